@@ -109,6 +109,52 @@ namespace ArduinoLib
 
 		static array<ArduinoPin, MAX_PINS> g_Pins;
 
+		//
+		//
+		// Ports and Pin Change Interrupts
+		//
+		//
+
+		constexpr int PINS_PER_PORT = 8;
+		constexpr int NUM_PORTS = (MAX_PINS + PINS_PER_PORT - 1) / PINS_PER_PORT;
+		constexpr int NUM_PIN_CHANGE_GROUPS = 3;
+
+		//index 0 is NOT_A_PORT
+		static array<volatile uint8_t, NUM_PORTS + 1> g_PortInputs;
+
+		static array<void (*)(), NUM_PIN_CHANGE_GROUPS> g_PinChangeVectors;
+
+		static volatile uint8_t *const g_PinChangeMasks[NUM_PIN_CHANGE_GROUPS] = { &PCMSK0, &PCMSK1, &PCMSK2 };
+
+		static inline bool IsValidPin(int pin)
+		{
+			return (pin >= 0) && (pin < MAX_PINS);
+		}
+
+		/**
+			Copies the pin voltage to its port input register and fires the pin change vector, like the hardware does
+		*/
+		static void SyncPort(int pin)
+		{
+			const auto port = pin / PINS_PER_PORT + 1;
+			const auto mask = static_cast<uint8_t>(1 << (pin % PINS_PER_PORT));
+
+			const uint8_t previous = g_PortInputs[port];
+			const uint8_t current = g_Pins.at(pin).digitalRead() == HIGH ? (previous | mask) : (previous & ~mask);
+
+			if (previous == current)
+				return;
+
+			g_PortInputs[port] = current;
+
+			const auto group = port - 1;
+			if ((group >= NUM_PIN_CHANGE_GROUPS) || !(PCICR & (1 << group)) || !(*g_PinChangeMasks[group] & mask))
+				return;
+
+			if (g_PinChangeVectors[group])
+				g_PinChangeVectors[group]();
+		}
+
 		//
 		//
 		// Arduino Lib helpers
@@ -118,11 +164,15 @@ namespace ArduinoLib
 		static void pinMode(int pin, PinModes mode)
 		{
 			g_Pins.at(pin).setPinMode(mode);
+
+			SyncPort(pin);
 		}
 
 		static void digitalWrite(int pin, VoltageModes mode)
 		{
 			g_Pins.at(pin).digitalWrite(mode);
+
+			SyncPort(pin);
 		}
 
 		static int digitalRead(int pin)
@@ -141,6 +191,15 @@ namespace ArduinoLib
 			{
 				it.reset();
 			}
+
+			for (auto &port : g_PortInputs)
+				port = 0;
+
+			PCICR = 0;
+			for (auto mask : g_PinChangeMasks)
+				*mask = 0;
+
+			g_PinChangeVectors.fill(nullptr);
 		}
 
 		void BoardTick()
@@ -188,6 +247,61 @@ int digitalRead(int pin)
 	return ArduinoLib::detail::digitalRead(pin);
 }
 
+uint8_t digitalPinToPort(int pin)
+{
+	using namespace ArduinoLib::detail;
+
+	return IsValidPin(pin) ? static_cast<uint8_t>(pin / PINS_PER_PORT + 1) : NOT_A_PORT;
+}
+
+uint8_t digitalPinToBitMask(int pin)
+{
+	using namespace ArduinoLib::detail;
+
+	return IsValidPin(pin) ? static_cast<uint8_t>(1 << (pin % PINS_PER_PORT)) : 0;
+}
+
+volatile uint8_t *portInputRegister(uint8_t port)
+{
+	using namespace ArduinoLib::detail;
+
+	return (port != NOT_A_PORT) && (port <= NUM_PORTS) ? &g_PortInputs[port] : nullptr;
+}
+
+volatile uint8_t PCICR = 0;
+volatile uint8_t PCMSK0 = 0;
+volatile uint8_t PCMSK1 = 0;
+volatile uint8_t PCMSK2 = 0;
+
+volatile uint8_t *digitalPinToPCICR(int pin)
+{
+	using namespace ArduinoLib::detail;
+
+	return IsValidPin(pin) && (pin / PINS_PER_PORT < NUM_PIN_CHANGE_GROUPS) ? &PCICR : nullptr;
+}
+
+uint8_t digitalPinToPCICRbit(int pin)
+{
+	return static_cast<uint8_t>(pin / ArduinoLib::detail::PINS_PER_PORT);
+}
+
+volatile uint8_t *digitalPinToPCMSK(int pin)
+{
+	using namespace ArduinoLib::detail;
+
+	return IsValidPin(pin) && (pin / PINS_PER_PORT < NUM_PIN_CHANGE_GROUPS) ? g_PinChangeMasks[pin / PINS_PER_PORT] : nullptr;
+}
+
+uint8_t digitalPinToPCMSKbit(int pin)
+{
+	return static_cast<uint8_t>(pin % ArduinoLib::detail::PINS_PER_PORT);
+}
+
+void attachPinChangeVector(uint8_t group, void (*isr)())
+{
+	ArduinoLib::detail::g_PinChangeVectors.at(group) = isr;
+}
+
 unsigned int bitRead(unsigned int flags, int pos)
 {
 	return (flags >> pos) & 1;
@@ -207,5 +321,7 @@ void delay(unsigned long ms)
 void ArduinoLib::SetPinDigitalVoltage(int pin, VoltageModes voltage)
 {
 	detail::g_Pins.at(pin).setDigitalVoltage(voltage);
+
+	detail::SyncPort(pin);
 }
 
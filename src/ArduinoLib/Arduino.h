@@ -10,6 +10,8 @@
 
 #pragma once
 
+#include <stdint.h>
+
 #include "ArduinoDefs.h"
 #include "Serial.h"
 
@@ -33,4 +35,39 @@ ARDUINO_API extern unsigned long millis();
 
 ARDUINO_API void delay(unsigned long ms);
 
+//
+// Port registers, the emulator groups pins in ports of 8 pins (pin 0 is port 1 bit 0)
+//
+
+#define NOT_A_PORT 0
+
+ARDUINO_API extern uint8_t digitalPinToPort(int pin);
+ARDUINO_API extern uint8_t digitalPinToBitMask(int pin);
+ARDUINO_API extern volatile uint8_t *portInputRegister(uint8_t port);
+
+//
+// Pin change interrupts, only the first 3 ports (pins 0 to 23) have them, one group per port
+//
+
+ARDUINO_API extern volatile uint8_t PCICR;
+ARDUINO_API extern volatile uint8_t PCMSK0;
+ARDUINO_API extern volatile uint8_t PCMSK1;
+ARDUINO_API extern volatile uint8_t PCMSK2;
 
+ARDUINO_API extern volatile uint8_t *digitalPinToPCICR(int pin);
+ARDUINO_API extern uint8_t digitalPinToPCICRbit(int pin);
+ARDUINO_API extern volatile uint8_t *digitalPinToPCMSK(int pin);
+ARDUINO_API extern uint8_t digitalPinToPCMSKbit(int pin);
+
+//There are no interrupt vectors on the emulator, so code that would use ISR(PCINTx_vect) registers the handler here
+ARDUINO_API extern void attachPinChangeVector(uint8_t group, void (*isr)());
+
+inline void noInterrupts()
+{
+	//empty
+}
+
+inline void interrupts()
+{
+	//empty
+}
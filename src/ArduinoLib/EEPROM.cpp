@@ -31,6 +31,7 @@ EEPROMImpl EEPROM;
 bool g_fDirty = false;
 static std::array<std::uint8_t, EEPROM_SIZE> g_Data;
 static std::array<std::uint8_t, EEPROM_SIZE> g_DataBackup;
+static std::array<unsigned, EEPROM_SIZE> g_WriteCount;
 
 static std::string g_strRomFileName;
 static std::string g_strRomTempFileName;
@@ -72,10 +73,37 @@ void EEPROMImpl::put(size_t pos, const void *ptr, size_t len)
 		throw std::out_of_range("out of bounds");
 	}
 
-	memcpy(&g_Data[pos], ptr, len);
+	auto *src = static_cast<const std::uint8_t *>(ptr);
+
+	//AVR EEPROM put only writes the cells that changed
+	for (size_t i = 0; i < len; ++i)
+		this->update(pos + i, src[i]);
+}
+
+void EEPROMImpl::write(size_t pos, unsigned char value)
+{
+	g_Data.at(pos) = value;
+	++g_WriteCount[pos];
+
 	g_fDirty = true;
 }
 
+void EEPROMImpl::update(size_t pos, unsigned char value)
+{
+	if (g_Data.at(pos) != value)
+		this->write(pos, value);
+}
+
+unsigned EEPROMImpl::getWriteCount(size_t pos) const
+{
+	return g_WriteCount.at(pos);
+}
+
+void EEPROMImpl::resetWriteCounts()
+{
+	g_WriteCount.fill(0);
+}
+
 unsigned char EEPROMImpl::read(size_t pos)
 {
 	return g_Data.at(pos);
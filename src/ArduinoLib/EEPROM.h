@@ -35,6 +35,15 @@ struct ARDUINO_API EEPROMImpl
 	size_t length();
 
 	unsigned char read(size_t pos);	
+
+	void write(size_t pos, unsigned char value);
+
+	//only writes if value is different, like the AVR EEPROM library (put also behaves like this there)
+	void update(size_t pos, unsigned char value);
+
+	//emulator only, how many times a cell was written, for wear tests
+	unsigned getWriteCount(size_t pos) const;
+	void resetWriteCounts();
 };
 
 ARDUINO_API extern EEPROMImpl EEPROM;
@@ -37,7 +37,7 @@
 #include "sys/BonjourService.h"
 #include "sys/Broker.h"
 #include "sys/EventHub.h"
-#include "sys/Thinker.h"
+#include "sys/MainLoop.h"
 
 #include <spdlog/logger.h>
 
@@ -141,23 +141,24 @@ int main(int argc, char **argv)
 
 		InitServicesFactories();
 
+		//before the broker, so services can watch their handles
+		dcclite::broker::sys::MainLoop::Start();
+
 		dcclite::broker::sys::Broker broker{ (argc == 1) ? "MyRailroad" : argv[1] };
 		
 		dcclite::Log::Info("Ready, main loop...");		
 		
 		while (!g_fExitRequested.test(std::memory_order_relaxed))
 		{			
-			auto now = dcclite::Clock::DefaultClock_t::now();
-						
-			auto timeout = dcclite::broker::sys::Thinker::UpdateThinkers(now);
-			
-			dcclite::broker::sys::EventHub::PumpEvents(timeout);
+			dcclite::broker::sys::MainLoop::RunOnce();
 		}
 	}	
 	catch (std::exception &ex)
 	{
 		dcclite::Log::Critical("caught {}", ex.what());
 	}
+
+	dcclite::broker::sys::MainLoop::Stop();
 	
 	dcclite::Log::Info("[Main] Bye");
 
@@ -0,0 +1,28 @@
+// Copyright (C) 2019 - Bruno Sanches. See the COPYRIGHT
+// file at the top-level directory of this distribution.
+//
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+//
+// This Source Code Form is "Incompatible With Secondary Licenses", as
+// defined by the Mozilla Public License, v. 2.0.
+
+#pragma once
+
+/**
+	Each benchmark prints its results and throws std::runtime_error if the run itself went wrong (lost messages,
+	timeouts), numbers are only reported, never checked
+*/
+
+void DataWriterBenchmark();
+void InterlockingBenchmark();
+void ItemQueryBenchmark();
+void LoconetControllerBenchmark();
+void MainLoopBenchmark();
+void OutputDecoderBatchBenchmark();
+void PacketSchemaBenchmark();
+void SectionBenchmark();
+void SignalDecoderBenchmark();
+void ThrottleServiceBenchmark();
+void ZeroConfSystemBenchmark();
@@ -0,0 +1,138 @@
+// Copyright (C) 2019 - Bruno Sanches. See the COPYRIGHT
+// file at the top-level directory of this distribution.
+//
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+//
+// This Source Code Form is "Incompatible With Secondary Licenses", as
+// defined by the Mozilla Public License, v. 2.0.
+
+#include "Benchmarks.h"
+
+#include <stdexcept>
+#include <string>
+
+#include <fmt/format.h>
+
+#include <JsonCreator/Object.h>
+#include <JsonCreator/StringWriter.h>
+
+#include <rapidjson/document.h>
+
+#include <dcclite/Benchmark.h>
+#include <dcclite/Cbor.h>
+#include <dcclite/DataWriter.h>
+
+using namespace dcclite;
+
+//mimics a decoder state notification, works with any object stream
+template <typename T>
+static void FillItem(T &stream, int index)
+{
+	stream.AddStringValue("name", fmt::format("turnout_{}", index));
+	stream.AddStringValue("className", "ServoTurnoutDecoder");
+	stream.AddStringValue("path", fmt::format("/DCCLite/Devices/Yard/turnout_{}", index));
+	stream.AddIntValue("internalId", 0x7FFF0000 + index);
+	stream.AddIntValue("address", index);
+	stream.AddBool("active", index & 1);
+	stream.AddBool("broken", false);
+	stream.AddStringValue("requestedState", (index & 1) ? "ACTIVE" : "INACTIVE");
+	stream.AddIntValue("pin", index % 54);
+	stream.AddIntValue("offset", -index);
+}
+
+template <typename T>
+static void FillDocument(T &root, int numItems)
+{
+	root.AddStringValue("jsonrpc", "2.0");
+	root.AddStringValue("method", "On-ItemPropertyValueChanged");
+
+	auto items = root.AddArray("items");
+	for (int i = 0; i < numItems; ++i)
+	{
+		auto item = items.AddObject();
+		FillItem(item, i);
+	}
+}
+
+template <typename W>
+static std::string MakeDocument(int numItems)
+{
+	W writer;
+
+	{
+		auto root = MakeObject(writer);
+		FillDocument(root, numItems);
+	}
+
+	return writer.ReleaseString();
+}
+
+/**
+* A notification with a thousand items encoded with JsonCreator, JsonDataWriter and CborDataWriter, then decoded from json and cbor
+*/
+void DataWriterBenchmark()
+{
+	constexpr int NUM_ITEMS = 1000;
+	constexpr int NUM_ROUNDS = 50;
+
+	Benchmark jsonCreatorEncode, jsonEncode, cborEncode;
+	Benchmark jsonDecode, cborDecode;
+
+	jsonCreatorEncode.Start();
+	for (int i = 0; i < NUM_ROUNDS; ++i)
+	{
+		JsonCreator::StringWriter writer;
+		{
+			auto root = JsonCreator::MakeObject(writer);
+			FillDocument(root, NUM_ITEMS);
+		}
+
+		if (writer.GetString().empty())
+			throw std::runtime_error("JsonCreator wrote nothing");
+	}
+	jsonCreatorEncode.Stop();
+
+	std::string json;
+	jsonEncode.Start();
+	for (int i = 0; i < NUM_ROUNDS; ++i)
+		json = MakeDocument<JsonDataWriter>(NUM_ITEMS);
+	jsonEncode.Stop();
+
+	std::string cbor;
+	cborEncode.Start();
+	for (int i = 0; i < NUM_ROUNDS; ++i)
+		cbor = MakeDocument<CborDataWriter>(NUM_ITEMS);
+	cborEncode.Stop();
+
+	jsonDecode.Start();
+	for (int i = 0; i < NUM_ROUNDS; ++i)
+	{
+		rapidjson::Document doc;
+		doc.Parse(json.c_str());
+
+		if (doc.HasParseError())
+			throw std::runtime_error("json document does not parse");
+	}
+	jsonDecode.Stop();
+
+	cborDecode.Start();
+	for (int i = 0; i < NUM_ROUNDS; ++i)
+	{
+		rapidjson::Document doc;
+		CborReader reader{ cbor };
+		doc.Populate(reader);
+
+		if (!doc.IsObject())
+			throw std::runtime_error("cbor document does not decode");
+	}
+	cborDecode.Stop();
+
+	fmt::print("[DataWriter] {} rounds of {} items, json {} bytes, cbor {} bytes\n", NUM_ROUNDS, NUM_ITEMS, json.size(), cbor.size());
+	fmt::print("[DataWriter] encode JsonCreator: {:.2f}ms\n", (double)jsonCreatorEncode.GetMs());
+	fmt::print("[DataWriter] encode json: {:.2f}ms\n", (double)jsonEncode.GetMs());
+	fmt::print("[DataWriter] encode cbor: {:.2f}ms\n", (double)cborEncode.GetMs());
+	fmt::print("[DataWriter] decode json: {:.2f}ms\n", (double)jsonDecode.GetMs());
+	fmt::print("[DataWriter] decode cbor: {:.2f}ms\n", (double)cborDecode.GetMs());
+}
@@ -0,0 +1,225 @@
+// Copyright (C) 2019 - Bruno Sanches. See the COPYRIGHT
+// file at the top-level directory of this distribution.
+//
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+//
+// This Source Code Form is "Incompatible With Secondary Licenses", as
+// defined by the Mozilla Public License, v. 2.0.
+
+#include "Benchmarks.h"
+
+#include <map>
+#include <memory>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <dcclite/Benchmark.h>
+
+#include <fmt/format.h>
+#include <rapidjson/document.h>
+#include <spdlog/spdlog.h>
+
+#include "../Tests/TestsCommon/BrokerMockups.h"
+#include "exec/dcc/SignalDecoder.h"
+#include "exec/dcc/SimpleOutputDecoder.h"
+#include "exec/dcc/VirtualSensorDecoder.h"
+#include "shell/dispatcher/Interlocking.h"
+
+using namespace dcclite::broker::exec::dcc;
+using dcclite::broker::shell::dispatcher::Interlocking;
+using dcclite::RName;
+
+namespace
+{
+	/**
+	* Owns the decoders and forwards state changes to the interlocking, like the DispatcherService does with DccLiteService events
+	*/
+	class InterlockingServicesMockup: public IDccLite_DecoderServices
+	{
+		public:
+			void Decoder_OnStateChanged(Decoder &decoder) override
+			{
+				if (m_pclInterlocking)
+					m_pclInterlocking->OnDecoderStateChanged(decoder);
+			}
+
+			Decoder *TryFindDecoder(RName id) const override
+			{
+				auto it = m_mapDecoders.find(id);
+
+				return it == m_mapDecoders.end() ? nullptr : it->second.get();
+			}
+
+			template <typename T>
+			T &Create(std::string_view name, const char *json)
+			{
+				rapidjson::Document params;
+				params.Parse(json);
+
+				auto decoder = std::make_unique<T>(Address{ static_cast<uint16_t>(m_mapDecoders.size()) }, RName{ name }, *this, m_clDevice, params);
+				auto &ref = *decoder;
+
+				m_mapDecoders.emplace(RName{ name }, std::move(decoder));
+
+				return ref;
+			}
+
+			OutputDecoder &CreateTurnout(std::string_view name)
+			{
+				return this->Create<SimpleOutputDecoder>(name, R"JSON({"class": "Output", "pin": 13})JSON");
+			}
+
+			VirtualSensorDecoder &CreateSensor(std::string_view name)
+			{
+				return this->Create<VirtualSensorDecoder>(name, R"JSON({"class": "VirtualSensor"})JSON");
+			}
+
+			void CreateSignal(std::string_view name)
+			{
+				this->CreateTurnout(fmt::format("{}_red", name));
+				this->CreateTurnout(fmt::format("{}_green", name));
+
+				auto json = fmt::format(
+					R"JSON({{
+						"class": "VirtualSignal",
+						"heads": {{ "red": "{0}_red", "green": "{0}_green" }},
+						"aspects": [ {{ "name": "Clear", "on": ["green"] }}, {{ "name": "Stop", "on": ["red"] }} ]
+					}})JSON",
+					name
+				);
+
+				this->Create<SignalDecoder>(name, json.c_str());
+			}
+
+			Interlocking *m_pclInterlocking = nullptr;
+
+		private:
+			DeviceDecoderServicesMockup m_clDevice;
+
+			std::map<RName, std::unique_ptr<Decoder>> m_mapDecoders;
+	};
+}
+
+/**
+* A big yard, hundreds of routes and a random stream of sensor and turnout changes.
+*
+* Incremental only evaluates the set routes using the changed decoder, full evaluates all set routes on every change, like
+* polling scripts do.
+*/
+void InterlockingBenchmark()
+{
+	constexpr unsigned NUM_TURNOUTS = 600;
+	constexpr unsigned NUM_SENSORS = 900;
+	constexpr unsigned NUM_ROUTES = 400;
+	constexpr unsigned NUM_CHANGES = 50000;
+
+	InterlockingServicesMockup services;
+
+	std::vector<OutputDecoder *> turnouts;
+	std::vector<VirtualSensorDecoder *> sensors;
+
+	for (unsigned i = 0; i < NUM_TURNOUTS; ++i)
+		turnouts.push_back(&services.CreateTurnout(fmt::format("bench_t{}", i)));
+
+	for (unsigned i = 0; i < NUM_SENSORS; ++i)
+		sensors.push_back(&services.CreateSensor(fmt::format("bench_s{}", i)));
+
+	//each route uses a small neighbourhood, so it only conflicts with the routes next to it
+	std::string json = "[";
+	for (unsigned i = 0; i < NUM_ROUTES; ++i)
+	{
+		services.CreateSignal(fmt::format("bench_sig{}", i));
+
+		const auto turnout = (i * 3) % (NUM_TURNOUTS - 2);
+		const auto sensor = (i * 2) % (NUM_SENSORS - 3);
+
+		json += fmt::format(
+			R"JSON({}{{
+				"name": "bench_r{}",
+				"signal": "bench_sig{}",
+				"turnouts": [ {{ "name": "bench_t{}", "position": "thrown" }}, {{ "name": "bench_t{}", "position": "closed" }} ],
+				"sensors": [ "bench_s{}", "bench_s{}", "bench_s{}" ]
+			}})JSON",
+			i ? "," : "",
+			i, i, turnout, turnout + 1, sensor, sensor + 1, sensor + 2
+		);
+	}
+	json += "]";
+
+	rapidjson::Document routes;
+	routes.Parse(json.c_str());
+
+	Interlocking interlocking{ RName{ "interlocking" }, routes, [&services](RName name) { return services.TryFindDecoder(name); } };
+	services.m_pclInterlocking = &interlocking;
+
+	//no need to hear about each refused neighbour
+	const auto logLevel = spdlog::get_level();
+	spdlog::set_level(spdlog::level::err);
+
+	unsigned numSetRoutes = 0;
+	for (unsigned i = 0; i < NUM_ROUTES; ++i)
+		numSetRoutes += interlocking.SetRoute(RName{ fmt::format("bench_r{}", i) });
+
+	spdlog::set_level(logLevel);
+
+	if (numSetRoutes == 0)
+		throw std::runtime_error("no route could be set");
+
+	for (auto turnout : turnouts)
+		turnout->SyncRemoteState(turnout->GetRequestedState());
+
+	//same random stream for both runs
+	std::mt19937 rng{ 42 };
+
+	std::vector<unsigned> changes;
+	for (unsigned i = 0; i < NUM_CHANGES; ++i)
+		changes.push_back(rng() % (NUM_TURNOUTS + NUM_SENSORS));
+
+	auto applyChange = [&](const unsigned change)
+	{
+		if (change < NUM_TURNOUTS)
+		{
+			//device glitch or manual throw on the panel, reported back by the device
+			auto turnout = turnouts[change];
+			turnout->SyncRemoteState(!turnout->GetState());
+		}
+		else
+		{
+			auto sensor = sensors[change - NUM_TURNOUTS];
+			sensor->SetSensorState(!sensor->GetState());
+		}
+	};
+
+	dcclite::Benchmark incremental, full;
+
+	auto evaluations = interlocking.GetNumEvaluations();
+
+	incremental.Start();
+	for (auto change : changes)
+		applyChange(change);
+	incremental.Stop();
+
+	const auto incrementalEvaluations = interlocking.GetNumEvaluations() - evaluations;
+
+	//now without the incremental path, everything on every change
+	services.m_pclInterlocking = nullptr;
+	evaluations = interlocking.GetNumEvaluations();
+
+	full.Start();
+	for (auto change : changes)
+	{
+		applyChange(change);
+		interlocking.EvaluateAllRoutes();
+	}
+	full.Stop();
+
+	const auto fullEvaluations = interlocking.GetNumEvaluations() - evaluations;
+
+	fmt::print("[Interlocking] {} routes ({} set), {} turnouts, {} sensors, {} changes\n", NUM_ROUTES, numSetRoutes, NUM_TURNOUTS, NUM_SENSORS, NUM_CHANGES);
+	fmt::print("[Interlocking] incremental: {:.2f}ms ({} route evaluations)\n", (double)incremental.GetMs(), incrementalEvaluations);
+	fmt::print("[Interlocking] full: {:.2f}ms ({} route evaluations)\n", (double)full.GetMs(), fullEvaluations);
+}
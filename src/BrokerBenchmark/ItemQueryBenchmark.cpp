@@ -0,0 +1,182 @@
+// Copyright (C) 2019 - Bruno Sanches. See the COPYRIGHT
+// file at the top-level directory of this distribution.
+//
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+//
+// This Source Code Form is "Incompatible With Secondary Licenses", as
+// defined by the Mozilla Public License, v. 2.0.
+
+#include "Benchmarks.h"
+
+#include <memory>
+#include <stdexcept>
+#include <string_view>
+#include <vector>
+
+#include <dcclite/Benchmark.h>
+#include <dcclite/DataWriter.h>
+#include <dcclite/FolderObject.h>
+
+#include <fmt/format.h>
+#include <rapidjson/document.h>
+
+#include "../Tests/TestsCommon/BrokerMockups.h"
+#include "exec/dcc/ItemQuery.h"
+#include "exec/dcc/SensorDecoder.h"
+#include "exec/dcc/SimpleOutputDecoder.h"
+
+using namespace dcclite;
+using namespace dcclite::broker::exec::dcc;
+
+namespace
+{
+	class NamedDeviceMockup: public DeviceDecoderServicesMockup
+	{
+		public:
+			explicit NamedDeviceMockup(RName name):
+				m_rnName{ name }
+			{
+				//empty
+			}
+
+			RName GetDeviceName() const noexcept override
+			{
+				return m_rnName;
+			}
+
+		private:
+			RName m_rnName;
+	};
+}
+
+/**
+* 20 devices, each with 50 outputs and 50 sensors (every 4th active). Active sensors are found by sending all items and
+* filtering them on the client, like before Query-Items, and by running a query
+*/
+void ItemQueryBenchmark()
+{
+	constexpr unsigned NUM_DEVICES = 20;
+	constexpr unsigned NUM_DECODERS_PER_KIND = 50;
+	constexpr int NUM_ROUNDS = 20;
+
+	DecoderServicesMockup decoderServices;
+	std::vector<std::unique_ptr<NamedDeviceMockup>> devices;
+
+	FolderObject root{ RName{ "root" } };
+
+	auto decoders = static_cast<FolderObject *>(root.AddChild(std::make_unique<FolderObject>(RName{ "decoders" })));
+
+	rapidjson::Document outputParams;
+	outputParams.Parse(R"JSON({"class": "Output", "pin": 13})JSON");
+
+	rapidjson::Document sensorParams;
+	sensorParams.Parse(R"JSON({"class": "Sensor", "pin": 12})JSON");
+
+	for (unsigned i = 0; i < NUM_DEVICES; ++i)
+	{
+		devices.push_back(std::make_unique<NamedDeviceMockup>(RName{ fmt::format("device_{}", i) }));
+		auto &device = *devices.back();
+
+		for (unsigned j = 0; j < NUM_DECODERS_PER_KIND; ++j)
+		{
+			const auto address = static_cast<uint16_t>((i * NUM_DECODERS_PER_KIND + j) * 2);
+
+			decoders->AddChild(std::make_unique<SimpleOutputDecoder>(
+				Address{ address },
+				RName{ fmt::format("output_{}_{}", i, j) },
+				decoderServices,
+				device,
+				outputParams
+			));
+
+			auto sensor = static_cast<SensorDecoder *>(decoders->AddChild(std::make_unique<SensorDecoder>(
+				Address{ static_cast<uint16_t>(address + 1) },
+				RName{ fmt::format("sensor_{}_{}", i, j) },
+				decoderServices,
+				device,
+				sensorParams
+			)));
+
+			if (j % 4 == 0)
+				sensor->SyncRemoteState(DecoderStates::ACTIVE);
+		}
+	}
+
+	size_t filteredCount = 0, queryCount = 0;
+	size_t filteredBytes = 0, queryBytes = 0;
+
+	Benchmark filtered, queried;
+
+	//the old way: send everything, client parses it and filters
+	filtered.Start();
+	for (int round = 0; round < NUM_ROUNDS; ++round)
+	{
+		JsonDataWriter writer;
+		{
+			ArrayOutputStream items{ writer };
+
+			root.ConstVisitChildren([&items](const IObject &folder)
+				{
+					static_cast<const IFolderObject &>(folder).ConstVisitChildren([&items](const IObject &item)
+						{
+							auto itemObject = items.AddObject();
+							item.Serialize(itemObject);
+
+							return true;
+						}
+					);
+
+					return true;
+				}
+			);
+		}
+
+		rapidjson::Document doc;
+		doc.Parse(writer.GetString().c_str());
+
+		filteredCount = 0;
+		for (const auto &item : doc.GetArray())
+		{
+			if ((std::string_view{ item["className"].GetString() } == "SensorDecoder") && item["active"].GetBool())
+				++filteredCount;
+		}
+
+		filteredBytes = writer.GetString().size();
+	}
+	filtered.Stop();
+
+	queried.Start();
+	for (int round = 0; round < NUM_ROUNDS; ++round)
+	{
+		auto query = ItemQuery::Parse("input state=active");
+
+		JsonDataWriter writer;
+		{
+			ArrayOutputStream items{ writer };
+
+			queryCount = 0;
+			query.Run(root, [&items, &queryCount](const IObject &item)
+				{
+					auto itemObject = items.AddObject();
+					item.Serialize(itemObject);
+
+					++queryCount;
+
+					return true;
+				}
+			);
+		}
+
+		queryBytes = writer.GetString().size();
+	}
+	queried.Stop();
+
+	if (filteredCount != queryCount)
+		throw std::runtime_error(fmt::format("client filter found {} sensors, query found {}", filteredCount, queryCount));
+
+	fmt::print("[ItemQuery] {} decoders, {} matches, {} rounds\n", NUM_DEVICES * NUM_DECODERS_PER_KIND * 2, queryCount, NUM_ROUNDS);
+	fmt::print("[ItemQuery] client filter: {:.2f}ms ({} bytes)\n", (double)filtered.GetMs(), filteredBytes);
+	fmt::print("[ItemQuery] query: {:.2f}ms ({} bytes)\n", (double)queried.GetMs(), queryBytes);
+}
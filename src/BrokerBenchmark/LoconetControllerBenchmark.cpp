@@ -0,0 +1,255 @@
+// Copyright (C) 2019 - Bruno Sanches. See the COPYRIGHT
+// file at the top-level directory of this distribution.
+//
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+//
+// This Source Code Form is "Incompatible With Secondary Licenses", as
+// defined by the Mozilla Public License, v. 2.0.
+
+#include "Benchmarks.h"
+
+#include <algorithm>
+#include <ctime>
+#include <stdexcept>
+#include <vector>
+
+#include <dcclite/Benchmark.h>
+#include <dcclite/Clock.h>
+#include <dcclite/FileSystem.h>
+#include <dcclite/SerialCapture.h>
+#include <dcclite/SerialPort.h>
+#include <dcclite/SerialReplay.h>
+
+#include <fmt/format.h>
+
+#include "shell/ln/ILoconetSlot.h"
+#include "shell/ln/LoconetController.h"
+#include "shell/ln/LoconetTransmitQueue.h"
+#include "shell/ln/ThrottleService.h"
+#include "sys/Timeouts.h"
+
+using namespace dcclite;
+using namespace dcclite::broker::shell::ln;
+using namespace std::chrono_literals;
+
+static constexpr uint8_t OPC_LOCO_SPD = 0xA0;
+static constexpr uint8_t OPC_LOCO_DIRF = 0xA1;
+static constexpr uint8_t OPC_LOCO_SND = 0xA2;
+static constexpr uint8_t OPC_MOVE_SLOTS = 0xBA;
+static constexpr uint8_t OPC_LOCO_ADR = 0xBF;
+
+namespace
+{
+	class ThrottleMockup: public IThrottle
+	{
+		public:
+			void OnSpeedChange() override
+			{
+				//empty
+			}
+
+			void OnForwardChange() override
+			{
+				//empty
+			}
+
+			void OnFunctionChange(const uint8_t begin, const uint8_t end) override
+			{
+				//empty
+			}
+
+			void OnEmergencyStop() override
+			{
+				//empty
+			}
+
+			void AddSlave(const ILoconetSlot &slot) override
+			{
+				//empty
+			}
+
+			void RemoveSlave(const ILoconetSlot &slot) override
+			{
+				//empty
+			}
+
+			bool HasSlaves() const noexcept override
+			{
+				return false;
+			}
+	};
+
+	class ThrottleProviderMockup: public IThrottleProvider
+	{
+		public:
+			IThrottle &CreateThrottle(const ILoconetSlot &owner) override
+			{
+				++m_iNumThrottles;
+
+				return m_clThrottle;
+			}
+
+			void ReleaseThrottle(IThrottle &throttle) override
+			{
+				--m_iNumThrottles;
+			}
+
+			int m_iNumThrottles = 0;
+
+		private:
+			ThrottleMockup m_clThrottle;
+	};
+
+	std::vector<uint8_t> MakeMessage(std::vector<uint8_t> data)
+	{
+		uint8_t checksum = 0xFF;
+		for (auto b : data)
+			checksum ^= b;
+
+		data.push_back(checksum);
+
+		return data;
+	}
+
+	std::vector<uint8_t> MakeLocoAdr(const uint16_t address)
+	{
+		return MakeMessage({ OPC_LOCO_ADR, static_cast<uint8_t>(address >> 7), static_cast<uint8_t>(address & 0x7F) });
+	}
+
+	std::vector<uint8_t> MakeNullMove(const uint8_t slot)
+	{
+		return MakeMessage({ OPC_MOVE_SLOTS, slot, slot });
+	}
+}
+
+/**
+* Replays a busy bus capture through a pty and the real SerialPort, like LoconetService does on its think
+*/
+void LoconetControllerBenchmark()
+{
+	constexpr auto NUM_THROTTLES = 60;
+	constexpr auto NUM_UPDATES = 30000;
+
+	//
+	//Build the capture: throttles acquiring locomotives and then spinning knobs, with messages split across reads
+	const auto captureFile = dcclite::fs::temp_directory_path() / "LoconetControllerBenchmark.cap";
+
+	unsigned numMessages = 0;
+	{
+		SerialCaptureWriter capture{ captureFile };
+
+		std::vector<uint8_t> stream;
+		for (int i = 0; i < NUM_THROTTLES; ++i)
+		{
+			auto adr = MakeLocoAdr(static_cast<uint16_t>(100 + i));
+			auto move = MakeNullMove(static_cast<uint8_t>(i + 1));
+
+			stream.insert(stream.end(), adr.begin(), adr.end());
+			stream.insert(stream.end(), move.begin(), move.end());
+
+			numMessages += 2;
+		}
+
+		for (int i = 0; i < NUM_UPDATES; ++i)
+		{
+			const auto slot = static_cast<uint8_t>((i % NUM_THROTTLES) + 1);
+			const uint8_t opcodes[] = { OPC_LOCO_SPD, OPC_LOCO_SPD, OPC_LOCO_DIRF, OPC_LOCO_SND };
+
+			auto msg = MakeMessage({ opcodes[i % 4], slot, static_cast<uint8_t>((i / 4) & 0x7F) });
+			stream.insert(stream.end(), msg.begin(), msg.end());
+
+			++numMessages;
+		}
+
+		//chunks of 1 to 64 bytes, about one message every 3ms, so the bus is always busy
+		size_t pos = 0;
+		auto timestamp = 0us;
+		for (unsigned chunk = 1; pos < stream.size(); chunk = (chunk * 7 + 3) % 64 + 1)
+		{
+			const auto size = std::min<size_t>(chunk, stream.size() - pos);
+
+			capture.Record(SerialCaptureDirections::RX, stream.data() + pos, static_cast<unsigned>(size), timestamp);
+
+			pos += size;
+			timestamp += 700us * size;
+		}
+	}
+
+	//
+	//Replay it at max speed
+	SerialReplay replay{ LoadSerialCapture(captureFile), 0 };
+	dcclite::fs::remove(captureFile);
+
+	SerialPort port{ replay.GetPortName() };
+	SerialPort::DataPacket packet;
+
+	ThrottleProviderMockup throttles;
+	LoconetTransmitQueue queue;
+	LoconetController controller{ throttles, queue, [](uint8_t slot) {} };
+
+	Benchmark wallTime;
+	Benchmark chunkTime;
+
+	Benchmark::us_t parseTime = 0;
+	Benchmark::us_t maxChunkTime = 0;
+	std::clock_t cpuTime = 0;
+
+	unsigned numChunks = 0;
+
+	wallTime.Start();
+	const auto deadline = Clock::DefaultClock_t::now() + 30s;
+
+	port.Read(packet);
+	while ((controller.GetNumMessages() < numMessages) && (Clock::DefaultClock_t::now() < deadline))
+	{
+		const auto now = Clock::DefaultClock_t::now();
+
+		replay.Update(now);
+
+		if (!packet.IsDataReady())
+			continue;
+
+		if (packet.GetDataSize())
+		{
+			const auto cpuStart = std::clock();
+			chunkTime.Start();
+
+			controller.ReceiveData(packet.GetData(), packet.GetDataSize(), now);
+
+			chunkTime.Stop();
+			cpuTime += std::clock() - cpuStart;
+
+			parseTime += chunkTime.GetUs();
+			maxChunkTime = std::max(maxChunkTime, chunkTime.GetUs());
+
+			++numChunks;
+		}
+
+		queue.Pump(port, now, dcclite::broker::sys::LOCONET_THINK_TIME);
+
+		port.Read(packet);
+	}
+
+	wallTime.Stop();
+
+	if (controller.GetNumMessages() != numMessages)
+		throw std::runtime_error(fmt::format("only {} of {} messages parsed before the timeout", controller.GetNumMessages(), numMessages));
+
+	if (controller.GetNumErrors())
+		throw std::runtime_error(fmt::format("{} checksum errors on replay", controller.GetNumErrors()));
+
+	if (throttles.m_iNumThrottles != NUM_THROTTLES)
+		throw std::runtime_error(fmt::format("{} throttles created, expected {}", throttles.m_iNumThrottles, NUM_THROTTLES));
+
+	fmt::print(
+		"[LoconetController] {} messages in {} reads: {:.0f} msgs/s, parse latency {:.2f}us per message (max read {:.2f}us), controller CPU {:.2f}ms\n",
+		numMessages,
+		numChunks,
+		(double)(numMessages / wallTime.GetSecond()),
+		(double)(parseTime / numMessages),
+		(double)maxChunkTime,
+		(cpuTime * 1000.0) / CLOCKS_PER_SEC
+	);
+}
@@ -0,0 +1,184 @@
+// Copyright (C) 2019 - Bruno Sanches. See the COPYRIGHT
+// file at the top-level directory of this distribution.
+//
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+//
+// This Source Code Form is "Incompatible With Secondary Licenses", as
+// defined by the Mozilla Public License, v. 2.0.
+
+#include "Benchmarks.h"
+
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <thread>
+
+#include <dcclite/Clock.h>
+
+#include <fmt/format.h>
+
+#include "sys/EventHub.h"
+#include "sys/MainLoop.h"
+#include "sys/Thinker.h"
+
+using namespace dcclite;
+using namespace dcclite::broker;
+using namespace std::chrono_literals;
+
+namespace
+{
+	class TargetMockup: public sys::EventHub::IEventTarget
+	{
+		//empty
+	};
+
+	class CounterEvent: public sys::EventHub::IEvent
+	{
+		public:
+			CounterEvent(TargetMockup &target, std::atomic<int> &counter):
+				IEvent(target),
+				m_rclCounter{ counter }
+			{
+				//empty
+			}
+
+			void Fire() override
+			{
+				++m_rclCounter;
+			}
+
+		private:
+			std::atomic<int> &m_rclCounter;
+	};
+
+	/**
+	* A thinker running every period, like the services ones, and measuring how late it runs
+	*/
+	class PeriodicThinker
+	{
+		public:
+			explicit PeriodicThinker(const Clock::DefaultClock_t::duration period):
+				m_tPeriod{ period },
+				m_tThinker{ "PeriodicThinker", THINKER_MF_LAMBDA(OnThink) }
+			{
+				m_tScheduled = Clock::DefaultClock_t::now() + m_tPeriod;
+				m_tThinker.Schedule(m_tScheduled);
+			}
+
+			void OnThink(const sys::Thinker::TimePoint_t tp)
+			{
+				const auto lateness = std::chrono::duration_cast<std::chrono::microseconds>(Clock::DefaultClock_t::now() - m_tScheduled).count();
+
+				m_iTotalLateness += lateness;
+				m_iMaxLateness = std::max<int64_t>(m_iMaxLateness, lateness);
+				++m_iNumTicks;
+
+				m_tScheduled += m_tPeriod;
+				m_tThinker.Schedule(m_tScheduled);
+			}
+
+			const Clock::DefaultClock_t::duration m_tPeriod;
+			Clock::DefaultClock_t::time_point m_tScheduled;
+
+			int64_t m_iTotalLateness = 0;
+			int64_t m_iMaxLateness = 0;
+			int m_iNumTicks = 0;
+
+		private:
+			sys::Thinker m_tThinker;
+	};
+
+	struct LoopResult
+	{
+		unsigned	m_uNumWakeups;
+		int			m_iNumTicks;
+		int			m_iNumEvents;
+		double		m_dMeanLateness;
+		int64_t		m_iMaxLateness;
+	};
+
+	/**
+	* A 5ms thinker and a thread posting an event every 2ms (network traffic), for one second
+	*/
+	LoopResult RunWorkload(std::function<void()> runOnce)
+	{
+		constexpr auto DURATION = 1s;
+
+		TargetMockup target;
+		std::atomic<int> numEvents = 0;
+		std::atomic_flag stop;
+
+		PeriodicThinker thinker{ 5ms };
+
+		std::thread producer{ [&]()
+		{
+			auto next = Clock::DefaultClock_t::now();
+
+			while (!stop.test())
+			{
+				next += 2ms;
+				std::this_thread::sleep_until(next);
+
+				sys::EventHub::PostEvent<CounterEvent>(std::ref(target), std::ref(numEvents));
+			}
+		} };
+
+		unsigned numWakeups = 0;
+
+		const auto deadline = Clock::DefaultClock_t::now() + DURATION;
+		while (Clock::DefaultClock_t::now() < deadline)
+		{
+			runOnce();
+
+			++numWakeups;
+		}
+
+		stop.test_and_set();
+		producer.join();
+
+		sys::EventHub::CancelEvents(target);
+
+		return LoopResult{
+			numWakeups,
+			thinker.m_iNumTicks,
+			numEvents.load(),
+			(double)thinker.m_iTotalLateness / thinker.m_iNumTicks,
+			thinker.m_iMaxLateness
+		};
+	}
+}
+
+/**
+* The same workload on the loop the broker used before MainLoop (thinkers then events) and on MainLoop
+*/
+void MainLoopBenchmark()
+{
+	//the loop broker used before MainLoop
+	auto classic = RunWorkload([]()
+	{
+		auto timeout = sys::Thinker::UpdateThinkers(Clock::DefaultClock_t::now());
+
+		sys::EventHub::PumpEvents(timeout);
+	});
+
+	sys::MainLoop::Start();
+
+	auto mainLoop = RunWorkload([]() { sys::MainLoop::RunOnce(); });
+
+	sys::MainLoop::Stop();
+
+	for (auto [name, result] : { std::make_pair("classic", classic), std::make_pair("main loop", mainLoop) })
+	{
+		fmt::print(
+			"[MainLoop] {}: {} wakeups/s, {} thinks, {} events, lateness {:.2f}us (max {}us)\n",
+			name,
+			result.m_uNumWakeups,
+			result.m_iNumTicks,
+			result.m_iNumEvents,
+			result.m_dMeanLateness,
+			result.m_iMaxLateness
+		);
+	}
+}
@@ -0,0 +1,124 @@
+// Copyright (C) 2019 - Bruno Sanches. See the COPYRIGHT
+// file at the top-level directory of this distribution.
+//
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+//
+// This Source Code Form is "Incompatible With Secondary Licenses", as
+// defined by the Mozilla Public License, v. 2.0.
+
+#include "Benchmarks.h"
+
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+#include <dcclite/Benchmark.h>
+
+#include <fmt/format.h>
+#include <rapidjson/document.h>
+
+#include "../Tests/TestsCommon/BrokerMockups.h"
+#include "exec/dcc/OutputDecoderBatch.h"
+#include "exec/dcc/SimpleOutputDecoder.h"
+
+using namespace dcclite::broker::exec::dcc;
+
+namespace
+{
+	class CountingDeviceMockup: public DeviceDecoderServicesMockup
+	{
+		public:
+			void Decoder_OnChangeStateRequest(const Decoder &decoder) noexcept override
+			{
+				++m_uNumNotifications;
+			}
+
+			unsigned m_uNumNotifications = 0;
+	};
+}
+
+/**
+* 20 devices with 25 turnouts each, like a medium sized layout, all turnouts changed one by one and as a batch
+*/
+void OutputDecoderBatchBenchmark()
+{
+	constexpr unsigned NUM_DEVICES = 20;
+	constexpr unsigned NUM_DECODERS_PER_DEVICE = 25;
+	constexpr unsigned NUM_ROUNDS = 50;
+
+	rapidjson::Document params;
+	params.Parse(R"JSON({"class": "Output", "pin": 13})JSON");
+
+	DecoderServicesMockup decoderServices;
+	std::vector<CountingDeviceMockup> devices{ NUM_DEVICES };
+	std::vector<std::unique_ptr<OutputDecoder>> decoders;
+
+	for (unsigned i = 0; i < NUM_DEVICES; ++i)
+	{
+		for (unsigned j = 0; j < NUM_DECODERS_PER_DEVICE; ++j)
+		{
+			const unsigned address = i * NUM_DECODERS_PER_DEVICE + j;
+
+			decoders.push_back(std::make_unique<SimpleOutputDecoder>(
+				Address{ static_cast<uint16_t>(address) },
+				dcclite::RName{ fmt::format("batch_turnout_{}", address) },
+				decoderServices,
+				devices[i],
+				params
+			));
+		}
+	}
+
+	auto countNotifications = [&devices]()
+	{
+		unsigned total = 0;
+		for (auto &device : devices)
+		{
+			total += device.m_uNumNotifications;
+			device.m_uNumNotifications = 0;
+		}
+
+		return total;
+	};
+
+	dcclite::Benchmark individual, batched;
+
+	auto state = dcclite::DecoderStates::ACTIVE;
+
+	individual.Start();
+	for (unsigned round = 0; round < NUM_ROUNDS; ++round)
+	{
+		for (auto &decoder : decoders)
+			decoder->SetState(state, "benchmark");
+
+		state = !state;
+	}
+	individual.Stop();
+
+	const auto individualNotifications = countNotifications();
+
+	OutputDecoderBatch batch;
+
+	batched.Start();
+	for (unsigned round = 0; round < NUM_ROUNDS; ++round)
+	{
+		for (auto &decoder : decoders)
+			batch.Add(*decoder, state);
+
+		batch.Apply("benchmark");
+
+		state = !state;
+	}
+	batched.Stop();
+
+	const auto batchedNotifications = countNotifications();
+
+	if (batchedNotifications != NUM_ROUNDS * NUM_DEVICES)
+		throw std::runtime_error(fmt::format("expected {} device notifications from batches, got {}", NUM_ROUNDS * NUM_DEVICES, batchedNotifications));
+
+	fmt::print("[OutputDecoderBatch] {} rounds of {} decoders on {} devices\n", NUM_ROUNDS, decoders.size(), NUM_DEVICES);
+	fmt::print("[OutputDecoderBatch] individual: {:.2f}ms ({} notifications)\n", (double)individual.GetMs(), individualNotifications);
+	fmt::print("[OutputDecoderBatch] batched: {:.2f}ms ({} notifications)\n", (double)batched.GetMs(), batchedNotifications);
+}
@@ -0,0 +1,116 @@
+// Copyright (C) 2019 - Bruno Sanches. See the COPYRIGHT
+// file at the top-level directory of this distribution.
+//
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+//
+// This Source Code Form is "Incompatible With Secondary Licenses", as
+// defined by the Mozilla Public License, v. 2.0.
+
+#include "Benchmarks.h"
+
+#include <dcclite/Benchmark.h>
+
+#include <dcclite_shared/Packet.h>
+
+#include <fmt/format.h>
+
+using namespace dcclite;
+
+static Guid MakeGuid(uint8_t seed)
+{
+	Guid guid;
+
+	for (unsigned i = 0; i < sizeof(guid.m_bId); ++i)
+		guid.m_bId[i] = static_cast<uint8_t>(seed + i);
+
+	return guid;
+}
+
+/**
+* CONFIG_ACK packets written and read one field at a time and with the packet schemas
+*/
+void PacketSchemaBenchmark()
+{
+	constexpr int NUM_ROUNDS = 200000;
+
+	const auto session = MakeGuid(1);
+	const auto config = MakeGuid(100);
+
+	ConfigAcksBitPack_t slots;
+	slots.SetBit(5);
+
+	Benchmark perByteWrite, schemaWrite, perByteRead, schemaRead;
+
+	//keep the optimizer from throwing the work away
+	volatile uint32_t sink = 0;
+
+	Packet packet;
+
+	perByteWrite.Start();
+	for (int i = 0; i < NUM_ROUNDS; ++i)
+	{
+		packet.Reset();
+		packet.Write32(PACKET_ID);
+		packet.Write8(static_cast<uint8_t>(MsgTypes::CONFIG_ACK));
+		packet.Write(session);
+		packet.Write(config);
+		packet.Write8(static_cast<uint8_t>(i));
+		packet.Write(slots);
+
+		sink = sink + packet.GetData()[i % packet.GetSize()];
+	}
+	perByteWrite.Stop();
+
+	schemaWrite.Start();
+	for (int i = 0; i < NUM_ROUNDS; ++i)
+	{
+		packet.Reset();
+		PacketHeaderSchema_t::Write(packet, PACKET_ID, MsgTypes::CONFIG_ACK, session, config);
+		ConfigAckSchema_t::Write(packet, static_cast<uint8_t>(i), slots);
+
+		sink = sink + packet.GetData()[i % packet.GetSize()];
+	}
+	schemaWrite.Stop();
+
+	perByteRead.Start();
+	for (int i = 0; i < NUM_ROUNDS; ++i)
+	{
+		packet.Reset();
+
+		const auto id = packet.Read<uint32_t>();
+		const auto type = packet.Read<MsgTypes>();
+		const auto readSession = packet.ReadGuid();
+		const auto readConfig = packet.ReadGuid();
+		const auto seq = packet.Read<uint8_t>();
+
+		ConfigAcksBitPack_t readSlots;
+		packet.ReadBitPack(readSlots);
+
+		sink = sink + id + static_cast<uint8_t>(type) + readSession.m_bId[i % 16] + readConfig.m_bId[0] + seq + readSlots[5];
+	}
+	perByteRead.Stop();
+
+	schemaRead.Start();
+	for (int i = 0; i < NUM_ROUNDS; ++i)
+	{
+		packet.Reset();
+
+		uint32_t id;
+		MsgTypes type;
+		Guid readSession, readConfig;
+		uint8_t seq;
+		ConfigAcksBitPack_t readSlots;
+
+		PacketHeaderSchema_t::Read(packet, id, type, readSession, readConfig);
+		ConfigAckSchema_t::Read(packet, seq, readSlots);
+
+		sink = sink + id + static_cast<uint8_t>(type) + readSession.m_bId[i % 16] + readConfig.m_bId[0] + seq + readSlots[5];
+	}
+	schemaRead.Stop();
+
+	fmt::print("[PacketSchema] {} CONFIG_ACK packets\n", NUM_ROUNDS);
+	fmt::print("[PacketSchema] per byte write: {:.2f}ms, schema write: {:.2f}ms\n", (double)perByteWrite.GetMs(), (double)schemaWrite.GetMs());
+	fmt::print("[PacketSchema] per byte read: {:.2f}ms, schema read: {:.2f}ms\n", (double)perByteRead.GetMs(), (double)schemaRead.GetMs());
+}
@@ -0,0 +1,252 @@
+// Copyright (C) 2019 - Bruno Sanches. See the COPYRIGHT
+// file at the top-level directory of this distribution.
+//
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+//
+// This Source Code Form is "Incompatible With Secondary Licenses", as
+// defined by the Mozilla Public License, v. 2.0.
+
+#include "Benchmarks.h"
+
+#include <map>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+#include <dcclite/Benchmark.h>
+#include <dcclite/FmtUtils.h>
+
+#include <fmt/format.h>
+#include <rapidjson/document.h>
+#include <sol/sol.hpp>
+
+#include "../Tests/TestsCommon/BrokerMockups.h"
+#include "exec/dcc/SensorDecoder.h"
+#include "shell/dispatcher/Section.h"
+
+using namespace dcclite::broker::exec::dcc;
+using dcclite::broker::shell::dispatcher::BaseSection;
+using dcclite::DecoderStates;
+using dcclite::RName;
+
+namespace
+{
+	class SectionServicesMockup: public IDccLite_DecoderServices
+	{
+		public:
+			void Decoder_OnStateChanged(Decoder &decoder) override
+			{
+				//empty
+			}
+
+			Decoder *TryFindDecoder(RName id) const override
+			{
+				auto it = m_mapDecoders.find(id);
+
+				return it == m_mapDecoders.end() ? nullptr : it->second.get();
+			}
+
+			SensorDecoder &CreateSensor(std::string_view name)
+			{
+				rapidjson::Document params;
+				params.Parse(R"JSON({"class": "Sensor", "pin": 10})JSON");
+
+				auto decoder = std::make_unique<SensorDecoder>(Address{ static_cast<uint16_t>(m_mapDecoders.size()) }, RName{ name }, *this, m_clDevice, params);
+				auto &ref = *decoder;
+
+				m_mapDecoders.emplace(RName{ name }, std::move(decoder));
+
+				return ref;
+			}
+
+			std::unique_ptr<BaseSection> CreateSection(const char *json)
+			{
+				rapidjson::Document params;
+				params.Parse(json);
+
+				return BaseSection::Create(params, [this](RName name) { return this->TryFindDecoder(name); });
+			}
+
+		private:
+			DeviceDecoderServicesMockup m_clDevice;
+
+			std::map<RName, std::unique_ptr<Decoder>> m_mapDecoders;
+	};
+}
+
+/**
+* Trains passing on lots of sections, native sections against the section.lua ones.
+*
+* Native numbers include the decoders state sync, the script ones only the sections logic, real script sections also pay
+* for the decoder proxies.
+*/
+void SectionBenchmark()
+{
+	constexpr unsigned NUM_SECTIONS = 200;
+	constexpr unsigned NUM_TRAINS = 250;
+
+	//each train: start on, end on, start off, end off
+	constexpr unsigned NUM_EVENTS = NUM_SECTIONS * NUM_TRAINS * 4;
+
+	//
+	// Native
+	//
+	SectionServicesMockup services;
+
+	std::vector<RemoteDecoder *> sensors;
+	std::vector<std::unique_ptr<BaseSection>> sections;
+
+	unsigned nativeChanges = 0;
+
+	for (unsigned i = 0; i < NUM_SECTIONS; ++i)
+	{
+		sensors.push_back(&services.CreateSensor(fmt::format("bench_start{}", i)));
+		sensors.push_back(&services.CreateSensor(fmt::format("bench_end{}", i)));
+
+		auto json = fmt::format(R"JSON({{ "name": "bench_sec{0}", "class": "Section", "startSensor": "bench_start{0}", "endSensor": "bench_end{0}" }})JSON", i);
+
+		sections.push_back(services.CreateSection(json.c_str()));
+		sections.back()->m_sigStateChanged.connect([&nativeChanges](BaseSection &) { ++nativeChanges; });
+	}
+
+	dcclite::Benchmark native;
+
+	native.Start();
+	for (unsigned train = 0; train < NUM_TRAINS; ++train)
+	{
+		for (unsigned i = 0; i < NUM_SECTIONS; ++i)
+		{
+			auto start = sensors[i * 2];
+			auto end = sensors[i * 2 + 1];
+
+			start->SyncRemoteState(DecoderStates::ACTIVE);
+			end->SyncRemoteState(DecoderStates::ACTIVE);
+			start->SyncRemoteState(DecoderStates::INACTIVE);
+			end->SyncRemoteState(DecoderStates::INACTIVE);
+		}
+	}
+	native.Stop();
+
+	for (auto &section : sections)
+	{
+		if (!section->IsClear())
+			throw std::runtime_error(fmt::format("native section {} is not clear after the trains", section->GetName()));
+	}
+
+	//
+	// Script
+	//
+	sol::state lua;
+	lua.open_libraries(sol::lib::base, sol::lib::table, sol::lib::string);
+
+	lua.safe_script(R"LUA(
+		local state_changes = 0
+
+		function log_trace(msg) end
+		function log_info(msg) end
+		function log_warn(msg) end
+		function log_error(msg) end
+
+		dcclite = {
+			dispatcher = {
+				register_section = function(self, name, section) end,
+				on_section_state_change = function(self, section, state) state_changes = state_changes + 1 end,
+				panic = function(self, section, reason) end
+			}
+		}
+
+		function get_state_changes()
+			return state_changes
+		end
+
+		local function make_sensor()
+			local sensor = { active = false, listeners = {} }
+
+			function sensor:on_state_change(listener)
+				self.listeners[#self.listeners + 1] = listener
+			end
+
+			return sensor
+		end
+
+		function set_sensor(sensor, active)
+			sensor.active = active
+
+			for _, listener in ipairs(sensor.listeners) do
+				listener(sensor)
+			end
+		end
+	)LUA");
+
+	lua.safe_script_file(DCCLITE_EFMR_SCRIPTS_DIR "/section.lua");
+
+	lua.safe_script(R"LUA(
+		sensors = {}
+		sections = {}
+
+		function create_sections(count)
+			for i = 1, count do
+				local start_sensor = make_sensor()
+				local end_sensor = make_sensor()
+
+				sensors[#sensors + 1] = start_sensor
+				sensors[#sensors + 1] = end_sensor
+
+				sections[i] = Section:new({
+					name = "lua_sec" .. i,
+					address = i,
+					start_sensor = start_sensor,
+					end_sensor = end_sensor,
+					callback = function(section) end
+				})
+			end
+		end
+	)LUA");
+
+	lua["create_sections"](NUM_SECTIONS);
+
+	const int initialChanges = lua["get_state_changes"]();
+
+	sol::table luaSensors = lua["sensors"];
+	std::vector<sol::table> scriptSensors;
+	for (unsigned i = 1; i <= NUM_SECTIONS * 2; ++i)
+		scriptSensors.push_back(luaSensors.get<sol::table>(i));
+
+	sol::protected_function setSensor = lua["set_sensor"];
+
+	dcclite::Benchmark script;
+
+	script.Start();
+	for (unsigned train = 0; train < NUM_TRAINS; ++train)
+	{
+		for (unsigned i = 0; i < NUM_SECTIONS; ++i)
+		{
+			auto &start = scriptSensors[i * 2];
+			auto &end = scriptSensors[i * 2 + 1];
+
+			setSensor(start, true);
+			setSensor(end, true);
+			setSensor(start, false);
+			setSensor(end, false);
+		}
+	}
+	script.Stop();
+
+	const int scriptChanges = lua["get_state_changes"]();
+
+	//same logic, same results
+	if (nativeChanges != NUM_SECTIONS * NUM_TRAINS * 3)
+		throw std::runtime_error(fmt::format("native sections changed state {} times, expected {}", nativeChanges, NUM_SECTIONS * NUM_TRAINS * 3));
+
+	if (static_cast<unsigned>(scriptChanges - initialChanges) != nativeChanges)
+		throw std::runtime_error(fmt::format("script sections changed state {} times, native {}", scriptChanges - initialChanges, nativeChanges));
+
+	const auto nativeMs = (double)native.GetMs();
+	const auto scriptMs = (double)script.GetMs();
+
+	fmt::print("[Section] {} sections, {} trains, {} sensor events\n", NUM_SECTIONS, NUM_TRAINS, NUM_EVENTS);
+	fmt::print("[Section] native: {:.2f}ms ({:.0f} events/s)\n", nativeMs, NUM_EVENTS / (nativeMs / 1000.0));
+	fmt::print("[Section] script: {:.2f}ms ({:.0f} events/s)\n", scriptMs, NUM_EVENTS / (scriptMs / 1000.0));
+}
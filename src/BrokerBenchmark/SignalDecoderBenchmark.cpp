@@ -0,0 +1,135 @@
+// Copyright (C) 2019 - Bruno Sanches. See the COPYRIGHT
+// file at the top-level directory of this distribution.
+//
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+//
+// This Source Code Form is "Incompatible With Secondary Licenses", as
+// defined by the Mozilla Public License, v. 2.0.
+
+#include "Benchmarks.h"
+
+#include <iterator>
+#include <map>
+#include <memory>
+#include <stdexcept>
+
+#include <dcclite/Benchmark.h>
+
+#include <fmt/format.h>
+#include <rapidjson/document.h>
+
+#include "../Tests/TestsCommon/BrokerMockups.h"
+#include "exec/dcc/SignalDecoder.h"
+#include "exec/dcc/SimpleOutputDecoder.h"
+
+using namespace dcclite::broker::exec::dcc;
+using dcclite::RName;
+
+namespace
+{
+	/**
+	* Owns the heads and counts how many times the signal looks them up
+	*/
+	class HeadsServicesMockup: public DecoderServicesMockup
+	{
+		public:
+			void AddHead(const char *name, int pin)
+			{
+				rapidjson::Document d;
+				d.Parse(fmt::format(R"JSON({{"pin": {}}})JSON", pin).c_str());
+
+				m_mapHeads.emplace(
+					RName{ name },
+					std::make_unique<SimpleOutputDecoder>(Address{ static_cast<uint16_t>(pin) }, RName{ name }, *this, m_clDevice, d)
+				);
+			}
+
+			Decoder *TryFindDecoder(RName id) const override
+			{
+				++m_uNumLookups;
+
+				auto it = m_mapHeads.find(id);
+
+				return it != m_mapHeads.end() ? it->second.get() : nullptr;
+			}
+
+			//the device answered all pending changes
+			void SyncHeads()
+			{
+				for (auto &it : m_mapHeads)
+					it.second->SyncRemoteState(it.second->GetRequestedState());
+			}
+
+			DeviceDecoderServicesMockup m_clDevice;
+
+			mutable unsigned m_uNumLookups = 0;
+
+		private:
+			std::map<RName, std::unique_ptr<SimpleOutputDecoder>> m_mapHeads;
+	};
+}
+
+/**
+* Thousands of aspect changes on a four heads signal with the heads answering every change
+*/
+void SignalDecoderBenchmark()
+{
+	constexpr unsigned NUM_CHANGES = 20000;
+
+	HeadsServicesMockup services;
+
+	services.AddHead("STC_HR12", 10);
+	services.AddHead("STC_HG12", 11);
+	services.AddHead("STC_HY12", 12);
+	services.AddHead("STC_BLA", 13);
+
+	rapidjson::Document d;
+	d.Parse(R"JSON(
+		{
+			"name":"STC_SIG_12",
+			"class":"VirtualSignal",
+			"heads": { "red":"STC_HR12", "green":"STC_HG12", "yellow":"STC_HY12", "caution":"STC_BLA" },
+			"aspects":
+			[
+				{ "name":"Stop", "on":["red"] },
+				{ "name":"Clear", "on":["green"] },
+				{ "name":"Aproach", "on":["yellow"] },
+				{ "name":"AdvanceAproach", "on":["yellow", "caution"] }
+			]
+		}
+	)JSON");
+
+	SignalDecoder signal{ Address{ 1841 }, RName{ "benchmark" }, services, services.m_clDevice, d };
+
+	services.SyncHeads();
+
+	const auto lookups = services.m_uNumLookups;
+
+	const dcclite::SignalAspects aspects[] =
+	{
+		dcclite::SignalAspects::Clear,
+		dcclite::SignalAspects::Aproach,
+		dcclite::SignalAspects::AdvanceAproach,
+		dcclite::SignalAspects::Stop
+	};
+
+	const RName requester{ "benchmark" };
+
+	dcclite::Benchmark benchmark;
+
+	benchmark.Start();
+	for (unsigned i = 0; i < NUM_CHANGES; ++i)
+	{
+		signal.SetAspect(aspects[i % std::size(aspects)], requester, "benchmark");
+
+		services.SyncHeads();
+	}
+	benchmark.Stop();
+
+	if (signal.GetAspect() != dcclite::SignalAspects::Stop)
+		throw std::runtime_error("signal did not follow the aspect changes");
+
+	fmt::print("[SignalDecoder] {} aspect changes: {:.2f}ms ({} head lookups)\n", NUM_CHANGES, (double)benchmark.GetMs(), services.m_uNumLookups - lookups);
+}
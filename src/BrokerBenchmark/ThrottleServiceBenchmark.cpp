@@ -0,0 +1,261 @@
+// Copyright (C) 2019 - Bruno Sanches. See the COPYRIGHT
+// file at the top-level directory of this distribution.
+//
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+//
+// This Source Code Form is "Incompatible With Secondary Licenses", as
+// defined by the Mozilla Public License, v. 2.0.
+
+#include "Benchmarks.h"
+
+#include <algorithm>
+#include <atomic>
+#include <ctime>
+#include <functional>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <dcclite/Benchmark.h>
+#include <dcclite/Clock.h>
+#include <dcclite/NetMessenger.h>
+#include <dcclite/Socket.h>
+
+#include <fmt/format.h>
+
+#include "shell/ln/ILoconetSlot.h"
+#include "shell/ln/ThrottleService.h"
+#include "sys/EventHub.h"
+#include "sys/Thinker.h"
+
+using namespace dcclite;
+using namespace dcclite::broker;
+using namespace dcclite::broker::shell::ln;
+using namespace std::chrono_literals;
+
+namespace
+{
+	class SlotMockup: public ILoconetSlot
+	{
+		public:
+			SlotMockup(const uint8_t id, const uint16_t address)
+			{
+				m_uId = id;
+				m_tLocomotiveAddress = exec::dcc::Address{ address };
+			}
+
+			void SetSpeed(const uint8_t speed)
+			{
+				m_uSpeed = speed;
+			}
+	};
+
+	class WakeTarget: public sys::EventHub::IEventTarget
+	{
+		//empty
+	};
+
+	/**
+	* Wakes the main loop, like the network threads do when posting their events
+	*/
+	class WakeEvent: public sys::EventHub::IEvent
+	{
+		public:
+			explicit WakeEvent(WakeTarget &target):
+				IEvent(target)
+			{
+				//empty
+			}
+
+			void Fire() override
+			{
+				//empty
+			}
+	};
+
+	/**
+	* Minimal WiThrottle server: handshake, heartbeat request and then it timestamps every speed command
+	*/
+	class FakeWiThrottleServer
+	{
+		public:
+			explicit FakeWiThrottleServer(const int numClients)
+			{
+				if (!m_clListener.Open(0, Socket::Type::STREAM, Socket::FLAG_BLOCKING_MODE) || !m_clListener.Listen(numClients))
+					throw std::runtime_error("[FakeWiThrottleServer] Cannot open listener");
+
+				m_thListener = std::thread{ [this, numClients]() { this->ListenThreadProc(numClients); } };
+			}
+
+			~FakeWiThrottleServer()
+			{
+				m_thListener.join();
+
+				for (auto &t : m_vecClients)
+					t.join();
+
+				sys::EventHub::CancelEvents(m_clWakeTarget);
+			}
+
+			NetworkAddress GetAddress() const
+			{
+				return NetworkAddress{ 127, 0, 0, 1, m_clListener.GetPort().value() };
+			}
+
+			std::atomic<int> m_iNumRegistered = 0;
+			std::atomic<int> m_iNumCommands = 0;
+
+			std::atomic<Clock::DefaultClock_t::rep> m_tLastCommand = 0;
+
+		private:
+			void ListenThreadProc(const int numClients)
+			{
+				for (int i = 0; i < numClients; ++i)
+				{
+					auto [status, socket, address] = m_clListener.TryAccept();
+					if (status != Socket::Status::OK)
+						break;
+
+					m_vecClients.emplace_back([this, s = std::move(socket)]() mutable { this->ClientThreadProc(std::move(s)); });
+				}
+			}
+
+			void ClientThreadProc(Socket socket)
+			{
+				NetMessenger messenger{ std::move(socket), "\r\n" };
+
+				messenger.Send("VN2.0");
+
+				for (;;)
+				{
+					auto [status, msg] = messenger.Poll();
+					if (status != Socket::Status::OK)
+						break;
+
+					if (msg[0] == 'N')
+					{
+						messenger.Send("*10");
+					}
+					else if (msg.compare(0, 3, "MT+") == 0)
+					{
+						++m_iNumRegistered;
+
+						sys::EventHub::PostEvent<WakeEvent>(std::ref(m_clWakeTarget));
+					}
+					else if (msg.compare(0, 8, "MTA*<;>V") == 0)
+					{
+						m_tLastCommand = Clock::DefaultClock_t::now().time_since_epoch().count();
+						++m_iNumCommands;
+
+						sys::EventHub::PostEvent<WakeEvent>(std::ref(m_clWakeTarget));
+					}
+				}
+			}
+
+		private:
+			WakeTarget					m_clWakeTarget;
+
+			Socket						m_clListener;
+			std::thread					m_thListener;
+
+			std::vector<std::thread>	m_vecClients;
+	};
+
+	/**
+	* Runs the broker main loop (thinkers and events) until the predicate is satisfied or the timeout expires
+	*
+	* Returns how many times the loop woke up
+	*/
+	unsigned RunLoop(std::function<bool()> predicate, const Clock::DefaultClock_t::duration timeout)
+	{
+		const auto deadline = Clock::DefaultClock_t::now() + timeout;
+
+		unsigned numWakeups = 0;
+
+		while (!predicate())
+		{
+			const auto now = Clock::DefaultClock_t::now();
+			if (now >= deadline)
+				break;
+
+			auto nextThink = sys::Thinker::UpdateThinkers(now);
+
+			sys::EventHub::PumpEvents(nextThink ? std::min(nextThink.value(), deadline) : deadline);
+
+			++numWakeups;
+		}
+
+		return numWakeups;
+	}
+}
+
+/**
+* Throttles connecting to a WiThrottle server, sending speed commands and then idle until the first heartbeat
+*/
+void ThrottleServiceBenchmark()
+{
+	constexpr auto NUM_THROTTLES = 20;
+	constexpr auto NUM_COMMANDS = 200;
+
+	FakeWiThrottleServer server{ NUM_THROTTLES };
+
+	std::vector<std::unique_ptr<SlotMockup>> slots;
+	std::vector<std::unique_ptr<IThrottle>> throttles;
+
+	//
+	//handshake: connect, version, line ending and heartbeat request, each one used to take a 20ms think
+	Benchmark connectTime;
+
+	connectTime.Start();
+	for (int i = 0; i < NUM_THROTTLES; ++i)
+	{
+		slots.push_back(std::make_unique<SlotMockup>(static_cast<uint8_t>(i + 1), static_cast<uint16_t>(100 + i)));
+		throttles.push_back(MakeThrottle(server.GetAddress(), *slots.back()));
+	}
+
+	RunLoop([&server]() { return server.m_iNumRegistered == NUM_THROTTLES; }, 5s);
+	connectTime.Stop();
+
+	if (server.m_iNumRegistered != NUM_THROTTLES)
+		throw std::runtime_error(fmt::format("only {} of {} throttles registered", server.m_iNumRegistered.load(), NUM_THROTTLES));
+
+	//
+	//commands
+	Benchmark::us_t totalLatency = 0;
+	Benchmark::us_t maxLatency = 0;
+
+	for (int i = 0; i < NUM_COMMANDS; ++i)
+	{
+		auto &slot = *slots[i % NUM_THROTTLES];
+		slot.SetSpeed(static_cast<uint8_t>(i & 0x7F));
+
+		const auto start = Clock::DefaultClock_t::now();
+		throttles[i % NUM_THROTTLES]->OnSpeedChange();
+
+		RunLoop([&server, i]() { return server.m_iNumCommands == i + 1; }, 1s);
+		if (server.m_iNumCommands != i + 1)
+			throw std::runtime_error(fmt::format("command {} did not reach the server", i));
+
+		const auto arrival = Clock::DefaultClock_t::time_point{ Clock::DefaultClock_t::duration{ server.m_tLastCommand.load() } };
+		const auto latency = static_cast<Benchmark::us_t>(std::chrono::duration_cast<std::chrono::microseconds>(arrival - start).count());
+
+		totalLatency += latency;
+		maxLatency = std::max(maxLatency, latency);
+	}
+
+	//
+	//idle: nothing to do until the first heartbeat, the loop should sleep (the old 20ms thinker woke up 25 times here)
+	const auto cpuStart = std::clock();
+	const auto numWakeups = RunLoop([]() { return false; }, 500ms);
+	const auto idleCpu = std::clock() - cpuStart;
+
+	throttles.clear();
+
+	fmt::print("[ThrottleService] {} throttles connected in {:.2f}ms\n", NUM_THROTTLES, (double)connectTime.GetMs());
+	fmt::print("[ThrottleService] {} commands, latency {:.2f}us (max {:.2f}us)\n", NUM_COMMANDS, (double)(totalLatency / NUM_COMMANDS), (double)maxLatency);
+	fmt::print("[ThrottleService] idle 500ms: {} wakeups, {:.2f}ms cpu\n", numWakeups, (idleCpu * 1000.0) / CLOCKS_PER_SEC);
+}
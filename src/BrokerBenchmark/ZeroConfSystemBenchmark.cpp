@@ -0,0 +1,154 @@
+// Copyright (C) 2019 - Bruno Sanches. See the COPYRIGHT
+// file at the top-level directory of this distribution.
+//
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+//
+// This Source Code Form is "Incompatible With Secondary Licenses", as
+// defined by the Mozilla Public License, v. 2.0.
+
+#include "Benchmarks.h"
+
+#include <algorithm>
+#include <stdexcept>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include <dcclite/Benchmark.h>
+#include <dcclite/Clock.h>
+#include <dcclite/Socket.h>
+
+#include <dcclite_shared/Packet.h>
+#include <dcclite_shared/SharedLibDefs.h>
+
+#include <fmt/format.h>
+
+#include "sys/Timeouts.h"
+#include "sys/ZeroConfSystem.h"
+
+using namespace dcclite;
+using namespace dcclite::broker::sys;
+using namespace std::chrono_literals;
+
+static constexpr uint32_t PACKET_MAGIC_NUMBER = 0xABCDDCCA;
+static constexpr uint8_t PACKET_VERSION = 0x01;
+static constexpr uint8_t FLAG_QUERY = 0x01;
+
+namespace
+{
+	/**
+	* A device looking for the broker, but on loopback, so no broadcast or multicast is needed
+	*/
+	class ZeroConfClient
+	{
+		public:
+			ZeroConfClient()
+			{
+				if (!m_clSocket.Open(0, Socket::Type::DATAGRAM))
+					throw std::runtime_error("[ZeroConfClient] Cannot open socket");
+			}
+
+			void SendQuery(const std::string_view serviceName)
+			{
+				BasePacket<192> packet;
+
+				packet.Write32(PACKET_MAGIC_NUMBER);
+				packet.Write8(PACKET_VERSION);
+				packet.Write8(FLAG_QUERY);
+
+				for (auto ch : serviceName)
+					packet.Write8(ch);
+
+				packet.Write8(0);
+
+				m_clSocket.Send(NetworkAddress{ 127, 0, 0, 1, DEFAULT_ZEROCONF_PORT }, packet.GetData(), packet.GetSize());
+			}
+
+			/**
+			* True if a reply was received, its contents are checked by the unit tests
+			*/
+			bool TryReceive()
+			{
+				uint8_t buffer[192];
+				NetworkAddress sender;
+
+				auto [status, size] = m_clSocket.Receive(sender, buffer, sizeof(buffer), true);
+				if (status != Socket::Status::OK)
+					return false;
+
+				BasePacket<192> packet{ buffer, static_cast<uint8_t>(size) };
+
+				return (packet.Read<uint32_t>() == PACKET_MAGIC_NUMBER) && (packet.Read<uint8_t>() == PACKET_VERSION) && !(packet.Read<uint8_t>() & FLAG_QUERY);
+			}
+
+		private:
+			Socket m_clSocket;
+	};
+}
+
+/**
+* Power comes back and the whole layout asks for the broker at the same time
+*/
+void ZeroConfSystemBenchmark()
+{
+	constexpr auto NUM_DEVICES = 30;
+	constexpr auto NUM_ROUNDS = 20;
+
+	ZeroConfSystem::Register("TestBroker", 4190);
+	ZeroConfSystem::Start("TestProject");
+
+	std::vector<ZeroConfClient> devices(NUM_DEVICES);
+
+	Benchmark::us_t totalLatency = 0;
+	Benchmark::us_t maxLatency = 0;
+
+	for (int round = 0; round < NUM_ROUNDS; ++round)
+	{
+		const auto start = Clock::DefaultClock_t::now();
+
+		for (auto &device : devices)
+			device.SendQuery("TestBroker");
+
+		std::vector<bool> answered(NUM_DEVICES);
+		int numAnswered = 0;
+
+		while ((numAnswered < NUM_DEVICES) && ((Clock::DefaultClock_t::now() - start) < 1s))
+		{
+			for (int i = 0; i < NUM_DEVICES; ++i)
+			{
+				if (answered[i] || !devices[i].TryReceive())
+					continue;
+
+				const auto latency = static_cast<Benchmark::us_t>(std::chrono::duration_cast<std::chrono::microseconds>(Clock::DefaultClock_t::now() - start).count());
+
+				totalLatency += latency;
+				maxLatency = std::max(maxLatency, latency);
+
+				answered[i] = true;
+				++numAnswered;
+			}
+		}
+
+		if (numAnswered != NUM_DEVICES)
+		{
+			ZeroConfSystem::Stop();
+
+			throw std::runtime_error(fmt::format("round {}: only {} of {} devices got a reply", round, numAnswered, NUM_DEVICES));
+		}
+
+		//give the flood control a fresh window, devices do not query that fast
+		std::this_thread::sleep_for(ZERO_CONF_SERVICE_PACKET_INTERVAL);
+	}
+
+	Benchmark stopTime;
+
+	stopTime.Start();
+	ZeroConfSystem::Stop();
+	stopTime.Stop();
+
+	//the old worker answered 16 queries and then slept for 100ms
+	fmt::print("[ZeroConfSystem] {} queries, latency {:.2f}us (max {:.2f}us)\n", NUM_ROUNDS * NUM_DEVICES, (double)(totalLatency / (NUM_ROUNDS * NUM_DEVICES)), (double)maxLatency);
+	fmt::print("[ZeroConfSystem] stop: {:.2f}ms\n", (double)stopTime.GetMs());
+}
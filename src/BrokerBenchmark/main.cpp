@@ -0,0 +1,76 @@
+// Copyright (C) 2019 - Bruno Sanches. See the COPYRIGHT
+// file at the top-level directory of this distribution.
+//
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+//
+// This Source Code Form is "Incompatible With Secondary Licenses", as
+// defined by the Mozilla Public License, v. 2.0.
+
+#include <exception>
+#include <string_view>
+
+#include <fmt/format.h>
+#include <spdlog/spdlog.h>
+
+#include "Benchmarks.h"
+
+struct BenchmarkInfo
+{
+	std::string_view m_svName;
+	void (*m_pfnProc)();
+};
+
+static const BenchmarkInfo g_arBenchmarks[] =
+{
+	{ "DataWriter", DataWriterBenchmark },
+	{ "Interlocking", InterlockingBenchmark },
+	{ "ItemQuery", ItemQueryBenchmark },
+	{ "LoconetController", LoconetControllerBenchmark },
+	{ "MainLoop", MainLoopBenchmark },
+	{ "OutputDecoderBatch", OutputDecoderBatchBenchmark },
+	{ "PacketSchema", PacketSchemaBenchmark },
+	{ "Section", SectionBenchmark },
+	{ "SignalDecoder", SignalDecoderBenchmark },
+	{ "ThrottleService", ThrottleServiceBenchmark },
+	{ "ZeroConfSystem", ZeroConfSystemBenchmark }
+};
+
+/**
+	BrokerBenchmark [name ...]
+
+	Runs all benchmarks or only the named ones
+*/
+int main(int argc, char **argv)
+{
+	//broker warnings only, traces would be measured too
+	spdlog::set_level(spdlog::level::warn);
+
+	int result = 0;
+
+	for (const auto &benchmark : g_arBenchmarks)
+	{
+		bool selected = argc < 2;
+		for (int i = 1; (i < argc) && !selected; ++i)
+			selected = benchmark.m_svName == argv[i];
+
+		if (!selected)
+			continue;
+
+		fmt::print("[{}] running...\n", benchmark.m_svName);
+
+		try
+		{
+			benchmark.m_pfnProc();
+		}
+		catch (const std::exception &ex)
+		{
+			fmt::print("[{}] failed: {}\n", benchmark.m_svName, ex.what());
+
+			result = -1;
+		}
+	}
+
+	return result;
+}
@@ -0,0 +1,200 @@
+// Copyright (C) 2019 - Bruno Sanches. See the COPYRIGHT
+// file at the top-level directory of this distribution.
+//
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+//
+// This Source Code Form is "Incompatible With Secondary Licenses", as
+// defined by the Mozilla Public License, v. 2.0.
+
+#include "ConfigUploadWindow.h"
+
+#include <algorithm>
+
+namespace dcclite::broker::exec::dcc
+{
+	ConfigUploadWindow::ConfigUploadWindow(size_t numItems, Duration_t initialTimeout, Duration_t minTimeout, Duration_t maxTimeout):
+		m_vecItems(numItems),
+		m_clRttEstimator{ initialTimeout, minTimeout, maxTimeout }
+	{
+		//empty
+	}
+
+	bool ConfigUploadWindow::TryFindNextItem(size_t &index) noexcept
+	{
+		//lost packets first, the device may be waiting for them
+		for (size_t i = 0; i < m_uNextNewItem; ++i)
+		{
+			if (m_vecItems[i].m_kState == States::LOST)
+			{
+				index = i;
+
+				return true;
+			}
+		}
+
+		//a selective ack may have confirmed items we never sent (device kept it from a previous attempt?)
+		while ((m_uNextNewItem < m_vecItems.size()) && (m_vecItems[m_uNextNewItem].m_kState != States::NOT_SENT))
+			++m_uNextNewItem;
+
+		if (m_uNextNewItem == m_vecItems.size())
+			return false;
+
+		index = m_uNextNewItem++;
+
+		return true;
+	}
+
+	dcclite::Clock::TimePoint_t ConfigUploadWindow::Update(const dcclite::Clock::TimePoint_t time, const Sender_t &sender)
+	{
+		//
+		//Check for timeouts first, so lost packets can be sent right away
+		bool timedOut = false;
+		for (auto &item : m_vecItems)
+		{
+			if ((item.m_kState != States::IN_FLIGHT) || (time < item.m_tSentTime + m_clRttEstimator.GetRetransmitTimeout()))
+				continue;
+
+			item.m_kState = States::LOST;
+			--m_uInFlight;
+
+			timedOut = true;
+		}
+
+		if (timedOut)
+		{
+			//nothing is getting through, restart from a single packet
+			m_clRttEstimator.OnTimeout();
+
+			m_uSlowStartThreshold = std::max(m_uWindow / 2, 2u);
+			m_uWindow = 1;
+			m_uWindowAcks = 0;
+			m_uRecoveryPoint = m_uSendCounter;
+		}
+
+		//
+		//Spread the window along the RTT, so the device has time to drain its buffer between packets
+		const auto pacing = m_clRttEstimator.GetNumSamples() ? m_clRttEstimator.GetSmoothedRtt() / m_uWindow : Duration_t{};
+
+		bool pendingItems = true;
+		while ((m_uInFlight < m_uWindow) && (time >= m_tNextSendTime))
+		{
+			size_t index;
+			if (!this->TryFindNextItem(index))
+			{
+				pendingItems = false;
+
+				break;
+			}
+
+			auto &item = m_vecItems[index];
+
+			const bool retransmission = item.m_kState != States::NOT_SENT;
+
+			item.m_kState = States::IN_FLIGHT;
+			item.m_tSentTime = time;
+			item.m_uSendOrder = ++m_uSendCounter;
+			item.m_fRetransmitted = item.m_fRetransmitted || retransmission;
+
+			++m_uInFlight;
+			++m_uNumTransmissions;
+
+			m_tNextSendTime = time + pacing;
+
+			sender(index, retransmission);
+		}
+
+		//
+		//When do we need to look again? Next paced send or next timeout, acks will also trigger an update
+		auto nextTime = time + m_clRttEstimator.GetRetransmitTimeout();
+
+		for (const auto &item : m_vecItems)
+		{
+			if (item.m_kState == States::IN_FLIGHT)
+				nextTime = std::min(nextTime, item.m_tSentTime + m_clRttEstimator.GetRetransmitTimeout());
+		}
+
+		if (pendingItems && (m_uInFlight < m_uWindow) && (m_tNextSendTime > time))
+			nextTime = std::min(nextTime, m_tNextSendTime);
+
+		return nextTime;
+	}
+
+	void ConfigUploadWindow::OnLoss(Item &item)
+	{
+		item.m_kState = States::LOST;
+		--m_uInFlight;
+
+		//a single reduction per window of data
+		if (item.m_uSendOrder <= m_uRecoveryPoint)
+			return;
+
+		m_uSlowStartThreshold = std::max(m_uWindow / 2, 2u);
+		m_uWindow = m_uSlowStartThreshold;
+		m_uWindowAcks = 0;
+		m_uRecoveryPoint = m_uSendCounter;
+	}
+
+	bool ConfigUploadWindow::Ack(size_t index, const dcclite::Clock::TimePoint_t time, const bool takeSample)
+	{
+		if (index >= m_vecItems.size())
+			return false;
+
+		auto &item = m_vecItems[index];
+		if (item.m_kState == States::ACKED)
+			return true;
+
+		if (item.m_kState == States::IN_FLIGHT)
+		{
+			--m_uInFlight;
+
+			//Karn: only packets sent once tell the real RTT
+			if (takeSample && !item.m_fRetransmitted)
+				m_clRttEstimator.AddSample(std::chrono::duration_cast<Duration_t>(time - item.m_tSentTime));
+		}
+
+		item.m_kState = States::ACKED;
+		++m_uNumAcked;
+
+		//slow start until the threshold, after that one packet per window
+		if (m_uWindow < m_uSlowStartThreshold)
+			++m_uWindow;
+		else if (++m_uWindowAcks >= m_uWindow)
+		{
+			m_uWindowAcks = 0;
+			++m_uWindow;
+		}
+
+		m_uWindow = std::min(m_uWindow, MAX_WINDOW);
+
+		//packets sent well before this one and still not acked are gone
+		if (item.m_uSendOrder > LOSS_THRESHOLD)
+		{
+			for (auto &other : m_vecItems)
+			{
+				if ((other.m_kState == States::IN_FLIGHT) && (other.m_uSendOrder + LOSS_THRESHOLD <= item.m_uSendOrder))
+					this->OnLoss(other);
+			}
+		}
+
+		return true;
+	}
+
+	bool ConfigUploadWindow::OnAck(size_t index, const dcclite::Clock::TimePoint_t time)
+	{
+		return this->Ack(index, time, true);
+	}
+
+	void ConfigUploadWindow::OnSelectiveAck(const dcclite::ConfigAcksBitPack_t &acks, const dcclite::Clock::TimePoint_t time)
+	{
+		const auto len = std::min(m_vecItems.size(), size_t{ acks.size() });
+
+		//no samples here, the ack for these may have been lost, so the time would be wrong
+		for (size_t i = 0; i < len; ++i)
+		{
+			if (acks[static_cast<unsigned>(i)])
+				this->Ack(i, time, false);
+		}
+	}
+}
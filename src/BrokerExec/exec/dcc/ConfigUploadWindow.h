@@ -0,0 +1,155 @@
+// Copyright (C) 2019 - Bruno Sanches. See the COPYRIGHT
+// file at the top-level directory of this distribution.
+//
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+//
+// This Source Code Form is "Incompatible With Secondary Licenses", as
+// defined by the Mozilla Public License, v. 2.0.
+
+#pragma once
+
+#include <functional>
+#include <vector>
+
+#include <dcclite/Clock.h>
+
+#include <dcclite_shared/Packet.h>
+
+#include "sys/RttEstimator.h"
+
+namespace dcclite::broker::exec::dcc
+{
+	/**
+	*
+	* Controls the upload of decoders configuration (CONFIG_DEV packets) to a device.
+	*
+	* Small devices (like an ENC28J60 on a Mega) have room for only a few packets on the NIC receive buffer, so sending
+	* everything at once makes most of the packets to be dropped. Instead only a window of packets is kept in flight and
+	* sends are spread along the round trip time:
+	*
+	*	- the window starts small, grows with each ack and is halved when packets are lost (like TCP congestion control)
+	*	- a packet is lost when LOSS_THRESHOLD packets sent after it were acked or when its retransmission timeout expires
+	*	- devices ack with the index of the config and a bitmap of all the configs received, so a lost ack is recovered by the next one
+	*
+	*/
+	class ConfigUploadWindow
+	{
+		public:
+			static constexpr unsigned INITIAL_WINDOW = 2;
+			static constexpr unsigned MAX_WINDOW = 16;
+			static constexpr unsigned LOSS_THRESHOLD = 3;
+
+			typedef sys::RttEstimator::Duration_t Duration_t;
+
+			/**
+			* Called for each packet that must be sent, retransmission is true if the index was already sent before
+			*/
+			typedef std::function<void(size_t index, bool retransmission)> Sender_t;
+
+			ConfigUploadWindow(size_t numItems, Duration_t initialTimeout, Duration_t minTimeout, Duration_t maxTimeout);
+
+			/**
+			* Sends what the window and the pacing allow, also checks for timeouts
+			*
+			* Returns when it should be called again, if no acks arrive before that
+			*/
+			dcclite::Clock::TimePoint_t Update(const dcclite::Clock::TimePoint_t time, const Sender_t &sender);
+
+			/**
+			* Returns false if the index is out of range
+			*/
+			bool OnAck(size_t index, const dcclite::Clock::TimePoint_t time);
+
+			void OnSelectiveAck(const dcclite::ConfigAcksBitPack_t &acks, const dcclite::Clock::TimePoint_t time);
+
+			[[nodiscard]] inline bool IsComplete() const noexcept
+			{
+				return m_uNumAcked == m_vecItems.size();
+			}
+
+			[[nodiscard]] inline bool IsAcked(size_t index) const noexcept
+			{
+				return m_vecItems[index].m_kState == States::ACKED;
+			}
+
+			[[nodiscard]] inline size_t GetNumAcked() const noexcept
+			{
+				return m_uNumAcked;
+			}
+
+			[[nodiscard]] inline unsigned GetWindow() const noexcept
+			{
+				return m_uWindow;
+			}
+
+			[[nodiscard]] inline unsigned GetInFlight() const noexcept
+			{
+				return m_uInFlight;
+			}
+
+			[[nodiscard]] inline unsigned GetNumTransmissions() const noexcept
+			{
+				return m_uNumTransmissions;
+			}
+
+			[[nodiscard]] inline const sys::RttEstimator &GetRttEstimator() const noexcept
+			{
+				return m_clRttEstimator;
+			}
+
+		private:
+			enum class States: uint8_t
+			{
+				NOT_SENT,
+				IN_FLIGHT,
+				LOST,
+				ACKED
+			};
+
+			struct Item
+			{
+				dcclite::Clock::TimePoint_t	m_tSentTime;
+
+				//order of the last transmission, used for detecting losses
+				unsigned					m_uSendOrder = 0;
+
+				States						m_kState = States::NOT_SENT;
+				bool						m_fRetransmitted = false;
+			};
+
+			bool Ack(size_t index, const dcclite::Clock::TimePoint_t time, const bool takeSample);
+
+			void OnLoss(Item &item);
+
+			bool TryFindNextItem(size_t &index) noexcept;
+
+		private:
+			std::vector<Item>			m_vecItems;
+
+			sys::RttEstimator			m_clRttEstimator;
+
+			dcclite::Clock::TimePoint_t	m_tNextSendTime;
+
+			size_t						m_uNumAcked = 0;
+
+			//where unsent items start, everything before it was sent at least once
+			size_t						m_uNextNewItem = 0;
+
+			unsigned					m_uWindow = INITIAL_WINDOW;
+			unsigned					m_uSlowStartThreshold = MAX_WINDOW;
+
+			//acks received since the window last grew, when in congestion avoidance
+			unsigned					m_uWindowAcks = 0;
+
+			unsigned					m_uInFlight = 0;
+
+			unsigned					m_uSendCounter = 0;
+
+			//losses of packets sent before this do not shrink the window again
+			unsigned					m_uRecoveryPoint = 0;
+
+			unsigned					m_uNumTransmissions = 0;
+	};
+}
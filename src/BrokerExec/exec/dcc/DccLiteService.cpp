@@ -92,6 +92,7 @@ namespace dcclite::broker::exec::dcc
 		BenchmarkLogger benchmark{ "DccLiteService", name.GetData() };
 
 		m_pDecoders = static_cast<FolderObject *>(this->AddChild(std::make_unique<FolderObject>(RName{ "decoders" })));
+		m_upDecoderIndices = std::make_unique<DecoderIndices>(*m_pDecoders);
 		m_pAddresses = static_cast<FolderObject *>(this->AddChild(std::make_unique<FolderObject>(RName{ "addresses" })));
 		m_pDecAddresses = static_cast<FolderObject *>(this->AddChild(std::make_unique<FolderObject>(RName{ "dec_addresses" })));
 		m_pDevices = static_cast<FolderObject *>(this->AddChild(std::make_unique<FolderObject>(RName{ "devices" })));
@@ -169,6 +170,8 @@ namespace dcclite::broker::exec::dcc
 		m_pAddresses->RemoveChild(addressName);
 		m_pDecoders->RemoveChild(dec.GetName());	
 		m_pDecAddresses->RemoveChild(RName{ address.ToDecimalString() });
+
+		this->InvalidateDecoderIndices();
 	}
 
 	Decoder &DccLiteService::Device_CreateDecoder(
@@ -190,6 +193,7 @@ namespace dcclite::broker::exec::dcc
 		auto pDecoder = decoder.get();	
 
 		m_pDecoders->AddChild(std::move(decoder));		
+		this->InvalidateDecoderIndices();
 
 		RName decimalAddress{ address.ToDecimalString() };
 		RName hexAddress{ address.ToString() };
@@ -230,6 +234,7 @@ namespace dcclite::broker::exec::dcc
 
 			//something bad happenned, cleanup to keep a consistent state
 			m_pDecoders->RemoveChild(pDecoder->GetName());
+			this->InvalidateDecoderIndices();
 
 			//blow up
 			throw;
@@ -381,36 +386,19 @@ namespace dcclite::broker::exec::dcc
 		return static_cast<Decoder *>(decoder ? decoder : m_pDecoders->TryResolveChild(id));
 	}
 
-	template <typename T>
-	std::vector<const T *> DccLiteService::FindAllDecoders() const
+	const std::vector<const SimpleOutputDecoder *> &DccLiteService::FindAllSimpleOutputDecoders() const
 	{
-		std::vector<const T *> vecDecoders;
-
-		m_pDecoders->VisitChildren([&vecDecoders](auto &obj)
-			{
-				if (auto decoder = dynamic_cast<const T *>(&obj))
-					vecDecoders.push_back(decoder);
-
-				return true;
-			}
-		);
-
-		return vecDecoders;
-	}
-
-	std::vector<const SimpleOutputDecoder *> DccLiteService::FindAllSimpleOutputDecoders() const
-	{
-		return this->FindAllDecoders<SimpleOutputDecoder>();
+		return m_upDecoderIndices->GetSimpleOutputs();
 	}
 
-	std::vector<const StateDecoder *> DccLiteService::FindAllInputDecoders() const
+	const std::vector<const StateDecoder *> &DccLiteService::FindAllInputDecoders() const
 	{
-		return this->FindAllDecoders<StateDecoder>();		
+		return m_upDecoderIndices->GetInputs();
 	}
 
-	std::vector<const TurnoutDecoder *> DccLiteService::FindAllTurnoutDecoders() const
+	const std::vector<const TurnoutDecoder *> &DccLiteService::FindAllTurnoutDecoders() const
 	{
-		return this->FindAllDecoders<TurnoutDecoder>();		
+		return m_upDecoderIndices->GetTurnouts();
 	}
 
 	void DccLiteService::Decoder_OnStateChanged(Decoder &decoder)
@@ -439,6 +427,8 @@ namespace dcclite::broker::exec::dcc
 	class NetworkHelloEvent: public sys::EventHub::IEvent
 	{
 		public:
+			static constexpr sys::EventHub::Lanes LANE = sys::EventHub::Lanes::NETWORK;
+
 			NetworkHelloEvent(DccLiteService &target, dcclite::NetworkAddress address, RName deviceName, const dcclite::Guid remoteSessionToken, const dcclite::Guid remoteConfigToken, uint16_t protocolVersion):
 				IEvent(target),
 				m_clAddress(address),
@@ -484,13 +474,14 @@ namespace dcclite::broker::exec::dcc
 		const auto procotolVersion = packet.Read<std::uint16_t>();
 
 		[[unlikely]]
-		if (procotolVersion != dcclite::PROTOCOL_VERSION)
+		if ((procotolVersion < dcclite::PROTOCOL_MIN_VERSION) || (procotolVersion > dcclite::PROTOCOL_VERSION))
 		{
-			dcclite::Log::Error("[DccLiteService::{}] [OnNet_Hello] Hello from {} - {} with invalid protocol version {}, expected {}, ignoring",
+			dcclite::Log::Error("[DccLiteService::{}] [OnNet_Hello] Hello from {} - {} with invalid protocol version {}, expected {} - {}, ignoring",
 				this->GetName(),
 				name,
 				senderAddress,
 				procotolVersion,
+				dcclite::PROTOCOL_MIN_VERSION,
 				dcclite::PROTOCOL_VERSION
 			);
 
@@ -562,6 +553,8 @@ namespace dcclite::broker::exec::dcc
 	class GenericNetworkEvent: public sys::EventHub::IEvent
 	{
 		public:
+			static constexpr sys::EventHub::Lanes LANE = sys::EventHub::Lanes::NETWORK;
+
 			GenericNetworkEvent(DccLiteService &target, dcclite::NetworkAddress address, const dcclite::Packet &packet, dcclite::MsgTypes msgType):
 				IEvent(target),				
 				m_clAddress(address),
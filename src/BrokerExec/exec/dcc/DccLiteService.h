@@ -11,6 +11,7 @@
 #pragma once
 
 #include <map>
+#include <memory>
 #include <string>
 #include <thread>
 #include <vector>
@@ -21,6 +22,7 @@
 #include <dcclite/Socket.h>
 
 #include "Decoder.h"
+#include "DecoderIndices.h"
 #include "IDccLiteService.h"
 
 #include "sys/Service.h"
@@ -87,12 +89,21 @@ namespace dcclite::broker::exec::dcc
 			// 
 			//
 
+			// The returned lists are cached and rebuilt only when decoders are created or destroyed, 
+			// so do not keep them around
+			//
+
 			//This returns only pure outputs, turnouts are ignored
-			std::vector<const SimpleOutputDecoder *> FindAllSimpleOutputDecoders() const;
+			const std::vector<const SimpleOutputDecoder *> &FindAllSimpleOutputDecoders() const;
+
+			const std::vector<const StateDecoder *> &FindAllInputDecoders() const;
 
-			std::vector<const StateDecoder *> FindAllInputDecoders() const;
+			const std::vector<const TurnoutDecoder *> &FindAllTurnoutDecoders() const;			
 
-			std::vector<const TurnoutDecoder *> FindAllTurnoutDecoders() const;			
+			inline DecoderIndices &GetDecoderIndices() const noexcept
+			{
+				return *m_upDecoderIndices;
+			}
 
 		private:			
 			void OnNetEvent_Hello(
@@ -103,8 +114,10 @@ namespace dcclite::broker::exec::dcc
 				const std::uint16_t				protocolVersion
 			);
 
-			template <typename T>
-			std::vector<const T *> FindAllDecoders() const;
+			inline void InvalidateDecoderIndices() noexcept
+			{
+				m_upDecoderIndices->Invalidate();
+			}
 
 			void OnNetEvent_Packet(const dcclite::NetworkAddress &senderAddress, dcclite::Packet &packet, const dcclite::MsgTypes msgType);
 
@@ -189,6 +202,11 @@ namespace dcclite::broker::exec::dcc
 			FolderObject *m_pDecAddresses;
 
 			LocationManager *m_pLocations;
+
+			/// <summary>
+			/// Typed lists of decoders, used by the queries. Lazy rebuilt after decoders are created or destroyed
+			/// </summary>
+			std::unique_ptr<DecoderIndices> m_upDecoderIndices;
 	};
 }
 
@@ -0,0 +1,185 @@
+// Copyright (C) 2019 - Bruno Sanches. See the COPYRIGHT
+// file at the top-level directory of this distribution.
+// 
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+// 
+// This Source Code Form is "Incompatible With Secondary Licenses", as
+// defined by the Mozilla Public License, v. 2.0.
+
+#include "DccppResponseCache.h"
+
+#include <iterator>
+
+#include <dcclite/FmtUtils.h>
+#include <dcclite/Nmra.h>
+
+#include "DecoderIndices.h"
+#include "SimpleOutputDecoder.h"
+#include "StateDecoder.h"
+#include "TurnoutDecoder.h"
+
+namespace dcclite::broker::exec::dcc
+{
+	DccppResponseCache::DccppResponseCache(DecoderIndices &indices):
+		m_rclIndices{ indices }
+	{
+		//empty
+	}
+
+	void DccppResponseCache::OnItemChanged(const IItem &item)
+	{
+		if (!m_fValid)
+			return;
+
+		auto it = m_mapPatches.find(&item);
+		if (it == m_mapPatches.end())
+			return;
+
+		const bool active = it->second.m_pclDecoder->GetState() == DecoderStates::ACTIVE;
+
+		for (auto &patch : it->second.m_vecPatches)
+		{
+			(*patch.m_pstrResponse)[patch.m_uOffset] = active ? patch.m_chActive : patch.m_chInactive;
+		}
+	}
+
+	void DccppResponseCache::Invalidate() noexcept
+	{
+		m_fValid = false;
+
+		//decoders may be gone, so do not keep any pointer around
+		m_mapPatches.clear();
+	}
+
+	const std::string &DccppResponseCache::GetResponse(const Responses response)
+	{
+		if (!m_fValid)
+			this->Rebuild();
+
+		return m_arResponses[response];
+	}
+
+	bool DccppResponseCache::HasSensors()
+	{
+		return !m_rclIndices.GetInputs().empty();
+	}
+
+	void DccppResponseCache::AppendState(std::string &response, const StateDecoder &decoder, const char active, const char inactive)
+	{
+		auto &patches = m_mapPatches[static_cast<const IItem *>(&decoder)];
+
+		patches.m_pclDecoder = &decoder;
+		patches.m_vecPatches.push_back(StatePatch{ &response, response.size(), active, inactive });
+
+		response.push_back(decoder.GetState() == DecoderStates::ACTIVE ? active : inactive);
+	}
+
+	void DccppResponseCache::Rebuild()
+	{
+		m_mapPatches.clear();
+
+		for (auto &response : m_arResponses)
+			response.clear();
+
+		const auto &turnoutDecoders = m_rclIndices.GetTurnouts();
+		const auto &outputDecoders = m_rclIndices.GetSimpleOutputs();
+		const auto &sensorDecoders = m_rclIndices.GetInputs();
+
+		//
+		//<s>
+		auto &status = m_arResponses[STATUS];
+		status = "<iDCC-EX V-5.0.7 / DccLite / PC G-BCS><N1: Ethernet><p0MAIN>";
+
+		if (turnoutDecoders.empty())
+			status.append("<X>");
+
+		for (auto turnout : turnoutDecoders)
+		{
+			fmt::format_to(std::back_inserter(status), "<H {} ", turnout->GetAddress());
+			this->AppendState(status, *turnout, '1', '0');
+			status.push_back('>');
+		}
+
+		if (outputDecoders.empty())
+			status.append("<X>");
+
+		for (auto dec : outputDecoders)
+		{
+			fmt::format_to(std::back_inserter(status), "<Y {} ", dec->GetAddress());
+			this->AppendState(status, *dec, '1', '0');
+			status.push_back('>');
+		}
+
+		//
+		//<Q>
+		auto &sensorsState = m_arResponses[SENSORS_STATE];
+		if (sensorDecoders.empty())
+			sensorsState.append("<X>");
+
+		for (auto dec : sensorDecoders)
+		{
+			sensorsState.push_back('<');
+			this->AppendState(sensorsState, *dec, 'Q', 'q');
+			fmt::format_to(std::back_inserter(sensorsState), "{}>", dec->GetAddress());
+		}
+
+		//
+		//<S>
+		auto &sensorsDef = m_arResponses[SENSORS_DEF];
+		if (sensorDecoders.empty())
+			sensorsDef.append("<X>");
+
+		for (auto dec : sensorDecoders)
+		{
+			fmt::format_to(std::back_inserter(sensorsDef), "<Q{} 1 false>;", dec->GetAddress());
+		}
+
+		//
+		//<T>
+		auto &turnoutsDef = m_arResponses[TURNOUTS_DEF];
+		if (turnoutDecoders.empty())
+			turnoutsDef.append("<X>");
+
+		for (auto turnout : turnoutDecoders)
+		{
+			auto addressNum = turnout->GetAddress().GetAddress();
+			auto nmraAddress = dcclite::ConvertAddressToNMRA(addressNum);
+
+			fmt::format_to(std::back_inserter(turnoutsDef), "<H {} {} {} ", addressNum, std::get<0>(nmraAddress), std::get<1>(nmraAddress));
+			this->AppendState(turnoutsDef, *turnout, '1', '0');
+			turnoutsDef.push_back('>');
+		}
+
+		//
+		//<JT>
+		auto &turnoutsIdList = m_arResponses[TURNOUTS_ID_LIST];
+		turnoutsIdList.append("<jT");
+
+		for (auto turnout : turnoutDecoders)
+		{
+			fmt::format_to(std::back_inserter(turnoutsIdList), " {}", turnout->GetAddress());
+		}
+
+		turnoutsIdList.push_back('>');
+
+		//
+		//<Z>
+		auto &outputsDef = m_arResponses[OUTPUTS_DEF];
+		if (outputDecoders.empty())
+			outputsDef.append("<X>");
+
+		for (auto dec : outputDecoders)
+		{
+			fmt::format_to(std::back_inserter(outputsDef), "<Y {} {} {} ", dec->GetAddress(), dec->GetPin().Raw(), dec->GetDccppFlags());
+			this->AppendState(outputsDef, *dec, '1', '0');
+
+			fmt::format_to(std::back_inserter(outputsDef), "><Y {} ", dec->GetAddress());
+			this->AppendState(outputsDef, *dec, '1', '0');
+			outputsDef.push_back('>');
+		}
+
+		m_fValid = true;
+	}
+}
@@ -0,0 +1,98 @@
+// Copyright (C) 2019 - Bruno Sanches. See the COPYRIGHT
+// file at the top-level directory of this distribution.
+// 
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+// 
+// This Source Code Form is "Incompatible With Secondary Licenses", as
+// defined by the Mozilla Public License, v. 2.0.
+
+#pragma once
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace dcclite
+{
+	class IItem;
+}
+
+namespace dcclite::broker::exec::dcc
+{
+	class DecoderIndices;
+	class StateDecoder;
+
+	/**
+	* Keeps the responses for the queries that list all decoders preformatted, so the frequent polls done by JMRI
+	* and EX-Toolbox (<s>, <Q>, etc) become a single write.
+	* 
+	* The responses are rebuilt only when decoders are created or destroyed. State changes are patched in place, because 
+	* on all responses the decoder state is a single char.
+	*/
+	class DccppResponseCache
+	{
+		public:
+			enum Responses
+			{
+				STATUS,
+				SENSORS_STATE,
+				SENSORS_DEF,
+				TURNOUTS_DEF,
+				TURNOUTS_ID_LIST,
+				OUTPUTS_DEF,
+
+				NUM_RESPONSES
+			};
+
+			explicit DccppResponseCache(DecoderIndices &indices);
+
+			DccppResponseCache(const DccppResponseCache &) = delete;
+			DccppResponseCache(DccppResponseCache &&) = delete;
+
+			const std::string &GetResponse(const Responses response);
+
+			bool HasSensors();
+
+			/**
+			* Must be called when decoders are created or destroyed, the responses are rebuilt on the next query
+			*/
+			void Invalidate() noexcept;
+
+			/**
+			* Patches the state of the decoder on the responses, items that are not on the responses are ignored
+			*/
+			void OnItemChanged(const IItem &item);
+
+		private:
+			void Rebuild();
+
+			void AppendState(std::string &response, const StateDecoder &decoder, const char active, const char inactive);
+
+		private:
+			struct StatePatch
+			{
+				std::string *m_pstrResponse;
+				size_t		m_uOffset;
+
+				char		m_chActive;
+				char		m_chInactive;
+			};
+
+			struct DecoderPatches
+			{
+				const StateDecoder		*m_pclDecoder;
+				std::vector<StatePatch>	m_vecPatches;
+			};
+
+			DecoderIndices			&m_rclIndices;
+
+			std::string				m_arResponses[NUM_RESPONSES];
+
+			//indexed by IItem, so events can be handled without casts
+			std::unordered_map<const IItem *, DecoderPatches> m_mapPatches;
+
+			bool m_fValid = false;
+	};
+}
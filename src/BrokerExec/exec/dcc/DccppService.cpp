@@ -27,6 +27,7 @@
 
 #include "Decoder.h"
 #include "DccLiteService.h"
+#include "DccppResponseCache.h"
 #include "SignalDecoder.h"
 #include "SimpleOutputDecoder.h"
 #include "SensorDecoder.h"
@@ -48,7 +49,7 @@ namespace dcclite::broker::exec::dcc
 	class DccppClient: private sys::IObjectManagerListener, public sys::EventHub::IEventTarget
 	{
 		public:
-			DccppClient(DccppServiceImplClientProxy &owner, DccLiteService &dccLite, const NetworkAddress address, Socket&& socket);
+			DccppClient(DccppServiceImplClientProxy &owner, DccLiteService &dccLite, DccppResponseCache &responseCache, const NetworkAddress address, Socket&& socket);
 
 			DccppClient(const DccppClient& client) = delete;
 			DccppClient(DccppClient&& other) = delete;
@@ -71,13 +72,6 @@ namespace dcclite::broker::exec::dcc
 			void ParseStatusCommand(dcclite::Parser &parser, const std::string &msg);
 			bool ParseSensorCommand(dcclite::Parser &parser, const std::string &msg);
 
-			bool CreateTurnoutsStateResponse(std::stringstream &stream) const;
-
-			bool CreateTurnoutsIdListResponse(std::stringstream &stream) const;
-
-			bool CreateTurnoutsDefResponse(std::stringstream &stream) const;
-			bool CreateOutputsDefResponse(std::stringstream &stream) const;
-
 			void OnMessage(const std::string &msg);
 
 			void ThreadProc();		
@@ -85,6 +79,8 @@ namespace dcclite::broker::exec::dcc
 			class ClientEvent: public sys::EventHub::IEvent
 			{
 				public:
+					static constexpr sys::EventHub::Lanes LANE = sys::EventHub::Lanes::TERMINAL;
+
 					ClientEvent(DccppClient &target, std::string msg):
 						IEvent(target),
 						m_strMessage(std::move(msg))
@@ -105,6 +101,7 @@ namespace dcclite::broker::exec::dcc
 			NetMessenger				m_clMessenger;
 			DccppServiceImplClientProxy &m_rclOwner;
 			DccLiteService				&m_rclSystem;	
+			DccppResponseCache			&m_rclResponseCache;
 
 			sigslot::scoped_connection	m_slotSystemConnection;
 
@@ -130,11 +127,15 @@ namespace dcclite::broker::exec::dcc
 
 			void Async_ClientDisconnected(DccppClient &client) override;		
 
+			void OnDccLiteEvent(const sys::ObjectManagerEvent &event);
+
 		private:
 			
 			class ClientDisconnectedEvent: public sys::EventHub::IEvent
 			{
 				public:
+					static constexpr sys::EventHub::Lanes LANE = sys::EventHub::Lanes::TERMINAL;
+
 					ClientDisconnectedEvent(DccppServiceImpl &target, DccppClient &client):
 						IEvent(target),
 						m_rclClient(client)
@@ -154,6 +155,8 @@ namespace dcclite::broker::exec::dcc
 			class AcceptConnectionEvent: public sys::EventHub::IEvent
 			{
 				public:
+					static constexpr sys::EventHub::Lanes LANE = sys::EventHub::Lanes::TERMINAL;
+
 					AcceptConnectionEvent(DccppServiceImpl &target, const dcclite::NetworkAddress address, dcclite::Socket socket):
 						IEvent(target),
 						m_clAddress(address),
@@ -175,6 +178,10 @@ namespace dcclite::broker::exec::dcc
 		private:			
 			DccLiteService  &m_rclDccService;			
 
+			DccppResponseCache							m_clResponseCache;
+
+			sigslot::scoped_connection					m_slotDccLiteConnection;
+
 			//
 			//Network communication
 			//
@@ -185,10 +192,11 @@ namespace dcclite::broker::exec::dcc
 			std::vector<std::unique_ptr<DccppClient>>	m_vecClients;
 	};
 
-	DccppClient::DccppClient(DccppServiceImplClientProxy &owner, DccLiteService &system, const NetworkAddress address, Socket &&socket):
+	DccppClient::DccppClient(DccppServiceImplClientProxy &owner, DccLiteService &system, DccppResponseCache &responseCache, const NetworkAddress address, Socket &&socket):
 		m_clMessenger(std::move(socket), ">"),
 		m_rclOwner(owner),
 		m_rclSystem(system),
+		m_rclResponseCache(responseCache),
 		m_clAddress(address)
 	{
 		m_slotSystemConnection = m_rclSystem.m_sigEvent.connect(&DccppClient::OnObjectManagerEvent, this);
@@ -235,29 +243,6 @@ namespace dcclite::broker::exec::dcc
 		}
 	}
 
-	static inline std::string CreateSensorStateResponse(const std::vector<const StateDecoder *> &sensorDecoders)
-	{
-		std::stringstream response;
-	
-		if (!sensorDecoders.empty())
-		{
-			for (auto dec : sensorDecoders)
-			{
-
-				response <<
-					"<" << (dec->GetState() == DecoderStates::ACTIVE ? 'Q' : 'q') <<
-					dec->GetAddress().GetAddress() <<
-					'>';
-			}
-		}
-		else
-		{
-			response << "<X>";
-		}
-
-		return response.str();
-	}
-
 	static bool ParseSignalCommandM(dcclite::Parser &parser, const std::string &msg, DccLiteService &liteService)
 	{	
 		int num1;
@@ -343,119 +328,21 @@ namespace dcclite::broker::exec::dcc
 		return true;
 	}
 
-	bool DccppClient::CreateTurnoutsStateResponse(std::stringstream &response) const
-	{
-		auto turnoutDecoders = m_rclSystem.FindAllTurnoutDecoders();
-		if (turnoutDecoders.empty())
-		{
-			response << "<X>";
-			return false;
-		}		
-	
-		for (auto turnout : turnoutDecoders)
-		{
-			response << CreateTurnoutDecoderStateResponse(*turnout);
-		}
-
-		return true;
-	}
-
-	bool DccppClient::CreateTurnoutsIdListResponse(std::stringstream &response) const
-	{		
-		response << "<jT";
-
-		auto turnoutDecoders = m_rclSystem.FindAllTurnoutDecoders();
-		if (turnoutDecoders.empty())
-		{
-			response << ">";
-			return false;
-		}
-
-		for (auto turnout : turnoutDecoders)
-		{
-			response << ' ' << turnout->GetAddress().GetAddress();
-		}
-
-		response << ">";
-		return true;
-	}
-
-	bool DccppClient::CreateTurnoutsDefResponse(std::stringstream &response) const
-	{
-		auto turnoutDecoders = m_rclSystem.FindAllTurnoutDecoders();
-		if (turnoutDecoders.empty())
-		{
-			response << "<X>";
-			return false;
-		}
-
-		for (auto turnout : turnoutDecoders)
-		{
-			auto addressNum = turnout->GetAddress().GetAddress();
-			auto nmraAddress = dcclite::ConvertAddressToNMRA(addressNum);
-
-			response << "<H " << 
-				addressNum << ' ' << 
-				std::get<0>(nmraAddress) << ' ' << 
-				std::get<1>(nmraAddress) << ' ' << 
-				((turnout->GetState() == DecoderStates::ACTIVE) ? 1 : 0 ) << 
-			">";
-		}
-
-		return true;
-	}
-
-	bool DccppClient::CreateOutputsDefResponse(std::stringstream &response) const
-	{
-		auto outputDecoders = m_rclSystem.FindAllSimpleOutputDecoders();
-		if (outputDecoders.empty())
-		{
-			response << "<X>";
-			return false;
-		}
-	
-		for (auto dec : outputDecoders)
-		{
-			response << "<Y " << 
-				dec->GetAddress() << ' ' << 
-				dec->GetPin() << ' ' << 
-				(int)dec->GetDccppFlags() << ' ' << 
-				((dec->GetState() == DecoderStates::ACTIVE) ? 1 : 0) <<
-			">";
-
-			response << CreateOutputDecoderStateResponse(*dec);
-		}	
-
-		return true;
-	}
-
+	///////////////////////////////////////////////////////////////////////////
+	//
+	//
+	// DccppClient
+	// 
+	//
+	///////////////////////////////////////////////////////////////////////////
 
 	void DccppClient::ParseStatusCommand(dcclite::Parser &parser, const std::string &msg)
 	{
-		std::stringstream response;
-		response << "<iDCC-EX V-5.0.7 / DccLite / PC G-BCS><N1: Ethernet><p0MAIN>";
-
-		this->CreateTurnoutsStateResponse(response);
-			
-		auto outputDecoders = m_rclSystem.FindAllSimpleOutputDecoders();
-		if (!outputDecoders.empty())
-		{
-			for (auto dec : outputDecoders)
-			{
-				response << CreateOutputDecoderStateResponse(*dec);
-			}
-		}
-		else
-		{
-			response << "<X>";
-		}	
-
-		m_clMessenger.Send(m_clAddress, response.str());
+		m_clMessenger.Send(m_clAddress, m_rclResponseCache.GetResponse(DccppResponseCache::STATUS));
 
 		//DCCPP by default seems to do not request this, so we send so it has sensors states at load
-		auto sensorDecoders = m_rclSystem.FindAllInputDecoders();
-		if (!sensorDecoders.empty())		
-			m_clMessenger.Send(m_clAddress, CreateSensorStateResponse(sensorDecoders));
+		if (m_rclResponseCache.HasSensors())
+			m_clMessenger.Send(m_clAddress, m_rclResponseCache.GetResponse(DccppResponseCache::SENSORS_STATE));
 	}
 
 	bool DccppClient::ParseSensorCommand(dcclite::Parser &parser, const std::string &msg)
@@ -467,33 +354,8 @@ namespace dcclite::broker::exec::dcc
 			return false;
 		}
 	
-		std::stringstream response;
-
 		//Send all sensors definition
-		auto sensorDecoders = m_rclSystem.FindAllInputDecoders();
-		if (!sensorDecoders.empty())
-		{
-			for (auto dec : sensorDecoders)
-			{	
-				response << "<Q" << dec->GetAddress().GetAddress() << " 1 false>;";
-#if 0
-				response <<
-					"<Q" <<
-					dec->GetAddress().GetAddress() <<
-					' ' <<
-					static_cast<unsigned int>(dec->GetPin()) <<
-					' ' <<
-					dec->HasPullUp() <<
-					'>';
-#endif
-			}
-		}
-		else
-		{
-			response << "<X>";
-		}
-
-		m_clMessenger.Send(m_clAddress, response.str());	
+		m_clMessenger.Send(m_clAddress, m_rclResponseCache.GetResponse(DccppResponseCache::SENSORS_DEF));
 
 		return true;	
 	}
@@ -718,10 +580,7 @@ namespace dcclite::broker::exec::dcc
 						}
 						else
 						{
-							std::stringstream response;
-
-							this->CreateTurnoutsIdListResponse(response);
-							m_clMessenger.Send(m_clAddress, response.str());
+							m_clMessenger.Send(m_clAddress, m_rclResponseCache.GetResponse(DccppResponseCache::TURNOUTS_ID_LIST));
 						}
 						break;
 
@@ -757,8 +616,7 @@ namespace dcclite::broker::exec::dcc
 				}
 				else
 				{				
-					auto sensorDecoders = m_rclSystem.FindAllInputDecoders();
-					m_clMessenger.Send(m_clAddress, CreateSensorStateResponse(sensorDecoders));
+					m_clMessenger.Send(m_clAddress, m_rclResponseCache.GetResponse(DccppResponseCache::SENSORS_STATE));
 				}
 				break;
 
@@ -769,15 +627,11 @@ namespace dcclite::broker::exec::dcc
 				const auto tokenType = parser.GetNumber(id);
 				if (tokenType == Tokens::END_OF_BUFFER)
 				{
-					std::stringstream response;
-
-					if (cmdToken.m_svData[0] == 'T')
-						this->CreateTurnoutsDefResponse(response);
-					else
-						this->CreateOutputsDefResponse(response);
-
-
-					m_clMessenger.Send(m_clAddress, response.str());
+					m_clMessenger.Send(
+						m_clAddress, 
+						m_rclResponseCache.GetResponse(cmdToken.m_svData[0] == 'T' ? DccppResponseCache::TURNOUTS_DEF : DccppResponseCache::OUTPUTS_DEF)
+					);
+					
 					break;
 				}
 
@@ -874,8 +728,11 @@ ERROR_RESPONSE:
 
 	DccppServiceImpl::DccppServiceImpl(RName name, sys::Broker &broker, const rapidjson::Value& params, DccLiteService &dependency):
 		DccppService(name, broker, params),		
-		m_rclDccService{ dependency }
+		m_rclDccService{ dependency },
+		m_clResponseCache{ dependency.GetDecoderIndices() }
 	{		
+		m_slotDccLiteConnection = m_rclDccService.m_sigEvent.connect(&DccppServiceImpl::OnDccLiteEvent, this);
+
 		//standard port used by DCC++
 		const auto port = dcclite::json::TryGetDefaultInt(params, "port", DEFAULT_DCCPP_PORT);
 
@@ -910,6 +767,14 @@ ERROR_RESPONSE:
 		sys::EventHub::CancelEvents(*this);
 	}
 
+	void DccppServiceImpl::OnDccLiteEvent(const sys::ObjectManagerEvent &event)
+	{
+		if (event.m_kType == sys::ObjectManagerEvent::ITEM_CHANGED)
+			m_clResponseCache.OnItemChanged(event.m_rclItem);
+		else if (dynamic_cast<const Decoder *>(&event.m_rclItem))
+			m_clResponseCache.Invalidate();
+	}
+
 	void DccppServiceImpl::OnAcceptConnection(const dcclite::NetworkAddress &address, Socket s)
 	{
 		assert(dcclite::IsMainThread());
@@ -917,6 +782,7 @@ ERROR_RESPONSE:
 		auto client = std::make_unique<DccppClient>(
 			*static_cast<DccppServiceImplClientProxy *>(this), 
 			m_rclDccService, 
+			m_clResponseCache,
 			address, 
 			std::move(s)
 		);
@@ -0,0 +1,75 @@
+// Copyright (C) 2019 - Bruno Sanches. See the COPYRIGHT
+// file at the top-level directory of this distribution.
+// 
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+// 
+// This Source Code Form is "Incompatible With Secondary Licenses", as
+// defined by the Mozilla Public License, v. 2.0.
+
+#include "DecoderIndices.h"
+
+#include <dcclite/FolderObject.h>
+
+#include "SimpleOutputDecoder.h"
+#include "StateDecoder.h"
+#include "TurnoutDecoder.h"
+
+namespace dcclite::broker::exec::dcc
+{
+	DecoderIndices::DecoderIndices(const dcclite::FolderObject &decoders):
+		m_rclDecoders{ decoders }
+	{
+		//empty
+	}
+
+	template <typename T>
+	void DecoderIndices::FindAll(std::vector<const T *> &vecDecoders) const
+	{
+		vecDecoders.clear();
+
+		m_rclDecoders.ConstVisitChildren([&vecDecoders](const auto &obj)
+			{
+				if (auto decoder = dynamic_cast<const T *>(&obj))
+					vecDecoders.push_back(decoder);
+
+				return true;
+			}
+		);
+	}
+
+	void DecoderIndices::Update()
+	{
+		[[likely]]
+		if (m_fValid)
+			return;
+
+		this->FindAll(m_vecSimpleOutputs);
+		this->FindAll(m_vecInputs);
+		this->FindAll(m_vecTurnouts);
+
+		m_fValid = true;
+	}
+
+	const std::vector<const SimpleOutputDecoder *> &DecoderIndices::GetSimpleOutputs()
+	{
+		this->Update();
+
+		return m_vecSimpleOutputs;
+	}
+
+	const std::vector<const StateDecoder *> &DecoderIndices::GetInputs()
+	{
+		this->Update();
+
+		return m_vecInputs;
+	}
+
+	const std::vector<const TurnoutDecoder *> &DecoderIndices::GetTurnouts()
+	{
+		this->Update();
+
+		return m_vecTurnouts;
+	}
+}
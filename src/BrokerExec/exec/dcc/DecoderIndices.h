@@ -0,0 +1,68 @@
+// Copyright (C) 2019 - Bruno Sanches. See the COPYRIGHT
+// file at the top-level directory of this distribution.
+// 
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+// 
+// This Source Code Form is "Incompatible With Secondary Licenses", as
+// defined by the Mozilla Public License, v. 2.0.
+
+#pragma once
+
+#include <vector>
+
+namespace dcclite
+{
+	class FolderObject;
+}
+
+namespace dcclite::broker::exec::dcc
+{
+	class SimpleOutputDecoder;
+	class StateDecoder;
+	class TurnoutDecoder;
+
+	/**
+	* 
+	* Typed lists of the decoders stored on a folder, so queries do not need to walk all decoders with dynamic_cast.
+	* 
+	* The lists are rebuilt lazily, so the owner of the folder must call Invalidate after any decoder is added or removed
+	* 
+	*/
+	class DecoderIndices
+	{
+		public:
+			explicit DecoderIndices(const dcclite::FolderObject &decoders);
+
+			DecoderIndices(const DecoderIndices &) = delete;
+			DecoderIndices(DecoderIndices &&) = delete;
+
+			inline void Invalidate() noexcept
+			{
+				m_fValid = false;
+			}
+
+			//This returns only pure outputs, turnouts are ignored
+			const std::vector<const SimpleOutputDecoder *> &GetSimpleOutputs();
+
+			const std::vector<const StateDecoder *> &GetInputs();
+
+			const std::vector<const TurnoutDecoder *> &GetTurnouts();
+
+		private:
+			template <typename T>
+			void FindAll(std::vector<const T *> &vecDecoders) const;
+
+			void Update();
+
+		private:
+			const dcclite::FolderObject &m_rclDecoders;
+
+			std::vector<const SimpleOutputDecoder *>	m_vecSimpleOutputs;
+			std::vector<const StateDecoder *>			m_vecInputs;
+			std::vector<const TurnoutDecoder *>			m_vecTurnouts;
+
+			bool m_fValid = false;
+	};
+}
@@ -0,0 +1,327 @@
+// Copyright (C) 2019 - Bruno Sanches. See the COPYRIGHT
+// file at the top-level directory of this distribution.
+//
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+//
+// This Source Code Form is "Incompatible With Secondary Licenses", as
+// defined by the Mozilla Public License, v. 2.0.
+
+#include "ItemQuery.h"
+
+#include <stdexcept>
+
+#include <fmt/format.h>
+
+#include "DccLiteService.h"
+#include "Device.h"
+#include "OutputDecoder.h"
+#include "RemoteDecoder.h"
+#include "StateDecoder.h"
+#include "TurnoutDecoder.h"
+
+namespace dcclite::broker::exec::dcc
+{
+	bool GlobMatch(std::string_view pattern, std::string_view text) noexcept
+	{
+		size_t p = 0, t = 0;
+
+		//where to resume if a mismatch happens after a *
+		size_t starPos = std::string_view::npos, starText = 0;
+
+		while (t < text.size())
+		{
+			if ((p < pattern.size()) && ((pattern[p] == '?') || (pattern[p] == text[t])))
+			{
+				++p;
+				++t;
+			}
+			else if ((p < pattern.size()) && (pattern[p] == '*'))
+			{
+				starPos = p++;
+				starText = t;
+			}
+			else if (starPos != std::string_view::npos)
+			{
+				//let the last * eat one more char
+				p = starPos + 1;
+				t = ++starText;
+			}
+			else
+			{
+				return false;
+			}
+		}
+
+		while ((p < pattern.size()) && (pattern[p] == '*'))
+			++p;
+
+		return p == pattern.size();
+	}
+
+	bool ItemQuery::Term::Matches(std::string_view text) const noexcept
+	{
+		return GlobMatch(m_strPattern, text) != m_fNegated;
+	}
+
+	static void SetTerm(std::string &pattern, std::string_view term, std::string_view value)
+	{
+		if (value.empty())
+			throw std::invalid_argument(fmt::format("[ItemQuery::Parse] Term {} requires a value", term));
+
+		if (!pattern.empty())
+			throw std::invalid_argument(fmt::format("[ItemQuery::Parse] Term {} cannot be used twice", term));
+
+		pattern = value;
+	}
+
+	template <typename T>
+	static void SetFlag(std::optional<T> &flag, std::string_view term, T value)
+	{
+		if (flag)
+			throw std::invalid_argument(fmt::format("[ItemQuery::Parse] Term {} cannot be used twice", term));
+
+		flag = value;
+	}
+
+	ItemQuery ItemQuery::Parse(std::string_view query)
+	{
+		ItemQuery result;
+
+		bool empty = true;
+
+		size_t pos = 0;
+		while (pos < query.size())
+		{
+			if (query[pos] == ' ')
+			{
+				++pos;
+				continue;
+			}
+
+			auto end = query.find(' ', pos);
+			if (end == std::string_view::npos)
+				end = query.size();
+
+			auto term = query.substr(pos, end - pos);
+			pos = end;
+
+			empty = false;
+
+			const bool negated = term[0] == '!';
+			if (negated)
+				term.remove_prefix(1);
+
+			auto separator = term.find('=');
+			if (separator != std::string_view::npos)
+			{
+				auto key = term.substr(0, separator);
+				auto value = term.substr(separator + 1);
+
+				Term *target;
+
+				if (key == "type")
+					target = &result.m_stType;
+				else if (key == "name")
+					target = &result.m_stName;
+				else if (key == "path")
+					target = &result.m_stPath;
+				else if (key == "device")
+					target = &result.m_stDevice;
+				else if (key == "state")
+				{
+					dcclite::DecoderStates state;
+
+					if (value == "active")
+						state = dcclite::DecoderStates::ACTIVE;
+					else if (value == "inactive")
+						state = dcclite::DecoderStates::INACTIVE;
+					else
+						throw std::invalid_argument(fmt::format("[ItemQuery::Parse] Invalid state {}, expected active or inactive", value));
+
+					SetFlag(result.m_kState, key, negated ? !state : state);
+
+					continue;
+				}
+				else
+					throw std::invalid_argument(fmt::format("[ItemQuery::Parse] Unknown term {}", key));
+
+				SetTerm(target->m_strPattern, key, value);
+				target->m_fNegated = negated;
+
+				continue;
+			}
+
+			if (term == "broken")
+				SetFlag(result.m_fBroken, term, !negated);
+			else if (term == "pending")
+				SetFlag(result.m_fPending, term, !negated);
+			else
+			{
+				Kinds kind;
+
+				if (term == "input")
+					kind = Kinds::INPUT;
+				else if (term == "output")
+					kind = Kinds::OUTPUT;
+				else if (term == "turnout")
+					kind = Kinds::TURNOUT;
+				else
+					throw std::invalid_argument(fmt::format("[ItemQuery::Parse] Unknown term {}", term));
+
+				if (result.m_kKind != Kinds::ANY)
+					throw std::invalid_argument("[ItemQuery::Parse] Only one of input, output or turnout can be used");
+
+				result.m_kKind = kind;
+				result.m_fKindNegated = negated;
+			}
+		}
+
+		if (empty)
+			throw std::invalid_argument("[ItemQuery::Parse] Query is empty");
+
+		return result;
+	}
+
+	bool ItemQuery::MatchesDecoder(const dcclite::IObject &item) const
+	{
+		auto decoder = dynamic_cast<const StateDecoder *>(&item);
+		if (!decoder)
+			return false;
+
+		if (m_kKind != Kinds::ANY)
+		{
+			bool isKind;
+
+			switch (m_kKind)
+			{
+				case Kinds::INPUT:
+					isKind = decoder->IsInputDecoder();
+					break;
+
+				case Kinds::OUTPUT:
+					isKind = decoder->IsOutputDecoder();
+					break;
+
+				default:
+					isKind = decoder->IsTurnoutDecoder();
+					break;
+			}
+
+			if (isKind == m_fKindNegated)
+				return false;
+		}
+
+		if (m_kState && (decoder->GetState() != *m_kState))
+			return false;
+
+		if (m_fBroken)
+		{
+			auto remoteDecoder = dynamic_cast<const RemoteDecoder *>(decoder);
+
+			if ((remoteDecoder && remoteDecoder->IsBroken()) != *m_fBroken)
+				return false;
+		}
+
+		if (m_fPending)
+		{
+			auto outputDecoder = decoder->IsOutputDecoder() ? static_cast<const OutputDecoder *>(decoder) : nullptr;
+
+			if ((outputDecoder && (outputDecoder->GetRequestedState() != outputDecoder->GetState())) != *m_fPending)
+				return false;
+		}
+
+		return !m_stDevice.IsSet() || m_stDevice.Matches(decoder->GetDeviceName().GetData());
+	}
+
+	bool ItemQuery::Matches(const dcclite::IObject &item) const
+	{
+		//cheap tests first, path is built on demand
+		if (m_stType.IsSet() && !m_stType.Matches(item.GetTypeName()))
+			return false;
+
+		if (m_stName.IsSet() && !m_stName.Matches(item.GetNameData()))
+			return false;
+
+		if (this->NeedsDecoder() && !this->MatchesDecoder(item))
+			return false;
+
+		return !m_stPath.IsSet() || m_stPath.Matches(item.GetPath().string());
+	}
+
+	bool ItemQuery::Run_r(const dcclite::IFolderObject &folder, const Visitor_t &visitor) const
+	{
+		bool keepGoing = true;
+
+		folder.ConstVisitChildren([this, &visitor, &keepGoing](const dcclite::IObject &item)
+			{
+				//shortcuts point to items already in the tree, following them would report duplicates
+				if (item.IsShortcut())
+					return true;
+
+				if (this->Matches(item) && !visitor(item))
+				{
+					keepGoing = false;
+
+					return false;
+				}
+
+				if (item.IsFolder())
+					keepGoing = this->Run_r(static_cast<const dcclite::IFolderObject &>(item), visitor);
+
+				return keepGoing;
+			}
+		);
+
+		return keepGoing;
+	}
+
+	void ItemQuery::Run(const dcclite::IFolderObject &folder, const Visitor_t &visitor) const
+	{
+		this->Run_r(folder, visitor);
+	}
+
+	void ItemQuery::Run(DccLiteService &service, const Visitor_t &visitor) const
+	{
+		//a single device, only look at its decoders
+		if (m_stDevice.IsSet() && !m_stDevice.m_fNegated && (m_stDevice.m_strPattern.find_first_of("*?") == std::string::npos))
+		{
+			//no name, no device
+			auto deviceName = RName::TryGetName(m_stDevice.m_strPattern);
+			if (!deviceName)
+				return;
+
+			auto device = service.TryFindDeviceByName(deviceName);
+			if (!device)
+				return;
+
+			device->VisitChildren([this, &visitor](dcclite::IObject &item)
+				{
+					auto decoder = item.IsShortcut() ? static_cast<dcclite::Shortcut &>(item).TryResolve() : &item;
+
+					return !decoder || !this->Matches(*decoder) || visitor(*decoder);
+				}
+			);
+
+			return;
+		}
+
+		auto runList = [this, &visitor](const auto &decoders)
+		{
+			for (auto decoder : decoders)
+			{
+				if (this->Matches(*decoder) && !visitor(*decoder))
+					break;
+			}
+		};
+
+		//cached lists, no need to walk the tree
+		if ((m_kKind == Kinds::INPUT) && !m_fKindNegated)
+			runList(service.FindAllInputDecoders());
+		else if ((m_kKind == Kinds::TURNOUT) && !m_fKindNegated)
+			runList(service.FindAllTurnoutDecoders());
+		else
+			this->Run_r(service, visitor);
+	}
+}
@@ -0,0 +1,115 @@
+// Copyright (C) 2019 - Bruno Sanches. See the COPYRIGHT
+// file at the top-level directory of this distribution.
+//
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+//
+// This Source Code Form is "Incompatible With Secondary Licenses", as
+// defined by the Mozilla Public License, v. 2.0.
+
+#pragma once
+
+#include <functional>
+#include <optional>
+#include <string>
+#include <string_view>
+
+#include <dcclite/IFolderObject.h>
+
+#include <dcclite_shared/SharedLibDefs.h>
+
+namespace dcclite::broker::exec::dcc
+{
+	class DccLiteService;
+
+	/**
+	*
+	* A small predicate language for finding objects without sending everything to the client, all terms must match:
+	*	- type=<glob>		-> object type name, ie "type=*Turnout*"
+	*	- name=<glob>		-> object name
+	*	- path=<glob>		-> full object path, ie "path=/DCCLite/decoders/yard_*"
+	*	- device=<name>		-> decoders from the given device
+	*	- state=<active|inactive>
+	*	- input, output, turnout	-> decoder kind
+	*	- broken, pending	-> decoder flags, pending means an output whose requested state was not confirmed by the device yet
+	*
+	* Any term can be negated with a "!" prefix, ie "!broken" or "!type=SignalDecoder"
+	*
+	* Globs accept * (any sequence) and ? (any char)
+	*
+	*/
+	class ItemQuery
+	{
+		public:
+			typedef std::function<bool(const dcclite::IObject &item)> Visitor_t;
+
+			/**
+			* throws std::invalid_argument if the query cannot be parsed
+			*/
+			static ItemQuery Parse(std::string_view query);
+
+			bool Matches(const dcclite::IObject &item) const;
+
+			/**
+			* Visits all objects below folder (shortcuts are not followed) that match, stops if visitor returns false
+			*/
+			void Run(const dcclite::IFolderObject &folder, const Visitor_t &visitor) const;
+
+			/**
+			* Same as above, but uses the service decoder lists and devices to avoid walking the whole service
+			*/
+			void Run(DccLiteService &service, const Visitor_t &visitor) const;
+
+		private:
+			enum class Kinds
+			{
+				ANY,
+				INPUT,
+				OUTPUT,
+				TURNOUT
+			};
+
+			struct Term
+			{
+				std::string m_strPattern;
+				bool		m_fNegated = false;
+
+				bool Matches(std::string_view text) const noexcept;
+
+				inline bool IsSet() const noexcept
+				{
+					return !m_strPattern.empty();
+				}
+			};
+
+			ItemQuery() = default;
+
+			bool MatchesDecoder(const dcclite::IObject &item) const;
+
+			bool Run_r(const dcclite::IFolderObject &folder, const Visitor_t &visitor) const;
+
+			inline bool NeedsDecoder() const noexcept
+			{
+				return m_stDevice.IsSet() || m_kState || m_fBroken || m_fPending || (m_kKind != Kinds::ANY);
+			}
+
+		private:
+			Term m_stType;
+			Term m_stName;
+			Term m_stPath;
+			Term m_stDevice;
+
+			std::optional<dcclite::DecoderStates>	m_kState;
+			std::optional<bool>						m_fBroken;
+			std::optional<bool>						m_fPending;
+
+			Kinds	m_kKind = Kinds::ANY;
+			bool	m_fKindNegated = false;
+	};
+
+	/**
+	* Matches text against a pattern with * and ? wildcards
+	*/
+	bool GlobMatch(std::string_view pattern, std::string_view text) noexcept;
+}
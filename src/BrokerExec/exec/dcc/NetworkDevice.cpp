@@ -13,6 +13,7 @@
 #include <magic_enum/magic_enum.hpp>
 
 #include <dcclite_shared/BitPack.h>
+#include <dcclite_shared/StatesCodec.h>
 
 #include <dcclite/FmtUtils.h>
 #include <dcclite/Guid.h>
@@ -173,19 +174,42 @@ namespace dcclite::broker::exec::dcc
 
 	NetworkDevice::ConfigState::ConfigState(NetworkDevice &self, const dcclite::Clock::TimePoint_t time):
 		State(self),
+		m_clWindow{ self.m_vecDecoders.size(), sys::NETWORK_DEVICE_CONFIG_RETRY_TIME, sys::NETWORK_DEVICE_CONFIG_MIN_RETRY_TIME, sys::NETWORK_DEVICE_CONFIG_MAX_RETRY_TIME },
 		m_clTimeoutThinker{"NetworkDevice::ConfigState::TimeoutThinker", THINKER_MF_LAMBDA(OnTimeout)},
 		m_clBenchmark{"NetworkDevice::ConfigState", self.GetNameData()}
 	{
-		this->m_vecAcks.resize(self.m_vecDecoders.size());
+		this->SendConfigStartPacket(time);
 
-		m_clTimeoutThinker.Schedule(time + sys::NETWORK_DEVICE_CONFIG_RETRY_TIME);
+		//only the first packets of the window go now, the others follow the acks
+		this->UpdateWindow(time);
+	}
 
-		this->SendConfigStartPacket(time);
+	void NetworkDevice::ConfigState::UpdateWindow(const dcclite::Clock::TimePoint_t time)
+	{
+		const auto nextTime = m_clWindow.Update(time, [this, time](const size_t index, const bool retransmission)
+			{
+				if (retransmission)
+				{
+					if (index == 0)
+					{
+						//when config 0 is not received, this could also means that CONFIG_START was not received by tge remote, so we send it again
+						this->SendConfigStartPacket(time);
+					}
+
+					dcclite::Log::Warn(
+						"[Device::{}] [{}::UpdateWindow] retrying config for device {} at {}",
+						m_rclSelf.GetName(),
+						this->GetName(),
+						m_rclSelf.m_vecDecoders[index]->GetName(),
+						index
+					);
+				}
 
-		for (size_t i = 0, sz = self.m_vecDecoders.size(); i < sz; ++i)
-		{
-			this->SendDecoderConfigPacket(i, time);
-		}
+				this->SendDecoderConfigPacket(index, time);
+			}
+		);
+
+		m_clTimeoutThinker.Schedule(nextTime);
 	}
 
 	void NetworkDevice::ConfigState::SendConfigStartPacket(const dcclite::Clock::TimePoint_t time) const
@@ -224,9 +248,19 @@ namespace dcclite::broker::exec::dcc
 		if (!m_rclSelf.CheckSession(remoteAddress))
 			return;
 
-		auto seq = packet.Read<uint8_t>();
+		uint8_t seq;
+		dcclite::ConfigAcksBitPack_t acks;
+
+		if (!dcclite::ConfigAckSchema_t::Read(packet, seq, acks))
+		{
+			dcclite::Log::Error("[Device::{}] [{}::OnPacket_ConfigAck] truncated packet, ignoring", m_rclSelf.GetName(), this->GetName());
+
+			return;
+		}
+
+		const bool wasComplete = m_clWindow.IsComplete();
 
-		if (seq >= m_vecAcks.size())
+		if (!m_clWindow.OnAck(seq, time))
 		{
 			dcclite::Log::Error("[Device::{}] [{}::OnPacket_ConfigAck] config out of sync, dropping connection", m_rclSelf.GetName(), this->GetName());
 
@@ -235,22 +269,36 @@ namespace dcclite::broker::exec::dcc
 			return;
 		}		
 
-		m_rclSelf.m_clTimeoutController.Enable(time);
-
-		//only increment seq count if m_vecAcks[seq] is not set yet, so we handle duplicate packets
-		m_uSeqCount += m_vecAcks[seq] == false;
-		m_vecAcks[seq] = true;
+		//the device also tells everything it has, this covers acks that were lost
+		m_clWindow.OnSelectiveAck(acks, time);
 
-		m_clTimeoutThinker.Schedule(time + sys::NETWORK_DEVICE_CONFIG_RETRY_TIME);
+		m_rclSelf.m_clTimeoutController.Enable(time);
 
 		dcclite::Log::Info("[Device::{}] [{}::OnPacket_ConfigAck] Config ACK {} - {}", m_rclSelf.GetName(), this->GetName(), seq, m_rclSelf.m_vecDecoders[seq]->GetName());
 
-		if (m_uSeqCount == m_vecAcks.size())
+		//duplicated ack after everything was done? Timeout will take care of config finished
+		if (wasComplete)
+			return;
+
+		if (m_clWindow.IsComplete())
 		{
-			dcclite::Log::Info("[Device::{}] [{}::OnPacket_ConfigAck] Config Finished, configured {} decoders", m_rclSelf.GetName(), this->GetName(), m_uSeqCount);
+			dcclite::Log::Info(
+				"[Device::{}] [{}::OnPacket_ConfigAck] Config Finished, configured {} decoders with {} packets", 
+				m_rclSelf.GetName(), 
+				this->GetName(), 
+				m_clWindow.GetNumAcked(),
+				m_clWindow.GetNumTransmissions()
+			);
+
+			m_clTimeoutThinker.Schedule(time + sys::NETWORK_DEVICE_CONFIG_RETRY_TIME);
 
 			this->SendConfigFinishedPacket(time);
+
+			return;
 		}
+
+		//window moved, send what is next
+		this->UpdateWindow(time);
 	}
 
 	void NetworkDevice::ConfigState::OnPacket_ConfigFinished(		
@@ -296,47 +344,20 @@ namespace dcclite::broker::exec::dcc
 
 	void NetworkDevice::ConfigState::OnTimeout(const dcclite::Clock::TimePoint_t time)
 	{		
-		//we havent received ack for some time, wake up the device (timeout keeps counting)
-		m_clTimeoutThinker.Schedule(time + sys::NETWORK_DEVICE_CONFIG_RETRY_TIME);
-
-		//go thought all the decoders and check what does not have an ACK
-		int pos = 0, packetCount = 0;
-		for (const bool &acked : m_vecAcks)
+		if (m_clWindow.IsComplete())
 		{
-			if (!acked)
-			{
-				if (pos == 0)
-				{
-					//when config 0 is not received, this could also means that CONFIG_START was not received by tge remote, so we send it again
-					this->SendConfigStartPacket(time);
-				}
-
-				dcclite::Log::Warn(
-					"[Device::{}] [{}::OnTimeout] retrying config for device {} at {}", 
-					m_rclSelf.GetName(), 
-					this->GetName(), 
-					m_rclSelf.m_vecDecoders[pos]->GetName(), 
-					pos
-				);
-
-				this->SendDecoderConfigPacket(pos, time);
-
-				++packetCount;
-
-				//too many packets? Wait a little bit
-				if (packetCount == 3)
-					break;
-			}
-
-			++pos;
-		}
+			//we havent received ack for some time, wake up the device (timeout keeps counting)
+			m_clTimeoutThinker.Schedule(time + sys::NETWORK_DEVICE_CONFIG_RETRY_TIME);
 
-		if (packetCount == 0)
-		{
 			//remote device already acked all decoders, but not acked the config finished, so, send it again
 			dcclite::Log::Warn("[Device::{}] [{}::Update] retrying config finished for remote device", m_rclSelf.GetName(), this->GetName());
 			this->SendConfigFinishedPacket(time);
+
+			return;
 		}
+
+		//paced sends or retransmissions, the window decides
+		this->UpdateWindow(time);
 	}
 
 	//
@@ -391,8 +412,12 @@ namespace dcclite::broker::exec::dcc
 		dcclite::StatesBitPack_t changedStates;
 		dcclite::StatesBitPack_t states;
 
-		packet.ReadBitPack(changedStates);
-		packet.ReadBitPack(states);
+		if (!m_rclSelf.ReadStates(packet, changedStates, states))
+		{
+			dcclite::Log::Error("[Device::{}] [SyncState::OnPacket] Invalid states on SYNC packet, ignoring", m_rclSelf.GetName());
+
+			return;
+		}
 
 		for (unsigned i = 0; i < changedStates.size(); ++i)
 		{
@@ -451,6 +476,9 @@ namespace dcclite::broker::exec::dcc
 	{		
 		m_clPingThinker.Schedule(time + sys::NETWORK_DEVICE_PING_TIMEOUT);
 
+		//new session, link may have changed
+		m_rclSelf.m_clRttEstimator.Reset();
+
 		//force it to send states ASAP
 		m_clSendStateDeltaThinker.Schedule({});
 
@@ -539,8 +567,7 @@ namespace dcclite::broker::exec::dcc
 		DevicePacket pkt{ dcclite::MsgTypes::STATE, m_rclSelf.m_guidSessionToken, m_rclSelf.m_guidConfigToken };
 
 		pkt.Write64(++m_uOutgoingStatePacketId);
-		pkt.Write(changedStates);
-		pkt.Write(states);
+		m_rclSelf.WriteStates(pkt, changedStates, states);
 
 		m_rclSelf.m_clNetService.SendPacket(m_rclSelf, pkt, time);
 
@@ -568,6 +595,11 @@ namespace dcclite::broker::exec::dcc
 			//m_rclSelf.PostponeTimeout(time);
 
 			//dcclite::Log::Debug("[{}::Device::OnPacket] pong", m_rclSelf.GetName());
+
+			//after a lost ping we cannot tell which ping this pong belongs to
+			if (m_fPendingPong && !m_fLostPingPacket)
+				m_rclSelf.m_clRttEstimator.AddSample(std::chrono::duration_cast<sys::RttEstimator::Duration_t>(time - m_tPingSentTime));
+
 			m_fPendingPong = false;
 			if (m_fLostPingPacket)
 			{
@@ -654,13 +686,17 @@ namespace dcclite::broker::exec::dcc
 		if (sequenceCount < m_uLastReceivedStatePacketId)
 			return;
 
-		m_uLastReceivedStatePacketId = sequenceCount;
-
 		dcclite::StatesBitPack_t changedStates;
 		dcclite::StatesBitPack_t states;
 
-		packet.ReadBitPack(changedStates);
-		packet.ReadBitPack(states);			
+		if (!m_rclSelf.ReadStates(packet, changedStates, states))
+		{
+			dcclite::Log::Error("[Device::{}] [{}::OnPacket] Invalid states on STATE packet, ignoring", m_rclSelf.GetName(), this->GetName());
+
+			return;
+		}
+
+		m_uLastReceivedStatePacketId = sequenceCount;
 
 		bool sensorStateRefresh = false;
 		
@@ -683,6 +719,17 @@ namespace dcclite::broker::exec::dcc
 			sensorStateRefresh = remoteDecoder->IsInputDecoder() || sensorStateRefresh;			
 		}		
 
+		//
+		//Device confirmed all our changes? Then this is the reply to the state packet we sent
+		if (m_tStateSentTime && !this->HasPendingStateChanges())
+		{
+			if (!m_fStateRetransmitted)
+				m_rclSelf.m_clRttEstimator.AddSample(std::chrono::duration_cast<sys::RttEstimator::Duration_t>(time - *m_tStateSentTime));
+
+			m_tStateSentTime.reset();
+			m_clSendStateDeltaThinker.Cancel();
+		}
+
 		if (sensorStateRefresh)
 		{
 			//
@@ -691,6 +738,19 @@ namespace dcclite::broker::exec::dcc
 		}		
 	}
 
+	bool NetworkDevice::OnlineState::HasPendingStateChanges() const noexcept
+	{
+		for (auto decoder : m_rclSelf.m_vecDecoders)
+		{
+			auto *remoteDecoder = static_cast<RemoteDecoder *>(decoder);
+
+			if (remoteDecoder && remoteDecoder->IsOutputDecoder() && static_cast<OutputDecoder *>(remoteDecoder)->GetPendingStateChange())
+				return true;
+		}
+
+		return false;
+	}
+
 	void NetworkDevice::OnlineState::OnPingThink(const dcclite::Clock::TimePoint_t time)
 	{
 		auto nextPing = sys::NETWORK_DEVICE_PING_TIMEOUT;
@@ -717,6 +777,7 @@ namespace dcclite::broker::exec::dcc
 		DevicePacket pkt{ dcclite::MsgTypes::MSG_PING, m_rclSelf.m_guidSessionToken, m_rclSelf.m_guidConfigToken };
 		m_rclSelf.m_clNetService.SendPacket(m_rclSelf, pkt, time);
 		m_fPendingPong = true;
+		m_tPingSentTime = time;
 	}
 
 	void NetworkDevice::OnlineState::OnChangeStateRequest(const Decoder &decoder)
@@ -730,17 +791,38 @@ namespace dcclite::broker::exec::dcc
 		if (!this->SendStateDelta(false, time, "OnStateDeltaThink"))
 		{
 			//no state sent? nothing else to do here
+			m_tStateSentTime.reset();
+
 			return;
 		}
 
+		auto &rttEstimator = m_rclSelf.m_clRttEstimator;
+
+		if (!m_tStateSentTime)
+		{
+			m_tStateSentTime = time;
+			m_fStateRetransmitted = false;
+		}
+		else
+		{
+			//still waiting for a reply, so this is a retransmission or new changes were added to the pending ones
+			m_fStateRetransmitted = true;
+
+			if (time >= m_tStateRetransmitTime)
+				rttEstimator.OnTimeout();
+		}
+
 		/*
 		* 
 		* State sent, so we schedule to send it again for covering packet lost cases
 		* 
 		* If  the state arrive on the other side, we will get a reply that will sync our state,
 		* and hopefully, the lastStateSent will be the same, so the send will fail and we will not schedule it again		
+		* 
+		* The timeout follows the link round trip time, so fast links recover quickly and slow ones are not flooded
 		*/
-		m_clSendStateDeltaThinker.Schedule(time + sys::NETWORK_DEVICE_STATE_TIMEOUT);
+		m_tStateRetransmitTime = time + rttEstimator.GetRetransmitTimeout();
+		m_clSendStateDeltaThinker.Schedule(m_tStateRetransmitTime);
 	}
 
 	//
@@ -767,6 +849,13 @@ namespace dcclite::broker::exec::dcc
 		stream.AddStringValue("remoteAddress", m_clRemoteAddress.GetIpString());
 	}
 
+	void NetworkDevice::SerializeLinkStats(dcclite::JsonOutputStream_t &stream) const
+	{
+		auto linkObj = stream.AddObject("link");
+
+		m_clRttEstimator.Serialize(linkObj);
+	}
+
 	void NetworkDevice::Serialize(dcclite::JsonOutputStream_t &stream) const
 	{
 		Device::Serialize(stream);
@@ -777,6 +866,7 @@ namespace dcclite::broker::exec::dcc
 
 		this->SerializeConnectionStatus(stream);
 		this->SerializeFreeRam(stream);
+		this->SerializeLinkStats(stream);
 
 		m_clPinManager.Serialize(stream);
 		m_clEventLog.Serialize(stream);
@@ -897,6 +987,30 @@ namespace dcclite::broker::exec::dcc
 		return true;
 	}
 
+	void NetworkDevice::WriteStates(dcclite::Packet &packet, const dcclite::StatesBitPack_t &changedStates, const dcclite::StatesBitPack_t &states) const noexcept
+	{
+		if (m_uProtocolVersion >= dcclite::PROTOCOL_VERSION_COMPACT_STATES)
+		{
+			dcclite::StatesCodec::Write(packet, changedStates, states);
+
+			return;
+		}
+
+		packet.Write(changedStates);
+		packet.Write(states);
+	}
+
+	bool NetworkDevice::ReadStates(dcclite::Packet &packet, dcclite::StatesBitPack_t &changedStates, dcclite::StatesBitPack_t &states) const noexcept
+	{
+		if (m_uProtocolVersion >= dcclite::PROTOCOL_VERSION_COMPACT_STATES)
+			return dcclite::StatesCodec::Read(packet, changedStates, states);
+
+		packet.ReadBitPack(changedStates);
+		packet.ReadBitPack(states);
+
+		return true;
+	}
+
 	bool NetworkDevice::CheckSession(dcclite::NetworkAddress remoteAddress)
 	{
 		if (m_kStatus == Status::OFFLINE)
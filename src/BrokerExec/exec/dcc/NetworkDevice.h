@@ -12,6 +12,7 @@
 
 #include <functional>
 #include <list>
+#include <optional>
 #include <string>
 #include <variant>
 
@@ -22,6 +23,7 @@
 #include <dcclite/Benchmark.h>
 #include <dcclite/Socket.h>
 
+#include "ConfigUploadWindow.h"
 #include "IDccLiteService.h"
 #include "Device.h"
 #include "IDevice.h"
@@ -29,6 +31,7 @@
 #include "NetworkDeviceTasks.h"
 #include "PinManager.h"
 
+#include "sys/RttEstimator.h"
 #include "sys/Thinker.h"
 #include "sys/Timeouts.h"
 
@@ -285,6 +288,12 @@ namespace dcclite::broker::exec::dcc
 			
 			[[nodiscard]] bool CheckSession(const dcclite::NetworkAddress remoteAddress);
 
+			/**
+			* STATE and SYNC decoder states, uses the compact encoding if the device supports it
+			*/
+			void WriteStates(dcclite::Packet &packet, const dcclite::StatesBitPack_t &changedStates, const dcclite::StatesBitPack_t &states) const noexcept;
+			[[nodiscard]] bool ReadStates(dcclite::Packet &packet, dcclite::StatesBitPack_t &changedStates, dcclite::StatesBitPack_t &states) const noexcept;
+
 			/**
 			* This methods sets the state as offline, such as in cases when a connection is dropped
 			* 
@@ -329,6 +338,7 @@ namespace dcclite::broker::exec::dcc
 
 			void SerializeFreeRam(dcclite::JsonOutputStream_t &stream) const;
 			void SerializeConnectionStatus(dcclite::JsonOutputStream_t &stream) const;
+			void SerializeLinkStats(dcclite::JsonOutputStream_t &stream) const;
 
 		private:						
 			PinManager				m_clPinManager;		
@@ -373,10 +383,7 @@ namespace dcclite::broker::exec::dcc
 
 			struct ConfigState: State
 			{
-				std::vector<bool>	m_vecAcks;				
-
-				uint8_t				m_uSeqCount = { 0 };
-				bool				m_fAckReceived = { false };
+				ConfigUploadWindow	m_clWindow;
 
 				sys::Thinker		m_clTimeoutThinker;
 
@@ -402,6 +409,8 @@ namespace dcclite::broker::exec::dcc
 
 					void OnTimeout(const dcclite::Clock::TimePoint_t time);
 
+					void UpdateWindow(const dcclite::Clock::TimePoint_t time);
+
 					void OnPacket_ConfigAck(						
 						dcclite::Packet &packet,
 						const dcclite::Clock::TimePoint_t time,
@@ -463,6 +472,8 @@ namespace dcclite::broker::exec::dcc
 					void OnPingThink(const dcclite::Clock::TimePoint_t time);
 					void OnStateDeltaThink(const dcclite::Clock::TimePoint_t time);									
 
+					bool HasPendingStateChanges() const noexcept;
+
 					uint64_t			m_uLastReceivedStatePacketId = 0;
 
 					uint64_t			m_uOutgoingStatePacketId = 0;
@@ -472,6 +483,17 @@ namespace dcclite::broker::exec::dcc
 
 					BenchmarkLogger		m_clBenchmark;
 
+					//When the first copy of the pending state changes was sent, used for RTT samples
+					std::optional<dcclite::Clock::TimePoint_t> m_tStateSentTime;
+
+					//When the retransmission timer for the pending state changes expires
+					dcclite::Clock::TimePoint_t m_tStateRetransmitTime;
+
+					dcclite::Clock::TimePoint_t m_tPingSentTime;
+
+					//pending changes were sent more than once, so a reply cannot be used as a sample (Karn's algorithm)
+					bool				m_fStateRetransmitted = false;
+
 					bool				m_fPendingPong = false;
 					bool				m_fLostPingPacket = false;
 			};
@@ -503,6 +525,8 @@ namespace dcclite::broker::exec::dcc
 
 			TimeoutController	m_clTimeoutController;
 
+			sys::RttEstimator	m_clRttEstimator{ sys::NETWORK_DEVICE_STATE_TIMEOUT, sys::NETWORK_DEVICE_STATE_MIN_TIMEOUT, sys::NETWORK_DEVICE_STATE_MAX_TIMEOUT };
+
 			std::uint16_t		m_uRemoteFreeRam = UINT16_MAX;
 			std::uint16_t		m_uProtocolVersion = 0;
 			
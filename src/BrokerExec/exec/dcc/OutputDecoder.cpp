@@ -35,29 +35,77 @@ namespace dcclite::broker::exec::dcc
 		this->SyncRemoteState(this->IgnoreSavedState() && this->ActivateOnPowerUp() ? dcclite::DecoderStates::ACTIVE : dcclite::DecoderStates::INACTIVE);				
 	}
 
-	bool OutputDecoder::SetState(dcclite::DecoderStates newState, const char *requester)
+	OutputDecoder::~OutputDecoder()
+	{
+		m_sigDestroyed(*this);
+	}
+
+	bool OutputDecoder::UpdateRequestedState(dcclite::DecoderStates newState, const char *requester)
 	{
-		if (m_kRequestedState != newState)
+		if (m_kRequestedState == newState)
+			return false;
+
+		if (m_rnLockOwner && ((requester == nullptr) || (m_rnLockOwner.GetData() != requester)))
 		{
-			dcclite::Log::Info("[OutputDecoder::{}] [SetState] requested change from {} to {} by {}",
+			dcclite::Log::Warn("[OutputDecoder::{}] [SetState] change to {} by {} refused, locked by {}",
 				this->GetName(),
-				dcclite::DecoderStateName(m_kRequestedState),
 				dcclite::DecoderStateName(newState),
-				requester
+				requester ? requester : "null",
+				m_rnLockOwner
 			);
 
-			m_kRequestedState = newState;
+			return false;
+		}
+
+		dcclite::Log::Info("[OutputDecoder::{}] [SetState] requested change from {} to {} by {}",
+			this->GetName(),
+			dcclite::DecoderStateName(m_kRequestedState),
+			dcclite::DecoderStateName(newState),
+			requester
+		);
+
+		m_kRequestedState = newState;
+
+		//Allow manager to know it and allow it to propagate changes
+		m_rclManager.Decoder_OnStateChanged(*this);
+
+		return true;
+	}
+
+	bool OutputDecoder::SetState(dcclite::DecoderStates newState, const char *requester)
+	{
+		if (!this->UpdateRequestedState(newState, requester))
+			return false;
 
-			//Allow manager to know it and allow it to propagate changes
-			m_rclManager.Decoder_OnStateChanged(*this);
+		//device will take care of sending this down the network if necessary
+		m_rclDevice.Decoder_OnChangeStateRequest(*this);
 
-			//device will take care of sending this down the network if necessary
-			m_rclDevice.Decoder_OnChangeStateRequest(*this);
+		return true;
+	}
 
+	bool OutputDecoder::Lock(RName owner)
+	{
+		if (m_rnLockOwner == owner)
 			return true;
-		}
 
-		return false;
+		if (m_rnLockOwner)
+			return false;
+
+		m_rnLockOwner = owner;
+
+		m_rclManager.Decoder_OnStateChanged(*this);
+
+		return true;
+	}
+
+	void OutputDecoder::Unlock(RName owner)
+	{
+		if (m_rnLockOwner != owner)
+			return;
+
+		m_rnLockOwner = RName{};
+
+		m_rclManager.Decoder_OnStateChanged(*this);
 	}
 
 	void OutputDecoder::Serialize(dcclite::JsonOutputStream_t& stream) const
@@ -69,5 +117,8 @@ namespace dcclite::broker::exec::dcc
 		stream.AddBool("invertedOperation", m_fInvertedOperation);
 		stream.AddBool("ignoreSaveState", m_fIgnoreSavedState);
 		stream.AddBool("activateOnPowerUp", m_fActivateOnPowerUp);
+
+		if (m_rnLockOwner)
+			stream.AddStringValue("lockOwner", m_rnLockOwner.GetData());
 	}
 }
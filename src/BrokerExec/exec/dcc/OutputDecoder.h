@@ -30,6 +30,8 @@ namespace dcclite::broker::exec::dcc
 				const rapidjson::Value &params
 			);
 
+			~OutputDecoder() override;
+
 			dcclite::DecoderTypes GetType() const noexcept override
 			{
 				return dcclite::DecoderTypes::DEC_OUTPUT;
@@ -89,6 +91,41 @@ namespace dcclite::broker::exec::dcc
 				return m_fActivateOnPowerUp;
 			}
 
+			/**
+			* While locked only the owner can change the requested state, used by the dispatcher interlocking to keep the
+			* turnouts of a set route in place
+			* 
+			* Returns false if already locked by someone else
+			*/
+			bool Lock(RName owner);
+			void Unlock(RName owner);
+
+			inline bool IsLocked() const noexcept
+			{
+				return static_cast<bool>(m_rnLockOwner);
+			}
+
+			inline RName GetLockOwner() const noexcept
+			{
+				return m_rnLockOwner;
+			}
+
+			/**
+			* True if the output is configured to flash, the device blinks it if supported
+			*/
+			virtual bool HasFlashOption() const noexcept
+			{
+				return false;
+			}
+
+			/**
+			* True if the device flashes the output while it is active, so the broker does not need to toggle it
+			*/
+			virtual bool FlashOnDevice() const noexcept
+			{
+				return false;
+			}
+
 			//
 			//IObject
 			//
@@ -99,9 +136,24 @@ namespace dcclite::broker::exec::dcc
 				return "OutputDecoder";
 			}				
 
+			/**
+			* Emitted when the decoder is going away (like a device reload), so anyone keeping a pointer to it (signals) can drop it
+			*/
+			sigslot::signal<OutputDecoder &> m_sigDestroyed;
+
+		private:
+			/**
+			* Updates the requested state without telling the device, returns true if the state changed
+			*/
+			bool UpdateRequestedState(const dcclite::DecoderStates newState, const char *requester);
+
+			friend class OutputDecoderBatch;
+
 		private:				
 			dcclite::DecoderStates m_kRequestedState = dcclite::DecoderStates::INACTIVE;
 
+			RName m_rnLockOwner;
+
 			bool m_fInvertedOperation = false;
 			bool m_fIgnoreSavedState = false;
 			bool m_fActivateOnPowerUp = false;
@@ -0,0 +1,66 @@
+// Copyright (C) 2019 - Bruno Sanches. See the COPYRIGHT
+// file at the top-level directory of this distribution.
+// 
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+// 
+// This Source Code Form is "Incompatible With Secondary Licenses", as
+// defined by the Mozilla Public License, v. 2.0.
+
+#include "OutputDecoderBatch.h"
+
+#include <algorithm>
+
+#include "IDevice.h"
+#include "OutputDecoder.h"
+
+namespace dcclite::broker::exec::dcc
+{
+	void OutputDecoderBatch::Add(OutputDecoder &decoder, const dcclite::DecoderStates state)
+	{
+		m_vecItems.push_back(Item{ &decoder, state });
+	}
+
+	unsigned OutputDecoderBatch::Apply(const char *requester)
+	{
+		//stable, so if a decoder shows up more than once, the last state wins
+		std::stable_sort(m_vecItems.begin(), m_vecItems.end(), [](const Item &lhs, const Item &rhs)
+			{
+				return &lhs.m_pclDecoder->GetDevice() < &rhs.m_pclDecoder->GetDevice();
+			}
+		);
+
+		unsigned numChanges = 0;
+
+		for (auto it = m_vecItems.begin(), end = m_vecItems.end(); it != end;)
+		{
+			auto &device = it->m_pclDecoder->GetDevice();
+
+			//network devices look at all decoders when sending a state packet, so a single notification is enough
+			const bool notifyOnce = device.TryGetINetworkDevice() != nullptr;
+
+			OutputDecoder *lastChanged = nullptr;
+
+			for (; (it != end) && (&it->m_pclDecoder->GetDevice() == &device); ++it)
+			{
+				if (!it->m_pclDecoder->UpdateRequestedState(it->m_kState, requester))
+					continue;
+
+				++numChanges;
+
+				if (notifyOnce)
+					lastChanged = it->m_pclDecoder;
+				else
+					device.Decoder_OnChangeStateRequest(*it->m_pclDecoder);
+			}
+
+			if (lastChanged)
+				device.Decoder_OnChangeStateRequest(*lastChanged);
+		}
+
+		m_vecItems.clear();
+
+		return numChanges;
+	}
+}
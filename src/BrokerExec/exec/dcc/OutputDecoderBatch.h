@@ -0,0 +1,58 @@
+// Copyright (C) 2019 - Bruno Sanches. See the COPYRIGHT
+// file at the top-level directory of this distribution.
+// 
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+// 
+// This Source Code Form is "Incompatible With Secondary Licenses", as
+// defined by the Mozilla Public License, v. 2.0.
+
+#pragma once
+
+#include <vector>
+
+#include <dcclite_shared/SharedLibDefs.h>
+
+namespace dcclite::broker::exec::dcc
+{
+	class OutputDecoder;
+
+	/**
+	* 
+	* Collects state changes for many output decoders and applies them grouped by device, so each device is told
+	* only once about the changes and can send all of them on a single state packet
+	* 
+	*/
+	class OutputDecoderBatch
+	{
+		public:
+			void Add(OutputDecoder &decoder, const dcclite::DecoderStates state);
+
+			/**
+			* Applies all the changes and clears the batch
+			* 
+			* Returns how many decoders changed state
+			*/
+			unsigned Apply(const char *requester);
+
+			inline bool IsEmpty() const noexcept
+			{
+				return m_vecItems.empty();
+			}
+
+			inline size_t GetSize() const noexcept
+			{
+				return m_vecItems.size();
+			}
+
+		private:
+			struct Item
+			{
+				OutputDecoder			*m_pclDecoder;
+				dcclite::DecoderStates	m_kState;
+			};
+
+			std::vector<Item> m_vecItems;
+	};
+}
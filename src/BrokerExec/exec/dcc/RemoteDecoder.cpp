@@ -27,6 +27,11 @@ namespace dcclite::broker::exec::dcc
 		m_fBroken = dcclite::json::TryGetDefaultBool(params, "broken", false);		
 	}
 
+	RemoteDecoder::~RemoteDecoder()
+	{
+		m_sigRemoteDestroyed(*this);
+	}
+
 	void RemoteDecoder::WriteConfig(dcclite::Packet &packet) const
 	{
 		packet.Write8(static_cast<std::uint8_t>(this->GetType()));
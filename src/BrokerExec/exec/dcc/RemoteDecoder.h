@@ -37,7 +37,9 @@ namespace dcclite::broker::exec::dcc
 				IDccLite_DecoderServices &owner,
 				IDevice_DecoderServices &dev,
 				const rapidjson::Value &params
-			);		
+			);
+
+			~RemoteDecoder() override;
 				
 
 			bool SyncRemoteState(dcclite::DecoderStates state);
@@ -58,6 +60,11 @@ namespace dcclite::broker::exec::dcc
 
 			sigslot::signal<RemoteDecoder &> m_sigRemoteStateSync;
 
+			/**
+			* Emitted when the decoder is going away (like a device reload), so anyone waiting for it (script tasks) can give up
+			*/
+			sigslot::signal<RemoteDecoder &> m_sigRemoteDestroyed;
+
 		protected:
 			virtual dcclite::DecoderTypes GetType() const noexcept = 0;
 
@@ -10,6 +10,9 @@
 
 #include "SignalDecoder.h"
 
+#include <algorithm>
+#include <bit>
+
 #include <dcclite/FmtUtils.h>
 #include <dcclite/Log.h>
 
@@ -50,6 +53,20 @@ namespace dcclite::broker::exec::dcc
 			m_mapHeads.insert(std::make_pair(headElement.name.GetString(), headElement.value.GetString()));
 		}
 
+		//many heads may use the same decoder
+		for (auto &headIt : m_mapHeads)
+		{
+			if (std::find(m_vecHeadsNames.begin(), m_vecHeadsNames.end(), headIt.second) == m_vecHeadsNames.end())
+				m_vecHeadsNames.push_back(headIt.second);
+		}
+
+		if (m_vecHeadsNames.size() > MAX_HEADS)
+		{
+			throw std::invalid_argument(fmt::format("[SignalDecoder::{}] [SignalDecoder] Error: too many heads, max is {}", this->GetName(), MAX_HEADS));
+		}
+
+		m_vecHeads.resize(m_vecHeadsNames.size(), nullptr);
+
 		auto aspectsData = params.FindMember("aspects");
 		if (aspectsData == params.MemberEnd())
 		{
@@ -146,6 +163,26 @@ namespace dcclite::broker::exec::dcc
 			return b.m_kAspect < a.m_kAspect;
 		});
 
+		auto makeMask = [this](const std::vector<RName> &heads)
+		{
+			HeadsMask_t mask = 0;
+
+			for (auto head : heads)
+			{
+				const auto index = std::find(m_vecHeadsNames.begin(), m_vecHeadsNames.end(), head) - m_vecHeadsNames.begin();
+
+				mask |= HeadsMask_t{ 1 } << index;
+			}
+
+			return mask;
+		};
+
+		for (auto &aspect : m_vecAspects)
+		{
+			aspect.m_uOnHeads = makeMask(aspect.m_vecOnHeads);
+			aspect.m_uOffHeads = makeMask(aspect.m_vecOffHeads);
+		}
+
 		//start with most restrictive aspect, expected to be Stop
 		const auto aspectIndex = static_cast<unsigned>(m_vecAspects.size() - 1);
 		this->ApplyAspect(m_vecAspects[aspectIndex].m_kAspect, aspectIndex);		
@@ -158,7 +195,7 @@ namespace dcclite::broker::exec::dcc
 
 		stream.AddStringValue("requestedAspectName", dcclite::ConvertAspectToName(m_eCurrentAspect));
 		stream.AddStringValue("currentAspectName", dcclite::ConvertAspectToName(m_vecAspects[m_uCurrentAspectIndex].m_kAspect));
-		stream.AddStringValue("aspectRequester", m_strAspectRequester);
+		stream.AddStringValue("aspectRequester", m_rnAspectRequester ? m_rnAspectRequester.GetData() : std::string_view{});
 		stream.AddStringValue("aspectReason", m_strAspectReason);
 
 		auto aspectsData = stream.AddArray("aspects");
@@ -167,14 +204,83 @@ namespace dcclite::broker::exec::dcc
 			aspectsData.AddString(dcclite::ConvertAspectToName(item.m_kAspect));
 	}
 
-	void SignalDecoder::ForEachHead(const std::vector<RName> &heads, const dcclite::SignalAspects aspect, std::function<bool(OutputDecoder &)> proc) const
+	void SignalDecoder::InitAfterDeviceLoad()
+	{
+		Decoder::InitAfterDeviceLoad();
+
+		//heads on devices not loaded yet are looked up again on first use
+		this->ResolveHeads();
+
+		//the device blinks a flash head whenever it is on, so a steady aspect would blink too
+		//checked by the option, as the device may not be connected yet or be replaced by a newer one
+		for (const auto &aspect : m_vecAspects)
+		{
+			if (aspect.m_Flash)
+				continue;
+
+			for (auto heads = aspect.m_uOnHeads; heads; heads &= heads - 1)
+			{
+				const auto index = std::countr_zero(heads);
+
+				if (m_vecHeads[index] && m_vecHeads[index]->HasFlashOption())
+				{
+					throw std::invalid_argument(fmt::format(
+						"[SignalDecoder::{}] [InitAfterDeviceLoad] Error: head {} flashes on the device, but is used by steady aspect {}", 
+						this->GetName(), 
+						m_vecHeadsNames[index], 
+						dcclite::ConvertAspectToName(aspect.m_kAspect)
+					));
+				}
+			}
+		}
+	}
+
+	bool SignalDecoder::ResolveHeads()
+	{
+		m_vecHeadsConnections.clear();
+		m_fHeadsResolved = true;
+
+		for (size_t i = 0, len = m_vecHeadsNames.size(); i < len; ++i)
+		{
+			auto *dec = dynamic_cast<OutputDecoder *>(m_rclManager.TryFindDecoder(m_vecHeadsNames[i]));
+
+			m_vecHeads[i] = dec;
+
+			if (dec == nullptr)
+			{
+				m_fHeadsResolved = false;
+
+				continue;
+			}
+
+			m_vecHeadsConnections.emplace_back(dec->m_sigDestroyed.connect(&SignalDecoder::OnHeadDestroyed, this));
+		}
+
+		return m_fHeadsResolved;
+	}
+
+	void SignalDecoder::OnHeadDestroyed(OutputDecoder &head)
+	{
+		//we are inside the head signal, so connections are only dropped on the next lookup
+		std::replace(m_vecHeads.begin(), m_vecHeads.end(), &head, static_cast<OutputDecoder *>(nullptr));
+
+		m_fHeadsResolved = false;
+	}
+
+	template <typename Proc>
+	void SignalDecoder::ForEachHead(HeadsMask_t heads, Proc proc)
 	{
-		for (const auto &head : heads)
-		{			
-			auto *dec = dynamic_cast<OutputDecoder *>(m_rclManager.TryFindDecoder(head));
+		if (!m_fHeadsResolved)
+			this->ResolveHeads();
+
+		for (; heads; heads &= heads - 1)
+		{
+			const auto index = std::countr_zero(heads);
+
+			auto *dec = m_vecHeads[index];
 			if (dec == nullptr)
 			{
-				dcclite::Log::Error("[SignalDecoder::{}] [SetAspect] Head {} for aspect {} not found or is not an output decoder.", this->GetName(), head, dcclite::ConvertAspectToName(aspect));
+				dcclite::Log::Error("[SignalDecoder::{}] [SetAspect] Head {} for aspect {} not found or is not an output decoder.", this->GetName(), m_vecHeadsNames[index], dcclite::ConvertAspectToName(m_eCurrentAspect));
 				continue;
 			}
 
@@ -183,15 +289,15 @@ namespace dcclite::broker::exec::dcc
 		}
 	}
 
-	void SignalDecoder::SetAspect(const dcclite::SignalAspects aspect, std::string requester, std::string reason)
+	void SignalDecoder::SetAspect(const dcclite::SignalAspects aspect, RName requester, std::string_view reason)
 	{
 		bool changed = false;
 
 		//
 		//we track those strings here because it is helpful for debbuging the CTC actions
-		if (m_strAspectRequester != requester)
+		if (m_rnAspectRequester != requester)
 		{
-			m_strAspectRequester = requester;
+			m_rnAspectRequester = requester;
 			changed = true;
 		}
 
@@ -285,7 +391,7 @@ namespace dcclite::broker::exec::dcc
 
 	void SignalDecoder::State_WaitTurnOff::Init()
 	{
-		m_rclOwner.ForEachHead(m_rclOwner.m_vecAspects[m_rclOwner.m_uCurrentAspectIndex].m_vecOffHeads, m_rclOwner.m_eCurrentAspect, [this](OutputDecoder &dec)
+		m_rclOwner.ForEachHead(m_rclOwner.m_vecAspects[m_rclOwner.m_uCurrentAspectIndex].m_uOffHeads, [this](OutputDecoder &dec)
 			{
 				if (dec.SetState(dcclite::DecoderStates::INACTIVE, m_rclOwner.GetName().GetData().data()))
 				{
@@ -349,15 +455,21 @@ namespace dcclite::broker::exec::dcc
 
 	void SignalDecoder::State_WaitTurnOff::GotoNextState()
 	{
-		m_rclOwner.ForEachHead(m_rclOwner.m_vecAspects[m_rclOwner.m_uCurrentAspectIndex].m_vecOnHeads, m_rclOwner.m_eCurrentAspect, [this](OutputDecoder &dec)
+		//heads that the device cannot flash by itself
+		unsigned numBrokerFlashHeads = 0;
+
+		m_rclOwner.ForEachHead(m_rclOwner.m_vecAspects[m_rclOwner.m_uCurrentAspectIndex].m_uOnHeads, [this, &numBrokerFlashHeads](OutputDecoder &dec)
 			{
 				dec.Activate(m_rclOwner.GetName().GetData().data());
 
+				numBrokerFlashHeads += !dec.FlashOnDevice();
+
 				return true;
 			}
 		);
 
-		if (m_rclOwner.m_vecAspects[m_rclOwner.m_uCurrentAspectIndex].m_Flash)
+		//if all heads flash on the device, nothing else to do, broker only sees aspect changes
+		if (m_rclOwner.m_vecAspects[m_rclOwner.m_uCurrentAspectIndex].m_Flash && numBrokerFlashHeads)
 		{
 			m_rclOwner.m_vState.emplace<State_Flash>(m_rclOwner, dcclite::Clock::DefaultClock_t::now());
 		}
@@ -381,8 +493,17 @@ namespace dcclite::broker::exec::dcc
 
 		const auto state = m_fOn ? dcclite::DecoderStates::ACTIVE : dcclite::DecoderStates::INACTIVE;
 
-		m_rclOwner.ForEachHead(m_rclOwner.m_vecAspects[m_rclOwner.m_uCurrentAspectIndex].m_vecOnHeads, m_rclOwner.m_eCurrentAspect, [state, this](OutputDecoder &dec)
+		m_rclOwner.ForEachHead(m_rclOwner.m_vecAspects[m_rclOwner.m_uCurrentAspectIndex].m_uOnHeads, [state, this](OutputDecoder &dec)
 			{
+				//device is flashing it, just keep it active (it may have connected after the aspect was set)
+				if (dec.FlashOnDevice())
+				{
+					if (dec.GetRequestedState() != dcclite::DecoderStates::ACTIVE)
+						dec.Activate(m_rclOwner.GetName().GetData().data());
+
+					return true;
+				}
+
 				dec.SetState(state, m_rclOwner.GetName().GetData().data());
 
 				return true;
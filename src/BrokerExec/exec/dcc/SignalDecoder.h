@@ -12,7 +12,7 @@
 
 #include "Decoder.h"
 
-#include <functional>
+#include <cstdint>
 #include <list>
 #include <map>
 #include <variant>
@@ -49,6 +49,15 @@ namespace dcclite::broker::exec::dcc
 			off: list of hedas to turn off when this aspect is active
 
 		Only one list is required. If just one list is specified, the other list is automatically filled with all other heads	
+
+	Heads decoders are looked up once (after the device loads or on first use) and each aspect keeps a mask of the heads to turn
+	on and off, so aspect changes do not search for decoders. If a head decoder is destroyed, heads are looked up again on next use.
+
+	Flashing aspects toggle their heads from the broker, except heads using an output decoder with the "flash" option on a device
+	with protocol version 15 or newer (PROTOCOL_VERSION_DEVICE_FLASH), those are blinked by their device. As the device blinks the
+	output whenever it is on, those heads can only be turned on by flashing aspects (checked on InitAfterDeviceLoad). Device and
+	broker flashing are not synchronized, so an aspect mixing both kinds of heads blinks them out of phase, use the same kind for
+	all heads of an aspect.
 	*/
 	class SignalDecoder : public Decoder
 	{
@@ -73,13 +82,15 @@ namespace dcclite::broker::exec::dcc
 
 			void Serialize(dcclite::JsonOutputStream_t &stream) const override;
 
+			void InitAfterDeviceLoad() override;
+
 			//
 			//
 			//
 			//
 			//
 
-			void SetAspect(const dcclite::SignalAspects aspect, std::string requester, std::string reason);
+			void SetAspect(const dcclite::SignalAspects aspect, RName requester, std::string_view reason);
 			inline dcclite::SignalAspects GetAspect() const
 			{
 				return m_eCurrentAspect;
@@ -88,7 +99,16 @@ namespace dcclite::broker::exec::dcc
 			sigslot::signal<SignalDecoder &> m_sigAspectChanged;
 
 		private:
-			void ForEachHead(const std::vector<RName> &heads, const dcclite::SignalAspects aspect, std::function<bool(OutputDecoder &)> proc) const;
+			//bit n is m_vecHeadsNames[n]
+			typedef uint64_t HeadsMask_t;
+
+			static constexpr size_t MAX_HEADS = sizeof(HeadsMask_t) * 8;
+
+			template <typename Proc>
+			void ForEachHead(HeadsMask_t heads, Proc proc);
+
+			bool ResolveHeads();
+			void OnHeadDestroyed(OutputDecoder &head);
 
 			void ApplyAspect(const dcclite::SignalAspects aspect, const unsigned aspectIndex);
 
@@ -100,6 +120,9 @@ namespace dcclite::broker::exec::dcc
 				std::vector<RName> m_vecOnHeads;
 				std::vector<RName> m_vecOffHeads;
 
+				HeadsMask_t m_uOnHeads = 0;
+				HeadsMask_t m_uOffHeads = 0;
+
 				bool m_Flash = false;
 			};
 
@@ -157,7 +180,7 @@ namespace dcclite::broker::exec::dcc
 			unsigned				m_uCurrentAspectIndex;
 
 			std::string				m_strAspectReason;
-			std::string				m_strAspectRequester;
+			RName					m_rnAspectRequester;
 
 			std::variant<std::monostate, State_Flash, State_WaitTurnOff> m_vState;			
 
@@ -166,6 +189,15 @@ namespace dcclite::broker::exec::dcc
 
 			//User defined aspects
 			std::vector<Aspect> m_vecAspects;
+
+			//Heads decoders names, without duplicates, the aspects masks index this
+			std::vector<RName> m_vecHeadsNames;
+
+			//Heads decoders, same order as m_vecHeadsNames, null if not found
+			std::vector<OutputDecoder *> m_vecHeads;
+			std::vector<sigslot::scoped_connection> m_vecHeadsConnections;
+
+			bool m_fHeadsResolved = false;
 	};
 
 }
\ No newline at end of file
@@ -10,6 +10,8 @@
 
 #include "SimpleOutputDecoder.h"
 
+#include <dcclite/JsonUtils.h>
+
 #include <dcclite_shared/Packet.h>
 
 #include "IDevice.h"
@@ -27,6 +29,8 @@ namespace dcclite::broker::exec::dcc
 		OutputDecoder(address, name, owner, dev, params),
 		m_clPin(params["pin"].GetInt())
 	{
+		m_fFlash = json::TryGetDefaultBool(params, "flash", false);
+
 		m_rclDevice.TryGetINetworkDevice()->Decoder_RegisterPin(*this, m_clPin, "pin");
 	}
 
@@ -42,12 +46,18 @@ namespace dcclite::broker::exec::dcc
 			(this->ActivateOnPowerUp() ? dcclite::OUTD_ACTIVATE_ON_POWER_UP : 0);
 	}
 
+	bool SimpleOutputDecoder::FlashOnDevice() const noexcept
+	{
+		//older devices do not know OUTD_FLASH, so the broker keeps flashing the output for them
+		return m_fFlash && (m_rclDevice.TryGetINetworkDevice()->GetProtocolVersion() >= dcclite::PROTOCOL_VERSION_DEVICE_FLASH);
+	}
 
 	void SimpleOutputDecoder::WriteConfig(dcclite::Packet &packet) const
 	{
 		OutputDecoder::WriteConfig(packet);
 
 		packet.Write8(m_clPin.Raw());
-		packet.Write8(this->GetDccppFlags());
+		//flash is not a DCC++ flag, so it only goes to our devices that support it
+		packet.Write8(this->GetDccppFlags() | (this->FlashOnDevice() ? dcclite::OutputDecoderFlags::OUTD_FLASH : 0));
 	}
 }
\ No newline at end of file
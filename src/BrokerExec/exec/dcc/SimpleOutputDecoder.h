@@ -44,6 +44,13 @@ namespace dcclite::broker::exec::dcc
 			}
 
 			uint8_t GetDccppFlags() const noexcept;
+
+			bool HasFlashOption() const noexcept override
+			{
+				return m_fFlash;
+			}
+
+			bool FlashOnDevice() const noexcept override;
 		
 			//
 			//IObject
@@ -60,10 +67,13 @@ namespace dcclite::broker::exec::dcc
 				OutputDecoder::Serialize(stream);
 
 				stream.AddIntValue ("pin", m_clPin.Raw());				
+				stream.AddBool("flash", m_fFlash);
 			}
 
 		private:
 			dcclite::BasicPin m_clPin;			
+
+			bool m_fFlash = false;
 	};
 
 }
\ No newline at end of file
@@ -11,6 +11,8 @@
 
 #include "DispatcherService.h"
 #include "DispatcherService_detail.h"
+#include "Interlocking.h"
+#include "Section.h"
 
 #include <stdexcept>
 #include <memory>
@@ -136,17 +138,37 @@ namespace dcclite::broker::shell::dispatcher
 			void Panic(sol::table src, const char *reason);
 
 			exec::dcc::VirtualSensorDecoder &CreateSectionSensor(sol::table obj);
+			exec::dcc::VirtualSensorDecoder &CreateSectionSensor(RName name, int address);
+
+			void CreateNativeSection(const rapidjson::Value &params);
+			void OnNativeSectionStateChange(BaseSection &section, exec::dcc::VirtualSensorDecoder *sensor);
+
+			sol::object GetSectionState(std::string_view name, sol::this_state state);
+			void AddSectionListener(std::string_view name, sol::protected_function listener);
 
 			void OnVMFinalize();
 
+			bool SetRoute(std::string_view name);
+			bool CancelRoute(std::string_view name);
+			bool IsRouteSet(std::string_view name) const;
+			bool IsRouteClear(std::string_view name) const;
+
+			void OnDccLiteEvent(const sys::ObjectManagerEvent &event);
+
 		private:
 			sigslot::scoped_connection m_slotScriptVMInit;
 			sigslot::scoped_connection m_slotScriptVMFinalize;
+			sigslot::scoped_connection m_slotDccLiteConnection;
 
 			exec::dcc::DccLiteService &m_rclDccLite;
 
 			FolderObject *m_pSections;
 			exec::dcc::Device *m_pclDevice = nullptr;
+
+			std::unique_ptr<Interlocking> m_upInterlocking;
+
+			//optional script hooks for native sections, cleared when the VM goes away
+			std::map<RName, std::vector<sol::protected_function>> m_mapSectionListeners;
 	};
 
 	DispatcherServiceImpl::DispatcherServiceImpl(RName name, sys::Broker &broker, const rapidjson::Value &params, exec::dcc::DccLiteService &dep):
@@ -167,12 +189,31 @@ namespace dcclite::broker::shell::dispatcher
 		{
 			throw std::invalid_argument(fmt::format("[DispatcherServiceImpl::{}] device {} not found", this->GetName(), name));
 		}
+
+		if (auto routes = json::TryGetValue(params, "routes"))
+		{
+			m_upInterlocking = std::make_unique<Interlocking>(
+				this->GetName(), 
+				*routes, 
+				[this](RName decoderName) { return m_rclDccLite.TryFindDecoder(decoderName); }
+			);
+		}
+
+		if (auto sections = json::TryGetValue(params, "sections"))
+		{
+			for (auto &sectionData : sections->GetArray())
+				this->CreateNativeSection(sectionData);
+		}
+
+		m_slotDccLiteConnection = m_rclDccLite.m_sigEvent.connect(&DispatcherServiceImpl::OnDccLiteEvent, this);
 	}
 
 
 	DispatcherServiceImpl::~DispatcherServiceImpl()
 	{
-		//empty
+		//interlocking unlocks its turnouts when destroyed, do not get those events back
+		m_slotDccLiteConnection.disconnect();
+		m_upInterlocking.reset();
 	}
 
 	void DispatcherServiceImpl::Serialize(JsonOutputStream_t &stream) const
@@ -194,7 +235,8 @@ namespace dcclite::broker::shell::dispatcher
 
 	sol::table DispatcherServiceImpl::TryGetSection(std::string_view name)
 	{
-		auto section = static_cast<BaseSectionWrapper *>(m_pSections->TryGetChild(RName{name}));
+		//native sections live on the same folder
+		auto section = dynamic_cast<BaseSectionWrapper *>(m_pSections->TryGetChild(RName{name}));
 		if (!section)
 			return sol::nil;
 
@@ -216,9 +258,15 @@ namespace dcclite::broker::shell::dispatcher
 #if 1
 		std::string name = obj["name"];
 		RName rname{ name };
-		auto section = static_cast<BaseSectionWrapper *>(m_pSections->TryGetChild(rname));
-		if (section == nullptr)
+
+		//native sections live on the same folder
+		auto child = m_pSections->TryGetChild(rname);
+		if (child == nullptr)
 			throw std::runtime_error(fmt::format("[DispatcherServiceImpl::OnSectionStateChange] Section {} not registered", rname));
+
+		auto section = dynamic_cast<BaseSectionWrapper *>(child);
+		if (section == nullptr)
+			throw std::runtime_error(fmt::format("[DispatcherServiceImpl::OnSectionStateChange] Section {} is not a script section", rname));
 #endif		
 
 		section->OnStateUpdate();
@@ -234,28 +282,32 @@ namespace dcclite::broker::shell::dispatcher
 
 	exec::dcc::VirtualSensorDecoder &DispatcherServiceImpl::CreateSectionSensor(sol::table obj)
 	{
-		rapidjson::Document json;
-
-		auto &params = json.SetObject();
-		
 		//must assign to a string to make sure SOL reads a string
 		std::string name = obj["name"];
-		RName rname{ name };
+		int address = obj["address"];
 
+		return this->CreateSectionSensor(RName{ name }, address);
+	}
+
+	exec::dcc::VirtualSensorDecoder &DispatcherServiceImpl::CreateSectionSensor(RName rname, int address)
+	{
 		//was decoder created before?
 		if (auto decoder = this->m_rclDccLite.TryFindDecoder(rname))
 		{
 			//Ok, use it... but make sure it is the correct type
 			auto vdecoder = dynamic_cast<exec::dcc::VirtualSensorDecoder *>(decoder);
 			if(!vdecoder)
-				throw std::invalid_argument(fmt::format("[DispatcherServiceImpl::CreateSectionSensor] Decoder {} is not an virtual sensor, cannot continue. Check names!!!", name));
+				throw std::invalid_argument(fmt::format("[DispatcherServiceImpl::CreateSectionSensor] Decoder {} is not an virtual sensor, cannot continue. Check names!!!", rname));
 
 			return *vdecoder;
 		}
 
-		int address = obj["address"];
-		if (address > std::numeric_limits<uint16_t>::max())
-			throw std::invalid_argument(fmt::format("[DispatcherServiceImpl::CreateSectionSensor] Invalid address {} for {}", address, name));
+		if ((address < 0) || (address > std::numeric_limits<uint16_t>::max()))
+			throw std::invalid_argument(fmt::format("[DispatcherServiceImpl::CreateSectionSensor] Invalid address {} for {}", address, rname));
+
+		rapidjson::Document json;
+
+		auto &params = json.SetObject();
 
 		//
 		//no decoder, so create a new one
@@ -269,19 +321,151 @@ namespace dcclite::broker::shell::dispatcher
 		return static_cast<exec::dcc::VirtualSensorDecoder &>(decoder);
 	}
 
+	void DispatcherServiceImpl::CreateNativeSection(const rapidjson::Value &params)
+	{
+		auto section = BaseSection::Create(params, [this](RName decoderName) { return m_rclDccLite.TryFindDecoder(decoderName); });
+
+		//like script sections, a virtual sensor shows the occupancy to JMRI and others
+		exec::dcc::VirtualSensorDecoder *sensor = nullptr;
+		if (auto address = json::TryGetInt(params, "address"))
+		{
+			sensor = &this->CreateSectionSensor(section->GetName(), *address);
+			sensor->SetSensorState(section->IsClear() ? dcclite::DecoderStates::INACTIVE : dcclite::DecoderStates::ACTIVE);
+		}
+
+		section->m_sigStateChanged.connect([this, sensor](BaseSection &section) { this->OnNativeSectionStateChange(section, sensor); });
+
+		this->NotifyItemCreated(*m_pSections->AddChild(std::move(section)));
+	}
+
+	void DispatcherServiceImpl::OnNativeSectionStateChange(BaseSection &section, exec::dcc::VirtualSensorDecoder *sensor)
+	{
+		if (sensor)
+			sensor->SetSensorState(section.IsClear() ? dcclite::DecoderStates::INACTIVE : dcclite::DecoderStates::ACTIVE);
+
+		this->NotifyItemChanged(section);
+
+		auto it = m_mapSectionListeners.find(section.GetName());
+		if (it == m_mapSectionListeners.end())
+			return;
+
+		for (auto &listener : it->second)
+		{
+			auto r = listener.call(section.GetNameData(), static_cast<int>(section.GetState()));
+
+			if (!r.valid())
+			{
+				sol::error err = r;
+
+				dcclite::Log::Error("[DispatcherServiceImpl::{}] [OnNativeSectionStateChange] Listener for {} failed: {}", this->GetName(), section.GetName(), err.what());
+			}
+		}
+	}
+
+	sol::object DispatcherServiceImpl::GetSectionState(std::string_view name, sol::this_state state)
+	{
+		auto section = dynamic_cast<BaseSection *>(m_pSections->TryGetChild(RName::TryGetName(name)));
+		if (!section)
+			return sol::make_object(state, sol::nil);
+
+		return sol::make_object(state, static_cast<int>(section->GetState()));
+	}
+
+	void DispatcherServiceImpl::AddSectionListener(std::string_view name, sol::protected_function listener)
+	{
+		RName rname{ name };
+
+		if (!dynamic_cast<BaseSection *>(m_pSections->TryGetChild(rname)))
+			throw std::invalid_argument(fmt::format("[DispatcherServiceImpl::{}] [AddSectionListener] Section {} is not a native section", this->GetName(), rname));
+
+		m_mapSectionListeners[rname].push_back(std::move(listener));
+	}
+
+	void DispatcherServiceImpl::OnDccLiteEvent(const sys::ObjectManagerEvent &event)
+	{
+		switch (event.m_kType)
+		{
+			case sys::ObjectManagerEvent::ITEM_CHANGED:
+				if (m_upInterlocking)
+					m_upInterlocking->OnDecoderStateChanged(event.m_rclItem);
+				break;
+
+			case sys::ObjectManagerEvent::ITEM_DESTROYED:
+				if (m_upInterlocking)
+					m_upInterlocking->OnDecoderDestroyed(event.m_rclItem);
+
+				m_pSections->VisitChildren([this, &event](auto &item)
+					{
+						auto section = dynamic_cast<BaseSection *>(&item);
+						if (section && section->OnDecoderDestroyed(event.m_rclItem))
+						{
+							dcclite::Log::Warn("[DispatcherServiceImpl::{}] [OnDccLiteEvent] Section {} lost a decoder, section disabled", this->GetName(), section->GetName());
+
+							this->NotifyItemChanged(*section);
+						}
+
+						return true;
+					}
+				);
+				break;
+
+			case sys::ObjectManagerEvent::ITEM_CREATED:
+				if (!m_upInterlocking)
+					break;
+
+				if (auto item = dynamic_cast<const exec::dcc::Decoder *>(&event.m_rclItem))
+				{
+					//events only carry const items, so get the decoder back from the service
+					if (auto decoder = m_rclDccLite.TryFindDecoder(item->GetName()))
+						m_upInterlocking->OnDecoderCreated(*decoder);
+				}
+				break;
+		}
+	}
+
+	bool DispatcherServiceImpl::SetRoute(std::string_view name)
+	{
+		if (!m_upInterlocking)
+			throw std::logic_error(fmt::format("[DispatcherServiceImpl::{}] [SetRoute] No routes configured", this->GetName()));
+
+		return m_upInterlocking->SetRoute(RName{ name });
+	}
+
+	bool DispatcherServiceImpl::CancelRoute(std::string_view name)
+	{
+		if (!m_upInterlocking)
+			throw std::logic_error(fmt::format("[DispatcherServiceImpl::{}] [CancelRoute] No routes configured", this->GetName()));
+
+		return m_upInterlocking->CancelRoute(RName{ name });
+	}
+
+	bool DispatcherServiceImpl::IsRouteSet(std::string_view name) const
+	{
+		return m_upInterlocking && m_upInterlocking->IsRouteSet(RName{ name });
+	}
+
+	bool DispatcherServiceImpl::IsRouteClear(std::string_view name) const
+	{
+		return m_upInterlocking && m_upInterlocking->IsRouteClear(RName{ name });
+	}
+
 	void DispatcherServiceImpl::OnVMFinalize()
 	{
 		auto self = static_cast<DispatcherServiceImpl *>(this);
 
-		self->m_pSections->VisitChildren([this](auto &current)
+		//native sections do not depend on the VM, only remove the script ones
+		self->m_pSections->KillerVisitChildren([this](auto &current)
 			{
+				if (!dynamic_cast<BaseSectionWrapper *>(&current))
+					return false;
+
 				this->NotifyItemDestroyed(current);
 
 				return true;
 			}
 		);
 
-		self->m_pSections->RemoveAllChildren();
+		self->m_mapSectionListeners.clear();
 	}
 
 	//
@@ -302,6 +486,12 @@ namespace dcclite::broker::shell::dispatcher
 				"on_section_state_change", &DispatcherServiceImpl::OnSectionStateChange,
 				"get_section", &DispatcherServiceImpl::TryGetSection,
 				"panic", &DispatcherServiceImpl::Panic,
+				"set_route", &DispatcherServiceImpl::SetRoute,
+				"cancel_route", &DispatcherServiceImpl::CancelRoute,
+				"is_route_set", &DispatcherServiceImpl::IsRouteSet,
+				"is_route_clear", &DispatcherServiceImpl::IsRouteClear,
+				"get_section_state", &DispatcherServiceImpl::GetSectionState,
+				"add_section_listener", &DispatcherServiceImpl::AddSectionListener,
 				"on_vm_finalize", &DispatcherServiceImpl::OnVMFinalize
 			);
 		}
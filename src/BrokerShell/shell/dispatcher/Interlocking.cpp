@@ -0,0 +1,511 @@
+// Copyright (C) 2019 - Bruno Sanches. See the COPYRIGHT
+// file at the top-level directory of this distribution.
+//
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+//
+// This Source Code Form is "Incompatible With Secondary Licenses", as
+// defined by the Mozilla Public License, v. 2.0.
+
+#include "Interlocking.h"
+
+#include <limits>
+#include <stdexcept>
+#include <string>
+
+#include <dcclite/FmtUtils.h>
+#include <dcclite/JsonUtils.h>
+#include <dcclite/Log.h>
+
+#include "exec/dcc/OutputDecoder.h"
+#include "exec/dcc/SignalDecoder.h"
+#include "exec/dcc/StateDecoder.h"
+
+namespace dcclite::broker::shell::dispatcher
+{
+	static dcclite::DecoderStates ParseTurnoutPosition(std::string_view position, RName route)
+	{
+		if (position == "closed")
+			return dcclite::DecoderStates::INACTIVE;
+
+		if (position == "thrown")
+			return dcclite::DecoderStates::ACTIVE;
+
+		throw std::invalid_argument(fmt::format("[Interlocking] [ParseTurnoutPosition] Route {} has invalid turnout position {}, expected closed or thrown", route, position));
+	}
+
+	static const char *GetElementTypeName(const int type)
+	{
+		static const char *names[] = { "turnout", "sensor", "signal" };
+
+		return names[type];
+	}
+
+	Interlocking::Interlocking(RName owner, const rapidjson::Value &routes, const FindDecoderProc_t &findDecoder):
+		m_rnOwner{ owner }
+	{
+		if (!routes.IsArray())
+			throw std::invalid_argument(fmt::format("[Interlocking::{}] routes must be an array", m_rnOwner));
+
+		if (routes.Size() >= std::numeric_limits<uint16_t>::max())
+			throw std::invalid_argument(fmt::format("[Interlocking::{}] too many routes: {}", m_rnOwner, routes.Size()));
+
+		m_vecRoutes.reserve(routes.Size());
+
+		//
+		//First collect everything, so all elements have an index
+		for (auto &routeData : routes.GetArray())
+		{
+			RName name{ json::GetString(routeData, "name", "route") };
+
+			if (!m_mapRoutes.emplace(name, static_cast<uint16_t>(m_vecRoutes.size())).second)
+				throw std::invalid_argument(fmt::format("[Interlocking::{}] route {} declared twice", m_rnOwner, name));
+
+			Route route;
+			route.m_rnName = name;
+
+			if (auto turnoutsData = json::TryGetValue(routeData, "turnouts"))
+			{
+				for (auto &turnoutData : turnoutsData->GetArray())
+				{
+					route.m_vecTurnouts.push_back(TurnoutPosition{
+						this->RegisterElement(RName{ json::GetString(turnoutData, "name", "route turnout") }, ElementTypes::TURNOUT),
+						ParseTurnoutPosition(json::GetString(turnoutData, "position", "route turnout"), name)
+					});
+				}
+			}
+
+			if (auto sensorsData = json::TryGetValue(routeData, "sensors"))
+			{
+				for (auto &sensorData : sensorsData->GetArray())
+					route.m_vecSensors.push_back(this->RegisterElement(RName{ json::MakeStringView(sensorData) }, ElementTypes::SENSOR));
+			}
+
+			if (auto signalName = json::TryGetString(routeData, "signal"))
+			{
+				route.m_iSignal = this->RegisterElement(RName{ *signalName }, ElementTypes::SIGNAL);
+
+				auto aspectName = std::string{ json::TryGetDefaultString(routeData, "aspect", "Clear") };
+
+				auto aspect = dcclite::TryConvertNameToAspect(aspectName.c_str());
+				if (!aspect)
+					throw std::invalid_argument(fmt::format("[Interlocking::{}] route {} has invalid aspect {}", m_rnOwner, name, aspectName));
+
+				route.m_kAspect = *aspect;
+			}
+
+			m_vecRoutes.push_back(std::move(route));
+		}
+
+		const auto numRoutes = m_vecRoutes.size();
+		const auto numElements = m_vecElements.size();
+
+		for (uint16_t i = 0; i < numRoutes; ++i)
+		{
+			auto &route = m_vecRoutes[i];
+
+			route.m_clElements = InterlockingBitset{ numElements };
+			route.m_clConflicts = InterlockingBitset{ numRoutes };
+
+			auto addElement = [this, &route, i](const uint16_t element)
+			{
+				route.m_clElements.Set(element);
+
+				auto &routes = m_vecElements[element].m_vecRoutes;
+				if (routes.empty() || (routes.back() != i))
+					routes.push_back(i);
+			};
+
+			for (auto &turnout : route.m_vecTurnouts)
+				addElement(turnout.m_uElement);
+
+			for (auto sensor : route.m_vecSensors)
+				addElement(sensor);
+
+			if (route.m_iSignal >= 0)
+				addElement(static_cast<uint16_t>(route.m_iSignal));
+		}
+
+		//
+		//Everything sharing an element conflicts, solved once here, so SetRoute is just a bitset check
+		for (size_t i = 0; i < numRoutes; ++i)
+		{
+			for (size_t j = i + 1; j < numRoutes; ++j)
+			{
+				if (!m_vecRoutes[i].m_clElements.Intersects(m_vecRoutes[j].m_clElements))
+					continue;
+
+				m_vecRoutes[i].m_clConflicts.Set(j);
+				m_vecRoutes[j].m_clConflicts.Set(i);
+			}
+		}
+
+		//explicit conflicts, like flank protection
+		for (auto &routeData : routes.GetArray())
+		{
+			auto conflictsData = json::TryGetValue(routeData, "conflicts");
+			if (!conflictsData)
+				continue;
+
+			RName name{ json::GetString(routeData, "name", "route") };
+			const auto index = m_mapRoutes[name];
+
+			for (auto &conflictData : conflictsData->GetArray())
+			{
+				RName conflictName{ json::MakeStringView(conflictData) };
+
+				auto it = m_mapRoutes.find(conflictName);
+				if (it == m_mapRoutes.end())
+					throw std::invalid_argument(fmt::format("[Interlocking::{}] route {} conflicts with unknown route {}", m_rnOwner, name, conflictName));
+
+				m_vecRoutes[index].m_clConflicts.Set(it->second);
+				m_vecRoutes[it->second].m_clConflicts.Set(index);
+			}
+		}
+
+		//
+		//Now find the decoders, a typo here would silently leave a route unusable, so fail loading
+		for (auto &element : m_vecElements)
+		{
+			auto decoder = findDecoder(element.m_rnName);
+			if (!decoder)
+				throw std::invalid_argument(fmt::format("[Interlocking::{}] {} {} not found", m_rnOwner, GetElementTypeName(static_cast<int>(element.m_kType)), element.m_rnName));
+
+			if (!this->Bind(element, *decoder))
+				throw std::invalid_argument(fmt::format("[Interlocking::{}] decoder {} is not a {}", m_rnOwner, element.m_rnName, GetElementTypeName(static_cast<int>(element.m_kType))));
+		}
+
+		m_clSetRoutes = InterlockingBitset{ numRoutes };
+
+		dcclite::Log::Info("[Interlocking::{}] Loaded {} routes using {} decoders", m_rnOwner, numRoutes, numElements);
+	}
+
+	Interlocking::~Interlocking()
+	{
+		//do not leave turnouts locked by routes that no longer exist
+		for (auto &route : m_vecRoutes)
+		{
+			if (route.m_fSet)
+				this->ReleaseRoute(route, false);
+		}
+	}
+
+	uint16_t Interlocking::RegisterElement(RName name, ElementTypes type)
+	{
+		auto it = m_mapElements.find(name);
+		if (it != m_mapElements.end())
+		{
+			if (m_vecElements[it->second].m_kType != type)
+			{
+				throw std::invalid_argument(fmt::format(
+					"[Interlocking::{}] decoder {} used as {} and {}",
+					m_rnOwner,
+					name,
+					GetElementTypeName(static_cast<int>(m_vecElements[it->second].m_kType)),
+					GetElementTypeName(static_cast<int>(type))
+				));
+			}
+
+			return it->second;
+		}
+
+		if (m_vecElements.size() >= std::numeric_limits<uint16_t>::max())
+			throw std::invalid_argument(fmt::format("[Interlocking::{}] too many decoders", m_rnOwner));
+
+		const auto index = static_cast<uint16_t>(m_vecElements.size());
+
+		m_vecElements.push_back(Element{ name, type });
+		m_mapElements.emplace(name, index);
+
+		return index;
+	}
+
+	bool Interlocking::Bind(Element &element, exec::dcc::Decoder &decoder)
+	{
+		switch (element.m_kType)
+		{
+			case ElementTypes::TURNOUT:
+				if (!dynamic_cast<exec::dcc::OutputDecoder *>(&decoder))
+					return false;
+				break;
+
+			case ElementTypes::SENSOR:
+				if (!dynamic_cast<exec::dcc::StateDecoder *>(&decoder))
+					return false;
+				break;
+
+			case ElementTypes::SIGNAL:
+				if (!dynamic_cast<exec::dcc::SignalDecoder *>(&decoder))
+					return false;
+				break;
+		}
+
+		element.m_pclDecoder = &decoder;
+		m_mapDecoders[&decoder] = static_cast<uint16_t>(&element - m_vecElements.data());
+
+		return true;
+	}
+
+	Interlocking::Route *Interlocking::TryFindRoute(RName name)
+	{
+		auto it = m_mapRoutes.find(name);
+
+		return it == m_mapRoutes.end() ? nullptr : &m_vecRoutes[it->second];
+	}
+
+	const Interlocking::Route *Interlocking::TryFindRoute(RName name) const
+	{
+		auto it = m_mapRoutes.find(name);
+
+		return it == m_mapRoutes.end() ? nullptr : &m_vecRoutes[it->second];
+	}
+
+	exec::dcc::OutputDecoder &Interlocking::GetTurnout(const TurnoutPosition &position) const
+	{
+		//type checked by Bind
+		return static_cast<exec::dcc::OutputDecoder &>(*m_vecElements[position.m_uElement].m_pclDecoder);
+	}
+
+	exec::dcc::StateDecoder &Interlocking::GetSensor(const uint16_t element) const
+	{
+		return static_cast<exec::dcc::StateDecoder &>(*m_vecElements[element].m_pclDecoder);
+	}
+
+	bool Interlocking::IsBound(const Route &route) const
+	{
+		for (auto &turnout : route.m_vecTurnouts)
+		{
+			if (!m_vecElements[turnout.m_uElement].m_pclDecoder)
+				return false;
+		}
+
+		for (auto sensor : route.m_vecSensors)
+		{
+			if (!m_vecElements[sensor].m_pclDecoder)
+				return false;
+		}
+
+		return (route.m_iSignal < 0) || m_vecElements[route.m_iSignal].m_pclDecoder;
+	}
+
+	bool Interlocking::SetRoute(RName name)
+	{
+		auto route = this->TryFindRoute(name);
+		if (!route)
+		{
+			dcclite::Log::Error("[Interlocking::{}] [SetRoute] Route {} not found", m_rnOwner, name);
+
+			return false;
+		}
+
+		if (route->m_fSet)
+			return true;
+
+		if (!this->IsBound(*route))
+		{
+			dcclite::Log::Warn("[Interlocking::{}] [SetRoute] Route {} has missing decoders", m_rnOwner, name);
+
+			return false;
+		}
+
+		if (route->m_clConflicts.Intersects(m_clSetRoutes))
+		{
+			dcclite::Log::Warn("[Interlocking::{}] [SetRoute] Route {} conflicts with a set route", m_rnOwner, name);
+
+			return false;
+		}
+
+		for (auto sensor : route->m_vecSensors)
+		{
+			if (this->GetSensor(sensor).GetState() == dcclite::DecoderStates::ACTIVE)
+			{
+				dcclite::Log::Warn("[Interlocking::{}] [SetRoute] Route {} is occupied at {}", m_rnOwner, name, m_vecElements[sensor].m_rnName);
+
+				return false;
+			}
+		}
+
+		for (auto &turnout : route->m_vecTurnouts)
+		{
+			auto &decoder = this->GetTurnout(turnout);
+
+			if (decoder.IsLocked() && (decoder.GetLockOwner() != name))
+			{
+				dcclite::Log::Warn("[Interlocking::{}] [SetRoute] Route {} turnout {} is locked by {}", m_rnOwner, name, decoder.GetName(), decoder.GetLockOwner());
+
+				return false;
+			}
+		}
+
+		route->m_fSet = true;
+		m_clSetRoutes.Set(route - m_vecRoutes.data());
+
+		dcclite::Log::Info("[Interlocking::{}] [SetRoute] Route {} set", m_rnOwner, name);
+
+		//lock everything first, so a change from someone else cannot sneak in between the throws
+		for (auto &turnout : route->m_vecTurnouts)
+			this->GetTurnout(turnout).Lock(name);
+
+		for (auto &turnout : route->m_vecTurnouts)
+			this->GetTurnout(turnout).SetState(turnout.m_kState, name.GetData().data());
+
+		//virtual turnouts may be already in place
+		this->Evaluate(*route);
+
+		return true;
+	}
+
+	bool Interlocking::CancelRoute(RName name)
+	{
+		auto route = this->TryFindRoute(name);
+		if (!route)
+		{
+			dcclite::Log::Error("[Interlocking::{}] [CancelRoute] Route {} not found", m_rnOwner, name);
+
+			return false;
+		}
+
+		if (!route->m_fSet)
+			return false;
+
+		this->ReleaseRoute(*route, true);
+
+		dcclite::Log::Info("[Interlocking::{}] [CancelRoute] Route {} cancelled", m_rnOwner, name);
+
+		return true;
+	}
+
+	void Interlocking::ReleaseRoute(Route &route, bool resetSignal)
+	{
+		route.m_fSet = false;
+		route.m_fClear = false;
+
+		m_clSetRoutes.Reset(&route - m_vecRoutes.data());
+
+		for (auto &turnout : route.m_vecTurnouts)
+		{
+			if (m_vecElements[turnout.m_uElement].m_pclDecoder)
+				this->GetTurnout(turnout).Unlock(route.m_rnName);
+		}
+
+		if (!resetSignal || (route.m_iSignal < 0))
+			return;
+
+		if (auto signal = static_cast<exec::dcc::SignalDecoder *>(m_vecElements[route.m_iSignal].m_pclDecoder))
+			signal->SetAspect(dcclite::SignalAspects::Stop, route.m_rnName, "route cancelled");
+	}
+
+	bool Interlocking::IsRouteSet(RName name) const
+	{
+		auto route = this->TryFindRoute(name);
+
+		return route && route->m_fSet;
+	}
+
+	bool Interlocking::IsRouteClear(RName name) const
+	{
+		auto route = this->TryFindRoute(name);
+
+		return route && route->m_fClear;
+	}
+
+	void Interlocking::Evaluate(Route &route)
+	{
+		++m_uNumEvaluations;
+
+		bool clear = route.m_fSet;
+
+		for (auto it = route.m_vecTurnouts.begin(), end = route.m_vecTurnouts.end(); clear && (it != end); ++it)
+			clear = this->GetTurnout(*it).GetState() == it->m_kState;
+
+		for (auto it = route.m_vecSensors.begin(), end = route.m_vecSensors.end(); clear && (it != end); ++it)
+			clear = this->GetSensor(*it).GetState() == dcclite::DecoderStates::INACTIVE;
+
+		if (clear == route.m_fClear)
+			return;
+
+		//updated before touching the signal, so any notification coming back from it sees the final state
+		route.m_fClear = clear;
+
+		if (route.m_iSignal < 0)
+			return;
+
+		static_cast<exec::dcc::SignalDecoder *>(m_vecElements[route.m_iSignal].m_pclDecoder)->SetAspect(
+			clear ? route.m_kAspect : dcclite::SignalAspects::Stop,
+			route.m_rnName,
+			clear ? "route clear" : "route blocked"
+		);
+	}
+
+	void Interlocking::OnDecoderStateChanged(const dcclite::IItem &item)
+	{
+		auto it = m_mapDecoders.find(&item);
+		if (it == m_mapDecoders.end())
+			return;
+
+		const auto &element = m_vecElements[it->second];
+		if (element.m_kType == ElementTypes::SIGNAL)
+			return;
+
+		for (auto index : element.m_vecRoutes)
+		{
+			auto &route = m_vecRoutes[index];
+
+			if (route.m_fSet)
+				this->Evaluate(route);
+		}
+	}
+
+	void Interlocking::OnDecoderCreated(exec::dcc::Decoder &decoder)
+	{
+		auto it = m_mapElements.find(decoder.GetName());
+		if (it == m_mapElements.end())
+			return;
+
+		auto &element = m_vecElements[it->second];
+		if (element.m_pclDecoder)
+			return;
+
+		if (!this->Bind(element, decoder))
+		{
+			dcclite::Log::Error("[Interlocking::{}] [OnDecoderCreated] Decoder {} is not a {}, routes using it are disabled", m_rnOwner, element.m_rnName, GetElementTypeName(static_cast<int>(element.m_kType)));
+
+			return;
+		}
+
+		dcclite::Log::Info("[Interlocking::{}] [OnDecoderCreated] Decoder {} is back", m_rnOwner, element.m_rnName);
+	}
+
+	void Interlocking::OnDecoderDestroyed(const dcclite::IItem &item)
+	{
+		auto it = m_mapDecoders.find(&item);
+		if (it == m_mapDecoders.end())
+			return;
+
+		auto &element = m_vecElements[it->second];
+
+		element.m_pclDecoder = nullptr;
+		m_mapDecoders.erase(it);
+
+		for (auto index : element.m_vecRoutes)
+		{
+			auto &route = m_vecRoutes[index];
+			if (!route.m_fSet)
+				continue;
+
+			dcclite::Log::Warn("[Interlocking::{}] [OnDecoderDestroyed] Route {} released, decoder {} was destroyed", m_rnOwner, route.m_rnName, element.m_rnName);
+
+			this->ReleaseRoute(route, true);
+		}
+	}
+
+	void Interlocking::EvaluateAllRoutes()
+	{
+		for (auto &route : m_vecRoutes)
+		{
+			if (route.m_fSet)
+				this->Evaluate(route);
+		}
+	}
+}
@@ -0,0 +1,241 @@
+// Copyright (C) 2019 - Bruno Sanches. See the COPYRIGHT
+// file at the top-level directory of this distribution.
+//
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+//
+// This Source Code Form is "Incompatible With Secondary Licenses", as
+// defined by the Mozilla Public License, v. 2.0.
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <unordered_map>
+#include <vector>
+
+#include <rapidjson/document.h>
+
+#include <dcclite/Nmra.h>
+#include <dcclite/RName.h>
+
+#include <dcclite_shared/SharedLibDefs.h>
+
+namespace dcclite
+{
+	class IItem;
+}
+
+namespace dcclite::broker::exec::dcc
+{
+	class Decoder;
+	class OutputDecoder;
+	class SignalDecoder;
+	class StateDecoder;
+}
+
+namespace dcclite::broker::shell::dispatcher
+{
+	/**
+	* Fixed size set of bits, sized when created, just enough for checking routes against each other with a few ANDs
+	*/
+	class InterlockingBitset
+	{
+		public:
+			explicit InterlockingBitset(size_t numBits = 0):
+				m_vecWords((numBits + 63) / 64, 0)
+			{
+				//empty
+			}
+
+			inline void Set(size_t bit) noexcept
+			{
+				m_vecWords[bit / 64] |= (uint64_t{ 1 } << (bit % 64));
+			}
+
+			inline void Reset(size_t bit) noexcept
+			{
+				m_vecWords[bit / 64] &= ~(uint64_t{ 1 } << (bit % 64));
+			}
+
+			inline bool Test(size_t bit) const noexcept
+			{
+				return m_vecWords[bit / 64] & (uint64_t{ 1 } << (bit % 64));
+			}
+
+			bool Intersects(const InterlockingBitset &other) const noexcept
+			{
+				for (size_t i = 0, len = std::min(m_vecWords.size(), other.m_vecWords.size()); i < len; ++i)
+				{
+					if (m_vecWords[i] & other.m_vecWords[i])
+						return true;
+				}
+
+				return false;
+			}
+
+		private:
+			std::vector<uint64_t> m_vecWords;
+	};
+
+	/**
+
+		Native route locking for the dispatcher.
+
+		Each route is a list of turnouts with the position they must be, a list of sensors (or sections) protecting it and optionally
+		a signal with the aspect to show when the route is set and clear:
+
+		"routes": [
+			{
+				"name": "R_MAIN_WEST",
+				"signal": "SIG_12",
+				"aspect": "Clear",
+				"turnouts": [ { "name": "TRN_01", "position": "closed" }, { "name": "TRN_02", "position": "thrown" } ],
+				"sensors": [ "SEC_WEST", "SEC_YARD" ],
+				"conflicts": [ "R_YARD_EXIT" ]
+			}
+		]
+
+		Routes that share any turnout, sensor or signal conflict with each other, "conflicts" is only needed for extra cases, like
+		flank protection. All the conflicts are solved when loading, so setting a route is a bitset check against the set routes.
+
+		While a route is set its turnouts are locked (see OutputDecoder::Lock) by the route, so nobody else can move them.
+
+		When a decoder changes state only the set routes that use it are evaluated again, a set route shows its aspect if all
+		its turnouts are in position and all its sensors are clear, otherwise the signal goes to Stop.
+
+	*/
+	class Interlocking
+	{
+		public:
+			typedef std::function<exec::dcc::Decoder *(RName name)> FindDecoderProc_t;
+
+			/**
+			* findDecoder is only used while loading, decoders created later come from OnDecoderCreated
+			*/
+			Interlocking(RName owner, const rapidjson::Value &routes, const FindDecoderProc_t &findDecoder);
+			~Interlocking();
+
+			Interlocking(const Interlocking &) = delete;
+			Interlocking &operator=(const Interlocking &) = delete;
+
+			/**
+			* Locks the route turnouts and throws them, fails if the route conflicts with a set route, is occupied or
+			* any of its decoders is missing
+			*/
+			bool SetRoute(RName name);
+
+			/**
+			* Unlocks the route turnouts and puts the signal on Stop, returns false if the route was not set
+			*/
+			bool CancelRoute(RName name);
+
+			bool IsRouteSet(RName name) const;
+
+			/**
+			* Returns true if the route is set and its signal is showing the route aspect
+			*/
+			bool IsRouteClear(RName name) const;
+
+			/**
+			* Incremental update, only routes using the item are evaluated again
+			*/
+			void OnDecoderStateChanged(const dcclite::IItem &item);
+
+			void OnDecoderCreated(exec::dcc::Decoder &decoder);
+			void OnDecoderDestroyed(const dcclite::IItem &item);
+
+			/**
+			* Evaluates all set routes, no matter what changed
+			*/
+			void EvaluateAllRoutes();
+
+			inline size_t GetNumRoutes() const noexcept
+			{
+				return m_vecRoutes.size();
+			}
+
+			inline uint64_t GetNumEvaluations() const noexcept
+			{
+				return m_uNumEvaluations;
+			}
+
+		private:
+			enum class ElementTypes
+			{
+				TURNOUT,
+				SENSOR,
+				SIGNAL
+			};
+
+			struct Element
+			{
+				RName					m_rnName;
+				ElementTypes			m_kType;
+
+				exec::dcc::Decoder		*m_pclDecoder = nullptr;
+
+				//routes using this element, evaluated again when it changes (signals are only used for releasing routes)
+				std::vector<uint16_t>	m_vecRoutes;
+			};
+
+			struct TurnoutPosition
+			{
+				uint16_t				m_uElement;
+				dcclite::DecoderStates	m_kState;
+			};
+
+			struct Route
+			{
+				RName						m_rnName;
+
+				std::vector<TurnoutPosition> m_vecTurnouts;
+				std::vector<uint16_t>		m_vecSensors;
+
+				//-1 if no signal
+				int							m_iSignal = -1;
+				dcclite::SignalAspects		m_kAspect = dcclite::SignalAspects::Clear;
+
+				InterlockingBitset			m_clElements;
+				InterlockingBitset			m_clConflicts;
+
+				bool						m_fSet = false;
+				bool						m_fClear = false;
+			};
+
+			uint16_t RegisterElement(RName name, ElementTypes type);
+
+			bool Bind(Element &element, exec::dcc::Decoder &decoder);
+
+			Route *TryFindRoute(RName name);
+			const Route *TryFindRoute(RName name) const;
+
+			exec::dcc::OutputDecoder &GetTurnout(const TurnoutPosition &position) const;
+			exec::dcc::StateDecoder &GetSensor(const uint16_t element) const;
+
+			bool IsBound(const Route &route) const;
+
+			void Evaluate(Route &route);
+
+			void ReleaseRoute(Route &route, bool resetSignal);
+
+		private:
+			RName m_rnOwner;
+
+			std::vector<Element>	m_vecElements;
+			std::vector<Route>		m_vecRoutes;
+
+			std::map<RName, uint16_t> m_mapElements;
+			std::map<RName, uint16_t> m_mapRoutes;
+
+			//decoder to element index, so state changes are dispatched without looking at names
+			std::unordered_map<const dcclite::IItem *, uint16_t> m_mapDecoders;
+
+			InterlockingBitset m_clSetRoutes;
+
+			uint64_t m_uNumEvaluations = 0;
+	};
+}
@@ -0,0 +1,447 @@
+// Copyright (C) 2019 - Bruno Sanches. See the COPYRIGHT
+// file at the top-level directory of this distribution.
+//
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+//
+// This Source Code Form is "Incompatible With Secondary Licenses", as
+// defined by the Mozilla Public License, v. 2.0.
+
+#include "Section.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+#include <dcclite/FmtUtils.h>
+#include <dcclite/IFolderObject.h>
+#include <dcclite/JsonUtils.h>
+#include <dcclite/Log.h>
+
+#include "exec/dcc/OutputDecoder.h"
+#include "exec/dcc/RemoteDecoder.h"
+
+namespace dcclite::broker::shell::dispatcher
+{
+	using exec::dcc::RemoteDecoder;
+
+	static inline bool IsActive(const RemoteDecoder &decoder) noexcept
+	{
+		return decoder.GetState() == dcclite::DecoderStates::ACTIVE;
+	}
+
+	const char *SectionStateName(const SectionStates state) noexcept
+	{
+		switch (state)
+		{
+			case SectionStates::CLEAR:
+				return "clear";
+
+			case SectionStates::UP_START:
+				return "up_start";
+
+			case SectionStates::UP:
+				return "up";
+
+			case SectionStates::DOWN_START:
+				return "down_start";
+
+			case SectionStates::DOWN:
+				return "down";
+		}
+
+		return "unknown";
+	}
+
+	//
+	//
+	// BaseSection
+	//
+	//
+
+	std::unique_ptr<BaseSection> BaseSection::Create(const rapidjson::Value &params, const FindDecoderProc_t &findDecoder)
+	{
+		RName name{ json::GetString(params, "name", "section") };
+		auto className = json::GetString(params, "class", "section");
+
+		std::unique_ptr<BaseSection> section;
+
+		if (className == "Section")
+		{
+			section = std::make_unique<Section>(
+				name,
+				FindDecoder<RemoteDecoder>(params, "startSensor", findDecoder),
+				FindDecoder<RemoteDecoder>(params, "endSensor", findDecoder)
+			);
+		}
+		else if (className == "TSection")
+		{
+			section = std::make_unique<TSection>(
+				name,
+				FindDecoder<RemoteDecoder>(params, "startSensor", findDecoder),
+				FindDecoder<RemoteDecoder>(params, "closedSensor", findDecoder),
+				FindDecoder<RemoteDecoder>(params, "thrownSensor", findDecoder),
+				FindDecoder<exec::dcc::OutputDecoder>(params, "turnout", findDecoder)
+			);
+		}
+		else if (className == "StorageSection")
+		{
+			section = std::make_unique<StorageSection>(
+				name,
+				FindDecoder<RemoteDecoder>(params, "entrySensor", findDecoder),
+				FindDecoder<RemoteDecoder>(params, "exitSensor", findDecoder)
+			);
+		}
+		else
+		{
+			throw std::invalid_argument(fmt::format("[BaseSection::Create] Section {} has unknown class {}", name, className));
+		}
+
+		section->Init();
+
+		return section;
+	}
+
+	template <typename T>
+	T &BaseSection::FindDecoder(const rapidjson::Value &params, const char *field, const FindDecoderProc_t &findDecoder)
+	{
+		RName name{ json::GetString(params, field, "section") };
+
+		auto decoder = dynamic_cast<T *>(findDecoder(name));
+		if (!decoder)
+			throw std::invalid_argument(fmt::format("[BaseSection::FindDecoder] Decoder {} for {} not found or has the wrong type", name, field));
+
+		return *decoder;
+	}
+
+	BaseSection::BaseSection(RName name):
+		Object(name)
+	{
+		//empty
+	}
+
+	void BaseSection::Watch(RemoteDecoder &decoder, std::function<void(RemoteDecoder &)> proc)
+	{
+		m_vecDecoders.push_back(&decoder);
+		m_vecConnections.emplace_back(decoder.m_sigRemoteStateSync.connect(proc));
+	}
+
+	bool BaseSection::OnDecoderDestroyed(const dcclite::IItem &item)
+	{
+		if (std::find(m_vecDecoders.begin(), m_vecDecoders.end(), &item) == m_vecDecoders.end())
+			return false;
+
+		dcclite::Log::Error("[{}::{}] [OnDecoderDestroyed] Decoder destroyed, section will stay clear until the dispatcher is reloaded", this->GetTypeName(), this->GetName());
+
+		m_fBroken = true;
+
+		m_vecConnections.clear();
+		m_vecDecoders.clear();
+
+		this->Reset();
+
+		return true;
+	}
+
+	void BaseSection::SetState(const SectionStates newState)
+	{
+		if (m_kState == newState)
+			return;
+
+		m_kState = newState;
+
+		m_sigStateChanged(*this);
+	}
+
+	void BaseSection::Reset()
+	{
+		m_pclBlockStart = nullptr;
+		m_pclBlockEnd = nullptr;
+
+		this->SetState(SectionStates::CLEAR);
+	}
+
+	void BaseSection::OnBlockSensorChange(
+		const RemoteDecoder &sensor,
+		const RemoteDecoder &startSensor,
+		const RemoteDecoder &endSensor,
+		const SectionStates startState,
+		const SectionStates completeState
+	)
+	{
+		if (m_pclBlockEnd)
+		{
+			//train is inside, start sensor may oscillate, we do not care
+			if (&sensor == m_pclBlockStart)
+				return;
+
+			if (IsActive(sensor))
+			{
+				if (m_kState == m_kCompleteState)
+				{
+					dcclite::Log::Warn("[{}::{}] end sensor activated again, was the start sensor active when deactivated?", this->GetTypeName(), this->GetName());
+
+					return;
+				}
+
+				//train touched the end sensor
+				this->SetState(m_kCompleteState);
+			}
+			else
+			{
+				if (IsActive(*m_pclBlockStart))
+				{
+					//expect the end sensor to be activated again
+					dcclite::Log::Warn("[{}::{}] end sensor deactivated, but start sensor is active", this->GetTypeName(), this->GetName());
+
+					return;
+				}
+
+				//train left the block
+				this->Reset();
+			}
+
+			return;
+		}
+
+		if (!IsActive(sensor))
+		{
+			dcclite::Log::Error("[{}::{}] sensor {} inactive, but section was clear", this->GetTypeName(), this->GetName(), sensor.GetName());
+
+			return;
+		}
+
+		m_pclBlockStart = &startSensor;
+		m_pclBlockEnd = &endSensor;
+		m_kCompleteState = completeState;
+
+		this->SetState(startState);
+	}
+
+	void BaseSection::Panic(const char *reason) const
+	{
+		dcclite::Log::Error("[{}::{}] [Panic] {}", this->GetTypeName(), this->GetName(), reason);
+	}
+
+	void BaseSection::Serialize(JsonOutputStream_t &stream) const
+	{
+		Object::Serialize(stream);
+
+		//same as the script sections, so clients find the dispatcher
+		if (auto folder = this->GetParent())
+			stream.AddStringValue("ownerPath", folder->GetParent()->GetPath().string());
+
+		stream.AddIntValue("state", static_cast<int>(m_kState));
+		stream.AddStringValue("stateName", SectionStateName(m_kState));
+		stream.AddBool("broken", m_fBroken);
+	}
+
+	//
+	//
+	// Section
+	//
+	//
+
+	Section::Section(RName name, RemoteDecoder &startSensor, RemoteDecoder &endSensor):
+		BaseSection(name),
+		m_rclStartSensor{ startSensor },
+		m_rclEndSensor{ endSensor }
+	{
+		this->Watch(m_rclStartSensor, [this](RemoteDecoder &sensor)
+			{
+				this->OnBlockSensorChange(sensor, m_rclStartSensor, m_rclEndSensor, SectionStates::UP_START, SectionStates::UP);
+			}
+		);
+
+		this->Watch(m_rclEndSensor, [this](RemoteDecoder &sensor)
+			{
+				this->OnBlockSensorChange(sensor, m_rclEndSensor, m_rclStartSensor, SectionStates::DOWN_START, SectionStates::DOWN);
+			}
+		);
+	}
+
+	void Section::Init()
+	{
+		if (IsActive(m_rclStartSensor) && IsActive(m_rclEndSensor))
+		{
+			dcclite::Log::Error("[Section::{}] [Init] both sensors active, state will be undefined", this->GetName());
+		}
+		else if (IsActive(m_rclStartSensor))
+		{
+			this->OnBlockSensorChange(m_rclStartSensor, m_rclStartSensor, m_rclEndSensor, SectionStates::UP_START, SectionStates::UP);
+		}
+		else if (IsActive(m_rclEndSensor))
+		{
+			this->OnBlockSensorChange(m_rclEndSensor, m_rclEndSensor, m_rclStartSensor, SectionStates::DOWN_START, SectionStates::DOWN);
+		}
+	}
+
+	void Section::Serialize(JsonOutputStream_t &stream) const
+	{
+		BaseSection::Serialize(stream);
+
+		//decoders may be gone
+		if (this->IsBroken())
+			return;
+
+		stream.AddStringValue("startSensor", m_rclStartSensor.GetNameData());
+		stream.AddStringValue("endSensor", m_rclEndSensor.GetNameData());
+	}
+
+	//
+	//
+	// TSection
+	//
+	//
+
+	TSection::TSection(
+		RName name,
+		RemoteDecoder &startSensor,
+		RemoteDecoder &closedSensor,
+		RemoteDecoder &thrownSensor,
+		exec::dcc::OutputDecoder &turnout
+	):
+		BaseSection(name),
+		m_rclStartSensor{ startSensor },
+		m_rclClosedSensor{ closedSensor },
+		m_rclThrownSensor{ thrownSensor },
+		m_rclTurnout{ turnout }
+	{
+		this->Watch(m_rclStartSensor, [this](RemoteDecoder &sensor)
+			{
+				this->OnBlockSensorChange(sensor, m_rclStartSensor, this->GetEndSensor(), SectionStates::UP_START, SectionStates::UP);
+			}
+		);
+
+		this->Watch(m_rclClosedSensor, [this](RemoteDecoder &sensor) { this->OnBranchSensorChange(sensor, true); });
+		this->Watch(m_rclThrownSensor, [this](RemoteDecoder &sensor) { this->OnBranchSensorChange(sensor, false); });
+
+		this->Watch(m_rclTurnout, [this](RemoteDecoder &) { this->OnTurnoutChange(); });
+	}
+
+	RemoteDecoder &TSection::GetEndSensor() const noexcept
+	{
+		return IsActive(m_rclTurnout) ? m_rclThrownSensor : m_rclClosedSensor;
+	}
+
+	void TSection::OnBranchSensorChange(RemoteDecoder &sensor, const bool closedBranch)
+	{
+		if (&this->GetEndSensor() != &sensor)
+		{
+			//sensor off is fine, the train may have just left and the turnout changed before the sensor went off
+			if (IsActive(sensor))
+				this->Panic(closedBranch ? "Closed sensor activated, but turnout is not closed" : "Thrown sensor activated, but turnout is closed");
+
+			return;
+		}
+
+		this->OnBlockSensorChange(sensor, sensor, m_rclStartSensor, SectionStates::DOWN_START, SectionStates::DOWN);
+	}
+
+	void TSection::OnTurnoutChange()
+	{
+		//the end sensor follows the turnout, nothing else to do
+		if (!this->IsClear())
+			this->Panic("turnout changed state while section is active");
+	}
+
+	void TSection::Init()
+	{
+		auto &endSensor = this->GetEndSensor();
+
+		if (IsActive(m_rclStartSensor) && IsActive(endSensor))
+		{
+			dcclite::Log::Error("[TSection::{}] [Init] both sensors active, state will be undefined", this->GetName());
+		}
+		else if (IsActive(m_rclStartSensor))
+		{
+			this->OnBlockSensorChange(m_rclStartSensor, m_rclStartSensor, endSensor, SectionStates::UP_START, SectionStates::UP);
+		}
+		else if (IsActive(endSensor))
+		{
+			this->OnBlockSensorChange(endSensor, endSensor, m_rclStartSensor, SectionStates::DOWN_START, SectionStates::DOWN);
+		}
+	}
+
+	void TSection::Serialize(JsonOutputStream_t &stream) const
+	{
+		BaseSection::Serialize(stream);
+
+		if (this->IsBroken())
+			return;
+
+		stream.AddStringValue("startSensor", m_rclStartSensor.GetNameData());
+		stream.AddStringValue("closedSensor", m_rclClosedSensor.GetNameData());
+		stream.AddStringValue("thrownSensor", m_rclThrownSensor.GetNameData());
+		stream.AddStringValue("turnout", m_rclTurnout.GetNameData());
+	}
+
+	//
+	//
+	// StorageSection
+	//
+	//
+
+	StorageSection::StorageSection(RName name, RemoteDecoder &entrySensor, RemoteDecoder &exitSensor):
+		BaseSection(name),
+		m_rclEntrySensor{ entrySensor },
+		m_rclExitSensor{ exitSensor }
+	{
+		this->Watch(m_rclEntrySensor, [this](RemoteDecoder &) { this->OnEntrySensorChange(); });
+		this->Watch(m_rclExitSensor, [this](RemoteDecoder &) { this->OnExitSensorChange(); });
+	}
+
+	void StorageSection::OnEntrySensorChange()
+	{
+		const bool active = IsActive(m_rclEntrySensor);
+
+		switch (this->GetState())
+		{
+			case SectionStates::CLEAR:
+				if (active)
+					this->SetState(SectionStates::UP_START);
+				break;
+
+			case SectionStates::DOWN_START:
+				//train is out
+				if (!active && !IsActive(m_rclExitSensor))
+					this->SetState(SectionStates::CLEAR);
+				break;
+
+			default:
+				//train moving inside the block
+				break;
+		}
+	}
+
+	void StorageSection::OnExitSensorChange()
+	{
+		if (IsActive(m_rclExitSensor))
+		{
+			this->SetState(SectionStates::UP);
+		}
+		else if (this->GetState() == SectionStates::UP)
+		{
+			this->SetState(SectionStates::DOWN_START);
+		}
+	}
+
+	void StorageSection::Init()
+	{
+		if (IsActive(m_rclExitSensor))
+			this->SetState(SectionStates::UP);
+		else if (IsActive(m_rclEntrySensor))
+			this->SetState(SectionStates::UP_START);
+	}
+
+	void StorageSection::Serialize(JsonOutputStream_t &stream) const
+	{
+		BaseSection::Serialize(stream);
+
+		if (this->IsBroken())
+			return;
+
+		stream.AddStringValue("entrySensor", m_rclEntrySensor.GetNameData());
+		stream.AddStringValue("exitSensor", m_rclExitSensor.GetNameData());
+	}
+}
@@ -0,0 +1,244 @@
+// Copyright (C) 2019 - Bruno Sanches. See the COPYRIGHT
+// file at the top-level directory of this distribution.
+//
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+//
+// This Source Code Form is "Incompatible With Secondary Licenses", as
+// defined by the Mozilla Public License, v. 2.0.
+
+#pragma once
+
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include <rapidjson/document.h>
+
+#include <sigslot/signal.hpp>
+
+#include <dcclite/Object.h>
+
+#include "exec/dcc/IResettableObject.h"
+
+namespace dcclite::broker::exec::dcc
+{
+	class Decoder;
+	class OutputDecoder;
+	class RemoteDecoder;
+}
+
+namespace dcclite::broker::shell::dispatcher
+{
+	/**
+	* Same values used by section.lua SECTION_STATES, so scripts can share code with native sections
+	*
+	* UP is going from start sensor to end sensor, DOWN the opposite
+	*/
+	enum class SectionStates
+	{
+		CLEAR = 0,
+		UP_START = 1,
+		UP = 2,
+		DOWN_START = 3,
+		DOWN = 4
+	};
+
+	const char *SectionStateName(const SectionStates state) noexcept;
+
+	/**
+
+		Native track section, occupancy and direction are tracked from the sensors state sync, so no script runs
+		for each sensor edge.
+
+		Sections only watch RemoteDecoders, because they are fed by the decoders m_sigRemoteStateSync.
+
+		Listeners (like the DispatcherService) are told about state changes using m_sigStateChanged.
+
+	*/
+	class BaseSection: public Object, public IResettableObject
+	{
+		public:
+			typedef std::function<exec::dcc::Decoder *(RName name)> FindDecoderProc_t;
+
+			/**
+			* Creates a Section, TSection or StorageSection, depending on the "class" field
+			*/
+			static std::unique_ptr<BaseSection> Create(const rapidjson::Value &params, const FindDecoderProc_t &findDecoder);
+
+			inline SectionStates GetState() const noexcept
+			{
+				return m_kState;
+			}
+
+			inline bool IsClear() const noexcept
+			{
+				return m_kState == SectionStates::CLEAR;
+			}
+
+			inline bool IsGoingUp() const noexcept
+			{
+				return (m_kState == SectionStates::UP_START) || (m_kState == SectionStates::UP);
+			}
+
+			inline bool IsGoingDown() const noexcept
+			{
+				return (m_kState == SectionStates::DOWN_START) || (m_kState == SectionStates::DOWN);
+			}
+
+			/**
+			* A section that lost one of its decoders (device reloaded, for example) stays clear and ignores everything
+			*/
+			inline bool IsBroken() const noexcept
+			{
+				return m_fBroken;
+			}
+
+			/**
+			* Returns true if the item is used by the section, that is now broken
+			*/
+			bool OnDecoderDestroyed(const dcclite::IItem &item);
+
+			void Reset() override;
+
+			void Serialize(JsonOutputStream_t &stream) const override;
+
+			sigslot::signal<BaseSection &> m_sigStateChanged;
+
+		protected:
+			BaseSection(RName name);
+
+			template <typename T>
+			static T &FindDecoder(const rapidjson::Value &params, const char *field, const FindDecoderProc_t &findDecoder);
+
+			void Watch(exec::dcc::RemoteDecoder &decoder, std::function<void(exec::dcc::RemoteDecoder &)> proc);
+
+			/**
+			* Reads the initial state, call it after all sensors are watched
+			*/
+			virtual void Init() = 0;
+
+			void SetState(const SectionStates newState);
+
+			//
+			// Section.lua MiniBlock logic, shared by Section and TSection
+			//
+			// startSensor and endSensor are the sensors on the direction the train is going, so they are only used when the block is clear
+			//
+			void OnBlockSensorChange(
+				const exec::dcc::RemoteDecoder &sensor,
+				const exec::dcc::RemoteDecoder &startSensor,
+				const exec::dcc::RemoteDecoder &endSensor,
+				const SectionStates startState,
+				const SectionStates completeState
+			);
+
+			void Panic(const char *reason) const;
+
+		private:
+			SectionStates m_kState = SectionStates::CLEAR;
+
+			//block in progress, null if clear
+			const exec::dcc::RemoteDecoder *m_pclBlockStart = nullptr;
+			const exec::dcc::RemoteDecoder *m_pclBlockEnd = nullptr;
+			SectionStates m_kCompleteState = SectionStates::CLEAR;
+
+			std::vector<const exec::dcc::Decoder *> m_vecDecoders;
+			std::vector<sigslot::scoped_connection> m_vecConnections;
+
+			bool m_fBroken = false;
+	};
+
+	/**
+	* Two sensors, one on each end of the section
+	*/
+	class Section: public BaseSection
+	{
+		public:
+			Section(RName name, exec::dcc::RemoteDecoder &startSensor, exec::dcc::RemoteDecoder &endSensor);
+
+			const char *GetTypeName() const noexcept override
+			{
+				return "Dispatcher::Section";
+			}
+
+			void Serialize(JsonOutputStream_t &stream) const override;
+
+		protected:
+			void Init() override;
+
+		private:
+			exec::dcc::RemoteDecoder &m_rclStartSensor;
+			exec::dcc::RemoteDecoder &m_rclEndSensor;
+	};
+
+	/**
+	* A section with a turnout, the end sensor is the closed or thrown sensor, depending on the turnout position
+	*/
+	class TSection: public BaseSection
+	{
+		public:
+			TSection(
+				RName name,
+				exec::dcc::RemoteDecoder &startSensor,
+				exec::dcc::RemoteDecoder &closedSensor,
+				exec::dcc::RemoteDecoder &thrownSensor,
+				exec::dcc::OutputDecoder &turnout
+			);
+
+			const char *GetTypeName() const noexcept override
+			{
+				return "Dispatcher::TSection";
+			}
+
+			void Serialize(JsonOutputStream_t &stream) const override;
+
+		protected:
+			void Init() override;
+
+		private:
+			void OnBranchSensorChange(exec::dcc::RemoteDecoder &sensor, const bool closedBranch);
+			void OnTurnoutChange();
+
+			exec::dcc::RemoteDecoder &GetEndSensor() const noexcept;
+
+		private:
+			exec::dcc::RemoteDecoder &m_rclStartSensor;
+			exec::dcc::RemoteDecoder &m_rclClosedSensor;
+			exec::dcc::RemoteDecoder &m_rclThrownSensor;
+			exec::dcc::OutputDecoder &m_rclTurnout;
+	};
+
+	/**
+	* A dead end block for stopping a train, the train goes in by the entry sensor and stops on the exit sensor
+	*
+	*	CLEAR: nothing inside
+	*	UP_START: train passed the entry sensor
+	*	UP: train is at the exit sensor (stop point)
+	*	DOWN_START: train left the exit sensor going back, it is clear when the entry sensor goes off
+	*/
+	class StorageSection: public BaseSection
+	{
+		public:
+			StorageSection(RName name, exec::dcc::RemoteDecoder &entrySensor, exec::dcc::RemoteDecoder &exitSensor);
+
+			const char *GetTypeName() const noexcept override
+			{
+				return "Dispatcher::StorageSection";
+			}
+
+			void Serialize(JsonOutputStream_t &stream) const override;
+
+		protected:
+			void Init() override;
+
+		private:
+			void OnEntrySensorChange();
+			void OnExitSensorChange();
+
+		private:
+			exec::dcc::RemoteDecoder &m_rclEntrySensor;
+			exec::dcc::RemoteDecoder &m_rclExitSensor;
+	};
+}
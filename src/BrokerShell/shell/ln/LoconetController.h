@@ -0,0 +1,96 @@
+// Copyright (C) 2019 - Bruno Sanches. See the COPYRIGHT
+// file at the top-level directory of this distribution.
+//
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+//
+// This Source Code Form is "Incompatible With Secondary Licenses", as
+// defined by the Mozilla Public License, v. 2.0.
+//
+// LocoNet is a registered trademark of Digitrax Inc.
+//
+
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include <dcclite/Clock.h>
+#include <dcclite/Object.h>
+
+namespace dcclite::broker::shell::ln
+{
+	class IThrottleProvider;
+	class LoconetMessageWriter;
+	class LoconetTransmitQueue;
+	class SlotManager;
+
+	/**
+
+		The command station side of LocoNet: splits the bytes read from the bus into messages, keeps the slots and queues
+		the replies on a LoconetTransmitQueue.
+
+		It does not know about serial ports or services, LoconetService feeds it from the PR3 and the unit tests feed it
+		from captures (see dcclite::SerialReplay).
+
+	*/
+	class LoconetController
+	{
+		public:
+			typedef std::function<void(uint8_t slot)> SlotChangedProc_t;
+
+			LoconetController(IThrottleProvider &throttleProvider, LoconetTransmitQueue &transmitQueue, SlotChangedProc_t slotChanged);
+			~LoconetController();
+
+			/**
+			* Handles all complete messages on data, a message split across reads is kept until the next call
+			*
+			* Returns the number of messages handled
+			*/
+			unsigned ReceiveData(const uint8_t *data, const unsigned size, const dcclite::Clock::TimePoint_t ticks);
+
+			void ResetPr3();
+
+			void PurgeSlots(const dcclite::Clock::TimePoint_t ticks);
+
+			void Serialize(JsonOutputStream_t &stream) const;
+			void SerializeSlot(const uint8_t slotIndex, JsonOutputStream_t &stream) const;
+
+			inline uint64_t GetNumMessages() const noexcept
+			{
+				return m_uNumMessages;
+			}
+
+			inline uint64_t GetNumErrors() const noexcept
+			{
+				return m_uNumErrors;
+			}
+
+		private:
+			void DispatchLnMessage(const LoconetMessageWriter &msg);
+			void DispatchLnLongAckMessage(const uint8_t opcode, const uint8_t responseCode);
+
+			void ParseMessage(const uint8_t opcode, const uint8_t *payload, const uint8_t payloadSize, const dcclite::Clock::TimePoint_t ticks);
+
+			void ParseLocomotiveDirf(const uint8_t slot, const uint8_t dirf, const dcclite::Clock::TimePoint_t ticks);
+			void ParseLocomotiveSnd(const uint8_t slot, const uint8_t snd, const dcclite::Clock::TimePoint_t ticks);
+
+		private:
+			std::unique_ptr<SlotManager> m_upSlotManager;
+
+			LoconetTransmitQueue &m_rclTransmitQueue;
+
+			SlotChangedProc_t m_pfnSlotChanged;
+
+			//bytes received but not parsed yet (message split across reads)
+			std::vector<uint8_t> m_vecInput;
+
+			uint64_t m_uNumMessages = 0;
+			uint64_t m_uNumErrors = 0;
+
+			uint8_t m_uErrorCount = 0;
+	};
+}
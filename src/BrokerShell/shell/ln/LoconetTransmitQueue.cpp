@@ -0,0 +1,129 @@
+// Copyright (C) 2019 - Bruno Sanches. See the COPYRIGHT
+// file at the top-level directory of this distribution.
+//
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+//
+// This Source Code Form is "Incompatible With Secondary Licenses", as
+// defined by the Mozilla Public License, v. 2.0.
+//
+// LocoNet is a registered trademark of Digitrax Inc.
+//
+
+#include "LoconetTransmitQueue.h"
+
+#include <cstring>
+#include <stdexcept>
+
+#include <fmt/format.h>
+
+#include "sys/Timeouts.h"
+
+namespace dcclite::broker::shell::ln
+{
+	void LoconetTransmitQueue::Push(const uint8_t *data, const uint8_t size, const Priorities priority, const uint16_t coalesceKey)
+	{
+		if ((size == 0) || (size > MAX_MESSAGE_LEN))
+			throw std::invalid_argument(fmt::format("[LoconetTransmitQueue::Push] Invalid message size: {}", size));
+
+		if (coalesceKey)
+		{
+			auto it = m_mapPendingKeys.find(coalesceKey);
+			if (it != m_mapPendingKeys.end())
+			{
+				//replace it, the old one is no longer relevant
+				auto &msg = *it->second;
+
+				memcpy(msg.m_arData.data(), data, size);
+				msg.m_uSize = size;
+
+				++m_uNumCoalesced;
+
+				return;
+			}
+		}
+
+		auto &lane = m_arLanes[static_cast<int>(priority)];
+
+		auto &msg = lane.emplace_back();
+
+		memcpy(msg.m_arData.data(), data, size);
+		msg.m_uSize = size;
+		msg.m_uCoalesceKey = coalesceKey;
+
+		if (coalesceKey)
+			m_mapPendingKeys.emplace(coalesceKey, &msg);
+	}
+
+	bool LoconetTransmitQueue::FillLane(std::deque<Message> &lane, SerialPort::DataPacket &packet, const Clock::TimePoint_t limit, unsigned &numWritten)
+	{
+		while (!lane.empty())
+		{
+			//bus busy until the next pump?
+			if (m_tBusFree > limit)
+				return false;
+
+			auto &msg = lane.front();
+
+			if (msg.m_uSize > packet.GetNumFreeBytes())
+				return false;
+
+			packet.WriteData(msg.m_arData.data(), msg.m_uSize);
+
+			m_tBusFree += (sys::LOCONET_BYTE_TIME * msg.m_uSize) + sys::LOCONET_TX_BACKOFF;
+
+			if (msg.m_uCoalesceKey)
+				m_mapPendingKeys.erase(msg.m_uCoalesceKey);
+
+			lane.pop_front();
+
+			++numWritten;
+		}
+
+		return true;
+	}
+
+	unsigned LoconetTransmitQueue::Pump(SerialPort &port, const Clock::TimePoint_t now, const Clock::DefaultClock_t::duration window)
+	{
+		if (!m_clOutputPacket.IsDataReady())
+			return 0;
+
+		m_clOutputPacket.Clear();
+
+		const auto numWritten = this->Fill(m_clOutputPacket, now, window);
+		if (numWritten)
+			port.Write(m_clOutputPacket);
+
+		return numWritten;
+	}
+
+	unsigned LoconetTransmitQueue::Fill(SerialPort::DataPacket &packet, const Clock::TimePoint_t now, const Clock::DefaultClock_t::duration window)
+	{
+		if (m_tBusFree < now)
+			m_tBusFree = now;
+
+		const auto limit = now + window;
+
+		unsigned numWritten = 0;
+		for (auto &lane : m_arLanes)
+		{
+			if (!this->FillLane(lane, packet, limit, numWritten))
+				break;
+		}
+
+		m_uNumSent += numWritten;
+
+		return numWritten;
+	}
+
+	size_t LoconetTransmitQueue::GetSize() const noexcept
+	{
+		size_t size = 0;
+
+		for (auto &lane : m_arLanes)
+			size += lane.size();
+
+		return size;
+	}
+}
@@ -0,0 +1,115 @@
+// Copyright (C) 2019 - Bruno Sanches. See the COPYRIGHT
+// file at the top-level directory of this distribution.
+//
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+//
+// This Source Code Form is "Incompatible With Secondary Licenses", as
+// defined by the Mozilla Public License, v. 2.0.
+//
+// LocoNet is a registered trademark of Digitrax Inc.
+//
+
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <deque>
+#include <unordered_map>
+
+#include <dcclite/Clock.h>
+#include <dcclite/SerialPort.h>
+
+namespace dcclite::broker::shell::ln
+{
+	/**
+
+		Outgoing LocoNet messages.
+
+		Messages are sent by priority, replies that a throttle is waiting for (slot data, long acks) go before anything else.
+
+		Messages with a coalesce key (speed, direction and sound for a slot) replace a queued message with the same key, keeping
+		its place on the queue, so a busy bus only gets the latest state of each slot.
+
+		Pump only writes messages while the estimated bus time (message bytes plus CD backoff) fits on the given window, so
+		when the bus is busy messages wait here (and get coalesced) instead of piling up on the PR3.
+
+	*/
+	class LoconetTransmitQueue
+	{
+		public:
+			enum class Priorities
+			{
+				HIGH,
+				NORMAL
+			};
+
+			static constexpr auto NUM_PRIORITIES = 2;
+			static constexpr auto MAX_MESSAGE_LEN = 20;
+
+			/**
+			* Zero is not a valid key, opcodes always have the high bit set
+			*/
+			static constexpr uint16_t MakeCoalesceKey(const uint8_t opcode, const uint8_t slot) noexcept
+			{
+				return static_cast<uint16_t>((opcode << 8) | slot);
+			}
+
+			/**
+			* A coalesceKey of zero means the message is never replaced
+			*/
+			void Push(const uint8_t *data, const uint8_t size, const Priorities priority, const uint16_t coalesceKey = 0);
+
+			/**
+			* Writes to the port all queued messages that fit on the bus until now + window, does nothing while the last write is pending
+			*
+			* Returns the number of messages written
+			*/
+			unsigned Pump(SerialPort &port, const Clock::TimePoint_t now, const Clock::DefaultClock_t::duration window);
+
+			/**
+			* Moves to packet all queued messages that fit on the bus until now + window, used by Pump
+			*
+			* Returns the number of messages moved
+			*/
+			unsigned Fill(SerialPort::DataPacket &packet, const Clock::TimePoint_t now, const Clock::DefaultClock_t::duration window);
+
+			size_t GetSize() const noexcept;
+
+			inline uint64_t GetNumSent() const noexcept
+			{
+				return m_uNumSent;
+			}
+
+			inline uint64_t GetNumCoalesced() const noexcept
+			{
+				return m_uNumCoalesced;
+			}
+
+		private:
+			struct Message
+			{
+				std::array<uint8_t, MAX_MESSAGE_LEN> m_arData;
+
+				uint16_t m_uCoalesceKey;
+				uint8_t m_uSize;
+			};
+
+			bool FillLane(std::deque<Message> &lane, SerialPort::DataPacket &packet, const Clock::TimePoint_t limit, unsigned &numWritten);
+
+		private:
+			std::array<std::deque<Message>, NUM_PRIORITIES> m_arLanes;
+
+			//deque push_back and pop_front do not invalidate pointers to other elements
+			std::unordered_map<uint16_t, Message *> m_mapPendingKeys;
+
+			SerialPort::DataPacket m_clOutputPacket;
+
+			//when the bus will be free of everything we already wrote
+			Clock::TimePoint_t m_tBusFree;
+
+			uint64_t m_uNumSent = 0;
+			uint64_t m_uNumCoalesced = 0;
+	};
+}
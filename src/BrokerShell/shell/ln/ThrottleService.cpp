@@ -23,6 +23,7 @@
 #include <dcclite/NetMessenger.h>
 
 #include "sys/ServiceFactory.h"
+#include "sys/SocketReactor.h"
 #include "sys/Thinker.h"
 #include "sys/Timeouts.h"
 
@@ -36,43 +37,56 @@
 
 using ILoconetSlot = dcclite::broker::shell::ln::ILoconetSlot;
 
+namespace SocketReactor = dcclite::broker::sys::SocketReactor;
 
-class Throttle: public dcclite::Object, public dcclite::broker::shell::ln::IThrottle
+/**
+* Drives a WiThrottle connection: the state machine only runs when its socket is ready (SocketReactor) or when a
+* protocol timer expires (connection timeout and heartbeats), idle throttles cost nothing
+*/
+class Throttle: public dcclite::Object, public dcclite::broker::shell::ln::IThrottle, private SocketReactor::IHandler
 {
 	public:
-#if 1
 		Throttle(const dcclite::NetworkAddress &serverAddress, const ILoconetSlot &owner) :
 			Object(dcclite::RName{ fmt::format("slot[{}][{}]", owner.GetId(), owner.GetLocomotiveAddress().GetAddress()) }),			
 			m_vState{ ConnectState {serverAddress} },
 			m_clServerAddress{ serverAddress },
-			m_rclOwnerSlot{ owner }
+			m_rclOwnerSlot{ owner },
+			m_tThinker{ "Throttle::Thinker", THINKER_MF_LAMBDA(OnTimeout) }
 		{
 			m_pclCurrentState = &std::get<ConnectState>(m_vState);
 
 			assert(m_pclCurrentState);
+
+			m_tThinker.Schedule(dcclite::Clock::DefaultClock_t::now() + dcclite::broker::sys::THROTTLE_SERVICE_CONNECT_TIMEOUT);
+			this->Watch();
 		}
-#endif
 
-		const char *GetTypeName() const noexcept override
+		~Throttle() override
 		{
-			return "Throttle";
+			SocketReactor::Unwatch(*this);
 		}
 
-		void Update(const dcclite::Clock::TimePoint_t ticks)
+		const char *GetTypeName() const noexcept override
 		{
-			m_pclCurrentState->Update(*this, ticks);
+			return "Throttle";
 		}
 
 		void OnSpeedChange() override
 		{			
-			if (m_pclConnectedState)
-				m_pclConnectedState->SetSpeed(m_rclOwnerSlot.GetSpeed());
+			if (!m_pclConnectedState)
+				return;
+
+			m_pclConnectedState->SetSpeed(m_rclOwnerSlot.GetSpeed());
+			this->WatchPendingOutput();
 		}
 
 		void OnForwardChange() override
 		{	
-			if (m_pclConnectedState)
-				m_pclConnectedState->SetForward(m_rclOwnerSlot.IsForwardDir());
+			if (!m_pclConnectedState)
+				return;
+
+			m_pclConnectedState->SetForward(m_rclOwnerSlot.IsForwardDir());
+			this->WatchPendingOutput();
 		}
 
 		void OnFunctionChange(const uint8_t begin, const uint8_t end) override
@@ -81,6 +95,7 @@ class Throttle: public dcclite::Object, public dcclite::broker::shell::ln::IThro
 				return;
 
 			m_pclConnectedState->OnFunctionChange(begin, end, m_rclOwnerSlot.GetFunctions());
+			this->WatchPendingOutput();
 		}
 
 		void OnEmergencyStop() override
@@ -89,6 +104,7 @@ class Throttle: public dcclite::Object, public dcclite::broker::shell::ln::IThro
 				return;
 
 			m_pclConnectedState->OnEmergencyStop();
+			this->WatchPendingOutput();
 		}
 
 		void AddSlave(const ILoconetSlot &slot) override
@@ -109,6 +125,7 @@ class Throttle: public dcclite::Object, public dcclite::broker::shell::ln::IThro
 				return;
 
 			m_pclConnectedState->OnAddSlave(slot);
+			this->WatchPendingOutput();
 		}
 
 		void RemoveSlave(const ILoconetSlot &slot) override
@@ -128,7 +145,10 @@ class Throttle: public dcclite::Object, public dcclite::broker::shell::ln::IThro
 				return;
 
 			if (m_pclConnectedState)
+			{
 				m_pclConnectedState->OnRemoveSlave(slot);
+				this->WatchPendingOutput();
+			}
 			
 			m_vecSlaves.erase(removedIt, m_vecSlaves.end());
 		}
@@ -139,6 +159,48 @@ class Throttle: public dcclite::Object, public dcclite::broker::shell::ln::IThro
 		}
 
 	private:
+		void OnSocketReady(const uint32_t events) override
+		{
+			//may change the state
+			m_pclCurrentState->OnReady(*this, events, dcclite::Clock::DefaultClock_t::now());
+
+			this->Watch();
+		}
+
+		void OnTimeout(const dcclite::Clock::TimePoint_t ticks)
+		{
+			m_pclCurrentState->OnTimeout(*this, ticks);
+
+			this->Watch();
+		}
+
+		/**
+		* Arms the socket for whatever the current state is waiting for
+		*/
+		void Watch()
+		{
+			const auto events = m_pclCurrentState->GetEvents();
+
+			if (events)
+				SocketReactor::Watch(*this, m_pclCurrentState->GetHandle(), events);
+			else
+				SocketReactor::Unwatch(*this);
+		}
+
+		/**
+		* Commands are sent right away, only if the socket did not take everything we need to know when it is writable again
+		*/
+		void WatchPendingOutput()
+		{
+			if (m_pclConnectedState->HasPendingOutput())
+				this->Watch();
+		}
+
+		void GotoProtocolTimeoutState(const char *stateName)
+		{
+			this->GotoErrorState(fmt::format("[Throttle::{}] {} timeout, server did not answer", stateName, this->GetName()));
+		}
+
 		template <typename T, class... Args>
 		void SetState(Args&&...args)
 		{
@@ -150,11 +212,19 @@ class Throttle: public dcclite::Object, public dcclite::broker::shell::ln::IThro
 
 		void GotoConnectState()
 		{
+			//the old socket is going away
+			SocketReactor::Unwatch(*this);
+
 			this->SetState<ConnectState>(m_clServerAddress);
+
+			m_tThinker.Schedule(dcclite::Clock::DefaultClock_t::now() + dcclite::broker::sys::THROTTLE_SERVICE_CONNECT_TIMEOUT);
 		}
 
 		void GotoErrorState(std::string reason)
 		{
+			SocketReactor::Unwatch(*this);
+			m_tThinker.Cancel();
+
 			this->SetState<ErrorState>(std::move(reason));
 		}
 
@@ -165,7 +235,10 @@ class Throttle: public dcclite::Object, public dcclite::broker::shell::ln::IThro
 			if (!connectingState)
 				throw std::logic_error("[Throttle::GotoHandShakeState] Invalid state, must be in ConnectingState state");
 
-			this->SetState<HandShakeState>(std::move(connectingState->m_clSocket) );
+			//take it before emplace destroys the current state (and closes the socket)
+			auto socket = std::move(connectingState->m_clSocket);
+
+			this->SetState<HandShakeState>(std::move(socket));
 		}
 
 		void GotoConfiguringThrottleIdState(const char *separator, const char *initialBuffer = "")
@@ -191,6 +264,12 @@ class Throttle: public dcclite::Object, public dcclite::broker::shell::ln::IThro
 
 			this->SetState<ConnectedState>(*this, std::move(tmp));
 			m_pclConnectedState = &std::get<ConnectedState>(m_vState);	
+
+			//from now on the timer is only used for heartbeats
+			if (const auto interval = m_pclConnectedState->GetHeartBeatInterval(); interval.count())
+				m_tThinker.Schedule(dcclite::Clock::DefaultClock_t::now() + interval);
+			else
+				m_tThinker.Cancel();
 		}
 
 	private:		
@@ -198,7 +277,15 @@ class Throttle: public dcclite::Object, public dcclite::broker::shell::ln::IThro
 		{
 			virtual ~State() = default;
 
-			virtual void Update(Throttle &self, const dcclite::Clock::TimePoint_t time) = 0;
+			/**
+			* Called when the socket is ready for the events returned by GetEvents
+			*/
+			virtual void OnReady(Throttle &self, const uint32_t events, const dcclite::Clock::TimePoint_t time) = 0;
+
+			virtual void OnTimeout(Throttle &self, const dcclite::Clock::TimePoint_t time) = 0;
+
+			virtual uint32_t GetEvents() const noexcept = 0;
+			virtual dcclite::Socket::Handler_t GetHandle() const noexcept = 0;
 		};
 
 		struct ErrorState : State
@@ -208,10 +295,25 @@ class Throttle: public dcclite::Object, public dcclite::broker::shell::ln::IThro
 				dcclite::Log::Error("{}", reason);
 			}
 
-			void Update(Throttle &self, const dcclite::Clock::TimePoint_t time) override
+			void OnReady(Throttle &self, const uint32_t events, const dcclite::Clock::TimePoint_t time) override
+			{
+				//empty
+			}
+
+			void OnTimeout(Throttle &self, const dcclite::Clock::TimePoint_t time) override
 			{
 				//empty
 			}
+
+			uint32_t GetEvents() const noexcept override
+			{
+				return 0;
+			}
+
+			dcclite::Socket::Handler_t GetHandle() const noexcept override
+			{
+				return 0;
+			}
 		};
 
 		struct ConnectState: State
@@ -225,9 +327,10 @@ class Throttle: public dcclite::Object, public dcclite::broker::shell::ln::IThro
 					dcclite::Log::Debug("[Throttle::ConnectState] Connecting to {}", serverAddress);
 				}
 
-				void Update(Throttle &self, const dcclite::Clock::TimePoint_t time) override
+				void OnReady(Throttle &self, const uint32_t events, const dcclite::Clock::TimePoint_t time) override
 				{
-					auto status = m_clSocket.GetConnectionProgress();
+					//a failed connect is also reported as writable, so check the error first
+					auto status = (events & SocketReactor::EVENT_ERROR) ? dcclite::Socket::Status::DISCONNECTED : m_clSocket.GetConnectionProgress();
 					if (status == dcclite::Socket::Status::DISCONNECTED)
 					{
 						self.GotoErrorState(fmt::format("[Throttle::ConnectState] Disconnected on GetConnectionProgress"));
@@ -240,6 +343,21 @@ class Throttle: public dcclite::Object, public dcclite::broker::shell::ln::IThro
 					}
 				}
 
+				void OnTimeout(Throttle &self, const dcclite::Clock::TimePoint_t time) override
+				{
+					self.GotoProtocolTimeoutState("ConnectState");
+				}
+
+				uint32_t GetEvents() const noexcept override
+				{
+					return SocketReactor::EVENT_WRITE;
+				}
+
+				dcclite::Socket::Handler_t GetHandle() const noexcept override
+				{
+					return m_clSocket.GetHandle();
+				}
+
 				dcclite::Socket m_clSocket;
 		};
 
@@ -251,7 +369,7 @@ class Throttle: public dcclite::Object, public dcclite::broker::shell::ln::IThro
 				//empty
 			}
 
-			void Update(Throttle &self, const dcclite::Clock::TimePoint_t time) override
+			void OnReady(Throttle &self, const uint32_t events, const dcclite::Clock::TimePoint_t time) override
 			{
 				char buffer[6];
 
@@ -306,7 +424,7 @@ class Throttle: public dcclite::Object, public dcclite::broker::shell::ln::IThro
 					}
 					else if (buffer[0] == '\r')
 					{
-						//try again later, because it can be \r or \r\n, so we must look one byte forward...
+						//it can be \r or \r\n, so we must look one byte forward...
 						m_fLookForward = true;						
 					}
 					else
@@ -316,7 +434,7 @@ class Throttle: public dcclite::Object, public dcclite::broker::shell::ln::IThro
 						return;
 					}
 				}
-				else
+
 				{
 					auto [status, size] = m_clSocket.Receive(buffer, 1);
 					if (status == dcclite::Socket::Status::WOULD_BLOCK)
@@ -342,6 +460,21 @@ class Throttle: public dcclite::Object, public dcclite::broker::shell::ln::IThro
 				}				
 			}
 
+			void OnTimeout(Throttle &self, const dcclite::Clock::TimePoint_t time) override
+			{
+				self.GotoProtocolTimeoutState("HandShakeState");
+			}
+
+			uint32_t GetEvents() const noexcept override
+			{
+				return SocketReactor::EVENT_READ;
+			}
+
+			dcclite::Socket::Handler_t GetHandle() const noexcept override
+			{
+				return m_clSocket.GetHandle();
+			}
+
 			dcclite::Socket m_clSocket;
 			bool m_fGotVersion = false;
 			bool m_fLookForward = false;
@@ -352,8 +485,7 @@ class Throttle: public dcclite::Object, public dcclite::broker::shell::ln::IThro
 			protected:
 				dcclite::NetMessenger m_clMessenger;
 
-				std::chrono::seconds m_uHeartBeatInterval;
-				dcclite::Clock::TimePoint_t m_tNextHeartBeat;
+				std::chrono::seconds m_uHeartBeatInterval{};
 
 			protected:
 				explicit OnlineState(dcclite::NetMessenger &&other) :
@@ -364,12 +496,22 @@ class Throttle: public dcclite::Object, public dcclite::broker::shell::ln::IThro
 
 				OnlineState(OnlineState &&other) noexcept :
 					m_clMessenger{ std::move(other.m_clMessenger) },
-					m_uHeartBeatInterval{ other.m_uHeartBeatInterval },
-					m_tNextHeartBeat{ other.m_tNextHeartBeat }
+					m_uHeartBeatInterval{ other.m_uHeartBeatInterval }
 				{
 					//empty
 				}				
 
+				/**
+				* Sends anything left by previous sends, returns false if the connection was lost
+				*/
+				bool FlushOutput(const uint32_t events)
+				{
+					if (!(events & SocketReactor::EVENT_WRITE))
+						return true;
+
+					return m_clMessenger.Flush() != dcclite::Socket::Status::DISCONNECTED;
+				}
+
 			protected:
 				static bool ParseMessage(Throttle &self, const std::string &message)
 				{
@@ -440,19 +582,24 @@ class Throttle: public dcclite::Object, public dcclite::broker::shell::ln::IThro
 				}
 
 			public:				
-				void Update(Throttle &self, const dcclite::Clock::TimePoint_t time) override
+				uint32_t GetEvents() const noexcept override
 				{
-					using namespace std::chrono_literals;
+					return SocketReactor::EVENT_READ | (m_clMessenger.HasPendingOutput() ? SocketReactor::EVENT_WRITE : 0);
+				}
 
-					if (m_uHeartBeatInterval == 0s)
-						return;
+				dcclite::Socket::Handler_t GetHandle() const noexcept override
+				{
+					return m_clMessenger.GetHandle();
+				}
 
-					if (m_tNextHeartBeat <= time)
-					{
-						m_clMessenger.Send("*");
+				bool HasPendingOutput() const noexcept
+				{
+					return m_clMessenger.HasPendingOutput();
+				}
 
-						m_tNextHeartBeat = time + m_uHeartBeatInterval;
-					}
+				std::chrono::seconds GetHeartBeatInterval() const noexcept
+				{
+					return m_uHeartBeatInterval;
 				}
 		};
 
@@ -466,8 +613,15 @@ class Throttle: public dcclite::Object, public dcclite::broker::shell::ln::IThro
 					m_clMessenger.Send(fmt::format("N{} {}", "DCCLite", self.GetName()));					
 				}
 
-				void Update(Throttle &self, const dcclite::Clock::TimePoint_t time) override
+				void OnReady(Throttle &self, const uint32_t events, const dcclite::Clock::TimePoint_t time) override
 				{
+					if (!this->FlushOutput(events))
+					{
+						self.GotoErrorState("[Throttle::ConfiguringState::OnReady] Disconnected");
+
+						return;
+					}
+
 					for (;;)
 					{
 						auto [status, message] = m_clMessenger.Poll();
@@ -476,7 +630,7 @@ class Throttle: public dcclite::Object, public dcclite::broker::shell::ln::IThro
 
 						if (status == dcclite::Socket::Status::DISCONNECTED)
 						{
-							self.GotoErrorState("[Throttle::ConfiguringState::Update] Disconnected");
+							self.GotoErrorState("[Throttle::ConfiguringState::OnReady] Disconnected");
 							break;
 						}
 
@@ -487,13 +641,12 @@ class Throttle: public dcclite::Object, public dcclite::broker::shell::ln::IThro
 							int heartBeat;
 							if(parser.GetNumber(heartBeat) != dcclite::Tokens::NUMBER)
 							{
-								self.GotoErrorState(fmt::format("[Throttle::ConfiguringState::Update] Expected heartbeat seconds, but got: {}", message));
+								self.GotoErrorState(fmt::format("[Throttle::ConfiguringState::OnReady] Expected heartbeat seconds, but got: {}", message));
 
 								break;
 							}
 
 							m_uHeartBeatInterval = std::chrono::seconds{ heartBeat };
-							m_tNextHeartBeat = time + m_uHeartBeatInterval;
 
 							dcclite::Log::Debug("[Throttle::ConnectState] Heartbeat set to {} (server requested)", m_uHeartBeatInterval);
 
@@ -501,7 +654,10 @@ class Throttle: public dcclite::Object, public dcclite::broker::shell::ln::IThro
 							//when the heartbeat arrives, we satisfy the config state
 							self.GotoConnectedState();
 
-							//we are dead now, so return...
+							//we are dead now, but lines that came on the same read are already queued on the messenger 
+							//and the socket will not be ready for them again, so let the connected state handle them
+							self.m_pclConnectedState->OnReady(self, SocketReactor::EVENT_READ, time);
+
 							return;
 						}
 						else if(!OnlineState::ParseMessage(self, message))						
@@ -510,6 +666,11 @@ class Throttle: public dcclite::Object, public dcclite::broker::shell::ln::IThro
 						}
 					}					
 				}
+
+				void OnTimeout(Throttle &self, const dcclite::Clock::TimePoint_t time) override
+				{
+					self.GotoProtocolTimeoutState("ConfiguringState");
+				}
 		};
 
 		struct ConnectedState: OnlineState
@@ -557,8 +718,15 @@ class Throttle: public dcclite::Object, public dcclite::broker::shell::ln::IThro
 					m_clMessenger.Send("MTA*<;>X");
 				}
 
-				void Update(Throttle &self, const dcclite::Clock::TimePoint_t time) override
+				void OnReady(Throttle &self, const uint32_t events, const dcclite::Clock::TimePoint_t time) override
 				{
+					if (!this->FlushOutput(events))
+					{
+						self.GotoConnectState();
+
+						return;
+					}
+
 					for(;;)
 					{
 						auto [status, message] = m_clMessenger.Poll();
@@ -584,6 +752,13 @@ class Throttle: public dcclite::Object, public dcclite::broker::shell::ln::IThro
 					
 				}
 
+				void OnTimeout(Throttle &self, const dcclite::Clock::TimePoint_t time) override
+				{
+					m_clMessenger.Send("*");
+
+					self.m_tThinker.Schedule(time + m_uHeartBeatInterval);
+				}
+
 				void OnAddSlave(const ILoconetSlot &slot)
 				{
 					this->RegisterLocomotive(slot);
@@ -632,6 +807,9 @@ class Throttle: public dcclite::Object, public dcclite::broker::shell::ln::IThro
 		const ILoconetSlot						&m_rclOwnerSlot;		
 
 		std::vector<const ILoconetSlot *> m_vecSlaves;
+
+		//protocol timeouts: connection / handshake timeout and then heartbeats
+		dcclite::broker::sys::Thinker			m_tThinker;
 };
 
 
@@ -664,19 +842,12 @@ namespace dcclite::broker::shell::ln
 			void ReleaseThrottle(IThrottle &throttle) override;
 
 		private:
-			void Think(const dcclite::Clock::TimePoint_t ticks);
-
-		private:
-			sys::Thinker m_tThinker;
-
 			dcclite::NetworkAddress m_clServerAddress;
-			unsigned int			m_uThrottleCount = 0;
 	};
 
 
 	ThrottleServiceImpl::ThrottleServiceImpl(RName name, sys::Broker &broker, const rapidjson::Value& params):
 		ThrottleService(name, broker, params),		
-		m_tThinker{"ThrottleServiceImpl::Thinker", THINKER_MF_LAMBDA(Think)},
 		m_clServerAddress{ dcclite::NetworkAddress::ParseAddress(DetermineServerAddress(params)) }
 	{				
 		dcclite::Log::Info("[ThrottleServiceImpl] Started, server at {}", m_clServerAddress);		
@@ -693,32 +864,12 @@ namespace dcclite::broker::shell::ln
 		ThrottleService::Serialize(stream);
 	}
 
-	void ThrottleServiceImpl::Think(const dcclite::Clock::TimePoint_t ticks)
-	{	
-		m_tThinker.Schedule(ticks + sys::THROTTLE_SERVICE_THINK_TIME);
-
-		this->VisitChildren([ticks](auto &item)
-			{
-				auto throttle = static_cast<Throttle *>(&item);
-
-				throttle->Update(ticks);
-
-				return true;
-			}
-		);		
-	}	
-
 	static sys::GenericServiceFactory<ThrottleServiceImpl> g_clThrottleServiceFactory;
 	
 	IThrottle &ThrottleServiceImpl::CreateThrottle(const ILoconetSlot &owner)
 	{
 		auto throttle = dynamic_cast<IThrottle *>(this->AddChild(std::make_unique<Throttle>(this->m_clServerAddress, owner )));
 
-		if (!m_tThinker.IsScheduled())
-			m_tThinker.Schedule({});
-
-		++m_uThrottleCount;
-
 		return *throttle;
 	}
 
@@ -726,13 +877,11 @@ namespace dcclite::broker::shell::ln
 	{
 		auto &t = dynamic_cast<Throttle &>(throttle);
 		this->RemoveChild(t.GetName());		
+	}
 
-		--m_uThrottleCount;
-		if (!m_uThrottleCount)
-		{
-			//nothing else to do... so go to sleep
-			m_tThinker.Cancel();
-		}
+	std::unique_ptr<IThrottle> MakeThrottle(const dcclite::NetworkAddress &serverAddress, const ILoconetSlot &owner)
+	{
+		return std::make_unique<Throttle>(serverAddress, owner);
 	}
 
 	//
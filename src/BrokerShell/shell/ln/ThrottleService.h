@@ -11,10 +11,17 @@
 
 #pragma once
 
+#include <memory>
+
 #include "exec/dcc/Address.h"
 
 #include "sys/Service.h"
 
+namespace dcclite
+{
+	class NetworkAddress;
+}
+
 namespace dcclite::broker::shell::ln
 { 
 	class ILoconetSlot;
@@ -38,7 +45,26 @@ namespace dcclite::broker::shell::ln
 	};
 
 
-	class ThrottleService: public sys::Service
+	/**
+	* What LoconetController needs from ThrottleService, so it can run without a broker (like on tests)
+	*/
+	class IThrottleProvider
+	{
+		public:
+			virtual ~IThrottleProvider() = default;
+
+			virtual IThrottle &CreateThrottle(const ILoconetSlot &owner) = 0;
+
+			virtual void ReleaseThrottle(IThrottle &throttle) = 0;
+	};
+
+	/**
+	* Creates a throttle that is not owned by a ThrottleService, for tests and benchmarks
+	*/
+	std::unique_ptr<IThrottle> MakeThrottle(const dcclite::NetworkAddress &serverAddress, const ILoconetSlot &owner);
+
+
+	class ThrottleService: public sys::Service, public IThrottleProvider
 	{	
 		public:
 			static const char *TYPE_NAME;
@@ -49,14 +75,6 @@ namespace dcclite::broker::shell::ln
 		
 			~ThrottleService() override = default;
 
-			//
-			// Main interface
-			//
-
-			virtual IThrottle &CreateThrottle(const ILoconetSlot &owner) = 0;
-
-			virtual void ReleaseThrottle(IThrottle &throttle) = 0;
-
 			//
 			//
 			//			
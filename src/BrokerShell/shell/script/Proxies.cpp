@@ -26,6 +26,8 @@
 
 #include "../dispatcher/DispatcherService_detail.h"
 
+#include "TaskScheduler.h"
+
 using Dispatcher = dcclite::broker::shell::dispatcher::detail::DispatcherServiceScripter;
 
 /******************************************************************************
@@ -106,11 +108,11 @@ class DecoderProxy
 			}
 		}
 
-		void SetAspect(dcclite::SignalAspects aspect, std::string requester, std::string reason)
+		void SetAspect(dcclite::SignalAspects aspect, std::string_view requester, std::string_view reason)
 		{
 			auto decoder = DynamicDecoderCast<dcclite::broker::exec::dcc::SignalDecoder>();
 
-			decoder->SetAspect(aspect, std::move(requester), std::move(reason));
+			decoder->SetAspect(aspect, dcclite::RName{ requester }, reason);
 		}
 
 		dcclite::SignalAspects GetAspect()
@@ -120,6 +122,11 @@ class DecoderProxy
 			return decoder->GetAspect();
 		}
 
+		inline dcclite::broker::exec::dcc::RemoteDecoder &GetRemoteDecoder()
+		{
+			return *DynamicDecoderCast<dcclite::broker::exec::dcc::RemoteDecoder>();
+		}
+
 	private:
 		void RegisterCallback(sol::function callBack)
 		{
@@ -295,6 +302,16 @@ namespace dcclite::broker::shell::script::detail
 			"aspect", sol::property(&DecoderProxy::GetAspect)
 		);
 
+		state.new_usertype<TaskScheduler>(
+			"task_scheduler", sol::no_constructor,
+			"sleep", &TaskScheduler::Sleep,
+			"wait_for", [](TaskScheduler &self, sol::main_object task, DecoderProxy &decoder, bool active, int timeoutMs)
+			{
+				return self.WaitFor(std::move(task), decoder.GetRemoteDecoder(), active ? dcclite::DecoderStates::ACTIVE : dcclite::DecoderStates::INACTIVE, timeoutMs);
+			},
+			"pending_tasks", sol::property(&TaskScheduler::GetPendingTasksCount)
+		);
+
 		state.new_enum<dcclite::SignalAspects>(
 			"SignalAspects",
 			{
@@ -57,6 +57,7 @@ namespace dcclite::broker::shell::script
 		dcclite::Log::Trace("[ScriptService::Start] Opening lua libraries");
 
 		m_clLua.open_libraries(sol::lib::base);
+		m_clLua.open_libraries(sol::lib::coroutine);
 		m_clLua.open_libraries(sol::lib::string);
 		m_clLua.open_libraries(sol::lib::table);
 
@@ -142,6 +143,54 @@ namespace dcclite::broker::shell::script
 		dcclite::Log::Trace("[ScriptService::Start] Exporting types");
 
 		detail::AddTypes(m_clLua);
+
+		dcclite::Log::Trace("[ScriptService::Start] Exporting tasks");
+
+		m_clLua["dcclite_tasks"] = std::ref(m_clTasks);
+
+		m_clLua.script(
+			R"LUA(
+				function dcclite_resume_task(task, ...)
+					local ok, err = coroutine.resume(task, ...)
+					if not ok then
+						log_error("task failed: " .. tostring(err))
+					end
+				end
+
+				local function get_current_task(caller)
+					local task, main = coroutine.running()
+					if main then
+						error(caller .. " must be called from a task, use dcclite.spawn")
+					end
+
+					return task
+				end
+
+				function dcclite.spawn(func, ...)
+					local task = coroutine.create(func)
+
+					dcclite_resume_task(task, ...)
+
+					return task
+				end
+
+				function dcclite.sleep(ms)
+					dcclite_tasks:sleep(get_current_task("dcclite.sleep"), ms)
+
+					return coroutine.yield()
+				end
+
+				function dcclite.wait_for(decoder, state, timeout)
+					if dcclite_tasks:wait_for(get_current_task("dcclite.wait_for"), decoder, state, timeout or -1) then
+						return true
+					end
+
+					return coroutine.yield()
+				end
+			)LUA"
+		);
+
+		m_clTasks.Start(m_clLua);
 		
 		dcclite::Log::Trace("[ScriptService::Start] Registering file monitor");
 
@@ -229,6 +278,9 @@ namespace dcclite::broker::shell::script
 		//Some services need to do a clenup first... let they know VM is going down
 		m_clLua.script("run_finalizers()");
 
+		//suspended tasks cannot survive the VM
+		m_clTasks.Stop();
+
 		//force destruction
 		m_clLua = {};	
 
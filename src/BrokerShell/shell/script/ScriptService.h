@@ -19,6 +19,8 @@
 
 #include "sys/Service.h"
 
+#include "TaskScheduler.h"
+
 namespace dcclite::broker::sys
 {	
 	class Broker;
@@ -53,6 +55,9 @@ namespace dcclite::broker::shell::script
 			sol::state						m_clLua;
 			std::set< dcclite::fs::path>	m_setScripts;
 
+			//must be declared after m_clLua, it holds references to the VM
+			TaskScheduler					m_clTasks;
+
 			bool							m_fConfigured = false;
 	};
 }
@@ -0,0 +1,154 @@
+// Copyright (C) 2023 - Bruno Sanches. See the COPYRIGHT
+// file at the top-level directory of this distribution.
+//
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+//
+// This Source Code Form is "Incompatible With Secondary Licenses", as
+// defined by the Mozilla Public License, v. 2.0.
+
+#include "TaskScheduler.h"
+
+#include <algorithm>
+#include <chrono>
+#include <stdexcept>
+
+#include <magic_enum/magic_enum.hpp>
+
+#include <dcclite/FmtUtils.h>
+#include <dcclite/Log.h>
+
+#include "exec/dcc/RemoteDecoder.h"
+
+namespace dcclite::broker::shell::script
+{
+	TaskScheduler::Waiter::Waiter(TaskScheduler &owner):
+		m_clThinker{ "ScriptService::TaskScheduler::Waiter", [this, &owner](const sys::Thinker::TimePoint_t) { owner.OnThink(*this); } }
+	{
+		//empty
+	}
+
+	TaskScheduler::~TaskScheduler()
+	{
+		this->Stop();
+	}
+
+	void TaskScheduler::Start(sol::state &state)
+	{
+		m_clResumeProc = state["dcclite_resume_task"];
+	}
+
+	void TaskScheduler::Stop()
+	{
+		const auto pendingTasks = this->GetPendingTasksCount();
+		if (pendingTasks)
+		{
+			dcclite::Log::Warn("[ScriptService::TaskScheduler::Stop] Dropping {} pending tasks", pendingTasks);
+		}
+
+		//make sure no thinker or signal is still pointing to us
+		m_vecFreeList.clear();
+		m_vecPool.clear();
+
+		m_clResumeProc = sol::lua_nil;
+	}
+
+	TaskScheduler::Waiter &TaskScheduler::AcquireWaiter(sol::main_object task)
+	{
+		if (!task.is<sol::thread>())
+		{
+			throw std::invalid_argument("[ScriptService::TaskScheduler] Only coroutines can be suspended, use dcclite.spawn to create a task");
+		}
+
+		Waiter *waiter;
+		if (m_vecFreeList.empty())
+		{
+			m_vecPool.push_back(std::make_unique<Waiter>(*this));
+			waiter = m_vecPool.back().get();
+		}
+		else
+		{
+			waiter = m_vecFreeList.back();
+			m_vecFreeList.pop_back();
+		}
+
+		waiter->m_clTask = std::move(task);
+
+		return *waiter;
+	}
+
+	void TaskScheduler::ReleaseWaiter(Waiter &waiter)
+	{
+		waiter.m_clThinker.Cancel();
+		waiter.m_slotStateSync.disconnect();
+		waiter.m_slotDestroyed.disconnect();
+		waiter.m_clTask = sol::lua_nil;
+
+		m_vecFreeList.push_back(&waiter);
+	}
+
+	void TaskScheduler::Resume(Waiter &waiter, bool result)
+	{
+		//release the waiter first, the task may suspend itself again while running
+		auto task = std::move(waiter.m_clTask);
+		this->ReleaseWaiter(waiter);
+
+		auto r = m_clResumeProc(task, result);
+		if (!r.valid())
+		{
+			sol::error err = r;
+
+			dcclite::Log::Error("[ScriptService::TaskScheduler::Resume] Call failed with result: {} - {}", magic_enum::enum_name(r.status()), err.what());
+		}
+	}
+
+	void TaskScheduler::Sleep(sol::main_object task, int ms)
+	{
+		auto &waiter = this->AcquireWaiter(std::move(task));
+
+		waiter.m_fTimeoutResult = true;
+		waiter.m_clThinker.Schedule(dcclite::Clock::DefaultClock_t::now() + std::chrono::milliseconds{ std::max(ms, 0) });
+	}
+
+	bool TaskScheduler::WaitFor(sol::main_object task, exec::dcc::RemoteDecoder &decoder, dcclite::DecoderStates state, int timeoutMs)
+	{
+		if (decoder.GetState() == state)
+			return true;
+
+		auto &waiter = this->AcquireWaiter(std::move(task));
+
+		waiter.m_fTimeoutResult = false;
+		waiter.m_kExpectedState = state;
+		waiter.m_slotStateSync = decoder.m_sigRemoteStateSync.connect([this, &waiter](exec::dcc::RemoteDecoder &decoder) { this->OnStateSync(waiter, decoder); });
+		waiter.m_slotDestroyed = decoder.m_sigRemoteDestroyed.connect([this, &waiter](exec::dcc::RemoteDecoder &) { this->OnDecoderDestroyed(waiter); });
+
+		if (timeoutMs >= 0)
+			waiter.m_clThinker.Schedule(dcclite::Clock::DefaultClock_t::now() + std::chrono::milliseconds{ timeoutMs });
+
+		return false;
+	}
+
+	void TaskScheduler::OnThink(Waiter &waiter)
+	{
+		this->Resume(waiter, waiter.m_fTimeoutResult);
+	}
+
+	void TaskScheduler::OnStateSync(Waiter &waiter, exec::dcc::RemoteDecoder &decoder)
+	{
+		if (decoder.GetState() != waiter.m_kExpectedState)
+			return;
+
+		this->Resume(waiter, true);
+	}
+
+	void TaskScheduler::OnDecoderDestroyed(Waiter &waiter)
+	{
+		waiter.m_slotStateSync.disconnect();
+		waiter.m_slotDestroyed.disconnect();
+
+		//do not run the script while the decoder is being destroyed, resume it with false on the next think
+		waiter.m_fTimeoutResult = false;
+		waiter.m_clThinker.Schedule(dcclite::Clock::DefaultClock_t::now());
+	}
+}
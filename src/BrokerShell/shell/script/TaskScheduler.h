@@ -0,0 +1,111 @@
+// Copyright (C) 2023 - Bruno Sanches. See the COPYRIGHT
+// file at the top-level directory of this distribution.
+//
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+//
+// This Source Code Form is "Incompatible With Secondary Licenses", as
+// defined by the Mozilla Public License, v. 2.0.
+
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include <sigslot/signal.hpp>
+
+#include <sol/sol.hpp>
+
+#include <dcclite_shared/SharedLibDefs.h>
+
+#include "sys/Thinker.h"
+
+namespace dcclite::broker::exec::dcc
+{
+	class RemoteDecoder;
+}
+
+namespace dcclite::broker::shell::script
+{
+	/**
+	*
+	* Keeps track of suspended script tasks (lua coroutines)
+	*
+	* A task suspends itself by calling dcclite.sleep or dcclite.wait_for, the scheduler stores the coroutine on a
+	* waiter and resumes it when the waiter thinker expires or when the watched decoder reaches the expected state.
+	*
+	* Waiters are pooled and never freed while the VM is running, so thousands of tasks can be suspended without
+	* allocations on the hot path and without any kind of polling.
+	*
+	*/
+	class TaskScheduler
+	{
+		public:
+			TaskScheduler() = default;
+			~TaskScheduler();
+
+			TaskScheduler(const TaskScheduler &) = delete;
+			TaskScheduler(TaskScheduler &&) = delete;
+
+			TaskScheduler &operator=(const TaskScheduler &) = delete;
+			TaskScheduler &operator=(TaskScheduler &&) = delete;
+
+			/**
+			* Must be called after the VM exported the task helpers (dcclite_resume_task)
+			*/
+			void Start(sol::state &state);
+
+			/**
+			* Cancel all pending tasks, they will never be resumed
+			*/
+			void Stop();
+
+			void Sleep(sol::main_object task, int ms);
+
+			/**
+			* Returns true if the decoder is already on the requested state, on that case the task is not suspended
+			*
+			* If timeoutMs is negative, waits forever. If the decoder is destroyed, the task is resumed with false
+			*/
+			bool WaitFor(sol::main_object task, exec::dcc::RemoteDecoder &decoder, dcclite::DecoderStates state, int timeoutMs);
+
+			inline size_t GetPendingTasksCount() const noexcept
+			{
+				return m_vecPool.size() - m_vecFreeList.size();
+			}
+
+		private:
+			struct Waiter
+			{
+				explicit Waiter(TaskScheduler &owner);
+
+				sys::Thinker				m_clThinker;
+
+				sol::main_object			m_clTask;
+
+				sigslot::scoped_connection	m_slotStateSync;
+				sigslot::scoped_connection	m_slotDestroyed;
+
+				dcclite::DecoderStates		m_kExpectedState = dcclite::DecoderStates::INACTIVE;
+
+				//value returned to the script when the thinker fires
+				bool						m_fTimeoutResult = true;
+			};
+
+			Waiter &AcquireWaiter(sol::main_object task);
+			void ReleaseWaiter(Waiter &waiter);
+
+			void Resume(Waiter &waiter, bool result);
+
+			void OnThink(Waiter &waiter);
+			void OnStateSync(Waiter &waiter, exec::dcc::RemoteDecoder &decoder);
+			void OnDecoderDestroyed(Waiter &waiter);
+
+		private:
+			std::vector<std::unique_ptr<Waiter>>	m_vecPool;
+			std::vector<Waiter *>					m_vecFreeList;
+
+			sol::main_protected_function			m_clResumeProc;
+	};
+}
@@ -12,6 +12,7 @@
 
 #include <fstream>
 #include <future>
+#include <optional>
 
 #include <fmt/format.h>
 
@@ -21,6 +22,7 @@
 
 #include <exec/dcc/DccLiteService.h>
 #include <exec/dcc/IResettableObject.h>
+#include <exec/dcc/ItemQuery.h>
 #include <exec/dcc/NetworkDevice.h>
 #include <exec/dcc/OutputDecoder.h>
 #include <exec/dcc/SignalDecoder.h>
@@ -33,6 +35,7 @@
 #include "DeviceNetworkTestCmds.h"
 #include "DeviceRenameCmd.h"
 #include "ServoProgrammerCmds.h"
+#include "SetItemsCmd.h"
 #include "TerminalCmd.h"
 #include "TerminalContext.h"
 #include "TerminalUtils.h"
@@ -86,7 +89,7 @@ class ResetItemCmd : public TerminalCmd
 			dcclite::Log::Info("[ResetCmd] Resetting {}.", itemPath);
 			ireset->Reset();
 
-			return MakeRpcResultMessage(id, [](Result_t &results)
+			return MakeRpcResultMessage(context, id, [](Result_t &results)
 				{
 					results.AddStringValue("classname", "string");
 					results.AddStringValue("msg", "OK");
@@ -123,7 +126,7 @@ class RebootDeviceCmd : public TerminalCmd
 
 			device.ResetRemoteDevice();
 
-			return MakeRpcResultMessage(id, [](Result_t &results)
+			return MakeRpcResultMessage(context, id, [](Result_t &results)
 				{
 					results.AddStringValue("classname", "string");
 					results.AddStringValue("msg", "OK");
@@ -160,7 +163,7 @@ class DisconnectDeviceCmd : public TerminalCmd
 
 			device.DisconnectDevice();
 
-			return MakeRpcResultMessage(id, [](Result_t &results)
+			return MakeRpcResultMessage(context, id, [](Result_t &results)
 				{
 					results.AddStringValue("classname", "string");
 					results.AddStringValue("msg", "OK");
@@ -197,7 +200,7 @@ class BlockDeviceCmd : public TerminalCmd
 
 			device.Block();
 
-			return MakeRpcResultMessage(id, [](Result_t &results)
+			return MakeRpcResultMessage(context, id, [](Result_t &results)
 				{
 					results.AddStringValue("classname", "string");
 					results.AddStringValue("msg", "OK");
@@ -246,7 +249,7 @@ class ClearDccLiteBlockListCmd : public TerminalCmd
 
 			dccLiteService->ClearBlockList();
 
-			return MakeRpcResultMessage(id, [](Result_t &results)
+			return MakeRpcResultMessage(context, id, [](Result_t &results)
 				{
 					results.AddStringValue("classname", "string");
 					results.AddStringValue("msg", "OK");
@@ -334,7 +337,7 @@ class ActivateItemCmd : public DecoderCmdBase
 
 			outputDecoder->Activate("ActivateItemCmd");
 
-			return MakeRpcResultMessage(id, [](Result_t &results)
+			return MakeRpcResultMessage(context, id, [](Result_t &results)
 				{
 					results.AddStringValue("classname", "string");
 					results.AddStringValue("msg", "OK");
@@ -363,7 +366,7 @@ class DeactivateItemCmd : public DecoderCmdBase
 
 			outputDecoder->Deactivate("DeactivateItemCmd");
 
-			return MakeRpcResultMessage(id, [](Result_t &results)
+			return MakeRpcResultMessage(context, id, [](Result_t &results)
 				{
 					results.AddStringValue("classname", "string");
 					results.AddStringValue("msg", "OK");
@@ -392,7 +395,7 @@ class SwitchItemCmd : public DecoderCmdBase
 
 			outputDecoder->ToggleState("SwitchItemCmd");
 
-			return MakeRpcResultMessage(id, [outputDecoder](Result_t &results)
+			return MakeRpcResultMessage(context, id, [outputDecoder](Result_t &results)
 				{
 					results.AddStringValue("classname", "string");
 					results.AddStringValue("msg", fmt::format("OK: {}", dcclite::DecoderStateName(outputDecoder->GetRequestedState())));
@@ -438,9 +441,9 @@ class SetAspectCmd : public DecoderCmdBase
 				throw TerminalCmdException(fmt::format("Invalid aspect name {}", aspectName), id);
 			}
 
-			signalDecoder->SetAspect(aspect.value(), this->GetName().GetData().data(), "Json proc");
+			signalDecoder->SetAspect(aspect.value(), this->GetName(), "Json proc");
 
-			return MakeRpcResultMessage(id, [aspectName](Result_t &results)
+			return MakeRpcResultMessage(context, id, [aspectName](Result_t &results)
 				{
 					results.AddStringValue("classname", "string");
 					results.AddStringValue("msg", fmt::format("OK: {}", aspectName));
@@ -449,6 +452,118 @@ class SetAspectCmd : public DecoderCmdBase
 		}
 };
 
+/////////////////////////////////////////////////////////////////////////////
+//
+// QueryItemsCmd
+//
+/////////////////////////////////////////////////////////////////////////////
+
+/**
+* Usage: Query-Items <query> [location] [fields]
+* 
+* Returns only the items below location (default is the current location) that match the query, see exec::dcc::ItemQuery for the syntax, ie:
+*	Query-Items "input state=active"
+*	Query-Items "turnout device=yard !state=active" /DCCLite
+* 
+* fields is an optional array of field names, when present only those fields are sent for each item
+*/
+class QueryItemsCmd : public TerminalCmd
+{
+	public:
+		explicit QueryItemsCmd(RName name = RName{ "Query-Items" }) :
+			TerminalCmd(name)
+		{
+			//empty
+		}
+
+		CmdResult_t Run(TerminalContext &context, const CmdId_t id, const rapidjson::Document &request) override
+		{
+			auto paramsIt = request.FindMember("params");
+			if ((paramsIt == request.MemberEnd()) || (!paramsIt->value.IsArray()) || (paramsIt->value.Empty()) || !paramsIt->value[0].IsString())
+			{
+				throw TerminalCmdException(fmt::format("Usage: {} <query> [location] [fields]", this->GetName()), id);
+			}
+
+			const auto &params = paramsIt->value;
+
+			std::optional<exec::dcc::ItemQuery> query;
+			try
+			{
+				query = exec::dcc::ItemQuery::Parse(params[0].GetString());
+			}
+			catch (std::invalid_argument &ex)
+			{
+				throw TerminalCmdException(fmt::format("{}: {}", this->GetName(), ex.what()), id);
+			}
+
+			IObject *location = &GetCurrentFolder(context, id);
+
+			if ((params.Size() > 1) && params[1].IsString())
+			{
+				location = static_cast<IFolderObject *>(location)->TryNavigate(Path_t{ params[1].GetString() });
+				if (!location || !location->IsFolder())
+				{
+					throw TerminalCmdException(fmt::format("{}: invalid location {}", this->GetName(), params[1].GetString()), id);
+				}
+			}
+
+			std::vector<std::string> fields;
+			if (params.Size() > 2)
+			{
+				if (!params[2].IsArray())
+					throw TerminalCmdException(fmt::format("{}: fields must be an array", this->GetName()), id);
+
+				for (const auto &field : params[2].GetArray())
+				{
+					if (!field.IsString())
+						throw TerminalCmdException(fmt::format("{}: fields must be strings", this->GetName()), id);
+
+					fields.emplace_back(field.GetString());
+				}
+			}
+
+			return MakeRpcResultMessage(context, id, [location, &query, &fields](Result_t &results)
+				{
+					results.AddStringValue("classname", "QueryResult");
+					results.AddStringValue("location", location->GetPath().string());
+
+					int64_t count = 0;
+					{
+						auto dataArray = results.AddArray("items");
+
+						auto writeItem = [&dataArray, &fields, &count](const IObject &item)
+						{
+							if (fields.empty())
+							{
+								auto itemObject = dataArray.AddObject();
+								item.Serialize(itemObject);
+							}
+							else
+							{
+								ProjectionDataWriter projection{ dataArray.GetWriter(), fields };
+
+								ObjectOutputStream itemObject{ projection };
+								item.Serialize(itemObject);
+							}
+
+							++count;
+
+							return true;
+						};
+
+						//the service knows its decoders, so it does not need to walk everything
+						if (auto service = dynamic_cast<exec::dcc::DccLiteService *>(location))
+							query->Run(*service, writeItem);
+						else
+							query->Run(*static_cast<IFolderObject *>(location), writeItem);
+					}
+
+					results.AddIntValue("count", count);
+				}
+			);
+		}
+};
+
 /////////////////////////////////////////////////////////////////////////////
 //
 // ReadEEPromCmd
@@ -489,7 +604,7 @@ class ReadEEPromFiber : public TerminalCmdFiber, private exec::dcc::NetworkTask:
 
 			if (m_spTask->HasFailed())
 			{
-				m_rclContext.SendClientNotification(MakeRpcErrorResponse(m_tCmdId, fmt::format("Download task failed: {}", m_spTask->GetMessage())));
+				m_rclContext.SendClientNotification(MakeRpcErrorResponse(m_rclContext, m_tCmdId, fmt::format("Download task failed: {}", m_spTask->GetMessage())));
 
 				//suicide, we are useless now
 				m_rclContext.DestroyFiber(*this);
@@ -524,7 +639,7 @@ class ReadEEPromFiber : public TerminalCmdFiber, private exec::dcc::NetworkTask:
 
 		void OnSaveEEPromFinished()
 		{
-			auto msg = MakeRpcResultMessage(m_tCmdId, [this](Result_t &results)
+			auto msg = MakeRpcResultMessage(m_rclContext, m_tCmdId, [this](Result_t &results)
 				{
 					results.AddStringValue("classname", "ReadEEPromResult");
 					results.AddStringValue("filepath", m_pathRomFileName.string());
@@ -622,6 +737,14 @@ namespace dcclite::broker::shell::terminal
 			cmdHost.AddCmd(std::make_unique<SetAspectCmd>());
 		}
 
+		{
+			cmdHost.AddCmd(std::make_unique<SetItemsCmd>());
+		}
+
+		{
+			cmdHost.AddCmd(std::make_unique<QueryItemsCmd>());
+		}
+
 		{
 			cmdHost.AddCmd(std::make_unique<ReadEEPromCmd>());
 		}
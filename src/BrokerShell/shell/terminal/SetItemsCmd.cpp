@@ -0,0 +1,107 @@
+// Copyright (C) 2019 - Bruno Sanches. See the COPYRIGHT
+// file at the top-level directory of this distribution.
+// 
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+// 
+// This Source Code Form is "Incompatible With Secondary Licenses", as
+// defined by the Mozilla Public License, v. 2.0.
+
+#include "SetItemsCmd.h"
+
+#include <utility>
+#include <vector>
+
+#include <fmt/format.h>
+
+#include <dcclite/FmtUtils.h>
+
+#include "exec/dcc/OutputDecoder.h"
+#include "exec/dcc/OutputDecoderBatch.h"
+#include "exec/dcc/SignalDecoder.h"
+
+#include "TerminalContext.h"
+#include "TerminalUtils.h"
+
+namespace dcclite::broker::shell::terminal
+{	
+	TerminalCmd::CmdResult_t SetItemsCmd::Run(TerminalContext &context, const CmdId_t id, const rapidjson::Document &request)
+	{
+		auto paramsIt = request.FindMember("params");
+		if ((paramsIt == request.MemberEnd()) || (!paramsIt->value.IsArray()) || (paramsIt->value.Empty()))
+		{
+			throw TerminalCmdException(fmt::format("Usage: {} [{{\"path\": <decoder_path>, \"state\": <active|inactive|aspect>}}, ...]", this->GetName()), id);
+		}
+
+		auto &folder = detail::GetCurrentFolder(context, id);
+
+		exec::dcc::OutputDecoderBatch outputs;
+		std::vector<std::pair<exec::dcc::SignalDecoder *, dcclite::SignalAspects>> signals;
+
+		unsigned index = 0;
+		for (const auto &item : paramsIt->value.GetArray())
+		{
+			auto pathIt = item.IsObject() ? item.FindMember("path") : item.MemberEnd();
+			auto stateIt = item.IsObject() ? item.FindMember("state") : item.MemberEnd();
+
+			if ((pathIt == item.MemberEnd()) || !pathIt->value.IsString() || (stateIt == item.MemberEnd()) || !stateIt->value.IsString())
+			{
+				throw TerminalCmdException(fmt::format("Item {} must be an object with path and state strings", index), id);
+			}
+
+			auto path = Path_t{ pathIt->value.GetString() };
+			const std::string_view state = stateIt->value.GetString();
+
+			auto obj = folder.TryNavigate(path);
+			if (obj == nullptr)
+			{
+				throw TerminalCmdException(fmt::format("Item {}: decoder not found: {}", index, path.string()), id);
+			}
+
+			if (auto outputDecoder = dynamic_cast<exec::dcc::OutputDecoder *>(obj))
+			{
+				//the decoder would refuse it anyway, but only after the others were applied
+				if (outputDecoder->IsLocked())
+					throw TerminalCmdException(fmt::format("Item {}: output decoder {} is locked by {}", index, path.string(), outputDecoder->GetLockOwner()), id);
+
+				if ((state == "active") || (state == dcclite::DecoderStateName(dcclite::DecoderStates::ACTIVE)))
+					outputs.Add(*outputDecoder, dcclite::DecoderStates::ACTIVE);
+				else if ((state == "inactive") || (state == dcclite::DecoderStateName(dcclite::DecoderStates::INACTIVE)))
+					outputs.Add(*outputDecoder, dcclite::DecoderStates::INACTIVE);
+				else
+					throw TerminalCmdException(fmt::format("Item {}: invalid state {} for output decoder {}, expected active or inactive", index, state, path.string()), id);
+			}
+			else if (auto signalDecoder = dynamic_cast<exec::dcc::SignalDecoder *>(obj))
+			{
+				auto aspect = dcclite::TryConvertNameToAspect(stateIt->value.GetString());
+				if (!aspect.has_value())
+				{
+					throw TerminalCmdException(fmt::format("Item {}: invalid aspect name {} for signal {}", index, state, path.string()), id);
+				}
+
+				signals.emplace_back(signalDecoder, aspect.value());
+			}
+			else
+			{
+				throw TerminalCmdException(fmt::format("Item {}: {} is not an output or signal decoder", index, path.string()), id);
+			}
+
+			++index;
+		}
+
+		//
+		//everything is valid, apply it
+		const auto numChanges = outputs.Apply("SetItemsCmd");
+
+		for (auto [signalDecoder, aspect] : signals)
+			signalDecoder->SetAspect(aspect, this->GetName(), "Json proc");
+
+		return MsgUtils::MakeRpcResultMessage(context, id, [numChanges, index](Result_t &results)
+			{
+				results.AddStringValue("classname", "string");
+				results.AddStringValue("msg", fmt::format("OK: {} items, {} outputs changed", index, numChanges));
+			}
+		);
+	}
+}
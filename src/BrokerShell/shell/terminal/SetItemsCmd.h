@@ -0,0 +1,34 @@
+// Copyright (C) 2019 - Bruno Sanches. See the COPYRIGHT
+// file at the top-level directory of this distribution.
+// 
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+// 
+// This Source Code Form is "Incompatible With Secondary Licenses", as
+// defined by the Mozilla Public License, v. 2.0.
+
+#pragma once
+
+#include "TerminalCmd.h"
+
+namespace dcclite::broker::shell::terminal
+{	
+	/**
+	* Usage: Set-Items [{"path": "<decoder_path>", "state": "<active|inactive|aspect name>"}, ...]
+	* 
+	* All items are validated before anything changes, so on error (like a locked output) no decoder is touched. Output decoders 
+	* are applied grouped by device, so each device sends all its changes on a single state packet.
+	*/
+	class SetItemsCmd: public TerminalCmd
+	{
+		public:
+			explicit SetItemsCmd(RName name = RName{ "Set-Items" }):
+				TerminalCmd(name)
+			{
+				//empty
+			}
+
+			CmdResult_t Run(TerminalContext &context, const CmdId_t id, const rapidjson::Document &request) override;
+	};
+}
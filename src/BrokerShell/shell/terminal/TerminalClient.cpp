@@ -13,6 +13,7 @@
 
 #include <magic_enum/magic_enum.hpp>
 
+#include <dcclite/Cbor.h>
 #include <dcclite/FmtUtils.h>
 #include <dcclite/Log.h>
 #include <dcclite/Util.h>
@@ -55,6 +56,13 @@ namespace dcclite::broker::shell::terminal
 	//
 	/////////////////////////////////////////////////////////////////////////////
 
+	static const sys::SubscriptionFilter &GetDefaultSubscription()
+	{
+		static const auto g_stDefaultFilter = sys::SubscriptionFilter::Parse("/*");
+
+		return g_stDefaultFilter;
+	}
+
 	TerminalClient::TerminalClient(
 		ITerminalServiceClientProxy &owner, 
 		CmdHostService &cmdHost,
@@ -72,7 +80,7 @@ namespace dcclite::broker::shell::terminal
 	{
 		m_clContext.SetLocation(currentLocation);
 
-		this->RegisterListeners();
+		m_rclOwner.Subscribe(*this, GetDefaultSubscription());
 
 		m_thReceiveThread = std::thread{ [this] {this->ReceiveDataThreadProc(); } };
 		dcclite::SetThreadName(m_thReceiveThread, "TerminalClient::ReceiveThread");
@@ -84,105 +92,72 @@ namespace dcclite::broker::shell::terminal
 
 		m_thReceiveThread.join();
 
-		m_rclBroker.VisitServices(
-			[this](auto &item)
-			{
-				auto *service = dynamic_cast<sys::Service *>(&item);
-				if (service != nullptr)
-					service->m_sigEvent.disconnect(this);
-
-				return true;
-			}
-		);
-
 		sys::EventHub::CancelEvents(*this);
 	}	
 
-	void TerminalClient::RegisterListeners()
+	TaskManager &TerminalClient::GetTaskManager()
 	{
-		m_rclBroker.VisitServices(
-			[this](auto &item)
-			{
-				auto *service = dynamic_cast<sys::Service *>(&item);
-
-				if (service != nullptr)
-				{
-					service->m_sigEvent.connect(&TerminalClient::OnObjectManagerEvent, this);
-				}
-				else
-				{
-					dcclite::Log::Warn("[TerminalClient::RegisterListeners] Object {} is not a service, it is {}", item.GetName(), item.GetTypeName());
-				}
-
-				return true;
-			}
-		);
+		return m_clTaskManager;
 	}
 
-	void TerminalClient::SendItemPropertyValueChangedNotification(const sys::ObjectManagerEvent &event)
+	void TerminalClient::SendClientNotification(const std::string_view msg)
 	{
-		m_clMessenger.Send(
-			m_clAddress,
-			MsgUtils::MakeRpcNotificationMessage(
-				-1,
-				"On-ItemPropertyValueChanged",
-				[&event](JsonOutputStream_t &params)
-				{
-					event.m_pfnSerializeDeltaProc ? event.m_pfnSerializeDeltaProc(params) : event.m_rclItem.Serialize(params);
-				}
-			)
-		);
+		if (!m_clMessenger.Send(m_clAddress, msg))
+		{
+			dcclite::Log::Error("[TerminalClient::Update] fiber result for {} not sent, contents: {}", m_clAddress.GetIpString(), m_kEncoding == TerminalEncoding::JSON ? msg : std::string_view{ "<binary>" });
+		}
 	}
 
-	void TerminalClient::OnObjectManagerEvent(const sys::ObjectManagerEvent &event)
+	void TerminalClient::SendNotification(const std::string_view msg)
 	{
-		switch (event.m_kType)
+		if (!m_clMessenger.Send(m_clAddress, msg))
 		{
-			case sys::ObjectManagerEvent::ITEM_CHANGED:
-				SendItemPropertyValueChangedNotification(event);
-				break;
+			dcclite::Log::Error("[TerminalClient::SendNotification] notification for {} not sent", m_clAddress.GetIpString());
+		}
+	}
 
-			case sys::ObjectManagerEvent::ITEM_CREATED:
-				m_clMessenger.Send(
-					m_clAddress,
-					MsgUtils::MakeRpcNotificationMessage(
-						-1,
-						"On-ItemCreated",
-						[&event](JsonOutputStream_t &params)
-						{
-							event.m_rclItem.Serialize(params);
-						}
-					)
-				);
-				break;
+	void TerminalClient::Subscribe(const sys::SubscriptionFilter &filter)
+	{
+		if (m_fDefaultSubscription)
+		{
+			m_rclOwner.Unsubscribe(*this, GetDefaultSubscription());
 
-			case sys::ObjectManagerEvent::ITEM_DESTROYED:
-				m_clMessenger.Send(
-					m_clAddress,
-					MsgUtils::MakeRpcNotificationMessage(
-						-1,
-						"On-ItemDestroyed",
-						[&event](JsonOutputStream_t &params)
-						{
-							event.m_rclItem.Serialize(params);
-						}
-					)
-				);
-				break;
+			m_fDefaultSubscription = false;
 		}
+
+		m_rclOwner.Subscribe(*this, filter);
 	}
 
-	TaskManager &TerminalClient::GetTaskManager()
+	bool TerminalClient::Unsubscribe(const sys::SubscriptionFilter &filter)
 	{
-		return m_clTaskManager;
+		if (m_fDefaultSubscription && (filter == GetDefaultSubscription()))
+			m_fDefaultSubscription = false;
+
+		return m_rclOwner.Unsubscribe(*this, filter);
 	}
 
-	void TerminalClient::SendClientNotification(const std::string_view msg)
+	void TerminalClient::UnsubscribeAll()
 	{
-		if (!m_clMessenger.Send(m_clAddress, msg))
-		{
-			dcclite::Log::Error("[TerminalClient::Update] fiber result for {} not sent, contents: {}", m_clAddress.GetIpString(), msg);
-		}
+		m_rclOwner.UnsubscribeAll(*this);
+
+		m_fDefaultSubscription = false;
+	}
+
+	TerminalEncoding TerminalClient::GetEncoding() const noexcept
+	{
+		return m_kEncoding;
+	}
+
+	void TerminalClient::SetEncoding(const TerminalEncoding encoding)
+	{
+		m_kEncoding = encoding;
+
+		//
+		//binary messages may contain the separator, so switch to length prefixed frames
+		//this is done before the response is sent, so the receive thread is ready when the client starts sending new frames
+		m_clMessenger.SetFraming(encoding == TerminalEncoding::JSON ? NetMessenger::Framing::SEPARATOR : NetMessenger::Framing::LENGTH_PREFIX);
+
+		dcclite::Log::Info("[TerminalClient::SetEncoding] Client {} switched to {}", m_clAddress.GetIpString(), magic_enum::enum_name(encoding));
 	}
 
 	void TerminalClient::DestroyFiber(TerminalCmdFiber &fiber)
@@ -213,28 +188,44 @@ namespace dcclite::broker::shell::terminal
 		TerminalCmd::CmdResult_t result;
 
 		int cmdId = -1;
+
+		//binary messages are not logged or echoed back
+		const std::string_view msgDescription = m_kEncoding == TerminalEncoding::JSON ? std::string_view{ msg } : std::string_view{ "<binary>" };
 		try
 		{
 			//dcclite::Log::Trace("[TerminalClient::OnMsg] Got msg");
 
 			rapidjson::Document doc;
-			doc.Parse(msg.c_str());
+			if (m_kEncoding == TerminalEncoding::CBOR)
+			{
+				CborReader reader{ msg };
+				doc.Populate(reader);
 
-			if (doc.HasParseError())
+				if (!doc.IsObject())
+				{
+					throw TerminalCmdException("Invalid cbor message", -1);
+				}
+			}
+			else
 			{
-				throw TerminalCmdException(fmt::format("Invalid json: {}", msg), -1);
+				doc.Parse(msg.c_str());
+
+				if (doc.HasParseError())
+				{
+					throw TerminalCmdException(fmt::format("Invalid json: {}", msg), -1);
+				}
 			}
 
 			auto jsonrpcKey = doc.FindMember(MsgUtils::JSONRPC_KEY);
 			if ((jsonrpcKey == doc.MemberEnd()) || (!jsonrpcKey->value.IsString()) || (strcmp(jsonrpcKey->value.GetString(), MsgUtils::JSONRPC_VERSION)))
 			{
-				throw TerminalCmdException(fmt::format("Invalid rpc version or was not set: {}", msg), -1);
+				throw TerminalCmdException(fmt::format("Invalid rpc version or was not set: {}", msgDescription), -1);
 			}
 
 			auto idKey = doc.FindMember("id");
 			if ((idKey == doc.MemberEnd()) || (!idKey->value.IsInt()))
 			{
-				throw TerminalCmdException(fmt::format("No method id in: {}", msg), -1);
+				throw TerminalCmdException(fmt::format("No method id in: {}", msgDescription), -1);
 			}
 
 			cmdId = idKey->value.GetInt();
@@ -242,7 +233,7 @@ namespace dcclite::broker::shell::terminal
 			auto methodKey = doc.FindMember("method");
 			if ((methodKey == doc.MemberEnd()) || (!methodKey->value.IsString()))
 			{
-				throw TerminalCmdException(fmt::format("Invalid method name in msg: {}", msg), cmdId);
+				throw TerminalCmdException(fmt::format("Invalid method name in msg: {}", msgDescription), cmdId);
 			}
 
 			const auto methodName = RName::TryGetName(methodKey->value.GetString());
@@ -264,11 +255,11 @@ namespace dcclite::broker::shell::terminal
 		}
 		catch (TerminalCmdException &ex)
 		{
-			result = MsgUtils::MakeRpcErrorResponse(ex.GetId(), ex.what());
+			result = MsgUtils::MakeRpcErrorResponse(m_clContext, ex.GetId(), ex.what());
 		}
 		catch (std::exception &ex)
 		{
-			result = MsgUtils::MakeRpcErrorResponse(cmdId, ex.what());
+			result = MsgUtils::MakeRpcErrorResponse(m_clContext, cmdId, ex.what());
 		}
 
 		if (std::holds_alternative<std::string>(result))
@@ -276,7 +267,7 @@ namespace dcclite::broker::shell::terminal
 			auto const &response = std::get<std::string>(result);
 			if (!m_clMessenger.Send(m_clAddress, response))
 			{
-				dcclite::Log::Error("[TerminalClient::Update] message for {} not sent, contents: {}", m_clAddress.GetIpString(), response);
+				dcclite::Log::Error("[TerminalClient::Update] message for {} not sent, contents: {}", m_clAddress.GetIpString(), m_kEncoding == TerminalEncoding::JSON ? std::string_view{ response } : std::string_view{ "<binary>" });
 			}
 		}
 		else
@@ -50,7 +50,7 @@ namespace dcclite::broker::shell::terminal
 			std::map<uint32_t, std::shared_ptr<exec::dcc::NetworkTask>>	m_mapNetworkTasks;
 	};
 
-	class TerminalClient: private sys::IObjectManagerListener, ITerminalClient_ContextServices, sys::EventHub::IEventTarget
+	class TerminalClient: ITerminalClient_ContextServices, sys::EventHub::IEventTarget
 	{
 		public:
 			TerminalClient(
@@ -66,13 +66,14 @@ namespace dcclite::broker::shell::terminal
 
 			virtual ~TerminalClient();
 
-		private:
-			void OnObjectManagerEvent(const sys::ObjectManagerEvent &event) override;
-
-			void RegisterListeners();
+			TerminalEncoding GetEncoding() const noexcept override;
 
-			void SendItemPropertyValueChangedNotification(const sys::ObjectManagerEvent &event);
+			/**
+			* Sends an already encoded notification, msg must use the client encoding
+			*/
+			void SendNotification(const std::string_view msg);
 
+		private:
 			void ReceiveDataThreadProc();
 
 			void OnMsg(const std::string &msg);
@@ -86,9 +87,17 @@ namespace dcclite::broker::shell::terminal
 			TaskManager &GetTaskManager() override;
 			void SendClientNotification(const std::string_view msg) override;
 
+			void SetEncoding(const TerminalEncoding encoding) override;
+
+			void Subscribe(const sys::SubscriptionFilter &filter) override;
+			bool Unsubscribe(const sys::SubscriptionFilter &filter) override;
+			void UnsubscribeAll() override;
+
 			class MsgArrivedEvent: public sys::EventHub::IEvent
 			{
 				public:
+					static constexpr sys::EventHub::Lanes LANE = sys::EventHub::Lanes::TERMINAL;
+
 					MsgArrivedEvent(TerminalClient &target, std::string &&msg):
 						IEvent(target),
 						m_strMessage(msg)
@@ -120,5 +129,10 @@ namespace dcclite::broker::shell::terminal
 			std::thread										m_thReceiveThread;
 
 			const NetworkAddress	m_clAddress;
+
+			TerminalEncoding		m_kEncoding = TerminalEncoding::JSON;
+
+			//old clients do not know about subscriptions, so everyone starts listening to everything until a filter is set
+			bool					m_fDefaultSubscription = true;
 		};
 }
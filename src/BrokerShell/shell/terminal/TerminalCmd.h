@@ -109,7 +109,7 @@ namespace dcclite::broker::shell::terminal
 	class TerminalCmdFiber
 	{
 		public:
-			typedef JsonCreator::Object<JsonCreator::StringWriter> Result_t;
+			typedef dcclite::JsonOutputStream_t Result_t;
 
 		public:
 			TerminalCmdFiber(const CmdId_t id, TerminalContext &context) :
@@ -136,7 +136,7 @@ namespace dcclite::broker::shell::terminal
 	class TerminalCmd: public dcclite::Object
 	{
 		public:
-			typedef JsonCreator::Object<JsonCreator::StringWriter> Result_t;
+			typedef dcclite::JsonOutputStream_t Result_t;
 			typedef std::variant<std::string, std::unique_ptr<TerminalCmdFiber>> CmdResult_t;
 
 		public:
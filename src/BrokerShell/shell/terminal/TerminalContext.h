@@ -12,6 +12,8 @@
 
 #include <dcclite/Object.h>
 
+#include "sys/SubscriptionIndex.h"
+
 namespace dcclite
 {
 	class IFolderObject;
@@ -22,6 +24,16 @@ namespace dcclite::broker::shell::terminal
 	class TerminalCmdFiber;
 	class TaskManager;
 
+	/**
+	* How rpc messages are encoded on the wire, json is always the default, binary encodings must be requested
+	* by the client using Set-Encoding
+	*/
+	enum class TerminalEncoding
+	{
+		JSON,
+		CBOR
+	};
+
 	class ITerminalClient_ContextServices
 	{
 		public:
@@ -29,6 +41,13 @@ namespace dcclite::broker::shell::terminal
 			virtual void SendClientNotification(const std::string_view msg) = 0;
 
 			virtual void DestroyFiber(TerminalCmdFiber &fiber) = 0;
+
+			virtual TerminalEncoding GetEncoding() const noexcept = 0;
+			virtual void SetEncoding(const TerminalEncoding encoding) = 0;
+
+			virtual void Subscribe(const sys::SubscriptionFilter &filter) = 0;
+			virtual bool Unsubscribe(const sys::SubscriptionFilter &filter) = 0;
+			virtual void UnsubscribeAll() = 0;
 	};
 
 	/**
@@ -70,6 +89,37 @@ namespace dcclite::broker::shell::terminal
 				m_rclTerminalClientServices.DestroyFiber(fiber);
 			}
 
+			inline TerminalEncoding GetEncoding() const noexcept
+			{
+				return m_rclTerminalClientServices.GetEncoding();
+			}
+
+			/**
+			* Any message sent or received after this call uses the new encoding
+			*/
+			inline void SetEncoding(const TerminalEncoding encoding)
+			{
+				m_rclTerminalClientServices.SetEncoding(encoding);
+			}
+
+			/**
+			* Clients start subscribed to everything, the first call replaces that with the given filter
+			*/
+			inline void Subscribe(const sys::SubscriptionFilter &filter)
+			{
+				m_rclTerminalClientServices.Subscribe(filter);
+			}
+
+			inline bool Unsubscribe(const sys::SubscriptionFilter &filter)
+			{
+				return m_rclTerminalClientServices.Unsubscribe(filter);
+			}
+
+			inline void UnsubscribeAll()
+			{
+				m_rclTerminalClientServices.UnsubscribeAll();
+			}
+
 			/**
 
 				returns:
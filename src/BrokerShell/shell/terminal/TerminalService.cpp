@@ -11,6 +11,7 @@
 
 #include "TerminalService.h"
 
+#include <dcclite/Guid.h>
 #include <dcclite/Util.h>
 
 #include <sys/BonjourService.h>
@@ -20,6 +21,7 @@
 #include "CmdHostService.h"
 #include "TerminalClient.h"
 #include "TerminalServiceCmds.h"
+#include "TerminalUtils.h"
 
 namespace dcclite::broker::shell::terminal
 {
@@ -35,6 +37,8 @@ namespace dcclite::broker::shell::terminal
 	class TerminalServiceAcceptConnectionEvent: public sys::EventHub::IEvent
 	{
 		public:
+			static constexpr sys::EventHub::Lanes LANE = sys::EventHub::Lanes::TERMINAL;
+
 			TerminalServiceAcceptConnectionEvent(TerminalService &target, const dcclite::NetworkAddress &address, Socket s):
 				IEvent(target),
 				m_clSocket{ std::move(s) },
@@ -57,6 +61,8 @@ namespace dcclite::broker::shell::terminal
 	class TerminalServiceClientDisconnectedEvent: public sys::EventHub::IEvent
 	{
 		public:
+			static constexpr sys::EventHub::Lanes LANE = sys::EventHub::Lanes::TERMINAL;
+
 			TerminalServiceClientDisconnectedEvent(TerminalService &target, TerminalClient &client):
 				IEvent(target),
 				m_rclClient(client)
@@ -73,6 +79,99 @@ namespace dcclite::broker::shell::terminal
 			TerminalClient &m_rclClient;
 	};
 
+	/////////////////////////////////////////////////////////////////////////////
+	//
+	// GetChangesSinceCmd
+	//
+	/////////////////////////////////////////////////////////////////////////////
+
+	/**
+	* Usage: Get-Changes-Since <serviceName> <version> [epoch]
+	* 
+	* Returns the current state of every item of the service changed after version, or snapshotRequired if the
+	* changes are not available anymore (or the epoch does not match, the broker was restarted), so the client 
+	* must reload the service items.
+	*/
+	class GetChangesSinceCmd : public TerminalCmd
+	{
+		public:
+			explicit GetChangesSinceCmd(TerminalService &owner, RName name = RName{ "Get-Changes-Since" }) :
+				TerminalCmd(name),
+				m_rclOwner{ owner }
+			{
+				//empty
+			}
+
+			CmdResult_t Run(TerminalContext &context, const CmdId_t id, const rapidjson::Document &request) override
+			{
+				auto paramsIt = request.FindMember("params");
+				if ((paramsIt == request.MemberEnd()) || !paramsIt->value.IsArray() || (paramsIt->value.Size() < 2) || !paramsIt->value[0].IsString() || !paramsIt->value[1].IsUint64())
+				{
+					throw TerminalCmdException(fmt::format("Usage: {} <serviceName> <version> [epoch]", this->GetName()), id);
+				}
+
+				const auto &params = paramsIt->value;
+
+				const auto serviceName = RName::TryGetName(params[0].GetString());
+				auto service = serviceName ? m_rclOwner.m_rclBroker.TryFindService(serviceName) : nullptr;
+				if (!service)
+				{
+					throw TerminalCmdException(fmt::format("{}: service {} not found", this->GetName(), params[0].GetString()), id);
+				}
+
+				auto changeLog = m_rclOwner.TryGetChangeLog(*service);
+				if (!changeLog)
+				{
+					throw TerminalCmdException(fmt::format("{}: service {} has no change log", this->GetName(), params[0].GetString()), id);
+				}
+
+				const auto epoch = m_rclOwner.GetChangeLogEpoch();
+				const bool sameEpoch = (params.Size() > 2) && params[2].IsString() && (epoch.compare(params[2].GetString()) == 0);
+
+				std::vector<const sys::ChangeLog::Change *> changes;
+				const bool snapshotRequired = !sameEpoch || !changeLog->TryGetChangesSince(params[1].GetUint64(), changes);
+
+				auto &root = m_rclOwner.GetRoot();
+
+				return MsgUtils::MakeRpcResultMessage(context, id, [&](Result_t &results)
+					{
+						results.AddStringValue("classname", "ChangeSet");
+						results.AddStringValue("service", service->GetNameData());
+						results.AddStringValue("epoch", epoch);
+						results.AddIntValue("version", static_cast<int64_t>(changeLog->GetVersion()));
+						results.AddBool("snapshotRequired", snapshotRequired);
+
+						auto changesArray = results.AddArray("changes");
+
+						for (auto change : changes)
+						{
+							auto changeObj = changesArray.AddObject();
+
+							changeObj.AddIntValue("changeVersion", static_cast<int64_t>(change->m_uVersion));
+							changeObj.AddStringValue("path", change->m_strPath);
+
+							//the item may be gone even if the last recorded change is not a destroy (a parent may have been destroyed)
+							auto item = change->m_kType != sys::ObjectManagerEvent::ITEM_DESTROYED ? root.TryNavigate(dcclite::Path_t{ change->m_strPath }) : nullptr;
+							if (!item)
+							{
+								changeObj.AddStringValue("type", "destroyed");
+
+								continue;
+							}
+
+							changeObj.AddStringValue("type", change->m_kType == sys::ObjectManagerEvent::ITEM_CREATED ? "created" : "changed");
+
+							auto itemObj = changeObj.AddObject("item");
+							item->Serialize(itemObj);
+						}
+					}
+				);
+			}
+
+		private:
+			TerminalService &m_rclOwner;
+	};
+
 	/////////////////////////////////////////////////////////////////////////////
 	//
 	// TerminalService
@@ -85,8 +184,13 @@ namespace dcclite::broker::shell::terminal
 
 	TerminalService::TerminalService(RName name, sys::Broker &broker, const rapidjson::Value &params, CmdHostService &cmdHost) :
 		Service(name, broker, params),
+		m_uChangeLogCapacity{ static_cast<size_t>(dcclite::json::TryGetDefaultInt(params, "changeLogSize", static_cast<int>(sys::ChangeLog::DEFAULT_CAPACITY))) },
+		m_strChangeLogEpoch{ dcclite::GuidToString(dcclite::GuidCreate()) },
 		m_rclCmdHost{cmdHost}
 	{
+		if (m_uChangeLogCapacity == 0)
+			throw std::invalid_argument("[TerminalService] changeLogSize must be greater than zero");
+
 		const auto port = dcclite::json::TryGetDefaultInt(params, "port", DEFAULT_TERMINAL_SERVER_PORT);
 		
 		m_thListenThread = std::thread{ [port, this] {this->ListenThreadProc(port); } };		
@@ -105,6 +209,8 @@ namespace dcclite::broker::shell::terminal
 		//close socket, so listen thread stops...
 		m_clSocket.Close();
 
+		m_vecServicesConnections.clear();
+
 		//kill all clients...
 		m_vecClients.clear();
 
@@ -125,6 +231,7 @@ namespace dcclite::broker::shell::terminal
 
 		assert(it != m_vecClients.end());
 
+		m_clSubscriptions.RemoveSubscriber(client);
 		m_vecClients.erase(it);
 
 		dcclite::Log::Info("[TerminalService] Client disconnected");
@@ -135,6 +242,134 @@ namespace dcclite::broker::shell::terminal
 		sys::EventHub::PostEvent< TerminalServiceClientDisconnectedEvent>(std::ref(*this), std::ref(client));
 	}
 
+	void TerminalService::OnLoadFinished()
+	{
+		m_rclBroker.VisitServices(
+			[this](auto &item)
+			{
+				auto *service = dynamic_cast<sys::Service *>(&item);
+
+				if (service != nullptr)
+				{
+					m_mapChangeLogs.emplace(service, sys::ChangeLog{ service->GetChangeVersion(), m_uChangeLogCapacity });
+
+					m_vecServicesConnections.emplace_back(service->m_sigEvent.connect(&TerminalService::OnObjectManagerEvent, this));
+				}
+				else
+				{
+					dcclite::Log::Warn("[TerminalService::OnLoadFinished] Object {} is not a service, it is {}", item.GetName(), item.GetTypeName());
+				}
+
+				return true;
+			}
+		);
+	}
+
+	void TerminalService::OnUnload()
+	{
+		m_vecServicesConnections.clear();
+		m_mapChangeLogs.clear();
+	}
+
+	void TerminalService::ITerminalCmdProvider_RegisterLocalCmds(CmdHostService &cmdHostService)
+	{
+		cmdHostService.AddCmd(std::make_unique<GetChangesSinceCmd>(*this));
+	}
+
+	const sys::ChangeLog *TerminalService::TryGetChangeLog(const sys::Service &service) const noexcept
+	{
+		auto it = m_mapChangeLogs.find(&service);
+
+		return it == m_mapChangeLogs.end() ? nullptr : &it->second;
+	}
+
+	void TerminalService::Subscribe(TerminalClient &client, const sys::SubscriptionFilter &filter)
+	{
+		m_clSubscriptions.Subscribe(client, filter);
+	}
+
+	bool TerminalService::Unsubscribe(TerminalClient &client, const sys::SubscriptionFilter &filter)
+	{
+		return m_clSubscriptions.Unsubscribe(client, filter);
+	}
+
+	void TerminalService::UnsubscribeAll(TerminalClient &client)
+	{
+		m_clSubscriptions.RemoveSubscriber(client);
+	}
+
+	void TerminalService::OnObjectManagerEvent(const sys::ObjectManagerEvent &event)
+	{
+		//items that are not objects cannot be located on the tree, so use their manager for matching
+		auto object = dynamic_cast<const dcclite::IObject *>(&event.m_rclItem);
+
+		if (auto it = m_mapChangeLogs.find(&event.m_rclManager); it != m_mapChangeLogs.end())
+		{
+			it->second.Record(
+				event.m_uVersion,
+				object ? event.m_kType : sys::ObjectManagerEvent::ITEM_CHANGED,
+				(object ? *object : event.m_rclManager).GetPath().string()
+			);
+		}
+
+		//nobody listening, do not waste time serializing
+		if (m_clSubscriptions.IsEmpty())
+			return;
+
+		m_vecSubscribersCache.clear();
+		m_clSubscriptions.FindSubscribers(object ? *object : event.m_rclManager, m_vecSubscribersCache);
+
+		if (m_vecSubscribersCache.empty())
+			return;
+
+		std::string_view methodName;
+		switch (event.m_kType)
+		{
+			case sys::ObjectManagerEvent::ITEM_CHANGED:
+				methodName = "On-ItemPropertyValueChanged";
+				break;
+
+			case sys::ObjectManagerEvent::ITEM_CREATED:
+				methodName = "On-ItemCreated";
+				break;
+
+			case sys::ObjectManagerEvent::ITEM_DESTROYED:
+				methodName = "On-ItemDestroyed";
+				break;
+
+			default:
+				return;
+		}
+
+		//
+		//serialize at most once per encoding and share the result with all the subscribers
+		std::string messages[2];
+
+		for (auto client : m_vecSubscribersCache)
+		{
+			const auto encoding = client->GetEncoding();
+			auto &msg = messages[encoding == TerminalEncoding::CBOR ? 1 : 0];
+
+			if (msg.empty())
+			{
+				msg = MsgUtils::MakeRpcNotificationMessage(
+					encoding,
+					-1,
+					methodName,
+					[&event](JsonOutputStream_t &params)
+					{
+						event.m_pfnSerializeDeltaProc ? event.m_pfnSerializeDeltaProc(params) : event.m_rclItem.Serialize(params);
+
+						//lets the client detect lost notifications, see Get-Changes-Since
+						params.AddIntValue("changeVersion", static_cast<int64_t>(event.m_uVersion));
+					}
+				);
+			}
+
+			client->SendNotification(msg);
+		}
+	}
+
 	void TerminalService::OnAcceptConnection(const dcclite::NetworkAddress &address, dcclite::Socket &&s)
 	{
 		dcclite::Log::Info("[TerminalService] Client connected {}", address.GetIpString());
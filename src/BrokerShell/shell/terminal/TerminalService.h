@@ -10,6 +10,7 @@
 
 #pragma once
 
+#include <map>
 #include <vector>
 
 #include <thread>
@@ -17,7 +18,9 @@
 #include <dcclite/Socket.h>
 
 #include "sys/Service.h"
+#include "sys/ChangeLog.h"
 #include "sys/EventHub.h"
+#include "sys/SubscriptionIndex.h"
 
 #include "TerminalCmdProvider.h"
 
@@ -30,14 +33,35 @@ namespace dcclite::broker::shell::terminal
 	{
 		public:
 			virtual void Async_DisconnectClient(TerminalClient &client) = 0;
+
+			virtual void Subscribe(TerminalClient &client, const sys::SubscriptionFilter &filter) = 0;
+			virtual bool Unsubscribe(TerminalClient &client, const sys::SubscriptionFilter &filter) = 0;
+			virtual void UnsubscribeAll(TerminalClient &client) = 0;
 	};
 
-	class TerminalService : public sys::Service, sys::EventHub::IEventTarget, ITerminalServiceClientProxy
+	class TerminalService : public sys::Service, public sys::IPostLoadService, public ITerminalCmdProvider, sys::EventHub::IEventTarget, ITerminalServiceClientProxy
 	{
 		private:		
 			dcclite::Socket m_clSocket;
 
 			std::vector <std::unique_ptr<TerminalClient>> m_vecClients;
+
+			//
+			//A single connection to each service, events are routed to clients using their subscriptions
+			std::vector<sigslot::scoped_connection>	m_vecServicesConnections;
+
+			sys::SubscriptionIndex<TerminalClient>	m_clSubscriptions;
+
+			//reused on every event, so dispatching does not allocate
+			std::vector<TerminalClient *>			m_vecSubscribersCache;
+
+			//
+			//Recent changes of each service, so reconnecting clients can ask only for what they missed
+			std::map<const sys::Service *, sys::ChangeLog>	m_mapChangeLogs;
+			size_t											m_uChangeLogCapacity;
+
+			//services versions restart with the broker, so clients must check this before reusing a version
+			const std::string								m_strChangeLogEpoch;
 			
 			std::thread m_thListenThread;	
 
@@ -56,7 +80,21 @@ namespace dcclite::broker::shell::terminal
 
 			typedef CmdHostService Requirement_t;
 
+			void OnLoadFinished() override;
+			void OnUnload() override;
+
+			void ITerminalCmdProvider_RegisterLocalCmds(CmdHostService &cmdHostService) override;
+
+			const sys::ChangeLog *TryGetChangeLog(const sys::Service &service) const noexcept;
+
+			inline std::string_view GetChangeLogEpoch() const noexcept
+			{
+				return m_strChangeLogEpoch;
+			}
+
 		private:
+			void OnObjectManagerEvent(const sys::ObjectManagerEvent &event);
+
 			void ListenThreadProc(const int port);
 
 			void OnAcceptConnection(const dcclite::NetworkAddress &address, dcclite::Socket &&s);
@@ -65,6 +103,11 @@ namespace dcclite::broker::shell::terminal
 
 			void Async_DisconnectClient(TerminalClient &client) override;
 
+			void Subscribe(TerminalClient &client, const sys::SubscriptionFilter &filter) override;
+			bool Unsubscribe(TerminalClient &client, const sys::SubscriptionFilter &filter) override;
+			void UnsubscribeAll(TerminalClient &client) override;
+
+			friend class GetChangesSinceCmd;
 			friend class TerminalServiceClientDisconnectedEvent;
 			friend class TerminalServiceAcceptConnectionEvent;
 	};
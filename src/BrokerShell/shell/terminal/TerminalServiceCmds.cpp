@@ -11,8 +11,14 @@
 
 #include "TerminalServiceCmds.h"
 
+#include <chrono>
+#include <optional>
+
+#include <dcclite/Clock.h>
 #include <dcclite/FmtUtils.h>
 
+#include "sys/Thinker.h"
+
 #include "CmdHostService.h"
 #include "TerminalContext.h"
 #include "TerminalUtils.h"
@@ -26,6 +32,251 @@ namespace dcclite::broker::shell::terminal
 	// GetChildItemCmd
 	//
 	/////////////////////////////////////////////////////////////////////////////
+
+	constexpr auto DEFAULT_STREAM_BUDGET = std::chrono::milliseconds{ 5 };
+
+	//time between stream chunks, so the broker loop can handle other events
+	constexpr auto STREAM_INTERVAL = std::chrono::milliseconds{ 1 };
+
+	/**
+	* Get-ChildItem options for large folders, all are optional:
+	*	- pageSize: max number of children on the response, if there are more children a cursor is returned
+	*	- cursor: continues the listing after the item with this name (the cursor from the previous page)
+	*	- fields: only those fields are sent for each child, ie ["name", "state"]
+	*	- stream: sends the children in chunks, as notifications, across several broker loop iterations
+	*	- budgetMs: for how long a stream chunk may run before yielding to the broker loop
+	*/
+	struct ChildItemListOptions
+	{
+		std::string					m_strCursor;
+		std::vector<std::string>	m_vecFields;
+
+		unsigned					m_uPageSize = 0;
+
+		std::chrono::milliseconds	m_tBudget = DEFAULT_STREAM_BUDGET;
+
+		bool						m_fStream = false;
+	};
+
+	static ChildItemListOptions ParseChildItemListOptions(RName cmdName, const CmdId_t id, const rapidjson::Value &data)
+	{
+		if (!data.IsObject())
+			throw TerminalCmdException(fmt::format("{}: options must be an object", cmdName), id);
+
+		ChildItemListOptions options;
+
+		if (auto it = data.FindMember("pageSize"); it != data.MemberEnd())
+		{
+			if (!it->value.IsUint())
+				throw TerminalCmdException(fmt::format("{}: pageSize must be a positive number", cmdName), id);
+
+			options.m_uPageSize = it->value.GetUint();
+		}
+
+		if (auto it = data.FindMember("cursor"); it != data.MemberEnd())
+		{
+			if (!it->value.IsString())
+				throw TerminalCmdException(fmt::format("{}: cursor must be a string", cmdName), id);
+
+			options.m_strCursor = it->value.GetString();
+		}
+
+		if (auto it = data.FindMember("fields"); it != data.MemberEnd())
+		{
+			if (!it->value.IsArray())
+				throw TerminalCmdException(fmt::format("{}: fields must be an array", cmdName), id);
+
+			for (const auto &field : it->value.GetArray())
+			{
+				if (!field.IsString())
+					throw TerminalCmdException(fmt::format("{}: fields must be strings", cmdName), id);
+
+				options.m_vecFields.emplace_back(field.GetString());
+			}
+		}
+
+		if (auto it = data.FindMember("stream"); it != data.MemberEnd())
+		{
+			if (!it->value.IsBool())
+				throw TerminalCmdException(fmt::format("{}: stream must be a boolean", cmdName), id);
+
+			options.m_fStream = it->value.GetBool();
+		}
+
+		if (auto it = data.FindMember("budgetMs"); it != data.MemberEnd())
+		{
+			if (!it->value.IsUint() || (it->value.GetUint() == 0))
+				throw TerminalCmdException(fmt::format("{}: budgetMs must be a positive number", cmdName), id);
+
+			options.m_tBudget = std::chrono::milliseconds{ it->value.GetUint() };
+		}
+
+		return options;
+	}
+
+	/**
+	* Writes the folder children that come after cursor, stops after maxItems (zero means no limit) or when the deadline is reached,
+	* but always writes at least one child, so the listing makes progress
+	*
+	* Returns true if there are children left, cursor is updated to the last child written
+	*/
+	static bool WriteChildren(
+		const IFolderObject &folder,
+		std::string &cursor,
+		const std::vector<std::string> &fields,
+		const unsigned maxItems,
+		const std::optional<dcclite::Clock::TimePoint_t> deadline,
+		const CmdId_t id,
+		dcclite::ArrayOutputStream &children
+	)
+	{
+		bool hasMore = false;
+		unsigned numItems = 0;
+
+		const IObject *lastItem = nullptr;
+
+		auto visitor = [&](const IObject &item)
+			{
+				if (numItems && (((maxItems > 0) && (numItems == maxItems)) || (deadline && (dcclite::Clock::DefaultClock_t::now() >= *deadline))))
+				{
+					hasMore = true;
+
+					return false;
+				}
+
+				if (fields.empty())
+				{
+					auto itemObject = children.AddObject();
+					item.Serialize(itemObject);
+				}
+				else
+				{
+					ProjectionDataWriter projection{ children.GetWriter(), fields };
+
+					ObjectOutputStream itemObject{ projection };
+					item.Serialize(itemObject);
+				}
+
+				++numItems;
+				lastItem = &item;
+
+				return true;
+			};
+
+		if (cursor.empty())
+		{
+			folder.ConstVisitChildren(visitor);
+		}
+		else
+		{
+			//resumes right after the cursor, instead of walking the folder again from the start
+			auto cursorName = RName::TryGetName(cursor);
+
+			if (!cursorName || !folder.ConstVisitChildrenAfter(cursorName, visitor))
+			{
+				//we cannot tell what the client already has
+				throw TerminalCmdException(fmt::format("Cursor {} not found on {}, restart the listing", cursor, folder.GetPath().string()), id);
+			}
+		}
+
+		if (lastItem)
+			cursor = lastItem->GetNameData();
+
+		return hasMore;
+	}
+
+	/**
+	* Sends the children in chunks (On-ChildItemChunk notifications), each chunk runs on its own broker loop iteration and for at most the
+	* time budget. When all children are sent, the cmd result is sent with the total count.
+	*/
+	class GetChildItemStreamFiber: public TerminalCmdFiber
+	{
+		public:
+			GetChildItemStreamFiber(const CmdId_t id, TerminalContext &context, const IFolderObject &folder, ChildItemListOptions &&options):
+				TerminalCmdFiber(id, context),
+				m_pthFolder{ folder.GetPath() },
+				m_stOptions{ std::move(options) },
+				m_clThinker{ dcclite::Clock::DefaultClock_t::now(), "GetChildItemStreamFiber", THINKER_MF_LAMBDA(OnThink) }
+			{
+				//empty
+			}
+
+		private:
+			void OnThink(const sys::Thinker::TimePoint_t tp)
+			{
+				try
+				{
+					//the folder may be gone since the last chunk
+					auto item = detail::GetCurrentFolder(m_rclContext, m_tCmdId).TryNavigate(m_pthFolder);
+					if (!item || !item->IsFolder())
+						throw TerminalCmdException(fmt::format("Location {} is gone", m_pthFolder.string()), m_tCmdId);
+
+					const auto &folder = static_cast<const IFolderObject &>(*item);
+
+					bool hasMore = false;
+					auto msg = MsgUtils::MakeRpcNotificationMessage(m_rclContext, m_tCmdId, "On-ChildItemChunk", [this, &folder, &hasMore](Result_t &params)
+						{
+							params.AddStringValue("classname", "ChildItemChunk");
+							params.AddStringValue("location", m_pthFolder.string());
+
+							{
+								auto dataArray = params.AddArray("children");
+
+								hasMore = WriteChildren(
+									folder, 
+									m_stOptions.m_strCursor, 
+									m_stOptions.m_vecFields, 
+									m_stOptions.m_uPageSize, 
+									dcclite::Clock::DefaultClock_t::now() + m_stOptions.m_tBudget, 
+									m_tCmdId,
+									dataArray
+								);
+							}
+
+							params.AddStringValue("cursor", m_stOptions.m_strCursor);
+						}
+					);
+
+					m_uNumChunks += 1;
+					m_rclContext.SendClientNotification(msg);
+
+					if (hasMore)
+					{
+						m_clThinker.Schedule(tp + STREAM_INTERVAL);
+
+						return;
+					}
+
+					m_rclContext.SendClientNotification(MsgUtils::MakeRpcResultMessage(m_rclContext, m_tCmdId, [this](Result_t &results)
+						{
+							results.AddStringValue("classname", "ChildItem");
+							results.AddStringValue("location", m_pthFolder.string());
+							results.AddIntValue("chunks", m_uNumChunks);
+
+							//everything was on the chunks
+							results.AddArray("children");
+						}
+					));
+				}
+				catch (TerminalCmdException &ex)
+				{
+					m_rclContext.SendClientNotification(MsgUtils::MakeRpcErrorResponse(m_rclContext, m_tCmdId, ex.what()));
+				}
+
+				//done, go away
+				m_rclContext.DestroyFiber(*this);
+			}
+
+		private:
+			const dcclite::Path_t	m_pthFolder;
+
+			ChildItemListOptions	m_stOptions;
+
+			unsigned				m_uNumChunks = 0;
+
+			sys::Thinker			m_clThinker;
+	};
+
 	class GetChildItemCmd : public TerminalCmd
 	{
 		public:
@@ -39,39 +290,55 @@ namespace dcclite::broker::shell::terminal
 			{
 				auto folder = &detail::GetCurrentFolder(context, id);
 
+				ChildItemListOptions options;
+
+				//params: [location] [options]
 				auto paramsIt = request.FindMember("params");
-				if (paramsIt != request.MemberEnd())
+				if ((paramsIt != request.MemberEnd()) && paramsIt->value.IsArray() && !paramsIt->value.Empty())
 				{
-					auto locationParam = paramsIt->value[0].GetString();
-					auto item = folder->TryNavigate(dcclite::Path_t(locationParam));
-					if (!item)
-					{
-						throw TerminalCmdException(fmt::format("Invalid location {}", locationParam), id);
-					}
+					const auto &params = paramsIt->value;
+					rapidjson::SizeType optionsIndex = 0;
 
-					if (!item->IsFolder())
+					if (params[0].IsString())
 					{
-						throw TerminalCmdException(fmt::format("Location is not a folder {}", locationParam), id);
+						auto locationParam = params[0].GetString();
+						auto item = folder->TryNavigate(dcclite::Path_t(locationParam));
+						if (!item)
+						{
+							throw TerminalCmdException(fmt::format("Invalid location {}", locationParam), id);
+						}
+
+						if (!item->IsFolder())
+						{
+							throw TerminalCmdException(fmt::format("Location is not a folder {}", locationParam), id);
+						}
+
+						folder = static_cast<IFolderObject *>(item);
+						optionsIndex = 1;
 					}
 
-					folder = static_cast<IFolderObject *>(item);
+					if (params.Size() > optionsIndex)
+						options = ParseChildItemListOptions(this->GetName(), id, params[optionsIndex]);
 				}
 
-				return MsgUtils::MakeRpcResultMessage(id, [folder](Result_t &results)
+				if (options.m_fStream)
+					return std::make_unique<GetChildItemStreamFiber>(id, context, *folder, std::move(options));
+
+				return MsgUtils::MakeRpcResultMessage(context, id, [folder, &options, id](Result_t &results)
 					{
 						results.AddStringValue("classname", "ChildItem");
 						results.AddStringValue("location", folder->GetPath().string());
 
-						auto dataArray = results.AddArray("children");
+						bool hasMore;
+						{
+							auto dataArray = results.AddArray("children");
 
-						folder->ConstVisitChildren([&dataArray](const IObject &item)
-							{
-								auto itemObject = dataArray.AddObject();
-								item.Serialize(itemObject);
+							hasMore = WriteChildren(*folder, options.m_strCursor, options.m_vecFields, options.m_uPageSize, std::nullopt, id, dataArray);
+						}
 
-								return true;
-							}
-						);
+						//no cursor means the listing is complete
+						if (hasMore)
+							results.AddStringValue("cursor", options.m_strCursor);
 					});
 			}
 	};
@@ -107,7 +374,7 @@ namespace dcclite::broker::shell::terminal
 					throw TerminalCmdException(fmt::format("Invalid location {}", locationParam), id);
 				}
 
-				return MsgUtils::MakeRpcResultMessage(id, [item](Result_t &results)
+				return MsgUtils::MakeRpcResultMessage(context, id, [item](Result_t &results)
 					{
 						results.AddStringValue("classname", "Item");
 						results.AddStringValue("location", item->GetPath().string());
@@ -162,7 +429,7 @@ namespace dcclite::broker::shell::terminal
 					path = folder.GetPath();
 				}
 
-				return MsgUtils::MakeRpcResultMessage(id, [&path](Result_t &results)
+				return MsgUtils::MakeRpcResultMessage(context, id, [&path](Result_t &results)
 					{
 						results.AddStringValue("classname", "Location");
 						results.AddStringValue("location", path.string());
@@ -193,7 +460,7 @@ namespace dcclite::broker::shell::terminal
 
 				auto folder = static_cast<FolderObject *>(item);
 
-				return MsgUtils::MakeRpcResultMessage(id, [folder](Result_t &results)
+				return MsgUtils::MakeRpcResultMessage(context, id, [folder](Result_t &results)
 					{
 						results.AddStringValue("classname", "CmdList");
 
@@ -230,7 +497,7 @@ namespace dcclite::broker::shell::terminal
 			{
 				auto names = dcclite::detail::RName_GetAll();
 
-				return MsgUtils::MakeRpcResultMessage(id, [&names](Result_t &results)
+				return MsgUtils::MakeRpcResultMessage(context, id, [&names](Result_t &results)
 					{
 						results.AddStringValue("classname", "RNames");
 						auto dataArray = results.AddArray("rnames");
@@ -250,6 +517,161 @@ namespace dcclite::broker::shell::terminal
 			}
 	};
 
+	/////////////////////////////////////////////////////////////////////////////
+	//
+	// SetEncodingCmd
+	//
+	/////////////////////////////////////////////////////////////////////////////
+	class SetEncodingCmd : public TerminalCmd
+	{
+		public:
+			explicit SetEncodingCmd(RName name = RName{ "Set-Encoding" }) :
+				TerminalCmd(name)
+			{
+				//empty
+			}
+
+			CmdResult_t Run(TerminalContext &context, const CmdId_t id, const rapidjson::Document &request) override
+			{
+				auto paramsIt = request.FindMember("params");
+				if ((paramsIt == request.MemberEnd()) || !paramsIt->value.IsArray() || (paramsIt->value.Size() < 1) || !paramsIt->value[0].IsString())
+				{
+					throw TerminalCmdException(fmt::format("Usage: {} <json|cbor>", this->GetName()), id);
+				}
+
+				const std::string_view encodingName = paramsIt->value[0].GetString();
+
+				TerminalEncoding encoding;
+				if (encodingName == "json")
+					encoding = TerminalEncoding::JSON;
+				else if (encodingName == "cbor")
+					encoding = TerminalEncoding::CBOR;
+				else
+					throw TerminalCmdException(fmt::format("Unknown encoding {}, expected json or cbor", encodingName), id);
+
+				//
+				//The reply already uses the new encoding, so clients can detect old brokers: a json reply 
+				//starts with '{' while a length prefixed frame starts with a zero byte
+				context.SetEncoding(encoding);
+
+				return MsgUtils::MakeRpcResultMessage(context, id, [encodingName](Result_t &results)
+					{
+						results.AddStringValue("classname", "Encoding");
+						results.AddStringValue("encoding", encodingName);
+					}
+				);
+			}
+	};
+
+	/////////////////////////////////////////////////////////////////////////////
+	//
+	// SubscribeCmd
+	//
+	/////////////////////////////////////////////////////////////////////////////
+
+	/**
+	* Parses all the filters before anything is changed, so a bad filter does not leave the client half subscribed
+	*/
+	static std::vector<sys::SubscriptionFilter> ParseSubscriptionFilters(RName cmdName, const CmdId_t id, const rapidjson::Value &params)
+	{
+		std::vector<sys::SubscriptionFilter> filters;
+		filters.reserve(params.Size());
+
+		for (const auto &param : params.GetArray())
+		{
+			if (!param.IsString())
+				throw TerminalCmdException(fmt::format("{}: filters must be strings", cmdName), id);
+
+			try
+			{
+				filters.push_back(sys::SubscriptionFilter::Parse(param.GetString()));
+			}
+			catch (std::invalid_argument &ex)
+			{
+				throw TerminalCmdException(fmt::format("{}: {}", cmdName, ex.what()), id);
+			}
+		}
+
+		return filters;
+	}
+
+	class SubscribeCmd : public TerminalCmd
+	{
+		public:
+			explicit SubscribeCmd(RName name = RName{ "Subscribe" }) :
+				TerminalCmd(name)
+			{
+				//empty
+			}
+
+			CmdResult_t Run(TerminalContext &context, const CmdId_t id, const rapidjson::Document &request) override
+			{
+				auto paramsIt = request.FindMember("params");
+				if ((paramsIt == request.MemberEnd()) || !paramsIt->value.IsArray() || (paramsIt->value.Size() < 1))
+				{
+					throw TerminalCmdException(fmt::format("Usage: {} <\"/path/*\" | \"/path/item\" | \"type=TypeName\" | \"/path/* type=TypeName\">...", this->GetName()), id);
+				}
+
+				const auto filters = ParseSubscriptionFilters(this->GetName(), id, paramsIt->value);
+
+				for (const auto &filter : filters)
+					context.Subscribe(filter);
+
+				return MsgUtils::MakeRpcResultMessage(context, id, [&filters](Result_t &results)
+					{
+						results.AddStringValue("classname", "Subscription");
+						results.AddIntValue("count", static_cast<int64_t>(filters.size()));
+					}
+				);
+			}
+	};
+
+	/////////////////////////////////////////////////////////////////////////////
+	//
+	// UnsubscribeCmd
+	//
+	/////////////////////////////////////////////////////////////////////////////
+	class UnsubscribeCmd : public TerminalCmd
+	{
+		public:
+			explicit UnsubscribeCmd(RName name = RName{ "Unsubscribe" }) :
+				TerminalCmd(name)
+			{
+				//empty
+			}
+
+			CmdResult_t Run(TerminalContext &context, const CmdId_t id, const rapidjson::Document &request) override
+			{
+				auto paramsIt = request.FindMember("params");
+
+				//no filters, remove everything
+				if ((paramsIt == request.MemberEnd()) || !paramsIt->value.IsArray() || paramsIt->value.Empty())
+				{
+					context.UnsubscribeAll();
+
+					return MsgUtils::MakeRpcResultMessage(context, id, [](Result_t &results)
+						{
+							results.AddStringValue("classname", "Subscription");
+							results.AddIntValue("count", 0);
+						}
+					);
+				}
+
+				const auto filters = ParseSubscriptionFilters(this->GetName(), id, paramsIt->value);
+
+				int removed = 0;
+				for (const auto &filter : filters)
+					removed += context.Unsubscribe(filter) ? 1 : 0;
+
+				return MsgUtils::MakeRpcResultMessage(context, id, [removed](Result_t &results)
+					{
+						results.AddStringValue("classname", "Subscription");
+						results.AddIntValue("removed", removed);
+					}
+				);
+			}
+	};
+
 	/////////////////////////////////////////////////////////////////////////////
 	//
 	// RegisterBaseTerminalCmds
@@ -280,6 +702,15 @@ namespace dcclite::broker::shell::terminal
 		{
 			cmdHost.AddCmd(std::make_unique<GetRNames>());
 		}
+
+		{
+			cmdHost.AddCmd(std::make_unique<SetEncodingCmd>());
+		}
+
+		{
+			cmdHost.AddCmd(std::make_unique<SubscribeCmd>());
+			cmdHost.AddCmd(std::make_unique<UnsubscribeCmd>());
+		}
 	}
 }
 
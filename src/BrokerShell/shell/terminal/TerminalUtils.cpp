@@ -13,6 +13,7 @@
 
 #include <fmt/format.h>
 
+#include <dcclite/Cbor.h>
 #include <dcclite/FmtUtils.h>
 #include <dcclite/Util.h>
 
@@ -24,32 +25,44 @@ namespace dcclite::broker::shell::terminal::MsgUtils
 {
 	using namespace dcclite;
 
-	std::string MakeRpcMessage(CmdId_t id, std::string_view *methodName, std::string_view nestedObjName, std::function<void(JsonOutputStream_t &object)> filler)
+	static void WriteRpcMessage(IDataWriter &messageWriter, CmdId_t id, std::string_view *methodName, std::string_view nestedObjName, const std::function<void(JsonOutputStream_t &object)> &filler)
 	{
-		JsonCreator::StringWriter messageWriter;
+		auto messageObj = dcclite::MakeObject(messageWriter);
 
+		messageObj.AddStringValue(JSONRPC_KEY, JSONRPC_VERSION);
+
+		if (id >= 0)
 		{
-			auto messageObj = JsonCreator::MakeObject(messageWriter);
+			messageObj.AddIntValue("id", id);
+		}
 
-			messageObj.AddStringValue(JSONRPC_KEY, JSONRPC_VERSION);
+		if (methodName)
+			messageObj.AddStringValue("method", *methodName);
 
-			if (id >= 0)
-			{
-				messageObj.AddIntValue("id", id);
-			}
+		if (filler)
+		{
+			auto params = messageObj.AddObject(nestedObjName);
+
+			filler(params);
+		}
+	}
 
-			if (methodName)
-				messageObj.AddStringValue("method", *methodName);
+	std::string MakeRpcMessage(TerminalEncoding encoding, CmdId_t id, std::string_view *methodName, std::string_view nestedObjName, std::function<void(JsonOutputStream_t &object)> filler)
+	{
+		if (encoding == TerminalEncoding::CBOR)
+		{
+			CborDataWriter messageWriter;
 
-			if (filler)
-			{
-				auto params = messageObj.AddObject(nestedObjName);
+			WriteRpcMessage(messageWriter, id, methodName, nestedObjName, filler);
 
-				filler(params);
-			}
+			return messageWriter.ReleaseString();
 		}
 
-		return messageWriter.GetString();
+		JsonDataWriter messageWriter;
+
+		WriteRpcMessage(messageWriter, id, methodName, nestedObjName, filler);
+
+		return messageWriter.ReleaseString();
 	}
 }
 
@@ -140,7 +153,7 @@ namespace dcclite::broker::shell::terminal::detail
 		context.GetTaskManager().RemoveTask(task->GetTaskId());
 
 		//notify client
-		return MsgUtils::MakeRpcResultMessage(id, [](TerminalCmd::Result_t &results)
+		return MsgUtils::MakeRpcResultMessage(context, id, [](TerminalCmd::Result_t &results)
 			{
 				results.AddStringValue("classname", "string");
 				results.AddStringValue("msg", "OK");
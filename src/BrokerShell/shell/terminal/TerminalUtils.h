@@ -13,6 +13,7 @@
 #include <string>
 
 #include "TerminalCmd.h"
+#include "TerminalContext.h"
 
 namespace dcclite::broker::exec::dcc
 {
@@ -25,21 +26,37 @@ namespace dcclite::broker::shell::terminal::MsgUtils
 	constexpr auto JSONRPC_KEY = "jsonrpc";
 	constexpr auto JSONRPC_VERSION = "2.0";
 
-	std::string MakeRpcMessage(CmdId_t id, std::string_view *methodName, std::string_view nestedObjName, std::function<void(JsonOutputStream_t &object)> filler);
+	std::string MakeRpcMessage(TerminalEncoding encoding, CmdId_t id, std::string_view *methodName, std::string_view nestedObjName, std::function<void(JsonOutputStream_t &object)> filler);
 
-	inline std::string MakeRpcNotificationMessage(CmdId_t id, std::string_view methodName, std::function<void(JsonOutputStream_t &object)> filler)
+	/**
+	* Builds a rpc message using the encoding currently in use by the context client
+	*/
+	inline std::string MakeRpcMessage(const TerminalContext &context, CmdId_t id, std::string_view *methodName, std::string_view nestedObjName, std::function<void(JsonOutputStream_t &object)> filler)
 	{
-		return MakeRpcMessage(id, &methodName, "params", filler);
+		return MakeRpcMessage(context.GetEncoding(), id, methodName, nestedObjName, std::move(filler));
 	}
 
-	inline std::string MakeRpcErrorResponse(const CmdId_t id, const std::string &msg)
+	/**
+	* Notifications shared by many clients are built once per encoding, so they do not depend on any context
+	*/
+	inline std::string MakeRpcNotificationMessage(TerminalEncoding encoding, CmdId_t id, std::string_view methodName, std::function<void(JsonOutputStream_t &object)> filler)
 	{
-		return MakeRpcMessage(id, nullptr, "error", [&, msg](JsonOutputStream_t &params) { params.AddStringValue("message", msg); });
+		return MakeRpcMessage(encoding, id, &methodName, "params", std::move(filler));
 	}
 
-	inline std::string MakeRpcResultMessage(const CmdId_t id, std::function<void(JsonOutputStream_t &object)> filler)
+	inline std::string MakeRpcNotificationMessage(const TerminalContext &context, CmdId_t id, std::string_view methodName, std::function<void(JsonOutputStream_t &object)> filler)
 	{
-		return MakeRpcMessage(id, nullptr, "result", filler);
+		return MakeRpcMessage(context, id, &methodName, "params", filler);
+	}
+
+	inline std::string MakeRpcErrorResponse(const TerminalContext &context, const CmdId_t id, const std::string &msg)
+	{
+		return MakeRpcMessage(context, id, nullptr, "error", [&, msg](JsonOutputStream_t &params) { params.AddStringValue("message", msg); });
+	}
+
+	inline std::string MakeRpcResultMessage(const TerminalContext &context, const CmdId_t id, std::function<void(JsonOutputStream_t &object)> filler)
+	{
+		return MakeRpcMessage(context, id, nullptr, "result", filler);
 	}
 }
 
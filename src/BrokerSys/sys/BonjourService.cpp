@@ -26,6 +26,8 @@ https://datatracker.ietf.org/doc/html/rfc6335 -> Internet Assigned Numbers Autho
 
 #include <magic_enum/magic_enum.hpp>
 #include <mutex>
+#include <thread>
+#include <vector>
 
 #include <dcclite_shared/Packet.h>
 
@@ -36,6 +38,7 @@ https://datatracker.ietf.org/doc/html/rfc6335 -> Internet Assigned Numbers Autho
 #include <dcclite/Util.h>
 
 #include "ServiceFactory.h"
+#include "SocketWaiter.h"
 #include "Timeouts.h"
 
 //#define NO_ENDIANNESS
@@ -334,33 +337,46 @@ namespace dcclite::broker::sys
 			static void CheckServiceName(std::string_view serviceName);
 			static void CheckInstanceName(std::string_view instanceName);
 
-			void SendServiceList(const DnsHeader &header, const QSection &query);
-
-			[[nodiscard]] bool Think();
+			void SendServiceList(const DnsHeader &header);
+			void BuildServiceList();
 
 			void NetworkProc();
 
 		private:		
 			dcclite::Socket m_clSocket;
+			SocketWaiter	m_clWaiter;
 
 			std::map< ServiceKey, ServiceRecord> m_mapServices;			
 
+			//answer for _services._dns-sd._udp.local., only rebuilt when a service is registered
+			std::vector<uint8_t> m_vecServiceListReply;
+
 			std::thread	m_tNetworkThread;
 			std::mutex	m_mtxMapServicesLock;			
 	};
 
 
 	BonjourServiceImpl::BonjourServiceImpl(RName name, Broker &broker, const rapidjson::Value &params):
-		BonjourService(name, broker, params),
-		m_tNetworkThread{ [this]() { this->NetworkProc(); }}		
+		BonjourService(name, broker, params)
 	{				
-		//empty
+		if (!m_clSocket.Open(g_clDnsAddress.GetPort(), dcclite::Socket::Type::DATAGRAM, dcclite::Socket::FLAG_ADDRESS_REUSE))
+		{
+			throw std::runtime_error("[BonjourServiceImpl] Cannot open port 5353 for listening");
+		}
+
+		if (!m_clSocket.JoinMulticastGroup(g_clDnsAddress))
+		{
+			throw std::runtime_error("[BonjourServiceImpl] Cannot join multicast group");
+		}
+
+		m_tNetworkThread = std::thread{ [this]() { this->NetworkProc(); } };
+		dcclite::SetThreadName(m_tNetworkThread, "BonjourService::NetworkThread");
 	}
 	
 
 	BonjourServiceImpl::~BonjourServiceImpl()
 	{
-		m_clSocket.Close();
+		m_clWaiter.Shutdown();
 
 		m_tNetworkThread.join();
 	}
@@ -452,6 +468,8 @@ namespace dcclite::broker::sys
 		{
 			throw std::invalid_argument(fmt::format("[BonjourServiceImpl::Register] Service {} already exists for protocol {}", serviceName, magic_enum::enum_name(protocol)));
 		}
+
+		this->BuildServiceList();
 	}
 
 	void BonjourServiceImpl::ParseQuery(const DnsHeader &header, const QSection &qsection)
@@ -496,12 +514,12 @@ namespace dcclite::broker::sys
 
 		//
 		// detect _services._dns-sd._udp.local.
-		if ((protocol.value() == NetworkProtocol::UDP) && (qsection.m_vecLabels[1].compare("_dns-sd") == 0) && (qsection.m_vecLabels[0].compare("_services") == 0))
+		if ((numLabels == 4) && (protocol.value() == NetworkProtocol::UDP) && (qsection.m_vecLabels[1].compare("_dns-sd") == 0) && (qsection.m_vecLabels[0].compare("_services") == 0))
 		{
 			//list all services
 			Log::Trace("[[BonjourServiceImpl::ParseQuery] received a _services._dns-sd._udp.local.");
 
-			this->SendServiceList(header, qsection);
+			this->SendServiceList(header);
 
 			return;
 		}
@@ -719,70 +737,63 @@ READ_NAME_AGAIN:
 
 	void BonjourServiceImpl::NetworkProc()
 	{
-		if (!m_clSocket.Open(g_clDnsAddress.GetPort(), dcclite::Socket::Type::DATAGRAM, dcclite::Socket::FLAG_ADDRESS_REUSE | dcclite::Socket::FLAG_BLOCKING_MODE))
-		{
-			throw std::runtime_error("[BonjourServiceImpl] Cannot open port 5353 for listening");
-		}
+		//mDNS is chatty, this covers a busy network without letting a flood eat a core
+		constexpr auto MAX_PACKETS_PER_INTERVAL = 32;
 
-		if (!m_clSocket.JoinMulticastGroup(g_clDnsAddress))
-		{
-			throw std::runtime_error("[BonjourServiceImpl] Cannot join multicast group");
-		}
+		NetworkPacket packet;
+
+		auto intervalStart = dcclite::Clock::DefaultClock_t::now();
+		int packetCount = 0;
 
 		for (;;)
 		{
-			auto startTime = dcclite::Clock::DefaultClock_t::now();
-
-			//Was thread interrupted?
-			if (!this->Think())
-				break;
-
-			auto endTime = dcclite::Clock::DefaultClock_t::now();
+			//sleep until a packet arrives or the destructor is called
+			if (m_clWaiter.Wait(m_clSocket) == SocketWaiter::Result::SHUTDOWN)
+				return;
 
-			if ((endTime - startTime) < BONJOUR_SERVICE_PACKET_INTERVAL)
+			for (;;)
 			{
-				//are we going too fast?
-				std::this_thread::sleep_for(BONJOUR_SERVICE_SLEEP_TIME);
-			}
-		}
-	}
-
-	bool BonjourServiceImpl::Think()
-	{	
-		NetworkPacket packet;				
+				const auto now = dcclite::Clock::DefaultClock_t::now();
+				if ((now - intervalStart) >= BONJOUR_SERVICE_PACKET_INTERVAL)
+				{
+					intervalStart = now;
+					packetCount = 0;
+				}
+				else if (packetCount == MAX_PACKETS_PER_INTERVAL)
+				{
+					//are we going too fast? Leave the rest queued until the next interval
+					if (!m_clWaiter.Sleep(intervalStart + BONJOUR_SERVICE_PACKET_INTERVAL - now))
+						return;
 
-		//Limit processing per frame in case something is flooding the network....
-		for (auto packetCount = 0; packetCount < 8; ++packetCount)
-		{
-			auto [status, size] = packet.Receive(m_clSocket);
+					continue;
+				}
 
-			if (status != dcclite::Socket::Status::OK)
-			{
-				//Bonjour destructor was called and socket was closed?
-				if (status == dcclite::Socket::Status::INTERRUPTED)
-					return false;
+				auto [status, size] = packet.Receive(m_clSocket);
+				if (status == dcclite::Socket::Status::WOULD_BLOCK)
+					break;
 
-				continue;
-			}
+				if (status != dcclite::Socket::Status::OK)
+					continue;
 
-			//corrupted packet?
-			if (size < sizeof(DnsHeader))
-				continue;
+				++packetCount;
 
-			{
-				std::lock_guard guard{ m_mtxMapServicesLock };
+				//corrupted packet?
+				if (size < sizeof(DnsHeader))
+					continue;
 
-				auto numServices = m_mapServices.size();
+				{
+					std::lock_guard guard{ m_mtxMapServicesLock };
 
-				//Is there any reason to parse packets if no services are registered?
-				if (numServices == 0)
-					continue;
-			}
+					auto numServices = m_mapServices.size();
 
-			this->ParsePacket(packet);
-		}	
+					//Is there any reason to parse packets if no services are registered?
+					if (numServices == 0)
+						continue;
+				}
 
-		return true;
+				this->ParsePacket(packet);
+			}
+		}
 	}
 
 	void BonjourServiceImpl::Serialize(JsonOutputStream_t &stream) const
@@ -891,9 +902,9 @@ READ_NAME_AGAIN:
 				m_clPacket.Seek(newPos);
 			}
 
-			inline void Send(Socket &socket)
+			inline const uint8_t *GetData() const noexcept
 			{
-				m_clPacket.Send(g_clDnsAddress, socket);				
+				return m_clPacket.GetData();
 			}
 
 		private:
@@ -904,11 +915,14 @@ READ_NAME_AGAIN:
 #endif
 	};
 
-	void BonjourServiceImpl::SendServiceList(const DnsHeader &header, const QSection &query)
+	void BonjourServiceImpl::BuildServiceList()
 	{
+		//called by Register, holding m_mtxMapServicesLock. The answer name is always the query name, so it can be built beforehand
+		static const LabelsVector_t g_vecServicesQuery{ "_services", "_dns-sd", "_udp", LOCAL_DOMAIN_NAME };
+
+		//id is patched when sending
 		DnsHeader rheader = { 0 };
 
-		rheader.m_uId = header.m_uId;
 		rheader.SetResponseBit();
 		rheader.SetAuthorityBit();
 
@@ -920,7 +934,7 @@ READ_NAME_AGAIN:
 
 		for (const auto &service : m_mapServices)
 		{
-			writer.WriteNames(query.m_vecLabels);
+			writer.WriteNames(g_vecServicesQuery);
 
 			writer.WriteWord(QTYPE_PTR);
 			writer.WriteWord(QCLASS_IN);
@@ -945,7 +959,21 @@ READ_NAME_AGAIN:
 			writer.Seek(finalPos);
 		}
 
-		writer.Send(m_clSocket);
+		m_vecServiceListReply.assign(writer.GetData(), writer.GetData() + writer.GetSize());
+	}
+
+	void BonjourServiceImpl::SendServiceList(const DnsHeader &header)
+	{
+		std::lock_guard guard{ m_mtxMapServicesLock };
+
+		if (m_vecServiceListReply.empty())
+			return;
+
+		//echo the query id, network order
+		m_vecServiceListReply[0] = static_cast<uint8_t>(header.m_uId >> 8);
+		m_vecServiceListReply[1] = static_cast<uint8_t>(header.m_uId & 0xFF);
+
+		m_clSocket.Send(g_clDnsAddress, m_vecServiceListReply.data(), m_vecServiceListReply.size());
 	}
 	
 	///////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,83 @@
+// Copyright (C) 2019 - Bruno Sanches. See the COPYRIGHT
+// file at the top-level directory of this distribution.
+//
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+//
+// This Source Code Form is "Incompatible With Secondary Licenses", as
+// defined by the Mozilla Public License, v. 2.0.
+
+#include "ChangeLog.h"
+
+#include <algorithm>
+#include <stdexcept>
+#include <string_view>
+#include <unordered_set>
+
+namespace dcclite::broker::sys
+{
+	ChangeLog::ChangeLog(uint64_t initialVersion, size_t capacity):
+		m_uCapacity{ capacity },
+		m_uOldestVersion{ initialVersion },
+		m_uVersion{ initialVersion }
+	{
+		if (capacity == 0)
+			throw std::invalid_argument("[ChangeLog] Capacity cannot be zero");
+	}
+
+	static bool CompareVersion(uint64_t version, const ChangeLog::Change &change) noexcept
+	{
+		return version < change.m_uVersion;
+	}
+
+	void ChangeLog::Record(uint64_t version, ObjectManagerEvent::EventType type, std::string path)
+	{
+		if (m_dqChanges.size() == m_uCapacity)
+		{
+			m_uOldestVersion = m_dqChanges.front().m_uVersion;
+
+			m_dqChanges.pop_front();
+		}
+
+		//too old, already out of the window
+		if (version <= m_uOldestVersion) [[unlikely]]
+			return;
+
+		if (version > m_uVersion) [[likely]]
+		{
+			m_dqChanges.push_back(Change{ version, type, std::move(path) });
+
+			m_uVersion = version;
+		}
+		else
+		{
+			//an event fired while the service was still dispatching a previous one may arrive first
+			m_dqChanges.insert(std::upper_bound(m_dqChanges.begin(), m_dqChanges.end(), version, CompareVersion), Change{ version, type, std::move(path) });
+		}
+	}
+
+	bool ChangeLog::TryGetChangesSince(uint64_t version, std::vector<const Change *> &changes) const
+	{
+		if ((version < m_uOldestVersion) || (version > m_uVersion))
+			return false;
+
+		auto begin = std::upper_bound(m_dqChanges.begin(), m_dqChanges.end(), version, CompareVersion);
+
+		const auto initialSize = changes.size();
+
+		//walk from the newest change, so only the last one of each path is kept
+		std::unordered_set<std::string_view> paths;
+		for (auto it = m_dqChanges.end(); it != begin;)
+		{
+			--it;
+
+			if (paths.insert(it->m_strPath).second)
+				changes.push_back(&(*it));
+		}
+
+		std::reverse(changes.begin() + initialSize, changes.end());
+
+		return true;
+	}
+}
@@ -0,0 +1,72 @@
+// Copyright (C) 2019 - Bruno Sanches. See the COPYRIGHT
+// file at the top-level directory of this distribution.
+//
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+//
+// This Source Code Form is "Incompatible With Secondary Licenses", as
+// defined by the Mozilla Public License, v. 2.0.
+
+#pragma once
+
+#include <deque>
+#include <string>
+#include <vector>
+
+#include "Service.h"
+
+namespace dcclite::broker::sys
+{
+	/**
+	*
+	* Keeps the last changes of a service (see ObjectManagerEvent::m_uVersion), so clients that missed some
+	* notifications can ask only for what changed instead of downloading everything again.
+	*
+	* Only the path and the event type are stored, items state is read again when the changes are requested, so
+	* memory use is bounded by the capacity and does not depend on the items size.
+	*
+	*/
+	class ChangeLog
+	{
+		public:
+			static constexpr size_t DEFAULT_CAPACITY = 1024;
+
+			struct Change
+			{
+				uint64_t						m_uVersion;
+				ObjectManagerEvent::EventType	m_kType;
+				std::string						m_strPath;
+			};
+
+			/**
+			* initialVersion: service version when the log starts, anything before it is unknown
+			*/
+			explicit ChangeLog(uint64_t initialVersion, size_t capacity = DEFAULT_CAPACITY);
+
+			void Record(uint64_t version, ObjectManagerEvent::EventType type, std::string path);
+
+			/**
+			* Fills changes with the last change of each path modified after version, in version order.
+			* 
+			* Returns false if the log does not have all the changes after version (old or future version), so 
+			* the client must reload everything.
+			*/
+			bool TryGetChangesSince(uint64_t version, std::vector<const Change *> &changes) const;
+
+			inline uint64_t GetVersion() const noexcept
+			{
+				return m_uVersion;
+			}
+
+		private:
+			std::deque<Change>	m_dqChanges;
+
+			size_t				m_uCapacity;
+
+			//all changes after this version are on the log
+			uint64_t			m_uOldestVersion;
+
+			uint64_t			m_uVersion;
+	};
+}
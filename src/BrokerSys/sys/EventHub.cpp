@@ -10,15 +10,29 @@
 
 #include "EventHub.h"
 
+#include <algorithm>
+#include <array>
 #include <condition_variable>
 #include <list>
 #include <memory>
 #include <mutex>
 #include <new>
+#include <stdexcept>
+#include <thread>
 
 #include <dcclite/Clock.h>
 #include <dcclite/Log.h>
 
+#include "Timeouts.h"
+
+#ifndef WIN32
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+#endif
+
 namespace dcclite::broker::sys
 {
 	class ObjectPool
@@ -33,8 +47,7 @@ namespace dcclite::broker::sys
 
 			void *Alloc(size_t sz)
 			{
-				auto usedMem = this->GetUsedMem();
-				if (usedMem + sz > m_u32Size)
+				if (!this->HasRoom(sz))
 				{
 					dcclite::Log::Critical("[ObjectPool::Alloc] Not enough memory for extra {} bytes, throwing bad::alloc", sz);
 
@@ -66,6 +79,11 @@ namespace dcclite::broker::sys
 				return m_pBase - m_upPool.get();
 			}
 
+			bool HasRoom(size_t sz) const noexcept
+			{
+				return this->GetUsedMem() + sz <= m_u32Size;
+			}
+
 		private:
 			uint32_t m_u32Size;
 
@@ -133,9 +151,10 @@ namespace dcclite::broker::sys
 					}										
 				}
 
-				void RemoveTarget(const IEventTarget &target) noexcept
+				size_t RemoveTarget(const IEventTarget &target) noexcept
 				{
 					auto *p = m_pclHead;
+					size_t count = 0;
 
 					while (p)
 					{
@@ -145,10 +164,58 @@ namespace dcclite::broker::sys
 							this->RemoveNode(p);
 
 							delete p;
+							++count;
 						}
 
 						p = next;
 					}
+
+					return count;
+				}
+
+				void DropFront() noexcept
+				{
+					auto *p = m_pclHead;
+
+					assert(p);
+
+					this->RemoveNode(p);
+
+					delete p;
+				}
+
+				IEvent *TryFind(IEvent &event, const size_t coalesceKey) noexcept
+				{
+					for (auto p = m_pclHead; p; p = p->m_pclNext)
+					{
+						if ((&p->GetTarget() == &event.GetTarget()) && (p->GetCoalesceKey() == coalesceKey))
+							return p;
+					}
+
+					return nullptr;
+				}
+
+				/**
+				* The new event takes the old one place on the queue, the old one is destroyed
+				*/
+				void Replace(IEvent *node, std::unique_ptr<IEvent> event) noexcept
+				{
+					auto *p = event.release();
+
+					p->m_pclPrev = node->m_pclPrev;
+					p->m_pclNext = node->m_pclNext;
+
+					if (p->m_pclPrev)
+						p->m_pclPrev->m_pclNext = p;
+					else
+						m_pclHead = p;
+
+					if (p->m_pclNext)
+						p->m_pclNext->m_pclPrev = p;
+					else
+						m_pclLast = p;
+
+					delete node;
 				}
 
 				void RemoveNode(IEvent *node) noexcept
@@ -214,23 +281,109 @@ namespace dcclite::broker::sys
 		};
 
 
-		/// <summary>
-		/// The only purpose of this structure is to make sure we a have a chance to clear the queue before the pools are destroyed 
-		/// </summary>
+		struct Lane
+		{
+			Lane(const LaneConfig &config, uint32_t poolSize):
+				m_arPools{ ObjectPool{ poolSize }, ObjectPool{ poolSize } },
+				m_clConfig{ config }
+			{
+				//empty
+			}
+
+			ObjectPool &GetPool() noexcept
+			{
+				return m_arPools[m_iActivePool];
+			}
+
+			bool IsFull() const noexcept
+			{
+				return m_clConfig.m_uCapacity && (m_uDepth >= m_clConfig.m_uCapacity);
+			}
+
+			//declared before the queue, so the queue is cleared before the pools are destroyed
+			ObjectPool				m_arPools[2];
+			int						m_iActivePool = 0;
+
+			EventQueue				m_clQueue;
+			LaneConfig				m_clConfig;
+
+			//producers blocked by the BLOCK policy
+			std::condition_variable	m_clRoomMonitor;
+
+			size_t					m_uDepth = 0;
+			size_t					m_uPeakDepth = 0;
+
+			uint64_t				m_uNumDropped = 0;
+			uint64_t				m_uNumCoalesced = 0;
+			uint64_t				m_uNumBlocked = 0;
+		};
+
+		typedef std::array<EventQueue, NUM_LANES> EventBatch_t;
+
 		struct EventHubData
 		{
-			EventQueue				m_lstEventQueue;
 			std::mutex				m_mtxEventQueueLock;
 			std::condition_variable	m_clQueueMonitor;
 
-			ObjectPool				m_arPools[2]{ ObjectPool{4096 * 8}, ObjectPool{4096 * 8} };
+			Lane					m_arLanes[NUM_LANES]{
+				{ LaneConfig{ 0, OverflowPolicies::BLOCK }, 4096 * 8 },				//CONTROL
+				{ LaneConfig{ 256, OverflowPolicies::DROP_OLDEST }, 4096 * 16 },	//NETWORK
+				{ LaneConfig{ 64, OverflowPolicies::BLOCK }, 4096 * 8 },			//TERMINAL
+				{ LaneConfig{ 32, OverflowPolicies::COALESCE }, 4096 * 2 }			//BACKGROUND
+			};
 
-			int						m_iActivePool = 0;
+			//set by Lock, used by IEvent::operator new and DoPostEvent
+			Lane					*m_pclPostLane = nullptr;
+
+			//the thread firing the events, it cannot block waiting for them
+			std::thread::id			m_tPumpThread;
+
+			Lane &GetLane(const Lanes lane) noexcept
+			{
+				return m_arLanes[static_cast<size_t>(lane)];
+			}
+
+			bool IsEmpty() const noexcept
+			{
+				for (auto &lane : m_arLanes)
+				{
+					if (lane.m_uDepth)
+						return false;
+				}
+
+				return true;
+			}
+
+#ifndef WIN32
+			int						m_iWakeEvent = -1;
+
+			EventHubData()
+			{
+				m_iWakeEvent = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+				if (m_iWakeEvent < 0)
+					throw std::runtime_error(fmt::format("[EventHub::EventHubData] eventfd failed: {}", strerror(errno)));
+			}
+
+			void SignalWakeEvent() noexcept
+			{
+				const uint64_t value = 1;
+
+				[[maybe_unused]] auto rc = write(m_iWakeEvent, &value, sizeof(value));
+			}
+
+			void ClearWakeEvent() noexcept
+			{
+				uint64_t value;
+
+				[[maybe_unused]] auto rc = read(m_iWakeEvent, &value, sizeof(value));
+			}
+#endif
 
 			~EventHubData()
 			{
-				//clear the queue before the pools are destroyed
-				m_lstEventQueue = EventQueue{};
+#ifndef WIN32
+				close(m_iWakeEvent);
+#endif
 			}
 		};	
 
@@ -239,7 +392,10 @@ namespace dcclite::broker::sys
 #ifdef DCCLITE_EVENT_HUB_INTERNAL_POOL
 		void *IEvent::operator new(size_t size)
 		{			
-			return g_sData.m_arPools[g_sData.m_iActivePool].Alloc(size);
+			//not created by PostEvent? Use the unbounded lane, like the old single pool
+			auto *lane = g_sData.m_pclPostLane ? g_sData.m_pclPostLane : &g_sData.GetLane(Lanes::CONTROL);
+
+			return lane->GetPool().Alloc(size);
 		}
 
 		void IEvent::operator delete(void *p)
@@ -251,23 +407,98 @@ namespace dcclite::broker::sys
 		namespace detail
 		{
 #ifdef DCCLITE_EVENT_HUB_INTERNAL_POOL
-			void Lock()
+			bool Lock(const Lanes laneId, const size_t eventSize)
 			{
-				g_sData.m_mtxEventQueueLock.lock();
+				std::unique_lock<std::mutex> guard{ g_sData.m_mtxEventQueueLock };
+
+				auto &lane = g_sData.GetLane(laneId);
+
+				//unbounded lanes behave like a single queue, the pool may throw
+				if (lane.m_clConfig.m_uCapacity)
+				{
+					auto hasRoom = [&lane, eventSize] { return !lane.IsFull() && lane.GetPool().HasRoom(eventSize); };
+
+					if (lane.m_clConfig.m_tPolicy == OverflowPolicies::BLOCK)
+					{
+						//the pump thread would wait for itself
+						if (!hasRoom() && (std::this_thread::get_id() != g_sData.m_tPumpThread))
+						{
+							++lane.m_uNumBlocked;
+
+							lane.m_clRoomMonitor.wait_for(guard, EVENT_HUB_LANE_BLOCK_TIMEOUT, hasRoom);
+						}
+					}
+					else if (!lane.GetPool().HasRoom(eventSize))
+					{
+						//dropping queued events does not give memory back before the next pump, so this one goes away
+						++lane.m_uNumDropped;
+
+						return false;
+					}
+				}
+
+				g_sData.m_pclPostLane = &lane;
+
+				//DoPostEvent or Unlock releases it
+				guard.release();
+
+				return true;
 			}
 
 			void Unlock()
 			{
+				g_sData.m_pclPostLane = nullptr;
+
 				g_sData.m_mtxEventQueueLock.unlock();
 			}
 
 			void DoPostEvent(std::unique_ptr<IEvent> event)
-			{				
-				g_sData.m_lstEventQueue.PushBack(std::move(event));
+			{
+				auto &lane = *std::exchange(g_sData.m_pclPostLane, nullptr);
+
+#ifndef WIN32
+				//if the queue is not empty, the loop was already woken and will take this one too
+				const bool wasEmpty = g_sData.IsEmpty();
+#endif
+
+				if (lane.m_clConfig.m_tPolicy == OverflowPolicies::COALESCE)
+				{
+					const auto key = event->GetCoalesceKey();
+
+					auto *queued = key ? lane.m_clQueue.TryFind(*event, key) : nullptr;
+					if (queued)
+					{
+						lane.m_clQueue.Replace(queued, std::move(event));
+						++lane.m_uNumCoalesced;
+
+						//depth did not change and the queue was not empty, nobody to notify
+						g_sData.m_mtxEventQueueLock.unlock();
+
+						return;
+					}
+				}
+
+				if (lane.IsFull() && (lane.m_clConfig.m_tPolicy != OverflowPolicies::BLOCK))
+				{
+					lane.m_clQueue.DropFront();
+
+					--lane.m_uDepth;
+					++lane.m_uNumDropped;
+				}
+
+				lane.m_clQueue.PushBack(std::move(event));
+
+				++lane.m_uDepth;
+				lane.m_uPeakDepth = std::max(lane.m_uPeakDepth, lane.m_uDepth);
 
 				g_sData.m_mtxEventQueueLock.unlock();
 
 				g_sData.m_clQueueMonitor.notify_one();
+
+#ifndef WIN32
+				if (wasEmpty)
+					g_sData.SignalWakeEvent();
+#endif
 			}
 #else
 
@@ -302,14 +533,45 @@ namespace dcclite::broker::sys
 			}
 		}		
 
+		static EventBatch_t TakeEvents()
+		{
+			EventBatch_t batch;
+
+			for (size_t i = 0; i < NUM_LANES; ++i)
+			{
+				auto &lane = g_sData.m_arLanes[i];
+
+				batch[i] = std::move(lane.m_clQueue);
+				lane.m_uDepth = 0;
+
+#ifdef DCCLITE_EVENT_HUB_INTERNAL_POOL
+				lane.m_iActivePool = lane.m_iActivePool ? 0 : 1;
+				lane.GetPool().Reset();
+#endif
+
+				lane.m_clRoomMonitor.notify_all();
+			}
+
+			return batch;
+		}
+
+		static void FireBatch(EventBatch_t &batch)
+		{
+			for (auto &queue : batch)
+				queue.FireTargets();
+		}
+
 		void PumpEvents(const std::optional<Clock::DefaultClock_t::time_point> &timeoutTime)
 		{
-			EventQueue eventQueue;			
+			EventBatch_t batch;
 
 			{
 				std::unique_lock<std::mutex> guard{ g_sData.m_mtxEventQueueLock };
 
-				auto listLambda = [] { return !g_sData.m_lstEventQueue.IsEmpty(); };
+				//before waiting, so a post from here does not wait for room on a blocking lane
+				g_sData.m_tPumpThread = std::this_thread::get_id();
+
+				auto listLambda = [] { return !g_sData.IsEmpty(); };
 				if (timeoutTime)
 				{
 					g_sData.m_clQueueMonitor.wait_until<dcclite::Clock::DefaultClock_t>(guard, timeoutTime.value(), listLambda);
@@ -319,24 +581,98 @@ namespace dcclite::broker::sys
 					g_sData.m_clQueueMonitor.wait(guard, listLambda);
 				}									
 								
-				eventQueue = std::move(g_sData.m_lstEventQueue);
-				
-#ifdef DCCLITE_EVENT_HUB_INTERNAL_POOL
-				g_sData.m_iActivePool = g_sData.m_iActivePool ? 0 : 1;
-				g_sData.m_arPools[g_sData.m_iActivePool].Reset();
-#endif
+				batch = TakeEvents();
 			}
 
 			//
 			//process events				
-			eventQueue.FireTargets();			
+			FireBatch(batch);
+		}
+
+		void FireEvents()
+		{
+#ifndef WIN32
+			//clear before taking the queue, anything posted after this signals again
+			g_sData.ClearWakeEvent();
+#endif
+
+			EventBatch_t batch;
+
+			{
+				std::unique_lock<std::mutex> guard{ g_sData.m_mtxEventQueueLock };
+
+				g_sData.m_tPumpThread = std::this_thread::get_id();
+
+				if (g_sData.IsEmpty())
+					return;
+
+				batch = TakeEvents();
+			}
+
+			FireBatch(batch);
+		}
+
+		void SetPumpThread()
+		{
+			std::unique_lock<std::mutex> guard{ g_sData.m_mtxEventQueueLock };
+
+			g_sData.m_tPumpThread = std::this_thread::get_id();
+		}
+
+#ifndef WIN32
+		int GetWakeUpHandle() noexcept
+		{
+			return g_sData.m_iWakeEvent;
 		}
+#endif
 
 		void CancelEvents(const IEventTarget &target)
 		{
 			std::unique_lock<std::mutex> guard{ g_sData.m_mtxEventQueueLock };
 
-			g_sData.m_lstEventQueue.RemoveTarget(target);
+			for (auto &lane : g_sData.m_arLanes)
+			{
+				const auto count = lane.m_clQueue.RemoveTarget(target);
+				if (!count)
+					continue;
+
+				lane.m_uDepth -= count;
+				lane.m_clRoomMonitor.notify_all();
+			}
+		}
+
+		void ConfigureLane(const Lanes lane, const LaneConfig &config)
+		{
+			std::unique_lock<std::mutex> guard{ g_sData.m_mtxEventQueueLock };
+
+			auto &data = g_sData.GetLane(lane);
+
+			data.m_clConfig = config;
+
+			//a bigger capacity may have room for the blocked ones
+			data.m_clRoomMonitor.notify_all();
+		}
+
+		LaneConfig GetLaneConfig(const Lanes lane)
+		{
+			std::unique_lock<std::mutex> guard{ g_sData.m_mtxEventQueueLock };
+
+			return g_sData.GetLane(lane).m_clConfig;
+		}
+
+		LaneStats GetLaneStats(const Lanes lane)
+		{
+			std::unique_lock<std::mutex> guard{ g_sData.m_mtxEventQueueLock };
+
+			auto &data = g_sData.GetLane(lane);
+
+			return LaneStats{
+				data.m_uDepth,
+				data.m_uPeakDepth,
+				data.m_uNumDropped,
+				data.m_uNumCoalesced,
+				data.m_uNumBlocked
+			};
 		}
 	}	
 }
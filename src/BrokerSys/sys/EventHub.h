@@ -11,6 +11,7 @@
 
 #pragma once
 
+#include <cstdint>
 #include <functional>
 #include <memory>
 #include <optional>
@@ -24,6 +25,45 @@ namespace dcclite::broker::sys
 {
 	namespace EventHub
 	{
+		/**
+		* Each lane has its own queue and pool, so a flood on one lane cannot starve or exhaust the others.
+		*
+		* Lanes are fired in this order on every pump
+		*/
+		enum class Lanes
+		{
+			CONTROL,		//lifetime and main thread work (quit, socket readiness, fibers), never dropped
+			NETWORK,		//device traffic, loss tolerant
+			TERMINAL,		//terminal and DCC++ clients
+			BACKGROUND		//file watchers and other slow stuff
+		};
+
+		constexpr size_t NUM_LANES = 4;
+
+		enum class OverflowPolicies
+		{
+			BLOCK,			//the producer waits for room up to EVENT_HUB_LANE_BLOCK_TIMEOUT, then queues over the capacity
+			DROP_OLDEST,	//the oldest queued event of the lane is destroyed
+			COALESCE		//replaces a queued event with the same target and key, otherwise drops the oldest
+		};
+
+		struct LaneConfig
+		{
+			//zero for unbounded lanes, those are limited only by the pool, like a single queue
+			size_t				m_uCapacity;
+			OverflowPolicies	m_tPolicy;
+		};
+
+		struct LaneStats
+		{
+			size_t		m_uDepth;
+			size_t		m_uPeakDepth;
+
+			uint64_t	m_uNumDropped;
+			uint64_t	m_uNumCoalesced;
+			uint64_t	m_uNumBlocked;
+		};
+
 		class IEventTarget
 		{
 			public:
@@ -48,11 +88,24 @@ namespace dcclite::broker::sys
 
 				virtual void Fire() = 0;
 
+				/**
+				* Used only on COALESCE lanes, queued events with the same target and key are replaced by the newer one.
+				*
+				* Zero means the event is never coalesced
+				*/
+				virtual size_t GetCoalesceKey() const noexcept
+				{
+					return 0;
+				}
+
 				inline IEventTarget &GetTarget() noexcept
 				{
 					return m_rclTarget;
 				}
 
+				//events hide this to use another lane
+				static constexpr Lanes LANE = Lanes::CONTROL;
+
 #ifdef DCCLITE_EVENT_HUB_INTERNAL_POOL
 				void *operator new(size_t size);
 				void operator delete(void *p);
@@ -71,7 +124,12 @@ namespace dcclite::broker::sys
 		{
 			void DoPostEvent(std::unique_ptr<IEvent> event);
 
-			void Lock();
+			/**
+			* Locks the hub and selects the lane pool, applying the lane overflow policy first.
+			*
+			* Returns false when the event must be dropped, the hub is not locked in this case
+			*/
+			bool Lock(const Lanes lane, const size_t eventSize);
 			void Unlock();
 
 			//for unit testing...
@@ -83,15 +141,47 @@ namespace dcclite::broker::sys
 		}
 		void PumpEvents(const std::optional<Clock::DefaultClock_t::time_point> &timeoutTime);
 
+		/**
+		* Fires the queued events without waiting, for loops that do the waiting by themselves (see MainLoop)
+		*/
+		void FireEvents();
+
+		/**
+		* Marks the calling thread as the one firing the events, posts from it never wait for room on a blocking lane.
+		*
+		* PumpEvents and FireEvents do it too, this is for events posted before the first pump (see MainLoop::Start)
+		*/
+		void SetPumpThread();
+
+#ifndef WIN32
+		/**
+		* eventfd signaled when an event is posted to an empty queue, so epoll based loops can wait for events.
+		*
+		* FireEvents clears it
+		*/
+		int GetWakeUpHandle() noexcept;
+#endif
+
 		void CancelEvents(const IEventTarget &target);
 
+		/**
+		* Replaces the lane limits, events already queued are kept even if above the new capacity
+		*/
+		void ConfigureLane(const Lanes lane, const LaneConfig &config);
+
+		LaneConfig GetLaneConfig(const Lanes lane);
+		LaneStats GetLaneStats(const Lanes lane);
+
 #ifdef DCCLITE_EVENT_HUB_INTERNAL_POOL
 		template <typename T, typename... Args>
 		void PostEvent(Args ...args)
 		{
 			//
 			//we must lock before creating the event, because it will use the pool and we must guarantee that the pool will stay until the event is posted
-			detail::Lock();
+			//
+			//the lane may also wait for room or tell us to drop the event
+			if (!detail::Lock(T::LANE, sizeof(T)))
+				return;
 
 			std::unique_ptr<IEvent> ptr;
 
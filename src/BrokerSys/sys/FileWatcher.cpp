@@ -106,6 +106,8 @@ namespace dcclite::broker::sys::FileWatcher
 	class FileWatcherEvent : public EventHub::IEvent
 	{
 		public:
+			static constexpr EventHub::Lanes LANE = EventHub::Lanes::BACKGROUND;
+
 			FileWatcherEvent(EventTarget &target, const ldmonitor::fs::path &path, std::string fileName, std::chrono::milliseconds time) :
 				IEvent(target),
 				m_pthPath{ path },
@@ -126,6 +128,14 @@ namespace dcclite::broker::sys::FileWatcher
 				it->second.TryFireEvent(std::move(m_pthPath), std::move(m_strFileName), m_tTime);
 			}
 
+			size_t GetCoalesceKey() const noexcept override
+			{
+				//editors write the same file several times in a row, only the last one matters
+				const auto key = hash_value(m_pthPath) ^ std::hash<std::string>{}(m_strFileName);
+
+				return key ? key : 1;
+			}
+
 		private:
 			ldmonitor::fs::path			m_pthPath;
 			std::string					m_strFileName;
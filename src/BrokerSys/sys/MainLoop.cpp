@@ -0,0 +1,304 @@
+// Copyright (C) 2019 - Bruno Sanches. See the COPYRIGHT
+// file at the top-level directory of this distribution.
+//
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+//
+// This Source Code Form is "Incompatible With Secondary Licenses", as
+// defined by the Mozilla Public License, v. 2.0.
+
+#include "MainLoop.h"
+
+#include <memory>
+#include <optional>
+#include <stdexcept>
+#include <type_traits>
+#include <unordered_map>
+
+#include <fmt/format.h>
+
+#include <dcclite/Clock.h>
+#include <dcclite/Log.h>
+
+#include "EventHub.h"
+#include "Thinker.h"
+
+#ifndef WIN32
+#include <sys/epoll.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+#endif
+
+namespace dcclite::broker::sys::MainLoop
+{
+#ifdef WIN32
+
+	static bool g_fStarted = false;
+
+	void Start()
+	{
+		if (g_fStarted)
+			throw std::logic_error("[MainLoop::Start] already called??");
+
+		g_fStarted = true;
+
+		EventHub::SetPumpThread();
+	}
+
+	void Stop()
+	{
+		g_fStarted = false;
+	}
+
+	bool IsStarted() noexcept
+	{
+		return g_fStarted;
+	}
+
+	void RunOnce()
+	{
+		auto timeout = Thinker::UpdateThinkers(Clock::DefaultClock_t::now());
+
+		EventHub::PumpEvents(timeout);
+	}
+
+#else
+
+	//timerfd must use the same clock as the thinkers, so deadlines can be armed as absolute times
+	constexpr clockid_t TIMER_CLOCK = std::is_same_v<Clock::DefaultClock_t, std::chrono::system_clock> ? CLOCK_REALTIME : CLOCK_MONOTONIC;
+
+	//ids 0 and 1 are the loop handles, watched handles start after them
+	constexpr uint64_t TIMER_ID = 0;
+	constexpr uint64_t EVENTS_ID = 1;
+
+	class Loop
+	{
+		public:
+			Loop();
+			~Loop();
+
+			void RunOnce();
+
+			void Watch(IFdHandler &handler, const int fd, const uint32_t events);
+			void Unwatch(const int fd);
+
+		private:
+			void ArmTimer(const std::optional<Clock::DefaultClock_t::time_point> deadline);
+
+		private:
+			struct Entry
+			{
+				IFdHandler	*m_pclHandler;
+				uint64_t	m_uId;
+			};
+
+			int m_iEpoll = -1;
+			int m_iTimer = -1;
+
+			//the timer is only touched when the earliest deadline changes
+			std::optional<Clock::DefaultClock_t::time_point> m_tArmedDeadline;
+
+			//epoll reports ids, so a handle unwatched by an earlier handler on the same wake up is simply ignored
+			std::unordered_map<int, Entry>	m_mapEntries;
+			std::unordered_map<uint64_t, int> m_mapIds;
+
+			uint64_t m_uNextId = EVENTS_ID + 1;
+	};
+
+	Loop::Loop()
+	{
+		m_iEpoll = epoll_create1(EPOLL_CLOEXEC);
+		if (m_iEpoll < 0)
+			throw std::runtime_error(fmt::format("[MainLoop::Loop] epoll_create1 failed: {}", strerror(errno)));
+
+		m_iTimer = timerfd_create(TIMER_CLOCK, TFD_CLOEXEC | TFD_NONBLOCK);
+		if (m_iTimer < 0)
+		{
+			const auto error = errno;
+			close(m_iEpoll);
+
+			throw std::runtime_error(fmt::format("[MainLoop::Loop] timerfd_create failed: {}", strerror(error)));
+		}
+
+		epoll_event ev{};
+		ev.events = EPOLLIN;
+
+		ev.data.u64 = TIMER_ID;
+		epoll_ctl(m_iEpoll, EPOLL_CTL_ADD, m_iTimer, &ev);
+
+		ev.data.u64 = EVENTS_ID;
+		epoll_ctl(m_iEpoll, EPOLL_CTL_ADD, EventHub::GetWakeUpHandle(), &ev);
+	}
+
+	Loop::~Loop()
+	{
+		close(m_iTimer);
+		close(m_iEpoll);
+	}
+
+	void Loop::ArmTimer(const std::optional<Clock::DefaultClock_t::time_point> deadline)
+	{
+		if (deadline == m_tArmedDeadline)
+			return;
+
+		itimerspec spec{};
+
+		if (deadline)
+		{
+			const auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(deadline->time_since_epoch()).count();
+
+			spec.it_value.tv_sec = ns / 1000000000;
+			spec.it_value.tv_nsec = ns % 1000000000;
+
+			//a zero value disarms the timer
+			if (!spec.it_value.tv_sec && !spec.it_value.tv_nsec)
+				spec.it_value.tv_nsec = 1;
+		}
+
+		if (timerfd_settime(m_iTimer, TFD_TIMER_ABSTIME, &spec, nullptr) < 0)
+			throw std::runtime_error(fmt::format("[MainLoop::ArmTimer] timerfd_settime failed: {}", strerror(errno)));
+
+		m_tArmedDeadline = deadline;
+	}
+
+	void Loop::RunOnce()
+	{
+		this->ArmTimer(Thinker::UpdateThinkers(Clock::DefaultClock_t::now()));
+
+		epoll_event events[32];
+
+		const auto count = epoll_wait(m_iEpoll, events, std::size(events), -1);
+		if (count < 0)
+		{
+			if (errno == EINTR)
+				return;
+
+			throw std::runtime_error(fmt::format("[MainLoop::RunOnce] epoll_wait failed: {}", strerror(errno)));
+		}
+
+		bool fireEvents = false;
+
+		for (int i = 0; i < count; ++i)
+		{
+			const auto id = events[i].data.u64;
+
+			if (id == TIMER_ID)
+			{
+				uint64_t expirations;
+				[[maybe_unused]] auto rc = read(m_iTimer, &expirations, sizeof(expirations));
+
+				//expired, so it must be armed again even if the deadline does not change
+				m_tArmedDeadline.reset();
+			}
+			else if (id == EVENTS_ID)
+			{
+				//fire after the handlers, so events posted by them do not need another wake up
+				fireEvents = true;
+			}
+			else
+			{
+				auto it = m_mapIds.find(id);
+				if (it == m_mapIds.end())
+					continue;
+
+				m_mapEntries[it->second].m_pclHandler->OnFdReady(events[i].events);
+			}
+		}
+
+		if (fireEvents)
+			EventHub::FireEvents();
+	}
+
+	void Loop::Watch(IFdHandler &handler, const int fd, const uint32_t events)
+	{
+		epoll_event ev{};
+		ev.events = events;
+
+		auto it = m_mapEntries.find(fd);
+		if (it != m_mapEntries.end())
+		{
+			ev.data.u64 = it->second.m_uId;
+
+			if (epoll_ctl(m_iEpoll, EPOLL_CTL_MOD, fd, &ev) < 0)
+				throw std::runtime_error(fmt::format("[MainLoop::Watch] epoll_ctl MOD failed: {}", strerror(errno)));
+
+			it->second.m_pclHandler = &handler;
+
+			return;
+		}
+
+		const auto id = m_uNextId++;
+		ev.data.u64 = id;
+
+		if (epoll_ctl(m_iEpoll, EPOLL_CTL_ADD, fd, &ev) < 0)
+			throw std::runtime_error(fmt::format("[MainLoop::Watch] epoll_ctl ADD failed: {}", strerror(errno)));
+
+		m_mapEntries.emplace(fd, Entry{ &handler, id });
+		m_mapIds.emplace(id, fd);
+	}
+
+	void Loop::Unwatch(const int fd)
+	{
+		auto it = m_mapEntries.find(fd);
+		if (it == m_mapEntries.end())
+			return;
+
+		//may fail if the handle is already closed, nothing to do about it
+		epoll_ctl(m_iEpoll, EPOLL_CTL_DEL, fd, nullptr);
+
+		m_mapIds.erase(it->second.m_uId);
+		m_mapEntries.erase(it);
+	}
+
+	static std::unique_ptr<Loop> g_upLoop;
+
+	void Start()
+	{
+		if (g_upLoop)
+			throw std::logic_error("[MainLoop::Start] already called??");
+
+		g_upLoop = std::make_unique<Loop>();
+
+		EventHub::SetPumpThread();
+
+		dcclite::Log::Trace("[MainLoop::Start] epoll loop ready");
+	}
+
+	void Stop()
+	{
+		g_upLoop.reset();
+	}
+
+	bool IsStarted() noexcept
+	{
+		return g_upLoop != nullptr;
+	}
+
+	void RunOnce()
+	{
+		if (!g_upLoop)
+			throw std::logic_error("[MainLoop::RunOnce] Start not called");
+
+		g_upLoop->RunOnce();
+	}
+
+	void Watch(IFdHandler &handler, const int fd, const uint32_t events)
+	{
+		if (!g_upLoop)
+			throw std::logic_error("[MainLoop::Watch] Start not called");
+
+		g_upLoop->Watch(handler, fd, events);
+	}
+
+	void Unwatch(const int fd)
+	{
+		if (g_upLoop)
+			g_upLoop->Unwatch(fd);
+	}
+
+#endif
+}
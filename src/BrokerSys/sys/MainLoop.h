@@ -0,0 +1,67 @@
+// Copyright (C) 2019 - Bruno Sanches. See the COPYRIGHT
+// file at the top-level directory of this distribution.
+//
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+//
+// This Source Code Form is "Incompatible With Secondary Licenses", as
+// defined by the Mozilla Public License, v. 2.0.
+
+#pragma once
+
+#include <cstdint>
+
+/**
+
+	Broker main thread loop: runs the thinkers, waits for work and fires the EventHub events.
+
+	On Linux a single epoll waits for everything: a timerfd armed with the earliest thinker deadline, the EventHub
+	eventfd (signaled by PostEvent) and any handle registered with Watch. The thread sleeps until the next real work
+	item and wakes exactly once for it.
+
+	Other platforms run the Thinker::UpdateThinkers / EventHub::PumpEvents loop.
+
+*/
+namespace dcclite::broker::sys::MainLoop
+{
+	/**
+	* Creates the loop, call it before creating services so they can watch their handles
+	*/
+	void Start();
+
+	/**
+	* Destroys the loop, handles still watched are forgotten
+	*/
+	void Stop();
+
+	bool IsStarted() noexcept;
+
+	/**
+	* Runs the due thinkers, waits for the next deadline, event or watched handle and dispatches it
+	*/
+	void RunOnce();
+
+#ifndef WIN32
+	class IFdHandler
+	{
+		public:
+			virtual ~IFdHandler() = default;
+
+			/**
+			* Called on the main thread with the epoll events (EPOLLIN, EPOLLOUT, ...), watches are level triggered
+			*/
+			virtual void OnFdReady(const uint32_t events) = 0;
+	};
+
+	/**
+	* Watches a file descriptor (socket, pipe, serial port, another epoll...), requires Start
+	*/
+	void Watch(IFdHandler &handler, const int fd, const uint32_t events);
+
+	/**
+	* Stops watching, does nothing if the loop was already stopped
+	*/
+	void Unwatch(const int fd);
+#endif
+}
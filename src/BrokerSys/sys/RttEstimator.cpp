@@ -0,0 +1,97 @@
+// Copyright (C) 2019 - Bruno Sanches. See the COPYRIGHT
+// file at the top-level directory of this distribution.
+//
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+//
+// This Source Code Form is "Incompatible With Secondary Licenses", as
+// defined by the Mozilla Public License, v. 2.0.
+
+#include "RttEstimator.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+#include <fmt/format.h>
+
+namespace dcclite::broker::sys
+{
+	//after this, doubling the timeout will always hit the ceiling
+	static constexpr unsigned MAX_BACKOFF = 16;
+
+	RttEstimator::RttEstimator(Duration_t initialTimeout, Duration_t minTimeout, Duration_t maxTimeout):
+		m_tInitialTimeout{ initialTimeout },
+		m_tMinTimeout{ minTimeout },
+		m_tMaxTimeout{ maxTimeout },
+		m_tTimeout{ std::clamp(initialTimeout, minTimeout, maxTimeout) }
+	{
+		if ((minTimeout.count() <= 0) || (minTimeout > maxTimeout))
+			throw std::invalid_argument(fmt::format("[RttEstimator::RttEstimator] Invalid timeout range: {}us - {}us", minTimeout.count(), maxTimeout.count()));
+	}
+
+	void RttEstimator::AddSample(Duration_t rtt) noexcept
+	{
+		if (rtt.count() < 0)
+			rtt = Duration_t{};
+
+		if (m_uNumSamples == 0)
+		{
+			m_tSmoothedRtt = rtt;
+			m_tRttVariation = rtt / 2;
+		}
+		else
+		{
+			const auto delta = m_tSmoothedRtt > rtt ? m_tSmoothedRtt - rtt : rtt - m_tSmoothedRtt;
+
+			//variation first, it uses the old SRTT
+			m_tRttVariation = (m_tRttVariation * 3 + delta) / 4;
+			m_tSmoothedRtt = (m_tSmoothedRtt * 7 + rtt) / 8;
+		}
+
+		++m_uNumSamples;
+
+		m_tTimeout = std::clamp(m_tSmoothedRtt + m_tRttVariation * 4, m_tMinTimeout, m_tMaxTimeout);
+		m_uBackoff = 0;
+	}
+
+	void RttEstimator::OnTimeout() noexcept
+	{
+		++m_uNumTimeouts;
+
+		if (m_uBackoff < MAX_BACKOFF)
+			++m_uBackoff;
+	}
+
+	void RttEstimator::Reset() noexcept
+	{
+		m_tSmoothedRtt = {};
+		m_tRttVariation = {};
+		m_tTimeout = std::clamp(m_tInitialTimeout, m_tMinTimeout, m_tMaxTimeout);
+
+		m_uNumSamples = 0;
+		m_uNumTimeouts = 0;
+		m_uBackoff = 0;
+	}
+
+	RttEstimator::Duration_t RttEstimator::GetRetransmitTimeout() const noexcept
+	{
+		//shift in steps, so it stops as soon as it reaches the ceiling and never overflows
+		auto timeout = m_tTimeout;
+		for (unsigned i = 0; (i < m_uBackoff) && (timeout < m_tMaxTimeout); ++i)
+			timeout *= 2;
+
+		return std::min(timeout, m_tMaxTimeout);
+	}
+
+	void RttEstimator::Serialize(dcclite::JsonOutputStream_t &stream) const
+	{
+		using namespace std::chrono;
+
+		stream.AddFloatValue("srttMs", duration<double, std::milli>(m_tSmoothedRtt).count());
+		stream.AddFloatValue("rttVarMs", duration<double, std::milli>(m_tRttVariation).count());
+		stream.AddFloatValue("rtoMs", duration<double, std::milli>(this->GetRetransmitTimeout()).count());
+		stream.AddIntValue("samples", m_uNumSamples);
+		stream.AddIntValue("timeouts", m_uNumTimeouts);
+	}
+}
@@ -0,0 +1,94 @@
+// Copyright (C) 2019 - Bruno Sanches. See the COPYRIGHT
+// file at the top-level directory of this distribution.
+//
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+//
+// This Source Code Form is "Incompatible With Secondary Licenses", as
+// defined by the Mozilla Public License, v. 2.0.
+
+#pragma once
+
+#include <chrono>
+
+#include <dcclite/Object.h>
+
+namespace dcclite::broker::sys
+{
+	/**
+	*
+	* Round trip time estimator for a link, uses Jacobson / Karels algorithm (the same used by TCP, see RFC 6298):
+	*
+	*	SRTT = 7/8 SRTT + 1/8 sample
+	*	RTTVAR = 3/4 RTTVAR + 1/4 |SRTT - sample|
+	*	RTO = SRTT + 4 * RTTVAR
+	*
+	* The retransmission timeout is clamped between a floor and a ceiling and it is doubled after each timeout until a new
+	* sample arrives.
+	*
+	* Callers must not feed samples from retransmitted packets (Karn's algorithm), as there is no way to know which
+	* transmission the reply belongs to.
+	*
+	*/
+	class RttEstimator
+	{
+		public:
+			typedef std::chrono::microseconds Duration_t;
+
+			RttEstimator(Duration_t initialTimeout, Duration_t minTimeout, Duration_t maxTimeout);
+
+			void AddSample(Duration_t rtt) noexcept;
+
+			/**
+			* A retransmission timer expired, backs off the timeout
+			*/
+			void OnTimeout() noexcept;
+
+			/**
+			* Forget all samples, used when the link is re-established
+			*/
+			void Reset() noexcept;
+
+			[[nodiscard]] Duration_t GetRetransmitTimeout() const noexcept;
+
+			[[nodiscard]] inline Duration_t GetSmoothedRtt() const noexcept
+			{
+				return m_tSmoothedRtt;
+			}
+
+			[[nodiscard]] inline Duration_t GetRttVariation() const noexcept
+			{
+				return m_tRttVariation;
+			}
+
+			[[nodiscard]] inline unsigned GetNumSamples() const noexcept
+			{
+				return m_uNumSamples;
+			}
+
+			[[nodiscard]] inline unsigned GetNumTimeouts() const noexcept
+			{
+				return m_uNumTimeouts;
+			}
+
+			void Serialize(dcclite::JsonOutputStream_t &stream) const;
+
+		private:
+			const Duration_t	m_tInitialTimeout;
+			const Duration_t	m_tMinTimeout;
+			const Duration_t	m_tMaxTimeout;
+
+			Duration_t			m_tSmoothedRtt{};
+			Duration_t			m_tRttVariation{};
+
+			//RTO without backoff, updated on each sample
+			Duration_t			m_tTimeout;
+
+			unsigned			m_uNumSamples = 0;
+			unsigned			m_uNumTimeouts = 0;
+
+			//how many times the timeout was doubled since the last sample
+			unsigned			m_uBackoff = 0;
+	};
+}
@@ -17,7 +17,8 @@ namespace dcclite::broker::sys
 		ObjectManagerEvent ev(
 			ObjectManagerEvent::ITEM_CREATED,
 			*this,
-			item
+			item,
+			++m_uChangeVersion
 		);
 
 		this->DispatchEvent(ev);
@@ -28,7 +29,8 @@ namespace dcclite::broker::sys
 		ObjectManagerEvent ev(
 			ObjectManagerEvent::ITEM_DESTROYED,
 			*this,
-			item
+			item,
+			++m_uChangeVersion
 		);
 
 		this->DispatchEvent(ev);
@@ -40,6 +42,7 @@ namespace dcclite::broker::sys
 			ObjectManagerEvent::ITEM_CHANGED,
 			*this,
 			item,
+			++m_uChangeVersion,
 			proc
 		);
 
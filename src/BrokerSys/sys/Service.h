@@ -43,10 +43,11 @@ namespace dcclite::broker::sys
 			};
 
 
-			ObjectManagerEvent(EventType ev, const Service &manager, const IItem &item, SerializeDeltaProc_t serializeDeltaProc = nullptr):
+			ObjectManagerEvent(EventType ev, const Service &manager, const IItem &item, uint64_t version, SerializeDeltaProc_t serializeDeltaProc = nullptr):
 				m_kType(ev),
 				m_rclManager(manager),
 				m_rclItem(item),
+				m_uVersion(version),
 				m_pfnSerializeDeltaProc(serializeDeltaProc)
 			{
 				//empty
@@ -59,6 +60,9 @@ namespace dcclite::broker::sys
 
 			const IItem &m_rclItem;
 
+			//manager change version after this event, see Service::GetChangeVersion
+			const uint64_t m_uVersion;
+
 			const SerializeDeltaProc_t m_pfnSerializeDeltaProc;
 	};
 
@@ -76,6 +80,15 @@ namespace dcclite::broker::sys
 			virtual ~Service() = default;
 
 			mutable sigslot::signal<const ObjectManagerEvent &> m_sigEvent;
+
+			/**
+			* Incremented on every event, so listeners can detect if they missed something. Starts at zero and is
+			* only valid during the service lifetime
+			*/
+			inline uint64_t GetChangeVersion() const noexcept
+			{
+				return m_uChangeVersion;
+			}
 	
 		protected:
 			Service(RName name, Broker &broker, const rapidjson::Value &params):
@@ -110,6 +123,9 @@ namespace dcclite::broker::sys
 
 		protected:		
 			Broker &m_rclBroker;		
+
+		private:
+			mutable uint64_t m_uChangeVersion = 0;
 	};
 
 	/**
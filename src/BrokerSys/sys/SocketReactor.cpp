@@ -0,0 +1,454 @@
+// Copyright (C) 2019 - Bruno Sanches. See the COPYRIGHT
+// file at the top-level directory of this distribution.
+//
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+//
+// This Source Code Form is "Incompatible With Secondary Licenses", as
+// defined by the Mozilla Public License, v. 2.0.
+
+#include "SocketReactor.h"
+
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include <fmt/format.h>
+
+#include <dcclite/Log.h>
+#include <dcclite/Util.h>
+
+#include "MainLoop.h"
+
+#ifdef WIN32
+#include <winsock2.h>
+#else
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+#endif
+
+namespace dcclite::broker::sys::SocketReactor
+{
+	class ReadyEvent: public EventHub::IEvent
+	{
+		public:
+			ReadyEvent(IHandler &target, const uint32_t events):
+				IEvent(target),
+				m_uEvents{ events }
+			{
+				//empty
+			}
+
+			void Fire() override
+			{
+				static_cast<IHandler &>(this->GetTarget()).OnSocketReady(m_uEvents);
+			}
+
+		private:
+			uint32_t m_uEvents;
+	};
+
+	class Reactor
+#ifndef WIN32
+		: private MainLoop::IFdHandler
+#endif
+	{
+		public:
+			Reactor();
+			~Reactor();
+
+			void Watch(IHandler &handler, const Socket::Handler_t handle, const uint32_t events);
+			void Unwatch(IHandler &handler);
+
+		private:
+			void ThreadProc();
+
+#ifndef WIN32
+			void OnFdReady(const uint32_t events) override;
+#endif
+
+			void Remove(IHandler &handler);
+
+#ifdef WIN32
+			void Wake();
+#endif
+
+		private:
+			struct Entry
+			{
+				IHandler	*m_pclHandler;
+
+				//armed events, only used by WSAPoll, epoll keeps it by itself
+				uint32_t	m_uEvents;
+			};
+
+			std::mutex m_mtxLock;
+
+			//handlers are found by id, so a notification for a socket that was unwatched in the meantime is simply ignored
+			std::unordered_map<uint64_t, Entry> m_mapEntries;
+
+			//zero is used for the wake up handle
+			uint64_t m_uNextId = 1;
+
+#ifdef WIN32
+			Socket	m_clWakeSocket;
+			bool	m_fShutdown = false;
+#else
+			int		m_iEpoll = -1;
+			int		m_iWakeEvent = -1;
+
+			//when the MainLoop is running, our epoll is nested on its epoll and handlers are called directly on the main thread
+			bool	m_fMainLoop = false;
+#endif
+
+			std::thread m_thThread;
+	};
+
+#ifdef WIN32
+
+	Reactor::Reactor()
+	{
+		if (!m_clWakeSocket.Open(0, Socket::Type::DATAGRAM))
+			throw std::runtime_error("[SocketReactor::Reactor] Cannot open wake up socket");
+
+		m_thThread = std::thread{ [this]() { this->ThreadProc(); } };
+		dcclite::SetThreadName(m_thThread, "SocketReactor::Thread");
+	}
+
+	Reactor::~Reactor()
+	{
+		{
+			std::lock_guard<std::mutex> guard{ m_mtxLock };
+
+			m_fShutdown = true;
+		}
+
+		this->Wake();
+
+		m_thThread.join();
+	}
+
+	void Reactor::Wake()
+	{
+		const uint8_t data = 0;
+
+		m_clWakeSocket.Send(NetworkAddress{ 127, 0, 0, 1, m_clWakeSocket.GetPort().value() }, &data, sizeof(data));
+	}
+
+	void Reactor::Watch(IHandler &handler, const Socket::Handler_t handle, const uint32_t events)
+	{
+		{
+			std::lock_guard<std::mutex> guard{ m_mtxLock };
+
+			if (handler.m_uReactorId && (handler.m_hReactorHandle != handle))
+				this->Remove(handler);
+
+			if (!handler.m_uReactorId)
+			{
+				handler.m_uReactorId = m_uNextId++;
+				handler.m_hReactorHandle = handle;
+			}
+
+			m_mapEntries[handler.m_uReactorId] = Entry{ &handler, events };
+		}
+
+		//WSAPoll must be restarted to see the new set
+		this->Wake();
+	}
+
+	void Reactor::Remove(IHandler &handler)
+	{
+		m_mapEntries.erase(handler.m_uReactorId);
+
+		handler.m_uReactorId = 0;
+	}
+
+	void Reactor::ThreadProc()
+	{
+		std::vector<WSAPOLLFD>	fds;
+		std::vector<uint64_t>	ids;
+
+		for (;;)
+		{
+			fds.clear();
+			ids.clear();
+
+			fds.push_back(WSAPOLLFD{ static_cast<SOCKET>(m_clWakeSocket.GetHandle()), POLLRDNORM, 0 });
+			ids.push_back(0);
+
+			{
+				std::lock_guard<std::mutex> guard{ m_mtxLock };
+
+				if (m_fShutdown)
+					return;
+
+				for (auto &[id, entry] : m_mapEntries)
+				{
+					if (!entry.m_uEvents)
+						continue;
+
+					fds.push_back(WSAPOLLFD{
+						static_cast<SOCKET>(entry.m_pclHandler->m_hReactorHandle),
+						static_cast<SHORT>(((entry.m_uEvents & EVENT_READ) ? POLLRDNORM : 0) | ((entry.m_uEvents & EVENT_WRITE) ? POLLWRNORM : 0)),
+						0
+					});
+
+					ids.push_back(id);
+				}
+			}
+
+			if (WSAPoll(fds.data(), static_cast<ULONG>(fds.size()), -1) == SOCKET_ERROR)
+			{
+				dcclite::Log::Error("[SocketReactor::ThreadProc] WSAPoll failed: {}", WSAGetLastError());
+
+				return;
+			}
+
+			if (fds[0].revents)
+			{
+				uint8_t buffer[64];
+				NetworkAddress sender;
+
+				while (std::get<0>(m_clWakeSocket.Receive(sender, buffer, sizeof(buffer))) == Socket::Status::OK)
+				{
+					//empty
+				}
+			}
+
+			std::lock_guard<std::mutex> guard{ m_mtxLock };
+
+			for (size_t i = 1; i < fds.size(); ++i)
+			{
+				if (!fds[i].revents)
+					continue;
+
+				auto it = m_mapEntries.find(ids[i]);
+				if ((it == m_mapEntries.end()) || !it->second.m_uEvents)
+					continue;
+
+				uint32_t events = 0;
+				events |= (fds[i].revents & POLLRDNORM) ? EVENT_READ : 0;
+				events |= (fds[i].revents & POLLWRNORM) ? EVENT_WRITE : 0;
+				events |= (fds[i].revents & (POLLERR | POLLHUP)) ? EVENT_ERROR | EVENT_READ : 0;
+
+				//one shot
+				it->second.m_uEvents = 0;
+
+				EventHub::PostEvent<ReadyEvent>(std::ref(*it->second.m_pclHandler), events);
+			}
+		}
+	}
+
+#else
+
+	Reactor::Reactor()
+	{
+		m_iEpoll = epoll_create1(EPOLL_CLOEXEC);
+		if (m_iEpoll < 0)
+			throw std::runtime_error(fmt::format("[SocketReactor::Reactor] epoll_create1 failed: {}", strerror(errno)));
+
+		m_iWakeEvent = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+		if (m_iWakeEvent < 0)
+		{
+			const auto error = errno;
+			close(m_iEpoll);
+
+			throw std::runtime_error(fmt::format("[SocketReactor::Reactor] eventfd failed: {}", strerror(error)));
+		}
+
+		epoll_event ev{};
+		ev.events = EPOLLIN;
+		ev.data.u64 = 0;
+
+		epoll_ctl(m_iEpoll, EPOLL_CTL_ADD, m_iWakeEvent, &ev);
+
+		if (MainLoop::IsStarted())
+		{
+			m_fMainLoop = true;
+
+			MainLoop::Watch(*this, m_iEpoll, EPOLLIN);
+
+			return;
+		}
+
+		m_thThread = std::thread{ [this]() { this->ThreadProc(); } };
+		dcclite::SetThreadName(m_thThread, "SocketReactor::Thread");
+	}
+
+	Reactor::~Reactor()
+	{
+		if (m_fMainLoop)
+		{
+			MainLoop::Unwatch(m_iEpoll);
+		}
+		else
+		{
+			const uint64_t value = 1;
+			[[maybe_unused]] auto rc = write(m_iWakeEvent, &value, sizeof(value));
+
+			m_thThread.join();
+		}
+
+		close(m_iWakeEvent);
+		close(m_iEpoll);
+	}
+
+	static uint32_t ToReadyEvents(const uint32_t flags) noexcept
+	{
+		uint32_t readyEvents = 0;
+		readyEvents |= (flags & EPOLLIN) ? EVENT_READ : 0;
+		readyEvents |= (flags & EPOLLOUT) ? EVENT_WRITE : 0;
+
+		//readers must see the disconnection
+		readyEvents |= (flags & (EPOLLERR | EPOLLHUP)) ? EVENT_ERROR | EVENT_READ : 0;
+
+		return readyEvents;
+	}
+
+	void Reactor::Watch(IHandler &handler, const Socket::Handler_t handle, const uint32_t events)
+	{
+		epoll_event ev{};
+		ev.events = EPOLLONESHOT | ((events & EVENT_READ) ? EPOLLIN : 0) | ((events & EVENT_WRITE) ? EPOLLOUT : 0);
+
+		std::lock_guard<std::mutex> guard{ m_mtxLock };
+
+		if (handler.m_uReactorId && (handler.m_hReactorHandle != handle))
+			this->Remove(handler);
+
+		if (handler.m_uReactorId)
+		{
+			ev.data.u64 = handler.m_uReactorId;
+
+			if (epoll_ctl(m_iEpoll, EPOLL_CTL_MOD, static_cast<int>(handle), &ev) == 0)
+				return;
+
+			if (errno != ENOENT)
+				throw std::runtime_error(fmt::format("[SocketReactor::Watch] epoll_ctl MOD failed: {}", strerror(errno)));
+
+			//socket was closed and the handle reused without an Unwatch, so epoll forgot about it, start again
+			this->Remove(handler);
+		}
+
+		const auto id = m_uNextId++;
+		ev.data.u64 = id;
+
+		if (epoll_ctl(m_iEpoll, EPOLL_CTL_ADD, static_cast<int>(handle), &ev) < 0)
+			throw std::runtime_error(fmt::format("[SocketReactor::Watch] epoll_ctl ADD failed: {}", strerror(errno)));
+
+		m_mapEntries.emplace(id, Entry{ &handler, events });
+
+		handler.m_uReactorId = id;
+		handler.m_hReactorHandle = handle;
+	}
+
+	void Reactor::Remove(IHandler &handler)
+	{
+		//may fail if the socket is already closed, nothing to do about it
+		epoll_ctl(m_iEpoll, EPOLL_CTL_DEL, static_cast<int>(handler.m_hReactorHandle), nullptr);
+
+		m_mapEntries.erase(handler.m_uReactorId);
+
+		handler.m_uReactorId = 0;
+	}
+
+	void Reactor::ThreadProc()
+	{
+		epoll_event events[64];
+
+		for (;;)
+		{
+			const auto count = epoll_wait(m_iEpoll, events, std::size(events), -1);
+			if (count < 0)
+			{
+				if (errno == EINTR)
+					continue;
+
+				dcclite::Log::Error("[SocketReactor::ThreadProc] epoll_wait failed: {}", strerror(errno));
+
+				return;
+			}
+
+			//holding the lock, so no handler can be unwatched (and destroyed) while its event is posted
+			std::lock_guard<std::mutex> guard{ m_mtxLock };
+
+			for (int i = 0; i < count; ++i)
+			{
+				const auto id = events[i].data.u64;
+
+				if (!id)
+					return;
+
+				auto it = m_mapEntries.find(id);
+				if (it == m_mapEntries.end())
+					continue;
+
+				EventHub::PostEvent<ReadyEvent>(std::ref(*it->second.m_pclHandler), ToReadyEvents(events[i].events));
+			}
+		}
+	}
+
+	void Reactor::OnFdReady(const uint32_t)
+	{
+		epoll_event events[64];
+
+		const auto count = epoll_wait(m_iEpoll, events, std::size(events), 0);
+
+		for (int i = 0; i < count; ++i)
+		{
+			IHandler *handler;
+
+			{
+				std::lock_guard<std::mutex> guard{ m_mtxLock };
+
+				//a previous handler may have unwatched this one
+				auto it = m_mapEntries.find(events[i].data.u64);
+				if (it == m_mapEntries.end())
+					continue;
+
+				handler = it->second.m_pclHandler;
+			}
+
+			//no lock here, handlers watch again from inside the callback
+			handler->OnSocketReady(ToReadyEvents(events[i].events));
+		}
+	}
+
+#endif
+
+	void Reactor::Unwatch(IHandler &handler)
+	{
+		{
+			std::lock_guard<std::mutex> guard{ m_mtxLock };
+
+			if (handler.m_uReactorId)
+				this->Remove(handler);
+		}
+
+		EventHub::CancelEvents(handler);
+	}
+
+	static Reactor &GetReactor()
+	{
+		//started on first use, brokers without sockets to watch do not get the thread
+		static Reactor g_clReactor;
+
+		return g_clReactor;
+	}
+
+	void Watch(IHandler &handler, const Socket::Handler_t handle, const uint32_t events)
+	{
+		GetReactor().Watch(handler, handle, events);
+	}
+
+	void Unwatch(IHandler &handler)
+	{
+		GetReactor().Unwatch(handler);
+	}
+}
@@ -0,0 +1,71 @@
+// Copyright (C) 2019 - Bruno Sanches. See the COPYRIGHT
+// file at the top-level directory of this distribution.
+//
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+//
+// This Source Code Form is "Incompatible With Secondary Licenses", as
+// defined by the Mozilla Public License, v. 2.0.
+
+#pragma once
+
+#include <cstdint>
+
+#include <dcclite/Socket.h>
+
+#include "EventHub.h"
+
+/**
+
+	Socket readiness for code running on the main thread.
+
+	A single thread waits on all watched sockets (epoll on Linux, WSAPoll on Windows) and posts an event to the
+	EventHub when one is ready, so the handler runs on the main thread like any other event and no one needs to
+	poll sockets on a Thinker.
+
+	On Linux, if the MainLoop is started before the first Watch, there is no thread: the reactor epoll is watched by the
+	main loop and handlers are called directly from it.
+
+	Watches are one shot: after a notification the socket is ignored until the handler calls Watch again, so a
+	socket that stays readable does not flood the EventHub while the main thread is busy.
+
+*/
+namespace dcclite::broker::sys::SocketReactor
+{
+	enum Events : uint32_t
+	{
+		EVENT_READ = 0x01,
+		EVENT_WRITE = 0x02,
+
+		//never watched, reported when the connection failed or was closed
+		EVENT_ERROR = 0x04
+	};
+
+	class Reactor;
+
+	class IHandler: public EventHub::IEventTarget
+	{
+		public:
+			virtual void OnSocketReady(const uint32_t events) = 0;
+
+		private:
+			uint64_t			m_uReactorId = 0;
+			Socket::Handler_t	m_hReactorHandle = 0;
+
+			friend class Reactor;
+	};
+
+	/**
+	* Arms the handler for a single notification about the socket.
+	*
+	* A handler watches one socket at a time, watching another one replaces the previous watch. Handlers must call Unwatch
+	* before closing a watched socket, otherwise the handle may be reused by another socket.
+	*/
+	void Watch(IHandler &handler, const Socket::Handler_t handle, const uint32_t events);
+
+	/**
+	* Stops watching and drops notifications not delivered yet, does nothing if the handler is not watching
+	*/
+	void Unwatch(IHandler &handler);
+}
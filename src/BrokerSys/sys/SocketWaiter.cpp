@@ -0,0 +1,135 @@
+// Copyright (C) 2019 - Bruno Sanches. See the COPYRIGHT
+// file at the top-level directory of this distribution.
+//
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+//
+// This Source Code Form is "Incompatible With Secondary Licenses", as
+// defined by the Mozilla Public License, v. 2.0.
+
+#include "SocketWaiter.h"
+
+#include <stdexcept>
+
+#include <fmt/format.h>
+
+#ifdef WIN32
+#include <winsock2.h>
+#else
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+#endif
+
+namespace dcclite::broker::sys
+{
+	static int ToPollTimeout(const std::optional<Clock::DefaultClock_t::duration> timeout)
+	{
+		if (!timeout)
+			return -1;
+
+		if (timeout.value() <= Clock::DefaultClock_t::duration::zero())
+			return 0;
+
+		//round up, a sub millisecond timeout must not turn into a busy loop
+		return static_cast<int>(std::chrono::ceil<std::chrono::milliseconds>(timeout.value()).count());
+	}
+
+#ifdef WIN32
+
+	SocketWaiter::SocketWaiter()
+	{
+		if (!m_clWakeSocket.Open(0, Socket::Type::DATAGRAM))
+			throw std::runtime_error("[SocketWaiter::SocketWaiter] Cannot open wake up socket");
+	}
+
+	SocketWaiter::~SocketWaiter()
+	{
+		//empty
+	}
+
+	void SocketWaiter::Shutdown()
+	{
+		//never read, so it stays signaled
+		const uint8_t data = 0;
+
+		m_clWakeSocket.Send(NetworkAddress{ 127, 0, 0, 1, m_clWakeSocket.GetPort().value() }, &data, sizeof(data));
+	}
+
+	SocketWaiter::Result SocketWaiter::Poll(const Socket *socket, const std::optional<Clock::DefaultClock_t::duration> timeout)
+	{
+		WSAPOLLFD fds[2] = {
+			{ static_cast<SOCKET>(m_clWakeSocket.GetHandle()), POLLRDNORM, 0 },
+			{ socket ? static_cast<SOCKET>(socket->GetHandle()) : INVALID_SOCKET, POLLRDNORM, 0 }
+		};
+
+		const auto rc = WSAPoll(fds, socket ? 2 : 1, ToPollTimeout(timeout));
+		if (rc == SOCKET_ERROR)
+			throw std::runtime_error(fmt::format("[SocketWaiter::Poll] WSAPoll failed: {}", WSAGetLastError()));
+
+		if (fds[0].revents)
+			return Result::SHUTDOWN;
+
+		return rc ? Result::READY : Result::TIMEOUT;
+	}
+
+#else
+
+	SocketWaiter::SocketWaiter()
+	{
+		m_iWakeEvent = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+		if (m_iWakeEvent < 0)
+			throw std::runtime_error(fmt::format("[SocketWaiter::SocketWaiter] eventfd failed: {}", strerror(errno)));
+	}
+
+	SocketWaiter::~SocketWaiter()
+	{
+		close(m_iWakeEvent);
+	}
+
+	void SocketWaiter::Shutdown()
+	{
+		//never read, so it stays signaled
+		const uint64_t value = 1;
+
+		[[maybe_unused]] auto rc = write(m_iWakeEvent, &value, sizeof(value));
+	}
+
+	SocketWaiter::Result SocketWaiter::Poll(const Socket *socket, const std::optional<Clock::DefaultClock_t::duration> timeout)
+	{
+		pollfd fds[2] = {
+			{ m_iWakeEvent, POLLIN, 0 },
+			{ socket ? static_cast<int>(socket->GetHandle()) : -1, POLLIN, 0 }
+		};
+
+		int rc;
+		do
+		{
+			rc = poll(fds, socket ? 2 : 1, ToPollTimeout(timeout));
+		} while ((rc < 0) && (errno == EINTR));
+
+		if (rc < 0)
+			throw std::runtime_error(fmt::format("[SocketWaiter::Poll] poll failed: {}", strerror(errno)));
+
+		if (fds[0].revents)
+			return Result::SHUTDOWN;
+
+		return rc ? Result::READY : Result::TIMEOUT;
+	}
+
+#endif
+
+	SocketWaiter::Result SocketWaiter::Wait(const Socket &socket, const std::optional<Clock::DefaultClock_t::duration> timeout)
+	{
+		return this->Poll(&socket, timeout);
+	}
+
+	bool SocketWaiter::Sleep(const Clock::DefaultClock_t::duration timeout)
+	{
+		return this->Poll(nullptr, timeout) != Result::SHUTDOWN;
+	}
+}
@@ -0,0 +1,67 @@
+// Copyright (C) 2019 - Bruno Sanches. See the COPYRIGHT
+// file at the top-level directory of this distribution.
+//
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+//
+// This Source Code Form is "Incompatible With Secondary Licenses", as
+// defined by the Mozilla Public License, v. 2.0.
+
+#pragma once
+
+#include <optional>
+
+#include <dcclite/Clock.h>
+#include <dcclite/Socket.h>
+
+namespace dcclite::broker::sys
+{
+	/**
+	* Lets a worker thread block on a socket and still be stopped: another thread calls Shutdown and the wait returns.
+	*
+	* Closing the socket from another thread does not wake a blocked recv on Linux, so this keeps an extra handle on the
+	* wait set (an eventfd on Linux, a loopback datagram socket on Windows) that is signaled on shutdown.
+	*/
+	class SocketWaiter
+	{
+		public:
+			enum class Result
+			{
+				READY,
+				TIMEOUT,
+				SHUTDOWN
+			};
+
+			SocketWaiter();
+			~SocketWaiter();
+
+			SocketWaiter(const SocketWaiter &) = delete;
+			SocketWaiter &operator=(const SocketWaiter &) = delete;
+
+			/**
+			* Blocks until the socket has data, the timeout expires or Shutdown is called
+			*/
+			Result Wait(const Socket &socket, const std::optional<Clock::DefaultClock_t::duration> timeout = std::nullopt);
+
+			/**
+			* Blocks until the timeout expires, returns false if Shutdown was called
+			*/
+			bool Sleep(const Clock::DefaultClock_t::duration timeout);
+
+			/**
+			* Wakes the waiting thread, after this every wait returns SHUTDOWN immediately
+			*/
+			void Shutdown();
+
+		private:
+			Result Poll(const Socket *socket, const std::optional<Clock::DefaultClock_t::duration> timeout);
+
+		private:
+#ifdef WIN32
+			Socket	m_clWakeSocket;
+#else
+			int		m_iWakeEvent = -1;
+#endif
+	};
+}
@@ -0,0 +1,91 @@
+// Copyright (C) 2019 - Bruno Sanches. See the COPYRIGHT
+// file at the top-level directory of this distribution.
+//
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+//
+// This Source Code Form is "Incompatible With Secondary Licenses", as
+// defined by the Mozilla Public License, v. 2.0.
+
+#include "SubscriptionIndex.h"
+
+#include <stdexcept>
+
+#include <fmt/format.h>
+
+namespace dcclite::broker::sys
+{
+	static constexpr std::string_view TYPE_PREFIX = "type=";
+
+	static void ParsePath(std::string_view path, SubscriptionFilter &filter, std::string_view originalFilter)
+	{
+		if (path.empty() || (path[0] != '/'))
+			throw std::invalid_argument(fmt::format("[SubscriptionFilter::Parse] Path must be absolute on filter: {}", originalFilter));
+
+		while (!path.empty())
+		{
+			const auto pos = path.find('/');
+			const auto segment = path.substr(0, pos);
+
+			path = pos == std::string_view::npos ? std::string_view{} : path.substr(pos + 1);
+
+			if (segment.empty())
+				continue;
+
+			if (segment == "*")
+			{
+				if (!path.empty())
+					throw std::invalid_argument(fmt::format("[SubscriptionFilter::Parse] Wildcard is only allowed at the end of the path: {}", originalFilter));
+
+				filter.m_fRecursive = true;
+
+				break;
+			}
+
+			filter.m_vecPath.emplace_back(segment);
+		}
+	}
+
+	SubscriptionFilter SubscriptionFilter::Parse(std::string_view filterString)
+	{
+		SubscriptionFilter filter;
+
+		filter.m_fAnyPath = true;
+
+		for (std::string_view remaining = filterString; !remaining.empty();)
+		{
+			const auto pos = remaining.find(' ');
+			const auto term = remaining.substr(0, pos);
+
+			remaining = pos == std::string_view::npos ? std::string_view{} : remaining.substr(pos + 1);
+
+			if (term.empty())
+				continue;
+
+			if (term.starts_with(TYPE_PREFIX))
+			{
+				if (!filter.m_strType.empty())
+					throw std::invalid_argument(fmt::format("[SubscriptionFilter::Parse] Multiple types on filter: {}", filterString));
+
+				filter.m_strType = term.substr(TYPE_PREFIX.size());
+				if (filter.m_strType.empty())
+					throw std::invalid_argument(fmt::format("[SubscriptionFilter::Parse] Empty type on filter: {}", filterString));
+			}
+			else
+			{
+				if (!filter.m_fAnyPath)
+					throw std::invalid_argument(fmt::format("[SubscriptionFilter::Parse] Multiple paths on filter: {}", filterString));
+
+				filter.m_fAnyPath = false;
+
+				ParsePath(term, filter, filterString);
+			}
+		}
+
+		if (filter.m_fAnyPath && filter.m_strType.empty())
+			throw std::invalid_argument(fmt::format("[SubscriptionFilter::Parse] Filter is empty: {}", filterString));
+
+		return filter;
+	}
+}
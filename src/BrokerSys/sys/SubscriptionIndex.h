@@ -0,0 +1,277 @@
+// Copyright (C) 2019 - Bruno Sanches. See the COPYRIGHT
+// file at the top-level directory of this distribution.
+//
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+//
+// This Source Code Form is "Incompatible With Secondary Licenses", as
+// defined by the Mozilla Public License, v. 2.0.
+
+#pragma once
+
+#include <algorithm>
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <dcclite/Object.h>
+
+namespace dcclite::broker::sys
+{
+	/**
+	*
+	* Describes which objects a subscriber is interested on, created from a string like:
+	*	- "/DCCLite/Decoders/*"				-> anything below /DCCLite/Decoders
+	*	- "/DCCLite/Decoders/turnout1"		-> only the turnout1 object
+	*	- "type=SignalDecoder"				-> any object with the given type name
+	*	- "/DCCLite/* type=SignalDecoder"	-> both conditions must match
+	*
+	*/
+	struct SubscriptionFilter
+	{
+		//path segments, empty for root or when filtering only by type
+		std::vector<std::string>	m_vecPath;
+
+		//empty matches any type
+		std::string					m_strType;
+
+		//true when the path has no restrictions
+		bool						m_fAnyPath = false;
+
+		//if set, matches anything below m_vecPath, but not the object itself
+		bool						m_fRecursive = false;
+
+		/**
+		* throws std::invalid_argument if the filter cannot be parsed
+		*/
+		static SubscriptionFilter Parse(std::string_view filter);
+
+		bool operator==(const SubscriptionFilter &rhs) const = default;
+	};
+
+	/**
+	*
+	* Keeps subscribers filters indexed by path (using a tree of path segments) and by type, so finding who
+	* is interested on an object only needs to walk the object path once and never touches unrelated subscribers
+	*
+	*/
+	template <typename T>
+	class SubscriptionIndex
+	{
+		public:
+			void Subscribe(T &subscriber, const SubscriptionFilter &filter)
+			{
+				Entry entry{ &subscriber, filter.m_strType };
+
+				if (filter.m_fAnyPath)
+				{
+					m_mapTypes[filter.m_strType].push_back(&subscriber);
+				}
+				else
+				{
+					auto &node = this->GetNode(filter.m_vecPath);
+
+					(filter.m_fRecursive ? node.m_vecRecursive : node.m_vecExact).push_back(std::move(entry));
+				}
+
+				++m_uNumEntries;
+			}
+
+			/**
+			* Returns false if the filter was not registered for the subscriber
+			*/
+			bool Unsubscribe(T &subscriber, const SubscriptionFilter &filter)
+			{
+				bool removed = false;
+
+				if (filter.m_fAnyPath)
+				{
+					auto it = m_mapTypes.find(filter.m_strType);
+					if (it == m_mapTypes.end())
+						return false;
+
+					removed = EraseFirst(it->second, [&subscriber](const T *item) { return item == &subscriber; });
+
+					if (it->second.empty())
+						m_mapTypes.erase(it);
+				}
+				else
+				{
+					auto node = this->TryGetNode(filter.m_vecPath);
+					if (!node)
+						return false;
+
+					removed = EraseFirst(
+						filter.m_fRecursive ? node->m_vecRecursive : node->m_vecExact,
+						[&subscriber, &filter](const Entry &entry) { return (entry.m_pclSubscriber == &subscriber) && (entry.m_strType == filter.m_strType); }
+					);
+				}
+
+				if (removed)
+					--m_uNumEntries;
+
+				return removed;
+			}
+
+			void RemoveSubscriber(T &subscriber)
+			{
+				for (auto it = m_mapTypes.begin(); it != m_mapTypes.end();)
+				{
+					m_uNumEntries -= std::erase(it->second, &subscriber);
+
+					it = it->second.empty() ? m_mapTypes.erase(it) : std::next(it);
+				}
+
+				RemoveSubscriber_r(m_stRoot, subscriber);
+			}
+
+			inline bool IsEmpty() const noexcept
+			{
+				return m_uNumEntries == 0;
+			}
+
+			/**
+			* Appends to subscribers anyone interested on object, each subscriber is added only once
+			*/
+			void FindSubscribers(const dcclite::IObject &object, std::vector<T *> &subscribers) const
+			{
+				if (m_uNumEntries == 0)
+					return;
+
+				const auto initialSize = subscribers.size();
+				const std::string_view typeName = object.GetTypeName();
+
+				if (!m_mapTypes.empty())
+				{
+					if (auto it = m_mapTypes.find(std::string_view{}); it != m_mapTypes.end())
+						subscribers.insert(subscribers.end(), it->second.begin(), it->second.end());
+
+					if (auto it = m_mapTypes.find(typeName); it != m_mapTypes.end())
+						subscribers.insert(subscribers.end(), it->second.begin(), it->second.end());
+				}
+
+				if (auto node = this->FindNode_r(object, typeName, subscribers))
+					AppendMatches(node->m_vecExact, typeName, subscribers);
+
+				if (subscribers.size() - initialSize > 1)
+				{
+					auto begin = subscribers.begin() + initialSize;
+
+					std::sort(begin, subscribers.end());
+					subscribers.erase(std::unique(begin, subscribers.end()), subscribers.end());
+				}
+			}
+
+		private:
+			struct Entry
+			{
+				T			*m_pclSubscriber;
+				std::string m_strType;
+			};
+
+			struct Node
+			{
+				std::map<std::string, std::unique_ptr<Node>, std::less<>> m_mapChildren;
+
+				std::vector<Entry> m_vecExact;
+				std::vector<Entry> m_vecRecursive;
+			};
+
+			template <typename C, typename P>
+			static bool EraseFirst(C &container, P pred)
+			{
+				auto it = std::find_if(container.begin(), container.end(), pred);
+				if (it == container.end())
+					return false;
+
+				container.erase(it);
+
+				return true;
+			}
+
+			static void AppendMatches(const std::vector<Entry> &entries, std::string_view typeName, std::vector<T *> &subscribers)
+			{
+				for (const auto &entry : entries)
+				{
+					if (entry.m_strType.empty() || (entry.m_strType == typeName))
+						subscribers.push_back(entry.m_pclSubscriber);
+				}
+			}
+
+			Node &GetNode(const std::vector<std::string> &path)
+			{
+				Node *node = &m_stRoot;
+
+				for (const auto &segment : path)
+				{
+					auto &child = node->m_mapChildren[segment];
+					if (!child)
+						child = std::make_unique<Node>();
+
+					node = child.get();
+				}
+
+				return *node;
+			}
+
+			Node *TryGetNode(const std::vector<std::string> &path)
+			{
+				Node *node = &m_stRoot;
+
+				for (const auto &segment : path)
+				{
+					auto it = node->m_mapChildren.find(segment);
+					if (it == node->m_mapChildren.end())
+						return nullptr;
+
+					node = it->second.get();
+				}
+
+				return node;
+			}
+
+			/**
+			* Walks up to the root and then down the tree following the object path, collecting recursive subscribers
+			* of any ancestor. Returns the node for the object, if any.
+			*/
+			const Node *FindNode_r(const dcclite::IObject &object, std::string_view typeName, std::vector<T *> &subscribers) const
+			{
+				auto parent = object.GetParent();
+				if (!parent)
+					return &m_stRoot;
+
+				auto parentNode = this->FindNode_r(*parent, typeName, subscribers);
+				if (!parentNode)
+					return nullptr;
+
+				AppendMatches(parentNode->m_vecRecursive, typeName, subscribers);
+
+				auto it = parentNode->m_mapChildren.find(object.GetNameData());
+
+				return it == parentNode->m_mapChildren.end() ? nullptr : it->second.get();
+			}
+
+			void RemoveSubscriber_r(Node &node, T &subscriber)
+			{
+				auto pred = [&subscriber](const Entry &entry) { return entry.m_pclSubscriber == &subscriber; };
+
+				m_uNumEntries -= std::erase_if(node.m_vecExact, pred);
+				m_uNumEntries -= std::erase_if(node.m_vecRecursive, pred);
+
+				for (auto &it : node.m_mapChildren)
+					RemoveSubscriber_r(*it.second, subscriber);
+			}
+
+		private:
+			Node m_stRoot;
+
+			//filters without a path, keyed by type name, empty key means anything
+			std::map<std::string, std::vector<T *>, std::less<>> m_mapTypes;
+
+			size_t m_uNumEntries = 0;
+	};
+}
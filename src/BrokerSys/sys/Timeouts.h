@@ -18,7 +18,11 @@ namespace dcclite::broker::sys
 
 	auto constexpr NETWORK_DEVICE_TIMEOUT_TICKS = 10s;
 	auto constexpr NETWORK_DEVICE_CONFIG_RETRY_TIME = 100ms;
+	auto constexpr NETWORK_DEVICE_CONFIG_MIN_RETRY_TIME = 20ms;
+	auto constexpr NETWORK_DEVICE_CONFIG_MAX_RETRY_TIME = 1s;
 	auto constexpr NETWORK_DEVICE_STATE_TIMEOUT = 250ms;
+	auto constexpr NETWORK_DEVICE_STATE_MIN_TIMEOUT = 20ms;
+	auto constexpr NETWORK_DEVICE_STATE_MAX_TIMEOUT = 2s;
 
 	auto constexpr NETWORK_DEVICE_SYNC_TIMEOUT = 100ms;
 
@@ -40,18 +44,25 @@ namespace dcclite::broker::sys
 
 	auto constexpr FILE_WATCHER_IGNORE_TIME = 100ms;
 
+	//bounded, so the main thread joining a blocked producer is never stuck
+	auto constexpr EVENT_HUB_LANE_BLOCK_TIMEOUT = 100ms;
+
 	auto constexpr LOCONET_THINK_TIME = 20ms;
 	auto constexpr LOCONET_PURGE_INTERVAL = 100s;
 	auto constexpr LOCONET_PURGE_TIMEOUT = 200s;
 
+	//10 bits at 16.66kbps and the 20 bits CD backoff
+	auto constexpr LOCONET_BYTE_TIME = 600us;
+	auto constexpr LOCONET_TX_BACKOFF = 1200us;
+
 	auto constexpr SIGNAL_FLASH_INTERVAL = 500ms;
 	auto constexpr SIGNAL_WAIT_STATE_TIMEOUT = 250ms;
 
-	auto constexpr THROTTLE_SERVICE_THINK_TIME = 20ms;
+	//from connection start until the server sends the heartbeat interval
+	auto constexpr THROTTLE_SERVICE_CONNECT_TIMEOUT = 5s;
 
+	//flood control window, the responders block on their sockets and only wait when too many packets arrive in one
 	auto constexpr ZERO_CONF_SERVICE_PACKET_INTERVAL = 50ms;
-	auto constexpr ZERO_CONF_SERVICE_SLEEP_TIME = 100ms;
 
 	auto constexpr BONJOUR_SERVICE_PACKET_INTERVAL = 100ms;
-	auto constexpr BONJOUR_SERVICE_SLEEP_TIME = 100ms;
 }
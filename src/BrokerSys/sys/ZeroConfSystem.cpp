@@ -15,23 +15,39 @@
 #include <dcclite/Log.h>
 #include <dcclite/Util.h>
 
+#include <map>
+#include <memory>
 #include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
 
 #include <dcclite_shared/Packet.h>
 #include <dcclite_shared/SharedLibDefs.h>
 
+#include "SocketWaiter.h"
 #include "Timeouts.h"
 
 namespace dcclite::broker::sys::ZeroConfSystem
 {		
-	static std::map<std::string_view, uint16_t> g_mapServices;
-	static dcclite::Socket						g_clSocket;	
-	static std::string							g_strProjectName;
-	static std::mutex							g_lckMapServicesMutex;
+	struct ServiceInfo
+	{
+		uint16_t				m_uPort;
+
+		//reply packet, built when the service is registered, so queries only need a lookup and a send
+		std::vector<uint8_t>	m_vecReply;
+	};
+
+	static std::map<std::string, ServiceInfo, std::less<>>	g_mapServices;
+	static dcclite::Socket									g_clSocket;	
+	static std::string										g_strProjectName;
+	static std::mutex										g_lckMapServicesMutex;
+
+	static std::unique_ptr<SocketWaiter>					g_upWaiter;
 	
 	static void OpenSocket()
 	{
-		if (!g_clSocket.Open(DEFAULT_ZEROCONF_PORT, dcclite::Socket::Type::DATAGRAM, dcclite::Socket::FLAG_ADDRESS_REUSE | dcclite::Socket::FLAG_BLOCKING_MODE))
+		if (!g_clSocket.Open(DEFAULT_ZEROCONF_PORT, dcclite::Socket::Type::DATAGRAM, dcclite::Socket::FLAG_ADDRESS_REUSE))
 		{
 			throw std::runtime_error("[ZeroconfService] [OpenSocket] Cannot open port 9381 for listening");
 		}
@@ -72,12 +88,15 @@ namespace dcclite::broker::sys::ZeroConfSystem
 
 	constexpr auto MAX_PACKET_SIZE = 192;
 
+	//Queries answered per ZERO_CONF_SERVICE_PACKET_INTERVAL, a whole layout booting at once fits, a flood does not
+	constexpr auto MAX_PACKETS_PER_INTERVAL = 64;
+
 	enum PacketFlags
 	{
 		FLAG_QUERY = 0x01
 	};
 
-	static void SendReply(const NetworkAddress &destination, const std::string_view serviceName, const uint16_t port)
+	static std::vector<uint8_t> BuildReply(const std::string_view serviceName, const uint16_t port)
 	{
 		dcclite::BasePacket<MAX_PACKET_SIZE> packet;
 
@@ -94,116 +113,134 @@ namespace dcclite::broker::sys::ZeroConfSystem
 		auto projectNameLen = std::min((size_t)(MAX_SERVICE_NAME - 1), g_strProjectName.length());
 		for (auto ch : g_strProjectName)
 		{
-			packet.Write8(ch);
-
 			//avoid giant names
-			--projectNameLen;
 			if (!projectNameLen)
 				break;
 
+			packet.Write8(ch);
+
+			--projectNameLen;
 		}
 
 		packet.Write8(0);
 
-		g_clSocket.Send(destination, packet.GetData(), packet.GetSize());
+		return std::vector<uint8_t>{ packet.GetData(), packet.GetData() + packet.GetSize() };
+	}
+
+	static void ParseQuery(dcclite::BasePacket<MAX_PACKET_SIZE> &packet, const int size, const NetworkAddress &sender)
+	{
+		//Packet too small ?
+		if (size < PACKET_MINIMUM_SIZE)
+			return;
+
+		//Invalid magic number?
+		if (packet.Read<uint32_t>() != PACKET_MAGIC_NUMBER)
+			return;
+
+		//Invalid version?
+		if (packet.Read<uint8_t>() != PACKET_VERSION)
+			return;
+
+		//not a query?
+		if (!(packet.Read<uint8_t>() & FLAG_QUERY))
+			return;
+
+		char serviceName[MAX_SERVICE_NAME];
+
+		bool finished = false;
+		for (int i = 0; i < MAX_SERVICE_NAME; ++i)
+		{
+			if (packet.GetSize() == size)
+			{
+				//overflow? Drop packet
+				break;
+			}
+
+			serviceName[i] = packet.ReadByte();
+
+			if (serviceName[i] == '\0')
+			{
+				finished = true;
+				break;
+			}
+		}
+
+		if (!finished)
+			return;
+
+		std::lock_guard guard{ g_lckMapServicesMutex };
+
+		auto it = g_mapServices.find(std::string_view{ serviceName });
+		if (it == g_mapServices.end())
+			return;
+
+		//
+		//found a service, send data...
+		const auto &reply = it->second.m_vecReply;
+
+		g_clSocket.Send(sender, reply.data(), reply.size());
 	}
 
 	static void WorkerThreadProc()
 	{			
-		OpenSocket();
-
 		dcclite::BasePacket<MAX_PACKET_SIZE> packet;
 		NetworkAddress sender;
+
+		auto intervalStart = dcclite::Clock::DefaultClock_t::now();
+		int packetCount = 0;
 		
 		for (;;)
 		{		
-			auto startTime = dcclite::Clock::DefaultClock_t::now();
+			//sleep until a query arrives or Stop is called
+			if (g_upWaiter->Wait(g_clSocket) == SocketWaiter::Result::SHUTDOWN)
+			{
+				dcclite::Log::Trace("[ZeroConfSystem::WorkerThreadProc] Shutdown requested, stoping");
+
+				return;
+			}
 
 			//
-			//Process 16 requests per frame, to avoid flooding
-			for (int packetCount = 0; packetCount < 16; ++packetCount)
+			//Answer everything that is queued, a burst of queries is answered at once
+			for (;;)
 			{
-				packet.Reset();
-
-				auto [status, size] = g_clSocket.Receive(sender, packet.GetRaw(), packet.GetCapacity(), true);
-				if (status != Socket::Status::OK)
+				const auto now = dcclite::Clock::DefaultClock_t::now();
+				if ((now - intervalStart) >= ZERO_CONF_SERVICE_PACKET_INTERVAL)
 				{
-					//Not sure why, but when SharpTerminal stops querying, this error may happen (just wait the countdown message to see it)
-					//The socket here is lost... so we reset it
-					if (status == Socket::Status::CONNRESET)
-					{
-						OpenSocket();
-					}
-					else if (status == Socket::Status::INTERRUPTED)
-					{
-						dcclite::Log::Trace("[ZeroConfSystem::WorkerThreadProc] Socket interrupted, stoping");
-
-						//socket closed? Game over...
+					intervalStart = now;
+					packetCount = 0;
+				}
+				else if (packetCount == MAX_PACKETS_PER_INTERVAL)
+				{
+					//we are going too fast.... wait for the next interval so we do not flood if someone is attacking
+					if (!g_upWaiter->Sleep(intervalStart + ZERO_CONF_SERVICE_PACKET_INTERVAL - now))
 						return;
-					}
 
 					continue;
 				}
 
+				packet.Reset();
 
-				//Packet too small ?
-				if (size < PACKET_MINIMUM_SIZE)
-					continue;
-
-				//Invalid magic number?
-				if (packet.Read<uint32_t>() != PACKET_MAGIC_NUMBER)
-					continue;
-
-				//Invalid version?
-				if (packet.Read<uint8_t>() != PACKET_VERSION)
-					continue;
-
-				//not a query?
-				if (!(packet.Read<uint8_t>() & FLAG_QUERY))
-					continue;
-
-				char serviceName[MAX_SERVICE_NAME];
+				auto [status, size] = g_clSocket.Receive(sender, packet.GetRaw(), packet.GetCapacity(), true);
+				if (status == Socket::Status::WOULD_BLOCK)
+					break;
 
-				bool finished = false;
-				for (int i = 0; i < MAX_SERVICE_NAME; ++i)
+				if (status != Socket::Status::OK)
 				{
-					if (packet.GetSize() == size)
+					//Not sure why, but when SharpTerminal stops querying, this error may happen (just wait the countdown message to see it)
+					//The socket here is lost... so we reset it
+					if (status == Socket::Status::CONNRESET)
 					{
-						//overflow? Drop packet
-						break;
-					}
-
-					serviceName[i] = packet.ReadByte();
+						OpenSocket();
 
-					if (serviceName[i] == '\0')
-					{
-						finished = true;
 						break;
 					}
 
-				}
-
-				if (!finished)
 					continue;
+				}
 
-				{
-					std::lock_guard guard{ g_lckMapServicesMutex };
-
-					auto it = g_mapServices.find(serviceName);
-					if (it == g_mapServices.end())
-						continue;
+				++packetCount;
 
-					//
-					//found a service, send data...
-					SendReply(sender, it->first, it->second);
-				}				
-			}
-
-			auto endTime = dcclite::Clock::DefaultClock_t::now();
-			if ((endTime - startTime) < ZERO_CONF_SERVICE_PACKET_INTERVAL)
-			{
-				//we are going too fast.... wait a bit so we do not flood if someone is attacking
-				std::this_thread::sleep_for(ZERO_CONF_SERVICE_SLEEP_TIME);
+				ParseQuery(packet, size, sender);
 			}
 		}			
 	}		
@@ -215,10 +252,10 @@ namespace dcclite::broker::sys::ZeroConfSystem
 
 		std::lock_guard guard{ g_lckMapServicesMutex };
 
-		auto result = g_mapServices.emplace(std::make_pair(serviceName, port));
+		auto result = g_mapServices.emplace(std::string{ serviceName }, ServiceInfo{ port, BuildReply(serviceName, port) });
 
 		if (!result.second)
-			throw std::runtime_error(fmt::format("[ZeroconfServiceImpl] [Register] Service {} already registered with port {}", serviceName, result.first->second));				
+			throw std::runtime_error(fmt::format("[ZeroconfServiceImpl] [Register] Service {} already registered with port {}", serviceName, result.first->second.m_uPort));				
 	}
 
 	static std::thread g_thWorker;
@@ -229,11 +266,23 @@ namespace dcclite::broker::sys::ZeroConfSystem
 		dcclite::Log::Trace("[ZeroConfSystem::Start] initializing");
 
 		if(g_fStarted)
-			throw std::logic_error("[ZeroconfService] [Start] already called??");
+			throw std::logic_error("[ZeroconfService] [Start] already called??");		
+
+		{
+			std::lock_guard guard{ g_lckMapServicesMutex };
+
+			g_strProjectName = projectName;
+
+			//services registered before start have replies without the project name
+			for (auto &[name, info] : g_mapServices)
+				info.m_vecReply = BuildReply(name, info.m_uPort);
+		}
+
+		OpenSocket();
 
-		g_fStarted = true;		
+		g_upWaiter = std::make_unique<SocketWaiter>();
 
-		g_strProjectName = projectName;
+		g_fStarted = true;
 
 		dcclite::Log::Trace("[ZeroConfSystem::Start] Starting worker thread");
 
@@ -248,14 +297,17 @@ namespace dcclite::broker::sys::ZeroConfSystem
 		if (!g_fStarted)
 			return;
 
-		dcclite::Log::Trace("[ZeroConfSystem::Stop] Closing socket");
+		dcclite::Log::Trace("[ZeroConfSystem::Stop] Waking worker thread");
 
-		g_clSocket.Close();
+		g_upWaiter->Shutdown();
 
 		dcclite::Log::Trace("[ZeroConfSystem::Stop] Joining worker thread");
 
 		g_thWorker.join();
 
+		g_upWaiter.reset();
+		g_clSocket.Close();
+
 		g_mapServices.clear();		
 
 		g_fStarted = false;
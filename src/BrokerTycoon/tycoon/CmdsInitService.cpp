@@ -93,7 +93,7 @@ namespace dcclite::broker::tycoon
 					throw terminal::TerminalCmdException(ex.what(), id);
 				}
 
-				return terminal::MsgUtils::MakeRpcResultMessage(id, [](Result_t &results)
+				return terminal::MsgUtils::MakeRpcResultMessage(context, id, [](Result_t &results)
 					{
 						results.AddStringValue("classname", "string");
 						results.AddStringValue("msg", "OK");
@@ -155,9 +155,9 @@ namespace dcclite::broker::tycoon
 
 	void TycoonService::SaveState()
 	{
-		JsonCreator::StringWriter responseWriter;
+		dcclite::JsonDataWriter responseWriter;
 		{
-			auto object = JsonCreator::MakeObject(responseWriter);
+			auto object = dcclite::MakeObject(responseWriter);
 
 			{
 				auto fastClock = object.AddObject("fastClock");
@@ -0,0 +1,260 @@
+// Copyright (C) 2019 - Bruno Sanches. See the COPYRIGHT
+// file at the top-level directory of this distribution.
+//
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+//
+// This Source Code Form is "Incompatible With Secondary Licenses", as
+// defined by the Mozilla Public License, v. 2.0.
+
+#include "Cbor.h"
+
+#include <bit>
+#include <cmath>
+#include <limits>
+
+namespace dcclite
+{
+	/////////////////////////////////////////////////////////////////////////////
+	//
+	// CborDataWriter
+	//
+	/////////////////////////////////////////////////////////////////////////////
+
+	namespace
+	{
+		constexpr uint8_t CBOR_MAJOR_UNSIGNED_INT = 0;
+		constexpr uint8_t CBOR_MAJOR_NEGATIVE_INT = 1;
+		constexpr uint8_t CBOR_MAJOR_TEXT_STRING = 3;
+
+		constexpr char CBOR_INDEFINITE_ARRAY = '\x9F';
+		constexpr char CBOR_INDEFINITE_MAP = '\xBF';
+		constexpr char CBOR_BREAK = '\xFF';
+
+		constexpr char CBOR_FALSE = '\xF4';
+		constexpr char CBOR_TRUE = '\xF5';
+		constexpr char CBOR_NULL = '\xF6';
+
+		constexpr char CBOR_FLOAT32 = '\xFA';
+		constexpr char CBOR_FLOAT64 = '\xFB';
+
+		template <typename T>
+		inline void AppendBigEndian(std::string &buffer, T value)
+		{
+			for (int shift = (sizeof(T) - 1) * 8; shift >= 0; shift -= 8)
+				buffer.push_back(static_cast<char>((value >> shift) & 0xFF));
+		}
+	}
+
+	void CborDataWriter::WriteHead(uint8_t majorType, uint64_t argument)
+	{
+		const auto type = static_cast<uint8_t>(majorType << 5);
+
+		if (argument < 24)
+		{
+			m_strBuffer.push_back(static_cast<char>(type | argument));
+		}
+		else if (argument <= std::numeric_limits<uint8_t>::max())
+		{
+			m_strBuffer.push_back(static_cast<char>(type | 24));
+			m_strBuffer.push_back(static_cast<char>(argument));
+		}
+		else if (argument <= std::numeric_limits<uint16_t>::max())
+		{
+			m_strBuffer.push_back(static_cast<char>(type | 25));
+			AppendBigEndian(m_strBuffer, static_cast<uint16_t>(argument));
+		}
+		else if (argument <= std::numeric_limits<uint32_t>::max())
+		{
+			m_strBuffer.push_back(static_cast<char>(type | 26));
+			AppendBigEndian(m_strBuffer, static_cast<uint32_t>(argument));
+		}
+		else
+		{
+			m_strBuffer.push_back(static_cast<char>(type | 27));
+			AppendBigEndian(m_strBuffer, argument);
+		}
+	}
+
+	void CborDataWriter::BeginObject()
+	{
+		m_strBuffer.push_back(CBOR_INDEFINITE_MAP);
+	}
+
+	void CborDataWriter::EndObject()
+	{
+		m_strBuffer.push_back(CBOR_BREAK);
+	}
+
+	void CborDataWriter::BeginArray()
+	{
+		m_strBuffer.push_back(CBOR_INDEFINITE_ARRAY);
+	}
+
+	void CborDataWriter::EndArray()
+	{
+		m_strBuffer.push_back(CBOR_BREAK);
+	}
+
+	void CborDataWriter::WriteKey(std::string_view key)
+	{
+		this->WriteString(key);
+	}
+
+	void CborDataWriter::WriteString(std::string_view value)
+	{
+		this->WriteHead(CBOR_MAJOR_TEXT_STRING, value.size());
+
+		m_strBuffer.append(value);
+	}
+
+	void CborDataWriter::WriteInt(int64_t value)
+	{
+		if (value >= 0)
+			this->WriteHead(CBOR_MAJOR_UNSIGNED_INT, static_cast<uint64_t>(value));
+		else
+			this->WriteHead(CBOR_MAJOR_NEGATIVE_INT, ~static_cast<uint64_t>(value));
+	}
+
+	void CborDataWriter::WriteUInt(uint64_t value)
+	{
+		this->WriteHead(CBOR_MAJOR_UNSIGNED_INT, value);
+	}
+
+	void CborDataWriter::WriteDouble(double value)
+	{
+		//use the short form when no precision is lost
+		const bool fitsFloat = !std::isfinite(value) || 
+			((std::fabs(value) <= std::numeric_limits<float>::max()) && (static_cast<double>(static_cast<float>(value)) == value));
+
+		if (fitsFloat)
+		{
+			m_strBuffer.push_back(CBOR_FLOAT32);
+			AppendBigEndian(m_strBuffer, std::bit_cast<uint32_t>(static_cast<float>(value)));
+		}
+		else
+		{
+			m_strBuffer.push_back(CBOR_FLOAT64);
+			AppendBigEndian(m_strBuffer, std::bit_cast<uint64_t>(value));
+		}
+	}
+
+	void CborDataWriter::WriteBool(bool value)
+	{
+		m_strBuffer.push_back(value ? CBOR_TRUE : CBOR_FALSE);
+	}
+
+	void CborDataWriter::WriteNull()
+	{
+		m_strBuffer.push_back(CBOR_NULL);
+	}
+
+	/////////////////////////////////////////////////////////////////////////////
+	//
+	// CborReader
+	//
+	/////////////////////////////////////////////////////////////////////////////
+
+	bool CborReader::ReadHead(Head &head) noexcept
+	{
+		if (!this->GetRemainingBytes()) [[unlikely]]
+			return false;
+
+		const auto initialByte = static_cast<uint8_t>(m_svData[m_uPosition++]);
+
+		head.m_uMajorType = initialByte >> 5;
+		head.m_uInfo = initialByte & 0x1F;
+
+		if (head.m_uInfo < 24)
+		{
+			head.m_uArgument = head.m_uInfo;
+
+			return true;
+		}
+
+		if (head.m_uInfo == INDEFINITE_LENGTH)
+		{
+			head.m_uArgument = 0;
+
+			//only containers (and strings) may have indefinite length
+			return (head.m_uMajorType >= BYTE_STRING) && (head.m_uMajorType <= MAP);
+		}
+
+		if (head.m_uInfo > 27) [[unlikely]]
+			return false;
+
+		const size_t length = size_t{ 1 } << (head.m_uInfo - 24);
+		if (this->GetRemainingBytes() < length) [[unlikely]]
+			return false;
+
+		head.m_uArgument = 0;
+		for (size_t i = 0; i < length; ++i)
+			head.m_uArgument = (head.m_uArgument << 8) | static_cast<uint8_t>(m_svData[m_uPosition++]);
+
+		return true;
+	}
+
+	bool CborReader::ReadText(const Head &head, std::string_view &text) noexcept
+	{
+		if ((head.m_uMajorType != TEXT_STRING) || head.IsIndefinite())
+			return false;
+
+		if (head.m_uArgument > this->GetRemainingBytes())
+			return false;
+
+		text = m_svData.substr(m_uPosition, static_cast<size_t>(head.m_uArgument));
+		m_uPosition += text.size();
+
+		return true;
+	}
+
+	bool CborReader::TryConsumeBreak() noexcept
+	{
+		if (this->GetRemainingBytes() && (static_cast<uint8_t>(m_svData[m_uPosition]) == BREAK_CODE))
+		{
+			++m_uPosition;
+
+			return true;
+		}
+
+		return false;
+	}
+
+	bool CborReader::DecodeFloat(const Head &head, double &value) noexcept
+	{
+		switch (head.m_uInfo)
+		{
+			case 25:
+			{
+				//half precision, see RFC 8949 appendix D
+				const auto half = static_cast<uint16_t>(head.m_uArgument);
+				const int exponent = (half >> 10) & 0x1F;
+				const int mantissa = half & 0x3FF;
+
+				if (exponent == 0)
+					value = std::ldexp(mantissa, -24);
+				else if (exponent != 31)
+					value = std::ldexp(mantissa + 1024, exponent - 25);
+				else
+					value = mantissa == 0 ? std::numeric_limits<double>::infinity() : std::numeric_limits<double>::quiet_NaN();
+
+				if (half & 0x8000)
+					value = -value;
+
+				return true;
+			}
+
+			case 26:
+				value = std::bit_cast<float>(static_cast<uint32_t>(head.m_uArgument));
+				return true;
+
+			case 27:
+				value = std::bit_cast<double>(head.m_uArgument);
+				return true;
+
+			default:
+				return false;
+		}
+	}
+}
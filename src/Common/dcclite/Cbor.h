@@ -0,0 +1,256 @@
+// Copyright (C) 2019 - Bruno Sanches. See the COPYRIGHT
+// file at the top-level directory of this distribution.
+//
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+//
+// This Source Code Form is "Incompatible With Secondary Licenses", as
+// defined by the Mozilla Public License, v. 2.0.
+
+#pragma once
+
+#include <climits>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+#include "DataWriter.h"
+
+/**
+*
+* Minimal CBOR (RFC 8949) support for the terminal binary encoding
+*
+* Objects and arrays are always written using indefinite length, so no size is required up front and the writer can
+* be driven directly by IItem::Serialize. The reader accepts definite and indefinite containers, but only definite
+* text strings, byte strings are not used by the rpc protocol and are rejected.
+*
+*/
+namespace dcclite
+{
+	class CborDataWriter final: public IDataWriter
+	{
+		public:
+			void BeginObject() override;
+			void EndObject() override;
+
+			void BeginArray() override;
+			void EndArray() override;
+
+			void WriteKey(std::string_view key) override;
+
+			void WriteString(std::string_view value) override;
+			void WriteInt(int64_t value) override;
+			void WriteUInt(uint64_t value) override;
+			void WriteDouble(double value) override;
+			void WriteBool(bool value) override;
+			void WriteNull() override;
+
+			inline const std::string &GetString() const noexcept
+			{
+				return m_strBuffer;
+			}
+
+			inline std::string ReleaseString() noexcept
+			{
+				return std::move(m_strBuffer);
+			}
+
+		private:
+			void WriteHead(uint8_t majorType, uint64_t argument);
+
+		private:
+			std::string m_strBuffer;
+	};
+
+	/**
+	*
+	* Decodes a CBOR buffer and sends SAX events to a handler that follows the rapidjson handler interface, so a
+	* rapidjson::Document can be filled by doing: doc.Populate(reader)
+	*
+	* The whole buffer must contain exactly one item, otherwise parsing fails
+	*
+	*/
+	class CborReader
+	{
+		public:
+			explicit CborReader(std::string_view data) noexcept:
+				m_svData{ data }
+			{
+				//empty
+			}
+
+			template <typename Handler>
+			bool operator()(Handler &handler)
+			{
+				m_uPosition = 0;
+
+				if (!this->ParseItem(handler, 0))
+					return false;
+
+				return m_uPosition == m_svData.size();
+			}
+
+		private:
+			enum MajorTypes: uint8_t
+			{
+				UNSIGNED_INT = 0,
+				NEGATIVE_INT = 1,
+				BYTE_STRING = 2,
+				TEXT_STRING = 3,
+				ARRAY = 4,
+				MAP = 5,
+				TAG = 6,
+				SIMPLE = 7
+			};
+
+			struct Head
+			{
+				uint8_t		m_uMajorType;
+				uint8_t		m_uInfo;
+				uint64_t	m_uArgument;
+
+				inline bool IsIndefinite() const noexcept
+				{
+					return m_uInfo == INDEFINITE_LENGTH;
+				}
+			};
+
+			static constexpr uint8_t INDEFINITE_LENGTH = 31;
+			static constexpr uint8_t BREAK_CODE = 0xFF;
+
+			static constexpr unsigned MAX_DEPTH = 64;
+
+			bool ReadHead(Head &head) noexcept;
+			bool ReadText(const Head &head, std::string_view &text) noexcept;
+
+			bool TryConsumeBreak() noexcept;
+
+			static bool DecodeFloat(const Head &head, double &value) noexcept;
+
+			inline size_t GetRemainingBytes() const noexcept
+			{
+				return m_svData.size() - m_uPosition;
+			}
+
+			template <typename Handler>
+			bool ParseItem(Handler &handler, unsigned depth)
+			{
+				if (depth > MAX_DEPTH) [[unlikely]]
+					return false;
+
+				Head head;
+				if (!this->ReadHead(head))
+					return false;
+
+				switch (head.m_uMajorType)
+				{
+					case UNSIGNED_INT:
+						if (head.m_uArgument <= INT_MAX)
+							return handler.Int(static_cast<int>(head.m_uArgument));
+
+						if (head.m_uArgument <= UINT_MAX)
+							return handler.Uint(static_cast<unsigned>(head.m_uArgument));
+
+						return handler.Uint64(head.m_uArgument);
+
+					case NEGATIVE_INT:
+					{
+						if (head.m_uArgument > static_cast<uint64_t>(INT64_MAX))
+							return false;
+
+						const auto value = -1 - static_cast<int64_t>(head.m_uArgument);
+
+						return value >= INT_MIN ? handler.Int(static_cast<int>(value)) : handler.Int64(value);
+					}
+
+					case TEXT_STRING:
+					{
+						std::string_view text;
+						if (!this->ReadText(head, text))
+							return false;
+
+						return handler.String(text.data(), static_cast<unsigned>(text.size()), true);
+					}
+
+					case ARRAY:
+					{
+						if (!handler.StartArray())
+							return false;
+
+						unsigned count = 0;
+						for (;; ++count)
+						{
+							if (head.IsIndefinite() ? this->TryConsumeBreak() : (count == head.m_uArgument))
+								break;
+
+							if (!this->ParseItem(handler, depth + 1))
+								return false;
+						}
+
+						return handler.EndArray(count);
+					}
+
+					case MAP:
+					{
+						if (!handler.StartObject())
+							return false;
+
+						unsigned count = 0;
+						for (;; ++count)
+						{
+							if (head.IsIndefinite() ? this->TryConsumeBreak() : (count == head.m_uArgument))
+								break;
+
+							Head keyHead;
+							std::string_view key;
+							if (!this->ReadHead(keyHead) || !this->ReadText(keyHead, key))
+								return false;
+
+							if (!handler.Key(key.data(), static_cast<unsigned>(key.size()), true))
+								return false;
+
+							if (!this->ParseItem(handler, depth + 1))
+								return false;
+						}
+
+						return handler.EndObject(count);
+					}
+
+					case TAG:
+						//tags (like the self describe one) carry no meaning for us, just decode the tagged item
+						return this->ParseItem(handler, depth + 1);
+
+					case SIMPLE:
+					{
+						switch (head.m_uInfo)
+						{
+							case 20:
+								return handler.Bool(false);
+
+							case 21:
+								return handler.Bool(true);
+
+							case 22:
+							case 23:
+								return handler.Null();
+						}
+
+						double value;
+						if (!DecodeFloat(head, value))
+							return false;
+
+						return handler.Double(value);
+					}
+
+					default:
+						//byte strings
+						return false;
+				}
+			}
+
+		private:
+			std::string_view	m_svData;
+			size_t				m_uPosition = 0;
+	};
+}
@@ -0,0 +1,289 @@
+// Copyright (C) 2019 - Bruno Sanches. See the COPYRIGHT
+// file at the top-level directory of this distribution.
+//
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+//
+// This Source Code Form is "Incompatible With Secondary Licenses", as
+// defined by the Mozilla Public License, v. 2.0.
+
+#include "DataWriter.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iterator>
+
+#include <fmt/format.h>
+
+namespace dcclite
+{
+	void JsonDataWriter::BeginValue()
+	{
+		if (m_fNeedSeparator)
+			m_strBuffer.push_back(',');
+
+		m_fNeedSeparator = true;
+	}
+
+	void JsonDataWriter::BeginObject()
+	{
+		this->BeginValue();
+
+		m_strBuffer.push_back('{');
+		m_fNeedSeparator = false;
+	}
+
+	void JsonDataWriter::EndObject()
+	{
+		m_strBuffer.push_back('}');
+		m_fNeedSeparator = true;
+	}
+
+	void JsonDataWriter::BeginArray()
+	{
+		this->BeginValue();
+
+		m_strBuffer.push_back('[');
+		m_fNeedSeparator = false;
+	}
+
+	void JsonDataWriter::EndArray()
+	{
+		m_strBuffer.push_back(']');
+		m_fNeedSeparator = true;
+	}
+
+	void JsonDataWriter::WriteKey(std::string_view key)
+	{
+		this->BeginValue();
+		this->WriteEscapedString(key);
+
+		m_strBuffer.push_back(':');
+
+		//the value that follows the key does not need a separator
+		m_fNeedSeparator = false;
+	}
+
+	void JsonDataWriter::WriteString(std::string_view value)
+	{
+		this->BeginValue();
+		this->WriteEscapedString(value);
+	}
+
+	void JsonDataWriter::WriteInt(int64_t value)
+	{
+		this->BeginValue();
+
+		fmt::format_to(std::back_inserter(m_strBuffer), "{}", value);
+	}
+
+	void JsonDataWriter::WriteUInt(uint64_t value)
+	{
+		this->BeginValue();
+
+		fmt::format_to(std::back_inserter(m_strBuffer), "{}", value);
+	}
+
+	void JsonDataWriter::WriteDouble(double value)
+	{
+		//json has no representation for nan or infinity
+		if (!std::isfinite(value)) [[unlikely]]
+		{
+			this->WriteNull();
+
+			return;
+		}
+
+		this->BeginValue();
+
+		fmt::format_to(std::back_inserter(m_strBuffer), "{}", value);
+	}
+
+	void JsonDataWriter::WriteBool(bool value)
+	{
+		this->BeginValue();
+
+		m_strBuffer.append(value ? "true" : "false");
+	}
+
+	void JsonDataWriter::WriteNull()
+	{
+		this->BeginValue();
+
+		m_strBuffer.append("null");
+	}
+
+	void JsonDataWriter::WriteEscapedString(std::string_view str)
+	{
+		m_strBuffer.push_back('"');
+
+		auto runBegin = str.begin();
+		for (auto it = str.begin(), end = str.end(); it != end; ++it)
+		{
+			const auto ch = static_cast<unsigned char>(*it);
+
+			if ((ch >= 0x20) && (ch != '"') && (ch != '\\')) [[likely]]
+				continue;
+
+			m_strBuffer.append(runBegin, it);
+			runBegin = it + 1;
+
+			switch (ch)
+			{
+				case '"':
+					m_strBuffer.append("\\\"");
+					break;
+
+				case '\\':
+					m_strBuffer.append("\\\\");
+					break;
+
+				case '\n':
+					m_strBuffer.append("\\n");
+					break;
+
+				case '\r':
+					m_strBuffer.append("\\r");
+					break;
+
+				case '\t':
+					m_strBuffer.append("\\t");
+					break;
+
+				default:
+					fmt::format_to(std::back_inserter(m_strBuffer), "\\u{:04x}", ch);
+					break;
+			}
+		}
+
+		m_strBuffer.append(runBegin, str.end());
+		m_strBuffer.push_back('"');
+	}
+
+	/////////////////////////////////////////////////////////////////////////////
+	//
+	// ProjectionDataWriter
+	//
+	/////////////////////////////////////////////////////////////////////////////
+
+	bool ProjectionDataWriter::SkipValue() noexcept
+	{
+		if (m_uSkipDepth)
+			return true;
+
+		if (m_fSkipNext)
+		{
+			m_fSkipNext = false;
+
+			return true;
+		}
+
+		return false;
+	}
+
+	bool ProjectionDataWriter::BeginContainer()
+	{
+		if (m_uSkipDepth || m_fSkipNext)
+		{
+			m_fSkipNext = false;
+			++m_uSkipDepth;
+
+			return false;
+		}
+
+		++m_uDepth;
+
+		return true;
+	}
+
+	bool ProjectionDataWriter::EndContainer()
+	{
+		if (m_uSkipDepth)
+		{
+			--m_uSkipDepth;
+
+			return false;
+		}
+
+		--m_uDepth;
+
+		return true;
+	}
+
+	void ProjectionDataWriter::BeginObject()
+	{
+		if (this->BeginContainer())
+			m_rclTarget.BeginObject();
+	}
+
+	void ProjectionDataWriter::EndObject()
+	{
+		if (this->EndContainer())
+			m_rclTarget.EndObject();
+	}
+
+	void ProjectionDataWriter::BeginArray()
+	{
+		if (this->BeginContainer())
+			m_rclTarget.BeginArray();
+	}
+
+	void ProjectionDataWriter::EndArray()
+	{
+		if (this->EndContainer())
+			m_rclTarget.EndArray();
+	}
+
+	void ProjectionDataWriter::WriteKey(std::string_view key)
+	{
+		if (m_uSkipDepth)
+			return;
+
+		//only keys of the projected object are filtered
+		if ((m_uDepth == 1) && (std::find(m_rvecFields.begin(), m_rvecFields.end(), key) == m_rvecFields.end()))
+		{
+			m_fSkipNext = true;
+
+			return;
+		}
+
+		m_rclTarget.WriteKey(key);
+	}
+
+	void ProjectionDataWriter::WriteString(std::string_view value)
+	{
+		if (!this->SkipValue())
+			m_rclTarget.WriteString(value);
+	}
+
+	void ProjectionDataWriter::WriteInt(int64_t value)
+	{
+		if (!this->SkipValue())
+			m_rclTarget.WriteInt(value);
+	}
+
+	void ProjectionDataWriter::WriteUInt(uint64_t value)
+	{
+		if (!this->SkipValue())
+			m_rclTarget.WriteUInt(value);
+	}
+
+	void ProjectionDataWriter::WriteDouble(double value)
+	{
+		if (!this->SkipValue())
+			m_rclTarget.WriteDouble(value);
+	}
+
+	void ProjectionDataWriter::WriteBool(bool value)
+	{
+		if (!this->SkipValue())
+			m_rclTarget.WriteBool(value);
+	}
+
+	void ProjectionDataWriter::WriteNull()
+	{
+		if (!this->SkipValue())
+			m_rclTarget.WriteNull();
+	}
+}
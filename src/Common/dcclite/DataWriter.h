@@ -0,0 +1,303 @@
+// Copyright (C) 2019 - Bruno Sanches. See the COPYRIGHT
+// file at the top-level directory of this distribution.
+//
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+//
+// This Source Code Form is "Incompatible With Secondary Licenses", as
+// defined by the Mozilla Public License, v. 2.0.
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace dcclite
+{
+	/**
+	*
+	* Low level output format, receives a stream of structure events (objects, arrays, keys and values) and
+	* encodes it, so the same Serialize code can generate json, cbor, etc
+	*
+	*/
+	class IDataWriter
+	{
+		public:
+			virtual ~IDataWriter() = default;
+
+			virtual void BeginObject() = 0;
+			virtual void EndObject() = 0;
+
+			virtual void BeginArray() = 0;
+			virtual void EndArray() = 0;
+
+			virtual void WriteKey(std::string_view key) = 0;
+
+			virtual void WriteString(std::string_view value) = 0;
+			virtual void WriteInt(int64_t value) = 0;
+			virtual void WriteUInt(uint64_t value) = 0;
+			virtual void WriteDouble(double value) = 0;
+			virtual void WriteBool(bool value) = 0;
+			virtual void WriteNull() = 0;
+	};
+
+	class JsonDataWriter final: public IDataWriter
+	{
+		public:
+			void BeginObject() override;
+			void EndObject() override;
+
+			void BeginArray() override;
+			void EndArray() override;
+
+			void WriteKey(std::string_view key) override;
+
+			void WriteString(std::string_view value) override;
+			void WriteInt(int64_t value) override;
+			void WriteUInt(uint64_t value) override;
+			void WriteDouble(double value) override;
+			void WriteBool(bool value) override;
+			void WriteNull() override;
+
+			inline const std::string &GetString() const noexcept
+			{
+				return m_strBuffer;
+			}
+
+			inline std::string ReleaseString() noexcept
+			{
+				m_fNeedSeparator = false;
+
+				return std::move(m_strBuffer);
+			}
+
+		private:
+			void BeginValue();
+
+			void WriteEscapedString(std::string_view str);
+
+		private:
+			std::string m_strBuffer;
+
+			bool m_fNeedSeparator = false;
+	};
+
+	/**
+	*
+	* Forwards to another writer only the selected keys of the first object written, so any Serialize 
+	* method can be used to produce a partial view of an object (ie, only name and state)
+	*
+	* Nested values of a selected key are forwarded untouched
+	*
+	*/
+	class ProjectionDataWriter final: public IDataWriter
+	{
+		public:
+			ProjectionDataWriter(IDataWriter &target, const std::vector<std::string> &fields) noexcept:
+				m_rclTarget{ target },
+				m_rvecFields{ fields }
+			{
+				//empty
+			}
+
+			void BeginObject() override;
+			void EndObject() override;
+
+			void BeginArray() override;
+			void EndArray() override;
+
+			void WriteKey(std::string_view key) override;
+
+			void WriteString(std::string_view value) override;
+			void WriteInt(int64_t value) override;
+			void WriteUInt(uint64_t value) override;
+			void WriteDouble(double value) override;
+			void WriteBool(bool value) override;
+			void WriteNull() override;
+
+		private:
+			bool BeginContainer();
+			bool EndContainer();
+
+			bool SkipValue() noexcept;
+
+		private:
+			IDataWriter						&m_rclTarget;
+			const std::vector<std::string>	&m_rvecFields;
+
+			unsigned	m_uDepth = 0;
+
+			//how deep we are inside a value being discarded
+			unsigned	m_uSkipDepth = 0;
+
+			//set when a key is discarded, so its value is also discarded
+			bool		m_fSkipNext = false;
+	};
+
+	class ArrayOutputStream;
+
+	/**
+	*
+	* Writes an object to a IDataWriter, the object is closed when the stream is destroyed
+	*
+	* Nested objects and arrays must be destroyed before adding new values to the parent
+	*
+	*/
+	class ObjectOutputStream
+	{
+		public:
+			explicit inline ObjectOutputStream(IDataWriter &writer):
+				m_pclWriter{ &writer }
+			{
+				writer.BeginObject();
+			}
+
+			inline ObjectOutputStream(ObjectOutputStream &&other) noexcept:
+				m_pclWriter{ other.m_pclWriter }
+			{
+				other.m_pclWriter = nullptr;
+			}
+
+			ObjectOutputStream(const ObjectOutputStream &) = delete;
+
+			ObjectOutputStream &operator=(const ObjectOutputStream &) = delete;
+			ObjectOutputStream &operator=(ObjectOutputStream &&) = delete;
+
+			inline ~ObjectOutputStream()
+			{
+				if (m_pclWriter)
+					m_pclWriter->EndObject();
+			}
+
+			inline void AddStringValue(std::string_view name, std::string_view value)
+			{
+				m_pclWriter->WriteKey(name);
+				m_pclWriter->WriteString(value);
+			}
+
+			inline void AddIntValue(std::string_view name, int64_t value)
+			{
+				m_pclWriter->WriteKey(name);
+				m_pclWriter->WriteInt(value);
+			}
+
+			inline void AddInt64Value(std::string_view name, int64_t value)
+			{
+				this->AddIntValue(name, value);
+			}
+
+			inline void AddFloatValue(std::string_view name, double value)
+			{
+				m_pclWriter->WriteKey(name);
+				m_pclWriter->WriteDouble(value);
+			}
+
+			inline void AddBool(std::string_view name, bool value)
+			{
+				m_pclWriter->WriteKey(name);
+				m_pclWriter->WriteBool(value);
+			}
+
+			inline void AddPointerValue(std::string_view name, const void *value)
+			{
+				m_pclWriter->WriteKey(name);
+				m_pclWriter->WriteUInt(reinterpret_cast<uintptr_t>(value));
+			}
+
+			inline void AddNull(std::string_view name)
+			{
+				m_pclWriter->WriteKey(name);
+				m_pclWriter->WriteNull();
+			}
+
+			inline ObjectOutputStream AddObject(std::string_view name)
+			{
+				m_pclWriter->WriteKey(name);
+
+				return ObjectOutputStream{ *m_pclWriter };
+			}
+
+			inline ArrayOutputStream AddArray(std::string_view name);
+
+		private:
+			IDataWriter *m_pclWriter;
+	};
+
+	class ArrayOutputStream
+	{
+		public:
+			explicit inline ArrayOutputStream(IDataWriter &writer):
+				m_pclWriter{ &writer }
+			{
+				writer.BeginArray();
+			}
+
+			inline ArrayOutputStream(ArrayOutputStream &&other) noexcept:
+				m_pclWriter{ other.m_pclWriter }
+			{
+				other.m_pclWriter = nullptr;
+			}
+
+			ArrayOutputStream(const ArrayOutputStream &) = delete;
+
+			ArrayOutputStream &operator=(const ArrayOutputStream &) = delete;
+			ArrayOutputStream &operator=(ArrayOutputStream &&) = delete;
+
+			inline ~ArrayOutputStream()
+			{
+				if (m_pclWriter)
+					m_pclWriter->EndArray();
+			}
+
+			inline void AddString(std::string_view value)
+			{
+				m_pclWriter->WriteString(value);
+			}
+
+			inline void AddIntValue(int64_t value)
+			{
+				m_pclWriter->WriteInt(value);
+			}
+
+			inline void AddBool(bool value)
+			{
+				m_pclWriter->WriteBool(value);
+			}
+
+			inline ObjectOutputStream AddObject()
+			{
+				return ObjectOutputStream{ *m_pclWriter };
+			}
+
+			inline ArrayOutputStream AddArray()
+			{
+				return ArrayOutputStream{ *m_pclWriter };
+			}
+
+			/**
+			* Allows elements to be written using a custom writer, like ProjectionDataWriter
+			*/
+			inline IDataWriter &GetWriter() const noexcept
+			{
+				return *m_pclWriter;
+			}
+
+		private:
+			IDataWriter *m_pclWriter;
+	};
+
+	inline ArrayOutputStream ObjectOutputStream::AddArray(std::string_view name)
+	{
+		m_pclWriter->WriteKey(name);
+
+		return ArrayOutputStream{ *m_pclWriter };
+	}
+
+	inline ObjectOutputStream MakeObject(IDataWriter &writer)
+	{
+		return ObjectOutputStream{ writer };
+	}
+}
@@ -77,6 +77,22 @@ namespace dcclite
 		}
 	}
 
+	bool FolderObject::ConstVisitChildrenAfter(RName name, ConstVisitor_t visitor) const
+	{
+		//names keep their order even after the child is removed, so we can always resume
+		auto it = m_mapObjects.lower_bound(name);
+		if ((it != m_mapObjects.end()) && (it->first == name))
+			++it;
+
+		for (; it != m_mapObjects.end(); ++it)
+		{
+			if (!visitor(*it->second.get()))
+				break;
+		}
+
+		return true;
+	}
+
 	void FolderObject::VisitChildren(Visitor_t visitor)
 	{
 		for (auto &pair : m_mapObjects)
@@ -34,6 +34,8 @@ namespace dcclite
 			void ConstVisitChildren(ConstVisitor_t visitor) const override;
 			void VisitChildren(Visitor_t visitor) override;
 
+			bool ConstVisitChildrenAfter(RName name, ConstVisitor_t visitor) const override;
+
 			void KillerVisitChildren(Visitor_t visitor);
 			
 			const char *GetTypeName() const noexcept override
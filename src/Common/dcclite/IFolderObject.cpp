@@ -65,6 +65,26 @@ namespace dcclite
 		return currentNode;
 	}	
 
+	bool IFolderObject::ConstVisitChildrenAfter(RName name, ConstVisitor_t visitor) const
+	{
+		bool found = false;
+
+		this->ConstVisitChildren([&](const IObject &item)
+			{
+				if (!found)
+				{
+					found = item.GetName() == name;
+
+					return true;
+				}
+
+				return visitor(item);
+			}
+		);
+
+		return found;
+	}
+
 	IFolderObject &IFolderObject::GetRoot()
 	{
 		auto parent = this;
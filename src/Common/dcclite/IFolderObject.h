@@ -41,5 +41,12 @@ namespace dcclite
 
 			virtual void ConstVisitChildren(ConstVisitor_t visitor) const = 0;
 			virtual void VisitChildren(Visitor_t visitor) = 0;
+
+			/**
+			* Visits the children that come after name, used to resume listings.
+			*
+			* Returns false when name is not a child and the folder cannot tell where it was
+			*/
+			virtual bool ConstVisitChildrenAfter(RName name, ConstVisitor_t visitor) const;
 	};	
 }
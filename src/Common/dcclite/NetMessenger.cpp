@@ -11,8 +11,10 @@
 #include "NetMessenger.h"
 
 #include <algorithm>
+#include <stdexcept>
 #include <string.h>
 
+#include "Log.h"
 #include "Util.h"
 
 namespace dcclite
@@ -38,14 +40,32 @@ namespace dcclite
 		m_clSocket{ std::move(rhs.m_clSocket) },
 		m_pszSeparator{rhs.m_pszSeparator},
 		m_uSeparatorLength{rhs.m_uSeparatorLength},
+		m_kFraming{ rhs.m_kFraming.load() },
 		m_lstMessages{ std::move(rhs.m_lstMessages) },
-		m_strIncomingMessage{ std::move(rhs.m_strIncomingMessage) }	
+		m_strIncomingMessage{ std::move(rhs.m_strIncomingMessage) },
+		m_strOutgoing{ std::move(rhs.m_strOutgoing) }
 	{
 		//empty
 	}
 
-	void NetMessenger::ParseIncomingMessage()
+	NetMessenger &NetMessenger::operator=(NetMessenger &&rhs) noexcept
 	{
+		m_clSocket = std::move(rhs.m_clSocket);
+		m_pszSeparator = rhs.m_pszSeparator;
+		m_uSeparatorLength = rhs.m_uSeparatorLength;
+		m_kFraming = rhs.m_kFraming.load();
+		m_lstMessages = std::move(rhs.m_lstMessages);
+		m_strIncomingMessage = std::move(rhs.m_strIncomingMessage);
+		m_strOutgoing = std::move(rhs.m_strOutgoing);
+
+		return *this;
+	}
+
+	bool NetMessenger::ParseIncomingMessage()
+	{
+		if (m_kFraming == Framing::LENGTH_PREFIX)
+			return this->ParseLengthPrefixedMessage();
+
 		for (auto pos = m_strIncomingMessage.find(m_pszSeparator); pos != std::string::npos; pos = m_strIncomingMessage.find(m_pszSeparator))
 		{
 			if(pos)
@@ -53,6 +73,60 @@ namespace dcclite
 
 			m_strIncomingMessage.erase(0, pos + m_uSeparatorLength);
 		}
+
+		return true;
+	}
+
+	bool NetMessenger::ParseLengthPrefixedMessage()
+	{
+		bool valid = true;
+		size_t pos = 0;
+
+		while (m_strIncomingMessage.length() - pos >= sizeof(uint32_t))
+		{
+			auto header = reinterpret_cast<const uint8_t *>(m_strIncomingMessage.data() + pos);
+
+			const uint32_t length = (uint32_t{ header[0] } << 24) | (uint32_t{ header[1] } << 16) | (uint32_t{ header[2] } << 8) | header[3];
+			if (length > MAX_FRAME_LENGTH) [[unlikely]]
+			{
+				valid = false;
+
+				break;
+			}
+
+			if (m_strIncomingMessage.length() - pos - sizeof(uint32_t) < length)
+				break;
+
+			//empty frames are ignored, like empty lines on text mode
+			if (length)
+				m_lstMessages.emplace_back(m_strIncomingMessage, pos + sizeof(uint32_t), length);
+
+			pos += sizeof(uint32_t) + length;
+		}
+
+		m_strIncomingMessage.erase(0, pos);
+
+		return valid;
+	}
+
+	std::string NetMessenger::MakeFrame(std::string_view msg) const
+	{
+		if (msg.length() > MAX_FRAME_LENGTH)
+			throw std::length_error("[NetMessenger::MakeFrame] message is too big for a frame");
+
+		const auto length = static_cast<uint32_t>(msg.length());
+
+		std::string frame;
+		frame.reserve(sizeof(uint32_t) + msg.length());
+
+		frame.push_back(static_cast<char>((length >> 24) & 0xFF));
+		frame.push_back(static_cast<char>((length >> 16) & 0xFF));
+		frame.push_back(static_cast<char>((length >> 8) & 0xFF));
+		frame.push_back(static_cast<char>(length & 0xFF));
+
+		frame.append(msg);
+
+		return frame;
 	}
 
 	std::tuple<Socket::Status, std::string> NetMessenger::Poll()
@@ -71,7 +145,14 @@ namespace dcclite
 		{
 			m_strIncomingMessage.append(tmpBuffer, size);
 					
-			this->ParseIncomingMessage();
+			if (!this->ParseIncomingMessage()) [[unlikely]]
+			{
+				dcclite::Log::Error("[NetMessenger::Poll] Received invalid frame, dropping connection");
+
+				m_clSocket.Close();
+
+				return std::make_tuple(Socket::Status::DISCONNECTED, std::string{});
+			}
 		}
 
 		return this->PollInternalQueue();		
@@ -96,6 +177,13 @@ namespace dcclite
 
 	bool NetMessenger::Send(const NetworkAddress &destination, std::string_view msg)
 	{	
+		if (m_kFraming == Framing::LENGTH_PREFIX)
+		{
+			const auto frame = this->MakeFrame(msg);
+
+			return m_clSocket.Send(destination, frame.data(), frame.length());
+		}
+
 		if (!dcclite::StrEndsWith(msg, "\r\n"))
 		{
 			std::string newMsg{msg};
@@ -112,22 +200,61 @@ namespace dcclite
 
 	bool NetMessenger::Send(std::string_view msg)
 	{
+		if (m_kFraming == Framing::LENGTH_PREFIX)
+		{
+			const auto frame = this->MakeFrame(msg);
+
+			return this->SendData(frame.data(), frame.length());
+		}
+
 		if (!dcclite::StrEndsWith(msg, "\r\n"))
 		{
 			std::string newMsg{ msg };
 
 			newMsg.append("\r\n");
 
-			auto [status, size] = m_clSocket.Send(newMsg.data(), newMsg.length());
-			return status != Socket::Status::DISCONNECTED;
+			return this->SendData(newMsg.data(), newMsg.length());
 		}
 		else
 		{
-			auto [status, size] = m_clSocket.Send(msg.data(), msg.length());
-			return status != Socket::Status::DISCONNECTED;			
+			return this->SendData(msg.data(), msg.length());
 		}
 	}
 
+	bool NetMessenger::SendData(const char *data, const size_t size)
+	{
+		//keep the order, new data goes after anything still pending
+		if (!m_strOutgoing.empty())
+		{
+			m_strOutgoing.append(data, size);
+
+			return this->Flush() != Socket::Status::DISCONNECTED;
+		}
+
+		auto [status, sent] = m_clSocket.Send(data, size);
+		if (status == Socket::Status::DISCONNECTED)
+			return false;
+
+		if (sent < size)
+			m_strOutgoing.append(data + sent, size - sent);
+
+		return true;
+	}
+
+	Socket::Status NetMessenger::Flush()
+	{
+		if (m_strOutgoing.empty())
+			return Socket::Status::OK;
+
+		auto [status, sent] = m_clSocket.Send(m_strOutgoing.data(), m_strOutgoing.length());
+		if (status != Socket::Status::OK)
+			return status;
+
+		m_strOutgoing.erase(0, sent);
+
+		return m_strOutgoing.empty() ? Socket::Status::OK : Socket::Status::WOULD_BLOCK;
+	}
+
 	std::tuple<Socket::Status, std::string> NetMessenger::PollInternalQueue()
 	{
 		if (m_lstMessages.empty())
@@ -10,6 +10,7 @@
 
 #pragma once
 
+#include <atomic>
 #include <deque>
 #include <string>
 #include <tuple>
@@ -21,11 +22,30 @@ namespace dcclite
 {
 	class NetMessenger
 	{
+		public:
+			enum class Framing
+			{
+				/**
+				* Messages are terminated by the separator, used by text protocols
+				*/
+				SEPARATOR,
+
+				/**
+				* Messages are preceded by its length (32 bits, big endian), used for binary payloads
+				*/
+				LENGTH_PREFIX
+			};
+
+			/**
+			* Length prefixed messages bigger than this are considered a protocol error and the connection is dropped
+			*/
+			static constexpr uint32_t MAX_FRAME_LENGTH = 16 * 1024 * 1024;
+
 		public:
 			explicit NetMessenger(Socket &&socket, const char *separator = "\r\n", const char *initialBuffer = "");
 			NetMessenger(NetMessenger&& rhs) noexcept;
 
-			NetMessenger &operator=(NetMessenger&& rhs) noexcept = default;
+			NetMessenger &operator=(NetMessenger&& rhs) noexcept;
 
 			NetMessenger(const NetMessenger &rhs) = delete;			
 			const NetMessenger operator=(const NetMessenger& rhs) = delete;			
@@ -34,14 +54,56 @@ namespace dcclite
 			std::tuple<Socket::Status, std::string> SyncPoll();
 
 			bool Send(const NetworkAddress &destination, std::string_view msg);
+
+			/**
+			* On non blocking sockets, whatever the socket does not take is kept and sent by the next Send or Flush call
+			*
+			* Returns false only if the connection was lost
+			*/
 			bool Send(std::string_view msg);
 
+			/**
+			* Tries to send data left by previous Send calls, returns WOULD_BLOCK if something is still pending
+			*/
+			Socket::Status Flush();
+
+			inline bool HasPendingOutput() const noexcept
+			{
+				return !m_strOutgoing.empty();
+			}
+
+			inline Socket::Handler_t GetHandle() const noexcept
+			{
+				return m_clSocket.GetHandle();
+			}
+
 			void Close();			
 
+			/**
+			* Changes how messages are delimited on both directions
+			*
+			* May be called while another thread is polling, the new framing is used for any data received after this call,
+			* so callers switching protocols must make sure the remote side only sends new frames after being notified
+			*/
+			inline void SetFraming(const Framing framing) noexcept
+			{
+				m_kFraming = framing;
+			}
+
+			inline Framing GetFraming() const noexcept
+			{
+				return m_kFraming;
+			}
+
 		private:
 			std::tuple<Socket::Status, std::string> PollInternalQueue();
 
-			void ParseIncomingMessage();
+			bool ParseIncomingMessage();
+			bool ParseLengthPrefixedMessage();
+
+			std::string MakeFrame(std::string_view msg) const;
+
+			bool SendData(const char *data, size_t size);
 
 			Socket::Status WaitData();
 
@@ -51,8 +113,13 @@ namespace dcclite
 			const char *m_pszSeparator;
 			size_t		m_uSeparatorLength;
 
+			std::atomic<Framing> m_kFraming = Framing::SEPARATOR;
+
 			std::deque<std::string> m_lstMessages;
 
 			std::string m_strIncomingMessage;
+
+			//data not taken by the socket yet
+			std::string m_strOutgoing;
 	};
 }
@@ -15,9 +15,7 @@
 
 #include <string>
 
-#include <JsonCreator/Object.h>
-#include <JsonCreator/StringWriter.h>
-
+#include "DataWriter.h"
 #include "RName.h"
 
 namespace dcclite
@@ -144,7 +142,8 @@ namespace dcclite
 	};
 
 	typedef ObjectPath Path_t;
-	typedef JsonCreator::Object<JsonCreator::StringWriter> JsonOutputStream_t;
+	//the name is historical, the stream is format agnostic and may be writing json or cbor
+	typedef ObjectOutputStream JsonOutputStream_t;
 
 	class IItem
 	{
@@ -0,0 +1,103 @@
+// Copyright (C) 2019 - Bruno Sanches. See the COPYRIGHT
+// file at the top-level directory of this distribution.
+//
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+//
+// This Source Code Form is "Incompatible With Secondary Licenses", as
+// defined by the Mozilla Public License, v. 2.0.
+
+#include "SerialCapture.h"
+
+#include <cstring>
+#include <stdexcept>
+
+#include <fmt/format.h>
+
+namespace dcclite
+{
+	static constexpr char CAPTURE_MAGIC[] = { 'D', 'L', 'S', 'E', 'R', 'C', 'A', 'P' };
+	static constexpr uint8_t CAPTURE_VERSION = 1;
+
+	static constexpr auto RECORD_HEADER_SIZE = 8 + 1 + 2;
+
+	SerialCaptureWriter::SerialCaptureWriter(const dcclite::fs::path &fileName):
+		m_clStream{ fileName, std::ios_base::binary | std::ios_base::trunc },
+		m_tStart{ Clock::DefaultClock_t::now() }
+	{
+		if (!m_clStream)
+			throw std::runtime_error(fmt::format("[SerialCaptureWriter] Cannot create {}", fileName.string()));
+
+		m_clStream.write(CAPTURE_MAGIC, sizeof(CAPTURE_MAGIC));
+		m_clStream.put(static_cast<char>(CAPTURE_VERSION));
+	}
+
+	void SerialCaptureWriter::Record(const SerialCaptureDirections direction, const uint8_t *data, const unsigned size)
+	{
+		this->Record(direction, data, size, std::chrono::duration_cast<std::chrono::microseconds>(Clock::DefaultClock_t::now() - m_tStart));
+	}
+
+	void SerialCaptureWriter::Record(const SerialCaptureDirections direction, const uint8_t *data, const unsigned size, const std::chrono::microseconds timestamp)
+	{
+		if (size > UINT16_MAX)
+			throw std::invalid_argument(fmt::format("[SerialCaptureWriter::Record] Record too big: {}", size));
+
+		uint8_t header[RECORD_HEADER_SIZE];
+
+		const uint64_t ts = timestamp.count();
+		for (int i = 0; i < 8; ++i)
+			header[i] = static_cast<uint8_t>(ts >> (i * 8));
+
+		header[8] = static_cast<uint8_t>(direction);
+		header[9] = static_cast<uint8_t>(size);
+		header[10] = static_cast<uint8_t>(size >> 8);
+
+		m_clStream.write(reinterpret_cast<const char *>(header), sizeof(header));
+		m_clStream.write(reinterpret_cast<const char *>(data), size);
+
+		//captures are for debugging, so we rather lose speed than the last records if the broker dies
+		m_clStream.flush();
+	}
+
+	std::vector<SerialCaptureRecord> LoadSerialCapture(const dcclite::fs::path &fileName)
+	{
+		std::ifstream stream{ fileName, std::ios_base::binary };
+		if (!stream)
+			throw std::runtime_error(fmt::format("[LoadSerialCapture] Cannot open {}", fileName.string()));
+
+		char magic[sizeof(CAPTURE_MAGIC)];
+		stream.read(magic, sizeof(magic));
+
+		if (!stream || memcmp(magic, CAPTURE_MAGIC, sizeof(magic)))
+			throw std::runtime_error(fmt::format("[LoadSerialCapture] {} is not a capture file", fileName.string()));
+
+		const auto version = stream.get();
+		if (version != CAPTURE_VERSION)
+			throw std::runtime_error(fmt::format("[LoadSerialCapture] {} has unknown version {}", fileName.string(), version));
+
+		std::vector<SerialCaptureRecord> records;
+
+		uint8_t header[RECORD_HEADER_SIZE];
+		while (stream.read(reinterpret_cast<char *>(header), sizeof(header)))
+		{
+			uint64_t ts = 0;
+			for (int i = 0; i < 8; ++i)
+				ts |= static_cast<uint64_t>(header[i]) << (i * 8);
+
+			auto &record = records.emplace_back();
+
+			record.m_tTimestamp = std::chrono::microseconds{ ts };
+			record.m_kDirection = static_cast<SerialCaptureDirections>(header[8]);
+			record.m_vecData.resize(header[9] | (header[10] << 8));
+
+			if (!stream.read(reinterpret_cast<char *>(record.m_vecData.data()), record.m_vecData.size()))
+				throw std::runtime_error(fmt::format("[LoadSerialCapture] {} is truncated", fileName.string()));
+		}
+
+		if (stream.gcount())
+			throw std::runtime_error(fmt::format("[LoadSerialCapture] {} is truncated", fileName.string()));
+
+		return records;
+	}
+}
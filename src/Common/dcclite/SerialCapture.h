@@ -0,0 +1,75 @@
+// Copyright (C) 2019 - Bruno Sanches. See the COPYRIGHT
+// file at the top-level directory of this distribution.
+//
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+//
+// This Source Code Form is "Incompatible With Secondary Licenses", as
+// defined by the Mozilla Public License, v. 2.0.
+
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <vector>
+
+#include "Clock.h"
+#include "FileSystem.h"
+
+namespace dcclite
+{
+	/**
+
+		Raw serial port traffic capture, used for replaying bus traffic offline (see SerialReplay)
+
+		File format (little endian):
+			header: "DLSERCAP" + uint8 version
+			records: uint64 microseconds since capture start, uint8 direction, uint16 size, data
+
+	*/
+	enum class SerialCaptureDirections: uint8_t
+	{
+		RX = 0,
+		TX = 1
+	};
+
+	struct SerialCaptureRecord
+	{
+		std::chrono::microseconds m_tTimestamp;
+
+		SerialCaptureDirections m_kDirection;
+
+		std::vector<uint8_t> m_vecData;
+	};
+
+	class SerialCaptureWriter
+	{
+		public:
+			explicit SerialCaptureWriter(const dcclite::fs::path &fileName);
+
+			SerialCaptureWriter(const SerialCaptureWriter &) = delete;
+			SerialCaptureWriter &operator=(const SerialCaptureWriter &) = delete;
+
+			/**
+			* Timestamp is the time since the capture was created
+			*/
+			void Record(const SerialCaptureDirections direction, const uint8_t *data, const unsigned size);
+
+			/**
+			* For building captures by hand, timestamps must not go back
+			*/
+			void Record(const SerialCaptureDirections direction, const uint8_t *data, const unsigned size, const std::chrono::microseconds timestamp);
+
+		private:
+			std::ofstream m_clStream;
+
+			Clock::TimePoint_t m_tStart;
+	};
+
+	/**
+	* Throws std::runtime_error if the file is not a capture or it is truncated
+	*/
+	std::vector<SerialCaptureRecord> LoadSerialCapture(const dcclite::fs::path &fileName);
+}
@@ -18,6 +18,8 @@
 
 #include <fmt/format.h>
 
+#include "SerialCapture.h"
+
 namespace dcclite
 {	
 	bool SerialPort::DataPacket::IsDataReady()
@@ -56,6 +58,9 @@ namespace dcclite
 		m_fWaiting = false;
 		m_uDataSize = numBytesTransferred;
 
+		if (m_pclCapture)
+			m_pclCapture->Record(m_kCaptureDirection, m_u8Data, m_uDataSize);
+
 		return true;
 	}
 
@@ -116,6 +121,12 @@ namespace dcclite
 		//One stop bit
 		options.c_cflag &= ~CSTOPB;
 
+		//
+		//Raw mode, LocoNet is binary: no line editing, echo, signals or output processing (0x0A is not a new line)
+		options.c_iflag &= ~(IGNBRK | BRKINT | PARMRK | ISTRIP | INLCR | IGNCR | ICRNL | IXON | IXOFF);
+		options.c_oflag &= ~OPOST;
+		options.c_lflag &= ~(ECHO | ECHONL | ICANON | ISIG | IEXTEN);
+
 		options.c_cc[VMIN] = 1;
 		options.c_cc[VTIME] = 0x64;
 
@@ -172,7 +183,13 @@ namespace dcclite
 			//try later...
 			packet.m_fWaiting = true;
 			packet.m_iPortHandle = this->m_iPortHandle;				
+			packet.m_pclCapture = m_pclCapture;
+			packet.m_kCaptureDirection = SerialCaptureDirections::TX;
 		}		
+		else if (m_pclCapture)
+		{
+			m_pclCapture->Record(SerialCaptureDirections::TX, packet.GetData(), bytesWritten);
+		}
 	}
 
 	void SerialPort::Read(DataPacket &packet)
@@ -193,10 +210,15 @@ namespace dcclite
 			//try later...
 			packet.m_fWaiting = true;
 			packet.m_iPortHandle = this->m_iPortHandle;			
+			packet.m_pclCapture = m_pclCapture;
+			packet.m_kCaptureDirection = SerialCaptureDirections::RX;
 		}
 		else
 		{
 			packet.m_uDataSize = bytesRead;
+
+			if (m_pclCapture && bytesRead)
+				m_pclCapture->Record(SerialCaptureDirections::RX, packet.m_u8Data, bytesRead);
 		}		
 	}
 }
\ No newline at end of file
@@ -12,6 +12,7 @@
 #include <fmt/format.h>
 
 #include "Log.h"
+#include "SerialCapture.h"
 #include "Util.h"
 
 namespace dcclite
@@ -64,6 +65,9 @@ namespace dcclite
 		m_fWaiting = false;
 		m_uDataSize = numBytesTransferred;
 
+		if (m_pclCapture && m_uDataSize)
+			m_pclCapture->Record(m_kCaptureDirection, m_u8Data, m_uDataSize);
+
 		return true;
 	}
 
@@ -206,9 +210,14 @@ namespace dcclite
 			//we must wait
 			packet.m_fWaiting = true;
 			packet.m_hComPort = m_hComPort;
+			packet.m_pclCapture = m_pclCapture;
+			packet.m_kCaptureDirection = SerialCaptureDirections::TX;
 		}		
-
-		//if above if not entered, data went thought, nothing left to do
+		else if (m_pclCapture)
+		{
+			//data went thought
+			m_pclCapture->Record(SerialCaptureDirections::TX, packet.GetData(), bytesWritten);
+		}
 	}
 
 	void SerialPort::Read(DataPacket &packet)
@@ -233,11 +242,16 @@ namespace dcclite
 
 			packet.m_fWaiting = true;
 			packet.m_hComPort = m_hComPort;
+			packet.m_pclCapture = m_pclCapture;
+			packet.m_kCaptureDirection = SerialCaptureDirections::RX;
 		}
 		else
 		{
 			//some data was read
 			packet.m_uDataSize = dwBytesRead;
+
+			if (m_pclCapture && dwBytesRead)
+				m_pclCapture->Record(SerialCaptureDirections::RX, packet.m_u8Data, dwBytesRead);
 		}
 	}
 
@@ -18,6 +18,9 @@
 
 namespace dcclite
 {
+	class SerialCaptureWriter;
+	enum class SerialCaptureDirections: uint8_t;
+
 	constexpr auto DATA_PACKET_SIZE = 512;	
 
 	class SerialPort
@@ -67,6 +70,10 @@ namespace dcclite
 
 					bool m_fWaiting = false;
 
+					//set when waiting, so the completion is also captured
+					SerialCaptureWriter *m_pclCapture = nullptr;
+					SerialCaptureDirections m_kCaptureDirection;
+
 					friend class SerialPort;
 			};
 
@@ -77,10 +84,20 @@ namespace dcclite
 			void Read(DataPacket &packet);
 			void Write(DataPacket &packet);
 
+			/**
+			* Records all bytes read and written, capture must outlive the port (or be reset to null)
+			*/
+			inline void SetCapture(SerialCaptureWriter *capture) noexcept
+			{
+				m_pclCapture = capture;
+			}
+
 		private:
 			HANDLE m_hComPort;			
 
 			std::string m_strName;
+
+			SerialCaptureWriter *m_pclCapture = nullptr;
 	};		
 
 } //end of namespace dcclite
@@ -0,0 +1,116 @@
+// Copyright (C) 2019 - Bruno Sanches. See the COPYRIGHT
+// file at the top-level directory of this distribution.
+//
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+//
+// This Source Code Form is "Incompatible With Secondary Licenses", as
+// defined by the Mozilla Public License, v. 2.0.
+
+#include "SerialReplay.h"
+
+#include <fcntl.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+
+#include <fmt/format.h>
+
+namespace dcclite
+{
+	SerialReplay::SerialReplay(std::vector<SerialCaptureRecord> records, const double speed):
+		m_fpSpeed{ speed }
+	{
+		if (speed < 0)
+			throw std::invalid_argument(fmt::format("[SerialReplay] Invalid speed: {}", speed));
+
+		//only what the port received is played
+		for (auto &record : records)
+		{
+			if ((record.m_kDirection == SerialCaptureDirections::RX) && !record.m_vecData.empty())
+				m_vecRecords.push_back(std::move(record));
+		}
+
+		m_iMaster = posix_openpt(O_RDWR | O_NOCTTY);
+		if (m_iMaster < 0)
+			throw std::runtime_error(fmt::format("[SerialReplay] posix_openpt failed: {}", strerror(errno)));
+
+		if (grantpt(m_iMaster) || unlockpt(m_iMaster))
+		{
+			const auto error = errno;
+			close(m_iMaster);
+
+			throw std::runtime_error(fmt::format("[SerialReplay] Cannot unlock pty: {}", strerror(error)));
+		}
+
+		m_strPortName = ptsname(m_iMaster);
+
+		fcntl(m_iMaster, F_SETFL, O_NONBLOCK);
+	}
+
+	SerialReplay::~SerialReplay()
+	{
+		close(m_iMaster);
+	}
+
+	void SerialReplay::DrainInput()
+	{
+		uint8_t buffer[256];
+
+		for (;;)
+		{
+			auto n = read(m_iMaster, buffer, sizeof(buffer));
+			if (n <= 0)
+				break;
+
+			m_uNumBytesReceived += n;
+		}
+	}
+
+	bool SerialReplay::Update(const Clock::TimePoint_t now)
+	{
+		if (!m_fStarted)
+		{
+			m_tStart = now;
+			m_fStarted = true;
+		}
+
+		this->DrainInput();
+
+		const auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(now - m_tStart);
+
+		while (m_uNextRecord < m_vecRecords.size())
+		{
+			auto &record = m_vecRecords[m_uNextRecord];
+
+			if ((m_fpSpeed > 0) && (record.m_tTimestamp.count() > elapsed.count() * m_fpSpeed))
+				break;
+
+			const auto remaining = record.m_vecData.size() - m_uRecordOffset;
+
+			auto n = write(m_iMaster, record.m_vecData.data() + m_uRecordOffset, remaining);
+			if (n < 0)
+			{
+				if ((errno == EAGAIN) || (errno == EWOULDBLOCK))
+					break;
+
+				throw std::runtime_error(fmt::format("[SerialReplay::Update] write failed: {}", strerror(errno)));
+			}
+
+			m_uRecordOffset += n;
+
+			//pty is full, try again later
+			if (m_uRecordOffset < record.m_vecData.size())
+				break;
+
+			m_uRecordOffset = 0;
+			++m_uNextRecord;
+		}
+
+		return m_uNextRecord < m_vecRecords.size();
+	}
+}
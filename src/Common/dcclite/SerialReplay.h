@@ -0,0 +1,91 @@
+// Copyright (C) 2019 - Bruno Sanches. See the COPYRIGHT
+// file at the top-level directory of this distribution.
+//
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+//
+// This Source Code Form is "Incompatible With Secondary Licenses", as
+// defined by the Mozilla Public License, v. 2.0.
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "Clock.h"
+#include "SerialCapture.h"
+
+namespace dcclite
+{
+	/**
+
+		Plays the RX side of a capture on a pty, so a SerialPort opened on GetPortName() reads the same bytes the
+		real port did. Whatever is written to the port is read and dropped, so writers never block.
+
+		Linux only.
+
+	*/
+	class SerialReplay
+	{
+		public:
+			/**
+			* speed: 1 keeps the captured timing, 10 plays it ten times faster and 0 sends everything as fast as the pty takes it
+			*/
+			SerialReplay(std::vector<SerialCaptureRecord> records, const double speed);
+			~SerialReplay();
+
+			SerialReplay(const SerialReplay &) = delete;
+			SerialReplay &operator=(const SerialReplay &) = delete;
+
+			inline const std::string &GetPortName() const noexcept
+			{
+				return m_strPortName;
+			}
+
+			/**
+			* Writes all records that are due, the first call starts the clock
+			*
+			* Returns false when all records were written
+			*/
+			bool Update(const Clock::TimePoint_t now);
+
+			inline size_t GetNumRecords() const noexcept
+			{
+				return m_vecRecords.size();
+			}
+
+			inline size_t GetNumRecordsSent() const noexcept
+			{
+				return m_uNextRecord;
+			}
+
+			inline uint64_t GetNumBytesReceived() const noexcept
+			{
+				return m_uNumBytesReceived;
+			}
+
+		private:
+			void DrainInput();
+
+		private:
+			std::vector<SerialCaptureRecord> m_vecRecords;
+
+			std::string m_strPortName;
+
+			Clock::TimePoint_t m_tStart;
+
+			size_t m_uNextRecord = 0;
+
+			//bytes of the next record already written (pty was full)
+			size_t m_uRecordOffset = 0;
+
+			uint64_t m_uNumBytesReceived = 0;
+
+			double m_fpSpeed;
+
+			int m_iMaster = -1;
+
+			bool m_fStarted = false;
+	};
+}
@@ -472,7 +472,12 @@ namespace dcclite
 	{
 		assert(m_hHandle != NULL_SOCKET);
 
+#if PLATFORM == PLATFORM_UNIX
+		//a peer that went away must show up as DISCONNECTED, not as a SIGPIPE killing the broker
+		auto bytesSent = send(m_hHandle, reinterpret_cast<const char *>(data), (int)size, MSG_NOSIGNAL);
+#else
 		auto bytesSent = send(m_hHandle, reinterpret_cast<const char *>(data), (int)size, 0);
+#endif
 		
 #if PLATFORM == PLATFORM_MAC || PLATFORM == PLATFORM_UNIX
 		if (bytesSent < 0)
@@ -484,6 +489,7 @@ namespace dcclite
 					return std::make_tuple(Status::WOULD_BLOCK, 0);
 
 				case ECONNRESET:
+				case EPIPE:
 					return std::make_tuple(Status::DISCONNECTED, 0);
 
 				default:
@@ -630,6 +636,9 @@ namespace dcclite
 			switch (errno)
 			{
 				case ENOTCONN:
+				case ECONNRESET:
+				case ECONNREFUSED:
+				case ETIMEDOUT:
 					return std::make_pair(Status::DISCONNECTED, 0);
 
 				case EWOULDBLOCK:
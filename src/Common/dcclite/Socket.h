@@ -214,6 +214,14 @@ namespace dcclite
 
 			[[nodiscard]] std::optional<Port_t> GetPort() const;
 
+			/**
+			* Native handle, for registering the socket on readiness APIs (epoll, WSAPoll)
+			*/
+			inline Handler_t GetHandle() const noexcept
+			{
+				return m_hHandle;
+			}
+
 		private:
 			Handler_t m_hHandle;
 
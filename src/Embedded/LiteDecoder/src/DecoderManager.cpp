@@ -14,17 +14,43 @@
 #include "OutputDecoder.h"
 #include "QuadInverterDecoder.h"
 #include "SensorDecoder.h"
+#include "SensorSampler.h"
 #include "ServoTurnoutDecoder.h"
 #include "Session.h"
+#include "StaticPool.h"
 #include "Storage.h"
 #include "TurntableAutoInverterDecoder.h"
 
 #if (defined ARDUINO_AVR_MEGA2560) || (defined DCCLITE_ARDUINO_EMULATOR)
 #define MAX_DECODERS 48
+#define MAX_POOL_DECODERS 48
 #else
-constexpr auto MAX_DECODERS = 16;
+//A slot costs a pointer, a decoder costs a pool cell, so slots numbers go up to 32 but only 16 decoders fit at once
+constexpr auto MAX_DECODERS = 32;
+constexpr auto MAX_POOL_DECODERS = 16;
+
+//Keep at least 3/4 of the Uno RAM for the network stack and everything else
+#define DECODER_POOL_RAM_BUDGET 512
+#endif
+
+typedef StaticPool<
+	Decoder, 
+	MAX_POOL_DECODERS, 
+	OutputDecoder, 
+	SensorDecoder, 
+	ServoTurnoutDecoder, 
+	QuadInverterDecoder, 
+	TurntableAutoInverterDecoder
+> DecoderPool_t;
+
+static_assert(MAX_POOL_DECODERS <= MAX_DECODERS, "Pool bigger than the slots table");
+
+#ifdef DECODER_POOL_RAM_BUDGET
+static_assert(DecoderPool_t::STORAGE_SIZE <= DECODER_POOL_RAM_BUDGET, "Decoder pool does not fit the RAM budget, lower MAX_POOL_DECODERS");
 #endif
 
+static DecoderPool_t g_clDecoderPool;
+
 static Decoder *g_pDecoders[MAX_DECODERS] = { 0 };
 
 #define MODULE_NAME					F("DecoderMgr")
@@ -35,24 +61,26 @@ static Decoder *g_pDecoders[MAX_DECODERS] = { 0 };
 
 #define FSTR_INVALID_DECODER_TYPE	F("Invalid decoder type")
 
+#define FSTR_POOL_FULL				F("Decoder pool full")
+
 static Decoder *Create(const dcclite::DecoderTypes type, dcclite::Packet &packet)
 {
 	switch (type)
 	{
 		case dcclite::DecoderTypes::DEC_OUTPUT:
-			return new OutputDecoder(packet);
+			return g_clDecoderPool.New<OutputDecoder>(packet);
 
 		case dcclite::DecoderTypes::DEC_SENSOR:
-			return new SensorDecoder(packet);
+			return g_clDecoderPool.New<SensorDecoder>(packet);
 
 		case dcclite::DecoderTypes::DEC_SERVO_TURNOUT:
-			return new ServoTurnoutDecoder(packet);
+			return g_clDecoderPool.New<ServoTurnoutDecoder>(packet);
 
 		case dcclite::DecoderTypes::DEC_QUAD_INVERTER:
-			return new QuadInverterDecoder(packet);
+			return g_clDecoderPool.New<QuadInverterDecoder>(packet);
 
 		case dcclite::DecoderTypes::DEC_TURNTABLE_AUTO_INVERTER:
-			return new TurntableAutoInverterDecoder(packet);		
+			return g_clDecoderPool.New<TurntableAutoInverterDecoder>(packet);		
 
 		default:
 			//Console::SendLogEx(MODULE_NAME, FSTR_INVALID_DECODER_TYPE, static_cast<int>(type));
@@ -83,9 +111,18 @@ Decoder *DecoderManager::Create(const uint8_t slot, dcclite::Packet &packet)
 		return nullptr;
 	}		
 
+	if (g_clDecoderPool.IsFull())
+	{
+		Console::Printf(F("[%z] %z %d\n"), MODULE_NAME, FSTR_POOL_FULL, slot);
+
+		return nullptr;
+	}
+
 	auto decType = static_cast<dcclite::DecoderTypes>(packet.Read <uint8_t>());	
 
 	auto decoder = ::Create(decType, packet);
+	if (!decoder)
+		return nullptr;
 
 	g_pDecoders[slot] = decoder;
 
@@ -103,7 +140,7 @@ void DecoderManager::Destroy(const uint8_t slot)
 		return;
 	}
 
-	delete g_pDecoders[slot];
+	g_clDecoderPool.Delete(g_pDecoders[slot]);
 	g_pDecoders[slot] = nullptr;
 }
 
@@ -111,7 +148,7 @@ void DecoderManager::DestroyAll()
 {
 	for (int i = 0; i < MAX_DECODERS; ++i)
 	{
-		delete g_pDecoders[i];
+		g_clDecoderPool.Delete(g_pDecoders[i]);
 		g_pDecoders[i] = nullptr;
 	}
 }
@@ -210,6 +247,7 @@ void DecoderManager::LoadConfig(Storage::EpromStream &stream)
 	//Console::SendLogEx(MODULE_NAME, 'O', ' ', (int)sizeof(OutputDecoder), ' ', 'S', ' ', (int)sizeof(SensorDecoder), ' ', 'T', ' ', (int)sizeof(ServoTurnoutDecoder));
 	//DCCLITE_LOG << MODULE_NAME << F("O ") << (int)sizeof(OutputDecoder) << F(" S ") << (int)sizeof(SensorDecoder) << F(" T ") << (int)sizeof(ServoTurnoutDecoder) << DCCLITE_ENDL;
 	Console::Printf(F("[%z] O %d S %d T %d\n"), MODULE_NAME, (int)sizeof(OutputDecoder), (int)sizeof(SensorDecoder), (int)sizeof(ServoTurnoutDecoder));
+	Console::Printf(F("[%z] pool %d x %d\n"), MODULE_NAME, (int)DecoderPool_t::NUM_CELLS, (int)DecoderPool_t::CELL_SIZE);
 
 	uint16_t usedMem = 0;
 	for (;;)
@@ -243,7 +281,7 @@ void DecoderManager::LoadConfig(Storage::EpromStream &stream)
 			switch (type)
 			{
 				case dcclite::DecoderTypes::DEC_OUTPUT:
-					decoder = new OutputDecoder(stream);
+					decoder = g_clDecoderPool.New<OutputDecoder>(stream);
 
 					usedMem += sizeof(OutputDecoder);
 
@@ -253,7 +291,7 @@ void DecoderManager::LoadConfig(Storage::EpromStream &stream)
 					break;				
 
 				case dcclite::DecoderTypes::DEC_SENSOR:
-					decoder = new SensorDecoder(stream);
+					decoder = g_clDecoderPool.New<SensorDecoder>(stream);
 
 					usedMem += sizeof(SensorDecoder);
 
@@ -263,7 +301,7 @@ void DecoderManager::LoadConfig(Storage::EpromStream &stream)
 					break;
 
 				case dcclite::DecoderTypes::DEC_SERVO_TURNOUT:
-					decoder = new ServoTurnoutDecoder(stream);
+					decoder = g_clDecoderPool.New<ServoTurnoutDecoder>(stream);
 
 					usedMem += sizeof(ServoTurnoutDecoder);
 
@@ -273,7 +311,7 @@ void DecoderManager::LoadConfig(Storage::EpromStream &stream)
 					break;
 
 				case dcclite::DecoderTypes::DEC_TURNTABLE_AUTO_INVERTER:
-					decoder = new TurntableAutoInverterDecoder(stream);
+					decoder = g_clDecoderPool.New<TurntableAutoInverterDecoder>(stream);
 
 					usedMem += sizeof(TurntableAutoInverterDecoder);
 
@@ -283,7 +321,7 @@ void DecoderManager::LoadConfig(Storage::EpromStream &stream)
 					break;
 
 				case dcclite::DecoderTypes::DEC_QUAD_INVERTER:
-					decoder = new QuadInverterDecoder(stream);
+					decoder = g_clDecoderPool.New<QuadInverterDecoder>(stream);
 
 					usedMem += sizeof(QuadInverterDecoder);
 
@@ -296,6 +334,9 @@ void DecoderManager::LoadConfig(Storage::EpromStream &stream)
 					break;
 			}
 
+			if (!decoder)
+				Console::Printf(F("[%z] %z %d\n"), MODULE_NAME, FSTR_POOL_FULL, slot);
+
 			g_pDecoders[slot] = decoder;			
 		}
 	}
@@ -387,8 +428,25 @@ void DecoderManager::WriteStates(dcclite::StatesBitPack_t &changedStates, dcclit
 	}
 }
 
+void DecoderManager::WriteConfiguredSlots(dcclite::ConfigAcksBitPack_t &slots)
+{
+	slots.ClearAll();
+
+	for (unsigned i = 0; (i < MAX_DECODERS) && (i < slots.size()); ++i)
+	{
+		if (g_pDecoders[i])
+			slots.SetBit(i);
+	}
+}
+
 bool DecoderManager::Update(const unsigned long ticks)
 {
+	//read all sensors pins at once
+	SensorSampler::Update();
+
+	//flush state changes when idle
+	Storage::Update(ticks);
+
 	bool stateChanged = false;
 
 	for (size_t i = 0; i < MAX_DECODERS; ++i)
@@ -56,5 +56,7 @@ namespace DecoderManager
 	void WriteStates(dcclite::StatesBitPack_t &changedStates, dcclite::StatesBitPack_t &states);
 	void WriteOutputDecoderStates(dcclite::StatesBitPack_t &changedStates, dcclite::StatesBitPack_t &states);
 
+	void WriteConfiguredSlots(dcclite::ConfigAcksBitPack_t &slots);
+
 	bool Update(const unsigned long ticks);
 }
@@ -18,6 +18,14 @@
 #include "Console.h"
 #include "Storage.h"
 
+//all flashing outputs of a device use the same clock, so they flash together
+constexpr unsigned long FLASH_INTERVAL = 500;
+
+static inline bool IsFlashPhaseOn(const unsigned long ticks)
+{
+	return !((ticks / FLASH_INTERVAL) & 1);
+}
+
 OutputDecoder::OutputDecoder(dcclite::Packet &packet) :
 	Decoder::Decoder{ packet },
 	m_clPin{ packet.Read<dcclite::PinType_t>(), Pin::MODE_OUTPUT }
@@ -54,14 +62,28 @@ void OutputDecoder::SaveConfig(Storage::EpromStream &stream)
 	stream.Put(m_fFlags);
 }
 
+void OutputDecoder::WritePin(bool active)
+{
+	using namespace dcclite;
+
+	active = (m_fFlags & OUTD_INVERTED_OPERATION) ? !active : active;	
+
+	m_clPin.DigitalWrite(active ? Pin::VHIGH : Pin::VLOW);	
+}
+
 void OutputDecoder::OperatePin()
 {
 	using namespace dcclite;	
 
 	bool active = (m_fFlags & OUTD_ACTIVE);	
-	active = (m_fFlags & OUTD_INVERTED_OPERATION) ? !active : active;	
 
-	m_clPin.DigitalWrite(active ? Pin::VHIGH : Pin::VLOW);	
+	if (active && (m_fFlags & OUTD_FLASH))
+	{
+		m_fFlashOn = IsFlashPhaseOn(millis());
+		active = m_fFlashOn;
+	}
+
+	this->WritePin(active);
 
 	//Store current state on eprom, so we can reload.
 	if((m_uFlagsStorageIndex) && (!(m_fFlags & OUTD_IGNORE_SAVED_STATE)))
@@ -125,3 +147,21 @@ bool OutputDecoder::AcceptServerState(dcclite::DecoderStates state, const unsign
 
 	return true;
 }
+
+bool OutputDecoder::Update(const unsigned long ticks)
+{
+	using namespace dcclite;
+
+	if ((m_fFlags & (OUTD_FLASH | OUTD_ACTIVE)) != (OUTD_FLASH | OUTD_ACTIVE))
+		return false;
+
+	const bool lampOn = IsFlashPhaseOn(ticks);
+	if (lampOn == m_fFlashOn)
+		return false;
+
+	m_fFlashOn = lampOn;
+	this->WritePin(lampOn);
+
+	//state is still ACTIVE, nothing to tell the broker
+	return false;
+}
@@ -21,6 +21,9 @@ class OutputDecoder : public Decoder
 		Pin				m_clPin;
 		uint8_t			m_fFlags = 0;
 
+		//current lamp state when flashing, not saved
+		bool			m_fFlashOn = false;
+
 	public:
 		explicit OutputDecoder(dcclite::Packet &packet);
 		explicit OutputDecoder(Storage::EpromStream &stream);
@@ -39,6 +42,8 @@ class OutputDecoder : public Decoder
 
 		bool AcceptServerState(dcclite::DecoderStates state, const unsigned long time) override;
 
+		bool Update(const unsigned long ticks) override;
+
 		bool IsActive() const override
 		{
 			return m_fFlags & dcclite::OUTD_ACTIVE;
@@ -53,4 +58,6 @@ class OutputDecoder : public Decoder
 		void Init();
 
 		void OperatePin();
+
+		void WritePin(bool active);
 };
@@ -15,6 +15,7 @@
 #include <stdint.h>
 
 #include <dcclite_shared/Packet.h>
+#include <dcclite_shared/StatesCodec.h>
 
 #include "Blinker.h"
 #include "Console.h"
@@ -308,7 +309,16 @@ static void HandleConfigPacket(dcclite::Packet &packet)
 	//DCCLITE_LOG_MODULE_LN(OnConfiguringPacketStateNameStr << F(" Ack ") << seq);
 	Console::Printf(F("[%z] %z %z %d\n"), MODULE_NAME, OnConfiguringPacketStateNameStr, F("Ack"), seq);
 
-	SendConfigPacket(packet, dcclite::MsgTypes::CONFIG_ACK, seq);
+	//ack this config and also everything we already have, so server does not need to resend configs whose ack was lost
+	dcclite::ConfigAcksBitPack_t slots;
+	DecoderManager::WriteConfiguredSlots(slots);
+
+	packet.Reset();
+	dcclite::PacketBuilder builder{ packet, dcclite::MsgTypes::CONFIG_ACK, g_SessionToken, g_ConfigToken };
+
+	dcclite::ConfigAckSchema_t::Write(packet, seq, slots);
+
+	NetUdp::SendPacket(packet.GetData(), packet.GetSize(), g_u8ServerIp, g_uSrvPort);
 }
 
 void OnConfiguringPacket(dcclite::MsgTypes type, dcclite::Packet &packet)
@@ -575,8 +585,7 @@ static void OnlineTick(const unsigned long ticks, const bool stateChangeDetected
 		PacketBuilder builder{ pkt, MsgTypes::STATE, g_SessionToken, g_ConfigToken };
 
 		pkt.Write64(++g_uDecodersStateSequence);
-		pkt.Write(changedStates);
-		pkt.Write(states);			
+		dcclite::StatesCodec::Write(pkt, changedStates, states);
 
 		//finally, send it...
 		NetUdp::SendPacket(pkt.GetData(), pkt.GetSize(), g_u8ServerIp, g_uSrvPort);			
@@ -609,8 +618,12 @@ static void OnStatePacket(dcclite::Packet &packet, const unsigned long time)
 	StatesBitPack_t states;
 	StatesBitPack_t changedStates;
 
-	packet.ReadBitPack(changedStates);
-	packet.ReadBitPack(states);
+	if (!StatesCodec::Read(packet, changedStates, states))
+	{
+		Console::Printf(F("[%z] %z\n"), MODULE_NAME, F("invalid state packet"));
+
+		return;
+	}
 
 	/*
 	
@@ -636,8 +649,7 @@ static void OnSyncPacket(dcclite::Packet &packet)
 	dcclite::Packet pkt;
 	PacketBuilder builder{ pkt, MsgTypes::SYNC, g_SessionToken, g_ConfigToken };
 			
-	pkt.Write(changedStates);
-	pkt.Write(states);
+	StatesCodec::Write(pkt, changedStates, states);
 
 	NetUdp::SendPacket(pkt.GetData(), pkt.GetSize(), g_u8ServerIp, g_uSrvPort);
 }
@@ -977,7 +989,9 @@ static void ReceiveCallback(
 			//This is the place where we set the config token
 			g_ConfigToken = token;
 
-			Storage::SaveConfig();
+			//decoders still work, but config will be lost on the next boot
+			if (!Storage::SaveConfig())
+				Console::Printf(F("[%z] %z %z\n"), MODULE_NAME, FSTR_NOK, F("config not saved"));
 
 			GotoOnlineState(millis(), __LINE__);
 		}
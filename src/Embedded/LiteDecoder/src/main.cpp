@@ -20,6 +20,7 @@
 #include "Console.h"
 #include "DecoderManager.h"
 #include "NetUdp.h"
+#include "SensorSampler.h"
 #include "Session.h"
 #include "Storage.h"
 #include "Strings.h"
@@ -79,10 +80,10 @@ bool Console::Custom_ParseCommand(dcclite::StringView command)
 		//DCCLITE_LOG_MODULE_LN(FSTR_OK);
 		Console::Printf(F("[%z] %z\n"), MODULE_NAME, FSTR_OK);
 
-		Storage::SaveConfig();
+		const bool saved = Storage::SaveConfig();
 		
 		//DCCLITE_LOG_MODULE_LN(FSTR_OK);
-		Console::Printf(F("[%z] %z\n"), MODULE_NAME, FSTR_OK);
+		Console::Printf(F("[%z] %z\n"), MODULE_NAME, saved ? FSTR_OK : FSTR_NOK);
 
 		return true;
 	}
@@ -239,6 +240,11 @@ void setup()
 	{
 		Storage_LoadDecoders(g_uDecodersPosition);
 	}
+
+#ifdef DCCLITE_SENSOR_PCINT
+	//sensors ports are only read after a pin change interrupt
+	SensorSampler::EnableInterrupts();
+#endif
 		
 	//DCCLITE_LOG_MODULE_LN(FSTR_SETUP << ' ' << FSTR_OK);
 	Console::Printf(F("[%z] %z %z\n"), MODULE_NAME, FSTR_SETUP, FSTR_OK);
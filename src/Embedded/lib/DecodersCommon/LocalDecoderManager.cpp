@@ -13,7 +13,9 @@
 #include "Console.h"
 #include "Storage.h"
 #include "SensorDecoder.h"
+#include "SensorSampler.h"
 #include "ServoTurnoutDecoder.h"
+#include "StaticPool.h"
 
 class Decoder;
 
@@ -30,6 +32,8 @@ constexpr auto MAX_BUTTONS = 32;
 
 #define FSTR_NO_BUTTONS F("Out of buttons")
 
+static StaticPool<Decoder, MAX_DECODERS, SensorDecoder, ServoTurnoutDecoder> g_clDecoderPool;
+
 static Decoder *g_pDecoders[MAX_DECODERS] = { 0 };
 
 static uint8_t g_iNextSlot = 0;
@@ -118,6 +122,8 @@ void Button::Update(const unsigned long ticks)
 	}
 }
 
+static StaticPool<Button, MAX_BUTTONS, Button> g_clButtonPool;
+
 static Button *g_pButtons[MAX_BUTTONS] = { 0 };
 
 static uint8_t g_iNextButton = 0;
@@ -146,7 +152,9 @@ ServoTurnoutDecoder *LocalDecoderManager::CreateServoTurnout(
 		return nullptr;
 	}
 
-	auto *turnout = g_pLoadStream ? new ServoTurnoutDecoder(*g_pLoadStream) : new ServoTurnoutDecoder(flags, pin, range, ticks, powerPin, frogPin);
+	auto *turnout = g_pLoadStream ? 
+		g_clDecoderPool.New<ServoTurnoutDecoder>(*g_pLoadStream) : 
+		g_clDecoderPool.New<ServoTurnoutDecoder>(flags, pin, range, ticks, powerPin, frogPin);
 
 	g_pDecoders[g_iNextSlot++] = turnout;	
 
@@ -170,7 +178,9 @@ SensorDecoder *LocalDecoderManager::CreateSensor(
 		return nullptr;
 	}
 
-	auto *sensor = g_pLoadStream ? new SensorDecoder(*g_pLoadStream) : new SensorDecoder(flags, pin, activateDelay, deactivateDelay);
+	auto *sensor = g_pLoadStream ? 
+		g_clDecoderPool.New<SensorDecoder>(*g_pLoadStream) : 
+		g_clDecoderPool.New<SensorDecoder>(flags, pin, activateDelay, deactivateDelay);
 
 	g_pDecoders[g_iNextSlot++] = sensor;
 
@@ -192,7 +202,7 @@ void LocalDecoderManager::CreateButton(SensorDecoder &sensor, ServoTurnoutDecode
 	//DCCLITE_LOG_MODULE_LN(F("Added button ") << g_iNextButton);
 	Console::Printf(F("[%z] %z %d\n"), MODULE_NAME, F("Added button"), g_iNextButton);
 
-	g_pButtons[g_iNextButton++] = new Button(sensor, target, actions);
+	g_pButtons[g_iNextButton++] = g_clButtonPool.New<Button>(sensor, target, actions);
 }
 
 Decoder *LocalDecoderManager::TryGetDecoder(const uint8_t slot)
@@ -204,6 +214,12 @@ Decoder *LocalDecoderManager::TryGetDecoder(const uint8_t slot)
 
 bool LocalDecoderManager::Update(const unsigned long ticks)
 {
+	//read all sensors pins at once
+	SensorSampler::Update();
+
+	//flush state changes when idle
+	Storage::Update(ticks);
+
 	bool stateChanged = false;
 
 	for (size_t i = 0; i < g_iNextSlot; ++i)
@@ -253,6 +269,9 @@ void LocalDecoderManager::Init(const char *time, const char *date)
 		//Console::SendLogEx(MODULE_NAME, "Found valid eprom data");		
 		//DCCLITE_LOG_MODULE_LN(F("Found valid eprom data"));
 		Console::Printf(F("[%z] %z\n"), MODULE_NAME, F("Found valid eprom data"));
+
+		//config is valid, so bring back the fields changed after it was saved
+		Storage::LoadStateLog();
 	}
 	else
 	{
@@ -291,6 +310,9 @@ void LocalDecoderManager::PostInit()
 	Header header;	
 	InitHeader(header);	
 
+	//new config has the current state of everything
+	Storage::ResetStateLog();
+
 	Storage::EpromStream stream{ 0 };
 
 	stream.PutRawData(reinterpret_cast<uint8_t *>(header.m_u8Buffer), sizeof(header));
@@ -69,6 +69,11 @@ SensorDecoder::SensorDecoder(Storage::EpromStream &stream) noexcept:
 }
 
 
+SensorDecoder::~SensorDecoder() noexcept
+{
+	SensorSampler::Unregister(m_clPin.Raw());
+}
+
 void SensorDecoder::SaveConfig(Storage::EpromStream& stream) noexcept
 {
 	Decoder::SaveConfig(stream);
@@ -85,6 +90,7 @@ void SensorDecoder::Init(const dcclite::PinType_t pin) noexcept
 	using namespace dcclite;	
 
 	m_clPin.Attach(pin, (m_fFlags & SNRD_PULL_UP) ? Pin::MODE_INPUT_PULLUP : Pin::MODE_INPUT);
+	m_stSample = SensorSampler::Register(pin);
 
 	if (m_uStartDelay)
 	{
@@ -117,6 +123,10 @@ bool SensorDecoder::AcceptServerState(dcclite::DecoderStates state, const unsign
 
 bool SensorDecoder::Update(const unsigned long ticks) noexcept
 {
+	//pin did not change since we last looked and there is nothing pending
+	if ((m_fFlags & dcclite::SNRD_SETTLED) && m_stSample.m_u8Mask && !SensorSampler::HasChanged(m_stSample))
+		return false;
+
 	const bool coolDown = m_fFlags & dcclite::SNRD_COOLDOWN;	
 	const bool delay = m_fFlags & dcclite::SNRD_DELAY;
 
@@ -132,17 +142,21 @@ bool SensorDecoder::Update(const unsigned long ticks) noexcept
 	//disable cooldown and delay anyway
 	m_fFlags &= ~(dcclite::SNRD_COOLDOWN | dcclite::SNRD_DELAY);
 
-	bool state = m_clPin.DigitalRead() == Pin::VHIGH;		
+	bool state = m_stSample.m_u8Mask ? SensorSampler::Read(m_stSample) : (m_clPin.DigitalRead() == Pin::VHIGH);
 	state = (m_fFlags & dcclite::SNRD_INVERTED) ? !state : state;
 
 	bool previousState = m_fFlags & dcclite::SNRD_ACTIVE;
 
 	//no state change?
 	if (state == previousState)
-	{		
+	{
+		m_fFlags |= dcclite::SNRD_SETTLED;
+
 		return false;
 	}
 
+	m_fFlags &= ~dcclite::SNRD_SETTLED;
+
 #ifdef DCCLITE_DBG
 	Console::SendLogEx("[SENSOR_DECODER]", "noise");
 #endif
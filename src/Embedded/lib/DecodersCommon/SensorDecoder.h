@@ -12,6 +12,7 @@
 
 #include "Decoder.h"
 #include "Pin.h"
+#include "SensorSampler.h"
 
 #define CFG_COOLDOWN_TIMEOUT_TICKS 25
 
@@ -27,11 +28,15 @@ class SensorDecoder : public Decoder
 		Pin				m_clPin;
 		uint8_t			m_fFlags = 0;
 
+		SensorSampler::PinHandle m_stSample = { 0, 0 };
+
 	public:
 		explicit SensorDecoder(uint8_t flags, dcclite::PinType_t pin, uint16_t activateDelay = 0, uint16_t deactivateDelay = 0, uint16_t startDelay = 0) noexcept;
 		explicit SensorDecoder(dcclite::Packet &packet) noexcept;
 		explicit SensorDecoder(Storage::EpromStream &stream) noexcept;
 
+		~SensorDecoder() noexcept override;
+
 		bool Update(const unsigned long ticks) noexcept override;
 
 		void SaveConfig(Storage::EpromStream& stream) noexcept override;
@@ -0,0 +1,210 @@
+// Copyright (C) 2019 - Bruno Sanches. See the COPYRIGHT
+// file at the top-level directory of this distribution.
+//
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+//
+// This Source Code Form is "Incompatible With Secondary Licenses", as
+// defined by the Mozilla Public License, v. 2.0.
+
+#include "SensorSampler.h"
+
+#include <string.h>
+
+#include <Arduino.h>
+
+//
+//On the board, pin change vectors are only compiled when asked for (DCCLITE_SENSOR_PCINT), so we do not fight other libraries for them
+//
+#if defined(BCS_ARDUINO_EMULATOR) || defined(DCCLITE_SENSOR_PCINT)
+#define SENSOR_SAMPLER_INTERRUPTS
+#endif
+
+namespace SensorSampler
+{
+	namespace detail
+	{
+		//index 0 is NOT_A_PORT, always zero
+		uint8_t g_u8Samples[MAX_PORTS] = { 0 };
+		uint8_t g_u8Changes[MAX_PORTS] = { 0 };
+	}
+
+	static uint8_t g_u8PortMasks[MAX_PORTS] = { 0 };
+	static volatile uint8_t *g_pPortRegisters[MAX_PORTS] = { 0 };
+
+	//registered pins that cannot wake us up using an interrupt
+	static uint8_t g_u8PollingPins = 0;
+
+	static bool g_fInterruptsEnabled = false;
+	static volatile bool g_fPinChanged = true;
+
+	static unsigned long g_uNumSamples = 0;
+
+#ifdef SENSOR_SAMPLER_INTERRUPTS
+	//PCICR bits of the registered pins
+	static uint8_t g_u8PinChangeGroups = 0;
+
+	static void OnPinChange()
+	{
+		g_fPinChanged = true;
+	}
+#endif
+
+	PinHandle Register(const dcclite::PinType_t pin)
+	{
+		PinHandle handle = { NOT_A_PORT, 0 };
+
+		const uint8_t port = digitalPinToPort(pin);
+		if ((port == NOT_A_PORT) || (port >= MAX_PORTS))
+			return handle;
+
+		handle.m_u8Port = port;
+		handle.m_u8Mask = digitalPinToBitMask(pin);
+
+		g_u8PortMasks[port] |= handle.m_u8Mask;
+		g_pPortRegisters[port] = portInputRegister(port);
+
+		//first sample, so the sensor does not see a change from nothing
+		detail::g_u8Samples[port] = (detail::g_u8Samples[port] & ~handle.m_u8Mask) | (*g_pPortRegisters[port] & handle.m_u8Mask);
+
+#ifdef SENSOR_SAMPLER_INTERRUPTS
+		if (digitalPinToPCICR(pin))
+		{
+			*digitalPinToPCMSK(pin) |= (1 << digitalPinToPCMSKbit(pin));
+
+			g_u8PinChangeGroups |= (1 << digitalPinToPCICRbit(pin));
+
+			if (g_fInterruptsEnabled)
+				*digitalPinToPCICR(pin) |= (1 << digitalPinToPCICRbit(pin));
+		}
+		else
+#endif
+		{
+			++g_u8PollingPins;
+		}
+
+		//force a read on next update
+		g_fPinChanged = true;
+
+		return handle;
+	}
+
+	void Unregister(const dcclite::PinType_t pin)
+	{
+		const uint8_t port = digitalPinToPort(pin);
+		if ((port == NOT_A_PORT) || (port >= MAX_PORTS))
+			return;
+
+		const uint8_t mask = digitalPinToBitMask(pin);
+		if (!(g_u8PortMasks[port] & mask))
+			return;
+
+		g_u8PortMasks[port] &= ~mask;
+		detail::g_u8Samples[port] &= ~mask;
+		detail::g_u8Changes[port] &= ~mask;
+
+#ifdef SENSOR_SAMPLER_INTERRUPTS
+		if (digitalPinToPCICR(pin))
+		{
+			//group is left enabled, with the pin masked it will not fire for this pin
+			*digitalPinToPCMSK(pin) &= ~(1 << digitalPinToPCMSKbit(pin));
+		}
+		else
+#endif
+		{
+			--g_u8PollingPins;
+		}
+	}
+
+	void EnableInterrupts()
+	{
+#ifdef SENSOR_SAMPLER_INTERRUPTS
+#ifdef BCS_ARDUINO_EMULATOR
+		for (uint8_t group = 0; group < 3; ++group)
+			attachPinChangeVector(group, OnPinChange);
+#endif
+
+		PCICR |= g_u8PinChangeGroups;
+
+		g_fInterruptsEnabled = true;
+		g_fPinChanged = true;
+#endif
+	}
+
+	void DisableInterrupts()
+	{
+#ifdef SENSOR_SAMPLER_INTERRUPTS
+		PCICR &= ~g_u8PinChangeGroups;
+
+		g_fInterruptsEnabled = false;
+#endif
+	}
+
+	bool IsPolling()
+	{
+		return !g_fInterruptsEnabled || g_u8PollingPins;
+	}
+
+	unsigned long GetNumSamples()
+	{
+		return g_uNumSamples;
+	}
+
+	void Update()
+	{
+		if (!IsPolling())
+		{
+			noInterrupts();
+			const bool pinChanged = g_fPinChanged;
+			g_fPinChanged = false;
+			interrupts();
+
+			//nothing happened, ports are the same as the last sample
+			if (!pinChanged)
+			{
+				memset(detail::g_u8Changes, 0, sizeof(detail::g_u8Changes));
+
+				return;
+			}
+		}
+
+		++g_uNumSamples;
+
+		for (uint8_t port = 1; port < MAX_PORTS; ++port)
+		{
+			const uint8_t mask = g_u8PortMasks[port];
+			if (!mask)
+				continue;
+
+			//a single register read for all the sensors on this port
+			const uint8_t sample = *g_pPortRegisters[port] & mask;
+
+			detail::g_u8Changes[port] = sample ^ detail::g_u8Samples[port];
+			detail::g_u8Samples[port] = sample;
+		}
+	}
+}
+
+#if defined(SENSOR_SAMPLER_INTERRUPTS) && !defined(BCS_ARDUINO_EMULATOR)
+
+ISR(PCINT0_vect)
+{
+	SensorSampler::OnPinChange();
+}
+
+#ifdef PCINT1_vect
+ISR(PCINT1_vect)
+{
+	SensorSampler::OnPinChange();
+}
+#endif
+
+#ifdef PCINT2_vect
+ISR(PCINT2_vect)
+{
+	SensorSampler::OnPinChange();
+}
+#endif
+
+#endif
@@ -0,0 +1,80 @@
+// Copyright (C) 2019 - Bruno Sanches. See the COPYRIGHT
+// file at the top-level directory of this distribution.
+//
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+//
+// This Source Code Form is "Incompatible With Secondary Licenses", as
+// defined by the Mozilla Public License, v. 2.0.
+
+#pragma once
+
+#include <stdint.h>
+
+#include <dcclite_shared/BasicPin.h>
+
+/**
+
+	Samples all sensor pins once per loop, reading each port input register a single time instead of a digitalRead per sensor.
+
+	Changes are computed for all pins of a port at once (previous sample XOR current sample), so sensors can skip their update
+	when their pin did not change.
+
+	When pin change interrupts are enabled and all registered pins support them, idle loops do not read the ports at all, pins
+	without pin change support make the sampler go back to reading every loop.
+
+*/
+namespace SensorSampler
+{
+	constexpr uint8_t MAX_PORTS = 13;
+
+	struct PinHandle
+	{
+		uint8_t m_u8Port;
+		uint8_t m_u8Mask;
+	};
+
+	namespace detail
+	{
+		extern uint8_t g_u8Samples[MAX_PORTS];
+		extern uint8_t g_u8Changes[MAX_PORTS];
+	}
+
+	/**
+		Starts sampling the pin, the pin mode must already be set. If the pin does not map to a port, m_u8Mask will be zero
+	*/
+	PinHandle Register(const dcclite::PinType_t pin);
+	void Unregister(const dcclite::PinType_t pin);
+
+	/**
+		Must be called once per loop, before updating the sensors
+	*/
+	void Update();
+
+	inline bool Read(const PinHandle handle)
+	{
+		return detail::g_u8Samples[handle.m_u8Port] & handle.m_u8Mask;
+	}
+
+	/**
+		True if the pin changed on the last Update
+	*/
+	inline bool HasChanged(const PinHandle handle)
+	{
+		return detail::g_u8Changes[handle.m_u8Port] & handle.m_u8Mask;
+	}
+
+	void EnableInterrupts();
+	void DisableInterrupts();
+
+	/**
+		True when the ports are read on every Update (no interrupts or some pin without pin change support)
+	*/
+	bool IsPolling();
+
+	/**
+		How many times the ports were read, for stats and tests
+	*/
+	unsigned long GetNumSamples();
+}
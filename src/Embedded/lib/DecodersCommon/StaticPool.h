@@ -0,0 +1,170 @@
+// Copyright (C) 2019 - Bruno Sanches. See the COPYRIGHT
+// file at the top-level directory of this distribution.
+//
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+//
+// This Source Code Form is "Incompatible With Secondary Licenses", as
+// defined by the Mozilla Public License, v. 2.0.
+
+#pragma once
+
+#include <assert.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __AVR__
+#include <new.h>
+#else
+#include <new>
+#endif
+
+namespace detail
+{
+	template <typename... TYPES>
+	struct PoolCellTraits;
+
+	template <typename T>
+	struct PoolCellTraits<T>
+	{
+		static constexpr size_t SIZE = sizeof(T);
+		static constexpr size_t ALIGN = alignof(T);
+	};
+
+	template <typename HEAD, typename... TAIL>
+	struct PoolCellTraits<HEAD, TAIL...>
+	{
+		static constexpr size_t SIZE = sizeof(HEAD) > PoolCellTraits<TAIL...>::SIZE ? sizeof(HEAD) : PoolCellTraits<TAIL...>::SIZE;
+		static constexpr size_t ALIGN = alignof(HEAD) > PoolCellTraits<TAIL...>::ALIGN ? alignof(HEAD) : PoolCellTraits<TAIL...>::ALIGN;
+	};
+
+	template <typename T, typename... TYPES>
+	struct IsPoolType
+	{
+		static constexpr bool VALUE = false;
+	};
+
+	template <typename T, typename... TAIL>
+	struct IsPoolType<T, T, TAIL...>
+	{
+		static constexpr bool VALUE = true;
+	};
+
+	template <typename T, typename HEAD, typename... TAIL>
+	struct IsPoolType<T, HEAD, TAIL...>
+	{
+		static constexpr bool VALUE = IsPoolType<T, TAIL...>::VALUE;
+	};
+}
+
+/**
+
+	Fixed number of cells, each one big enough for the largest of TYPES, so objects are built in place instead of on the heap.
+
+	All the memory is reserved at link time (shows up on .bss), so the real RAM cost is known when building and the heap does not
+	get fragmented by config changes.
+
+	Cells are not tied to decoder slots: an object lives on its cell until Delete, even if it leaves the slot table for a while
+	(like the ServoProgrammer does).
+
+	Keep it C++11 and STL free, this is compiled for AVR.
+
+*/
+template <typename BASE, uint8_t CAPACITY, typename... TYPES>
+class StaticPool
+{
+	public:
+		static constexpr size_t CELL_SIZE = detail::PoolCellTraits<TYPES...>::SIZE;
+		static constexpr size_t CELL_ALIGN = detail::PoolCellTraits<TYPES...>::ALIGN;
+
+	private:
+		struct Cell
+		{
+			alignas(CELL_ALIGN) uint8_t m_u8Data[CELL_SIZE];
+		};
+
+	public:
+		static constexpr uint8_t NUM_CELLS = CAPACITY;
+		static constexpr size_t STORAGE_SIZE = sizeof(Cell) * CAPACITY;
+
+		static_assert(CAPACITY > 0, "Empty pool");
+
+		/**
+			Returns nullptr if there are no free cells
+		*/
+		template <typename T, typename... ARGS>
+		T *New(ARGS &&... args)
+		{
+			static_assert(detail::IsPoolType<T, TYPES...>::VALUE, "Type not declared on the pool, cell may be too small");
+
+			const int index = this->FindFreeCell();
+			if (index < 0)
+				return nullptr;
+
+			this->SetUsed(index, true);
+
+			return new (m_arCells[index].m_u8Data) T(args...);
+		}
+
+		void Delete(BASE *object)
+		{
+			if (object == nullptr)
+				return;
+
+			//base may be at an offset inside the cell, so divide down to the cell
+			const size_t index = (reinterpret_cast<uint8_t *>(object) - m_arCells[0].m_u8Data) / sizeof(Cell);
+
+			assert(index < CAPACITY);
+			assert(this->IsUsed(index));
+
+			object->~BASE();
+
+			this->SetUsed(index, false);
+		}
+
+		bool IsFull() const
+		{
+			return this->FindFreeCell() < 0;
+		}
+
+		uint8_t GetNumUsed() const
+		{
+			uint8_t count = 0;
+
+			for (uint8_t i = 0; i < CAPACITY; ++i)
+				count += this->IsUsed(i);
+
+			return count;
+		}
+
+	private:
+		int FindFreeCell() const
+		{
+			for (uint8_t i = 0; i < CAPACITY; ++i)
+			{
+				if (!this->IsUsed(i))
+					return i;
+			}
+
+			return -1;
+		}
+
+		inline bool IsUsed(const uint8_t index) const
+		{
+			return m_u8UsedCells[index / 8] & (1 << (index % 8));
+		}
+
+		inline void SetUsed(const uint8_t index, const bool used)
+		{
+			if (used)
+				m_u8UsedCells[index / 8] |= (1 << (index % 8));
+			else
+				m_u8UsedCells[index / 8] &= ~(1 << (index % 8));
+		}
+
+	private:
+		Cell m_arCells[CAPACITY];
+
+		uint8_t m_u8UsedCells[(CAPACITY + 7) / 8] = { 0 };
+};
@@ -19,11 +19,36 @@
 #include "Storage.h"
 #include "Strings.h"
 
-#define STORAGE_MAGIC F("Bcs0008")
+#ifdef BCS_ARDUINO_EMULATOR
+#define EEPROM_IS_READY() true
+#else
+#include <avr/eeprom.h>
+#define EEPROM_IS_READY() eeprom_is_ready()
+#endif
+
+#define STORAGE_MAGIC F("Bcs0009")
 #define END_STORAGE_ID F("ENDEND1")
 
 #define MODULE_NAME F("Storage")
 
+//state log, see "State log" below
+#define STATE_LOG_RECORDS		32
+#define STATE_LOG_RECORD_SIZE	6
+#define STATE_LOG_SIZE			(1 + (STATE_LOG_RECORDS * STATE_LOG_RECORD_SIZE))
+
+//write back of the overwritten record, crc invalidate, data bytes and the crc
+#define STATE_LOG_RECORD_STEPS	(STATE_LOG_RECORD_SIZE + 2)
+
+#define FIELD_CACHE_SIZE		8
+
+#ifdef E2END
+//smallest boards have 1KB of EEPROM, keep most of it for the config
+static_assert(STATE_LOG_SIZE <= (E2END + 1) / 4, "state log takes too much of the EEPROM");
+#endif
+
+//how long fields must be quiet before being flushed
+#define FIELD_FLUSH_IDLE_TIME	500
+
 //#define MODULE_NAME "Storage"
 
 void Storage::Dump()
@@ -61,6 +86,8 @@ void Storage::DumpHex()
 
 void Storage::Clear()
 {
+	Storage::ResetStateLog();
+
 	EpromStream stream(0);
 
 	//just invalidate the header...
@@ -101,6 +128,9 @@ bool Storage::LoadConfig()
     }
     else
     {
+		//config is valid, so bring back the fields changed after it was saved
+		Storage::LoadStateLog();
+
 		Lump lump;				
 
 		for (;;)
@@ -135,8 +165,13 @@ bool Storage::LoadConfig()
     return true;
 }
 
-void Storage::SaveConfig()
+static void RestartStateLog();
+
+bool Storage::SaveConfig()
 {   	
+	//new config has the current state of everything
+	Storage::ResetStateLog();
+
 	//clear eprom first bytes, so we make sure only after writing everyting, we put a magic number
 	{
 		EpromStream stream(0);
@@ -146,22 +181,382 @@ void Storage::SaveConfig()
 
 	EpromStream stream(0);
 
-	LumpWriter lump(stream, STORAGE_MAGIC);
-	
-	Storage::Custom_SaveModules(stream);
-		
+	//scoped, so the magic number is written before checking the size
 	{
-		LumpWriter endLump(stream, END_STORAGE_ID);
+		LumpWriter lump(stream, STORAGE_MAGIC);
+
+		Storage::Custom_SaveModules(stream);
+
+		{
+			LumpWriter endLump(stream, END_STORAGE_ID);
+		}
+	}
+
+	if (stream.GetIndex() > EEPROM.length() - STATE_LOG_SIZE)
+	{
+		//config ran over the state log, so neither can be trusted: drop the config and start a new log generation
+		{
+			EpromStream invalidateStream(0);
+
+			LumpWriter endLump(invalidateStream, END_STORAGE_ID);
+		}
+
+		RestartStateLog();
+
+		Console::Printf(F("[%z] %z %z\n"), MODULE_NAME, FSTR_NOK, F("config overlaps state log"));
+
+		return false;
 	}
 
     //Console::SendLogEx(MODULE_NAME, "sv", ' ', FSTR_OK);
 	//DCCLITE_LOG_MODULE_LN(F("sv") << ' ' << FSTR_OK);
 	Console::Printf(F("[%z] %z %z\n"), MODULE_NAME, F("sv"), FSTR_OK);
+
+	return true;
+}
+
+//
+//
+// State log
+//
+//
+
+/*
+
+Decoders state fields (flags) change all the time, a turnout saves its position every time it stops, writing those straight to
+the config would burn the same cells over and over.
+
+So changes are kept on a small RAM cache and, when they stop changing, appended to a ring of records at the end of the EEPROM:
+
+	[generation][record 0][record 1]...[record N - 1]
+
+	record: [crc][seq lo][seq hi][index lo][index hi][value]
+
+The record position is always seq % N and crc covers generation and record data. A record is written invalidating its crc first
+and writing the real crc last, so a record torn by a power loss is ignored on boot.
+
+When the ring wraps, the record being overwritten may be the only copy of a field that did not change since, so if no newer
+record has that field its value is written back to the config before the record is reused.
+
+On boot the valid records are replayed, oldest to newest, over the config. Saving a new config bumps generation, so old records
+stop being valid.
+
+*/
+
+static_assert((65536UL % STATE_LOG_RECORDS) == 0, "seq wrap must keep record positions");
+
+struct DirtyField
+{
+	uint16_t	m_uIndex;
+	uint8_t		m_u8Value;
+};
+
+static DirtyField g_arDirtyFields[FIELD_CACHE_SIZE];
+static uint8_t g_u8NumDirtyFields = 0;
+
+static unsigned long g_uLastFieldChange = 0;
+
+static uint8_t g_u8Generation = 0;
+static uint16_t g_uNextSeq = 0;
+
+//record being written, byte by byte, step past the record steps means idle
+static uint8_t g_arPendingRecord[STATE_LOG_RECORD_SIZE];
+static uint8_t g_u8PendingStep = STATE_LOG_RECORD_STEPS;
+static unsigned int g_uPendingAddress = 0;
+
+//live field on the record being overwritten
+static bool g_fPendingWriteBack = false;
+static unsigned int g_uWriteBackIndex = 0;
+static uint8_t g_u8WriteBackValue = 0;
+
+static inline unsigned int GetStateLogStart()
+{
+	return EEPROM.length() - STATE_LOG_SIZE;
+}
+
+static inline unsigned int GetRecordAddress(const uint16_t position)
+{
+	return GetStateLogStart() + 1 + (position * STATE_LOG_RECORD_SIZE);
+}
+
+//Dallas / Maxim CRC8, same as avr-libc _crc_ibutton_update
+static uint8_t Crc8Update(uint8_t crc, const uint8_t data)
+{
+	crc ^= data;
+
+	for (uint8_t i = 0; i < 8; ++i)
+		crc = (crc & 1) ? (crc >> 1) ^ 0x8C : (crc >> 1);
+
+	return crc;
+}
+
+static uint8_t ComputeRecordCrc(const uint8_t *record)
+{
+	uint8_t crc = Crc8Update(0, g_u8Generation);
+
+	for (uint8_t i = 1; i < STATE_LOG_RECORD_SIZE; ++i)
+		crc = Crc8Update(crc, record[i]);
+
+	return crc;
+}
+
+static bool TryReadRecord(const uint16_t position, uint8_t *record, uint16_t &seq)
+{
+	const unsigned int address = GetRecordAddress(position);
+
+	for (uint8_t i = 0; i < STATE_LOG_RECORD_SIZE; ++i)
+		record[i] = EEPROM.read(address + i);
+
+	if (record[0] != ComputeRecordCrc(record))
+		return false;
+
+	seq = record[1] | (record[2] << 8);
+
+	return (seq % STATE_LOG_RECORDS) == position;
+}
+
+static inline bool IsWritingRecord()
+{
+	return g_u8PendingStep < STATE_LOG_RECORD_STEPS;
+}
+
+static inline unsigned int GetRecordIndex(const uint8_t *record)
+{
+	return record[3] | (record[4] << 8);
+}
+
+//checks if the record at position holds a field that is not on any newer record, so it must go to the config before being overwritten
+static void PrepareWriteBack(const uint16_t position, const unsigned int newIndex)
+{
+	g_fPendingWriteBack = false;
+
+	uint8_t record[STATE_LOG_RECORD_SIZE];
+
+	uint16_t seq;
+	if (!TryReadRecord(position, record, seq))
+		return;
+
+	//only the previous lap is live
+	if (static_cast<uint16_t>(g_uNextSeq - seq) != STATE_LOG_RECORDS)
+		return;
+
+	const unsigned int index = GetRecordIndex(record);
+	if ((index == newIndex) || (index >= GetStateLogStart()))
+		return;
+
+	for (uint16_t i = 1; i < STATE_LOG_RECORDS; ++i)
+	{
+		uint8_t newer[STATE_LOG_RECORD_SIZE];
+
+		uint16_t newerSeq;
+		if (!TryReadRecord((position + i) % STATE_LOG_RECORDS, newer, newerSeq))
+			continue;
+
+		if ((static_cast<uint16_t>(newerSeq - seq) < STATE_LOG_RECORDS) && (GetRecordIndex(newer) == index))
+			return;
+	}
+
+	g_uWriteBackIndex = index;
+	g_u8WriteBackValue = record[5];
+	g_fPendingWriteBack = true;
+}
+
+static void BeginRecord()
+{
+	const DirtyField field = g_arDirtyFields[0];
+
+	--g_u8NumDirtyFields;
+	memmove(g_arDirtyFields, g_arDirtyFields + 1, g_u8NumDirtyFields * sizeof(DirtyField));
+
+	g_arPendingRecord[1] = g_uNextSeq & 0xFF;
+	g_arPendingRecord[2] = g_uNextSeq >> 8;
+	g_arPendingRecord[3] = field.m_uIndex & 0xFF;
+	g_arPendingRecord[4] = field.m_uIndex >> 8;
+	g_arPendingRecord[5] = field.m_u8Value;
+	g_arPendingRecord[0] = ComputeRecordCrc(g_arPendingRecord);
+
+	const uint16_t position = g_uNextSeq % STATE_LOG_RECORDS;
+
+	PrepareWriteBack(position, field.m_uIndex);
+
+	g_uPendingAddress = GetRecordAddress(position);
+	g_u8PendingStep = 0;
+
+	++g_uNextSeq;
+}
+
+//a single EEPROM write per call
+static void WriteRecordStep()
+{
+	uint8_t step = g_u8PendingStep++;
+
+	if (step == 0)
+	{
+		//old record is still valid until invalidated below, so a power loss here loses nothing
+		if (g_fPendingWriteBack)
+		{
+			EEPROM.update(g_uWriteBackIndex, g_u8WriteBackValue);
+
+			return;
+		}
+
+		step = g_u8PendingStep++;
+	}
+
+	if (step == 1)
+	{
+		//invalidate first, so a torn record is never taken as valid
+		EEPROM.update(g_uPendingAddress, static_cast<uint8_t>(~g_arPendingRecord[0]));
+	}
+	else if (step <= STATE_LOG_RECORD_SIZE)
+	{
+		EEPROM.update(g_uPendingAddress + step - 1, g_arPendingRecord[step - 1]);
+	}
+	else
+	{
+		EEPROM.update(g_uPendingAddress, g_arPendingRecord[0]);
+	}
 }
 
 void Storage::UpdateField(unsigned int index, unsigned char byte)
 {
-	EEPROM.put(index, byte);
+	g_uLastFieldChange = millis();
+
+	for (uint8_t i = 0; i < g_u8NumDirtyFields; ++i)
+	{
+		if (g_arDirtyFields[i].m_uIndex == index)
+		{
+			g_arDirtyFields[i].m_u8Value = byte;
+
+			return;
+		}
+	}
+
+	if (g_u8NumDirtyFields == FIELD_CACHE_SIZE)
+		Storage::Flush();
+
+	g_arDirtyFields[g_u8NumDirtyFields].m_uIndex = index;
+	g_arDirtyFields[g_u8NumDirtyFields].m_u8Value = byte;
+	++g_u8NumDirtyFields;
+}
+
+void Storage::Update(const unsigned long ticks)
+{
+	if (!IsWritingRecord())
+	{
+		if (!g_u8NumDirtyFields)
+			return;
+
+		//still changing? Wait for it to settle down
+		if (ticks - g_uLastFieldChange < FIELD_FLUSH_IDLE_TIME)
+			return;
+
+		BeginRecord();
+	}
+
+	//last write still in progress, do not stall the loop
+	if (!EEPROM_IS_READY())
+		return;
+
+	WriteRecordStep();
+}
+
+void Storage::Flush()
+{
+	for (;;)
+	{
+		if (!IsWritingRecord())
+		{
+			if (!g_u8NumDirtyFields)
+				break;
+
+			BeginRecord();
+		}
+
+		//EEPROM.update waits for the previous write
+		WriteRecordStep();
+	}
+}
+
+void Storage::LoadStateLog()
+{
+	g_u8NumDirtyFields = 0;
+	g_u8PendingStep = STATE_LOG_RECORD_STEPS;
+	g_uNextSeq = 0;
+
+	g_u8Generation = EEPROM.read(GetStateLogStart());
+
+	uint8_t record[STATE_LOG_RECORD_SIZE];
+
+	//newest record is the end of the chain: the next position is invalid or does not hold the next seq
+	int newest = -1;
+	uint16_t newestSeq = 0;
+	for (uint16_t position = 0; position < STATE_LOG_RECORDS; ++position)
+	{
+		uint16_t seq;
+		if (!TryReadRecord(position, record, seq))
+			continue;
+
+		uint16_t nextSeq;
+		if (TryReadRecord((position + 1) % STATE_LOG_RECORDS, record, nextSeq) && (nextSeq == static_cast<uint16_t>(seq + 1)))
+			continue;
+
+		newest = position;
+		newestSeq = seq;
+		break;
+	}
+
+	if (newest < 0)
+		return;
+
+	g_uNextSeq = newestSeq + 1;
+
+	const unsigned int logStart = GetStateLogStart();
+
+	//replay oldest to newest, so the last change of each field wins
+	int numReplayed = 0;
+	for (uint16_t i = 1; i <= STATE_LOG_RECORDS; ++i)
+	{
+		const uint16_t position = (newest + i) % STATE_LOG_RECORDS;
+
+		uint16_t seq;
+		if (!TryReadRecord(position, record, seq))
+			continue;
+
+		//leftover from older laps of the ring
+		if (static_cast<uint16_t>(newestSeq - seq) >= STATE_LOG_RECORDS)
+			continue;
+
+		const unsigned int index = GetRecordIndex(record);
+		if (index >= logStart)
+			continue;
+
+		EEPROM.update(index, record[5]);
+		++numReplayed;
+	}
+
+	Console::Printf(F("[%z] %z %d\n"), MODULE_NAME, F("state log replayed"), numReplayed);
+}
+
+//like ResetStateLog, but does not trust the generation byte, it may have been overwritten
+static void RestartStateLog()
+{
+	g_u8NumDirtyFields = 0;
+	g_u8PendingStep = STATE_LOG_RECORD_STEPS;
+	g_uNextSeq = 0;
+
+	++g_u8Generation;
+	EEPROM.update(GetStateLogStart(), g_u8Generation);
+}
+
+void Storage::ResetStateLog()
+{
+	g_u8NumDirtyFields = 0;
+	g_u8PendingStep = STATE_LOG_RECORD_STEPS;
+	g_uNextSeq = 0;
+
+	g_u8Generation = EEPROM.read(GetStateLogStart()) + 1;
+	EEPROM.update(GetStateLogStart(), g_u8Generation);
 }
 
 
@@ -96,7 +96,10 @@ namespace Storage
 
 	extern bool LoadConfig();	
 
-	extern void SaveConfig();
+	/**
+		Writes the config, returns false and leaves no valid config when it does not fit before the state log
+	*/
+	extern bool SaveConfig();
 
 	//Write blanks at stream header to invalidate it
 	extern void Clear();
@@ -104,8 +107,34 @@ namespace Storage
 	extern void Dump();
 	extern void DumpHex();
 
+	/**
+		Queues a state field change, fields are kept on a RAM cache (coalescing repeated changes) and written to the state
+		log by Update when the fields stop changing
+	*/
 	extern void UpdateField(unsigned int index, unsigned char byte);
 
+	/**
+		Flushes dirty fields to the state log, one byte per call and only when the EEPROM is ready, so loop never waits
+		for a write to finish
+	*/
+	extern void Update(const unsigned long ticks);
+
+	/**
+		Writes all dirty fields now, blocking
+	*/
+	extern void Flush();
+
+	/**
+		Replays the state log over the config, must be called at boot after checking the config is valid and before
+		loading the decoders
+	*/
+	extern void LoadStateLog();
+
+	/**
+		Invalidates the state log and drops the dirty fields, must be called before writing a new config
+	*/
+	extern void ResetStateLog();
+
 	extern bool Custom_LoadModules(const Storage::Lump &lump, EpromStream &stream);
 	extern void Custom_SaveModules(EpromStream &stream);
 
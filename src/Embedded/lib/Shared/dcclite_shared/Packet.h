@@ -16,6 +16,7 @@
 
 #include "BitPack.h"
 #include "GuidDefs.h"
+#include "PacketSchema.h"
 
 namespace dcclite
 {
@@ -96,12 +97,34 @@ namespace dcclite
 
 	constexpr uint8_t MAX_DECODERS_STATES_PER_PACKET = 64;
 	
-	constexpr uint16_t PROTOCOL_VERSION = 12;
+	constexpr uint16_t PROTOCOL_VERSION = 15;
+
+	//oldest device protocol the broker still talks to
+	constexpr uint16_t PROTOCOL_MIN_VERSION = 13;
+
+	//STATE and SYNC packets use StatesCodec, older devices get the plain bitmaps
+	constexpr uint16_t PROTOCOL_VERSION_COMPACT_STATES = 14;
+
+	//outputs with OUTD_FLASH are blinked by the device, older devices are flashed by the broker
+	constexpr uint16_t PROTOCOL_VERSION_DEVICE_FLASH = 15;
 
 	constexpr uint8_t MAX_NODE_NAME = 16;
 
 	typedef BitPack<MAX_DECODERS_STATES_PER_PACKET> StatesBitPack_t;
 
+	//CONFIG_ACK carries all the configured slots, so the server can recover from lost acks
+	typedef BitPack<MAX_DECODERS_STATES_PER_PACKET> ConfigAcksBitPack_t;
+
+	//
+	//Fixed layout messages, shared by broker and firmware
+	//
+
+	//PACKET_ID MSG_TYPE SESSION_TOKEN CONFIG_TOKEN, see PacketBuilder
+	typedef PacketSchema<uint32_t, MsgTypes, Guid, Guid> PacketHeaderSchema_t;
+
+	//CONFIG_ACK: seq, all configured slots
+	typedef PacketSchema<uint8_t, ConfigAcksBitPack_t> ConfigAckSchema_t;
+
 	inline const char *MsgName(const MsgTypes type)
 	{
 		switch (type)
@@ -272,7 +295,41 @@ namespace dcclite
 			inline uint8_t ReadByte() noexcept
 			{
 				return Read<uint8_t>();
-			}						
+			}
+
+			/// <summary>
+			/// Checks if numBytes can be written or read from the current position, same rule used by the asserts
+			/// </summary>
+			inline bool HasRoom(const LENSIZE numBytes) const noexcept
+			{
+				return m_uIndex + numBytes < SIZE;
+			}
+
+			/// <summary>
+			/// Reserves numBytes for writing with a single check, see PacketSchema
+			/// </summary>
+			inline uint8_t *BeginWrite(const LENSIZE numBytes) noexcept
+			{
+				assert(m_uIndex + numBytes < SIZE);
+
+				uint8_t *dest = m_arData + m_uIndex;
+				m_uIndex += numBytes;
+
+				return dest;
+			}
+
+			/// <summary>
+			/// Consumes numBytes with a single check, see PacketSchema
+			/// </summary>
+			inline const uint8_t *BeginRead(const LENSIZE numBytes) noexcept
+			{
+				assert(m_uIndex + numBytes < SIZE);
+
+				const uint8_t *src = m_arData + m_uIndex;
+				m_uIndex += numBytes;
+
+				return src;
+			}
 
 			inline LENSIZE GetSize() const noexcept
 			{
@@ -346,10 +403,7 @@ namespace dcclite
 			inline PacketBuilder(Packet &pkt, MsgTypes msgType, const Guid &sessionToken, const Guid &configToken):
 				m_Packet(pkt)
 			{
-				pkt.Write32(PACKET_ID);				
-				pkt.Write8(static_cast<uint8_t>(msgType));
-				pkt.Write(sessionToken);
-				pkt.Write(configToken);
+				PacketHeaderSchema_t::Write(pkt, PACKET_ID, msgType, sessionToken, configToken);
 			}
 
 			inline void WriteStr(const char *str)
@@ -0,0 +1,157 @@
+// Copyright (C) 2019 - Bruno Sanches. See the COPYRIGHT
+// file at the top-level directory of this distribution.
+//
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+//
+// This Source Code Form is "Incompatible With Secondary Licenses", as
+// defined by the Mozilla Public License, v. 2.0.
+
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+
+#include "BitPack.h"
+#include "GuidDefs.h"
+
+namespace dcclite
+{
+	template <uint32_t SIZE, typename LENSIZE>
+	class BasePacket;
+
+	/**
+
+	How a single field goes to the wire. Plain types (integers and enums) are copied in host order, same as Packet::WriteXX and Read, so
+	schemas and the old per byte calls can be mixed on the same packet.
+
+	Keep it C++11 and STL free, this is also compiled for AVR.
+
+	*/
+	template <typename T>
+	struct SchemaField
+	{
+		static constexpr uint8_t SIZE = sizeof(T);
+
+		static inline void Store(uint8_t *dest, const T &value) noexcept
+		{
+			memcpy(dest, &value, SIZE);
+		}
+
+		static inline void Load(const uint8_t *src, T &value) noexcept
+		{
+			memcpy(&value, src, SIZE);
+		}
+	};
+
+	template <>
+	struct SchemaField<Guid>
+	{
+		static constexpr uint8_t SIZE = sizeof(Guid::m_bId);
+
+		static inline void Store(uint8_t *dest, const Guid &value) noexcept
+		{
+			memcpy(dest, value.m_bId, SIZE);
+		}
+
+		static inline void Load(const uint8_t *src, Guid &value) noexcept
+		{
+			memcpy(value.m_bId, src, SIZE);
+		}
+	};
+
+	template <size_t NBITS>
+	struct SchemaField<BitPack<NBITS>>
+	{
+		static constexpr uint8_t SIZE = NBITS / 8;
+
+		static inline void Store(uint8_t *dest, const BitPack<NBITS> &value) noexcept
+		{
+			memcpy(dest, value.GetRaw(), SIZE);
+		}
+
+		static inline void Load(const uint8_t *src, BitPack<NBITS> &value) noexcept
+		{
+			value.Set(src);
+		}
+	};
+
+	namespace detail
+	{
+		template <typename... FIELDS>
+		struct SchemaCodec;
+
+		template <>
+		struct SchemaCodec<>
+		{
+			static constexpr unsigned SIZE = 0;
+
+			static inline void Store(uint8_t *) noexcept
+			{
+				//empty
+			}
+
+			static inline void Load(const uint8_t *) noexcept
+			{
+				//empty
+			}
+		};
+
+		//Fields types come from the schema, not from the arguments, so a literal cannot change the field size
+		template <typename HEAD, typename... TAIL>
+		struct SchemaCodec<HEAD, TAIL...>
+		{
+			static constexpr unsigned SIZE = SchemaField<HEAD>::SIZE + SchemaCodec<TAIL...>::SIZE;
+
+			static inline void Store(uint8_t *dest, const HEAD &head, const TAIL &... tail) noexcept
+			{
+				SchemaField<HEAD>::Store(dest, head);
+				SchemaCodec<TAIL...>::Store(dest + SchemaField<HEAD>::SIZE, tail...);
+			}
+
+			static inline void Load(const uint8_t *src, HEAD &head, TAIL &... tail) noexcept
+			{
+				SchemaField<HEAD>::Load(src, head);
+				SchemaCodec<TAIL...>::Load(src + SchemaField<HEAD>::SIZE, tail...);
+			}
+		};
+	}
+
+	/**
+
+	Fixed layout message (or part of a message), shared by broker and firmware, so both sides always agree on fields order and size.
+
+	The size is known at compile time, so writing or reading all the fields costs a single bounds check and the fields are
+	copied straight to the packet buffer.
+
+	Write asserts like the Packet::WriteXX methods, Read returns false if the packet does not have all the fields, in that case
+	nothing is consumed.
+
+	*/
+	template <typename... FIELDS>
+	class PacketSchema
+	{
+		public:
+			static constexpr uint8_t SIZE = detail::SchemaCodec<FIELDS...>::SIZE;
+
+			static_assert(detail::SchemaCodec<FIELDS...>::SIZE < 256, "Schema too big for a packet");
+
+			template <uint32_t PACKET_SIZE, typename LENSIZE>
+			static inline void Write(BasePacket<PACKET_SIZE, LENSIZE> &packet, const FIELDS &... fields) noexcept
+			{
+				detail::SchemaCodec<FIELDS...>::Store(packet.BeginWrite(SIZE), fields...);
+			}
+
+			template <uint32_t PACKET_SIZE, typename LENSIZE>
+			static inline bool Read(BasePacket<PACKET_SIZE, LENSIZE> &packet, FIELDS &... fields) noexcept
+			{
+				if (!packet.HasRoom(SIZE))
+					return false;
+
+				detail::SchemaCodec<FIELDS...>::Load(packet.BeginRead(SIZE), fields...);
+
+				return true;
+			}
+	};
+}
@@ -75,6 +75,11 @@ namespace dcclite
 	IFLAG, bit 2: 0 = state of pin set to INACTIVE uponm power-up or when first created
 				  1 = state of pin set to ACTIVE uponm power-up or when first created
 
+	DCCLite only (not sent to DCC++ clients):
+
+	IFLAG, bit 3: 0 = pin follows the state
+				  1 = pin flashes while ACTIVE, done by the device, so state does not change
+
 	
 	*/
 	enum OutputDecoderFlags : uint8_t
@@ -82,6 +87,7 @@ namespace dcclite
 		OUTD_INVERTED_OPERATION = 0x01,
 		OUTD_IGNORE_SAVED_STATE = 0x02,
 		OUTD_ACTIVATE_ON_POWER_UP = 0x04,
+		OUTD_FLASH = 0x08,
 
 		OUTD_ACTIVE = 0x80
 	};		
@@ -105,6 +111,7 @@ namespace dcclite
 		SNRD_INVERTED = 0x02,
 
 		//runtime flags
+		SNRD_SETTLED = 0x08,		//pin matches the state, nothing to do until it changes
 		SNRD_DELAY = 0x10,
 		SNRD_COOLDOWN = 0x20,
 		SNRD_REMOTE_ACTIVE = 0x40,
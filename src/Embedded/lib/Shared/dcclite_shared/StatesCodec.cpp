@@ -0,0 +1,240 @@
+// Copyright (C) 2019 - Bruno Sanches. See the COPYRIGHT
+// file at the top-level directory of this distribution.
+//
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+//
+// This Source Code Form is "Incompatible With Secondary Licenses", as
+// defined by the Mozilla Public License, v. 2.0.
+
+#include "StatesCodec.h"
+
+namespace dcclite
+{
+	namespace
+	{
+		enum RleSymbols: uint8_t
+		{
+			RLE_UNCHANGED = 0,
+			RLE_INACTIVE,
+			RLE_ACTIVE
+		};
+
+		constexpr uint8_t SPARSE_STATE_BIT = 0x80;
+		constexpr uint8_t SPARSE_INDEX_MASK = 0x3F;
+
+		constexpr uint8_t RLE_SYMBOL_SHIFT = 6;
+		constexpr uint8_t RLE_LENGTH_MASK = 0x3F;
+		constexpr uint8_t RLE_MAX_RUN = RLE_LENGTH_MASK + 1;
+
+		static_assert(MAX_DECODERS_STATES_PER_PACKET <= SPARSE_INDEX_MASK + 1, "Index does not fit on sparse encoding");
+
+		inline uint8_t GetSymbol(const StatesBitPack_t &changedStates, const StatesBitPack_t &states, const unsigned index) noexcept
+		{
+			return changedStates[index] ? (states[index] ? RLE_ACTIVE : RLE_INACTIVE) : RLE_UNCHANGED;
+		}
+
+		uint8_t CountChanges(const StatesBitPack_t &changedStates) noexcept
+		{
+			const uint8_t *data = changedStates.GetRaw();
+
+			uint8_t count = 0;
+			for (unsigned i = 0; i < changedStates.GetNumBytes(); ++i)
+			{
+				//clear the lowest bit until nothing is left, cheap for the usual few changes
+				for (uint8_t bits = data[i]; bits; bits &= bits - 1)
+					++count;
+			}
+
+			return count;
+		}
+
+		/**
+		Returns the number of decoders that need to be covered by runs, so trailing unchanged decoders are not sent
+		*/
+		unsigned GetRleLength(const StatesBitPack_t &changedStates) noexcept
+		{
+			const uint8_t *data = changedStates.GetRaw();
+
+			for (unsigned i = changedStates.GetNumBytes(); i > 0; --i)
+			{
+				const uint8_t bits = data[i - 1];
+				if (!bits)
+					continue;
+
+				unsigned bit = 7;
+				while (!(bits & (1 << bit)))
+					--bit;
+
+				return (i - 1) * 8 + bit + 1;
+			}
+
+			return 0;
+		}
+
+		uint8_t CountRuns(const StatesBitPack_t &changedStates, const StatesBitPack_t &states, const unsigned length) noexcept
+		{
+			uint8_t runs = 0;
+
+			for (unsigned i = 0; i < length;)
+			{
+				const uint8_t symbol = GetSymbol(changedStates, states, i);
+
+				unsigned runLength = 1;
+				while ((i + runLength < length) && (runLength < RLE_MAX_RUN) && (GetSymbol(changedStates, states, i + runLength) == symbol))
+					++runLength;
+
+				i += runLength;
+				++runs;
+			}
+
+			return runs;
+		}
+	}
+
+	StatesEncoding StatesCodec::SelectEncoding(const StatesBitPack_t &changedStates, const StatesBitPack_t &states) noexcept
+	{
+		const unsigned sparseSize = 1 + CountChanges(changedStates);
+		const unsigned bitmapSize = changedStates.GetNumBytes() + states.GetNumBytes();
+
+		//nothing beats sparse for a few changes, so do not bother counting runs
+		if (sparseSize <= 2)
+			return StatesEncoding::SPARSE;
+
+		const unsigned rleSize = 1 + CountRuns(changedStates, states, GetRleLength(changedStates));
+
+		if ((sparseSize <= rleSize) && (sparseSize <= bitmapSize))
+			return StatesEncoding::SPARSE;
+
+		return rleSize < bitmapSize ? StatesEncoding::RLE : StatesEncoding::BITMAP;
+	}
+
+	void StatesCodec::Write(Packet &packet, const StatesBitPack_t &changedStates, const StatesBitPack_t &states) noexcept
+	{
+		const auto encoding = SelectEncoding(changedStates, states);
+
+		packet.Write8(static_cast<uint8_t>(encoding));
+
+		switch (encoding)
+		{
+			case StatesEncoding::SPARSE:
+				packet.Write8(CountChanges(changedStates));
+
+				for (unsigned i = 0; i < changedStates.size(); ++i)
+				{
+					if (changedStates[i])
+						packet.Write8(static_cast<uint8_t>(i | (states[i] ? SPARSE_STATE_BIT : 0)));
+				}
+				break;
+
+			case StatesEncoding::RLE:
+			{
+				const unsigned length = GetRleLength(changedStates);
+
+				packet.Write8(CountRuns(changedStates, states, length));
+
+				for (unsigned i = 0; i < length;)
+				{
+					const uint8_t symbol = GetSymbol(changedStates, states, i);
+
+					unsigned runLength = 1;
+					while ((i + runLength < length) && (runLength < RLE_MAX_RUN) && (GetSymbol(changedStates, states, i + runLength) == symbol))
+						++runLength;
+
+					packet.Write8(static_cast<uint8_t>((symbol << RLE_SYMBOL_SHIFT) | (runLength - 1)));
+
+					i += runLength;
+				}
+			}
+			break;
+
+			default:
+				packet.Write(changedStates);
+				packet.Write(states);
+				break;
+		}
+	}
+
+	bool StatesCodec::Read(Packet &packet, StatesBitPack_t &changedStates, StatesBitPack_t &states) noexcept
+	{
+		changedStates.ClearAll();
+		states.ClearAll();
+
+		if (!packet.HasRoom(1))
+			return false;
+
+		const auto encoding = static_cast<StatesEncoding>(packet.Read<uint8_t>());
+
+		switch (encoding)
+		{
+			case StatesEncoding::BITMAP:
+				if (!packet.HasRoom(changedStates.GetNumBytes() + states.GetNumBytes()))
+					return false;
+
+				packet.ReadBitPack(changedStates);
+				packet.ReadBitPack(states);
+
+				return true;
+
+			case StatesEncoding::SPARSE:
+			{
+				if (!packet.HasRoom(1))
+					return false;
+
+				const uint8_t count = packet.Read<uint8_t>();
+				if ((count > changedStates.size()) || !packet.HasRoom(count))
+					return false;
+
+				for (uint8_t i = 0; i < count; ++i)
+				{
+					const uint8_t data = packet.Read<uint8_t>();
+					const uint8_t index = data & SPARSE_INDEX_MASK;
+
+					changedStates.SetBit(index);
+					states.SetBitValue(index, data & SPARSE_STATE_BIT);
+				}
+
+				return true;
+			}
+
+			case StatesEncoding::RLE:
+			{
+				if (!packet.HasRoom(1))
+					return false;
+
+				const uint8_t runs = packet.Read<uint8_t>();
+				if ((runs > changedStates.size()) || !packet.HasRoom(runs))
+					return false;
+
+				unsigned pos = 0;
+				for (uint8_t i = 0; i < runs; ++i)
+				{
+					const uint8_t data = packet.Read<uint8_t>();
+
+					const uint8_t symbol = data >> RLE_SYMBOL_SHIFT;
+					const unsigned runLength = (data & RLE_LENGTH_MASK) + 1u;
+
+					if ((symbol > RLE_ACTIVE) || (pos + runLength > changedStates.size()))
+						return false;
+
+					if (symbol != RLE_UNCHANGED)
+					{
+						for (unsigned j = pos; j < pos + runLength; ++j)
+						{
+							changedStates.SetBit(j);
+							states.SetBitValue(j, symbol == RLE_ACTIVE);
+						}
+					}
+
+					pos += runLength;
+				}
+
+				return true;
+			}
+
+			default:
+				return false;
+		}
+	}
+}
@@ -0,0 +1,53 @@
+// Copyright (C) 2019 - Bruno Sanches. See the COPYRIGHT
+// file at the top-level directory of this distribution.
+//
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+//
+// This Source Code Form is "Incompatible With Secondary Licenses", as
+// defined by the Mozilla Public License, v. 2.0.
+
+#pragma once
+
+#include "Packet.h"
+
+namespace dcclite
+{
+	/**
+
+	Compact encoding for the decoders states blocks of STATE and SYNC packets (PROTOCOL_VERSION_COMPACT_STATES).
+
+	The old format is always two StatesBitPack_t (changed mask plus states, 16 bytes), even when a single decoder changes. Now the
+	encoder picks the smallest of:
+
+		- SPARSE: count, then one byte per change: index on the low 6 bits, state on the high bit
+		- RLE: count, then runs up to the last changed decoder: run length - 1 on the low 6 bits,
+			   symbol (unchanged, inactive, active) on the high 2 bits
+		- BITMAP: the old format
+
+	The first byte is always the encoding.
+
+	*/
+	enum class StatesEncoding: uint8_t
+	{
+		BITMAP = 0,
+		SPARSE,
+		RLE
+	};
+
+	namespace StatesCodec
+	{
+		/**
+		Returns the encoding Write will use for this data, useful for tests and stats
+		*/
+		StatesEncoding SelectEncoding(const StatesBitPack_t &changedStates, const StatesBitPack_t &states) noexcept;
+
+		void Write(Packet &packet, const StatesBitPack_t &changedStates, const StatesBitPack_t &states) noexcept;
+
+		/**
+		Returns false if the data is malformed or does not fit on the packet, in that case, the packet must be dropped
+		*/
+		bool Read(Packet &packet, StatesBitPack_t &changedStates, StatesBitPack_t &states) noexcept;
+	}
+}
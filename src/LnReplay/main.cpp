@@ -0,0 +1,102 @@
+// Copyright (C) 2019 - Bruno Sanches. See the COPYRIGHT
+// file at the top-level directory of this distribution.
+//
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+//
+// This Source Code Form is "Incompatible With Secondary Licenses", as
+// defined by the Mozilla Public License, v. 2.0.
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+
+#include <fmt/format.h>
+
+#include <dcclite/Clock.h>
+#include <dcclite/Console.h>
+#include <dcclite/SerialCapture.h>
+#include <dcclite/SerialReplay.h>
+
+static std::atomic_flag g_fExitRequested;
+
+static bool ConsoleCtrlHandler(dcclite::ConsoleEvent event)
+{
+	g_fExitRequested.test_and_set(std::memory_order_relaxed);
+
+	return true;
+}
+
+/**
+	LnReplay <capture file> [speed]
+
+	speed: 1 (default) keeps the captured timing, a greater value plays faster, "max" sends everything as fast as possible
+
+	Point the LoconetService "port" to the printed pty. After the capture ends, the pty stays open (the broker would see
+	an error if it was closed) until CTRL+C.
+*/
+int main(int argc, char **argv)
+{
+	using namespace std::chrono_literals;
+
+	if (argc < 2)
+	{
+		fmt::print("Usage: LnReplay <capture file> [speed|max]\n");
+
+		return -1;
+	}
+
+	try
+	{
+		double speed = 1;
+		if (argc > 2)
+		{
+			std::string_view speedArg{ argv[2] };
+
+			speed = speedArg == "max" ? 0 : std::stod(argv[2]);
+		}
+
+		dcclite::SerialReplay replay{ dcclite::LoadSerialCapture(argv[1]), speed };
+
+		dcclite::ConsoleInstallEventHandler(ConsoleCtrlHandler);
+
+		fmt::print("Replaying {} records on {}, press ENTER to start\n", replay.GetNumRecords(), replay.GetPortName());
+		std::getchar();
+
+		const auto start = dcclite::Clock::DefaultClock_t::now();
+		bool finished = false;
+
+		while (!g_fExitRequested.test(std::memory_order_relaxed))
+		{
+			const auto now = dcclite::Clock::DefaultClock_t::now();
+
+			if (!replay.Update(now) && !finished)
+			{
+				finished = true;
+
+				fmt::print(
+					"Replay finished in {}ms, {} bytes received, CTRL+C to quit\n",
+					std::chrono::duration_cast<std::chrono::milliseconds>(now - start).count(),
+					replay.GetNumBytesReceived()
+				);
+			}
+
+			//at max speed keep the pty full
+			if (speed > 0 || finished)
+				std::this_thread::sleep_for(1ms);
+		}
+	}
+	catch (std::exception &ex)
+	{
+		fmt::print("Fatal: {}\n", ex.what());
+
+		return -1;
+	}
+
+	return 0;
+}
@@ -518,6 +518,7 @@ namespace SharpEEPromViewer
 		static readonly Dictionary<string, Type> gKnownTypes = new()
 		{
 			{ "Bcs0008\0", typeof(RootLump) },
+			{ "Bcs0009\0", typeof(RootLump) },		//009 state log at the end of the EEPROM
 			{ "NetU002\0", typeof(NetworkLumpV002) },
 			{ "NetU003\0", typeof(NetworkLump) },
 			{ "Sson001\0", typeof(SessionLumpV001) },
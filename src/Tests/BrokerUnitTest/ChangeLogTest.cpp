@@ -0,0 +1,105 @@
+// Copyright (C) 2019 - Bruno Sanches. See the COPYRIGHT
+// file at the top-level directory of this distribution.
+//
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+//
+// This Source Code Form is "Incompatible With Secondary Licenses", as
+// defined by the Mozilla Public License, v. 2.0.
+
+#include <gtest/gtest.h>
+
+#include "sys/ChangeLog.h"
+
+using namespace dcclite::broker::sys;
+
+static std::vector<std::string> GetPaths(const std::vector<const ChangeLog::Change *> &changes)
+{
+	std::vector<std::string> paths;
+
+	for (auto change : changes)
+		paths.push_back(change->m_strPath);
+
+	return paths;
+}
+
+TEST(ChangeLog, Empty)
+{
+	ChangeLog log{ 5 };
+
+	ASSERT_EQ(log.GetVersion(), 5u);
+
+	std::vector<const ChangeLog::Change *> changes;
+	ASSERT_TRUE(log.TryGetChangesSince(5, changes));
+	ASSERT_TRUE(changes.empty());
+
+	//before the log started
+	ASSERT_FALSE(log.TryGetChangesSince(4, changes));
+
+	//from the future (broker restarted?)
+	ASSERT_FALSE(log.TryGetChangesSince(6, changes));
+}
+
+TEST(ChangeLog, KeepsLastChangePerPath)
+{
+	ChangeLog log{ 0 };
+
+	log.Record(1, ObjectManagerEvent::ITEM_CREATED, "/a");
+	log.Record(2, ObjectManagerEvent::ITEM_CHANGED, "/b");
+	log.Record(3, ObjectManagerEvent::ITEM_CHANGED, "/a");
+	log.Record(4, ObjectManagerEvent::ITEM_CHANGED, "/c");
+	log.Record(5, ObjectManagerEvent::ITEM_DESTROYED, "/b");
+
+	ASSERT_EQ(log.GetVersion(), 5u);
+
+	std::vector<const ChangeLog::Change *> changes;
+	ASSERT_TRUE(log.TryGetChangesSince(0, changes));
+
+	ASSERT_EQ(GetPaths(changes), (std::vector<std::string>{"/a", "/c", "/b"}));
+	ASSERT_EQ(changes[0]->m_uVersion, 3u);
+	ASSERT_EQ(changes[2]->m_kType, ObjectManagerEvent::ITEM_DESTROYED);
+
+	changes.clear();
+	ASSERT_TRUE(log.TryGetChangesSince(3, changes));
+	ASSERT_EQ(GetPaths(changes), (std::vector<std::string>{"/c", "/b"}));
+
+	changes.clear();
+	ASSERT_TRUE(log.TryGetChangesSince(5, changes));
+	ASSERT_TRUE(changes.empty());
+}
+
+TEST(ChangeLog, Capacity)
+{
+	ChangeLog log{ 0, 3 };
+
+	for (uint64_t i = 1; i <= 5; ++i)
+		log.Record(i, ObjectManagerEvent::ITEM_CHANGED, "/item" + std::to_string(i));
+
+	std::vector<const ChangeLog::Change *> changes;
+
+	//changes 1 and 2 are gone
+	ASSERT_FALSE(log.TryGetChangesSince(0, changes));
+	ASSERT_FALSE(log.TryGetChangesSince(1, changes));
+
+	ASSERT_TRUE(log.TryGetChangesSince(2, changes));
+	ASSERT_EQ(GetPaths(changes), (std::vector<std::string>{"/item3", "/item4", "/item5"}));
+}
+
+TEST(ChangeLog, OutOfOrder)
+{
+	ChangeLog log{ 0 };
+
+	log.Record(2, ObjectManagerEvent::ITEM_CHANGED, "/b");
+	log.Record(1, ObjectManagerEvent::ITEM_CHANGED, "/a");
+	log.Record(3, ObjectManagerEvent::ITEM_CHANGED, "/c");
+
+	std::vector<const ChangeLog::Change *> changes;
+	ASSERT_TRUE(log.TryGetChangesSince(1, changes));
+	ASSERT_EQ(GetPaths(changes), (std::vector<std::string>{"/b", "/c"}));
+}
+
+TEST(ChangeLog, InvalidCapacity)
+{
+	ASSERT_THROW(ChangeLog(0, 0), std::invalid_argument);
+}
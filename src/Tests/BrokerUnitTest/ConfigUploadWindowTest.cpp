@@ -0,0 +1,401 @@
+// Copyright (C) 2019 - Bruno Sanches. See the COPYRIGHT
+// file at the top-level directory of this distribution.
+//
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+//
+// This Source Code Form is "Incompatible With Secondary Licenses", as
+// defined by the Mozilla Public License, v. 2.0.
+
+#include <gtest/gtest.h>
+
+#include <deque>
+#include <random>
+#include <vector>
+
+#include "exec/dcc/ConfigUploadWindow.h"
+#include "sys/Timeouts.h"
+
+using namespace dcclite::broker::exec::dcc;
+using namespace dcclite::broker;
+using namespace std::chrono_literals;
+
+typedef dcclite::Clock::TimePoint_t TimePoint_t;
+
+namespace
+{
+	ConfigUploadWindow MakeWindow(size_t numItems)
+	{
+		return ConfigUploadWindow{ numItems, sys::NETWORK_DEVICE_CONFIG_RETRY_TIME, sys::NETWORK_DEVICE_CONFIG_MIN_RETRY_TIME, sys::NETWORK_DEVICE_CONFIG_MAX_RETRY_TIME };
+	}
+
+	class SentLog
+	{
+		public:
+			ConfigUploadWindow::Sender_t MakeSender()
+			{
+				return [this](size_t index, bool retransmission)
+				{
+					m_vecSent.push_back(index);
+					m_uRetransmissions += retransmission;
+				};
+			}
+
+			std::vector<size_t>		m_vecSent;
+			unsigned				m_uRetransmissions = 0;
+	};
+
+	/**
+	* A device behind a NIC with a tiny receive buffer: packets that arrive while the buffer is full are dropped and
+	* the main loop takes a while for handling each config packet
+	*/
+	class SmallBufferDevice
+	{
+		public:
+			static constexpr auto LINK_DELAY = 2ms;
+			static constexpr auto PROCESSING_TIME = 5ms;
+			static constexpr size_t BUFFER_SIZE = 3;
+
+			struct Ack
+			{
+				TimePoint_t						m_tArrival;
+				size_t							m_uIndex;
+				dcclite::ConfigAcksBitPack_t	m_clSlots;
+			};
+
+			explicit SmallBufferDevice(double lossRate):
+				m_clRng{ 4321 },
+				m_clLoss{ lossRate }
+			{
+				m_clSlots.ClearAll();
+			}
+
+			void Send(size_t index, TimePoint_t time)
+			{
+				++m_uReceivedPackets;
+
+				if (!m_clLoss(m_clRng))
+					m_vecInTransit.push_back({ time + LINK_DELAY, index });
+			}
+
+			/**
+			* Runs the device until time, filling acks with what arrives at the broker until then
+			*/
+			void Update(TimePoint_t time, std::vector<Ack> &acks)
+			{
+				//deliver to the NIC buffer, in order
+				for (auto it = m_vecInTransit.begin(); it != m_vecInTransit.end();)
+				{
+					if (it->first > time)
+					{
+						++it;
+						continue;
+					}
+
+					if (m_dqBuffer.size() < BUFFER_SIZE)
+						m_dqBuffer.push_back(*it);
+					else
+						++m_uDroppedPackets;
+
+					it = m_vecInTransit.erase(it);
+				}
+
+				//main loop, one packet at a time
+				while (!m_dqBuffer.empty())
+				{
+					auto start = std::max(m_tBusyUntil, m_dqBuffer.front().first);
+					if (start + PROCESSING_TIME > time)
+						break;
+
+					const auto index = m_dqBuffer.front().second;
+					m_dqBuffer.pop_front();
+
+					m_tBusyUntil = start + PROCESSING_TIME;
+
+					m_clSlots.SetBit(static_cast<unsigned>(index));
+
+					if (!m_clLoss(m_clRng))
+						m_vecAcksInTransit.push_back({ m_tBusyUntil + LINK_DELAY, index, m_clSlots });
+				}
+
+				for (auto it = m_vecAcksInTransit.begin(); it != m_vecAcksInTransit.end();)
+				{
+					if (it->m_tArrival > time)
+					{
+						++it;
+						continue;
+					}
+
+					acks.push_back(*it);
+					it = m_vecAcksInTransit.erase(it);
+				}
+			}
+
+			unsigned m_uReceivedPackets = 0;
+			unsigned m_uDroppedPackets = 0;
+
+		private:
+			std::mt19937										m_clRng;
+			std::bernoulli_distribution							m_clLoss;
+
+			std::vector<std::pair<TimePoint_t, size_t>>			m_vecInTransit;
+			std::deque<std::pair<TimePoint_t, size_t>>			m_dqBuffer;
+			std::vector<Ack>									m_vecAcksInTransit;
+
+			TimePoint_t											m_tBusyUntil;
+
+			dcclite::ConfigAcksBitPack_t						m_clSlots;
+	};
+
+	struct UploadResult
+	{
+		std::chrono::milliseconds	m_tTime;
+
+		unsigned					m_uPackets;
+		unsigned					m_uDropped;
+	};
+
+	constexpr auto SIMULATION_STEP = 100us;
+	constexpr auto SIMULATION_LIMIT = 60s;
+
+	/**
+	* How ConfigState used to work: send everything, then every retry tick, resend up to 3 packets without ack
+	*/
+	UploadResult BurstUpload(size_t numItems, double lossRate)
+	{
+		SmallBufferDevice device{ lossRate };
+
+		std::vector<bool> acked(numItems);
+		size_t numAcked = 0;
+
+		TimePoint_t time{};
+
+		for (size_t i = 0; i < numItems; ++i)
+			device.Send(i, time);
+
+		auto retryTime = time + sys::NETWORK_DEVICE_CONFIG_RETRY_TIME;
+
+		std::vector<SmallBufferDevice::Ack> acks;
+		while ((numAcked < numItems) && (time < TimePoint_t{} + SIMULATION_LIMIT))
+		{
+			time += SIMULATION_STEP;
+
+			acks.clear();
+			device.Update(time, acks);
+
+			for (const auto &ack : acks)
+			{
+				numAcked += !acked[ack.m_uIndex];
+				acked[ack.m_uIndex] = true;
+
+				retryTime = time + sys::NETWORK_DEVICE_CONFIG_RETRY_TIME;
+			}
+
+			if (time < retryTime)
+				continue;
+
+			retryTime = time + sys::NETWORK_DEVICE_CONFIG_RETRY_TIME;
+
+			int packetCount = 0;
+			for (size_t i = 0; (i < numItems) && (packetCount < 3); ++i)
+			{
+				if (acked[i])
+					continue;
+
+				device.Send(i, time);
+				++packetCount;
+			}
+		}
+
+		return { std::chrono::duration_cast<std::chrono::milliseconds>(time - TimePoint_t{}), device.m_uReceivedPackets, device.m_uDroppedPackets };
+	}
+
+	UploadResult WindowUpload(size_t numItems, double lossRate)
+	{
+		SmallBufferDevice device{ lossRate };
+
+		auto window = MakeWindow(numItems);
+
+		TimePoint_t time{};
+
+		auto sender = [&device, &time](size_t index, bool)
+		{
+			device.Send(index, time);
+		};
+
+		auto nextUpdate = window.Update(time, sender);
+
+		std::vector<SmallBufferDevice::Ack> acks;
+		while (!window.IsComplete() && (time < TimePoint_t{} + SIMULATION_LIMIT))
+		{
+			time += SIMULATION_STEP;
+
+			acks.clear();
+			device.Update(time, acks);
+
+			for (const auto &ack : acks)
+			{
+				window.OnAck(ack.m_uIndex, time);
+				window.OnSelectiveAck(ack.m_clSlots, time);
+			}
+
+			if (!acks.empty() || (time >= nextUpdate))
+				nextUpdate = window.Update(time, sender);
+
+			//after a loss the window may shrink below what is in flight, but the device is never flooded
+			EXPECT_LE(window.GetInFlight(), ConfigUploadWindow::MAX_WINDOW);
+		}
+
+		return { std::chrono::duration_cast<std::chrono::milliseconds>(time - TimePoint_t{}), device.m_uReceivedPackets, device.m_uDroppedPackets };
+	}
+}
+
+TEST(ConfigUploadWindow, InitialWindow)
+{
+	auto window = MakeWindow(10);
+
+	SentLog log;
+	window.Update(TimePoint_t{}, log.MakeSender());
+
+	ASSERT_EQ(log.m_vecSent, (std::vector<size_t>{0, 1}));
+	ASSERT_EQ(window.GetInFlight(), ConfigUploadWindow::INITIAL_WINDOW);
+
+	//window is full, nothing else goes
+	window.Update(TimePoint_t{} + 1ms, log.MakeSender());
+	ASSERT_EQ(log.m_vecSent.size(), 2u);
+
+	ASSERT_FALSE(window.OnAck(10, TimePoint_t{}));
+}
+
+TEST(ConfigUploadWindow, GrowsWithAcks)
+{
+	auto window = MakeWindow(10);
+
+	SentLog log;
+	TimePoint_t time{};
+
+	window.Update(time, log.MakeSender());
+
+	time += 10ms;
+	ASSERT_TRUE(window.OnAck(0, time));
+	ASSERT_TRUE(window.OnAck(1, time));
+
+	ASSERT_EQ(window.GetWindow(), ConfigUploadWindow::INITIAL_WINDOW + 2);
+	ASSERT_EQ(window.GetRttEstimator().GetNumSamples(), 2u);
+	ASSERT_EQ(window.GetRttEstimator().GetSmoothedRtt(), ConfigUploadWindow::Duration_t{ 10ms });
+
+	//paced: a single packet now, next one after SRTT / window
+	window.Update(time, log.MakeSender());
+	ASSERT_EQ(log.m_vecSent.size(), 3u);
+
+	window.Update(time + 2500us, log.MakeSender());
+	ASSERT_EQ(log.m_vecSent.size(), 4u);
+
+	//duplicated acks change nothing
+	window.OnAck(0, time);
+	ASSERT_EQ(window.GetNumAcked(), 2u);
+}
+
+TEST(ConfigUploadWindow, LossDetectedByLaterAcks)
+{
+	auto window = MakeWindow(10);
+
+	SentLog log;
+	TimePoint_t time{};
+
+	//open the window a bit
+	window.Update(time, log.MakeSender());
+	window.OnAck(0, time);
+	window.OnAck(1, time);
+	window.Update(time, log.MakeSender());
+
+	ASSERT_EQ(log.m_vecSent, (std::vector<size_t>{0, 1, 2, 3, 4, 5}));
+
+	const auto windowBefore = window.GetWindow();
+
+	//2 got lost, 3 more packets after it were acked
+	window.OnAck(3, time);
+	window.OnAck(4, time);
+	ASSERT_EQ(window.GetWindow(), windowBefore + 2);
+
+	window.OnAck(5, time);
+	//grew once more with this ack, then halved
+	ASSERT_EQ(window.GetWindow(), (windowBefore + 3) / 2);
+
+	window.Update(time, log.MakeSender());
+	ASSERT_EQ(log.m_vecSent[6], 2u);
+	ASSERT_EQ(log.m_uRetransmissions, 1u);
+}
+
+TEST(ConfigUploadWindow, Timeout)
+{
+	auto window = MakeWindow(3);
+
+	SentLog log;
+	TimePoint_t time{};
+
+	auto next = window.Update(time, log.MakeSender());
+	ASSERT_EQ(next, time + sys::NETWORK_DEVICE_CONFIG_RETRY_TIME);
+
+	next = window.Update(next, log.MakeSender());
+
+	//everything lost, back to a single packet, with a longer timeout
+	ASSERT_EQ(window.GetWindow(), 1u);
+	ASSERT_EQ(log.m_vecSent, (std::vector<size_t>{0, 1, 0}));
+	ASSERT_EQ(log.m_uRetransmissions, 1u);
+	ASSERT_EQ(next, time + sys::NETWORK_DEVICE_CONFIG_RETRY_TIME * 3);
+
+	//late ack of a retransmitted packet is not a sample
+	window.OnAck(0, next);
+	ASSERT_EQ(window.GetRttEstimator().GetNumSamples(), 0u);
+}
+
+TEST(ConfigUploadWindow, SelectiveAck)
+{
+	auto window = MakeWindow(4);
+
+	SentLog log;
+	TimePoint_t time{};
+
+	window.Update(time, log.MakeSender());
+
+	//ack of 0 was lost, but the ack of 1 tells 0 is there
+	dcclite::ConfigAcksBitPack_t acks;
+	acks.ClearAll();
+	acks.SetBit(0);
+	acks.SetBit(1);
+
+	window.OnAck(1, time + 5ms);
+	window.OnSelectiveAck(acks, time + 5ms);
+
+	ASSERT_EQ(window.GetNumAcked(), 2u);
+	ASSERT_EQ(window.GetInFlight(), 0u);
+	ASSERT_EQ(window.GetRttEstimator().GetNumSamples(), 1u);
+
+	window.Update(time + 5ms, log.MakeSender());
+	window.Update(time + 10ms, log.MakeSender());
+	acks.SetBit(2);
+	acks.SetBit(3);
+	window.OnSelectiveAck(acks, time + 10ms);
+
+	ASSERT_TRUE(window.IsComplete());
+	ASSERT_EQ(log.m_uRetransmissions, 0u);
+}
+
+TEST(ConfigUploadWindow, SmallReceiveBuffer)
+{
+	//a Mega full of decoders
+	constexpr size_t NUM_DECODERS = 48;
+
+	for (const double lossRate : { 0.0, 0.05 })
+	{
+		auto burst = BurstUpload(NUM_DECODERS, lossRate);
+		auto windowed = WindowUpload(NUM_DECODERS, lossRate);
+
+		ASSERT_LT(windowed.m_tTime, SIMULATION_LIMIT);
+		ASSERT_LT(windowed.m_tTime * 2, burst.m_tTime);
+		ASSERT_LT(windowed.m_uPackets, burst.m_uPackets);
+		ASSERT_LT(windowed.m_uDropped * 4, burst.m_uDropped);
+	}
+}
@@ -0,0 +1,283 @@
+// Copyright (C) 2019 - Bruno Sanches. See the COPYRIGHT
+// file at the top-level directory of this distribution.
+// 
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+// 
+// This Source Code Form is "Incompatible With Secondary Licenses", as
+// defined by the Mozilla Public License, v. 2.0.
+
+#include <gtest/gtest.h>
+
+#include <limits>
+
+#include <fmt/format.h>
+
+#include <JsonCreator/Object.h>
+#include <JsonCreator/StringWriter.h>
+
+#include <rapidjson/document.h>
+
+#include <dcclite/Cbor.h>
+#include <dcclite/DataWriter.h>
+
+using namespace dcclite;
+
+//mimics a decoder state notification, works with any object stream
+template <typename T>
+static void FillItem(T &stream, int index)
+{
+	stream.AddStringValue("name", fmt::format("turnout_{}", index));
+	stream.AddStringValue("className", "ServoTurnoutDecoder");
+	stream.AddStringValue("path", fmt::format("/DCCLite/Devices/Yard/turnout_{}", index));
+	stream.AddIntValue("internalId", 0x7FFF0000 + index);
+	stream.AddIntValue("address", index);
+	stream.AddBool("active", index & 1);
+	stream.AddBool("broken", false);
+	stream.AddStringValue("requestedState", (index & 1) ? "ACTIVE" : "INACTIVE");
+	stream.AddIntValue("pin", index % 54);
+	stream.AddIntValue("offset", -index);
+}
+
+template <typename T>
+static void FillDocument(T &root, int numItems)
+{
+	root.AddStringValue("jsonrpc", "2.0");
+	root.AddStringValue("method", "On-ItemPropertyValueChanged");
+
+	auto items = root.AddArray("items");
+	for (int i = 0; i < numItems; ++i)
+	{
+		auto item = items.AddObject();
+		FillItem(item, i);
+	}
+}
+
+static std::string MakeJson(int numItems)
+{
+	JsonDataWriter writer;
+
+	{
+		auto root = MakeObject(writer);
+		FillDocument(root, numItems);
+	}
+
+	return writer.ReleaseString();
+}
+
+static std::string MakeCbor(int numItems)
+{
+	CborDataWriter writer;
+
+	{
+		auto root = MakeObject(writer);
+		FillDocument(root, numItems);
+	}
+
+	return writer.ReleaseString();
+}
+
+TEST(DataWriter, JsonMatchesJsonCreator)
+{
+	JsonCreator::StringWriter referenceWriter;
+	{
+		auto root = JsonCreator::MakeObject(referenceWriter);
+		FillDocument(root, 3);
+	}
+
+	rapidjson::Document reference;
+	reference.Parse(referenceWriter.GetString().c_str());
+	ASSERT_FALSE(reference.HasParseError());
+
+	rapidjson::Document doc;
+	doc.Parse(MakeJson(3).c_str());
+	ASSERT_FALSE(doc.HasParseError());
+
+	ASSERT_TRUE(doc == reference);
+}
+
+TEST(DataWriter, JsonEscape)
+{
+	JsonDataWriter writer;
+	{
+		auto root = MakeObject(writer);
+
+		root.AddStringValue("text", "a\"b\\c\nd\x01");
+		root.AddFloatValue("nan", std::numeric_limits<double>::quiet_NaN());
+	}
+
+	ASSERT_EQ(writer.GetString(), R"({"text":"a\"b\\c\nd\u0001","nan":null})");
+}
+
+TEST(DataWriter, Projection)
+{
+	const std::vector<std::string> fields{ "name", "pins", "state" };
+
+	JsonDataWriter writer;
+	{
+		ArrayOutputStream items{ writer };
+
+		ProjectionDataWriter projection{ items.GetWriter(), fields };
+		{
+			ObjectOutputStream item{ projection };
+
+			item.AddStringValue("name", "turnout_1");
+			item.AddIntValue("address", 5);
+
+			{
+				//nested keys are not filtered, but the whole object is skipped
+				auto location = item.AddObject("location");
+				location.AddStringValue("name", "yard");
+			}
+
+			{
+				auto pins = item.AddArray("pins");
+				pins.AddIntValue(13);
+
+				auto pin = pins.AddObject();
+				pin.AddIntValue("address", 3);
+			}
+
+			item.AddStringValue("state", "ACTIVE");
+			item.AddNull("broken");
+		}
+	}
+
+	ASSERT_EQ(writer.GetString(), R"([{"name":"turnout_1","pins":[13,{"address":3}],"state":"ACTIVE"}])");
+}
+
+TEST(DataWriter, CborEncoding)
+{
+	CborDataWriter writer;
+	{
+		auto root = MakeObject(writer);
+
+		root.AddIntValue("a", 1);
+		root.AddIntValue("b", -500);
+
+		auto array = root.AddArray("c");
+		array.AddBool(true);
+		array.AddString("xy");
+	}
+
+	//values from RFC 8949 examples
+	const std::string expected{ "\xBF" "\x61" "a" "\x01" "\x61" "b" "\x39\x01\xF3" "\x61" "c" "\x9F" "\xF5" "\x62" "xy" "\xFF" "\xFF" };
+
+	ASSERT_EQ(writer.GetString(), expected);
+}
+
+TEST(DataWriter, CborRoundTrip)
+{
+	CborDataWriter writer;
+	{
+		auto root = MakeObject(writer);
+
+		root.AddStringValue("jsonrpc", "2.0");
+		root.AddIntValue("id", 5);
+		root.AddInt64Value("big", 0x1FFFFFFFFll);
+		root.AddIntValue("negative", -70000);
+		root.AddFloatValue("rate", 0.1);
+		root.AddFloatValue("half", 1.5);
+		root.AddNull("nothing");
+
+		auto params = root.AddArray("params");
+		params.AddString("/DCCLite/Devices");
+
+		{
+			auto nested = params.AddObject();
+			nested.AddBool("flag", false);
+		}
+
+		params.AddArray();
+	}
+
+	rapidjson::Document doc;
+	CborReader reader{ writer.GetString() };
+	doc.Populate(reader);
+
+	ASSERT_TRUE(doc.IsObject());
+	ASSERT_STREQ(doc["jsonrpc"].GetString(), "2.0");
+	ASSERT_TRUE(doc["id"].IsInt());
+	ASSERT_EQ(doc["id"].GetInt(), 5);
+	ASSERT_EQ(doc["big"].GetInt64(), 0x1FFFFFFFFll);
+	ASSERT_EQ(doc["negative"].GetInt(), -70000);
+	ASSERT_DOUBLE_EQ(doc["rate"].GetDouble(), 0.1);
+	ASSERT_DOUBLE_EQ(doc["half"].GetDouble(), 1.5);
+	ASSERT_TRUE(doc["nothing"].IsNull());
+
+	const auto &params = doc["params"];
+	ASSERT_EQ(params.Size(), 3u);
+	ASSERT_STREQ(params[0].GetString(), "/DCCLite/Devices");
+	ASSERT_FALSE(params[1]["flag"].GetBool());
+	ASSERT_TRUE(params[2].IsArray());
+	ASSERT_TRUE(params[2].Empty());
+}
+
+TEST(DataWriter, CborReaderDefiniteLengthAndTags)
+{
+	//tag 55799 (self describe) followed by {"a": [1, 2], "b": 1.0 (half float)}
+	const std::string data{ "\xD9\xD9\xF7" "\xA2" "\x61" "a" "\x82\x01\x02" "\x61" "b" "\xF9\x3C\x00", 14 };
+
+	rapidjson::Document doc;
+	CborReader reader{ data };
+	doc.Populate(reader);
+
+	ASSERT_TRUE(doc.IsObject());
+	ASSERT_EQ(doc["a"].Size(), 2u);
+	ASSERT_EQ(doc["a"][1].GetInt(), 2);
+	ASSERT_DOUBLE_EQ(doc["b"].GetDouble(), 1.0);
+}
+
+TEST(DataWriter, CborReaderRejectsInvalidData)
+{
+	const std::string invalidInputs[] =
+	{
+		//truncated string
+		std::string{ "\xBF\x65" "ab" },
+
+		//missing break
+		std::string{ "\xBF\x61" "a" "\x01" },
+
+		//non string key
+		std::string{ "\xA1\x01\x02" },
+
+		//byte string
+		std::string{ "\x42\x01\x02" },
+
+		//trailing data
+		std::string{ "\xA0\x00", 2 },
+
+		//huge definite array
+		std::string{ "\x9B\xFF\xFF\xFF\xFF\xFF\xFF\xFF\xFF" },
+
+		//deep nesting
+		std::string(1000, '\x81')
+	};
+
+	for (const auto &data : invalidInputs)
+	{
+		rapidjson::Document doc;
+		CborReader reader{ data };
+		doc.Populate(reader);
+
+		ASSERT_FALSE(doc.IsObject());
+	}
+}
+
+TEST(DataWriter, CborCarriesSameDataAsJson)
+{
+	constexpr int NUM_ITEMS = 1000;
+
+	const auto json = MakeJson(NUM_ITEMS);
+	const auto cbor = MakeCbor(NUM_ITEMS);
+
+	rapidjson::Document jsonDoc, cborDoc;
+	jsonDoc.Parse(json.c_str());
+
+	CborReader reader{ cbor };
+	cborDoc.Populate(reader);
+
+	ASSERT_TRUE(jsonDoc == cborDoc);
+	ASSERT_LT(cbor.size(), json.size());
+}
@@ -0,0 +1,178 @@
+// Copyright (C) 2019 - Bruno Sanches. See the COPYRIGHT
+// file at the top-level directory of this distribution.
+// 
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+// 
+// This Source Code Form is "Incompatible With Secondary Licenses", as
+// defined by the Mozilla Public License, v. 2.0.
+
+#include <gtest/gtest.h>
+
+#include <memory>
+
+#include <rapidjson/document.h>
+
+#include <dcclite/FolderObject.h>
+
+#include "../TestsCommon/BrokerMockups.h"
+#include "exec/dcc/DccppResponseCache.h"
+#include "exec/dcc/DecoderIndices.h"
+#include "exec/dcc/SensorDecoder.h"
+#include "exec/dcc/SimpleOutputDecoder.h"
+#include "exec/dcc/TurnoutDecoder.h"
+
+using namespace dcclite::broker::exec::dcc;
+using dcclite::DecoderStates;
+using dcclite::RName;
+
+namespace
+{
+	/**
+	* Forwards changes to the cache like DccppService does with the DccLiteService events
+	*/
+	class DccppResponseCacheTest: public testing::Test
+	{
+		public:
+			DccppResponseCacheTest():
+				m_clDecoders{ RName{"decoders"} },
+				m_clIndices{ m_clDecoders },
+				m_clCache{ m_clIndices }
+			{
+				//empty
+			}
+
+			template <typename T>
+			T &Create(std::string_view name, uint16_t address, const char *json)
+			{
+				rapidjson::Document params;
+				params.Parse(json);
+
+				auto &decoder = static_cast<T &>(*m_clDecoders.AddChild(std::make_unique<T>(Address{ address }, RName{ name }, m_clDecoderServices, m_clDeviceServices, params)));
+
+				m_clIndices.Invalidate();
+				m_clCache.Invalidate();
+
+				return decoder;
+			}
+
+			SensorDecoder &CreateSensor(std::string_view name, uint16_t address)
+			{
+				return this->Create<SensorDecoder>(name, address, R"JSON({"class": "Sensor", "pin": 14})JSON");
+			}
+
+			ServoTurnoutDecoder &CreateTurnout(std::string_view name, uint16_t address)
+			{
+				return this->Create<ServoTurnoutDecoder>(name, address, R"JSON({"class": "ServoTurnout", "pin": 3})JSON");
+			}
+
+			void Destroy(std::string_view name)
+			{
+				m_clCache.Invalidate();
+
+				m_clDecoders.RemoveChild(RName{ name });
+				m_clIndices.Invalidate();
+			}
+
+			void SyncState(RemoteDecoder &decoder, DecoderStates state)
+			{
+				decoder.SyncRemoteState(state);
+
+				m_clCache.OnItemChanged(decoder);
+			}
+
+			const std::string &GetResponse(DccppResponseCache::Responses response)
+			{
+				return m_clCache.GetResponse(response);
+			}
+
+		protected:
+			DecoderServicesMockup		m_clDecoderServices;
+			DeviceDecoderServicesMockup m_clDeviceServices;
+
+			dcclite::FolderObject		m_clDecoders;
+
+			DecoderIndices				m_clIndices;
+			DccppResponseCache			m_clCache;
+	};
+}
+
+TEST_F(DccppResponseCacheTest, Empty)
+{
+	ASSERT_FALSE(m_clCache.HasSensors());
+
+	ASSERT_EQ(this->GetResponse(DccppResponseCache::SENSORS_STATE), "<X>");
+	ASSERT_EQ(this->GetResponse(DccppResponseCache::TURNOUTS_DEF), "<X>");
+	ASSERT_EQ(this->GetResponse(DccppResponseCache::TURNOUTS_ID_LIST), "<jT>");
+}
+
+TEST_F(DccppResponseCacheTest, StateChange)
+{
+	auto &sensor = this->CreateSensor("sensor", 2);
+	auto &turnout = this->CreateTurnout("turnout", 3);
+
+	//all state decoders are reported as sensors, like on DccLiteService::FindAllInputDecoders
+	ASSERT_EQ(this->GetResponse(DccppResponseCache::SENSORS_STATE), "<q2><q3>");
+	ASSERT_NE(this->GetResponse(DccppResponseCache::STATUS).find("<H 3 0>"), std::string::npos);
+
+	this->SyncState(sensor, DecoderStates::ACTIVE);
+	this->SyncState(turnout, DecoderStates::ACTIVE);
+
+	//patched in place, so the same strings are updated
+	ASSERT_EQ(this->GetResponse(DccppResponseCache::SENSORS_STATE), "<Q2><Q3>");
+	ASSERT_NE(this->GetResponse(DccppResponseCache::STATUS).find("<H 3 1>"), std::string::npos);
+	ASSERT_EQ(this->GetResponse(DccppResponseCache::STATUS).find("<H 3 0>"), std::string::npos);
+	ASSERT_NE(this->GetResponse(DccppResponseCache::TURNOUTS_DEF).find(" 1>"), std::string::npos);
+
+	this->SyncState(sensor, DecoderStates::INACTIVE);
+
+	ASSERT_EQ(this->GetResponse(DccppResponseCache::SENSORS_STATE), "<q2><Q3>");
+}
+
+TEST_F(DccppResponseCacheTest, StateChangeWhileInvalid)
+{
+	auto &sensor = this->CreateSensor("sensor", 2);
+
+	//nothing built yet, so nothing to patch, but the rebuild must see the new state
+	this->SyncState(sensor, DecoderStates::ACTIVE);
+
+	ASSERT_EQ(this->GetResponse(DccppResponseCache::SENSORS_STATE), "<Q2>");
+}
+
+TEST_F(DccppResponseCacheTest, Create)
+{
+	this->CreateSensor("sensor2", 2);
+
+	ASSERT_EQ(this->GetResponse(DccppResponseCache::SENSORS_STATE), "<q2>");
+
+	auto &sensor = this->CreateSensor("sensor5", 5);
+
+	ASSERT_TRUE(m_clCache.HasSensors());
+	ASSERT_EQ(this->GetResponse(DccppResponseCache::SENSORS_STATE).size(), std::string{ "<q2><q5>" }.size());
+	ASSERT_NE(this->GetResponse(DccppResponseCache::SENSORS_STATE).find("<q5>"), std::string::npos);
+
+	//patches must point to the rebuilt responses
+	this->SyncState(sensor, DecoderStates::ACTIVE);
+
+	ASSERT_NE(this->GetResponse(DccppResponseCache::SENSORS_STATE).find("<Q5>"), std::string::npos);
+	ASSERT_NE(this->GetResponse(DccppResponseCache::SENSORS_STATE).find("<q2>"), std::string::npos);
+}
+
+TEST_F(DccppResponseCacheTest, Destroy)
+{
+	this->CreateSensor("sensor2", 2);
+	this->CreateTurnout("turnout", 3);
+
+	ASSERT_EQ(this->GetResponse(DccppResponseCache::TURNOUTS_ID_LIST), "<jT 3>");
+
+	this->Destroy("turnout");
+
+	ASSERT_EQ(this->GetResponse(DccppResponseCache::TURNOUTS_ID_LIST), "<jT>");
+	ASSERT_EQ(this->GetResponse(DccppResponseCache::TURNOUTS_DEF), "<X>");
+
+	this->Destroy("sensor2");
+
+	ASSERT_FALSE(m_clCache.HasSensors());
+	ASSERT_EQ(this->GetResponse(DccppResponseCache::SENSORS_STATE), "<X>");
+}
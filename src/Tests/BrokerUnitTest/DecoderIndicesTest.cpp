@@ -0,0 +1,175 @@
+// Copyright (C) 2019 - Bruno Sanches. See the COPYRIGHT
+// file at the top-level directory of this distribution.
+// 
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+// 
+// This Source Code Form is "Incompatible With Secondary Licenses", as
+// defined by the Mozilla Public License, v. 2.0.
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <memory>
+
+#include <rapidjson/document.h>
+
+#include <dcclite/FolderObject.h>
+
+#include "../TestsCommon/BrokerMockups.h"
+#include "exec/dcc/DecoderIndices.h"
+#include "exec/dcc/SensorDecoder.h"
+#include "exec/dcc/SimpleOutputDecoder.h"
+#include "exec/dcc/TurnoutDecoder.h"
+
+using namespace dcclite::broker::exec::dcc;
+using dcclite::RName;
+
+namespace
+{
+	/**
+	* Mimics what DccLiteService does: decoders live on a folder and the indices are invalidated on every create or destroy
+	*/
+	class DecoderIndicesTest: public testing::Test
+	{
+		public:
+			DecoderIndicesTest():
+				m_clDecoders{ RName{"decoders"} },
+				m_clIndices{ m_clDecoders }
+			{
+				//empty
+			}
+
+			template <typename T>
+			T &Create(std::string_view name, uint16_t address, const char *json)
+			{
+				rapidjson::Document params;
+				params.Parse(json);
+
+				auto &decoder = static_cast<T &>(*m_clDecoders.AddChild(std::make_unique<T>(Address{ address }, RName{ name }, m_clDecoderServices, m_clDeviceServices, params)));
+				m_clIndices.Invalidate();
+
+				return decoder;
+			}
+
+			SimpleOutputDecoder &CreateOutput(std::string_view name, uint16_t address)
+			{
+				return this->Create<SimpleOutputDecoder>(name, address, R"JSON({"class": "Output", "pin": 13})JSON");
+			}
+
+			SensorDecoder &CreateSensor(std::string_view name, uint16_t address)
+			{
+				return this->Create<SensorDecoder>(name, address, R"JSON({"class": "Sensor", "pin": 14})JSON");
+			}
+
+			ServoTurnoutDecoder &CreateTurnout(std::string_view name, uint16_t address)
+			{
+				return this->Create<ServoTurnoutDecoder>(name, address, R"JSON({"class": "ServoTurnout", "pin": 3})JSON");
+			}
+
+			void Destroy(std::string_view name)
+			{
+				m_clDecoders.RemoveChild(RName{ name });
+				m_clIndices.Invalidate();
+			}
+
+			template <typename T>
+			static bool Contains(const std::vector<const T *> &list, RName name)
+			{
+				return std::any_of(list.begin(), list.end(), [name](const T *decoder) { return decoder->GetName() == name; });
+			}
+
+		protected:
+			DecoderServicesMockup		m_clDecoderServices;
+			DeviceDecoderServicesMockup m_clDeviceServices;
+
+			dcclite::FolderObject		m_clDecoders;
+
+			DecoderIndices				m_clIndices;
+	};
+}
+
+TEST_F(DecoderIndicesTest, Empty)
+{
+	ASSERT_TRUE(m_clIndices.GetSimpleOutputs().empty());
+	ASSERT_TRUE(m_clIndices.GetInputs().empty());
+	ASSERT_TRUE(m_clIndices.GetTurnouts().empty());
+}
+
+TEST_F(DecoderIndicesTest, Create)
+{
+	//build the indices before any decoder exists, so the test covers the update
+	ASSERT_TRUE(m_clIndices.GetSimpleOutputs().empty());
+
+	this->CreateOutput("output", 1);
+	this->CreateSensor("sensor", 2);
+	this->CreateTurnout("turnout", 3);
+
+	ASSERT_EQ(m_clIndices.GetSimpleOutputs().size(), 1);
+	ASSERT_TRUE(Contains(m_clIndices.GetSimpleOutputs(), RName{ "output" }));
+
+	ASSERT_EQ(m_clIndices.GetTurnouts().size(), 1);
+	ASSERT_TRUE(Contains(m_clIndices.GetTurnouts(), RName{ "turnout" }));
+
+	//all state decoders are inputs, like on DccLiteService::FindAllInputDecoders
+	ASSERT_EQ(m_clIndices.GetInputs().size(), 3);
+	ASSERT_TRUE(Contains(m_clIndices.GetInputs(), RName{ "sensor" }));
+}
+
+TEST_F(DecoderIndicesTest, Rename)
+{
+	this->CreateTurnout("old", 3);
+
+	ASSERT_TRUE(Contains(m_clIndices.GetTurnouts(), RName{ "old" }));
+
+	//a device reload renames a decoder by destroying it and creating it again with the new name
+	this->Destroy("old");
+	auto &turnout = this->CreateTurnout("new", 3);
+
+	const auto &turnouts = m_clIndices.GetTurnouts();
+	ASSERT_EQ(turnouts.size(), 1);
+	ASSERT_EQ(turnouts[0], &turnout);
+	ASSERT_FALSE(Contains(turnouts, RName{ "old" }));
+}
+
+TEST_F(DecoderIndicesTest, Destroy)
+{
+	this->CreateOutput("output", 1);
+	this->CreateSensor("sensor", 2);
+	this->CreateTurnout("turnout", 3);
+
+	ASSERT_EQ(m_clIndices.GetInputs().size(), 3);
+
+	this->Destroy("output");
+
+	ASSERT_TRUE(m_clIndices.GetSimpleOutputs().empty());
+	ASSERT_EQ(m_clIndices.GetInputs().size(), 2);
+	ASSERT_FALSE(Contains(m_clIndices.GetInputs(), RName{ "output" }));
+
+	this->Destroy("turnout");
+	this->Destroy("sensor");
+
+	ASSERT_TRUE(m_clIndices.GetTurnouts().empty());
+	ASSERT_TRUE(m_clIndices.GetInputs().empty());
+}
+
+TEST_F(DecoderIndicesTest, CachedUntilInvalidated)
+{
+	this->CreateOutput("output", 1);
+
+	auto &outputs = m_clIndices.GetSimpleOutputs();
+	ASSERT_EQ(outputs.size(), 1);
+
+	//add one behind the indices back, the lists must not change until invalidated
+	rapidjson::Document params;
+	params.Parse(R"JSON({"class": "Output", "pin": 15})JSON");
+	m_clDecoders.AddChild(std::make_unique<SimpleOutputDecoder>(Address{ 2 }, RName{ "hidden" }, m_clDecoderServices, m_clDeviceServices, params));
+
+	ASSERT_EQ(m_clIndices.GetSimpleOutputs().size(), 1);
+
+	m_clIndices.Invalidate();
+
+	ASSERT_EQ(m_clIndices.GetSimpleOutputs().size(), 2);
+	ASSERT_TRUE(Contains(m_clIndices.GetSimpleOutputs(), RName{ "hidden" }));
+}
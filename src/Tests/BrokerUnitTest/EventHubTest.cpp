@@ -10,8 +10,15 @@
 
 #include <gtest/gtest.h>
 
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <vector>
+
 #include <dcclite/Log.h>
 
+#include <fmt/format.h>
+
 #include "sys/EventHub.h"
 
 class EventTargetMockup : public dcclite::broker::sys::EventHub::IEventTarget
@@ -170,6 +177,316 @@ TEST(EventHub, CancelMultipleTargets)
 	ASSERT_EQ(called, 2);
 }
 
+template <dcclite::broker::sys::EventHub::Lanes L>
+class LaneEvent : public dcclite::broker::sys::EventHub::IEvent
+{
+	public:
+		static constexpr dcclite::broker::sys::EventHub::Lanes LANE = L;
+
+		LaneEvent(dcclite::broker::sys::EventHub::IEventTarget &target, std::vector<int> &fired, int value, size_t key = 0) :
+			IEvent{ target },
+			m_rvecFired{ fired },
+			m_iValue{ value },
+			m_uKey{ key }
+		{
+			//empty
+		}
+
+		void Fire() override
+		{
+			m_rvecFired.push_back(m_iValue);
+		}
+
+		size_t GetCoalesceKey() const noexcept override
+		{
+			return m_uKey;
+		}
+
+	private:
+		std::vector<int> &m_rvecFired;
+		int m_iValue;
+		size_t m_uKey;
+};
+
+class LaneConfigManager
+{
+	public:
+		LaneConfigManager(dcclite::broker::sys::EventHub::Lanes lane, const dcclite::broker::sys::EventHub::LaneConfig &config):
+			m_tLane{ lane },
+			m_clOriginal{ dcclite::broker::sys::EventHub::GetLaneConfig(lane) }
+		{
+			dcclite::broker::sys::EventHub::ConfigureLane(lane, config);
+		}
+
+		~LaneConfigManager()
+		{
+			dcclite::broker::sys::EventHub::ConfigureLane(m_tLane, m_clOriginal);
+		}
+
+	private:
+		dcclite::broker::sys::EventHub::Lanes m_tLane;
+		dcclite::broker::sys::EventHub::LaneConfig m_clOriginal;
+};
+
+using dcclite::broker::sys::EventHub::Lanes;
+using dcclite::broker::sys::EventHub::OverflowPolicies;
+
+TEST(EventHub, LanePriority)
+{
+	std::vector<int> fired;
+
+	EventTargetMockup t1{ "t1" };
+	dcclite::broker::sys::EventHub::PostEvent<LaneEvent<Lanes::BACKGROUND>>(std::ref(t1), std::ref(fired), 3);
+	dcclite::broker::sys::EventHub::PostEvent<LaneEvent<Lanes::TERMINAL>>(std::ref(t1), std::ref(fired), 2);
+	dcclite::broker::sys::EventHub::PostEvent<LaneEvent<Lanes::NETWORK>>(std::ref(t1), std::ref(fired), 1);
+	dcclite::broker::sys::EventHub::PostEvent<LaneEvent<Lanes::CONTROL>>(std::ref(t1), std::ref(fired), 0);
+
+	ASSERT_EQ(dcclite::broker::sys::EventHub::GetLaneStats(Lanes::NETWORK).m_uDepth, 1);
+
+	dcclite::broker::sys::EventHub::PumpEvents(dcclite::Clock::DefaultClock_t::now());
+
+	ASSERT_EQ(fired, (std::vector<int>{ 0, 1, 2, 3 }));
+	ASSERT_EQ(dcclite::broker::sys::EventHub::GetLaneStats(Lanes::NETWORK).m_uDepth, 0);
+}
+
+TEST(EventHub, DropOldest)
+{
+	LaneConfigManager configManager{ Lanes::NETWORK, { 4, OverflowPolicies::DROP_OLDEST } };
+
+	const auto before = dcclite::broker::sys::EventHub::GetLaneStats(Lanes::NETWORK);
+
+	std::vector<int> fired;
+	EventTargetMockup t1{ "t1" };
+
+	for (int i = 0; i < 10; ++i)
+		dcclite::broker::sys::EventHub::PostEvent<LaneEvent<Lanes::NETWORK>>(std::ref(t1), std::ref(fired), i);
+
+	auto stats = dcclite::broker::sys::EventHub::GetLaneStats(Lanes::NETWORK);
+	ASSERT_EQ(stats.m_uDepth, 4);
+	ASSERT_EQ(stats.m_uNumDropped - before.m_uNumDropped, 6);
+
+	dcclite::broker::sys::EventHub::PumpEvents(dcclite::Clock::DefaultClock_t::now());
+
+	ASSERT_EQ(fired, (std::vector<int>{ 6, 7, 8, 9 }));
+}
+
+TEST(EventHub, Coalesce)
+{
+	const auto before = dcclite::broker::sys::EventHub::GetLaneStats(Lanes::BACKGROUND);
+
+	std::vector<int> fired;
+	EventTargetMockup t1{ "t1" };
+	EventTargetMockup t2{ "t2" };
+
+	dcclite::broker::sys::EventHub::PostEvent<LaneEvent<Lanes::BACKGROUND>>(std::ref(t1), std::ref(fired), 0, 1);
+	dcclite::broker::sys::EventHub::PostEvent<LaneEvent<Lanes::BACKGROUND>>(std::ref(t1), std::ref(fired), 1, 2);
+	dcclite::broker::sys::EventHub::PostEvent<LaneEvent<Lanes::BACKGROUND>>(std::ref(t1), std::ref(fired), 2, 1);
+
+	//no key, never coalesced
+	dcclite::broker::sys::EventHub::PostEvent<LaneEvent<Lanes::BACKGROUND>>(std::ref(t1), std::ref(fired), 3);
+	dcclite::broker::sys::EventHub::PostEvent<LaneEvent<Lanes::BACKGROUND>>(std::ref(t1), std::ref(fired), 4);
+
+	//same key, but another target
+	dcclite::broker::sys::EventHub::PostEvent<LaneEvent<Lanes::BACKGROUND>>(std::ref(t2), std::ref(fired), 5, 1);
+
+	dcclite::broker::sys::EventHub::PostEvent<LaneEvent<Lanes::BACKGROUND>>(std::ref(t1), std::ref(fired), 6, 1);
+
+	auto stats = dcclite::broker::sys::EventHub::GetLaneStats(Lanes::BACKGROUND);
+	ASSERT_EQ(stats.m_uDepth, 5);
+	ASSERT_EQ(stats.m_uNumCoalesced - before.m_uNumCoalesced, 2);
+
+	dcclite::broker::sys::EventHub::PumpEvents(dcclite::Clock::DefaultClock_t::now());
+
+	//the newest one keeps the place of the first
+	ASSERT_EQ(fired, (std::vector<int>{ 6, 1, 3, 4, 5 }));
+}
+
+TEST(EventHub, BlockProducer)
+{
+	LaneConfigManager configManager{ Lanes::TERMINAL, { 2, OverflowPolicies::BLOCK } };
+
+	const auto before = dcclite::broker::sys::EventHub::GetLaneStats(Lanes::TERMINAL);
+
+	std::vector<int> fired;
+	EventTargetMockup t1{ "t1" };
+
+	std::thread producer{ [&]()
+	{
+		for (int i = 0; i < 3; ++i)
+			dcclite::broker::sys::EventHub::PostEvent<LaneEvent<Lanes::TERMINAL>>(std::ref(t1), std::ref(fired), i);
+	} };
+
+	//two fit, the third one waits for the pump
+	while (dcclite::broker::sys::EventHub::GetLaneStats(Lanes::TERMINAL).m_uNumBlocked == before.m_uNumBlocked)
+		std::this_thread::yield();
+
+	const auto depth = dcclite::broker::sys::EventHub::GetLaneStats(Lanes::TERMINAL).m_uDepth;
+
+	dcclite::broker::sys::EventHub::PumpEvents(dcclite::Clock::DefaultClock_t::now());
+
+	producer.join();
+
+	dcclite::broker::sys::EventHub::PumpEvents(dcclite::Clock::DefaultClock_t::now());
+
+	ASSERT_EQ(depth, 2);
+	ASSERT_EQ(fired, (std::vector<int>{ 0, 1, 2 }));
+}
+
+TEST(EventHub, PumpThreadNeverBlocks)
+{
+	LaneConfigManager configManager{ Lanes::TERMINAL, { 2, OverflowPolicies::BLOCK } };
+
+	const auto before = dcclite::broker::sys::EventHub::GetLaneStats(Lanes::TERMINAL);
+
+	std::vector<int> fired;
+	EventTargetMockup t1{ "t1" };
+
+	//like the broker thread loading services before the first pump
+	std::thread pump{ [&]()
+	{
+		dcclite::broker::sys::EventHub::SetPumpThread();
+
+		for (int i = 0; i < 3; ++i)
+			dcclite::broker::sys::EventHub::PostEvent<LaneEvent<Lanes::TERMINAL>>(std::ref(t1), std::ref(fired), i);
+	} };
+
+	pump.join();
+
+	const auto stats = dcclite::broker::sys::EventHub::GetLaneStats(Lanes::TERMINAL);
+
+	dcclite::broker::sys::EventHub::PumpEvents(dcclite::Clock::DefaultClock_t::now());
+
+	ASSERT_EQ(stats.m_uNumBlocked, before.m_uNumBlocked);
+	ASSERT_EQ(stats.m_uDepth, 3);
+	ASSERT_EQ(fired, (std::vector<int>{ 0, 1, 2 }));
+}
+
+/**
+* UDP floods from several threads while terminal, control and file watcher events keep flowing
+*/
+TEST(EventHubStress, MultipleProducers)
+{
+	constexpr int NUM_NETWORK_PRODUCERS = 3;
+	constexpr int NUM_NETWORK_EVENTS = 20000;
+	constexpr int NUM_TERMINAL_EVENTS = 2000;
+	constexpr int NUM_CONTROL_EVENTS = 200;
+	constexpr int NUM_FILE_EVENTS = 2000;
+	constexpr int NUM_FILES = 8;
+
+	dcclite::broker::sys::EventHub::LaneStats before[dcclite::broker::sys::EventHub::NUM_LANES];
+	for (size_t i = 0; i < dcclite::broker::sys::EventHub::NUM_LANES; ++i)
+		before[i] = dcclite::broker::sys::EventHub::GetLaneStats(static_cast<Lanes>(i));
+
+	EventTargetMockup target{ "stress" };
+
+	std::vector<int> network, terminal, control, files;
+
+	std::atomic<int> numRunning = NUM_NETWORK_PRODUCERS + 3;
+	std::vector<std::thread> producers;
+
+	for (int i = 0; i < NUM_NETWORK_PRODUCERS; ++i)
+	{
+		producers.emplace_back([&]()
+		{
+			for (int j = 0; j < NUM_NETWORK_EVENTS; ++j)
+				dcclite::broker::sys::EventHub::PostEvent<LaneEvent<Lanes::NETWORK>>(std::ref(target), std::ref(network), j);
+
+			--numRunning;
+		});
+	}
+
+	producers.emplace_back([&]()
+	{
+		for (int i = 0; i < NUM_TERMINAL_EVENTS; ++i)
+			dcclite::broker::sys::EventHub::PostEvent<LaneEvent<Lanes::TERMINAL>>(std::ref(target), std::ref(terminal), i);
+
+		--numRunning;
+	});
+
+	producers.emplace_back([&]()
+	{
+		for (int i = 0; i < NUM_CONTROL_EVENTS; ++i)
+		{
+			dcclite::broker::sys::EventHub::PostEvent<LaneEvent<Lanes::CONTROL>>(std::ref(target), std::ref(control), i);
+
+			std::this_thread::sleep_for(std::chrono::microseconds{ 100 });
+		}
+
+		--numRunning;
+	});
+
+	producers.emplace_back([&]()
+	{
+		//a few files being saved over and over
+		for (int i = 0; i < NUM_FILE_EVENTS; ++i)
+		{
+			dcclite::broker::sys::EventHub::PostEvent<LaneEvent<Lanes::BACKGROUND>>(std::ref(target), std::ref(files), i, (i % NUM_FILES) + 1);
+
+			std::this_thread::sleep_for(std::chrono::microseconds{ 20 });
+		}
+
+		--numRunning;
+	});
+
+	auto isEmpty = []()
+	{
+		for (size_t i = 0; i < dcclite::broker::sys::EventHub::NUM_LANES; ++i)
+		{
+			if (dcclite::broker::sys::EventHub::GetLaneStats(static_cast<Lanes>(i)).m_uDepth)
+				return false;
+		}
+
+		return true;
+	};
+
+	while (numRunning || !isEmpty())
+		dcclite::broker::sys::EventHub::PumpEvents(dcclite::Clock::DefaultClock_t::now() + std::chrono::milliseconds{ 1 });
+
+	for (auto &producer : producers)
+		producer.join();
+
+	dcclite::broker::sys::EventHub::LaneStats stats[dcclite::broker::sys::EventHub::NUM_LANES];
+	for (size_t i = 0; i < dcclite::broker::sys::EventHub::NUM_LANES; ++i)
+	{
+		stats[i] = dcclite::broker::sys::EventHub::GetLaneStats(static_cast<Lanes>(i));
+
+		stats[i].m_uNumDropped -= before[i].m_uNumDropped;
+		stats[i].m_uNumCoalesced -= before[i].m_uNumCoalesced;
+		stats[i].m_uNumBlocked -= before[i].m_uNumBlocked;
+	}
+
+	//control and terminal never lose anything and keep the order
+	ASSERT_EQ(control.size(), NUM_CONTROL_EVENTS);
+	ASSERT_TRUE(std::is_sorted(control.begin(), control.end()));
+	ASSERT_EQ(stats[static_cast<size_t>(Lanes::CONTROL)].m_uNumDropped, 0);
+
+	ASSERT_EQ(terminal.size(), NUM_TERMINAL_EVENTS);
+	ASSERT_TRUE(std::is_sorted(terminal.begin(), terminal.end()));
+	ASSERT_EQ(stats[static_cast<size_t>(Lanes::TERMINAL)].m_uNumDropped, 0);
+
+	//network is bounded and everything is accounted for
+	const auto &networkStats = stats[static_cast<size_t>(Lanes::NETWORK)];
+	ASSERT_LE(networkStats.m_uPeakDepth, dcclite::broker::sys::EventHub::GetLaneConfig(Lanes::NETWORK).m_uCapacity);
+	ASSERT_EQ(network.size() + networkStats.m_uNumDropped, NUM_NETWORK_PRODUCERS * NUM_NETWORK_EVENTS);
+
+	//the last save of each file always arrives
+	const auto &fileStats = stats[static_cast<size_t>(Lanes::BACKGROUND)];
+	ASSERT_EQ(files.size() + fileStats.m_uNumCoalesced + fileStats.m_uNumDropped, NUM_FILE_EVENTS);
+	ASSERT_EQ(fileStats.m_uNumDropped, 0);
+
+	for (int i = NUM_FILE_EVENTS - NUM_FILES; i < NUM_FILE_EVENTS; ++i)
+		ASSERT_NE(std::find(files.begin(), files.end(), i), files.end());
+
+	const char *names[] = { "control", "network", "terminal", "background" };
+	for (size_t i = 0; i < dcclite::broker::sys::EventHub::NUM_LANES; ++i)
+	{
+		RecordProperty(fmt::format("{}_peak_depth", names[i]), static_cast<int>(stats[i].m_uPeakDepth));
+		RecordProperty(fmt::format("{}_dropped", names[i]), static_cast<int>(stats[i].m_uNumDropped));
+		RecordProperty(fmt::format("{}_coalesced", names[i]), static_cast<int>(stats[i].m_uNumCoalesced));
+		RecordProperty(fmt::format("{}_blocked", names[i]), static_cast<int>(stats[i].m_uNumBlocked));
+	}
+}
+
 class EventDropManager
 {
 	public:
@@ -212,6 +529,9 @@ TEST(EventHub, BadAlloc)
 		//memory is free
 		dcclite::broker::sys::EventHub::PostEvent<MyTestEvent>(std::ref(t1), [&called] { ++called;  });
 
+		//do not leave it for the next tests, it points to our stack
+		dcclite::broker::sys::EventHub::CancelEvents(t1);
+
 		return;
 	}
 
@@ -0,0 +1,435 @@
+// Copyright (C) 2019 - Bruno Sanches. See the COPYRIGHT
+// file at the top-level directory of this distribution.
+//
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+//
+// This Source Code Form is "Incompatible With Secondary Licenses", as
+// defined by the Mozilla Public License, v. 2.0.
+
+#include <gtest/gtest.h>
+
+#include <map>
+#include <memory>
+#include <random>
+
+#include <fmt/format.h>
+#include <rapidjson/document.h>
+#include <spdlog/spdlog.h>
+
+#include "../TestsCommon/BrokerMockups.h"
+#include "exec/dcc/SignalDecoder.h"
+#include "exec/dcc/SimpleOutputDecoder.h"
+#include "exec/dcc/VirtualSensorDecoder.h"
+#include "shell/dispatcher/Interlocking.h"
+
+using namespace dcclite::broker::exec::dcc;
+using dcclite::broker::shell::dispatcher::Interlocking;
+using dcclite::DecoderStates;
+using dcclite::RName;
+using dcclite::SignalAspects;
+
+namespace
+{
+	/**
+	* Finds decoders by name (signals need it for the heads) and forwards state changes to the interlocking, like the
+	* DispatcherService does with DccLiteService events
+	*/
+	class InterlockingServicesMockup: public IDccLite_DecoderServices
+	{
+		public:
+			void Decoder_OnStateChanged(Decoder &decoder) override
+			{
+				if (m_pclInterlocking)
+					m_pclInterlocking->OnDecoderStateChanged(decoder);
+			}
+
+			Decoder *TryFindDecoder(RName id) const override
+			{
+				auto it = m_mapDecoders.find(id);
+
+				return it == m_mapDecoders.end() ? nullptr : it->second.get();
+			}
+
+			template <typename T>
+			T &Create(std::string_view name, const char *json)
+			{
+				rapidjson::Document params;
+				params.Parse(json);
+
+				auto decoder = std::make_unique<T>(Address{ static_cast<uint16_t>(m_mapDecoders.size()) }, RName{ name }, *this, m_clDevice, params);
+				auto &ref = *decoder;
+
+				m_mapDecoders.emplace(RName{ name }, std::move(decoder));
+
+				return ref;
+			}
+
+			OutputDecoder &CreateTurnout(std::string_view name)
+			{
+				return this->Create<SimpleOutputDecoder>(name, R"JSON({"class": "Output", "pin": 13})JSON");
+			}
+
+			VirtualSensorDecoder &CreateSensor(std::string_view name)
+			{
+				return this->Create<VirtualSensorDecoder>(name, R"JSON({"class": "VirtualSensor"})JSON");
+			}
+
+			SignalDecoder &CreateSignal(std::string_view name)
+			{
+				this->CreateTurnout(fmt::format("{}_red", name));
+				this->CreateTurnout(fmt::format("{}_green", name));
+
+				auto json = fmt::format(
+					R"JSON({{
+						"class": "VirtualSignal",
+						"heads": {{ "red": "{0}_red", "green": "{0}_green" }},
+						"aspects": [ {{ "name": "Clear", "on": ["green"] }}, {{ "name": "Stop", "on": ["red"] }} ]
+					}})JSON",
+					name
+				);
+
+				return this->Create<SignalDecoder>(name, json.c_str());
+			}
+
+			template <typename T>
+			T &Get(std::string_view name)
+			{
+				return static_cast<T &>(*this->TryFindDecoder(RName{ name }));
+			}
+
+			std::unique_ptr<Interlocking> CreateInterlocking(const char *json)
+			{
+				rapidjson::Document routes;
+				routes.Parse(json);
+
+				auto interlocking = std::make_unique<Interlocking>(
+					RName{ "interlocking" },
+					routes,
+					[this](RName name) { return this->TryFindDecoder(name); }
+				);
+
+				m_pclInterlocking = interlocking.get();
+
+				return interlocking;
+			}
+
+			void Destroy(std::string_view name)
+			{
+				auto it = m_mapDecoders.find(RName{ name });
+
+				if (m_pclInterlocking)
+					m_pclInterlocking->OnDecoderDestroyed(*it->second);
+
+				m_mapDecoders.erase(it);
+			}
+
+			Interlocking *m_pclInterlocking = nullptr;
+
+		private:
+			DeviceDecoderServicesMockup m_clDevice;
+
+			std::map<RName, std::unique_ptr<Decoder>> m_mapDecoders;
+	};
+
+	class InterlockingTest: public testing::Test
+	{
+		public:
+			InterlockingTest()
+			{
+				for (auto name : { "T1", "T2", "T3" })
+					m_clServices.CreateTurnout(name);
+
+				for (auto name : { "S1", "S2", "S3" })
+					m_clServices.CreateSensor(name);
+
+				for (auto name : { "SIG1", "SIG2", "SIG3" })
+					m_clServices.CreateSignal(name);
+			}
+
+			~InterlockingTest()
+			{
+				m_clServices.m_pclInterlocking = nullptr;
+			}
+
+		protected:
+			//the device answered, so the remote state matches what was asked
+			void SyncTurnout(std::string_view name)
+			{
+				auto &turnout = m_clServices.Get<OutputDecoder>(name);
+
+				turnout.SyncRemoteState(turnout.GetRequestedState());
+			}
+
+			SignalAspects GetAspect(std::string_view signal)
+			{
+				return m_clServices.Get<SignalDecoder>(signal).GetAspect();
+			}
+
+		protected:
+			InterlockingServicesMockup m_clServices;
+	};
+
+	const char *g_pszRoutes = R"JSON([
+		{
+			"name": "R1",
+			"signal": "SIG1",
+			"aspect": "Clear",
+			"turnouts": [ { "name": "T1", "position": "thrown" }, { "name": "T2", "position": "closed" } ],
+			"sensors": [ "S1" ]
+		},
+		{
+			"name": "R2",
+			"signal": "SIG2",
+			"turnouts": [ { "name": "T2", "position": "thrown" } ],
+			"sensors": [ "S2" ]
+		},
+		{
+			"name": "R3",
+			"signal": "SIG3",
+			"turnouts": [ { "name": "T3", "position": "thrown" } ],
+			"sensors": [ "S3" ],
+			"conflicts": [ "R1" ]
+		}
+	])JSON";
+}
+
+TEST_F(InterlockingTest, SetRoute)
+{
+	auto interlocking = m_clServices.CreateInterlocking(g_pszRoutes);
+
+	ASSERT_EQ(interlocking->GetNumRoutes(), 3);
+
+	ASSERT_TRUE(interlocking->SetRoute(RName{ "R1" }));
+	ASSERT_TRUE(interlocking->IsRouteSet(RName{ "R1" }));
+
+	auto &t1 = m_clServices.Get<OutputDecoder>("T1");
+
+	ASSERT_EQ(t1.GetRequestedState(), DecoderStates::ACTIVE);
+	ASSERT_EQ(t1.GetLockOwner(), RName{ "R1" });
+
+	//nobody else can move it
+	ASSERT_FALSE(t1.SetState(DecoderStates::INACTIVE, "someone"));
+	ASSERT_EQ(t1.GetRequestedState(), DecoderStates::ACTIVE);
+
+	//not there yet
+	ASSERT_FALSE(interlocking->IsRouteClear(RName{ "R1" }));
+	ASSERT_EQ(GetAspect("SIG1"), SignalAspects::Stop);
+
+	SyncTurnout("T1");
+
+	ASSERT_TRUE(interlocking->IsRouteClear(RName{ "R1" }));
+	ASSERT_EQ(GetAspect("SIG1"), SignalAspects::Clear);
+
+	//train entered the route
+	m_clServices.Get<VirtualSensorDecoder>("S1").SetSensorState(DecoderStates::ACTIVE);
+	ASSERT_EQ(GetAspect("SIG1"), SignalAspects::Stop);
+
+	m_clServices.Get<VirtualSensorDecoder>("S1").SetSensorState(DecoderStates::INACTIVE);
+	ASSERT_EQ(GetAspect("SIG1"), SignalAspects::Clear);
+
+	ASSERT_TRUE(interlocking->CancelRoute(RName{ "R1" }));
+	ASSERT_FALSE(interlocking->IsRouteSet(RName{ "R1" }));
+	ASSERT_FALSE(interlocking->CancelRoute(RName{ "R1" }));
+
+	ASSERT_EQ(GetAspect("SIG1"), SignalAspects::Stop);
+	ASSERT_FALSE(t1.IsLocked());
+	ASSERT_TRUE(t1.SetState(DecoderStates::INACTIVE, "someone"));
+}
+
+TEST_F(InterlockingTest, Conflicts)
+{
+	auto interlocking = m_clServices.CreateInterlocking(g_pszRoutes);
+
+	ASSERT_TRUE(interlocking->SetRoute(RName{ "R1" }));
+
+	//shares T2
+	ASSERT_FALSE(interlocking->SetRoute(RName{ "R2" }));
+
+	//declared conflict
+	ASSERT_FALSE(interlocking->SetRoute(RName{ "R3" }));
+
+	ASSERT_EQ(m_clServices.Get<OutputDecoder>("T2").GetLockOwner(), RName{ "R1" });
+
+	interlocking->CancelRoute(RName{ "R1" });
+
+	ASSERT_TRUE(interlocking->SetRoute(RName{ "R2" }));
+	ASSERT_TRUE(interlocking->SetRoute(RName{ "R3" }));
+
+	ASSERT_EQ(m_clServices.Get<OutputDecoder>("T2").GetRequestedState(), DecoderStates::ACTIVE);
+	ASSERT_EQ(m_clServices.Get<OutputDecoder>("T2").GetLockOwner(), RName{ "R2" });
+}
+
+TEST_F(InterlockingTest, Occupied)
+{
+	auto interlocking = m_clServices.CreateInterlocking(g_pszRoutes);
+
+	m_clServices.Get<VirtualSensorDecoder>("S2").SetSensorState(DecoderStates::ACTIVE);
+
+	ASSERT_FALSE(interlocking->SetRoute(RName{ "R2" }));
+	ASSERT_FALSE(m_clServices.Get<OutputDecoder>("T2").IsLocked());
+
+	ASSERT_FALSE(interlocking->SetRoute(RName{ "unknown" }));
+}
+
+TEST_F(InterlockingTest, DecoderDestroyed)
+{
+	auto interlocking = m_clServices.CreateInterlocking(g_pszRoutes);
+
+	ASSERT_TRUE(interlocking->SetRoute(RName{ "R1" }));
+
+	m_clServices.Destroy("S1");
+
+	ASSERT_FALSE(interlocking->IsRouteSet(RName{ "R1" }));
+	ASSERT_FALSE(m_clServices.Get<OutputDecoder>("T1").IsLocked());
+
+	ASSERT_FALSE(interlocking->SetRoute(RName{ "R1" }));
+
+	//back again
+	interlocking->OnDecoderCreated(m_clServices.CreateSensor("S1"));
+
+	ASSERT_TRUE(interlocking->SetRoute(RName{ "R1" }));
+}
+
+TEST_F(InterlockingTest, BadConfig)
+{
+	ASSERT_THROW(m_clServices.CreateInterlocking(R"JSON([{ "name": "R1", "sensors": ["missing"] }])JSON"), std::invalid_argument);
+
+	//sensor used as turnout
+	ASSERT_THROW(m_clServices.CreateInterlocking(R"JSON([{ "name": "R1", "turnouts": [ { "name": "S1", "position": "closed" } ] }])JSON"), std::invalid_argument);
+
+	ASSERT_THROW(m_clServices.CreateInterlocking(R"JSON([{ "name": "R1", "turnouts": [ { "name": "T1", "position": "sideways" } ] }])JSON"), std::invalid_argument);
+
+	ASSERT_THROW(m_clServices.CreateInterlocking(R"JSON([{ "name": "R1", "conflicts": [ "R9" ] }])JSON"), std::invalid_argument);
+
+	ASSERT_THROW(m_clServices.CreateInterlocking(R"JSON([{ "name": "R1" }, { "name": "R1" }])JSON"), std::invalid_argument);
+}
+
+/**
+* A big yard, hundreds of routes and a random stream of sensor and turnout changes.
+*
+* Incremental only evaluates the set routes using the changed decoder, full evaluates all set routes on every change, like
+* polling scripts do. Both must agree on every route, and incremental must do a fraction of the work.
+*/
+TEST(InterlockingStress, StateChanges)
+{
+	constexpr unsigned NUM_TURNOUTS = 600;
+	constexpr unsigned NUM_SENSORS = 900;
+	constexpr unsigned NUM_ROUTES = 400;
+	constexpr unsigned NUM_CHANGES = 50000;
+
+	const auto logLevel = spdlog::get_level();
+	spdlog::set_level(spdlog::level::warn);
+
+	InterlockingServicesMockup services;
+
+	std::vector<OutputDecoder *> turnouts;
+	std::vector<VirtualSensorDecoder *> sensors;
+
+	for (unsigned i = 0; i < NUM_TURNOUTS; ++i)
+		turnouts.push_back(&services.CreateTurnout(fmt::format("bench_t{}", i)));
+
+	for (unsigned i = 0; i < NUM_SENSORS; ++i)
+		sensors.push_back(&services.CreateSensor(fmt::format("bench_s{}", i)));
+
+	std::mt19937 rng{ 42 };
+
+	//each route uses a small neighbourhood, so most routes do not conflict with each other
+	std::string json = "[";
+	for (unsigned i = 0; i < NUM_ROUTES; ++i)
+	{
+		services.CreateSignal(fmt::format("bench_sig{}", i));
+
+		const auto turnout = (i * 3) % (NUM_TURNOUTS - 2);
+		const auto sensor = (i * 2) % (NUM_SENSORS - 3);
+
+		json += fmt::format(
+			R"JSON({}{{
+				"name": "bench_r{}",
+				"signal": "bench_sig{}",
+				"turnouts": [ {{ "name": "bench_t{}", "position": "thrown" }}, {{ "name": "bench_t{}", "position": "closed" }} ],
+				"sensors": [ "bench_s{}", "bench_s{}", "bench_s{}" ]
+			}})JSON",
+			i ? "," : "",
+			i, i, turnout, turnout + 1, sensor, sensor + 1, sensor + 2
+		);
+	}
+	json += "]";
+
+	auto interlocking = services.CreateInterlocking(json.c_str());
+
+	unsigned numSetRoutes = 0;
+	for (unsigned i = 0; i < NUM_ROUTES; ++i)
+		numSetRoutes += interlocking->SetRoute(RName{ fmt::format("bench_r{}", i) });
+
+	ASSERT_GT(numSetRoutes, NUM_ROUTES / 4);
+
+	for (auto turnout : turnouts)
+		turnout->SyncRemoteState(turnout->GetRequestedState());
+
+	//same random stream for both runs
+	std::vector<unsigned> changes;
+	for (unsigned i = 0; i < NUM_CHANGES; ++i)
+		changes.push_back(rng() % (NUM_TURNOUTS + NUM_SENSORS));
+
+	auto applyChange = [&](const unsigned change)
+	{
+		if (change < NUM_TURNOUTS)
+		{
+			//device glitch or manual throw on the panel, reported back by the device
+			auto turnout = turnouts[change];
+			turnout->SyncRemoteState(!turnout->GetState());
+		}
+		else
+		{
+			auto sensor = sensors[change - NUM_TURNOUTS];
+			sensor->SetSensorState(!sensor->GetState());
+		}
+	};
+
+	auto evaluations = interlocking->GetNumEvaluations();
+
+	for (auto change : changes)
+		applyChange(change);
+
+	const auto incrementalEvaluations = interlocking->GetNumEvaluations() - evaluations;
+
+	//every set route must match its decoders
+	auto checkRoutes = [&]()
+	{
+		for (unsigned i = 0; i < NUM_ROUTES; ++i)
+		{
+			const auto t = (i * 3) % (NUM_TURNOUTS - 2);
+			const auto s = (i * 2) % (NUM_SENSORS - 3);
+
+			const bool expected = interlocking->IsRouteSet(RName{ fmt::format("bench_r{}", i) }) &&
+				(turnouts[t]->GetState() == DecoderStates::ACTIVE) && (turnouts[t + 1]->GetState() == DecoderStates::INACTIVE) &&
+				(sensors[s]->GetState() == DecoderStates::INACTIVE) && (sensors[s + 1]->GetState() == DecoderStates::INACTIVE) && (sensors[s + 2]->GetState() == DecoderStates::INACTIVE);
+
+			ASSERT_EQ(interlocking->IsRouteClear(RName{ fmt::format("bench_r{}", i) }), expected) << "route " << i;
+		}
+	};
+
+	checkRoutes();
+
+	//now without the incremental path, everything on every change
+	services.m_pclInterlocking = nullptr;
+	evaluations = interlocking->GetNumEvaluations();
+
+	for (auto change : changes)
+	{
+		applyChange(change);
+		interlocking->EvaluateAllRoutes();
+	}
+
+	const auto fullEvaluations = interlocking->GetNumEvaluations() - evaluations;
+
+	checkRoutes();
+
+	services.m_pclInterlocking = interlocking.get();
+
+	spdlog::set_level(logLevel);
+
+	ASSERT_LT(incrementalEvaluations * 10, fullEvaluations);
+}
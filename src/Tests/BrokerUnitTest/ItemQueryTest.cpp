@@ -0,0 +1,197 @@
+// Copyright (C) 2019 - Bruno Sanches. See the COPYRIGHT
+// file at the top-level directory of this distribution.
+//
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+//
+// This Source Code Form is "Incompatible With Secondary Licenses", as
+// defined by the Mozilla Public License, v. 2.0.
+
+#include <gtest/gtest.h>
+
+#include <memory>
+
+#include <fmt/format.h>
+#include <rapidjson/document.h>
+#include <spdlog/spdlog.h>
+
+#include <dcclite/FolderObject.h>
+
+#include "../TestsCommon/BrokerMockups.h"
+#include "exec/dcc/ItemQuery.h"
+#include "exec/dcc/SensorDecoder.h"
+#include "exec/dcc/SimpleOutputDecoder.h"
+
+using namespace dcclite;
+using namespace dcclite::broker::exec::dcc;
+
+namespace
+{
+	class NamedDeviceMockup: public DeviceDecoderServicesMockup
+	{
+		public:
+			explicit NamedDeviceMockup(RName name):
+				m_rnName{ name }
+			{
+				//empty
+			}
+
+			RName GetDeviceName() const noexcept override
+			{
+				return m_rnName;
+			}
+
+		private:
+			RName m_rnName;
+	};
+
+	/**
+	* 20 devices, each with 50 outputs and 50 sensors
+	*
+	* Sensors: every 4th is active
+	* Outputs: every 3rd was requested to be active, every 6th is also active on the device, so the others are pending
+	*/
+	class ItemQueryTest: public testing::Test
+	{
+		public:
+			static constexpr unsigned NUM_DEVICES = 20;
+			static constexpr unsigned NUM_DECODERS_PER_KIND = 50;
+
+			ItemQueryTest():
+				m_clRoot{ RName{ "root" } }
+			{
+				auto decoders = static_cast<FolderObject *>(m_clRoot.AddChild(std::make_unique<FolderObject>(RName{ "decoders" })));
+
+				rapidjson::Document outputParams;
+				outputParams.Parse(R"JSON({"class": "Output", "pin": 13})JSON");
+
+				rapidjson::Document sensorParams;
+				sensorParams.Parse(R"JSON({"class": "Sensor", "pin": 12})JSON");
+
+				//state changes are logged, keep the output clean
+				const auto logLevel = spdlog::get_level();
+				spdlog::set_level(spdlog::level::warn);
+
+				for (unsigned i = 0; i < NUM_DEVICES; ++i)
+				{
+					m_vecDevices.push_back(std::make_unique<NamedDeviceMockup>(RName{ fmt::format("device_{}", i) }));
+					auto &device = *m_vecDevices.back();
+
+					for (unsigned j = 0; j < NUM_DECODERS_PER_KIND; ++j)
+					{
+						const auto address = static_cast<uint16_t>((i * NUM_DECODERS_PER_KIND + j) * 2);
+
+						auto output = static_cast<SimpleOutputDecoder *>(decoders->AddChild(std::make_unique<SimpleOutputDecoder>(
+							Address{ address },
+							RName{ fmt::format("output_{}_{}", i, j) },
+							m_clDecoderServices,
+							device,
+							outputParams
+						)));
+
+						if (j % 3 == 0)
+							output->SetState(DecoderStates::ACTIVE, "test");
+
+						if (j % 6 == 0)
+							output->SyncRemoteState(DecoderStates::ACTIVE);
+
+						auto sensor = static_cast<SensorDecoder *>(decoders->AddChild(std::make_unique<SensorDecoder>(
+							Address{ static_cast<uint16_t>(address + 1) },
+							RName{ fmt::format("sensor_{}_{}", i, j) },
+							m_clDecoderServices,
+							device,
+							sensorParams
+						)));
+
+						if (j % 4 == 0)
+							sensor->SyncRemoteState(DecoderStates::ACTIVE);
+					}
+				}
+
+				spdlog::set_level(logLevel);
+			}
+
+		protected:
+			size_t Count(std::string_view queryString) const
+			{
+				auto query = ItemQuery::Parse(queryString);
+
+				size_t count = 0;
+				query.Run(m_clRoot, [&count](const IObject &) { ++count; return true; });
+
+				return count;
+			}
+
+		protected:
+			DecoderServicesMockup								m_clDecoderServices;
+			std::vector<std::unique_ptr<NamedDeviceMockup>>	m_vecDevices;
+
+			FolderObject										m_clRoot;
+	};
+}
+
+TEST(ItemQuery, GlobMatch)
+{
+	ASSERT_TRUE(GlobMatch("*", ""));
+	ASSERT_TRUE(GlobMatch("*Turnout*", "ServoTurnoutDecoder"));
+	ASSERT_FALSE(GlobMatch("*Turnout", "ServoTurnoutDecoder"));
+	ASSERT_TRUE(GlobMatch("t?rn*_1", "turnout_1"));
+	ASSERT_FALSE(GlobMatch("t?rn*_1", "turnout_12"));
+	ASSERT_TRUE(GlobMatch("/DCCLite/*/yard_*", "/DCCLite/decoders/yard_3"));
+	ASSERT_FALSE(GlobMatch("ab", "abc"));
+}
+
+TEST(ItemQuery, Parse)
+{
+	ASSERT_NO_THROW(ItemQuery::Parse("type=SensorDecoder"));
+	ASSERT_NO_THROW(ItemQuery::Parse("  input   state=active !broken "));
+	ASSERT_NO_THROW(ItemQuery::Parse("!turnout device=yard path=/DCCLite/*"));
+
+	ASSERT_THROW(ItemQuery::Parse(""), std::invalid_argument);
+	ASSERT_THROW(ItemQuery::Parse("   "), std::invalid_argument);
+	ASSERT_THROW(ItemQuery::Parse("color=red"), std::invalid_argument);
+	ASSERT_THROW(ItemQuery::Parse("locked"), std::invalid_argument);
+	ASSERT_THROW(ItemQuery::Parse("type="), std::invalid_argument);
+	ASSERT_THROW(ItemQuery::Parse("state=thrown"), std::invalid_argument);
+	ASSERT_THROW(ItemQuery::Parse("name=a name=b"), std::invalid_argument);
+	ASSERT_THROW(ItemQuery::Parse("input output"), std::invalid_argument);
+}
+
+TEST_F(ItemQueryTest, Terms)
+{
+	constexpr size_t NUM_PER_KIND = NUM_DEVICES * NUM_DECODERS_PER_KIND;
+
+	//the decoders folder itself is not a sensor
+	ASSERT_EQ(Count("type=SensorDecoder"), NUM_PER_KIND);
+	ASSERT_EQ(Count("input"), NUM_PER_KIND);
+	ASSERT_EQ(Count("output"), NUM_PER_KIND);
+	ASSERT_EQ(Count("turnout"), 0u);
+	ASSERT_EQ(Count("!turnout"), NUM_PER_KIND * 2);
+
+	ASSERT_EQ(Count("name=sensor_3_*"), NUM_DECODERS_PER_KIND);
+	ASSERT_EQ(Count("path=/decoders/output_1?_1"), 10u);
+	ASSERT_EQ(Count("!type=*Decoder"), 1u);
+
+	//50 / 4, rounded up
+	ASSERT_EQ(Count("input state=active"), NUM_DEVICES * 13);
+	ASSERT_EQ(Count("input !state=active"), NUM_DEVICES * (NUM_DECODERS_PER_KIND - 13));
+
+	ASSERT_EQ(Count("output state=active"), NUM_DEVICES * 9);
+	ASSERT_EQ(Count("output pending"), NUM_DEVICES * (17 - 9));
+	ASSERT_EQ(Count("pending"), NUM_DEVICES * (17 - 9));
+
+	ASSERT_EQ(Count("input device=device_7 state=active"), 13u);
+	ASSERT_EQ(Count("device=device_1*"), (NUM_DECODERS_PER_KIND * 2) * 11);
+	ASSERT_EQ(Count("broken"), 0u);
+}
+
+TEST_F(ItemQueryTest, StopsWhenVisitorReturnsFalse)
+{
+	auto query = ItemQuery::Parse("input");
+
+	size_t count = 0;
+	query.Run(m_clRoot, [&count](const IObject &) { return ++count < 5; });
+
+	ASSERT_EQ(count, 5u);
+}
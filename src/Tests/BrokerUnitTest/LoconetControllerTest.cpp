@@ -0,0 +1,239 @@
+// Copyright (C) 2019 - Bruno Sanches. See the COPYRIGHT
+// file at the top-level directory of this distribution.
+//
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+//
+// This Source Code Form is "Incompatible With Secondary Licenses", as
+// defined by the Mozilla Public License, v. 2.0.
+
+#include <gtest/gtest.h>
+
+#include <vector>
+
+#include <dcclite/Clock.h>
+
+#include "shell/ln/ILoconetSlot.h"
+#include "shell/ln/LoconetController.h"
+#include "shell/ln/LoconetTransmitQueue.h"
+#include "shell/ln/ThrottleService.h"
+
+using namespace dcclite;
+using namespace dcclite::broker::shell::ln;
+
+static constexpr uint8_t OPC_MOVE_SLOTS = 0xBA;
+static constexpr uint8_t OPC_LOCO_ADR = 0xBF;
+static constexpr uint8_t OPC_SL_RD_DATA = 0xE7;
+
+namespace
+{
+	class ThrottleMockup: public IThrottle
+	{
+		public:
+			void OnSpeedChange() override
+			{
+				//empty
+			}
+
+			void OnForwardChange() override
+			{
+				//empty
+			}
+
+			void OnFunctionChange(const uint8_t begin, const uint8_t end) override
+			{
+				//empty
+			}
+
+			void OnEmergencyStop() override
+			{
+				//empty
+			}
+
+			void AddSlave(const ILoconetSlot &slot) override
+			{
+				//empty
+			}
+
+			void RemoveSlave(const ILoconetSlot &slot) override
+			{
+				//empty
+			}
+
+			bool HasSlaves() const noexcept override
+			{
+				return false;
+			}
+	};
+
+	class ThrottleProviderMockup: public IThrottleProvider
+	{
+		public:
+			IThrottle &CreateThrottle(const ILoconetSlot &owner) override
+			{
+				++m_iNumThrottles;
+
+				return m_clThrottle;
+			}
+
+			void ReleaseThrottle(IThrottle &throttle) override
+			{
+				--m_iNumThrottles;
+			}
+
+			int m_iNumThrottles = 0;
+
+		private:
+			ThrottleMockup m_clThrottle;
+	};
+
+	std::vector<uint8_t> MakeMessage(std::vector<uint8_t> data)
+	{
+		uint8_t checksum = 0xFF;
+		for (auto b : data)
+			checksum ^= b;
+
+		data.push_back(checksum);
+
+		return data;
+	}
+
+	std::vector<uint8_t> MakeLocoAdr(const uint16_t address)
+	{
+		return MakeMessage({ OPC_LOCO_ADR, static_cast<uint8_t>(address >> 7), static_cast<uint8_t>(address & 0x7F) });
+	}
+
+	std::vector<uint8_t> MakeNullMove(const uint8_t slot)
+	{
+		return MakeMessage({ OPC_MOVE_SLOTS, slot, slot });
+	}
+
+	class ControllerTester
+	{
+		public:
+			ControllerTester():
+				m_clController{ m_clThrottles, m_clQueue, [this](uint8_t slot) { ++m_uNumSlotChanges; } }
+			{
+				//empty
+			}
+
+			unsigned Receive(const std::vector<uint8_t> &data)
+			{
+				return m_clController.ReceiveData(data.data(), static_cast<unsigned>(data.size()), Clock::DefaultClock_t::now());
+			}
+
+			ThrottleProviderMockup m_clThrottles;
+			LoconetTransmitQueue m_clQueue;
+			LoconetController m_clController;
+
+			unsigned m_uNumSlotChanges = 0;
+	};
+}
+
+TEST(LoconetController, AcquireLocomotive)
+{
+	ControllerTester tester;
+
+	ASSERT_EQ(tester.Receive(MakeLocoAdr(3)), 1);
+	ASSERT_EQ(tester.m_clQueue.GetSize(), 1);
+	ASSERT_EQ(tester.m_uNumSlotChanges, 1);
+
+	//same address, same slot (no new one is taken)
+	ASSERT_EQ(tester.Receive(MakeLocoAdr(3)), 1);
+	ASSERT_EQ(tester.Receive(MakeLocoAdr(1234)), 1);
+	ASSERT_EQ(tester.m_clQueue.GetSize(), 3);
+
+	ASSERT_EQ(tester.m_clThrottles.m_iNumThrottles, 0);
+
+	//slot 1 is loco 3, take it
+	ASSERT_EQ(tester.Receive(MakeNullMove(1)), 1);
+	ASSERT_EQ(tester.m_clThrottles.m_iNumThrottles, 1);
+
+	//free it
+	ASSERT_EQ(tester.Receive(MakeMessage({ OPC_MOVE_SLOTS, 1, 0 })), 1);
+	ASSERT_EQ(tester.m_clThrottles.m_iNumThrottles, 0);
+
+	ASSERT_EQ(tester.m_clController.GetNumMessages(), 5);
+	ASSERT_EQ(tester.m_clController.GetNumErrors(), 0);
+}
+
+TEST(LoconetController, SplitMessages)
+{
+	ControllerTester tester;
+
+	auto data = MakeLocoAdr(3);
+	auto nullMove = MakeNullMove(1);
+	data.insert(data.end(), nullMove.begin(), nullMove.end());
+
+	//one byte at a time, like a slow port
+	unsigned numMessages = 0;
+	for (auto b : data)
+		numMessages += tester.Receive({ b });
+
+	ASSERT_EQ(numMessages, 2);
+	ASSERT_EQ(tester.m_clThrottles.m_iNumThrottles, 1);
+
+	//a variable size message split before its size byte
+	auto slotRead = MakeMessage({ OPC_SL_RD_DATA, 0x0E, 1, 0, 3, 0, 0, 0, 0, 0, 0, 0, 0 });
+	ASSERT_EQ(slotRead.size(), 0x0E);
+
+	ASSERT_EQ(tester.Receive({ slotRead.begin(), slotRead.begin() + 1 }), 0);
+	ASSERT_EQ(tester.Receive({ slotRead.begin() + 1, slotRead.begin() + 5 }), 0);
+	ASSERT_EQ(tester.Receive({ slotRead.begin() + 5, slotRead.end() }), 1);
+
+	ASSERT_EQ(tester.m_clController.GetNumMessages(), 3);
+	ASSERT_EQ(tester.m_clController.GetNumErrors(), 0);
+}
+
+TEST(LoconetController, ChecksumErrorThenData)
+{
+	ControllerTester tester;
+
+	ASSERT_EQ(tester.Receive(MakeLocoAdr(3)), 1);
+
+	//bad checksum followed by a good message on the same read, only the bad one is dropped
+	auto data = MakeLocoAdr(5);
+	data.back() ^= 0x01;
+
+	auto good = MakeLocoAdr(6);
+	data.insert(data.end(), good.begin(), good.end());
+
+	ASSERT_EQ(tester.Receive(data), 1);
+	ASSERT_EQ(tester.m_clController.GetNumErrors(), 1);
+
+	//garbage before an opcode is skipped
+	data = { 0x12, 0x34 };
+	data.insert(data.end(), good.begin(), good.end());
+
+	ASSERT_EQ(tester.Receive(data), 1);
+	ASSERT_EQ(tester.m_clController.GetNumErrors(), 2);
+
+	//and we are back on track on the next reads
+	ASSERT_EQ(tester.Receive(MakeLocoAdr(7)), 1);
+	ASSERT_EQ(tester.m_clController.GetNumMessages(), 4);
+	ASSERT_EQ(tester.m_clQueue.GetSize(), 4);
+}
+
+TEST(LoconetController, LostSizeByte)
+{
+	ControllerTester tester;
+
+	//a variable size opcode followed by the next opcode, its size byte was lost
+	std::vector<uint8_t> data{ OPC_SL_RD_DATA };
+
+	auto good = MakeLocoAdr(3);
+	data.insert(data.end(), good.begin(), good.end());
+
+	//the good message is handled now, not after 0xBF more bytes arrive
+	ASSERT_EQ(tester.Receive(data), 1);
+	ASSERT_EQ(tester.m_clController.GetNumErrors(), 1);
+
+	//size too small
+	data = { OPC_SL_RD_DATA, 1 };
+	data.insert(data.end(), good.begin(), good.end());
+
+	ASSERT_EQ(tester.Receive(data), 1);
+	ASSERT_EQ(tester.m_clController.GetNumErrors(), 2);
+	ASSERT_EQ(tester.m_clController.GetNumMessages(), 2);
+}
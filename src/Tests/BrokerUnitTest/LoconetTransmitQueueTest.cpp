@@ -0,0 +1,381 @@
+// Copyright (C) 2019 - Bruno Sanches. See the COPYRIGHT
+// file at the top-level directory of this distribution.
+//
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+//
+// This Source Code Form is "Incompatible With Secondary Licenses", as
+// defined by the Mozilla Public License, v. 2.0.
+
+#include <gtest/gtest.h>
+
+#ifndef WIN32
+#include <fcntl.h>
+#include <poll.h>
+#include <stdlib.h>
+#include <unistd.h>
+#endif
+
+#include <map>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include <dcclite/SerialPort.h>
+
+#include "shell/ln/LoconetTransmitQueue.h"
+#include "sys/Timeouts.h"
+
+using namespace dcclite;
+using namespace dcclite::broker;
+using namespace std::chrono_literals;
+
+using shell::ln::LoconetTransmitQueue;
+
+static constexpr uint8_t OPC_LOCO_SPD = 0xA0;
+static constexpr uint8_t OPC_LOCO_DIRF = 0xA1;
+static constexpr uint8_t OPC_SL_RD_DATA = 0xE7;
+
+namespace
+{
+	/**
+	* Stands in for the serial port, keeps everything the queue sends
+	*/
+	class BusRecorder
+	{
+		public:
+			unsigned Pump(LoconetTransmitQueue &queue, const Clock::TimePoint_t now, const Clock::DefaultClock_t::duration window)
+			{
+				SerialPort::DataPacket packet;
+
+				const auto numMessages = queue.Fill(packet, now, window);
+
+				m_vecData.insert(m_vecData.end(), packet.GetData(), packet.GetData() + packet.GetDataSize());
+
+				return numMessages;
+			}
+
+			std::vector<uint8_t> ReadAll()
+			{
+				return std::exchange(m_vecData, {});
+			}
+
+		private:
+			std::vector<uint8_t> m_vecData;
+	};
+
+#ifndef WIN32
+	/**
+	* The master side plays the PR3, the slave is opened by SerialPort like a real device
+	*/
+	class PtyPair
+	{
+		public:
+			PtyPair()
+			{
+				m_iMaster = posix_openpt(O_RDWR | O_NOCTTY);
+				if (m_iMaster < 0)
+					throw std::runtime_error("[PtyPair] posix_openpt failed");
+
+				if (grantpt(m_iMaster) || unlockpt(m_iMaster))
+				{
+					close(m_iMaster);
+
+					throw std::runtime_error("[PtyPair] cannot unlock pty");
+				}
+
+				m_strSlaveName = ptsname(m_iMaster);
+
+				fcntl(m_iMaster, F_SETFL, O_NONBLOCK);
+			}
+
+			~PtyPair()
+			{
+				close(m_iMaster);
+			}
+
+			const std::string &GetSlaveName() const noexcept
+			{
+				return m_strSlaveName;
+			}
+
+			std::vector<uint8_t> ReadAll()
+			{
+				std::vector<uint8_t> data;
+
+				pollfd fd = { m_iMaster, POLLIN, 0 };
+
+				//pty delivers data asynchronously, so wait a bit for the first bytes
+				while (poll(&fd, 1, data.empty() ? 20 : 2) > 0)
+				{
+					uint8_t buffer[256];
+
+					auto n = read(m_iMaster, buffer, sizeof(buffer));
+					if (n <= 0)
+						break;
+
+					data.insert(data.end(), buffer, buffer + n);
+				}
+
+				return data;
+			}
+
+		private:
+			int m_iMaster;
+
+			std::string m_strSlaveName;
+	};
+#endif
+
+	std::vector<uint8_t> MakeMessage(std::vector<uint8_t> data)
+	{
+		uint8_t checksum = 0xFF;
+		for (auto b : data)
+			checksum ^= b;
+
+		data.push_back(checksum);
+
+		return data;
+	}
+
+	std::vector<uint8_t> MakeSpeed(const uint8_t slot, const uint8_t speed)
+	{
+		return MakeMessage({ OPC_LOCO_SPD, slot, static_cast<uint8_t>(speed & 0x7F) });
+	}
+
+	std::vector<uint8_t> MakeSlotData(const uint8_t slot)
+	{
+		return MakeMessage({ OPC_SL_RD_DATA, 0x0E, slot, 0x33, 3, 0, 0, 1, 0, 0, 0, 0, 0 });
+	}
+
+	void Push(LoconetTransmitQueue &queue, const std::vector<uint8_t> &msg, LoconetTransmitQueue::Priorities priority, uint16_t key = 0)
+	{
+		queue.Push(msg.data(), static_cast<uint8_t>(msg.size()), priority, key);
+	}
+
+	void PushSpeed(LoconetTransmitQueue &queue, const uint8_t slot, const uint8_t speed)
+	{
+		Push(queue, MakeSpeed(slot, speed), LoconetTransmitQueue::Priorities::NORMAL, LoconetTransmitQueue::MakeCoalesceKey(OPC_LOCO_SPD, slot));
+	}
+
+	/**
+	* Splits the stream like LoconetService does, fails on bad checksums
+	*/
+	std::vector<std::vector<uint8_t>> ParseStream(const std::vector<uint8_t> &stream)
+	{
+		std::vector<std::vector<uint8_t>> messages;
+
+		size_t pos = 0;
+		while (pos < stream.size())
+		{
+			const auto opcode = stream[pos];
+			EXPECT_TRUE(opcode & 0x80);
+
+			size_t len = 2;
+			if ((opcode & 0x60) == 0x60)
+				len = stream[pos + 1];
+			else if (opcode & 0x20)
+				len = 4;
+			else if (opcode & 0x40)
+				len = 6;
+
+			EXPECT_LE(pos + len, stream.size());
+
+			uint8_t checksum = 0xFF;
+			for (size_t i = 0; i < len - 1; ++i)
+				checksum ^= stream[pos + i];
+
+			EXPECT_EQ(checksum, stream[pos + len - 1]);
+
+			messages.emplace_back(stream.begin() + pos, stream.begin() + pos + len);
+
+			pos += len;
+		}
+
+		return messages;
+	}
+}
+
+TEST(LoconetTransmitQueue, Coalesce)
+{
+	BusRecorder bus;
+
+	LoconetTransmitQueue queue;
+
+	for (uint8_t i = 0; i < 10; ++i)
+		PushSpeed(queue, 5, i);
+
+	Push(queue, MakeMessage({ OPC_LOCO_DIRF, 5, 0x10 }), LoconetTransmitQueue::Priorities::NORMAL, LoconetTransmitQueue::MakeCoalesceKey(OPC_LOCO_DIRF, 5));
+	PushSpeed(queue, 6, 20);
+
+	//0x0A must not be translated
+	PushSpeed(queue, 10, 10);
+
+	ASSERT_EQ(queue.GetSize(), 4);
+	ASSERT_EQ(queue.GetNumCoalesced(), 9);
+
+	ASSERT_EQ(bus.Pump(queue, Clock::DefaultClock_t::now(), 1s), 4);
+	ASSERT_EQ(queue.GetSize(), 0);
+
+	auto messages = ParseStream(bus.ReadAll());
+	ASSERT_EQ(messages.size(), 4);
+
+	//first one keeps its place, with the last value
+	ASSERT_EQ(messages[0], MakeSpeed(5, 9));
+	ASSERT_EQ(messages[1][0], OPC_LOCO_DIRF);
+	ASSERT_EQ(messages[2], MakeSpeed(6, 20));
+	ASSERT_EQ(messages[3], MakeSpeed(10, 10));
+
+	//sent, so it is not replaced anymore
+	PushSpeed(queue, 5, 30);
+	ASSERT_EQ(queue.GetSize(), 1);
+	ASSERT_EQ(queue.GetNumCoalesced(), 9);
+}
+
+TEST(LoconetTransmitQueue, Priority)
+{
+	BusRecorder bus;
+
+	LoconetTransmitQueue queue;
+
+	PushSpeed(queue, 1, 10);
+	PushSpeed(queue, 2, 10);
+	Push(queue, MakeSlotData(3), LoconetTransmitQueue::Priorities::HIGH);
+
+	ASSERT_EQ(bus.Pump(queue, Clock::DefaultClock_t::now(), 1s), 3);
+
+	auto messages = ParseStream(bus.ReadAll());
+	ASSERT_EQ(messages.size(), 3);
+
+	ASSERT_EQ(messages[0], MakeSlotData(3));
+	ASSERT_EQ(messages[1], MakeSpeed(1, 10));
+	ASSERT_EQ(messages[2], MakeSpeed(2, 10));
+}
+
+TEST(LoconetTransmitQueue, Backoff)
+{
+	BusRecorder bus;
+
+	LoconetTransmitQueue queue;
+
+	for (uint8_t i = 1; i <= 20; ++i)
+		PushSpeed(queue, i, i);
+
+	auto now = Clock::DefaultClock_t::now();
+
+	//no window: only a message per pump
+	ASSERT_EQ(bus.Pump(queue, now, 0ms), 1);
+
+	//bus still busy with the last message
+	ASSERT_EQ(bus.Pump(queue, now, 0ms), 0);
+
+	now += sys::LOCONET_BYTE_TIME * 4 + sys::LOCONET_TX_BACKOFF;
+	ASSERT_EQ(bus.Pump(queue, now, 0ms), 1);
+
+	ASSERT_EQ(ParseStream(bus.ReadAll()).size(), 2);
+}
+
+TEST(LoconetTransmitQueue, BusyBus)
+{
+	BusRecorder bus;
+
+	LoconetTransmitQueue queue;
+
+	constexpr auto NUM_CYCLES = 200;
+	constexpr auto NUM_SLOTS = 8;
+	constexpr auto UPDATES_PER_CYCLE = 40;
+
+	std::map<uint8_t, uint8_t> lastSpeeds;
+	std::map<uint8_t, uint8_t> receivedSpeeds;
+
+	auto busTime = Clock::DefaultClock_t::duration{};
+	auto processMessages = [&](const std::vector<std::vector<uint8_t>> &messages)
+	{
+		for (auto &msg : messages)
+		{
+			busTime += sys::LOCONET_BYTE_TIME * msg.size() + sys::LOCONET_TX_BACKOFF;
+
+			if (msg[0] == OPC_LOCO_SPD)
+				receivedSpeeds[msg[1]] = msg[2];
+		}
+	};
+
+	auto now = Clock::DefaultClock_t::now();
+
+	for (int cycle = 0; cycle < NUM_CYCLES; ++cycle)
+	{
+		now += sys::LOCONET_THINK_TIME;
+
+		//throttles spinning knobs, a lot more than the bus can carry
+		for (int i = 0; i < UPDATES_PER_CYCLE; ++i)
+		{
+			const uint8_t slot = (i % NUM_SLOTS) + 1;
+			const uint8_t speed = static_cast<uint8_t>((cycle + i) & 0x7F);
+
+			PushSpeed(queue, slot, speed);
+			lastSpeeds[slot] = speed;
+		}
+
+		//and someone waiting for a reply
+		Push(queue, MakeSlotData((cycle % NUM_SLOTS) + 1), LoconetTransmitQueue::Priorities::HIGH);
+
+		ASSERT_GT(bus.Pump(queue, now, sys::LOCONET_THINK_TIME), 0);
+
+		auto messages = ParseStream(bus.ReadAll());
+		ASSERT_FALSE(messages.empty());
+
+		//reply never waits behind the speed updates
+		ASSERT_EQ(messages[0][0], OPC_SL_RD_DATA);
+
+		processMessages(messages);
+
+		//coalescing keeps the queue bounded by the number of slots
+		ASSERT_LE(queue.GetSize(), NUM_SLOTS);
+	}
+
+	//nothing written beyond what the bus can carry, plus the pump window and a message
+	ASSERT_LE(busTime, sys::LOCONET_THINK_TIME * (NUM_CYCLES + 1) + sys::LOCONET_BYTE_TIME * 14 + sys::LOCONET_TX_BACKOFF);
+	ASSERT_GT(queue.GetNumCoalesced(), 0);
+
+	//drain
+	while (queue.GetSize())
+	{
+		now += sys::LOCONET_THINK_TIME;
+
+		bus.Pump(queue, now, sys::LOCONET_THINK_TIME);
+		processMessages(ParseStream(bus.ReadAll()));
+	}
+
+	//every slot ends up on the last speed
+	ASSERT_EQ(receivedSpeeds, lastSpeeds);
+	ASSERT_EQ(queue.GetNumSent() + queue.GetNumCoalesced(), NUM_CYCLES * (UPDATES_PER_CYCLE + 1));
+}
+
+#ifndef WIN32
+
+//uses a pty pair as a serial port stand in
+TEST(LoconetTransmitQueue, PumpWritesToPort)
+{
+	PtyPair pty;
+	SerialPort port{ pty.GetSlaveName() };
+
+	LoconetTransmitQueue queue;
+
+	PushSpeed(queue, 1, 10);
+	PushSpeed(queue, 2, 10);
+	Push(queue, MakeSlotData(3), LoconetTransmitQueue::Priorities::HIGH);
+
+	ASSERT_EQ(queue.Pump(port, Clock::DefaultClock_t::now(), 1s), 3);
+	ASSERT_EQ(queue.GetSize(), 0);
+	ASSERT_EQ(queue.GetNumSent(), 3);
+
+	auto messages = ParseStream(pty.ReadAll());
+	ASSERT_EQ(messages.size(), 3);
+
+	ASSERT_EQ(messages[0], MakeSlotData(3));
+	ASSERT_EQ(messages[1], MakeSpeed(1, 10));
+	ASSERT_EQ(messages[2], MakeSpeed(2, 10));
+}
+
+#endif
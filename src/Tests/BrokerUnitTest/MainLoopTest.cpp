@@ -0,0 +1,175 @@
+// Copyright (C) 2019 - Bruno Sanches. See the COPYRIGHT
+// file at the top-level directory of this distribution.
+//
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+//
+// This Source Code Form is "Incompatible With Secondary Licenses", as
+// defined by the Mozilla Public License, v. 2.0.
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <thread>
+
+#include <dcclite/Clock.h>
+
+#include "sys/EventHub.h"
+#include "sys/MainLoop.h"
+#include "sys/Thinker.h"
+
+#ifndef WIN32
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+#endif
+
+using namespace dcclite;
+using namespace dcclite::broker;
+using namespace std::chrono_literals;
+
+namespace
+{
+	class TargetMockup: public sys::EventHub::IEventTarget
+	{
+		//empty
+	};
+
+	class CounterEvent: public sys::EventHub::IEvent
+	{
+		public:
+			CounterEvent(TargetMockup &target, std::atomic<int> &counter):
+				IEvent(target),
+				m_rclCounter{ counter }
+			{
+				//empty
+			}
+
+			void Fire() override
+			{
+				++m_rclCounter;
+			}
+
+		private:
+			std::atomic<int> &m_rclCounter;
+	};
+
+#ifndef WIN32
+	class EventFdHandler: public sys::MainLoop::IFdHandler
+	{
+		public:
+			EventFdHandler():
+				m_iFd{ eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK) }
+			{
+				//empty
+			}
+
+			~EventFdHandler() override
+			{
+				close(m_iFd);
+			}
+
+			void Signal()
+			{
+				const uint64_t value = 1;
+				[[maybe_unused]] auto rc = write(m_iFd, &value, sizeof(value));
+			}
+
+			void OnFdReady(const uint32_t events) override
+			{
+				uint64_t value;
+				[[maybe_unused]] auto rc = read(m_iFd, &value, sizeof(value));
+
+				++m_iNumCalls;
+			}
+
+			const int m_iFd;
+			int m_iNumCalls = 0;
+	};
+#endif
+
+	/**
+	* A thinker running every period, like the services ones
+	*/
+	class PeriodicThinker
+	{
+		public:
+			explicit PeriodicThinker(const Clock::DefaultClock_t::duration period):
+				m_tPeriod{ period },
+				m_tThinker{ "PeriodicThinker", THINKER_MF_LAMBDA(OnThink) }
+			{
+				m_tThinker.Schedule(Clock::DefaultClock_t::now() + m_tPeriod);
+			}
+
+			void OnThink(const sys::Thinker::TimePoint_t tp)
+			{
+				m_tThinker.Schedule(tp + m_tPeriod);
+			}
+
+		private:
+			const Clock::DefaultClock_t::duration m_tPeriod;
+
+			sys::Thinker m_tThinker;
+	};
+}
+
+TEST(MainLoop, Basic)
+{
+	sys::MainLoop::Start();
+
+	ASSERT_TRUE(sys::MainLoop::IsStarted());
+	ASSERT_THROW(sys::MainLoop::Start(), std::logic_error);
+
+	//like the broker, there is always a thinker, otherwise the loop blocks once everything ran
+	PeriodicThinker ticker{ 1ms };
+
+	TargetMockup target;
+	std::atomic<int> numEvents = 0;
+
+	int numThinks = 0;
+	const auto thinkTime = Clock::DefaultClock_t::now() + 5ms;
+	Clock::DefaultClock_t::time_point thinkCall;
+
+	sys::Thinker thinker{ thinkTime, "MainLoopTest", [&](const sys::Thinker::TimePoint_t tp) { ++numThinks; thinkCall = Clock::DefaultClock_t::now(); } };
+
+	std::thread producer{ [&]() { sys::EventHub::PostEvent<CounterEvent>(std::ref(target), std::ref(numEvents)); } };
+	producer.join();
+
+#ifndef WIN32
+	EventFdHandler handler;
+
+	sys::MainLoop::Watch(handler, handler.m_iFd, EPOLLIN);
+	handler.Signal();
+#endif
+
+	const auto deadline = Clock::DefaultClock_t::now() + 1s;
+	while ((numThinks == 0) && (Clock::DefaultClock_t::now() < deadline))
+		sys::MainLoop::RunOnce();
+
+	ASSERT_EQ(numThinks, 1);
+	ASSERT_GE(thinkCall, thinkTime);
+
+	ASSERT_EQ(numEvents, 1);
+
+#ifndef WIN32
+	ASSERT_EQ(handler.m_iNumCalls, 1);
+
+	sys::MainLoop::Unwatch(handler.m_iFd);
+
+	//not watched anymore, so only the thinker wakes the loop
+	handler.Signal();
+
+	thinker.Schedule(Clock::DefaultClock_t::now() + 1ms);
+
+	while ((numThinks == 1) && (Clock::DefaultClock_t::now() < deadline))
+		sys::MainLoop::RunOnce();
+
+	ASSERT_EQ(numThinks, 2);
+	ASSERT_EQ(handler.m_iNumCalls, 1);
+#endif
+
+	sys::MainLoop::Stop();
+
+	ASSERT_FALSE(sys::MainLoop::IsStarted());
+}
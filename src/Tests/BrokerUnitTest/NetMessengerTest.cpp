@@ -11,7 +11,9 @@
 #include <gtest/gtest.h>
 
 #include <chrono>
+#include <string>
 #include <thread>
+#include <tuple>
 
 #include <dcclite/Socket.h>
 #include <dcclite/NetMessenger.h>
@@ -158,4 +160,116 @@ TEST(NetMessenger, NetMessengerBasic)
 
 		ASSERT_EQ(status, Socket::Status::WOULD_BLOCK);
 	}
-}
\ No newline at end of file
+}
+static std::tuple<Socket, Socket> ConnectSockets(const uint16_t port)
+{
+	Socket serverListener{ };
+	Socket server;
+
+	EXPECT_TRUE(serverListener.Open(port, Socket::Type::STREAM));
+	EXPECT_TRUE(serverListener.Listen());
+
+	Socket client{};
+
+	EXPECT_TRUE(client.StartConnection(0, Socket::Type::STREAM, NetworkAddress(127, 0, 0, 1, port)));
+
+	for (;;)
+	{
+		if (!server.IsOpen())
+		{
+			auto [status, conSocket, address] = serverListener.TryAccept();
+			if (status == Socket::Status::OK)
+				server = std::move(conSocket);
+		}
+
+		auto status = client.GetConnectionProgress();
+
+		EXPECT_NE(status, Socket::Status::DISCONNECTED);
+
+		if ((status == Socket::Status::WOULD_BLOCK) || !server.IsOpen())
+		{
+			std::this_thread::sleep_for(1ms);
+			continue;
+		}
+
+		return std::make_tuple(std::move(server), std::move(client));
+	}
+}
+
+static std::tuple<Socket::Status, std::string> PollMessage(NetMessenger &messenger)
+{
+	//give the loopback some time to deliver the data
+	for (int i = 0; i < 100; ++i)
+	{
+		auto [status, msg] = messenger.Poll();
+		if (status != Socket::Status::WOULD_BLOCK)
+			return std::make_tuple(status, std::move(msg));
+
+		std::this_thread::sleep_for(1ms);
+	}
+
+	return std::make_tuple(Socket::Status::WOULD_BLOCK, std::string{});
+}
+
+TEST(NetMessenger, LengthPrefixFraming)
+{
+	auto [server, client] = ConnectSockets(8788);
+
+	NetMessenger sender{ std::move(server) };
+	NetMessenger receiver{ std::move(client) };
+
+	//binary data may contain the separator and zeros
+	const std::string binaryMsg{ "ab\r\nc\0d", 7 };
+
+	sender.SetFraming(NetMessenger::Framing::LENGTH_PREFIX);
+	receiver.SetFraming(NetMessenger::Framing::LENGTH_PREFIX);
+
+	ASSERT_TRUE(sender.Send(binaryMsg));
+	ASSERT_TRUE(sender.Send("xyz"));
+
+	{
+		auto [status, msg] = PollMessage(receiver);
+
+		ASSERT_EQ(status, Socket::Status::OK);
+		ASSERT_EQ(msg, binaryMsg);
+	}
+
+	{
+		auto [status, msg] = PollMessage(receiver);
+
+		ASSERT_EQ(status, Socket::Status::OK);
+		ASSERT_EQ(msg, "xyz");
+	}
+
+	//back to text mode
+	sender.SetFraming(NetMessenger::Framing::SEPARATOR);
+	receiver.SetFraming(NetMessenger::Framing::SEPARATOR);
+
+	ASSERT_TRUE(sender.Send("abc"));
+
+	{
+		auto [status, msg] = PollMessage(receiver);
+
+		ASSERT_EQ(status, Socket::Status::OK);
+		ASSERT_EQ(msg, "abc");
+	}
+}
+
+TEST(NetMessenger, LengthPrefixFramingRejectsHugeFrames)
+{
+	auto [server, client] = ConnectSockets(8789);
+
+	NetMessenger receiver{ std::move(client) };
+	receiver.SetFraming(NetMessenger::Framing::LENGTH_PREFIX);
+
+	{
+		const char header[] = { '\x7F', '\xFF', '\xFF', '\xFF' };
+
+		auto [status, sz] = server.Send(header, sizeof(header));
+		ASSERT_EQ(status, Socket::Status::OK);
+	}
+
+	auto [status, msg] = PollMessage(receiver);
+
+	ASSERT_EQ(status, Socket::Status::DISCONNECTED);
+}
@@ -0,0 +1,166 @@
+// Copyright (C) 2019 - Bruno Sanches. See the COPYRIGHT
+// file at the top-level directory of this distribution.
+//
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+//
+// This Source Code Form is "Incompatible With Secondary Licenses", as
+// defined by the Mozilla Public License, v. 2.0.
+
+#include <gtest/gtest.h>
+
+#include <memory>
+
+#include <fmt/format.h>
+#include <rapidjson/document.h>
+
+#include "../TestsCommon/BrokerMockups.h"
+#include "exec/dcc/OutputDecoderBatch.h"
+#include "exec/dcc/SimpleOutputDecoder.h"
+#include "exec/dcc/VirtualTurnoutDecoder.h"
+
+using namespace dcclite::broker::exec::dcc;
+
+namespace
+{
+	class CountingDeviceMockup: public DeviceDecoderServicesMockup
+	{
+		public:
+			void Decoder_OnChangeStateRequest(const Decoder &decoder) noexcept override
+			{
+				++m_uNumNotifications;
+			}
+
+			unsigned m_uNumNotifications = 0;
+	};
+
+	class VirtualDeviceMockup: public CountingDeviceMockup
+	{
+		public:
+			INetworkDevice_DecoderServices *TryGetINetworkDevice() noexcept override
+			{
+				return nullptr;
+			}
+	};
+
+	/**
+	* 20 devices with 25 turnouts each, like a medium sized layout
+	*/
+	class OutputDecoderBatchTest: public testing::Test
+	{
+		public:
+			static constexpr unsigned NUM_DEVICES = 20;
+			static constexpr unsigned NUM_DECODERS_PER_DEVICE = 25;
+
+			OutputDecoderBatchTest()
+			{
+				rapidjson::Document params;
+				params.Parse(R"JSON({"class": "Output", "pin": 13})JSON");
+
+				m_vecDevices.resize(NUM_DEVICES);
+
+				for (unsigned i = 0; i < NUM_DEVICES; ++i)
+				{
+					for (unsigned j = 0; j < NUM_DECODERS_PER_DEVICE; ++j)
+					{
+						const unsigned address = i * NUM_DECODERS_PER_DEVICE + j;
+
+						m_vecDecoders.push_back(std::make_unique<SimpleOutputDecoder>(
+							Address{ static_cast<uint16_t>(address) },
+							dcclite::RName{ fmt::format("batch_turnout_{}", address) },
+							m_clDecoderServices,
+							m_vecDevices[i],
+							params
+						));
+					}
+				}
+			}
+
+		protected:
+			unsigned GetTotalNotifications() const
+			{
+				unsigned total = 0;
+				for (const auto &device : m_vecDevices)
+					total += device.m_uNumNotifications;
+
+				return total;
+			}
+
+			void ResetNotifications()
+			{
+				for (auto &device : m_vecDevices)
+					device.m_uNumNotifications = 0;
+			}
+
+		protected:
+			DecoderServicesMockup							m_clDecoderServices;
+			std::vector<CountingDeviceMockup>				m_vecDevices;
+			std::vector<std::unique_ptr<OutputDecoder>>		m_vecDecoders;
+	};
+}
+
+TEST_F(OutputDecoderBatchTest, SingleNotificationPerDevice)
+{
+	OutputDecoderBatch batch;
+
+	//interleave devices, so the batch must group them
+	for (unsigned j = 0; j < NUM_DECODERS_PER_DEVICE; ++j)
+	{
+		for (unsigned i = 0; i < NUM_DEVICES; ++i)
+			batch.Add(*m_vecDecoders[i * NUM_DECODERS_PER_DEVICE + j], dcclite::DecoderStates::ACTIVE);
+	}
+
+	ASSERT_EQ(batch.GetSize(), NUM_DEVICES * NUM_DECODERS_PER_DEVICE);
+	ASSERT_EQ(batch.Apply("test"), NUM_DEVICES * NUM_DECODERS_PER_DEVICE);
+	ASSERT_TRUE(batch.IsEmpty());
+
+	for (const auto &device : m_vecDevices)
+		ASSERT_EQ(device.m_uNumNotifications, 1u);
+
+	for (const auto &decoder : m_vecDecoders)
+		ASSERT_EQ(decoder->GetRequestedState(), dcclite::DecoderStates::ACTIVE);
+
+	//nothing changed, so no one is notified
+	ResetNotifications();
+
+	batch.Add(*m_vecDecoders[0], dcclite::DecoderStates::ACTIVE);
+	ASSERT_EQ(batch.Apply("test"), 0u);
+	ASSERT_EQ(GetTotalNotifications(), 0u);
+}
+
+TEST_F(OutputDecoderBatchTest, LastStateWins)
+{
+	OutputDecoderBatch batch;
+
+	batch.Add(*m_vecDecoders[0], dcclite::DecoderStates::ACTIVE);
+	batch.Add(*m_vecDecoders[1], dcclite::DecoderStates::ACTIVE);
+	batch.Add(*m_vecDecoders[0], dcclite::DecoderStates::INACTIVE);
+
+	batch.Apply("test");
+
+	ASSERT_EQ(m_vecDecoders[0]->GetRequestedState(), dcclite::DecoderStates::INACTIVE);
+	ASSERT_EQ(m_vecDecoders[1]->GetRequestedState(), dcclite::DecoderStates::ACTIVE);
+	ASSERT_EQ(m_vecDevices[0].m_uNumNotifications, 1u);
+}
+
+TEST(OutputDecoderBatch, VirtualDevicesAreNotifiedPerDecoder)
+{
+	DecoderServicesMockup decoderServices;
+	VirtualDeviceMockup device;
+
+	rapidjson::Document params;
+	params.Parse(R"JSON({"class": "VirtualTurnout"})JSON");
+
+	VirtualTurnoutDecoder decoder1{ Address{ 1 }, dcclite::RName{ "batch_virtual_1" }, decoderServices, device, params };
+	VirtualTurnoutDecoder decoder2{ Address{ 2 }, dcclite::RName{ "batch_virtual_2" }, decoderServices, device, params };
+
+	OutputDecoderBatch batch;
+	batch.Add(decoder1, dcclite::DecoderStates::ACTIVE);
+	batch.Add(decoder2, dcclite::DecoderStates::ACTIVE);
+
+	ASSERT_EQ(batch.Apply("test"), 2u);
+
+	//virtual devices sync each decoder when notified
+	ASSERT_EQ(device.m_uNumNotifications, 2u);
+}
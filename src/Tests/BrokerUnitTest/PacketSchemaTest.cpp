@@ -0,0 +1,114 @@
+// Copyright (C) 2019 - Bruno Sanches. See the COPYRIGHT
+// file at the top-level directory of this distribution.
+//
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+//
+// This Source Code Form is "Incompatible With Secondary Licenses", as
+// defined by the Mozilla Public License, v. 2.0.
+
+#include <gtest/gtest.h>
+
+#include <dcclite_shared/Packet.h>
+
+using namespace dcclite;
+
+static Guid MakeGuid(uint8_t seed)
+{
+	Guid guid;
+
+	for (unsigned i = 0; i < sizeof(guid.m_bId); ++i)
+		guid.m_bId[i] = static_cast<uint8_t>(seed + i);
+
+	return guid;
+}
+
+TEST(PacketSchema, Size)
+{
+	static_assert(PacketHeaderSchema_t::SIZE == 37, "header must match PacketBuilder");
+	static_assert(ConfigAckSchema_t::SIZE == 9, "seq + 64 bits");
+	static_assert(PacketSchema<uint8_t, uint16_t, uint64_t>::SIZE == 11, "no padding");
+	static_assert(PacketSchema<>::SIZE == 0, "empty");
+}
+
+TEST(PacketSchema, MatchesPerByteLayout)
+{
+	const auto session = MakeGuid(1);
+	const auto config = MakeGuid(100);
+
+	ConfigAcksBitPack_t slots;
+	slots.SetBit(0);
+	slots.SetBit(33);
+	slots.SetBit(63);
+
+	Packet perByte;
+	perByte.Write32(PACKET_ID);
+	perByte.Write8(static_cast<uint8_t>(MsgTypes::CONFIG_ACK));
+	perByte.Write(session);
+	perByte.Write(config);
+	perByte.Write8(42);
+	perByte.Write(slots);
+
+	Packet schema;
+	PacketHeaderSchema_t::Write(schema, PACKET_ID, MsgTypes::CONFIG_ACK, session, config);
+	ConfigAckSchema_t::Write(schema, 42, slots);
+
+	ASSERT_EQ(schema.GetSize(), perByte.GetSize());
+	ASSERT_EQ(memcmp(schema.GetData(), perByte.GetData(), schema.GetSize()), 0);
+
+	//and read back with both
+	schema.Reset();
+
+	uint32_t id;
+	MsgTypes type;
+	Guid readSession, readConfig;
+	ASSERT_TRUE(PacketHeaderSchema_t::Read(schema, id, type, readSession, readConfig));
+
+	ASSERT_EQ(id, PACKET_ID);
+	ASSERT_EQ(type, MsgTypes::CONFIG_ACK);
+	ASSERT_EQ(readSession, session);
+	ASSERT_EQ(readConfig, config);
+
+	ASSERT_EQ(schema.Read<uint8_t>(), 42);
+
+	ConfigAcksBitPack_t readSlots;
+	schema.ReadBitPack(readSlots);
+	ASSERT_EQ(readSlots, slots);
+}
+
+TEST(PacketSchema, PacketBuilder)
+{
+	const auto session = MakeGuid(7);
+	const auto config = MakeGuid(77);
+
+	Packet packet;
+	PacketBuilder builder{ packet, MsgTypes::STATE, session, config };
+
+	ASSERT_EQ(packet.GetSize(), PacketHeaderSchema_t::SIZE);
+
+	packet.Reset();
+	ASSERT_EQ(packet.Read<uint32_t>(), PACKET_ID);
+	ASSERT_EQ(packet.Read<MsgTypes>(), MsgTypes::STATE);
+	ASSERT_EQ(packet.ReadGuid(), session);
+	ASSERT_EQ(packet.ReadGuid(), config);
+}
+
+TEST(PacketSchema, Truncated)
+{
+	Packet packet;
+
+	//only 7 bytes left, considering the reserved one
+	packet.Seek(PACKET_MAX_SIZE - 8);
+
+	uint8_t seq = 0;
+	ConfigAcksBitPack_t slots;
+	ASSERT_FALSE(ConfigAckSchema_t::Read(packet, seq, slots));
+
+	//nothing consumed
+	ASSERT_EQ(packet.GetSize(), PACKET_MAX_SIZE - 8);
+
+	packet.Seek(PACKET_MAX_SIZE - 10);
+	ASSERT_TRUE(ConfigAckSchema_t::Read(packet, seq, slots));
+	ASSERT_EQ(packet.GetSize(), PACKET_MAX_SIZE - 1);
+}
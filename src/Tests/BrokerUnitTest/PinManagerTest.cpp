@@ -159,7 +159,7 @@ TEST(PinManagerTest, Serialize_CallsStream)
 {
 	PinManager manager(ArduinoBoards::UNO);
 
-	JsonCreator::StringWriter writer;
+	dcclite::JsonDataWriter writer;
 	JsonOutputStream_t stream{ writer };
 
 	// Should not throw
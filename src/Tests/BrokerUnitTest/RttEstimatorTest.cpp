@@ -0,0 +1,235 @@
+// Copyright (C) 2019 - Bruno Sanches. See the COPYRIGHT
+// file at the top-level directory of this distribution.
+//
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+//
+// This Source Code Form is "Incompatible With Secondary Licenses", as
+// defined by the Mozilla Public License, v. 2.0.
+
+#include <gtest/gtest.h>
+
+#include <optional>
+#include <random>
+
+#include "sys/RttEstimator.h"
+#include "sys/Timeouts.h"
+
+using namespace dcclite::broker::sys;
+using namespace std::chrono_literals;
+
+typedef RttEstimator::Duration_t Duration_t;
+
+namespace
+{
+	/**
+	* A stand in for the network: each packet is lost with the given probability, otherwise its reply arrives after
+	* a random delay
+	*/
+	class LossyLink
+	{
+		public:
+			LossyLink(Duration_t minDelay, Duration_t maxDelay, double lossRate):
+				m_clRng{ 1234 },
+				m_clDelay{ minDelay.count(), maxDelay.count() },
+				m_clLoss{ lossRate }
+			{
+				//empty
+			}
+
+			/**
+			* Returns the round trip time or nothing if the packet or its reply was lost
+			*/
+			std::optional<Duration_t> Send()
+			{
+				if (m_clLoss(m_clRng))
+					return std::nullopt;
+
+				return Duration_t{ m_clDelay(m_clRng) };
+			}
+
+		private:
+			std::mt19937								m_clRng;
+			std::uniform_int_distribution<int64_t>		m_clDelay;
+			std::bernoulli_distribution					m_clLoss;
+	};
+
+	struct SimulationResult
+	{
+		unsigned	m_uTransmissions = 0;
+
+		//replies that arrived after the packet was sent again
+		unsigned	m_uSpuriousRetransmissions = 0;
+
+		Duration_t	m_tTotalTime{};
+	};
+
+	/**
+	* Sends numPackets, one after the other, like the broker does with state changes: a packet is sent again when the
+	* retransmission timer expires, until a reply arrives
+	*/
+	SimulationResult Simulate(LossyLink &link, unsigned numPackets, RttEstimator *estimator)
+	{
+		SimulationResult result;
+
+		for (unsigned i = 0; i < numPackets; ++i)
+		{
+			Duration_t elapsed{};
+			std::optional<Duration_t> replyTime;
+
+			unsigned attempts = 0;
+
+			for (;;)
+			{
+				++attempts;
+				++result.m_uTransmissions;
+
+				if (auto rtt = link.Send())
+				{
+					if (!replyTime || (elapsed + *rtt < *replyTime))
+						replyTime = elapsed + *rtt;
+				}
+
+				const auto timeout = estimator ? estimator->GetRetransmitTimeout() : Duration_t{ NETWORK_DEVICE_STATE_TIMEOUT };
+
+				if (replyTime && (*replyTime <= elapsed + timeout))
+					break;
+
+				if (replyTime)
+					++result.m_uSpuriousRetransmissions;
+
+				if (estimator)
+					estimator->OnTimeout();
+
+				elapsed += timeout;
+			}
+
+			//Karn: only packets sent once give a reliable sample
+			if (estimator && (attempts == 1))
+				estimator->AddSample(*replyTime);
+
+			result.m_tTotalTime += *replyTime;
+		}
+
+		return result;
+	}
+
+	RttEstimator MakeEstimator()
+	{
+		return RttEstimator{ NETWORK_DEVICE_STATE_TIMEOUT, NETWORK_DEVICE_STATE_MIN_TIMEOUT, NETWORK_DEVICE_STATE_MAX_TIMEOUT };
+	}
+}
+
+TEST(RttEstimator, Basic)
+{
+	auto estimator = MakeEstimator();
+
+	ASSERT_EQ(estimator.GetNumSamples(), 0u);
+	ASSERT_EQ(estimator.GetRetransmitTimeout(), Duration_t{ NETWORK_DEVICE_STATE_TIMEOUT });
+
+	//first sample: SRTT = R, RTTVAR = R / 2
+	estimator.AddSample(100ms);
+
+	ASSERT_EQ(estimator.GetSmoothedRtt(), Duration_t{ 100ms });
+	ASSERT_EQ(estimator.GetRttVariation(), Duration_t{ 50ms });
+	ASSERT_EQ(estimator.GetRetransmitTimeout(), Duration_t{ 300ms });
+
+	//RTTVAR = 3/4 * 50 + 1/4 * 100, SRTT = 7/8 * 100 + 1/8 * 200
+	estimator.AddSample(200ms);
+
+	ASSERT_EQ(estimator.GetRttVariation(), Duration_t{ 62500us });
+	ASSERT_EQ(estimator.GetSmoothedRtt(), Duration_t{ 112500us });
+	ASSERT_EQ(estimator.GetRetransmitTimeout(), Duration_t{ 362500us });
+}
+
+TEST(RttEstimator, Bounds)
+{
+	auto estimator = MakeEstimator();
+
+	//a fast and steady link must not go below the floor
+	for (int i = 0; i < 100; ++i)
+		estimator.AddSample(1ms);
+
+	ASSERT_EQ(estimator.GetSmoothedRtt(), Duration_t{ 1ms });
+	ASSERT_EQ(estimator.GetRetransmitTimeout(), Duration_t{ NETWORK_DEVICE_STATE_MIN_TIMEOUT });
+
+	estimator.AddSample(10s);
+	ASSERT_EQ(estimator.GetRetransmitTimeout(), Duration_t{ NETWORK_DEVICE_STATE_MAX_TIMEOUT });
+
+	ASSERT_THROW(RttEstimator(100ms, 0ms, 1s), std::invalid_argument);
+	ASSERT_THROW(RttEstimator(100ms, 2s, 1s), std::invalid_argument);
+}
+
+TEST(RttEstimator, Backoff)
+{
+	auto estimator = MakeEstimator();
+
+	estimator.AddSample(40ms);
+
+	const auto timeout = estimator.GetRetransmitTimeout();
+	ASSERT_EQ(timeout, Duration_t{ 120ms });
+
+	estimator.OnTimeout();
+	ASSERT_EQ(estimator.GetRetransmitTimeout(), timeout * 2);
+
+	estimator.OnTimeout();
+	ASSERT_EQ(estimator.GetRetransmitTimeout(), timeout * 4);
+
+	//never goes past the ceiling, no matter how many timeouts
+	for (int i = 0; i < 100; ++i)
+		estimator.OnTimeout();
+
+	ASSERT_EQ(estimator.GetRetransmitTimeout(), Duration_t{ NETWORK_DEVICE_STATE_MAX_TIMEOUT });
+	ASSERT_EQ(estimator.GetNumTimeouts(), 102u);
+
+	//a new sample clears the backoff, RTTVAR = 3/4 * 20
+	estimator.AddSample(40ms);
+	ASSERT_EQ(estimator.GetRetransmitTimeout(), Duration_t{ 100ms });
+
+	estimator.Reset();
+	ASSERT_EQ(estimator.GetNumSamples(), 0u);
+	ASSERT_EQ(estimator.GetNumTimeouts(), 0u);
+	ASSERT_EQ(estimator.GetRetransmitTimeout(), Duration_t{ NETWORK_DEVICE_STATE_TIMEOUT });
+}
+
+TEST(RttEstimator, FastLossyLink)
+{
+	constexpr unsigned NUM_PACKETS = 1000;
+
+	//a good wifi link, but dropping 10% of the packets
+	LossyLink fixedLink{ 2ms, 6ms, 0.1 };
+	auto fixed = Simulate(fixedLink, NUM_PACKETS, nullptr);
+
+	LossyLink adaptiveLink{ 2ms, 6ms, 0.1 };
+	auto estimator = MakeEstimator();
+	auto adaptive = Simulate(adaptiveLink, NUM_PACKETS, &estimator);
+
+	ASSERT_EQ(estimator.GetRetransmitTimeout(), Duration_t{ NETWORK_DEVICE_STATE_MIN_TIMEOUT });
+
+	//lost packets are recovered in a fraction of the time
+	ASSERT_LT(adaptive.m_tTotalTime * 3, fixed.m_tTotalTime);
+}
+
+TEST(RttEstimator, SlowLink)
+{
+	constexpr unsigned NUM_PACKETS = 1000;
+
+	//slower than the fixed timeout, like a congested network or a busy device
+	LossyLink fixedLink{ 260ms, 400ms, 0.02 };
+	auto fixed = Simulate(fixedLink, NUM_PACKETS, nullptr);
+
+	LossyLink adaptiveLink{ 260ms, 400ms, 0.02 };
+	auto estimator = MakeEstimator();
+	auto adaptive = Simulate(adaptiveLink, NUM_PACKETS, &estimator);
+
+	//fixed timer resends every single packet
+	ASSERT_GE(fixed.m_uSpuriousRetransmissions, NUM_PACKETS * 9 / 10);
+
+	//after the first samples, the timeout follows the link
+	ASSERT_LT(adaptive.m_uSpuriousRetransmissions, NUM_PACKETS / 20);
+	ASSERT_LT(adaptive.m_uTransmissions * 3, fixed.m_uTransmissions * 2);
+
+	ASSERT_GT(estimator.GetSmoothedRtt(), Duration_t{ 260ms });
+	ASSERT_LT(estimator.GetSmoothedRtt(), Duration_t{ 400ms });
+}
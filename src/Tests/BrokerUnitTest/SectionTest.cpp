@@ -0,0 +1,265 @@
+// Copyright (C) 2019 - Bruno Sanches. See the COPYRIGHT
+// file at the top-level directory of this distribution.
+//
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+//
+// This Source Code Form is "Incompatible With Secondary Licenses", as
+// defined by the Mozilla Public License, v. 2.0.
+
+#include <gtest/gtest.h>
+
+#include <map>
+#include <memory>
+
+#include <fmt/format.h>
+#include <rapidjson/document.h>
+
+#include "../TestsCommon/BrokerMockups.h"
+#include "exec/dcc/SensorDecoder.h"
+#include "exec/dcc/SimpleOutputDecoder.h"
+#include "shell/dispatcher/Section.h"
+
+using namespace dcclite::broker::exec::dcc;
+using dcclite::broker::shell::dispatcher::BaseSection;
+using dcclite::broker::shell::dispatcher::SectionStates;
+using dcclite::DecoderStates;
+using dcclite::RName;
+
+namespace
+{
+	class SectionServicesMockup: public IDccLite_DecoderServices
+	{
+		public:
+			void Decoder_OnStateChanged(Decoder &decoder) override
+			{
+				//empty
+			}
+
+			Decoder *TryFindDecoder(RName id) const override
+			{
+				auto it = m_mapDecoders.find(id);
+
+				return it == m_mapDecoders.end() ? nullptr : it->second.get();
+			}
+
+			template <typename T>
+			T &Create(std::string_view name, const char *json)
+			{
+				rapidjson::Document params;
+				params.Parse(json);
+
+				auto decoder = std::make_unique<T>(Address{ static_cast<uint16_t>(m_mapDecoders.size()) }, RName{ name }, *this, m_clDevice, params);
+				auto &ref = *decoder;
+
+				m_mapDecoders.emplace(RName{ name }, std::move(decoder));
+
+				return ref;
+			}
+
+			SensorDecoder &CreateSensor(std::string_view name)
+			{
+				return this->Create<SensorDecoder>(name, R"JSON({"class": "Sensor", "pin": 10})JSON");
+			}
+
+			OutputDecoder &CreateTurnout(std::string_view name)
+			{
+				return this->Create<SimpleOutputDecoder>(name, R"JSON({"class": "Output", "pin": 13})JSON");
+			}
+
+			std::unique_ptr<BaseSection> CreateSection(const char *json)
+			{
+				rapidjson::Document params;
+				params.Parse(json);
+
+				return BaseSection::Create(params, [this](RName name) { return this->TryFindDecoder(name); });
+			}
+
+		private:
+			DeviceDecoderServicesMockup m_clDevice;
+
+			std::map<RName, std::unique_ptr<Decoder>> m_mapDecoders;
+	};
+
+	class SectionTest: public testing::Test
+	{
+		public:
+			SectionTest()
+			{
+				for (auto name : { "start", "end", "closed", "thrown" })
+					m_clServices.CreateSensor(name);
+
+				m_clServices.CreateTurnout("turnout");
+			}
+
+		protected:
+			//the device reported a new state
+			void Sync(std::string_view name, const DecoderStates state)
+			{
+				static_cast<RemoteDecoder *>(m_clServices.TryFindDecoder(RName{ name }))->SyncRemoteState(state);
+			}
+
+			void Activate(std::string_view name)
+			{
+				this->Sync(name, DecoderStates::ACTIVE);
+			}
+
+			void Deactivate(std::string_view name)
+			{
+				this->Sync(name, DecoderStates::INACTIVE);
+			}
+
+		protected:
+			SectionServicesMockup m_clServices;
+	};
+
+	const char *g_pszSection = R"JSON({ "name": "section", "class": "Section", "startSensor": "start", "endSensor": "end" })JSON";
+	const char *g_pszTSection = R"JSON({ "name": "tsection", "class": "TSection", "startSensor": "start", "closedSensor": "closed", "thrownSensor": "thrown", "turnout": "turnout" })JSON";
+	const char *g_pszStorage = R"JSON({ "name": "storage", "class": "StorageSection", "entrySensor": "start", "exitSensor": "end" })JSON";
+}
+
+TEST_F(SectionTest, Section)
+{
+	auto section = m_clServices.CreateSection(g_pszSection);
+
+	unsigned changes = 0;
+	section->m_sigStateChanged.connect([&changes](BaseSection &) { ++changes; });
+
+	ASSERT_TRUE(section->IsClear());
+
+	//going up
+	Activate("start");
+	ASSERT_EQ(section->GetState(), SectionStates::UP_START);
+	ASSERT_TRUE(section->IsGoingUp());
+
+	Activate("end");
+	ASSERT_EQ(section->GetState(), SectionStates::UP);
+
+	//tail left the start sensor, still inside
+	Deactivate("start");
+	ASSERT_EQ(section->GetState(), SectionStates::UP);
+
+	Deactivate("end");
+	ASSERT_TRUE(section->IsClear());
+	ASSERT_EQ(changes, 3);
+
+	//going down
+	Activate("end");
+	ASSERT_EQ(section->GetState(), SectionStates::DOWN_START);
+	ASSERT_TRUE(section->IsGoingDown());
+
+	Activate("start");
+	ASSERT_EQ(section->GetState(), SectionStates::DOWN);
+
+	//start sensor of the block (end) may oscillate, it is ignored
+	Deactivate("end");
+	ASSERT_EQ(section->GetState(), SectionStates::DOWN);
+
+	Deactivate("start");
+	ASSERT_TRUE(section->IsClear());
+
+	section->Reset();
+	ASSERT_TRUE(section->IsClear());
+}
+
+TEST_F(SectionTest, InitialState)
+{
+	Activate("start");
+
+	auto section = m_clServices.CreateSection(g_pszSection);
+	ASSERT_EQ(section->GetState(), SectionStates::UP_START);
+
+	Activate("end");
+	ASSERT_EQ(section->GetState(), SectionStates::UP);
+}
+
+TEST_F(SectionTest, TSection)
+{
+	auto section = m_clServices.CreateSection(g_pszTSection);
+
+	ASSERT_TRUE(section->IsClear());
+
+	//turnout is closed, thrown branch makes no sense, ignored
+	Activate("thrown");
+	ASSERT_TRUE(section->IsClear());
+	Deactivate("thrown");
+
+	//coming from the closed branch
+	Activate("closed");
+	ASSERT_EQ(section->GetState(), SectionStates::DOWN_START);
+
+	Activate("start");
+	ASSERT_EQ(section->GetState(), SectionStates::DOWN);
+
+	Deactivate("closed");
+	ASSERT_EQ(section->GetState(), SectionStates::DOWN);
+
+	Deactivate("start");
+	ASSERT_TRUE(section->IsClear());
+
+	//end sensor follows the turnout
+	Activate("turnout");
+
+	Activate("start");
+	ASSERT_EQ(section->GetState(), SectionStates::UP_START);
+
+	Activate("thrown");
+	ASSERT_EQ(section->GetState(), SectionStates::UP);
+
+	Deactivate("start");
+	Deactivate("thrown");
+	ASSERT_TRUE(section->IsClear());
+}
+
+TEST_F(SectionTest, StorageSection)
+{
+	auto section = m_clServices.CreateSection(g_pszStorage);
+
+	Activate("start");
+	ASSERT_EQ(section->GetState(), SectionStates::UP_START);
+
+	Activate("end");
+	ASSERT_EQ(section->GetState(), SectionStates::UP);
+
+	//whole train inside
+	Deactivate("start");
+	ASSERT_EQ(section->GetState(), SectionStates::UP);
+
+	//backing out
+	Deactivate("end");
+	ASSERT_EQ(section->GetState(), SectionStates::DOWN_START);
+
+	Activate("start");
+	ASSERT_EQ(section->GetState(), SectionStates::DOWN_START);
+
+	Deactivate("start");
+	ASSERT_TRUE(section->IsClear());
+}
+
+TEST_F(SectionTest, DecoderDestroyed)
+{
+	auto section = m_clServices.CreateSection(g_pszSection);
+
+	Activate("start");
+
+	ASSERT_FALSE(section->OnDecoderDestroyed(*m_clServices.TryFindDecoder(RName{ "closed" })));
+	ASSERT_FALSE(section->IsBroken());
+
+	ASSERT_TRUE(section->OnDecoderDestroyed(*m_clServices.TryFindDecoder(RName{ "end" })));
+	ASSERT_TRUE(section->IsBroken());
+	ASSERT_TRUE(section->IsClear());
+
+	//not watching anymore
+	Activate("end");
+	ASSERT_TRUE(section->IsClear());
+}
+
+TEST_F(SectionTest, BadConfig)
+{
+	ASSERT_THROW(m_clServices.CreateSection(R"JSON({ "name": "s", "class": "Block", "startSensor": "start", "endSensor": "end" })JSON"), std::invalid_argument);
+	ASSERT_THROW(m_clServices.CreateSection(R"JSON({ "name": "s", "class": "Section", "startSensor": "start", "endSensor": "missing" })JSON"), std::invalid_argument);
+
+	//sensor used as turnout
+	ASSERT_THROW(m_clServices.CreateSection(R"JSON({ "name": "s", "class": "TSection", "startSensor": "start", "closedSensor": "closed", "thrownSensor": "thrown", "turnout": "end" })JSON"), std::invalid_argument);
+}
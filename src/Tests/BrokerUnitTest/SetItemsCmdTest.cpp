@@ -0,0 +1,147 @@
+// Copyright (C) 2019 - Bruno Sanches. See the COPYRIGHT
+// file at the top-level directory of this distribution.
+// 
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+// 
+// This Source Code Form is "Incompatible With Secondary Licenses", as
+// defined by the Mozilla Public License, v. 2.0.
+
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <stdexcept>
+
+#include <fmt/format.h>
+#include <rapidjson/document.h>
+
+#include <dcclite/FolderObject.h>
+
+#include "../TestsCommon/BrokerMockups.h"
+#include "exec/dcc/SimpleOutputDecoder.h"
+#include "shell/terminal/SetItemsCmd.h"
+#include "shell/terminal/TerminalContext.h"
+
+using namespace dcclite::broker::exec::dcc;
+using namespace dcclite::broker::shell::terminal;
+using dcclite::DecoderStates;
+using dcclite::RName;
+
+namespace
+{
+	class TerminalClientServicesMockup: public ITerminalClient_ContextServices
+	{
+		public:
+			TaskManager &GetTaskManager() override
+			{
+				throw std::runtime_error("not supported");
+			}
+
+			void SendClientNotification(const std::string_view msg) override
+			{
+				//empty
+			}
+
+			void DestroyFiber(TerminalCmdFiber &fiber) override
+			{
+				//empty
+			}
+
+			TerminalEncoding GetEncoding() const noexcept override
+			{
+				return TerminalEncoding::JSON;
+			}
+
+			void SetEncoding(const TerminalEncoding encoding) override
+			{
+				//empty
+			}
+
+			void Subscribe(const dcclite::broker::sys::SubscriptionFilter &filter) override
+			{
+				//empty
+			}
+
+			bool Unsubscribe(const dcclite::broker::sys::SubscriptionFilter &filter) override
+			{
+				return false;
+			}
+
+			void UnsubscribeAll() override
+			{
+				//empty
+			}
+	};
+
+	class SetItemsCmdTest: public testing::Test
+	{
+		public:
+			SetItemsCmdTest():
+				m_clRoot{ RName{"root"} },
+				m_clContext{ m_clRoot, m_clClientServices }
+			{
+				for (int i = 0; i < 3; ++i)
+				{
+					rapidjson::Document params;
+					params.Parse(R"JSON({"class": "Output", "pin": 13})JSON");
+
+					m_pclOutputs[i] = static_cast<SimpleOutputDecoder *>(m_clRoot.AddChild(
+						std::make_unique<SimpleOutputDecoder>(Address{ static_cast<uint16_t>(i) }, RName{ fmt::format("out{}", i) }, m_clDecoderServices, m_clDeviceServices, params)
+					));
+				}
+			}
+
+			void Run(const char *json)
+			{
+				rapidjson::Document request;
+				request.Parse(json);
+
+				m_clCmd.Run(m_clContext, 1, request);
+			}
+
+		protected:
+			DecoderServicesMockup			m_clDecoderServices;
+			DeviceDecoderServicesMockup		m_clDeviceServices;
+			TerminalClientServicesMockup	m_clClientServices;
+
+			dcclite::FolderObject			m_clRoot;
+			TerminalContext					m_clContext;
+
+			SetItemsCmd						m_clCmd;
+
+			SimpleOutputDecoder				*m_pclOutputs[3];
+	};
+}
+
+TEST_F(SetItemsCmdTest, Apply)
+{
+	this->Run(R"JSON({"params": [{"path": "out0", "state": "active"}, {"path": "out2", "state": "active"}]})JSON");
+
+	ASSERT_EQ(m_pclOutputs[0]->GetRequestedState(), DecoderStates::ACTIVE);
+	ASSERT_EQ(m_pclOutputs[1]->GetRequestedState(), DecoderStates::INACTIVE);
+	ASSERT_EQ(m_pclOutputs[2]->GetRequestedState(), DecoderStates::ACTIVE);
+}
+
+TEST_F(SetItemsCmdTest, LockedOutput)
+{
+	ASSERT_TRUE(m_pclOutputs[1]->Lock(RName{ "route1" }));
+
+	try
+	{
+		this->Run(R"JSON({"params": [{"path": "out0", "state": "active"}, {"path": "out1", "state": "active"}, {"path": "out2", "state": "active"}]})JSON");
+
+		FAIL() << "locked output accepted";
+	}
+	catch (const TerminalCmdException &ex)
+	{
+		const std::string_view what = ex.what();
+
+		EXPECT_NE(what.find("out1"), std::string_view::npos) << what;
+		EXPECT_NE(what.find("route1"), std::string_view::npos) << what;
+	}
+
+	//validation failed, so nothing was applied
+	for (auto output : m_pclOutputs)
+		ASSERT_EQ(output->GetRequestedState(), DecoderStates::INACTIVE);
+}
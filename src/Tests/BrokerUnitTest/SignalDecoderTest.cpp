@@ -2,11 +2,16 @@
 #include <gmock/gmock.h>
 #include <gmock/gmock-matchers.h>
 
+#include <fmt/format.h>
+
 #include <rapidjson/document.h>
 
 #include <dcclite/Log.h>
 
+#include <spdlog/spdlog.h>
+
 #include "exec/dcc/SignalDecoder.h"
+#include "exec/dcc/SimpleOutputDecoder.h"
 
 
 using testing::HasSubstr;
@@ -49,6 +54,11 @@ class SignalTester
 			return m_Signal->m_vecAspects;
 		}
 
+		bool IsBrokerFlashing() const
+		{
+			return std::holds_alternative<SignalDecoder::State_Flash>(m_Signal->m_vState);
+		}
+
 	private:
 		std::unique_ptr<SignalDecoder> m_Signal;
 };
@@ -180,7 +190,7 @@ static std::string ExtractSignalExceptionString(const char *json)
 		return ex.what();
 	}
 
-	throw std::exception("GTEST FAILURE");
+	throw std::runtime_error("GTEST FAILURE");
 }
 
 TEST(SignalDecoderTest, NoHeadsData)
@@ -421,4 +431,266 @@ TEST(SignalDecoderTest, InvalidAspectName)
 	)JSON")) << "Signal definition in JSON uses an name for aspect that is not know [BLA]";
 };
 
+class HeadsServicesMockup : public DecoderServicesMockup
+{
+	public:
+		void AddHead(const char *name, int pin, bool flash)
+		{
+			Document d;
+			d.Parse(fmt::format(R"JSON({{"pin": {}, "flash": {}}})JSON", pin, flash).c_str());
+
+			m_mapHeads.emplace(
+				dcclite::RName{ name }, 
+				std::make_unique<SimpleOutputDecoder>(Address{ static_cast<uint16_t>(pin) }, dcclite::RName{ name }, *this, m_clDevice, d)
+			);
+		}
+
+		Decoder *TryFindDecoder(dcclite::RName id) const override
+		{
+			++m_uNumLookups;
+
+			auto it = m_mapHeads.find(id);
+
+			return it != m_mapHeads.end() ? it->second.get() : nullptr;
+		}
+
+		OutputDecoder &GetHead(const char *name)
+		{
+			return *m_mapHeads.find(dcclite::RName{ name })->second;
+		}
+
+		void RemoveHead(const char *name)
+		{
+			m_mapHeads.erase(dcclite::RName{ name });
+		}
+
+		//the device answered all pending changes
+		void SyncHeads()
+		{
+			for (auto &it : m_mapHeads)
+				it.second->SyncRemoteState(it.second->GetRequestedState());
+		}
+
+		void SetProtocolVersion(uint16_t version) noexcept
+		{
+			m_clDevice.SetProtocolVersion(version);
+		}
+
+		mutable unsigned m_uNumLookups = 0;
+
+	private:
+		DeviceDecoderServicesMockup m_clDevice;
+
+		std::map<dcclite::RName, std::unique_ptr<SimpleOutputDecoder>> m_mapHeads;
+};
+
+static const char *g_pszFlashingSignal = R"JSON(
+	{
+		"name":"STC_SIG_FLASH",
+		"class":"VirtualSignal",    
+		"address":"1841",  
+		"heads":
+		{
+			"red":"STC_FLASH_HR",
+			"yellow":"STC_FLASH_HY"
+		},        
+		"aspects":
+		[
+			{
+				"name":"Stop",
+				"on":["yellow"],
+				"flash":true
+			},
+			{
+				"name":"Clear",
+				"on":["red"]
+			}
+		]  
+	}
+)JSON";
+
+static std::unique_ptr<SignalDecoder> CreateSignal(const char *json, HeadsServicesMockup &services)
+{
+	Document d;
+	d.Parse(json);
+
+	return std::make_unique<SignalDecoder>(Address{ 1841 }, dcclite::RName{ "test" }, services, g_DeviceDecoderServices, d);
+}
+
+TEST(SignalDecoderTest, FlashOnDevice)
+{
+	HeadsServicesMockup services;
+
+	services.AddHead("STC_FLASH_HR", 10, false);
+	services.AddHead("STC_FLASH_HY", 11, true);
+
+	//starts on Stop, the flashing aspect
+	SignalTester tester{ CreateSignal(g_pszFlashingSignal, services) };
+
+	ASSERT_EQ(services.GetHead("STC_FLASH_HY").GetRequestedState(), dcclite::DecoderStates::ACTIVE);
+	ASSERT_EQ(services.GetHead("STC_FLASH_HR").GetRequestedState(), dcclite::DecoderStates::INACTIVE);
+
+	//device does the flashing, no toggling from here
+	ASSERT_FALSE(tester.IsBrokerFlashing());
+}
+
+TEST(SignalDecoderTest, FlashOnDeviceInit)
+{
+	HeadsServicesMockup services;
+
+	services.AddHead("STC_FLASH_HR", 10, false);
+	services.AddHead("STC_FLASH_HY", 11, true);
+
+	auto signal = CreateSignal(g_pszFlashingSignal, services);
+
+	//yellow only shows on Stop, that flashes
+	ASSERT_NO_THROW(signal->InitAfterDeviceLoad());
+}
+
+TEST(SignalDecoderTest, FlashOnBroker)
+{
+	HeadsServicesMockup services;
+
+	services.AddHead("STC_FLASH_HR", 10, false);
+	services.AddHead("STC_FLASH_HY", 11, false);
+
+	SignalTester tester{ CreateSignal(g_pszFlashingSignal, services) };
+
+	ASSERT_TRUE(tester.IsBrokerFlashing());
+}
+
+TEST(SignalDecoderTest, FlashOnOldDevice)
+{
+	HeadsServicesMockup services;
+
+	//device does not know how to flash
+	services.SetProtocolVersion(dcclite::PROTOCOL_VERSION_DEVICE_FLASH - 1);
+
+	services.AddHead("STC_FLASH_HR", 10, false);
+	services.AddHead("STC_FLASH_HY", 11, true);
+
+	SignalTester tester{ CreateSignal(g_pszFlashingSignal, services) };
+
+	ASSERT_TRUE(tester.IsBrokerFlashing());
+}
+
+TEST(SignalDecoderTest, FlashOnDeviceSteadyAspect)
+{
+	HeadsServicesMockup services;
+
+	//red is on for Clear, that does not flash
+	services.AddHead("STC_FLASH_HR", 10, true);
+	services.AddHead("STC_FLASH_HY", 11, true);
+
+	auto signal = CreateSignal(g_pszFlashingSignal, services);
+
+	ASSERT_THROW(signal->InitAfterDeviceLoad(), std::invalid_argument);
+}
+
+TEST(SignalDecoderTest, FlashOnOldDeviceSteadyAspect)
+{
+	HeadsServicesMockup services;
+
+	//the device may be updated later, so the config is still wrong
+	services.SetProtocolVersion(dcclite::PROTOCOL_VERSION_DEVICE_FLASH - 1);
+
+	services.AddHead("STC_FLASH_HR", 10, true);
+	services.AddHead("STC_FLASH_HY", 11, true);
+
+	auto signal = CreateSignal(g_pszFlashingSignal, services);
+
+	ASSERT_THROW(signal->InitAfterDeviceLoad(), std::invalid_argument);
+}
+
+TEST(SignalDecoderTest, HeadDestroyed)
+{
+	HeadsServicesMockup services;
+
+	services.AddHead("STC_FLASH_HR", 10, false);
+	services.AddHead("STC_FLASH_HY", 11, true);
+
+	auto signal = CreateSignal(g_pszFlashingSignal, services);
+	services.SyncHeads();
 
+	//device reloaded, head is gone
+	services.RemoveHead("STC_FLASH_HR");
+
+	signal->SetAspect(dcclite::SignalAspects::Clear, dcclite::RName{ "test" }, "head destroyed");
+	ASSERT_EQ(signal->GetAspect(), dcclite::SignalAspects::Clear);
+
+	services.SyncHeads();
+
+	//and back again
+	services.AddHead("STC_FLASH_HR", 10, false);
+
+	signal->SetAspect(dcclite::SignalAspects::Stop, dcclite::RName{ "test" }, "head destroyed");
+	services.SyncHeads();
+
+	signal->SetAspect(dcclite::SignalAspects::Clear, dcclite::RName{ "test" }, "head created");
+	services.SyncHeads();
+
+	ASSERT_EQ(services.GetHead("STC_FLASH_HR").GetRequestedState(), dcclite::DecoderStates::ACTIVE);
+	ASSERT_EQ(services.GetHead("STC_FLASH_HY").GetRequestedState(), dcclite::DecoderStates::INACTIVE);
+}
+
+/**
+* Lots of aspect changes with the heads answering, heads must only be looked up when the signal is created
+*/
+TEST(SignalDecoderTest, AspectChangesKeepHeads)
+{
+	constexpr unsigned NUM_CHANGES = 2000;
+
+	const auto logLevel = spdlog::get_level();
+	spdlog::set_level(spdlog::level::warn);
+
+	HeadsServicesMockup services;
+
+	services.AddHead("STC_HR12", 10, false);
+	services.AddHead("STC_HG12", 11, false);
+	services.AddHead("STC_HY12", 12, false);
+	services.AddHead("STC_BLA", 13, false);
+
+	auto signal = CreateSignal(R"JSON(
+		{
+			"name":"STC_SIG_12",
+			"class":"VirtualSignal",
+			"heads": { "red":"STC_HR12", "green":"STC_HG12", "yellow":"STC_HY12", "caution":"STC_BLA" },
+			"aspects":
+			[
+				{ "name":"Stop", "on":["red"] },
+				{ "name":"Clear", "on":["green"] },
+				{ "name":"Aproach", "on":["yellow"] },
+				{ "name":"AdvanceAproach", "on":["yellow", "caution"] }
+			]
+		}
+	)JSON", services);
+
+	services.SyncHeads();
+
+	const auto lookups = services.m_uNumLookups;
+
+	const dcclite::SignalAspects aspects[] = 
+	{
+		dcclite::SignalAspects::Clear,
+		dcclite::SignalAspects::Aproach,
+		dcclite::SignalAspects::AdvanceAproach,
+		dcclite::SignalAspects::Stop
+	};
+
+	const dcclite::RName requester{ "test" };
+
+	for (unsigned i = 0; i < NUM_CHANGES; ++i)
+	{
+		signal->SetAspect(aspects[i % std::size(aspects)], requester, "test");
+
+		services.SyncHeads();
+	}
+
+	spdlog::set_level(logLevel);
+
+	ASSERT_EQ(signal->GetAspect(), dcclite::SignalAspects::Stop);
+	ASSERT_EQ(services.GetHead("STC_HR12").GetRequestedState(), dcclite::DecoderStates::ACTIVE);
+	ASSERT_EQ(services.GetHead("STC_HG12").GetRequestedState(), dcclite::DecoderStates::INACTIVE);
+
+	ASSERT_EQ(services.m_uNumLookups, lookups);
+}
@@ -73,6 +73,14 @@ static void CheckFlags(const char *json, uint8_t flags)
 		ASSERT_TRUE(decoder.ActivateOnPowerUp());
 	}
 
+	if (flags & dcclite::OutputDecoderFlags::OUTD_FLASH)
+	{
+		ASSERT_TRUE(decoder.FlashOnDevice());
+
+		//not a DCC++ flag
+		ASSERT_FALSE(decoder.GetDccppFlags() & dcclite::OutputDecoderFlags::OUTD_FLASH);
+	}
+
 	packet.Reset();
 	ASSERT_EQ(dcclite::DecoderTypes::DEC_OUTPUT, static_cast<dcclite::DecoderTypes>(packet.Read<uint8_t>()));
 	ASSERT_EQ(Address{ 128 }, Address{ packet });
@@ -129,3 +137,55 @@ TEST(SimpleOutputDecoderTest, ActivateOnPowerUp)
 
 	CheckFlags(json, dcclite::OutputDecoderFlags::OUTD_ACTIVATE_ON_POWER_UP);
 }
+
+TEST(SimpleOutputDecoderTest, Flash)
+{
+	const char *json = R"JSON(
+		{
+			"name": "ST_PNL_EXTC_LED_TRK_07",
+			"class": "Output",
+			"address": "4467",
+			"pin": 64,
+			"flash": true
+		}
+	)JSON";
+
+	CheckFlags(json, dcclite::OutputDecoderFlags::OUTD_FLASH);
+}
+
+TEST(SimpleOutputDecoderTest, FlashOldDevice)
+{
+	const char *json = R"JSON(
+		{
+			"name": "ST_PNL_EXTC_LED_TRK_07",
+			"class": "Output",
+			"address": "4467",
+			"pin": 64,
+			"flash": true
+		}
+	)JSON";
+
+	Document d;
+	d.Parse(json);
+
+	DeviceDecoderServicesMockup oldDevice;
+	oldDevice.SetProtocolVersion(dcclite::PROTOCOL_VERSION_DEVICE_FLASH - 1);
+
+	SimpleOutputDecoder decoder{ Address{128}, dcclite::RName{"test"}, g_DecoderServices, oldDevice, d };
+
+	//broker must flash it
+	ASSERT_TRUE(decoder.HasFlashOption());
+	ASSERT_FALSE(decoder.FlashOnDevice());
+
+	dcclite::Packet packet;
+
+	decoder.WriteConfig(packet);
+
+	packet.Reset();
+	ASSERT_EQ(dcclite::DecoderTypes::DEC_OUTPUT, static_cast<dcclite::DecoderTypes>(packet.Read<uint8_t>()));
+	ASSERT_EQ(Address{ 128 }, Address{ packet });
+	ASSERT_EQ(64, packet.Read< dcclite::PinType_t>());
+
+	//the device does not know the flag
+	ASSERT_EQ(0, packet.Read<uint8_t>());
+}
@@ -0,0 +1,203 @@
+// Copyright (C) 2019 - Bruno Sanches. See the COPYRIGHT
+// file at the top-level directory of this distribution.
+//
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+//
+// This Source Code Form is "Incompatible With Secondary Licenses", as
+// defined by the Mozilla Public License, v. 2.0.
+
+#include <gtest/gtest.h>
+
+#include <dcclite/FolderObject.h>
+
+#include "sys/SubscriptionIndex.h"
+
+using namespace dcclite;
+using namespace dcclite::broker::sys;
+
+namespace
+{
+	class SignalItem: public Object
+	{
+		public:
+			explicit SignalItem(RName name):
+				Object(name)
+			{
+				//empty
+			}
+
+			const char *GetTypeName() const noexcept override
+			{
+				return "SignalDecoder";
+			}
+	};
+
+	struct Subscriber
+	{
+		int m_iId;
+	};
+
+	class SubscriptionIndexTest: public testing::Test
+	{
+		public:
+			SubscriptionIndexTest():
+				m_clRoot{ RName{"root"} }
+			{
+				m_pclDccLite = static_cast<FolderObject *>(m_clRoot.AddChild(std::make_unique<FolderObject>(RName{ "DCCLite" })));
+				m_pclDecoders = static_cast<FolderObject *>(m_pclDccLite->AddChild(std::make_unique<FolderObject>(RName{ "Decoders" })));
+
+				m_pclSignal = m_pclDecoders->AddChild(std::make_unique<SignalItem>(RName{ "signal1" }));
+				m_pclOutput = m_pclDecoders->AddChild(std::make_unique<Object>(RName{ "output1" }));
+
+				m_pclOther = m_clRoot.AddChild(std::make_unique<Object>(RName{ "other" }));
+			}
+
+		protected:
+			std::vector<Subscriber *> Find(const IObject &object) const
+			{
+				std::vector<Subscriber *> result;
+
+				m_clIndex.FindSubscribers(object, result);
+
+				return result;
+			}
+
+		protected:
+			FolderObject m_clRoot;
+
+			FolderObject	*m_pclDccLite;
+			FolderObject	*m_pclDecoders;
+			IObject			*m_pclSignal;
+			IObject			*m_pclOutput;
+			IObject			*m_pclOther;
+
+			SubscriptionIndex<Subscriber> m_clIndex;
+
+			Subscriber m_stA{ 1 };
+			Subscriber m_stB{ 2 };
+	};
+}
+
+TEST(SubscriptionFilter, Parse)
+{
+	auto filter = SubscriptionFilter::Parse("/DCCLite/Decoders/*");
+
+	ASSERT_FALSE(filter.m_fAnyPath);
+	ASSERT_TRUE(filter.m_fRecursive);
+	ASSERT_TRUE(filter.m_strType.empty());
+	ASSERT_EQ(filter.m_vecPath, (std::vector<std::string>{"DCCLite", "Decoders"}));
+
+	filter = SubscriptionFilter::Parse("/DCCLite/Decoders/signal1");
+
+	ASSERT_FALSE(filter.m_fRecursive);
+	ASSERT_EQ(filter.m_vecPath, (std::vector<std::string>{"DCCLite", "Decoders", "signal1"}));
+
+	filter = SubscriptionFilter::Parse("type=SignalDecoder");
+
+	ASSERT_TRUE(filter.m_fAnyPath);
+	ASSERT_EQ(filter.m_strType, "SignalDecoder");
+
+	filter = SubscriptionFilter::Parse("/* type=SignalDecoder");
+
+	ASSERT_FALSE(filter.m_fAnyPath);
+	ASSERT_TRUE(filter.m_fRecursive);
+	ASSERT_TRUE(filter.m_vecPath.empty());
+	ASSERT_EQ(filter.m_strType, "SignalDecoder");
+
+	ASSERT_EQ(SubscriptionFilter::Parse("/DCCLite//Decoders/"), SubscriptionFilter::Parse("/DCCLite/Decoders"));
+
+	ASSERT_THROW(SubscriptionFilter::Parse(""), std::invalid_argument);
+	ASSERT_THROW(SubscriptionFilter::Parse("   "), std::invalid_argument);
+	ASSERT_THROW(SubscriptionFilter::Parse("DCCLite"), std::invalid_argument);
+	ASSERT_THROW(SubscriptionFilter::Parse("/DCCLite/*/Decoders"), std::invalid_argument);
+	ASSERT_THROW(SubscriptionFilter::Parse("type="), std::invalid_argument);
+	ASSERT_THROW(SubscriptionFilter::Parse("type=A type=B"), std::invalid_argument);
+	ASSERT_THROW(SubscriptionFilter::Parse("/A /B"), std::invalid_argument);
+}
+
+TEST_F(SubscriptionIndexTest, Empty)
+{
+	ASSERT_TRUE(m_clIndex.IsEmpty());
+	ASSERT_TRUE(Find(*m_pclSignal).empty());
+}
+
+TEST_F(SubscriptionIndexTest, RecursivePath)
+{
+	m_clIndex.Subscribe(m_stA, SubscriptionFilter::Parse("/DCCLite/Decoders/*"));
+
+	ASSERT_EQ(Find(*m_pclSignal), std::vector<Subscriber *>{ &m_stA });
+	ASSERT_EQ(Find(*m_pclOutput), std::vector<Subscriber *>{ &m_stA });
+
+	//the folder itself is not included
+	ASSERT_TRUE(Find(*m_pclDecoders).empty());
+	ASSERT_TRUE(Find(*m_pclOther).empty());
+
+	m_clIndex.Subscribe(m_stB, SubscriptionFilter::Parse("/*"));
+
+	ASSERT_EQ(Find(*m_pclOther), std::vector<Subscriber *>{ &m_stB });
+	ASSERT_EQ(Find(*m_pclDecoders), std::vector<Subscriber *>{ &m_stB });
+	ASSERT_EQ(Find(*m_pclSignal).size(), 2u);
+}
+
+TEST_F(SubscriptionIndexTest, ExactPath)
+{
+	m_clIndex.Subscribe(m_stA, SubscriptionFilter::Parse("/DCCLite/Decoders/signal1"));
+	m_clIndex.Subscribe(m_stB, SubscriptionFilter::Parse("/DCCLite/Decoders"));
+
+	ASSERT_EQ(Find(*m_pclSignal), std::vector<Subscriber *>{ &m_stA });
+	ASSERT_EQ(Find(*m_pclDecoders), std::vector<Subscriber *>{ &m_stB });
+	ASSERT_TRUE(Find(*m_pclOutput).empty());
+
+	//filters for objects that do not exist (yet) are allowed
+	m_clIndex.Subscribe(m_stA, SubscriptionFilter::Parse("/DCCLite/Decoders/future"));
+	ASSERT_TRUE(Find(*m_pclOutput).empty());
+}
+
+TEST_F(SubscriptionIndexTest, TypeFilter)
+{
+	m_clIndex.Subscribe(m_stA, SubscriptionFilter::Parse("type=SignalDecoder"));
+	m_clIndex.Subscribe(m_stB, SubscriptionFilter::Parse("/DCCLite/* type=Object"));
+
+	ASSERT_EQ(Find(*m_pclSignal), std::vector<Subscriber *>{ &m_stA });
+	ASSERT_EQ(Find(*m_pclOutput), std::vector<Subscriber *>{ &m_stB });
+
+	//outside the path
+	ASSERT_TRUE(Find(*m_pclOther).empty());
+}
+
+TEST_F(SubscriptionIndexTest, SubscribersAreUnique)
+{
+	m_clIndex.Subscribe(m_stA, SubscriptionFilter::Parse("/*"));
+	m_clIndex.Subscribe(m_stA, SubscriptionFilter::Parse("/DCCLite/Decoders/*"));
+	m_clIndex.Subscribe(m_stA, SubscriptionFilter::Parse("/DCCLite/Decoders/signal1"));
+	m_clIndex.Subscribe(m_stA, SubscriptionFilter::Parse("type=SignalDecoder"));
+
+	ASSERT_EQ(Find(*m_pclSignal), std::vector<Subscriber *>{ &m_stA });
+}
+
+TEST_F(SubscriptionIndexTest, Unsubscribe)
+{
+	const auto decoders = SubscriptionFilter::Parse("/DCCLite/Decoders/*");
+	const auto signals = SubscriptionFilter::Parse("type=SignalDecoder");
+
+	m_clIndex.Subscribe(m_stA, decoders);
+	m_clIndex.Subscribe(m_stA, signals);
+	m_clIndex.Subscribe(m_stB, decoders);
+
+	ASSERT_TRUE(m_clIndex.Unsubscribe(m_stA, decoders));
+	ASSERT_FALSE(m_clIndex.Unsubscribe(m_stA, decoders));
+	ASSERT_FALSE(m_clIndex.Unsubscribe(m_stA, SubscriptionFilter::Parse("/DCCLite/Decoders/signal1")));
+
+	ASSERT_EQ(Find(*m_pclOutput), std::vector<Subscriber *>{ &m_stB });
+	ASSERT_EQ(Find(*m_pclSignal).size(), 2u);
+
+	m_clIndex.RemoveSubscriber(m_stB);
+
+	ASSERT_EQ(Find(*m_pclSignal), std::vector<Subscriber *>{ &m_stA });
+	ASSERT_TRUE(Find(*m_pclOutput).empty());
+
+	ASSERT_TRUE(m_clIndex.Unsubscribe(m_stA, signals));
+	ASSERT_TRUE(m_clIndex.IsEmpty());
+}
@@ -0,0 +1,270 @@
+// Copyright (C) 2019 - Bruno Sanches. See the COPYRIGHT
+// file at the top-level directory of this distribution.
+//
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+//
+// This Source Code Form is "Incompatible With Secondary Licenses", as
+// defined by the Mozilla Public License, v. 2.0.
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <dcclite/Clock.h>
+#include <dcclite/NetMessenger.h>
+#include <dcclite/Socket.h>
+
+#include <spdlog/spdlog.h>
+#include <spdlog/sinks/ringbuffer_sink.h>
+
+#include "shell/ln/ILoconetSlot.h"
+#include "shell/ln/ThrottleService.h"
+#include "sys/EventHub.h"
+#include "sys/Thinker.h"
+
+using namespace dcclite;
+using namespace dcclite::broker;
+using namespace dcclite::broker::shell::ln;
+using namespace std::chrono_literals;
+
+namespace
+{
+	class SlotMockup: public ILoconetSlot
+	{
+		public:
+			SlotMockup(const uint8_t id, const uint16_t address)
+			{
+				m_uId = id;
+				m_tLocomotiveAddress = exec::dcc::Address{ address };
+			}
+
+			void SetSpeed(const uint8_t speed)
+			{
+				m_uSpeed = speed;
+			}
+	};
+
+	class WakeTarget: public sys::EventHub::IEventTarget
+	{
+		//empty
+	};
+
+	/**
+	* Wakes the main loop, like the network threads do when posting their events
+	*/
+	class WakeEvent: public sys::EventHub::IEvent
+	{
+		public:
+			explicit WakeEvent(WakeTarget &target):
+				IEvent(target)
+			{
+				//empty
+			}
+
+			void Fire() override
+			{
+				//empty
+			}
+	};
+
+	/**
+	* Minimal WiThrottle server: handshake, heartbeat request and then it timestamps every speed command
+	*/
+	class FakeWiThrottleServer
+	{
+		public:
+			/**
+			* afterHeartBeat: lines sent on the same write as the heartbeat request
+			*/
+			explicit FakeWiThrottleServer(const int numClients, std::string afterHeartBeat = {}):
+				m_strAfterHeartBeat{ std::move(afterHeartBeat) }
+			{
+				if (!m_clListener.Open(0, Socket::Type::STREAM, Socket::FLAG_BLOCKING_MODE) || !m_clListener.Listen(numClients))
+					throw std::runtime_error("[FakeWiThrottleServer] Cannot open listener");
+
+				m_thListener = std::thread{ [this, numClients]() { this->ListenThreadProc(numClients); } };
+			}
+
+			~FakeWiThrottleServer()
+			{
+				m_thListener.join();
+
+				for (auto &t : m_vecClients)
+					t.join();
+
+				sys::EventHub::CancelEvents(m_clWakeTarget);
+			}
+
+			NetworkAddress GetAddress() const
+			{
+				return NetworkAddress{ 127, 0, 0, 1, m_clListener.GetPort().value() };
+			}
+
+			std::atomic<int> m_iNumRegistered = 0;
+			std::atomic<int> m_iNumCommands = 0;
+
+			std::atomic<Clock::DefaultClock_t::rep> m_tLastCommand = 0;
+
+		private:
+			void ListenThreadProc(const int numClients)
+			{
+				for (int i = 0; i < numClients; ++i)
+				{
+					auto [status, socket, address] = m_clListener.TryAccept();
+					if (status != Socket::Status::OK)
+						break;
+
+					m_vecClients.emplace_back([this, s = std::move(socket)]() mutable { this->ClientThreadProc(std::move(s)); });
+				}
+			}
+
+			void ClientThreadProc(Socket socket)
+			{
+				NetMessenger messenger{ std::move(socket), "\r\n" };
+
+				messenger.Send("VN2.0");
+
+				for (;;)
+				{
+					auto [status, msg] = messenger.Poll();
+					if (status != Socket::Status::OK)
+						break;
+
+					if (msg[0] == 'N')
+					{
+						messenger.Send(m_strAfterHeartBeat.empty() ? std::string{ "*10" } : "*10\r\n" + m_strAfterHeartBeat);
+					}
+					else if (msg.compare(0, 3, "MT+") == 0)
+					{
+						++m_iNumRegistered;
+
+						sys::EventHub::PostEvent<WakeEvent>(std::ref(m_clWakeTarget));
+					}
+					else if (msg.compare(0, 8, "MTA*<;>V") == 0)
+					{
+						m_tLastCommand = Clock::DefaultClock_t::now().time_since_epoch().count();
+						++m_iNumCommands;
+
+						sys::EventHub::PostEvent<WakeEvent>(std::ref(m_clWakeTarget));
+					}
+				}
+			}
+
+		private:
+			const std::string			m_strAfterHeartBeat;
+
+			WakeTarget					m_clWakeTarget;
+
+			Socket						m_clListener;
+			std::thread					m_thListener;
+
+			std::vector<std::thread>	m_vecClients;
+	};
+
+	/**
+	* Runs the broker main loop (thinkers and events) until the predicate is satisfied or the timeout expires
+	*
+	* Returns how many times the loop woke up
+	*/
+	unsigned RunLoop(std::function<bool()> predicate, const Clock::DefaultClock_t::duration timeout)
+	{
+		const auto deadline = Clock::DefaultClock_t::now() + timeout;
+
+		unsigned numWakeups = 0;
+
+		while (!predicate())
+		{
+			const auto now = Clock::DefaultClock_t::now();
+			if (now >= deadline)
+				break;
+
+			auto nextThink = sys::Thinker::UpdateThinkers(now);
+
+			sys::EventHub::PumpEvents(nextThink ? std::min(nextThink.value(), deadline) : deadline);
+
+			++numWakeups;
+		}
+
+		return numWakeups;
+	}
+}
+
+TEST(ThrottleService, SendsCommands)
+{
+	constexpr auto NUM_THROTTLES = 3;
+	constexpr auto NUM_COMMANDS = 9;
+
+	FakeWiThrottleServer server{ NUM_THROTTLES };
+
+	std::vector<std::unique_ptr<SlotMockup>> slots;
+	std::vector<std::unique_ptr<IThrottle>> throttles;
+
+	for (int i = 0; i < NUM_THROTTLES; ++i)
+	{
+		slots.push_back(std::make_unique<SlotMockup>(static_cast<uint8_t>(i + 1), static_cast<uint16_t>(100 + i)));
+		throttles.push_back(MakeThrottle(server.GetAddress(), *slots.back()));
+	}
+
+	RunLoop([&server]() { return server.m_iNumRegistered == NUM_THROTTLES; }, 5s);
+	ASSERT_EQ(server.m_iNumRegistered, NUM_THROTTLES);
+
+	//each speed change reaches the server, one at a time
+	for (int i = 0; i < NUM_COMMANDS; ++i)
+	{
+		slots[i % NUM_THROTTLES]->SetSpeed(static_cast<uint8_t>(i + 1));
+		throttles[i % NUM_THROTTLES]->OnSpeedChange();
+
+		RunLoop([&server, i]() { return server.m_iNumCommands == i + 1; }, 5s);
+		ASSERT_EQ(server.m_iNumCommands, i + 1);
+	}
+
+	throttles.clear();
+}
+
+TEST(ThrottleService, LinesAfterHeartBeat)
+{
+	//the server is silent after this, so the message is only seen if it is parsed from the same read
+	FakeWiThrottleServer server{ 1, "HMLate message" };
+
+	auto sink = std::make_shared<spdlog::sinks::ringbuffer_sink_mt>(32);
+	spdlog::default_logger()->sinks().push_back(sink);
+
+	SlotMockup slot{ 1, 3 };
+	auto throttle = MakeThrottle(server.GetAddress(), slot);
+
+	RunLoop([&server]() { return server.m_iNumRegistered == 1; }, 5s);
+
+	throttle.reset();
+	spdlog::default_logger()->sinks().pop_back();
+
+	ASSERT_EQ(server.m_iNumRegistered, 1);
+
+	const auto lines = sink->last_formatted();
+	ASSERT_NE(std::find_if(lines.begin(), lines.end(), [](const std::string &line) { return line.find("got error message from server: Late message") != std::string::npos; }), lines.end());
+}
+
+TEST(ThrottleService, ConnectionRefused)
+{
+	//grab a free port and release it, so nobody is listening there
+	Socket probe;
+	ASSERT_TRUE(probe.Open(0, Socket::Type::STREAM));
+
+	const NetworkAddress address{ 127, 0, 0, 1, probe.GetPort().value() };
+	probe.Close();
+
+	SlotMockup slot{ 1, 3 };
+
+	auto throttle = MakeThrottle(address, slot);
+
+	//the failure is reported by the reactor, nothing should be thrown and commands are ignored
+	ASSERT_NO_THROW(RunLoop([]() { return false; }, 100ms));
+	ASSERT_NO_THROW(throttle->OnSpeedChange());
+}
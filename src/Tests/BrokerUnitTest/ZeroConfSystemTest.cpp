@@ -0,0 +1,151 @@
+// Copyright (C) 2019 - Bruno Sanches. See the COPYRIGHT
+// file at the top-level directory of this distribution.
+//
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+//
+// This Source Code Form is "Incompatible With Secondary Licenses", as
+// defined by the Mozilla Public License, v. 2.0.
+
+#include <gtest/gtest.h>
+
+#include <optional>
+#include <string>
+#include <string_view>
+#include <thread>
+
+#include <dcclite/Clock.h>
+#include <dcclite/Socket.h>
+
+#include <dcclite_shared/Packet.h>
+#include <dcclite_shared/SharedLibDefs.h>
+
+#include "sys/ZeroConfSystem.h"
+
+using namespace dcclite;
+using namespace dcclite::broker::sys;
+using namespace std::chrono_literals;
+
+static constexpr uint32_t PACKET_MAGIC_NUMBER = 0xABCDDCCA;
+static constexpr uint8_t PACKET_VERSION = 0x01;
+static constexpr uint8_t FLAG_QUERY = 0x01;
+
+namespace
+{
+	struct Reply
+	{
+		std::string m_strServiceName;
+		uint16_t	m_uPort;
+		std::string m_strProjectName;
+	};
+
+	/**
+	* A device looking for the broker, but on loopback, so no broadcast or multicast is needed
+	*/
+	class ZeroConfClient
+	{
+		public:
+			ZeroConfClient()
+			{
+				if (!m_clSocket.Open(0, Socket::Type::DATAGRAM))
+					throw std::runtime_error("[ZeroConfClient] Cannot open socket");
+			}
+
+			void SendQuery(const std::string_view serviceName)
+			{
+				BasePacket<192> packet;
+
+				packet.Write32(PACKET_MAGIC_NUMBER);
+				packet.Write8(PACKET_VERSION);
+				packet.Write8(FLAG_QUERY);
+
+				for (auto ch : serviceName)
+					packet.Write8(ch);
+
+				packet.Write8(0);
+
+				m_clSocket.Send(NetworkAddress{ 127, 0, 0, 1, DEFAULT_ZEROCONF_PORT }, packet.GetData(), packet.GetSize());
+			}
+
+			std::optional<Reply> TryReceive()
+			{
+				uint8_t buffer[192];
+				NetworkAddress sender;
+
+				auto [status, size] = m_clSocket.Receive(sender, buffer, sizeof(buffer), true);
+				if (status != Socket::Status::OK)
+					return std::nullopt;
+
+				BasePacket<192> packet{ buffer, static_cast<uint8_t>(size) };
+
+				if ((packet.Read<uint32_t>() != PACKET_MAGIC_NUMBER) || (packet.Read<uint8_t>() != PACKET_VERSION) || (packet.Read<uint8_t>() & FLAG_QUERY))
+					return std::nullopt;
+
+				Reply reply;
+
+				for (char ch = packet.ReadByte(); ch; ch = packet.ReadByte())
+					reply.m_strServiceName.push_back(ch);
+
+				reply.m_uPort = packet.Read<uint16_t>();
+
+				for (char ch = packet.ReadByte(); ch; ch = packet.ReadByte())
+					reply.m_strProjectName.push_back(ch);
+
+				return reply;
+			}
+
+			std::optional<Reply> WaitReply(const Clock::DefaultClock_t::duration timeout)
+			{
+				const auto deadline = Clock::DefaultClock_t::now() + timeout;
+
+				do
+				{
+					if (auto reply = this->TryReceive())
+						return reply;
+
+					std::this_thread::yield();
+				} while (Clock::DefaultClock_t::now() < deadline);
+
+				return std::nullopt;
+			}
+
+		private:
+			Socket m_clSocket;
+	};
+}
+
+TEST(ZeroConfSystem, QueryReply)
+{
+	//registered before start, the reply must still carry the project name
+	ZeroConfSystem::Register("TestBroker", 4190);
+
+	ZeroConfSystem::Start("TestProject");
+
+	ZeroConfClient client;
+
+	client.SendQuery("TestBroker");
+
+	auto reply = client.WaitReply(1s);
+	ASSERT_TRUE(reply.has_value());
+	ASSERT_EQ(reply->m_strServiceName, "TestBroker");
+	ASSERT_EQ(reply->m_uPort, 4190);
+	ASSERT_EQ(reply->m_strProjectName, "TestProject");
+
+	//unknown services are ignored
+	client.SendQuery("Nobody");
+	ASSERT_FALSE(client.WaitReply(50ms).has_value());
+
+	//registering after start makes it visible immediately
+	ZeroConfSystem::Register("LateService", 2560);
+	ASSERT_THROW(ZeroConfSystem::Register("LateService", 2561), std::runtime_error);
+
+	client.SendQuery("LateService");
+
+	reply = client.WaitReply(1s);
+	ASSERT_TRUE(reply.has_value());
+	ASSERT_EQ(reply->m_strServiceName, "LateService");
+	ASSERT_EQ(reply->m_uPort, 2560);
+
+	ZeroConfSystem::Stop();
+}
@@ -19,6 +19,7 @@
 #include <Console.h>
 #include <Storage.h>
 #include <SensorDecoder.h>
+#include <SensorSampler.h>
 
 #include <dcclite_shared/Packet.h>
 
@@ -44,6 +45,8 @@ class MiniDuino
 	{
 		auto ticks = millis();
 
+		SensorSampler::Update();
+
 		for (auto dec : g_pclSingleton->m_vecDecoders)
 		{
 			dec->Update(ticks);
@@ -91,9 +94,13 @@ bool Console::Custom_ParseCommand(dcclite::StringView command)
 	return false;
 }
 
+//used by StorageTest to grow the config
+unsigned g_uStorageTestConfigPadding = 0;
+
 void Storage::Custom_SaveModules(Storage::EpromStream &stream)
 {
-
+	for (unsigned i = 0; i < g_uStorageTestConfigPadding; ++i)
+		stream.Put(static_cast<unsigned char>(0));
 }
 
 TEST(LiteDecoder, SensorTest_Default)
@@ -614,4 +621,160 @@ TEST(LiteDecoder, SensorTest_DeactivateDelay)
 		ASSERT_FALSE(remoteDecoder.IsCoolDownActive());
 		ASSERT_FALSE(remoteDecoder.IsDelayActive());		
 	}
-}
\ No newline at end of file
+}
+TEST(LiteDecoder, SensorSampler_PortBatch)
+{
+	MiniDuino board;
+
+	//two pins on the same port and one far away
+	pinMode(8, INPUT);
+	pinMode(9, INPUT);
+	pinMode(63, INPUT);
+
+	const auto pin8 = SensorSampler::Register(8);
+	const auto pin9 = SensorSampler::Register(9);
+	const auto pin63 = SensorSampler::Register(63);
+
+	ASSERT_EQ(pin8.m_u8Port, pin9.m_u8Port);
+	ASSERT_NE(pin8.m_u8Port, pin63.m_u8Port);
+
+	//no interrupts, so always reading
+	ASSERT_TRUE(SensorSampler::IsPolling());
+
+	const auto samples = SensorSampler::GetNumSamples();
+
+	ArduinoLib::SetPinDigitalVoltage(9, VoltageModes::HIGH);
+	ArduinoLib::SetPinDigitalVoltage(63, VoltageModes::HIGH);
+
+	//not sampled yet
+	ASSERT_FALSE(SensorSampler::Read(pin9));
+
+	SensorSampler::Update();
+	ASSERT_EQ(SensorSampler::GetNumSamples(), samples + 1);
+
+	ASSERT_FALSE(SensorSampler::Read(pin8));
+	ASSERT_TRUE(SensorSampler::Read(pin9));
+	ASSERT_TRUE(SensorSampler::Read(pin63));
+
+	ASSERT_FALSE(SensorSampler::HasChanged(pin8));
+	ASSERT_TRUE(SensorSampler::HasChanged(pin9));
+	ASSERT_TRUE(SensorSampler::HasChanged(pin63));
+
+	//changes are only reported once
+	SensorSampler::Update();
+	ASSERT_EQ(SensorSampler::GetNumSamples(), samples + 2);
+	ASSERT_TRUE(SensorSampler::Read(pin9));
+	ASSERT_FALSE(SensorSampler::HasChanged(pin9));
+	ASSERT_FALSE(SensorSampler::HasChanged(pin63));
+
+	SensorSampler::Unregister(8);
+	SensorSampler::Unregister(9);
+	SensorSampler::Unregister(63);
+
+	//not sampled anymore
+	ASSERT_FALSE(SensorSampler::Read(pin9));
+}
+
+TEST(LiteDecoder, SensorSampler_Interrupts)
+{
+	MiniDuino board;
+
+	pinMode(3, INPUT);
+	pinMode(4, INPUT);
+
+	const auto pin3 = SensorSampler::Register(3);
+	const auto pin4 = SensorSampler::Register(4);
+
+	SensorSampler::EnableInterrupts();
+	ASSERT_FALSE(SensorSampler::IsPolling());
+
+	//first update always reads
+	auto samples = SensorSampler::GetNumSamples();
+	SensorSampler::Update();
+	ASSERT_EQ(SensorSampler::GetNumSamples(), ++samples);
+
+	//idle, ports are not touched
+	for (int i = 0; i < 100; ++i)
+		SensorSampler::Update();
+
+	ASSERT_EQ(SensorSampler::GetNumSamples(), samples);
+
+	ArduinoLib::SetPinDigitalVoltage(4, VoltageModes::HIGH);
+
+	SensorSampler::Update();
+	ASSERT_EQ(SensorSampler::GetNumSamples(), ++samples);
+	ASSERT_FALSE(SensorSampler::Read(pin3));
+	ASSERT_TRUE(SensorSampler::Read(pin4));
+	ASSERT_TRUE(SensorSampler::HasChanged(pin4));
+
+	//idle again, state is kept but change is gone
+	SensorSampler::Update();
+	ASSERT_EQ(SensorSampler::GetNumSamples(), samples);
+	ASSERT_TRUE(SensorSampler::Read(pin4));
+	ASSERT_FALSE(SensorSampler::HasChanged(pin4));
+
+	//a pin without pin change interrupt forces polling
+	pinMode(40, INPUT);
+	SensorSampler::Register(40);
+	ASSERT_TRUE(SensorSampler::IsPolling());
+
+	SensorSampler::Update();
+	SensorSampler::Update();
+	ASSERT_EQ(SensorSampler::GetNumSamples(), samples + 2);
+
+	SensorSampler::Unregister(40);
+	ASSERT_FALSE(SensorSampler::IsPolling());
+
+	SensorSampler::DisableInterrupts();
+	ASSERT_TRUE(SensorSampler::IsPolling());
+
+	SensorSampler::Unregister(3);
+	SensorSampler::Unregister(4);
+}
+
+TEST(LiteDecoder, SensorSampler_DecoderWithInterrupts)
+{
+	MiniDuino board;
+
+	SensorDecoder decoder{ 0, 5 };
+
+	board.AddDecoder(decoder);
+
+	SensorSampler::EnableInterrupts();
+
+	ArduinoLib::FixedTick(1);
+	ASSERT_FALSE(decoder.IsActive());
+	ASSERT_FALSE(decoder.IsCoolDownActive());
+
+	//idle, no sampling
+	const auto samples = SensorSampler::GetNumSamples();
+	ArduinoLib::FixedTick(1);
+	ArduinoLib::FixedTick(1);
+	ASSERT_EQ(SensorSampler::GetNumSamples(), samples);
+
+	ArduinoLib::SetPinDigitalVoltage(5, VoltageModes::HIGH);
+
+	//cool down, same as polling
+	ArduinoLib::FixedTick(1);
+	ASSERT_FALSE(decoder.IsActive());
+	ASSERT_TRUE(decoder.IsCoolDownActive());
+
+	ArduinoLib::FixedTick(30);
+	ASSERT_TRUE(decoder.IsActive());
+	ASSERT_FALSE(decoder.IsCoolDownActive());
+
+	//a single read for the change
+	ASSERT_EQ(SensorSampler::GetNumSamples(), samples + 1);
+
+	ArduinoLib::SetPinDigitalVoltage(5, VoltageModes::LOW);
+
+	ArduinoLib::FixedTick(1);
+	ASSERT_TRUE(decoder.IsActive());
+	ASSERT_TRUE(decoder.IsCoolDownActive());
+
+	ArduinoLib::FixedTick(30);
+	ASSERT_FALSE(decoder.IsActive());
+	ASSERT_FALSE(decoder.IsCoolDownActive());
+
+	SensorSampler::DisableInterrupts();
+}
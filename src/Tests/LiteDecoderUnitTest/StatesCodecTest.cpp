@@ -0,0 +1,210 @@
+// Copyright (C) 2019 - Bruno Sanches. See the COPYRIGHT
+// file at the top-level directory of this distribution.
+//
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+//
+// This Source Code Form is "Incompatible With Secondary Licenses", as
+// defined by the Mozilla Public License, v. 2.0.
+
+#include <random>
+
+#include <gtest/gtest.h>
+
+#include <dcclite_shared/Packet.h>
+#include <dcclite_shared/StatesCodec.h>
+
+using namespace dcclite;
+
+static StatesBitPack_t MakePack(std::initializer_list<unsigned> bits)
+{
+	StatesBitPack_t pack;
+
+	for (auto bit : bits)
+		pack.SetBit(bit);
+
+	return pack;
+}
+
+/**
+* Encodes and decodes, checking that what comes out is what went in, returns the encoded size
+*/
+static unsigned RoundTrip(const StatesBitPack_t &changedStates, const StatesBitPack_t &states)
+{
+	Packet packet;
+	StatesCodec::Write(packet, changedStates, states);
+
+	const unsigned size = packet.GetSize();
+
+	packet.Reset();
+
+	StatesBitPack_t decodedChanges, decodedStates;
+	EXPECT_TRUE(StatesCodec::Read(packet, decodedChanges, decodedStates));
+	EXPECT_EQ(packet.GetSize(), size);
+
+	EXPECT_EQ(decodedChanges, changedStates);
+
+	//states of unchanged decoders are not sent, so compare only what changed
+	for (unsigned i = 0; i < changedStates.size(); ++i)
+	{
+		if (changedStates[i])
+		{
+			EXPECT_EQ(decodedStates[i], states[i]) << "at index " << i;
+		}
+	}
+
+	return size;
+}
+
+TEST(StatesCodec, SingleChange)
+{
+	auto changed = MakePack({ 42 });
+	auto states = MakePack({ 42 });
+
+	ASSERT_EQ(StatesCodec::SelectEncoding(changed, states), StatesEncoding::SPARSE);
+
+	//encoding + count + one entry, instead of 16 bytes
+	ASSERT_EQ(RoundTrip(changed, states), 3u);
+
+	states.ClearAll();
+	ASSERT_EQ(RoundTrip(changed, states), 3u);
+}
+
+TEST(StatesCodec, NoChanges)
+{
+	StatesBitPack_t changed, states;
+
+	ASSERT_EQ(RoundTrip(changed, states), 2u);
+}
+
+TEST(StatesCodec, FullRefresh)
+{
+	//a device sending everything, long runs of the same state, like after a SYNC
+	StatesBitPack_t changed, states;
+	for (unsigned i = 0; i < 48; ++i)
+	{
+		changed.SetBit(i);
+		states.SetBitValue(i, i >= 40);
+	}
+
+	ASSERT_EQ(StatesCodec::SelectEncoding(changed, states), StatesEncoding::RLE);
+	ASSERT_EQ(RoundTrip(changed, states), 4u);
+
+	//all 64 in a single run
+	for (unsigned i = 0; i < 64; ++i)
+		changed.SetBit(i);
+	states.ClearAll();
+
+	ASSERT_EQ(RoundTrip(changed, states), 3u);
+}
+
+TEST(StatesCodec, Noisy)
+{
+	//alternating states do not compress, must fall back to bitmap
+	StatesBitPack_t changed, states;
+	for (unsigned i = 0; i < 64; ++i)
+	{
+		changed.SetBit(i);
+		states.SetBitValue(i, i & 1);
+	}
+
+	ASSERT_EQ(StatesCodec::SelectEncoding(changed, states), StatesEncoding::BITMAP);
+	ASSERT_EQ(RoundTrip(changed, states), 17u);
+}
+
+TEST(StatesCodec, RandomRoundTrip)
+{
+	std::mt19937 rng{ 2024 };
+
+	for (int round = 0; round < 20000; ++round)
+	{
+		//vary the density, so all encodings are used
+		std::bernoulli_distribution changeDist{ (round % 64) / 63.0 };
+		std::bernoulli_distribution stateDist{ (round % 3) ? 0.5 : 0.05 };
+
+		StatesBitPack_t changed, states;
+		for (unsigned i = 0; i < changed.size(); ++i)
+		{
+			changed.SetBitValue(i, changeDist(rng));
+			states.SetBitValue(i, stateDist(rng));
+		}
+
+		//never worse than the old format plus the encoding byte
+		ASSERT_LE(RoundTrip(changed, states), changed.GetNumBytes() + states.GetNumBytes() + 1);
+	}
+}
+
+TEST(StatesCodec, Fuzz)
+{
+	std::mt19937 rng{ 1977 };
+	std::uniform_int_distribution<int> byteDist{ 0, 255 };
+	std::uniform_int_distribution<int> sizeDist{ 0, PACKET_MAX_SIZE - 1 };
+
+	unsigned accepted = 0;
+
+	for (int round = 0; round < 50000; ++round)
+	{
+		Packet packet;
+
+		//random garbage, but with a valid encoding most of the time
+		packet.Write8(static_cast<uint8_t>(round % 4));
+
+		const int size = sizeDist(rng);
+		for (int i = 1; i < size; ++i)
+			packet.Write8(static_cast<uint8_t>(byteDist(rng)));
+
+		//garbage at the end of the packet, reader must not go past it
+		packet.Seek(static_cast<uint8_t>(round % 2 ? 0 : PACKET_MAX_SIZE - 1 - (round % 20)));
+
+		StatesBitPack_t changed, states;
+		if (!StatesCodec::Read(packet, changed, states))
+			continue;
+
+		++accepted;
+
+		ASSERT_LT(packet.GetSize(), PACKET_MAX_SIZE);
+	}
+
+	//not everything is rejected
+	ASSERT_GT(accepted, 0u);
+}
+
+TEST(StatesCodec, InvalidData)
+{
+	Packet packet;
+
+	//unknown encoding
+	packet.Write8(7);
+	packet.Reset();
+
+	StatesBitPack_t changed, states;
+	ASSERT_FALSE(StatesCodec::Read(packet, changed, states));
+
+	//run past the last decoder
+	packet.Reset();
+	packet.Write8(static_cast<uint8_t>(StatesEncoding::RLE));
+	packet.Write8(2);
+	packet.Write8((1 << 6) | 63);
+	packet.Write8((1 << 6) | 0);
+	packet.Reset();
+
+	ASSERT_FALSE(StatesCodec::Read(packet, changed, states));
+
+	//invalid symbol
+	packet.Reset();
+	packet.Write8(static_cast<uint8_t>(StatesEncoding::RLE));
+	packet.Write8(1);
+	packet.Write8(3 << 6);
+	packet.Reset();
+
+	ASSERT_FALSE(StatesCodec::Read(packet, changed, states));
+
+	//more entries than decoders
+	packet.Reset();
+	packet.Write8(static_cast<uint8_t>(StatesEncoding::SPARSE));
+	packet.Write8(65);
+	packet.Reset();
+
+	ASSERT_FALSE(StatesCodec::Read(packet, changed, states));
+}
@@ -0,0 +1,129 @@
+// Copyright (C) 2019 - Bruno Sanches. See the COPYRIGHT
+// file at the top-level directory of this distribution.
+//
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+//
+// This Source Code Form is "Incompatible With Secondary Licenses", as
+// defined by the Mozilla Public License, v. 2.0.
+
+#include <gtest/gtest.h>
+
+#include "StaticPool.h"
+
+static int g_iNumAlive = 0;
+
+class PoolBase
+{
+	public:
+		PoolBase()
+		{
+			++g_iNumAlive;
+		}
+
+		virtual ~PoolBase()
+		{
+			--g_iNumAlive;
+		}
+
+		virtual int GetValue() const = 0;
+};
+
+class SmallObject : public PoolBase
+{
+	public:
+		explicit SmallObject(int value) :
+			m_iValue{ value }
+		{
+			//empty
+		}
+
+		int GetValue() const override
+		{
+			return m_iValue;
+		}
+
+	private:
+		int m_iValue;
+};
+
+struct Padding
+{
+	virtual ~Padding() = default;
+
+	double m_arData[4] = { 0 };
+};
+
+//base is not at the start of the object
+class BigObject : public Padding, public PoolBase
+{
+	public:
+		BigObject(int a, int b) :
+			m_iValue{ a + b }
+		{
+			//empty
+		}
+
+		int GetValue() const override
+		{
+			return m_iValue;
+		}
+
+	private:
+		int m_iValue;
+};
+
+typedef StaticPool<PoolBase, 3, SmallObject, BigObject> TestPool_t;
+
+TEST(StaticPool, Layout)
+{
+	static_assert(TestPool_t::CELL_SIZE == sizeof(BigObject), "cell must fit the biggest type");
+	static_assert(TestPool_t::CELL_ALIGN == alignof(BigObject), "cell must use the strictest alignment");
+	static_assert(TestPool_t::STORAGE_SIZE >= 3 * sizeof(BigObject), "one cell per object");
+	static_assert(TestPool_t::NUM_CELLS == 3, "capacity");
+}
+
+TEST(StaticPool, NewDelete)
+{
+	TestPool_t pool;
+
+	ASSERT_EQ(pool.GetNumUsed(), 0);
+
+	PoolBase *a = pool.New<SmallObject>(1);
+	PoolBase *b = pool.New<BigObject>(2, 3);
+	PoolBase *c = pool.New<SmallObject>(4);
+
+	ASSERT_NE(a, nullptr);
+	ASSERT_NE(b, nullptr);
+	ASSERT_NE(c, nullptr);
+
+	ASSERT_EQ(a->GetValue(), 1);
+	ASSERT_EQ(b->GetValue(), 5);
+	ASSERT_EQ(c->GetValue(), 4);
+
+	ASSERT_EQ(g_iNumAlive, 3);
+	ASSERT_TRUE(pool.IsFull());
+	ASSERT_EQ(pool.New<SmallObject>(5), nullptr);
+
+	//base at an offset must free the right cell
+	pool.Delete(b);
+	ASSERT_EQ(g_iNumAlive, 2);
+	ASSERT_FALSE(pool.IsFull());
+
+	b = pool.New<BigObject>(10, 10);
+	ASSERT_NE(b, nullptr);
+	ASSERT_EQ(b->GetValue(), 20);
+
+	//a and c untouched
+	ASSERT_EQ(a->GetValue(), 1);
+	ASSERT_EQ(c->GetValue(), 4);
+
+	pool.Delete(nullptr);
+	pool.Delete(a);
+	pool.Delete(b);
+	pool.Delete(c);
+
+	ASSERT_EQ(g_iNumAlive, 0);
+	ASSERT_EQ(pool.GetNumUsed(), 0);
+}
@@ -0,0 +1,204 @@
+// Copyright (C) 2019 - Bruno Sanches. See the COPYRIGHT
+// file at the top-level directory of this distribution.
+//
+// This Source Code Form is subject to the terms of the Mozilla Public
+// License, v. 2.0. If a copy of the MPL was not distributed with this
+// file, You can obtain one at http://mozilla.org/MPL/2.0/.
+//
+// This Source Code Form is "Incompatible With Secondary Licenses", as
+// defined by the Mozilla Public License, v. 2.0.
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+
+#include <Arduino.h>
+#include <EEPROM.h>
+
+#include <Storage.h>
+
+//see SensorTest.cpp
+extern unsigned g_uStorageTestConfigPadding;
+
+//some byte inside the config area
+constexpr unsigned FIELD_INDEX = 100;
+
+//enough time for the fields to be considered idle
+constexpr unsigned long IDLE_TIME = 10000;
+
+static void UpdateUntilIdle(int maxSteps = 256)
+{
+	for (int i = 0; i < maxSteps; ++i)
+		Storage::Update(millis() + IDLE_TIME);
+}
+
+static unsigned GetMaxWriteCount()
+{
+	unsigned result = 0;
+
+	for (size_t i = 0; i < EEPROM.length(); ++i)
+		result = std::max(result, EEPROM.getWriteCount(i));
+
+	return result;
+}
+
+static unsigned GetTotalWriteCount()
+{
+	unsigned result = 0;
+
+	for (size_t i = 0; i < EEPROM.length(); ++i)
+		result += EEPROM.getWriteCount(i);
+
+	return result;
+}
+
+class StorageStateLogTest : public ::testing::Test
+{
+	protected:
+		void SetUp() override
+		{
+			EEPROM.update(FIELD_INDEX, 0);
+
+			Storage::ResetStateLog();
+			EEPROM.resetWriteCounts();
+		}
+};
+
+TEST_F(StorageStateLogTest, Coalesce)
+{
+	for (int i = 0; i < 50; ++i)
+		Storage::UpdateField(FIELD_INDEX, static_cast<unsigned char>(i));
+
+	//not idle yet, nothing written
+	Storage::Update(millis());
+	ASSERT_EQ(GetTotalWriteCount(), 0);
+
+	UpdateUntilIdle();
+
+	//a single record: crc invalidate, 5 data bytes and the crc, config untouched
+	ASSERT_LE(GetTotalWriteCount(), 7);
+	ASSERT_EQ(EEPROM.getWriteCount(FIELD_INDEX), 0);
+
+	Storage::LoadStateLog();
+	ASSERT_EQ(EEPROM.read(FIELD_INDEX), 49);
+}
+
+TEST_F(StorageStateLogTest, WearLeveling)
+{
+	constexpr int NUM_CHANGES = 200;
+
+	for (int i = 0; i < NUM_CHANGES; ++i)
+	{
+		Storage::UpdateField(FIELD_INDEX, static_cast<unsigned char>(i & 1 ? 3 : 2));
+		UpdateUntilIdle(8);
+	}
+
+	ASSERT_EQ(EEPROM.getWriteCount(FIELD_INDEX), 0);
+
+	//writing straight to the field would be NUM_CHANGES writes on the same cell
+	ASSERT_LT(GetMaxWriteCount(), NUM_CHANGES / 10);
+
+	//ring wrapped many times, newest must win
+	Storage::LoadStateLog();
+	ASSERT_EQ(EEPROM.read(FIELD_INDEX), 3);
+
+	//log keeps going after a reboot
+	Storage::UpdateField(FIELD_INDEX, 7);
+	UpdateUntilIdle();
+
+	Storage::LoadStateLog();
+	ASSERT_EQ(EEPROM.read(FIELD_INDEX), 7);
+}
+
+TEST_F(StorageStateLogTest, RingKeepsOldFields)
+{
+	Storage::UpdateField(FIELD_INDEX, 5);
+	UpdateUntilIdle();
+
+	//other fields keep changing until the ring wraps over the only record of the first field
+	for (int i = 0; i < 80; ++i)
+	{
+		Storage::UpdateField(FIELD_INDEX + 1 + (i % 4), static_cast<unsigned char>(i));
+		UpdateUntilIdle(8);
+	}
+
+	//written back to the config once, when its record was reused
+	ASSERT_EQ(EEPROM.getWriteCount(FIELD_INDEX), 1);
+
+	//the others always had a newer record, so their config is untouched
+	for (unsigned i = 1; i <= 4; ++i)
+		ASSERT_EQ(EEPROM.getWriteCount(FIELD_INDEX + i), 0);
+
+	Storage::LoadStateLog();
+	ASSERT_EQ(EEPROM.read(FIELD_INDEX), 5);
+
+	for (unsigned i = 1; i <= 4; ++i)
+		ASSERT_EQ(EEPROM.read(FIELD_INDEX + i), 76 + i - 1);
+}
+
+TEST_F(StorageStateLogTest, TornRecord)
+{
+	Storage::UpdateField(FIELD_INDEX, 5);
+	UpdateUntilIdle();
+
+	//power loss in the middle of the next record
+	Storage::UpdateField(FIELD_INDEX, 9);
+	for (int i = 0; i < 4; ++i)
+		Storage::Update(millis() + IDLE_TIME);
+
+	Storage::LoadStateLog();
+	ASSERT_EQ(EEPROM.read(FIELD_INDEX), 5);
+}
+
+TEST_F(StorageStateLogTest, ResetInvalidates)
+{
+	Storage::UpdateField(FIELD_INDEX, 5);
+	UpdateUntilIdle();
+
+	//new config saved with the field
+	Storage::ResetStateLog();
+	EEPROM.update(FIELD_INDEX, 1);
+
+	Storage::LoadStateLog();
+	ASSERT_EQ(EEPROM.read(FIELD_INDEX), 1);
+}
+
+TEST_F(StorageStateLogTest, Flush)
+{
+	for (unsigned i = 0; i < 20; ++i)
+		Storage::UpdateField(FIELD_INDEX + i, static_cast<unsigned char>(i + 1));
+
+	//cache overflow already wrote some, flush writes the rest
+	Storage::Flush();
+
+	Storage::LoadStateLog();
+
+	for (unsigned i = 0; i < 20; ++i)
+		ASSERT_EQ(EEPROM.read(FIELD_INDEX + i), i + 1);
+}
+
+TEST_F(StorageStateLogTest, ConfigOverlapsStateLog)
+{
+	g_uStorageTestConfigPadding = 0;
+	ASSERT_TRUE(Storage::SaveConfig());
+	ASSERT_TRUE(Storage::LoadConfig());
+
+	Storage::UpdateField(FIELD_INDEX, 5);
+	UpdateUntilIdle();
+
+	//way past the state log start
+	g_uStorageTestConfigPadding = static_cast<unsigned>(EEPROM.length() - 64);
+
+	const bool saved = Storage::SaveConfig();
+	g_uStorageTestConfigPadding = 0;
+
+	ASSERT_FALSE(saved);
+
+	//nothing half written is taken as a valid config
+	ASSERT_FALSE(Storage::LoadConfig());
+
+	//old records are gone, they were saved for the previous config
+	EEPROM.update(FIELD_INDEX, 1);
+	Storage::LoadStateLog();
+	ASSERT_EQ(EEPROM.read(FIELD_INDEX), 1);
+}
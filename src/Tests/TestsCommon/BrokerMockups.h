@@ -11,6 +11,7 @@
 #pragma once
 
 #include <map>
+#include <stdexcept>
 #include <vector>
 
 #include "exec/dcc/Decoder.h"
@@ -19,6 +20,8 @@
 
 #include <dcclite/RName.h>
 
+#include <dcclite_shared/Packet.h>
+
 namespace dcclite::broker::exec::dcc
 {
 	class Decoder;
@@ -47,7 +50,7 @@ class NetworkDeviceDecoderServicesMockup: public dcclite::broker::exec::dcc::INe
 			auto it = m_mapDecoders.find(name);
 			if (it == m_mapDecoders.end())
 			{
-				throw std::exception("Decoder not found");
+				throw std::runtime_error("Decoder not found");
 			}
 
 			return *(it->second);
@@ -57,24 +60,26 @@ class NetworkDeviceDecoderServicesMockup: public dcclite::broker::exec::dcc::INe
 		{
 			auto it = std::find(m_vecDecoders.begin(), m_vecDecoders.end(), &decoder);
 			if (it == m_vecDecoders.end())
-				throw std::exception("Decoder not registered");
+				throw std::runtime_error("Decoder not registered");
 
 			if (m_vecDecoders.size() > 255)
-				throw std::exception("too many decoders, which arduino are you using?");
+				throw std::runtime_error("too many decoders, which arduino are you using?");
 
 			return static_cast<uint8_t>(it - m_vecDecoders.begin());
 		}
 
 		[[nodiscard]] uint16_t GetProtocolVersion() const noexcept override
 		{
-			return 0;
+			return m_uProtocolVersion;
 		}
 
+		uint16_t m_uProtocolVersion = dcclite::PROTOCOL_VERSION;
+
 		void RegisterDecoder(dcclite::broker::exec::dcc::Decoder &decoder)
 		{
 			if (m_mapDecoders.find(decoder.GetName()) != m_mapDecoders.end())
 			{
-				throw std::exception("decoder already registered");
+				throw std::runtime_error("decoder already registered");
 			}
 
 			m_mapDecoders.insert(std::make_pair(decoder.GetName(), &decoder));
@@ -110,6 +115,11 @@ class DeviceDecoderServicesMockup : public dcclite::broker::exec::dcc::IDevice_D
 			m_DecoderServices.RegisterDecoder(decoder);			
 		}
 
+		void SetProtocolVersion(uint16_t version) noexcept
+		{
+			m_DecoderServices.m_uProtocolVersion = version;
+		}
+
 	private:
 		NetworkDeviceDecoderServicesMockup m_DecoderServices;
 };